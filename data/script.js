@@ -6,6 +6,12 @@ document.addEventListener("DOMContentLoaded", () => {
     const logSelect = document.getElementById("log-select");
     const logContent = document.getElementById("log-content");
     const refreshLogsBtn = document.getElementById("refresh-logs-btn");
+    const chartSeries = document.getElementById("chart-series");
+    const chartHours = document.getElementById("chart-hours");
+    const chartMethod = document.getElementById("chart-method");
+    const chartCanvas = document.getElementById("chart-canvas");
+    const chartInfo = document.getElementById("chart-info");
+    const refreshChartBtn = document.getElementById("refresh-chart-btn");
 
     // --- Cargar configuración inicial ---
     function loadConfig() {
@@ -125,6 +131,98 @@ document.addEventListener("DOMContentLoaded", () => {
             });
     }
 
+    // --- Cargar una gráfica (formato binario de /api/chart) ---
+    function loadChart() {
+        // Un punto por cada ~2 píxeles del ancho visible
+        const points = Math.max(10, Math.min(1000, Math.round(chartCanvas.clientWidth / 2)));
+        const url = `/api/chart?series=${chartSeries.value}&hours=${chartHours.value}` +
+                    `&method=${chartMethod.value}&points=${points}&format=bin`;
+        chartInfo.textContent = "Cargando...";
+
+        fetch(url)
+            .then(response => {
+                if (!response.ok) {
+                    return response.text().then(text => { throw new Error(text || `Error ${response.status}`); });
+                }
+                return response.arrayBuffer();
+            })
+            .then(buffer => {
+                const chart = parseChart(buffer);
+                drawChart(chart);
+                chartInfo.textContent = `${chart.times.length} puntos de ${chart.raw} lecturas` +
+                                        (chart.cached ? " (caché)" : "");
+            })
+            .catch(error => {
+                drawChart(null);
+                chartInfo.textContent = error.message;
+            });
+    }
+
+    // "CHT1", u16 puntos, u8 método, u8 flags, u32 from, u32 to, u32 lecturas, puntos (u32 + f32)
+    function parseChart(buffer) {
+        const view = new DataView(buffer);
+        if (buffer.byteLength < 20 || String.fromCharCode(view.getUint8(0), view.getUint8(1), view.getUint8(2), view.getUint8(3)) !== "CHT1") {
+            throw new Error("Respuesta de gráfica no válida.");
+        }
+        const count = view.getUint16(4, true);
+        const chart = {
+            cached: (view.getUint8(7) & 1) !== 0,
+            from: view.getUint32(8, true),
+            to: view.getUint32(12, true),
+            raw: view.getUint32(16, true),
+            times: [],
+            values: []
+        };
+        for (let i = 0; i < count && 20 + i * 8 + 8 <= buffer.byteLength; i++) {
+            chart.times.push(view.getUint32(20 + i * 8, true));
+            chart.values.push(view.getFloat32(24 + i * 8, true));
+        }
+        return chart;
+    }
+
+    function drawChart(chart) {
+        const ctx = chartCanvas.getContext("2d");
+        const width = chartCanvas.width, height = chartCanvas.height;
+        const pad = { left: 50, right: 10, top: 10, bottom: 25 };
+        ctx.clearRect(0, 0, width, height);
+        if (!chart || chart.times.length === 0) {
+            ctx.fillStyle = "#666";
+            ctx.font = "14px sans-serif";
+            ctx.textAlign = "center";
+            ctx.fillText(chart ? "Sin datos en el rango." : "", width / 2, height / 2);
+            return;
+        }
+
+        let minValue = Math.min(...chart.values), maxValue = Math.max(...chart.values);
+        if (minValue === maxValue) { minValue -= 1; maxValue += 1; }
+        const x = t => pad.left + (t - chart.from) / Math.max(1, chart.to - chart.from) * (width - pad.left - pad.right);
+        const y = v => height - pad.bottom - (v - minValue) / (maxValue - minValue) * (height - pad.top - pad.bottom);
+
+        // Ejes con los extremos de valor y tiempo
+        ctx.strokeStyle = "#ccc";
+        ctx.strokeRect(pad.left, pad.top, width - pad.left - pad.right, height - pad.top - pad.bottom);
+        ctx.fillStyle = "#666";
+        ctx.font = "12px sans-serif";
+        ctx.textAlign = "right";
+        ctx.fillText(maxValue.toFixed(1), pad.left - 5, pad.top + 10);
+        ctx.fillText(minValue.toFixed(1), pad.left - 5, height - pad.bottom);
+        const label = epoch => new Date(epoch * 1000).toLocaleString([], { month: "2-digit", day: "2-digit", hour: "2-digit", minute: "2-digit" });
+        ctx.textAlign = "left";
+        ctx.fillText(label(chart.from), pad.left, height - 7);
+        ctx.textAlign = "right";
+        ctx.fillText(label(chart.to), width - pad.right, height - 7);
+
+        // Serie
+        ctx.strokeStyle = "#007bff";
+        ctx.lineWidth = 1.5;
+        ctx.beginPath();
+        chart.times.forEach((t, i) => {
+            if (i === 0) ctx.moveTo(x(t), y(chart.values[i]));
+            else ctx.lineTo(x(t), y(chart.values[i]));
+        });
+        ctx.stroke();
+    }
+
     // --- Helper para mostrar mensajes ---
     function showStatus(message, type) {
         statusMessage.textContent = message;
@@ -135,8 +233,11 @@ document.addEventListener("DOMContentLoaded", () => {
     form.addEventListener("submit", saveConfig);
     logSelect.addEventListener("change", viewLog);
     refreshLogsBtn.addEventListener("click", loadLogList);
+    [chartSeries, chartHours, chartMethod].forEach(el => el.addEventListener("change", loadChart));
+    refreshChartBtn.addEventListener("click", loadChart);
 
     // --- Carga inicial ---
     loadConfig();
     loadLogList();
+    loadChart();
 });
\ No newline at end of file
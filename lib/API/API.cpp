@@ -9,6 +9,9 @@
 #include "mbedtls/base64.h" // Para codificar/decodificar el estado guardado
 // (Dependencias adicionales)
 #include "ErrorLogger.h"
+#include "Trace.h"          // Instrumentación de trazas (no-op sin ENABLE_TRACE)
+#include "FaultInjection.h" // Inyección de fallos (no-op sin ENABLE_FAULT_INJECTION)
+#include "PhaseDeadline.h"  // Plazo de la fase en curso (refresco de token durante un envío)
 #include "TimeManager.h"
 #include "ConfigManager.h"
 #include "EnvironmentDataJSON.h"
@@ -74,7 +77,7 @@ void API::setDeviceMAC(const String& mac) {
  * @brief (Helper) Guarda el estado actual de la API (encriptado) en la SD.
  */
 bool API::_saveCurrentApiStateToSd() {
-    if (!_sdManagerRef.isSDAvailable()) {
+    if (!_sdManagerRef.isLocalStorageAvailable()) {
         #ifdef ENABLE_DEBUG_SERIAL
             Serial.println("[API_Save] SD card not available. Cannot save API state.");
         #endif
@@ -105,59 +108,9 @@ bool API::_saveCurrentApiStateToSd() {
         #ifdef ENABLE_DEBUG_SERIAL
             Serial.println("[API_Save] Encrypting API state...");
         #endif
-        
-        mbedtls_gcm_context gcm;
-        unsigned char iv[AES_GCM_IV_LENGTH];      // Vector de inicialización (aleatorio)
-        unsigned char tag[AES_GCM_TAG_LENGTH];  // Etiqueta de autenticación (generada)
-        
-        size_t plaintextLength = stateJsonToSavePlain.length();
-        // Buffer para el texto cifrado (mismo tamaño que el texto plano)
-        unsigned char* ciphertextBuffer = (unsigned char*)malloc(plaintextLength);
-        if (!ciphertextBuffer) {
-            #ifdef ENABLE_DEBUG_SERIAL
-                Serial.println("[API_Save] Failed to allocate memory for ciphertext buffer!");
-            #endif
+        if (!_encryptState(_aesKey, stateJsonToSavePlain, dataToStoreOnSd)) {
             return false;
         }
-
-        // Generar un IV aleatorio para cada encriptación
-        esp_fill_random(iv, AES_GCM_IV_LENGTH);
-
-        // Configurar GCM con la clave
-        mbedtls_gcm_init(&gcm);
-        int ret = mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, _aesKey, API_AES_KEY_SIZE * 8); // 32 bytes * 8 = 256 bits
-        if (ret != 0) {
-            mbedtls_gcm_free(&gcm); free(ciphertextBuffer); return false;
-        }
-
-        // Encriptar y generar la etiqueta (tag)
-        ret = mbedtls_gcm_crypt_and_tag(&gcm, MBEDTLS_GCM_ENCRYPT, plaintextLength, 
-                                        iv, AES_GCM_IV_LENGTH, NULL, 0, // (Sin datos adicionales autenticados)
-                                        (const unsigned char*)stateJsonToSavePlain.c_str(), ciphertextBuffer,
-                                        AES_GCM_TAG_LENGTH, tag);
-        mbedtls_gcm_free(&gcm);
-        if (ret != 0) {
-            free(ciphertextBuffer); return false;
-        }
-
-        // 3. Combinar [IV] + [TAG] + [Ciphertext] en un solo buffer
-        size_t totalEncryptedLength = AES_GCM_IV_LENGTH + AES_GCM_TAG_LENGTH + plaintextLength;
-        std::vector<unsigned char> combinedBuffer(totalEncryptedLength);
-        memcpy(combinedBuffer.data(), iv, AES_GCM_IV_LENGTH);
-        memcpy(combinedBuffer.data() + AES_GCM_IV_LENGTH, tag, AES_GCM_TAG_LENGTH);
-        memcpy(combinedBuffer.data() + AES_GCM_IV_LENGTH + AES_GCM_TAG_LENGTH, ciphertextBuffer, plaintextLength);
-        
-        free(ciphertextBuffer);
-
-        // 4. Codificar el buffer combinado en Base64
-        size_t base64Len;
-        mbedtls_base64_encode(NULL, 0, &base64Len, combinedBuffer.data(), combinedBuffer.size()); // Calcular tamaño
-        std::vector<unsigned char> base64Buffer(base64Len);
-        
-        ret = mbedtls_base64_encode(base64Buffer.data(), base64Len, &base64Len, combinedBuffer.data(), combinedBuffer.size());
-        if(ret != 0){ return false; }
-
-        dataToStoreOnSd = String((char*)base64Buffer.data());
         #ifdef ENABLE_DEBUG_SERIAL
             Serial.println("[API_Save] API state encrypted and Base64 encoded successfully.");
         #endif
@@ -170,18 +123,125 @@ bool API::_saveCurrentApiStateToSd() {
         dataToStoreOnSd = stateJsonToSavePlain;
     }
 
-    // 5. Guardar en la SD
+    // 3. Guardar en la SD
     bool success = _sdManagerRef.saveApiState(dataToStoreOnSd);
     return success;
 }
 
+/**
+ * @brief (Helper) Cifra el estado (AES-256-GCM) y lo codifica en Base64.
+ */
+bool API::_encryptState(const uint8_t* key, const String& plain, String& encoded) {
+    mbedtls_gcm_context gcm;
+    unsigned char iv[AES_GCM_IV_LENGTH];      // Vector de inicialización (aleatorio)
+    unsigned char tag[AES_GCM_TAG_LENGTH];  // Etiqueta de autenticación (generada)
+    
+    size_t plaintextLength = plain.length();
+    // Buffer para el texto cifrado (mismo tamaño que el texto plano)
+    unsigned char* ciphertextBuffer = (unsigned char*)malloc(plaintextLength);
+    if (!ciphertextBuffer) {
+        #ifdef ENABLE_DEBUG_SERIAL
+            Serial.println("[API_Save] Failed to allocate memory for ciphertext buffer!");
+        #endif
+        return false;
+    }
+
+    // 1. Generar un IV aleatorio para cada encriptación
+    esp_fill_random(iv, AES_GCM_IV_LENGTH);
+
+    // Configurar GCM con la clave
+    mbedtls_gcm_init(&gcm);
+    int ret = mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, key, API_AES_KEY_SIZE * 8); // 32 bytes * 8 = 256 bits
+    if (ret != 0) {
+        mbedtls_gcm_free(&gcm); free(ciphertextBuffer); return false;
+    }
+
+    // 2. Encriptar y generar la etiqueta (tag)
+    ret = mbedtls_gcm_crypt_and_tag(&gcm, MBEDTLS_GCM_ENCRYPT, plaintextLength, 
+                                    iv, AES_GCM_IV_LENGTH, NULL, 0, // (Sin datos adicionales autenticados)
+                                    (const unsigned char*)plain.c_str(), ciphertextBuffer,
+                                    AES_GCM_TAG_LENGTH, tag);
+    mbedtls_gcm_free(&gcm);
+    if (ret != 0) {
+        free(ciphertextBuffer); return false;
+    }
+
+    // 3. Combinar [IV] + [TAG] + [Ciphertext] en un solo buffer
+    size_t totalEncryptedLength = AES_GCM_IV_LENGTH + AES_GCM_TAG_LENGTH + plaintextLength;
+    std::vector<unsigned char> combinedBuffer(totalEncryptedLength);
+    memcpy(combinedBuffer.data(), iv, AES_GCM_IV_LENGTH);
+    memcpy(combinedBuffer.data() + AES_GCM_IV_LENGTH, tag, AES_GCM_TAG_LENGTH);
+    memcpy(combinedBuffer.data() + AES_GCM_IV_LENGTH + AES_GCM_TAG_LENGTH, ciphertextBuffer, plaintextLength);
+    
+    free(ciphertextBuffer);
+
+    // 4. Codificar el buffer combinado en Base64
+    size_t base64Len;
+    mbedtls_base64_encode(NULL, 0, &base64Len, combinedBuffer.data(), combinedBuffer.size()); // Calcular tamaño
+    std::vector<unsigned char> base64Buffer(base64Len);
+    
+    ret = mbedtls_base64_encode(base64Buffer.data(), base64Len, &base64Len, combinedBuffer.data(), combinedBuffer.size());
+    if(ret != 0){ return false; }
+
+    encoded = String((char*)base64Buffer.data());
+    return true;
+}
+
+/**
+ * @brief (Helper) Decodifica (Base64) y desencripta/autentica un estado cifrado por _encryptState().
+ */
+int API::_decryptState(const uint8_t* key, const String& encoded, String& plain) {
+    // 1. Decodificar Base64
+    size_t decodedLen;
+    mbedtls_base64_decode(NULL, 0, &decodedLen, (const unsigned char*)encoded.c_str(), encoded.length()); // Calcular tamaño
+    std::vector<unsigned char> encryptedBuffer(decodedLen);
+    
+    int ret = mbedtls_base64_decode(encryptedBuffer.data(), encryptedBuffer.size(), &decodedLen, (const unsigned char*)encoded.c_str(), encoded.length());
+
+    // Verificar si la decodificación Base64 falló o es demasiado corta
+    if (ret != 0 || decodedLen < (AES_GCM_IV_LENGTH + AES_GCM_TAG_LENGTH)) {
+        #ifdef ENABLE_DEBUG_SERIAL
+            Serial.printf("[API_Load] Base64 decode failed (-0x%04X) or decoded data too short. Treating as corrupt.\n", -ret);
+        #endif
+        return ret != 0 ? ret : -1;
+    }
+
+    // 2. Extraer [IV], [TAG] y [Ciphertext] del buffer combinado
+    unsigned char iv[AES_GCM_IV_LENGTH];
+    unsigned char tag[AES_GCM_TAG_LENGTH];
+    size_t ciphertextLength = decodedLen - AES_GCM_IV_LENGTH - AES_GCM_TAG_LENGTH;
+    
+    memcpy(iv, encryptedBuffer.data(), AES_GCM_IV_LENGTH);
+    memcpy(tag, encryptedBuffer.data() + AES_GCM_IV_LENGTH, AES_GCM_TAG_LENGTH);
+    
+    std::vector<unsigned char> plaintextBuffer(ciphertextLength);
+
+    // 3. Desencriptar y Autenticar (AES-GCM)
+    mbedtls_gcm_context gcm;
+    mbedtls_gcm_init(&gcm);
+    ret = mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, key, API_AES_KEY_SIZE * 8);
+    if (ret != 0) { mbedtls_gcm_free(&gcm); return ret; }
+
+    ret = mbedtls_gcm_auth_decrypt(&gcm, ciphertextLength,
+                                   iv, AES_GCM_IV_LENGTH, NULL, 0, // (Sin AAD)
+                                   tag, AES_GCM_TAG_LENGTH,
+                                   encryptedBuffer.data() + AES_GCM_IV_LENGTH + AES_GCM_TAG_LENGTH, // Puntero al inicio del ciphertext
+                                   plaintextBuffer.data());
+    mbedtls_gcm_free(&gcm);
+
+    if (ret == 0) { // ¡Éxito!
+        plain = String((char*)plaintextBuffer.data(), plaintextBuffer.size());
+    }
+    return ret;
+}
+
 /**
  * @brief (Helper) Carga y desencripta el estado de la API desde la SD.
  */
 void API::_loadPersistentData() {
     String stateJsonFromSdBase64; 
     // 1. Intentar leer el archivo de estado de la SD
-    if (_sdManagerRef.isSDAvailable() && _sdManagerRef.readApiState(stateJsonFromSdBase64) && !stateJsonFromSdBase64.isEmpty()) {
+    if (_sdManagerRef.isLocalStorageAvailable() && _sdManagerRef.readApiState(stateJsonFromSdBase64) && !stateJsonFromSdBase64.isEmpty()) {
         
         String stateJsonPlain = ""; 
 
@@ -191,53 +251,16 @@ void API::_loadPersistentData() {
                 Serial.println("[API_Load] Data found on SD. Attempting decryption...");
             #endif
             
-            // 3. Decodificar Base64
-            size_t decodedLen;
-            mbedtls_base64_decode(NULL, 0, &decodedLen, (const unsigned char*)stateJsonFromSdBase64.c_str(), stateJsonFromSdBase64.length()); // Calcular tamaño
-            std::vector<unsigned char> encryptedBuffer(decodedLen);
-            
-            int ret = mbedtls_base64_decode(encryptedBuffer.data(), encryptedBuffer.size(), &decodedLen, (const unsigned char*)stateJsonFromSdBase64.c_str(), stateJsonFromSdBase64.length());
-
-            // Verificar si la decodificación Base64 falló o es demasiado corta
-            if (ret != 0 || decodedLen < (AES_GCM_IV_LENGTH + AES_GCM_TAG_LENGTH)) {
-                #ifdef ENABLE_DEBUG_SERIAL
-                    Serial.printf("[API_Load] Base64 decode failed (-0x%04X) or decoded data too short. Treating as corrupt.\n", -ret);
-                #endif
-                goto use_defaults; // Saltar a la sección de usar valores por defecto
-            }
-
-            // 4. Extraer [IV], [TAG] y [Ciphertext] del buffer combinado
-            unsigned char iv[AES_GCM_IV_LENGTH];
-            unsigned char tag[AES_GCM_TAG_LENGTH];
-            size_t ciphertextLength = decodedLen - AES_GCM_IV_LENGTH - AES_GCM_TAG_LENGTH;
-            
-            memcpy(iv, encryptedBuffer.data(), AES_GCM_IV_LENGTH);
-            memcpy(tag, encryptedBuffer.data() + AES_GCM_IV_LENGTH, AES_GCM_TAG_LENGTH);
-            
-            std::vector<unsigned char> plaintextBuffer(ciphertextLength);
-
-            // 5. Desencriptar y Autenticar (AES-GCM)
-            mbedtls_gcm_context gcm;
-            mbedtls_gcm_init(&gcm);
-            ret = mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, _aesKey, API_AES_KEY_SIZE * 8);
-            if (ret != 0) { mbedtls_gcm_free(&gcm); goto use_defaults; }
-
-            ret = mbedtls_gcm_auth_decrypt(&gcm, ciphertextLength,
-                                           iv, AES_GCM_IV_LENGTH, NULL, 0, // (Sin AAD)
-                                           tag, AES_GCM_TAG_LENGTH,
-                                           encryptedBuffer.data() + AES_GCM_IV_LENGTH + AES_GCM_TAG_LENGTH, // Puntero al inicio del ciphertext
-                                           plaintextBuffer.data());
-            mbedtls_gcm_free(&gcm);
-
+            // 3. Decodificar (Base64), desencriptar y autenticar (AES-GCM)
+            int ret = _decryptState(_aesKey, stateJsonFromSdBase64, stateJsonPlain);
             if (ret == 0) { // ¡Éxito!
-                stateJsonPlain = String((char*)plaintextBuffer.data(), plaintextBuffer.size());
                 #ifdef ENABLE_DEBUG_SERIAL
                     Serial.println("[API_Load] API state decrypted successfully!");
                 #endif
             } else {
                 // Fallo de autenticación (Tag incorrecto) o desencriptación
                 #ifdef ENABLE_DEBUG_SERIAL
-                    Serial.printf("[API_Load] Decryption FAILED (mbedtls_gcm_auth_decrypt: -0x%04X). Data is corrupt or key is wrong.\n", -ret);
+                    Serial.printf("[API_Load] Decryption FAILED (-0x%04X). Data is corrupt or key is wrong.\n", -ret);
                 #endif
                 goto use_defaults;
             }
@@ -250,7 +273,7 @@ void API::_loadPersistentData() {
             stateJsonPlain = stateJsonFromSdBase64;
         }
 
-        // 6. Parsear el JSON (ya sea desencriptado o de texto plano)
+        // 4. Parsear el JSON (ya sea desencriptado o de texto plano)
         if (!stateJsonPlain.isEmpty()) {
             JsonDocument doc;
             DeserializationError error = deserializeJson(doc, stateJsonPlain);
@@ -274,7 +297,7 @@ void API::_loadPersistentData() {
         }
 
     } else { 
-        // 7. Usar valores por defecto (si el archivo no existe o está vacío)
+        // 5. Usar valores por defecto (si el archivo no existe o está vacío)
 use_defaults:
         #ifdef ENABLE_DEBUG_SERIAL
             Serial.println("[API_Load] No valid API state found. Using defaults and saving a new state file.");
@@ -284,7 +307,7 @@ use_defaults:
         _dataCollectionTimeMinutes = 0;
         _activatedFlag = false;
         // Intenta guardar este estado por defecto (encriptado si es posible)
-        if (_sdManagerRef.isSDAvailable()) {
+        if (_sdManagerRef.isLocalStorageAvailable()) {
              _saveCurrentApiStateToSd();
         }
     }
@@ -344,10 +367,17 @@ int API::_httpPost(const String& fullUrl, const String& authorizationToken, cons
         #endif
         return -100; // Código de error: Sin WiFi
     }
+    if (PhaseDeadline::expired()) {
+        #ifdef ENABLE_DEBUG_SERIAL
+            Serial.println("[API_httpPost] Skipped: phase deadline expired.");
+        #endif
+        return -107; // Código de error: Plazo de la fase vencido
+    }
     
     http.setReuse(false); 
     if (http.begin(fullUrl)) {
-        http.setTimeout(HTTP_REQUEST_TIMEOUT);
+        http.setConnectTimeout(PhaseDeadline::boundTimeout(HTTPCLIENT_DEFAULT_TCP_TIMEOUT));
+        http.setTimeout(PhaseDeadline::boundTimeout(HTTP_REQUEST_TIMEOUT));
         http.addHeader("Content-Type", "application/json");
         http.addHeader("Connection", "close"); 
         // Añadir token de autorización (si se proporciona)
@@ -360,11 +390,15 @@ int API::_httpPost(const String& fullUrl, const String& authorizationToken, cons
         #endif
 
         // Maneja POST con o sin payload
-        if(jsonPayload.isEmpty()){
+        TRACE_BEGIN(HTTP_POST_API);
+        if (FAULT_INJECT(HTTP_REQUEST)) {
+             httpResponseCode = HTTPC_ERROR_CONNECTION_LOST;
+        } else if(jsonPayload.isEmpty()){
              httpResponseCode = http.POST("");
         } else {
              httpResponseCode = http.POST(jsonPayload);
         }
+        TRACE_END(HTTP_POST_API);
 
         if (httpResponseCode > 0) {
             responsePayload = http.getString();
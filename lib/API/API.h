@@ -102,6 +102,8 @@ public:
     void setDeviceMAC(const String& mac);
     
 private:
+    friend struct BenchmarkAccess; ///< (Solo test/test_benchmarks) acceso a los helpers privados
+
     /// Referencia al gestor de la SD (para guardar/leer estado).
     SDManager& _sdManagerRef; 
 
@@ -141,6 +143,23 @@ private:
      */
     bool _saveCurrentApiStateToSd();
 
+    /**
+     * @brief (Helper) Encripta el estado con AES-256-GCM (IV aleatorio) y codifica
+     * [IV] + [TAG] + [Ciphertext] en Base64.
+     * @param key Clave AES de API_AES_KEY_SIZE bytes.
+     * @param plain JSON de estado en texto plano.
+     * @param[out] encoded Texto Base64 a guardar en la SD.
+     * @return true si la encriptación fue exitosa.
+     */
+    static bool _encryptState(const uint8_t* key, const String& plain, String& encoded);
+
+    /**
+     * @brief (Helper) Decodifica y desencripta (autenticando el tag) un estado de _encryptState().
+     * @param[out] plain JSON de estado (solo se modifica si tuvo éxito).
+     * @return 0 si tuvo éxito; código de error de mbedtls (-1 si los datos son demasiado cortos).
+     */
+    static int _decryptState(const uint8_t* key, const String& encoded, String& plain);
+
     /**
      * @brief (Helper) Inicializa la clave AES.
      * 1. Intenta cargar la clave desde NVS (almacenamiento seguro).
@@ -0,0 +1,132 @@
+#include "AnomalyDetector.h"
+
+#include <string.h>
+#include <math.h>
+#ifdef ESP_PLATFORM
+  #include "nvs.h"
+#endif
+
+#define ANOMALY_NVS_NAMESPACE "anomaly"
+#define ANOMALY_NVS_KEY "state"
+#define SECONDS_PER_DAY 86400UL
+#define ANOMALY_OUTLIER_DAMPING 4.0f    // Peso de una muestra fuera de umbral = alpha / 4
+
+AnomalyDetector::AnomalyDetector(const AnomalyConfig& config) : _config(config) {
+    reset();
+}
+
+void AnomalyDetector::reset() {
+    memset(&_state, 0, sizeof(_state));
+    _state.magic = ANOMALY_STATE_MAGIC;
+    _state.version = ANOMALY_STATE_VERSION;
+}
+
+float AnomalyDetector::baselineStd() const {
+    float std = sqrtf(_state.variance);
+    return std > _config.minStd ? std : _config.minStd;
+}
+
+AnomalyResult AnomalyDetector::update(uint32_t time, float surfaceTemp, float airTemp) {
+    if (time == 0 || isnan(surfaceTemp) || isnan(airTemp) || isinf(surfaceTemp) || isinf(airTemp)) return ANOMALY_SKIPPED;
+    if (_state.samples > 0 && time <= _state.lastTime) return ANOMALY_SKIPPED;
+
+    // 1. Puntuación contra la línea base anterior
+    float delta = surfaceTemp - airTemp;
+    float deviation = delta - _state.mean;
+    bool warm = _state.samples >= _config.warmupSamples;
+    float z = warm ? deviation / baselineStd() : 0.0f;
+    _state.lastZ = z;
+
+    // 2. Línea base
+    bool burstOpen = _state.burstUntil != 0; // Hasta que nextBurstDelay() la cierra
+    _state.lastTime = time;
+    float alpha = _config.alpha;
+    bool outlier = warm && _config.zThreshold > 0.0f && fabsf(z) >= _config.zThreshold;
+    if (!warm) {
+        float cumulative = 1.0f / (float)(_state.samples + 1); // Media acumulada al principio
+        if (cumulative > alpha) alpha = cumulative;
+    }
+    if (_state.samples == 0) {
+        _state.mean = delta;
+        _state.variance = 0.0f;
+        _state.samples++;
+    } else if (burstOpen && _config.zThreshold > 0.0f) {
+        // Las capturas extra no se aprenden: pesarían el evento varias veces
+    } else if (outlier) {
+        // Solo la media, recortada y con peso reducido: un cambio sostenido se absorbe despacio
+        float limit = _config.zThreshold * baselineStd();
+        if (deviation > limit) deviation = limit;
+        if (deviation < -limit) deviation = -limit;
+        _state.mean += alpha / ANOMALY_OUTLIER_DAMPING * deviation;
+    } else {
+        _state.mean += alpha * deviation;
+        _state.variance = (1.0f - alpha) * (_state.variance + alpha * deviation * deviation);
+        _state.samples++;
+    }
+
+    // 3. Disparo
+    if (!warm) return ANOMALY_LEARNING;
+    if (_config.zThreshold <= 0.0f || z < _config.zThreshold) return ANOMALY_NORMAL;
+    uint32_t day = time / SECONDS_PER_DAY;
+    bool budgetLeft = _state.budgetDay != day || _state.budgetUsed < _config.maxBurstCapturesPerDay;
+    if (burstOpen || time < _state.cooldownUntil || !budgetLeft) return ANOMALY_SUPPRESSED;
+    _state.burstUntil = time + _config.burstDurationSeconds;
+    if (_state.triggers < UINT16_MAX) _state.triggers++;
+    return ANOMALY_TRIGGERED;
+}
+
+uint32_t AnomalyDetector::nextBurstDelay(uint32_t now) {
+    if (_state.burstUntil == 0) return 0;
+    uint32_t day = now / SECONDS_PER_DAY;
+    if (_state.budgetDay != day) {
+        _state.budgetDay = day;
+        _state.budgetUsed = 0;
+    }
+    // La siguiente captura tiene que caer dentro de la ráfaga y del presupuesto
+    if (now + _config.burstIntervalSeconds > _state.burstUntil || _state.budgetUsed >= _config.maxBurstCapturesPerDay) {
+        _endBurst(now);
+        return 0;
+    }
+    _state.budgetUsed++;
+    return _config.burstIntervalSeconds;
+}
+
+void AnomalyDetector::_endBurst(uint32_t now) {
+    _state.burstUntil = 0;
+    _state.cooldownUntil = now + _config.cooldownSeconds;
+}
+
+bool AnomalyDetector::restore(const AnomalyState& state) {
+    if (state.magic != ANOMALY_STATE_MAGIC || state.version != ANOMALY_STATE_VERSION) return false;
+    if (isnan(state.mean) || isinf(state.mean) || isnan(state.variance) || isinf(state.variance) || state.variance < 0.0f) return false;
+    _state = state;
+    return true;
+}
+
+#ifdef ESP_PLATFORM
+
+bool AnomalyDetector::loadState() {
+    nvs_handle_t handle;
+    if (nvs_open(ANOMALY_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) return false; // Primera vez: no existe
+    AnomalyState stored;
+    size_t size = sizeof(stored);
+    esp_err_t err = nvs_get_blob(handle, ANOMALY_NVS_KEY, &stored, &size);
+    nvs_close(handle);
+    return err == ESP_OK && size == sizeof(stored) && restore(stored);
+}
+
+bool AnomalyDetector::saveState() const {
+    nvs_handle_t handle;
+    if (nvs_open(ANOMALY_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) return false;
+    esp_err_t err = nvs_set_blob(handle, ANOMALY_NVS_KEY, &_state, sizeof(_state));
+    if (err == ESP_OK) err = nvs_commit(handle);
+    nvs_close(handle);
+    return err == ESP_OK;
+}
+
+#else
+
+bool AnomalyDetector::loadState() { return false; }
+bool AnomalyDetector::saveState() const { return false; }
+
+#endif
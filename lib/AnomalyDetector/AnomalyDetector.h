@@ -0,0 +1,134 @@
+#ifndef ANOMALY_DETECTOR_H
+#define ANOMALY_DETECTOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Sin dependencias de Arduino: la lógica se prueba en el host con trazas reproducidas
+// (tools/anomaly_replay). Solo loadState()/saveState() usan NVS en el ESP32.
+
+#define ANOMALY_STATE_MAGIC 0x414E      // "AN"
+#define ANOMALY_STATE_VERSION 1
+#define ANOMALY_DEFAULT_ALPHA 0.05f     // Peso de cada muestra en la línea base (~20 capturas de memoria)
+#define ANOMALY_WARMUP_SAMPLES 24       // Capturas antes de poder disparar (medio día cada 30 min)
+#define ANOMALY_MIN_STD 0.3f            // °C: suelo de la desviación (tras días muy estables)
+
+/**
+ * @brief Resultado de AnomalyDetector::update().
+ */
+enum AnomalyResult : uint8_t {
+    ANOMALY_SKIPPED = 0,    ///< Lectura NaN o tiempo no creciente: no cambia nada
+    ANOMALY_LEARNING,       ///< Aún en calentamiento (menos de warmupSamples)
+    ANOMALY_NORMAL,         ///< Dentro de la línea base
+    ANOMALY_SUPPRESSED,     ///< Sobre el umbral, pero en ráfaga, enfriamiento o sin presupuesto
+    ANOMALY_TRIGGERED       ///< Sobre el umbral: empieza una ráfaga
+};
+
+/**
+ * @brief Parámetros del detector y de las ráfagas (config.json, `burst_*`).
+ */
+struct AnomalyConfig {
+    float alpha = ANOMALY_DEFAULT_ALPHA;
+    float zThreshold = 3.0f;                ///< 0 = sin ráfagas (la línea base se sigue aprendiendo)
+    uint32_t warmupSamples = ANOMALY_WARMUP_SAMPLES;
+    float minStd = ANOMALY_MIN_STD;
+    uint32_t burstIntervalSeconds = 300;    ///< Cadencia durante la ráfaga
+    uint32_t burstDurationSeconds = 3600;   ///< Duración máxima de una ráfaga
+    uint32_t cooldownSeconds = 10800;       ///< Sin ráfagas nuevas tras terminar una
+    uint16_t maxBurstCapturesPerDay = 24;   ///< Presupuesto de capturas extra por día (UTC)
+};
+
+/**
+ * @brief Estado persistente (blob en NVS): un reinicio no pierde la línea base ni el presupuesto.
+ */
+struct AnomalyState {
+    uint16_t magic;
+    uint16_t version;
+    float mean;             ///< Media EWMA de (superficie - aire), °C
+    float variance;         ///< Varianza EWMA, °C²
+    uint32_t samples;       ///< Muestras aprendidas (sin contar las anómalas ni las de ráfaga)
+    uint32_t lastTime;      ///< Época de la última muestra
+    uint32_t burstUntil;    ///< Fin de la ráfaga en curso (0 = sin ráfaga)
+    uint32_t cooldownUntil; ///< Sin ráfagas nuevas hasta esta época
+    uint32_t budgetDay;     ///< Día (época / 86400) del contador de presupuesto
+    uint16_t budgetUsed;    ///< Capturas de ráfaga programadas ese día
+    uint16_t triggers;      ///< Ráfagas iniciadas (diagnóstico)
+    float lastZ;            ///< Puntuación z de la última muestra
+};
+
+/**
+ * @class AnomalyDetector
+ * @brief Detecta estrés térmico en la serie de resúmenes de captura y decide cuándo
+ * capturar a mayor cadencia.
+ *
+ * La señal es la diferencia entre la temperatura del dosel y la del aire: con riego y
+ * transpiración normales se mantiene estable, y sube cuando las plantas cierran estomas
+ * (fallo de riego en una tarde caliente). Se sigue con una media y una varianza EWMA; cada
+ * muestra se compara con la línea base *anterior* (puntuación z) antes de incorporarla.
+ * Solo dispara hacia arriba (dosel más caliente de lo habitual).
+ *
+ * Para que un evento largo no se convierta en la nueva normalidad, las capturas de ráfaga
+ * no se aprenden y las que superan el umbral solo mueven la media, recortadas a zThreshold
+ * desviaciones y con un cuarto del peso; un cambio real y sostenido se absorbe igualmente,
+ * más despacio. Durante el calentamiento el peso es 1/n (media acumulada) para converger
+ * rápido.
+ *
+ * Una ráfaga dura como mucho burstDurationSeconds, con una captura cada
+ * burstIntervalSeconds mientras quede presupuesto del día; al terminar empieza el
+ * enfriamiento. La cadencia la consulta el planificador con nextBurstDelay().
+ */
+class AnomalyDetector {
+public:
+    explicit AnomalyDetector(const AnomalyConfig& config = AnomalyConfig());
+
+    /**
+     * @brief Cambia los parámetros sin perder el estado aprendido.
+     */
+    void configure(const AnomalyConfig& config) { _config = config; }
+
+    /**
+     * @brief Añade una captura.
+     * @param time Época de la captura (0 = reloj sin sincronizar: se ignora).
+     * @param surfaceTemp Temperatura media del dosel (o del cuadro), °C.
+     * @param airTemp Temperatura del aire (BME280), °C.
+     */
+    AnomalyResult update(uint32_t time, float surfaceTemp, float airTemp);
+
+    /**
+     * @brief Segundos hasta la siguiente captura de ráfaga, o 0 si toca la cadencia normal.
+     * Cada valor distinto de 0 consume una captura del presupuesto del día. Si la ráfaga
+     * terminó (por duración o presupuesto), empieza el enfriamiento.
+     */
+    uint32_t nextBurstDelay(uint32_t now);
+
+    bool inBurst(uint32_t now) const { return _state.burstUntil != 0 && now < _state.burstUntil; }
+    float lastZ() const { return _state.lastZ; }
+    float baselineMean() const { return _state.mean; }
+    float baselineStd() const;
+    const AnomalyState& state() const { return _state; }
+
+    /**
+     * @brief Restaura un estado guardado.
+     * @return False (y el estado queda como estaba) si el blob no es válido.
+     */
+    bool restore(const AnomalyState& state);
+
+    /**
+     * @brief Vuelve al estado inicial (sin línea base).
+     */
+    void reset();
+
+    /**
+     * @brief (ESP32) Carga / guarda el estado en NVS. En el host devuelven false.
+     */
+    bool loadState();
+    bool saveState() const;
+
+private:
+    AnomalyConfig _config;
+    AnomalyState _state;
+
+    void _endBurst(uint32_t now);
+};
+
+#endif // ANOMALY_DETECTOR_H
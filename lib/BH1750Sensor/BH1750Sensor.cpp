@@ -3,22 +3,59 @@
  * @brief Implementación de los métodos de la clase BH1750Sensor.
  */
 #include "BH1750Sensor.h"
+#include "SensorTrace.h" // Grabación/reproducción de lecturas (no-op sin ENABLE_SENSOR_TRACE)
+
+#define BH1750_ADDRESS     0x23 // Dirección I2C por defecto (pin ADDR a GND)
+#define BH1750_POWER_DOWN  0x00 // Orden "Power Down" del datasheet (la librería no la expone)
 
 // El constructor utiliza la lista de inicialización para guardar la referencia
 // al bus I2C y los pines. El cuerpo está vacío intencionalmente.
 BH1750Sensor::BH1750Sensor(TwoWire &wire, int sda, int scl)
-  : _wire(wire), _sda(sda), _scl(scl) {
+  : _wire(wire), _sda(sda), _scl(scl), _powerState(SensorPowerState::ACTIVE) {
     // La inicialización real del hardware ocurre en el método begin().
 }
 
 bool BH1750Sensor::begin() {
+  // En reproducción las lecturas vienen de la traza: no se necesita el sensor
+  if (SENSOR_TRACE_REPLAYING()) return true;
+
   // Inicializa el sensor usando la librería base.
   // Se especifica el modo, la dirección I2C (0x23) y la instancia del bus I2C.
-  return lightMeter.begin(BH1750::CONTINUOUS_HIGH_RES_MODE_2, 0x23, &_wire);
+  _powerState = SensorPowerState::ACTIVE;
+  return lightMeter.begin(BH1750::CONTINUOUS_HIGH_RES_MODE_2, BH1750_ADDRESS, &_wire);
+}
+
+bool BH1750Sensor::setPowerState(SensorPowerState state) {
+  if (SENSOR_TRACE_REPLAYING()) {
+    _powerState = state;
+    return true;
+  }
+  if (state == _powerState) return true;
+
+  if (state == SensorPowerState::ACTIVE) {
+    // Una orden de medición saca al sensor de Power Down; se espera el primer resultado
+    if (!lightMeter.configure(BH1750::CONTINUOUS_HIGH_RES_MODE_2)) return false;
+    _powerState = SensorPowerState::ACTIVE;
+    return lightMeter.measurementReady(true);
+  }
+
+  _wire.beginTransmission(BH1750_ADDRESS);
+  _wire.write((uint8_t)BH1750_POWER_DOWN);
+  if (_wire.endTransmission() != 0) return false;
+  _powerState = state;
+  return true;
 }
 
 float BH1750Sensor::readLightLevel() {
   // Simplemente llama al método de la librería base y retorna su valor.
   // La librería BH1750 maneja internamente los códigos de error (valores negativos).
-  return lightMeter.readLightLevel();
+  float lux;
+  if (SENSOR_TRACE_REPLAYING()) {
+    // Un canal agotado se reporta como error de lectura (valor negativo, como la librería)
+    return SensorTrace::replayScalar(SensorChannel::LIGHT, lux) ? lux : -1.0f;
+  }
+  if (_powerState != SensorPowerState::ACTIVE) return -1.0f; // En Power Down
+  lux = lightMeter.readLightLevel();
+  SENSOR_TRACE_RECORD(recordScalar(SensorChannel::LIGHT, lux));
+  return lux;
 }
\ No newline at end of file
@@ -10,6 +10,7 @@
 
 #include <Wire.h>
 #include <BH1750.h> // Librería base del sensor
+#include "SensorPower.h" // SensorPowerState
 
 /**
  * @class BH1750Sensor
@@ -43,15 +44,28 @@ class BH1750Sensor {
      *
      * @return El nivel de luz medido en lux (lx).
      * Retorna un valor negativo (definido por la librería BH1750, ej: -1 o -2)
-     * si la lectura falla.
+     * si la lectura falla o el sensor está en reposo.
      */
     float readLightLevel();
 
+    /**
+     * @brief Cambia el estado de energía entre ciclos.
+     *
+     * STANDBY y OFF envían la orden Power Down del BH1750 (~0.01 µA; no tiene un
+     * estado más bajo). ACTIVE vuelve al modo continuo y espera la primera medición
+     * (~180 ms en alta resolución 2).
+     *
+     * @return false si el sensor no respondió.
+     */
+    bool setPowerState(SensorPowerState state);
+    SensorPowerState powerState() const { return _powerState; }
+
   private:
     BH1750 lightMeter;   ///< Instancia de la librería BH1750 subyacente.
     int _sda;            ///< Pin SDA (solo para referencia).
     int _scl;            ///< Pin SCL (solo para referencia).
     TwoWire &_wire;      ///< Referencia al bus I2C (ej: Wire o Wire1) a utilizar.
+    SensorPowerState _powerState; ///< Las lecturas solo se hacen en ACTIVE.
 };
 
 #endif // BH1750_SENSOR_H
\ No newline at end of file
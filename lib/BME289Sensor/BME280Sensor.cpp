@@ -1,10 +1,12 @@
 #include "BME280Sensor.h"
 #include <Adafruit_BME280.h> // Se incluye la librería completa en el .cpp
+#include "FaultInjection.h"  // Inyección de fallos (no-op sin ENABLE_FAULT_INJECTION)
+#include "SensorTrace.h"     // Grabación/reproducción de lecturas (no-op sin ENABLE_SENSOR_TRACE)
 
 /**
  * @brief Constructor. Asigna memoria para _bme y guarda la referencia a TwoWire.
  */
-BME280Sensor::BME280Sensor(TwoWire &wire) : _wire(wire), _isInitialized(false) {
+BME280Sensor::BME280Sensor(TwoWire &wire) : _wire(wire), _isInitialized(false), _powerState(SensorPowerState::ACTIVE) {
     // Creamos el objeto en el heap (memoria dinámica)
     _bme = new Adafruit_BME280(); 
 }
@@ -20,6 +22,13 @@ BME280Sensor::~BME280Sensor() {
  * @brief Inicializa el sensor BME280.
  */
 bool BME280Sensor::begin(uint8_t i2c_addr) {
+    // En reproducción las lecturas vienen de la traza: no se necesita el sensor
+    if (SENSOR_TRACE_REPLAYING()) {
+        _isInitialized = true;
+        _powerState = SensorPowerState::ACTIVE;
+        return true;
+    }
+
     // Precondición: El bus I2C (Wire.begin) debe ser inicializado 
     // por el código principal antes de llamar a esta función.
     
@@ -30,36 +39,79 @@ bool BME280Sensor::begin(uint8_t i2c_addr) {
     }
     
     _isInitialized = _bme->begin(i2c_addr, &_wire);
-    return _isInitialized;
+    // La librería arranca en modo normal (conversión continua): se pasa a forzado
+    return _isInitialized && setPowerState(SensorPowerState::ACTIVE);
 }
 
 /**
- * @brief Lee la temperatura. Devuelve NAN si el sensor no fue inicializado.
+ * @brief Modo forzado (ACTIVE) o sleep (STANDBY/OFF), con el mismo sobremuestreo x16 de siempre.
+ */
+bool BME280Sensor::setPowerState(SensorPowerState state) {
+    if (SENSOR_TRACE_REPLAYING()) {
+        _powerState = state;
+        return true;
+    }
+    if (!_isInitialized) return false;
+
+    Adafruit_BME280::sensor_mode mode = state == SensorPowerState::ACTIVE ? Adafruit_BME280::MODE_FORCED
+                                                                          : Adafruit_BME280::MODE_SLEEP;
+    _bme->setSampling(mode, Adafruit_BME280::SAMPLING_X16, Adafruit_BME280::SAMPLING_X16,
+                      Adafruit_BME280::SAMPLING_X16, Adafruit_BME280::FILTER_OFF);
+    _powerState = state;
+    // Despertar = primera conversión completa (~115 ms con x16), así la latencia medida es real
+    return state != SensorPowerState::ACTIVE || _bme->takeForcedMeasurement();
+}
+
+/**
+ * @brief Dispara una conversión y lee la temperatura. Devuelve NAN si el sensor no fue
+ * inicializado, está en reposo o la conversión no terminó.
  */
 float BME280Sensor::readTemperature() {
-    if (!_isInitialized) {
+    float value;
+    if (SENSOR_TRACE_REPLAYING()) {
+        SensorTrace::replayScalar(SensorChannel::AMBIENT_TEMPERATURE, value);
+        return value;
+    }
+    if (!_isInitialized || _powerState != SensorPowerState::ACTIVE || FAULT_INJECT(I2C_BME_READ)) {
         return NAN; // Not a Number
     }
-    return _bme->readTemperature();
+    // Nueva conversión en modo forzado; humedad y presión leen sus resultados
+    value = _bme->takeForcedMeasurement() ? _bme->readTemperature() : NAN;
+    SENSOR_TRACE_RECORD(recordScalar(SensorChannel::AMBIENT_TEMPERATURE, value, !isnan(value)));
+    return value;
 }
 
 /**
- * @brief Lee la humedad. Devuelve NAN si el sensor no fue inicializado.
+ * @brief Lee la humedad de la última conversión. Devuelve NAN si el sensor no fue inicializado o está en reposo.
  */
 float BME280Sensor::readHumidity() {
-    if (!_isInitialized) {
+    float value;
+    if (SENSOR_TRACE_REPLAYING()) {
+        SensorTrace::replayScalar(SensorChannel::HUMIDITY, value);
+        return value;
+    }
+    if (!_isInitialized || _powerState != SensorPowerState::ACTIVE || FAULT_INJECT(I2C_BME_READ)) {
         return NAN;
     }
-    return _bme->readHumidity();
+    value = _bme->readHumidity();
+    SENSOR_TRACE_RECORD(recordScalar(SensorChannel::HUMIDITY, value, !isnan(value)));
+    return value;
 }
 
 /**
- * @brief Lee la presión. Devuelve NAN si el sensor no fue inicializado.
+ * @brief Lee la presión de la última conversión. Devuelve NAN si el sensor no fue inicializado o está en reposo.
  */
 float BME280Sensor::readPressure() {
-    if (!_isInitialized) {
+    float value;
+    if (SENSOR_TRACE_REPLAYING()) {
+        SensorTrace::replayScalar(SensorChannel::PRESSURE, value);
+        return value;
+    }
+    if (!_isInitialized || _powerState != SensorPowerState::ACTIVE || FAULT_INJECT(I2C_BME_READ)) {
         return NAN;
     }
     // La librería devuelve la presión en Pascales (Pa). La convertimos a hPa.
-    return _bme->readPressure() / 100.0F;
+    value = _bme->readPressure() / 100.0F;
+    SENSOR_TRACE_RECORD(recordScalar(SensorChannel::PRESSURE, value, !isnan(value)));
+    return value;
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define BME280_SENSOR_H
 
 #include <Wire.h>
+#include "SensorPower.h" // SensorPowerState
 
 // Declaración anticipada (forward declaration) para evitar incluir
 // el pesado header de Adafruit aquí. Solo necesitamos el tipo "puntero a".
@@ -12,6 +13,10 @@ class Adafruit_BME280;
  * @brief Wrapper para el sensor BME280, que simplifica la lectura de
  * temperatura, humedad y presión a través de I2C.
  *
+ * El sensor mide en modo forzado: cada readTemperature() dispara una conversión
+ * (humedad y presión usan la misma) y el BME280 vuelve a dormir al terminar, en lugar
+ * del modo normal de la librería, que convierte sin parar y calienta el propio sensor.
+ *
  * @note Esta clase utiliza asignación dinámica de memoria (new/delete)
  * para el objeto de la librería subyacente.
  */
@@ -36,20 +41,32 @@ public:
     bool begin(uint8_t i2c_addr = 0x76);
 
     /**
-     * @brief Lee el valor de la temperatura.
-     * @return La temperatura en grados Celsius (°C). NAN si no está inicializado.
+     * @brief Cambia el estado de energía entre ciclos.
+     *
+     * ACTIVE configura el modo forzado y hace una primera conversión (vuelve cuando
+     * hay datos). STANDBY y OFF ponen el sensor en modo sleep (~0.1 µA): el BME280
+     * no tiene un estado más bajo.
+     *
+     * @return false si el sensor no está inicializado o la conversión no terminó.
+     */
+    bool setPowerState(SensorPowerState state);
+    SensorPowerState powerState() const { return _powerState; }
+
+    /**
+     * @brief Dispara una conversión y lee la temperatura.
+     * @return La temperatura en grados Celsius (°C). NAN si no está inicializado o en reposo.
      */
     float readTemperature();
 
     /**
-     * @brief Lee el valor de la humedad relativa.
-     * @return La humedad en porcentaje (%). NAN si no está inicializado.
+     * @brief Lee la humedad relativa de la última conversión.
+     * @return La humedad en porcentaje (%). NAN si no está inicializado o en reposo.
      */
     float readHumidity();
 
     /**
-     * @brief Lee el valor de la presión barométrica.
-     * @return La presión en hectopascales (hPa). NAN si no está inicializado.
+     * @brief Lee la presión barométrica de la última conversión.
+     * @return La presión en hectopascales (hPa). NAN si no está inicializado o en reposo.
      */
     float readPressure();
 
@@ -62,6 +79,9 @@ private:
     
     ///< Bandera para verificar si begin() fue exitoso.
     bool _isInitialized;  
+
+    ///< Estado de energía actual (las lecturas solo se hacen en ACTIVE).
+    SensorPowerState _powerState;
 };
 
 #endif // BME280_SENSOR_H
\ No newline at end of file
@@ -0,0 +1,88 @@
+#ifndef BOARD_PROFILE_H
+#define BOARD_PROFILE_H
+
+#include <stdint.h>
+
+// Perfil de placa y sensores elegido en tiempo de compilación con -D BOARD_PROFILE_<NOMBRE>
+// (un entorno de platformio.ini por perfil; sin flag se compila el perfil completo).
+// Los pines son constantes de la estructura `Board`; los sensores opcionales se compilan
+// o no con las macros BOARD_HAS_* (drivers, tareas y campos del payload), porque el
+// toolchain es C++11 y un `if` normal seguiría enlazando el driver.
+
+#if defined(BOARD_PROFILE_FULL) && defined(BOARD_PROFILE_THERMAL_ONLY)
+    #error "Select a single board profile per environment"
+#endif
+
+#if defined(BOARD_PROFILE_THERMAL_ONLY)
+    #define BOARD_PROFILE_NAME      "thermal_only"
+    #define BOARD_HAS_CAMERA        0   ///< OV2640 (imagen visual e índices de vegetación)
+    #define BOARD_HAS_LIGHT_SENSOR  0   ///< BH1750 (lux; decide la captura visual)
+#else
+    #define BOARD_PROFILE_NAME      "full"
+    #define BOARD_HAS_CAMERA        1
+    #define BOARD_HAS_LIGHT_SENSOR  1
+#endif
+
+/**
+ * @brief Pines de la Freenove ESP32-S3 WROOM (comunes a todos los perfiles).
+ */
+struct FreenoveEsp32S3Pins {
+    // --- Bus I2C (BME280, BH1750, MLX90640) y sensor interno 1-Wire ---
+    static constexpr int I2C_SDA_PIN = 47;
+    static constexpr int I2C_SCL_PIN = 21;
+    static constexpr int TEMP_INTERNAL_PIN = 14;   ///< DS18B20 (control del ventilador)
+    /// Interruptor de carga del MLX90640 (-1 = alimentación fija; el sensor no tiene modo de reposo)
+    static constexpr int THERMAL_POWER_PIN = -1;
+
+    // --- LED de estado (NeoPixel) ---
+    static constexpr int LED_PIN = 48;
+
+    // --- SD_MMC (modo 1-bit) ---
+    static constexpr int SD_MMC_CLK_PIN = 39;
+    static constexpr int SD_MMC_CMD_PIN = 38;
+    static constexpr int SD_MMC_D0_PIN = 40;
+
+    // --- Cámara OV2640 (-1 = no usado) ---
+    static constexpr int CAM_PWDN_PIN = -1;
+    static constexpr int CAM_RESET_PIN = -1;
+    static constexpr int CAM_XCLK_PIN = 15;
+    static constexpr int CAM_SIOD_PIN = 4;         ///< Datos SCCB
+    static constexpr int CAM_SIOC_PIN = 5;         ///< Reloj SCCB
+    static constexpr int CAM_Y2_PIN = 11;          ///< D0 ... Y9 = D7 (bus paralelo de 8 bits)
+    static constexpr int CAM_Y3_PIN = 9;
+    static constexpr int CAM_Y4_PIN = 8;
+    static constexpr int CAM_Y5_PIN = 10;
+    static constexpr int CAM_Y6_PIN = 12;
+    static constexpr int CAM_Y7_PIN = 18;
+    static constexpr int CAM_Y8_PIN = 17;
+    static constexpr int CAM_Y9_PIN = 16;
+    static constexpr int CAM_VSYNC_PIN = 6;
+    static constexpr int CAM_HREF_PIN = 7;
+    static constexpr int CAM_PCLK_PIN = 13;
+};
+
+/**
+ * @brief Sensores opcionales de un perfil. MLX90640, BME280 y DS18B20 están en todos.
+ */
+template <bool Camera, bool LightSensor>
+struct SensorSet {
+    static constexpr bool HAS_CAMERA = Camera;
+    static constexpr bool HAS_LIGHT_SENSOR = LightSensor;
+    static_assert(!Camera || LightSensor, "The visual capture is gated on the BH1750 light level");
+};
+
+/// Térmica, visual, ambiente y luz (despliegue estándar).
+struct FullProfile : FreenoveEsp32S3Pins, SensorSet<true, true> {};
+/// Solo térmica y ambiente: sin cámara ni sensor de luz (nodos de dosel de bajo coste).
+struct ThermalOnlyProfile : FreenoveEsp32S3Pins, SensorSet<false, false> {};
+
+#if defined(BOARD_PROFILE_THERMAL_ONLY)
+    typedef ThermalOnlyProfile Board;
+#else
+    typedef FullProfile Board;
+#endif
+
+static_assert(Board::HAS_CAMERA == (BOARD_HAS_CAMERA != 0), "BOARD_HAS_CAMERA must match the Board profile");
+static_assert(Board::HAS_LIGHT_SENSOR == (BOARD_HAS_LIGHT_SENSOR != 0), "BOARD_HAS_LIGHT_SENSOR must match the Board profile");
+
+#endif // BOARD_PROFILE_H
@@ -0,0 +1,192 @@
+#include "ClusterWriter.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef ESP_PLATFORM
+  #include "esp_heap_caps.h"
+  #include "ff.h"
+#endif
+
+// --- ClusterWriterStats ---
+
+void ClusterWriterStats::add(const ClusterWriterStats& other) {
+    payloadBytes += other.payloadBytes;
+    deviceBytes += other.deviceBytes;
+    writeCalls += other.writeCalls;
+    preallocations += other.preallocations;
+}
+
+float ClusterWriterStats::amplification() const {
+    return payloadBytes > 0 ? (float)deviceBytes / (float)payloadBytes : 0.0f;
+}
+
+uint64_t ClusterWriterStats::sectorSpan(uint64_t offset, size_t length) {
+    if (length == 0) return 0;
+    uint64_t first = offset / CLUSTER_WRITER_SECTOR_BYTES;
+    uint64_t last = (offset + length - 1) / CLUSTER_WRITER_SECTOR_BYTES;
+    return (last - first + 1) * CLUSTER_WRITER_SECTOR_BYTES;
+}
+
+// --- ClusterWriter ---
+
+static size_t roundUpToSector(size_t bytes) {
+    return (bytes + CLUSTER_WRITER_SECTOR_BYTES - 1) / CLUSTER_WRITER_SECTOR_BYTES * CLUSTER_WRITER_SECTOR_BYTES;
+}
+
+// (El controlador SDMMC solo transfiere por DMA desde RAM interna alineada a 4 bytes;
+//  con cualquier otro buffer copia sector a sector a través de uno intermedio)
+static uint8_t* allocDmaBuffer(size_t size) {
+#ifdef ESP_PLATFORM
+    return (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+#else
+    return (uint8_t*)malloc(size);
+#endif
+}
+
+ClusterWriter::ClusterWriter(size_t chunkBytes)
+    : _fd(-1), _path(nullptr), _buffer(nullptr), _chunk(0), _maxChunk(0), _bufferUsed(0),
+      _flushedSize(0), _allocated(0), _growStep(0), _failed(false) {
+    size_t chunk = chunkBytes > CLUSTER_WRITER_MAX_CHUNK ? CLUSTER_WRITER_MAX_CHUNK : chunkBytes;
+    _maxChunk = chunk < CLUSTER_WRITER_SECTOR_BYTES ? CLUSTER_WRITER_SECTOR_BYTES : roundUpToSector(chunk);
+    _chunk = _maxChunk;
+}
+
+ClusterWriter::~ClusterWriter() {
+    close();
+}
+
+bool ClusterWriter::open(const char* path, bool append, size_t expectedSize, size_t growStep) {
+    close();
+    _stats = ClusterWriterStats();
+
+    _fd = ::open(path, O_WRONLY | O_CREAT | (append ? 0 : O_TRUNC), 0644);
+    if (_fd < 0) return false;
+    off_t end = append ? lseek(_fd, 0, SEEK_END) : 0;
+    if (end < 0) {
+        _release();
+        return false;
+    }
+
+    // Un archivo que cabe en un bloque no necesita un buffer del tamaño del cluster
+    _chunk = _maxChunk;
+    if (expectedSize > 0 && roundUpToSector(expectedSize) < _chunk) _chunk = roundUpToSector(expectedSize);
+    _buffer = allocDmaBuffer(_chunk);
+    while (_buffer == nullptr && _chunk > CLUSTER_WRITER_SECTOR_BYTES) {
+        _chunk /= 2; // RAM interna fragmentada: bloques menores (siguen alineados a sector)
+        _buffer = allocDmaBuffer(_chunk);
+    }
+    _path = strdup(path);
+    if (_buffer == nullptr || _path == nullptr) {
+        _release();
+        return false;
+    }
+
+    _bufferUsed = 0;
+    _flushedSize = (uint64_t)end;
+    _allocated = (uint64_t)end;
+    _growStep = growStep;
+    _failed = false;
+    if (expectedSize > (size_t)end) _reserve(expectedSize); // Sin reserva se escribe igual
+    return true;
+}
+
+size_t ClusterWriter::write(const uint8_t* data, size_t length) {
+    if (_fd < 0 || _failed) return 0;
+    size_t remaining = length;
+    while (remaining > 0) {
+        // El bloque termina en el siguiente múltiplo de _chunk del archivo (el primero puede
+        // ser más corto al continuar un archivo existente)
+        size_t limit = _chunk - (size_t)(_flushedSize % _chunk);
+        size_t n = limit - _bufferUsed;
+        if (n > remaining) n = remaining;
+        memcpy(_buffer + _bufferUsed, data, n);
+        _bufferUsed += n;
+        data += n;
+        remaining -= n;
+
+        if (_bufferUsed == limit) {
+            if (!_writeOut(_buffer, _bufferUsed)) return 0;
+            _bufferUsed = 0;
+        }
+    }
+    _stats.payloadBytes += length;
+    return length;
+}
+
+bool ClusterWriter::flush(bool sync) {
+    if (_fd < 0 || _failed) return false;
+    if (_bufferUsed > 0) {
+        if (!_writeOut(_buffer, _bufferUsed)) return false;
+        _bufferUsed = 0;
+    }
+    return !sync || fsync(_fd) == 0;
+}
+
+bool ClusterWriter::close() {
+    if (_fd < 0) return true;
+    bool ok = flush(false);
+    bool trim = _allocated > _flushedSize;
+    // Sin reserva sobrante se sincroniza aquí; con ella, truncate() ya guarda el tamaño final
+    if (!trim && ok) ok = fsync(_fd) == 0;
+    ok = ::close(_fd) == 0 && ok;
+    _fd = -1;
+    if (trim && truncate(_path, (off_t)_flushedSize) != 0) ok = false;
+    _release();
+    return ok;
+}
+
+size_t ClusterWriter::detectClusterSize() {
+#ifdef ESP_PLATFORM
+    // La SD es el único volumen FAT del firmware (la configuración usa LittleFS): unidad "0:"
+    FATFS* fs = nullptr;
+    DWORD freeClusters = 0;
+    if (f_getfree("0:", &freeClusters, &fs) != FR_OK || fs == nullptr) return 0;
+  #if FF_MAX_SS != FF_MIN_SS
+    return (size_t)fs->csize * fs->ssize;
+  #else
+    return (size_t)fs->csize * FF_MAX_SS;
+  #endif
+#else
+    return 0;
+#endif
+}
+
+bool ClusterWriter::_writeOut(const uint8_t* data, size_t length) {
+    if (_growStep > 0 && _flushedSize + length > _allocated) {
+        uint64_t target = _flushedSize + length;
+        _reserve((target + _growStep - 1) / _growStep * _growStep);
+    }
+    ssize_t written = ::write(_fd, data, length);
+    _stats.writeCalls++;
+    _stats.deviceBytes += ClusterWriterStats::sectorSpan(_flushedSize, written > 0 ? (size_t)written : 0);
+    if (written != (ssize_t)length) {
+        _failed = true;
+        return false;
+    }
+    _flushedSize += length;
+    return true;
+}
+
+bool ClusterWriter::_reserve(uint64_t size) {
+    if (size <= _allocated) return true;
+    // FAT: un lseek más allá del final con el archivo abierto para escritura asigna la
+    // cadena de clusters hasta esa posición (contenido indefinido hasta que se escriba)
+    bool ok = lseek(_fd, (off_t)size, SEEK_SET) >= 0;
+    lseek(_fd, (off_t)_flushedSize, SEEK_SET);
+    if (!ok) return false;
+    _allocated = size;
+    _stats.preallocations++;
+    return true;
+}
+
+void ClusterWriter::_release() {
+    if (_fd >= 0) ::close(_fd);
+    _fd = -1;
+    free(_buffer);
+    _buffer = nullptr;
+    free(_path);
+    _path = nullptr;
+    _bufferUsed = 0;
+}
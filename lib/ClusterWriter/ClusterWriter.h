@@ -0,0 +1,121 @@
+#ifndef CLUSTER_WRITER_H
+#define CLUSTER_WRITER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Sin dependencias de Arduino: escribe con open()/write() sobre el VFS (en el ESP32 la SD
+// está montada en "/sdcard"), igual que SensorTrace, así que también compila en el host.
+
+#define CLUSTER_WRITER_SECTOR_BYTES 512            // Sector de la SD (unidad mínima de escritura)
+#define CLUSTER_WRITER_DEFAULT_CHUNK (16 * 1024)   // Bloque si no se conoce el cluster
+#define CLUSTER_WRITER_MAX_CHUNK (16 * 1024)       // Tope del buffer (RAM interna con DMA)
+#define CLUSTER_WRITER_LOG_GROW_STEP (64 * 1024)   // Reserva de los logs (se recorta al cerrar)
+
+/**
+ * @brief Contadores de escritura, acumulables entre archivos.
+ * La amplificación estima los bytes que la tarjeta escribe de verdad: cada write() que
+ * toca un sector a medias obliga a reescribir el sector completo (512 bytes).
+ */
+struct ClusterWriterStats {
+    uint64_t payloadBytes = 0;   ///< Bytes pedidos por el llamador
+    uint64_t deviceBytes = 0;    ///< Bytes de sectores tocados por cada write() al FS
+    uint32_t writeCalls = 0;     ///< Llamadas write() al FS
+    uint32_t preallocations = 0; ///< Reservas de espacio (cadenas de clusters pedidas de una vez)
+
+    void add(const ClusterWriterStats& other);
+
+    /**
+     * @brief deviceBytes / payloadBytes (1.0 = sin sobrecoste; 0 si no se escribió nada).
+     */
+    float amplification() const;
+
+    /**
+     * @brief Bytes de sectores que toca una escritura de `length` bytes en `offset`.
+     */
+    static uint64_t sectorSpan(uint64_t offset, size_t length);
+};
+
+/**
+ * @class ClusterWriter
+ * @brief Escritor de archivos con buffer alineado al cluster de la SD.
+ *
+ * Las escrituras pequeñas o de tamaño arbitrario se acumulan en un buffer de RAM interna
+ * con DMA y se vuelcan en bloques del tamaño del cluster (tope CLUSTER_WRITER_MAX_CHUNK)
+ * alineados con el inicio del archivo: el controlador SDMMC transfiere directamente desde
+ * el buffer (sin copias por sector, que es lo que ocurre con datos en PSRAM o desalineados)
+ * y ningún sector se escribe dos veces salvo el último.
+ *
+ * Con `expectedSize` (ej. un JPEG de tamaño conocido) el archivo se reserva entero al abrir;
+ * con `growStep` (logs) crece en pasos grandes. En FAT la reserva es un lseek más allá del
+ * final, que asigna la cadena de clusters de una vez en lugar de extenderla en cada escritura.
+ * close() recorta el archivo a los bytes escritos. Si hay un corte con el archivo abierto,
+ * el final reservado queda con contenido indefinido hasta el siguiente cierre.
+ */
+class ClusterWriter {
+public:
+    /**
+     * @param chunkBytes Tamaño del bloque (se redondea a sectores y se limita a CLUSTER_WRITER_MAX_CHUNK).
+     */
+    explicit ClusterWriter(size_t chunkBytes = CLUSTER_WRITER_DEFAULT_CHUNK);
+    ~ClusterWriter();
+
+    /**
+     * @brief Abre el archivo para escribir.
+     * @param path Ruta VFS (ej. "/sdcard/logs/20251031_log.txt").
+     * @param append True para continuar al final de un archivo existente; false lo trunca.
+     * @param expectedSize Tamaño final previsto (0 = desconocido). Se reserva al abrir.
+     * @param growStep Paso de reserva mientras crece (0 = sin reserva incremental).
+     * @return True si se abrió y se pudo asignar el buffer (la reserva de espacio es opcional).
+     */
+    bool open(const char* path, bool append, size_t expectedSize = 0, size_t growStep = 0);
+
+    /**
+     * @brief Añade datos (se vuelcan al FS por bloques completos).
+     * @return `length`, o 0 si falló una escritura al FS (el escritor queda en error hasta close()).
+     */
+    size_t write(const uint8_t* data, size_t length);
+
+    /**
+     * @brief Vuelca el buffer pendiente. Con `sync`, además hace fsync.
+     */
+    bool flush(bool sync = false);
+
+    /**
+     * @brief Vuelca, sincroniza, recorta la reserva sobrante y cierra.
+     * @return True si todo lo escrito llegó al FS.
+     */
+    bool close();
+
+    bool isOpen() const { return _fd >= 0; }
+    uint32_t size() const { return (uint32_t)(_flushedSize + _bufferUsed); } ///< Bytes lógicos del archivo
+    size_t chunkBytes() const { return _chunk; }
+    const ClusterWriterStats& stats() const { return _stats; }
+
+    /**
+     * @brief Tamaño de cluster del FAT montado en la SD (0 si no se puede obtener).
+     */
+    static size_t detectClusterSize();
+
+private:
+    int _fd;
+    char* _path;
+    uint8_t* _buffer;
+    size_t _chunk;          // Bloque del archivo abierto (menor si el archivo es pequeño o falta RAM)
+    size_t _maxChunk;       // Bloque pedido en el constructor
+    size_t _bufferUsed;
+    uint64_t _flushedSize;  // Bytes ya volcados (posición de escritura en el archivo)
+    uint64_t _allocated;    // Tamaño reservado (>= tamaño lógico)
+    size_t _growStep;
+    bool _failed;
+    ClusterWriterStats _stats;
+
+    bool _writeOut(const uint8_t* data, size_t length);
+    bool _reserve(uint64_t size);
+    void _release();
+
+    ClusterWriter(const ClusterWriter&);
+    ClusterWriter& operator=(const ClusterWriter&);
+};
+
+#endif // CLUSTER_WRITER_H
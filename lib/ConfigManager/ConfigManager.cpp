@@ -109,6 +109,45 @@ bool loadConfiguration(const char *filename) {
 
     config.data_interval_minutes = doc["data_interval_minutes"] | config.data_interval_minutes;
 
+    config.backlog_thin_after_hours = doc["backlog_thin_after_hours"] | config.backlog_thin_after_hours;
+    config.backlog_thin_interval_minutes = doc["backlog_thin_interval_minutes"] | config.backlog_thin_interval_minutes;
+    config.backlog_summary_after_hours = doc["backlog_summary_after_hours"] | config.backlog_summary_after_hours;
+    config.backlog_summary_bucket_minutes = doc["backlog_summary_bucket_minutes"] | config.backlog_summary_bucket_minutes;
+    config.backlog_max_pending_mb = doc["backlog_max_pending_mb"] | config.backlog_max_pending_mb;
+    config.backlog_max_items_per_cycle = doc["backlog_max_items_per_cycle"] | config.backlog_max_items_per_cycle;
+    config.backlog_drain_budget_seconds = doc["backlog_drain_budget_seconds"] | config.backlog_drain_budget_seconds;
+
+    config.deadline_environment_seconds = doc["deadline_environment_seconds"] | config.deadline_environment_seconds;
+    config.deadline_image_seconds = doc["deadline_image_seconds"] | config.deadline_image_seconds;
+    config.deadline_upload_seconds = doc["deadline_upload_seconds"] | config.deadline_upload_seconds;
+    config.deadline_maintenance_seconds = doc["deadline_maintenance_seconds"] | config.deadline_maintenance_seconds;
+
+    config.sensor_idle_state = doc["sensor_idle_state"] | config.sensor_idle_state;
+
+    config.thermal_homography = doc["thermal_homography"] | config.thermal_homography;
+
+    config.burst_z_threshold = doc["burst_z_threshold"] | config.burst_z_threshold;
+    config.burst_interval_minutes = doc["burst_interval_minutes"] | config.burst_interval_minutes;
+    config.burst_duration_minutes = doc["burst_duration_minutes"] | config.burst_duration_minutes;
+    config.burst_cooldown_minutes = doc["burst_cooldown_minutes"] | config.burst_cooldown_minutes;
+    config.burst_max_captures_per_day = doc["burst_max_captures_per_day"] | config.burst_max_captures_per_day;
+
+    config.log_level_sd = doc["log_level_sd"] | config.log_level_sd;
+    config.log_level_remote = doc["log_level_remote"] | config.log_level_remote;
+    config.log_level_api = doc["log_level_api"] | config.log_level_api;
+    config.log_level_sdmanager = doc["log_level_sdmanager"] | config.log_level_sdmanager;
+    config.log_level_image = doc["log_level_image"] | config.log_level_image;
+    config.log_level_environment = doc["log_level_environment"] | config.log_level_environment;
+    config.log_level_wifi = doc["log_level_wifi"] | config.log_level_wifi;
+
+    config.fault_injection = doc["fault_injection"] | config.fault_injection;
+    config.fault_injection_seed = doc["fault_injection_seed"] | config.fault_injection_seed;
+
+    config.sensor_trace_mode = doc["sensor_trace_mode"] | config.sensor_trace_mode;
+    config.sensor_trace_file = doc["sensor_trace_file"] | config.sensor_trace_file;
+    config.sensor_trace_speed = doc["sensor_trace_speed"] | config.sensor_trace_speed;
+    config.sensor_trace_loop = doc["sensor_trace_loop"] | config.sensor_trace_loop;
+
     #ifdef ENABLE_DEBUG_SERIAL
         Serial.println("[ConfigMgr] Configuration loaded successfully from file.");
         // (Los logs detallados de cada variable se omiten aquí por brevedad,
@@ -150,4 +189,24 @@ bool saveConfiguration(const String& jsonString) {
         #endif
         return false;
     }
-}
\ No newline at end of file
+}
+/**
+ * @brief Guarda las claves recibidas sobre el archivo de configuración actual.
+ */
+bool mergeConfiguration(JsonObjectConst updates) {
+    JsonDocument doc;
+    File configFile = LittleFS.open(CONFIG_FILENAME, "r");
+    if (configFile) {
+        // Un archivo ilegible se reemplaza por completo con las claves recibidas
+        if (deserializeJson(doc, configFile) || !doc.is<JsonObject>()) doc.clear();
+        configFile.close();
+    }
+
+    for (JsonPairConst kv : updates) {
+        doc[kv.key()] = kv.value();
+    }
+
+    String output;
+    serializeJson(doc, output);
+    return saveConfiguration(output);
+}
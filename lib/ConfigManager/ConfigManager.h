@@ -2,6 +2,7 @@
 #define CONFIG_MANAGER_H
 
 #include <Arduino.h> 
+#include <ArduinoJson.h>
 
 // --- Estructura de Configuración ---
 /**
@@ -23,6 +24,81 @@ struct Config {
     String apiAmbientDataPath = "/api/device-api/ambient-data";
     String apiCaptureDataPath = "/api/device-api/capture-data";
     int data_interval_minutes = 30;
+
+    // --- Política de backlog (cola offline tras cortes prolongados) ---
+    ///< Capturas pendientes más antiguas que esto (horas) se "adelgazan".
+    int backlog_thin_after_hours = 24;
+    ///< Tras adelgazar, se conserva una captura (solo térmica) por este intervalo (min).
+    int backlog_thin_interval_minutes = 60;
+    ///< Datos ambientales pendientes más antiguos que esto (horas) se resumen.
+    int backlog_summary_after_hours = 6;
+    ///< Ancho (min) de cada ventana de resumen ambiental.
+    int backlog_summary_bucket_minutes = 60;
+    ///< Tope de bytes pendientes (MB). Lo más antiguo pasa a 'archive' sin enviarse.
+    int backlog_max_pending_mb = 256;
+    ///< Máximo de envíos de la cola pendiente por ciclo.
+    int backlog_max_items_per_cycle = 20;
+    ///< Tiempo máximo (s) dedicado a vaciar la cola pendiente por ciclo.
+    int backlog_drain_budget_seconds = 120;
+
+    // --- Plazos por fase del ciclo (PhaseDeadline, 0 = sin límite) ---
+    ///< Lectura y envío de datos ambientales (s).
+    int deadline_environment_seconds = 60;
+    ///< Captura, análisis, envío y guardado de imágenes (s).
+    int deadline_image_seconds = 120;
+    ///< Cada envío de datos del ciclo, con su reintento tras un 401 (s).
+    int deadline_upload_seconds = 45;
+    ///< Cada tramo de mantenimiento: nivel rápido y compactación, y limpieza de la SD (s).
+    int deadline_maintenance_seconds = 90;
+
+    // --- Energía de los sensores entre ciclos (SensorPower) ---
+    ///< "standby" (reposo, despertar rápido), "off" (drivers liberados) o "active" (sin gestión).
+    String sensor_idle_state = "standby";
+
+    // --- Registro térmico-visual ---
+    ///< Homografía imagen visual (640x480) -> rejilla térmica (32x24): 9 coeficientes fila a fila
+    ///< separados por comas (tools/thermal_calibration.py). Vacío = sin calibrar (sin estadísticas del dosel).
+    String thermal_homography = "";
+
+    // --- Ráfagas por anomalía térmica (AnomalyDetector) ---
+    ///< Puntuación z de (dosel - aire) que inicia una ráfaga. 0 = sin ráfagas.
+    float burst_z_threshold = 3.0f;
+    ///< Intervalo (min) entre capturas durante una ráfaga.
+    int burst_interval_minutes = 5;
+    ///< Duración máxima (min) de una ráfaga.
+    int burst_duration_minutes = 60;
+    ///< Tiempo (min) sin ráfagas nuevas tras terminar una.
+    int burst_cooldown_minutes = 180;
+    ///< Máximo de capturas de ráfaga por día (UTC).
+    int burst_max_captures_per_day = 24;
+
+    // --- Filtros de log (valores: "INFO", "WARNING", "ERROR" o "NONE") ---
+    ///< Nivel mínimo para escribir en la SD.
+    String log_level_sd = "INFO";
+    ///< Nivel mínimo para enviar a la API remota.
+    String log_level_remote = "INFO";
+    ///< Niveles mínimos por módulo (se combinan con el del destino: gana el más alto).
+    String log_level_api = "INFO";
+    String log_level_sdmanager = "INFO";
+    String log_level_image = "INFO";
+    String log_level_environment = "INFO";
+    String log_level_wifi = "INFO";
+
+    // --- Inyección de fallos (solo con -D ENABLE_FAULT_INJECTION) ---
+    ///< Programa de fallos, ej. "SD_RENAME:nth=2;HTTP_REQUEST:p=0.25,latency=1500". Vacío = ninguno.
+    String fault_injection = "";
+    ///< Semilla del PRNG (misma semilla + mismo programa = misma secuencia de fallos).
+    int fault_injection_seed = 1;
+
+    // --- Grabación/reproducción de sensores (solo con -D ENABLE_SENSOR_TRACE) ---
+    ///< "off", "record" (graba todas las lecturas) o "replay" (los sensores leen de la traza).
+    String sensor_trace_mode = "off";
+    ///< Archivo de traza en la SD. Al grabar, cada arranque añade "_NNNN" antes de la extensión.
+    String sensor_trace_file = "/sensor_trace.trc";
+    ///< Velocidad de reproducción: 1 = tiempo real, 10 = 10× más rápido, 0 = sin esperas.
+    float sensor_trace_speed = 1.0f;
+    ///< Si es true, la reproducción vuelve al principio al agotarse la traza.
+    bool sensor_trace_loop = false;
 };
 
 // Declara la instancia *global* 'config'.
@@ -58,4 +134,12 @@ void loadConfigurationFromFile();
  */
 bool saveConfiguration(const String& jsonString);
 
+/** * @brief Guarda las claves recibidas sobre el archivo de configuración actual.
+ * Las claves del archivo que 'updates' no incluye (ej. las que el formulario del
+ * portal no muestra) se conservan en lugar de perderse al sobrescribir.
+ * @param updates Objeto JSON con las claves a escribir.
+ * @return True si se guardó correctamente, false si falló la escritura.
+ */
+bool mergeConfiguration(JsonObjectConst updates);
+
 #endif // CONFIG_MANAGER_H
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "DS18B20Sensor.h"
+#include "SensorTrace.h" // Grabación/reproducción de lecturas (no-op sin ENABLE_SENSOR_TRACE)
 
 /**
  * @brief Constructor.
@@ -23,6 +24,11 @@ void DS18B20Sensor::begin() {
  * @brief Lee la temperatura del primer sensor encontrado en el bus.
  */
 float DS18B20Sensor::readTemperature() {
+    float tempC;
+    if (SENSOR_TRACE_REPLAYING()) {
+        return SensorTrace::replayScalar(SensorChannel::DEVICE_TEMPERATURE, tempC) ? tempC : DEVICE_DISCONNECTED_C;
+    }
+
     // Paso 1: Envía el comando para solicitar las lecturas a TODOS
     // los dispositivos DS18B20 presentes en el bus.
     _sensors.requestTemperatures();
@@ -30,7 +36,8 @@ float DS18B20Sensor::readTemperature() {
     // Paso 2: Obtiene la temperatura del primer sensor (índice 0).
     // Si se produce un error (ej. sensor desconectado), la librería
     // retorna el valor constante DEVICE_DISCONNECTED_C (-127).
-    float tempC = _sensors.getTempCByIndex(0);
+    tempC = _sensors.getTempCByIndex(0);
+    SENSOR_TRACE_RECORD(recordScalar(SensorChannel::DEVICE_TEMPERATURE, tempC));
     
     return tempC;
 }
\ No newline at end of file
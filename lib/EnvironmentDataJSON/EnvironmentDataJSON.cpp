@@ -4,6 +4,10 @@
  */
 #include "EnvironmentDataJSON.h"
 #include <WiFi.h> // Para la comprobación WiFi.status()
+#include "Trace.h" // Instrumentación de trazas (no-op sin ENABLE_TRACE)
+#include "FaultInjection.h" // Inyección de fallos (no-op sin ENABLE_FAULT_INJECTION)
+#include "PhaseDeadline.h" // Plazo de la fase en curso (acota el timeout del POST)
+#include "BoardProfile.h" // Campos del payload según los sensores del perfil
 
 // Timeout para las peticiones HTTP de datos ambientales (milisegundos)
 #define ENV_DATA_HTTP_REQUEST_TIMEOUT 10000
@@ -18,7 +22,9 @@ int EnvironmentDataJSON::IOEnvironmentData(
     float lightLevel,
     float temperature,
     float humidity,
-    float pressure
+    float pressure,
+    int samples,
+    const String& windowEnd
 ) {
     // --- 1. Validaciones previas (errores locales) ---
 
@@ -38,13 +44,30 @@ int EnvironmentDataJSON::IOEnvironmentData(
         return -2; // Código de error: Sin WiFi
     }
 
+    // Error: Plazo de la fase vencido (el llamador guarda los datos en pendientes)
+    if (PhaseDeadline::expired()) {
+        #ifdef ENABLE_DEBUG_SERIAL
+            Serial.println(F("[EnvDataJSON] Skipped sending: phase deadline expired."));
+        #endif
+        return -6;
+    }
+
     // --- 2. Construir el payload JSON ---
     JsonDocument doc;
     doc["timestamp"] = timestamp;
-    doc["light"] = lightLevel;
+    #if BOARD_HAS_LIGHT_SENSOR
+        doc["light"] = lightLevel; // Sin sensor de luz el campo no se envía
+    #else
+        (void)lightLevel;
+    #endif
     doc["temperature"] = temperature;
     doc["humidity"] = humidity;
     doc["pressure"] = pressure;
+    if (samples > 1) {
+        // Resumen del backlog: promedio de 'samples' lecturas entre 'timestamp' y 'window_end'
+        doc["samples"] = samples;
+        doc["window_end"] = windowEnd;
+    }
 
     String jsonPayload;
     serializeJson(doc, jsonPayload);
@@ -72,7 +95,8 @@ int EnvironmentDataJSON::IOEnvironmentData(
     
     // http.begin() es para HTTP. Para HTTPS, se debe usar un WiFiClientSecure.
     if (http.begin(fullEnvDataUrl)) { 
-        http.setTimeout(ENV_DATA_HTTP_REQUEST_TIMEOUT);
+        http.setConnectTimeout(PhaseDeadline::boundTimeout(HTTPCLIENT_DEFAULT_TCP_TIMEOUT));
+        http.setTimeout(PhaseDeadline::boundTimeout(ENV_DATA_HTTP_REQUEST_TIMEOUT));
         http.addHeader("Content-Type", "application/json");
         http.addHeader("Connection", "close"); // Indicar al servidor que cierre la conexión
 
@@ -86,7 +110,10 @@ int EnvironmentDataJSON::IOEnvironmentData(
         }
 
         // Ejecutar la petición POST
-        httpResponseCode = http.POST(jsonPayload);
+        if (FAULT_INJECT(WIFI_DROP)) WiFi.disconnect();
+        TRACE_BEGIN(HTTP_POST_AMBIENT);
+        httpResponseCode = FAULT_INJECT(HTTP_REQUEST) ? HTTPC_ERROR_CONNECTION_LOST : http.POST(jsonPayload);
+        TRACE_END(HTTP_POST_AMBIENT);
 
         #ifdef ENABLE_DEBUG_SERIAL
             if (httpResponseCode > 0) {
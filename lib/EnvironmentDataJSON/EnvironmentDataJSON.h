@@ -25,10 +25,13 @@ public:
      * @param fullEnvDataUrl URL completa (String) del endpoint de la API.
      * @param accessToken Token de acceso (String) para la cabecera 'Authorization'.
      * @param timestamp Hora de captura en formato ISO 8601 (String).
-     * @param lightLevel Nivel de luz ambiental (float, lux).
+     * @param lightLevel Nivel de luz ambiental (float, lux). Se ignora si el perfil no tiene BH1750.
      * @param temperature Temperatura (float, °C).
      * @param humidity Humedad relativa (float, %).
      * @param pressure Presión barométrica (float, hPa).
+     * @param samples Lecturas promediadas en el envío (1 = lectura individual). Si es mayor que 1
+     * el payload incluye 'samples' y 'window_end' para que el backend distinga un resumen del backlog.
+     * @param windowEnd Timestamp de la última lectura promediada (solo se envía si samples > 1).
      *
      * @return El código de estado HTTP devuelto por el servidor (ej. 200, 401, 500).
      * Retorna un valor negativo si ocurre un error en el cliente
@@ -41,7 +44,9 @@ public:
         float lightLevel,
         float temperature,
         float humidity,
-        float pressure 
+        float pressure,
+        int samples = 1,
+        const String& windowEnd = ""
     );
 };
 
@@ -5,6 +5,10 @@
 #include <math.h>        // Para la comprobación isnan() de la temperatura
 #include "SDManager.h"    // Para la escritura local en SD
 #include "TimeManager.h"  // Para obtener los timestamps
+#include "ConfigManager.h" // Para los niveles de log configurables
+#include "Trace.h"         // Instrumentación de trazas (no-op sin ENABLE_TRACE)
+#include "FaultInjection.h" // Inyección de fallos (no-op sin ENABLE_FAULT_INJECTION)
+#include "PhaseDeadline.h"  // Sin envío remoto con el plazo de la fase vencido
 
 // Timeout para la petición HTTP de envío de logs (milisegundos)
 #define LOG_HTTP_REQUEST_TIMEOUT 5000 
@@ -14,13 +18,61 @@ const char LOG_TYPE_INFO[]    = "INFO";
 const char LOG_TYPE_WARNING[] = "WARNING";
 const char LOG_TYPE_ERROR[]   = "ERROR";
 
+// Nivel "NONE": mayor que cualquier LogLevel, desactiva el destino/módulo
+#define LOG_LEVEL_NONE 3
+
+// Filtros (por defecto todo habilitado: INFO = 0)
+uint8_t ErrorLogger::_sinkMinLevel[static_cast<uint8_t>(LogSink::COUNT)] = {0};
+uint8_t ErrorLogger::_moduleMinLevel[static_cast<uint8_t>(LogModule::COUNT)] = {0};
+
+// (Convierte "INFO"/"WARNING"/"ERROR"/"NONE" de config.json a nivel numérico)
+static uint8_t parseMinLevel(const String& text) {
+    String upper = text;
+    upper.trim();
+    upper.toUpperCase();
+    if (upper == "WARNING") return static_cast<uint8_t>(LogLevel::WARNING);
+    if (upper == "ERROR")   return static_cast<uint8_t>(LogLevel::ERROR);
+    if (upper == "NONE")    return LOG_LEVEL_NONE;
+    return static_cast<uint8_t>(LogLevel::INFO); // Por defecto (o valor desconocido): todo
+}
+
+void ErrorLogger::configureFilters(const Config& cfg) {
+    _sinkMinLevel[static_cast<uint8_t>(LogSink::SD)]     = parseMinLevel(cfg.log_level_sd);
+    _sinkMinLevel[static_cast<uint8_t>(LogSink::REMOTE)] = parseMinLevel(cfg.log_level_remote);
+
+    _moduleMinLevel[static_cast<uint8_t>(LogModule::CORE)]        = static_cast<uint8_t>(LogLevel::INFO);
+    _moduleMinLevel[static_cast<uint8_t>(LogModule::API)]         = parseMinLevel(cfg.log_level_api);
+    _moduleMinLevel[static_cast<uint8_t>(LogModule::SDMANAGER)]   = parseMinLevel(cfg.log_level_sdmanager);
+    _moduleMinLevel[static_cast<uint8_t>(LogModule::IMAGE)]       = parseMinLevel(cfg.log_level_image);
+    _moduleMinLevel[static_cast<uint8_t>(LogModule::ENVIRONMENT)] = parseMinLevel(cfg.log_level_environment);
+    _moduleMinLevel[static_cast<uint8_t>(LogModule::WIFI)]        = parseMinLevel(cfg.log_level_wifi);
+
+    #ifdef ENABLE_DEBUG_SERIAL
+        Serial.printf("[ErrorLogger] Log filters: SD>=%u, Remote>=%u, API>=%u, SD_Mgr>=%u, Image>=%u, Env>=%u, WiFi>=%u (0=INFO..3=NONE)\n",
+                      _sinkMinLevel[0], _sinkMinLevel[1],
+                      _moduleMinLevel[1], _moduleMinLevel[2], _moduleMinLevel[3], _moduleMinLevel[4], _moduleMinLevel[5]);
+    #endif
+}
+
+LogLevel ErrorLogger::levelFromLogType(const char* logType) {
+    if (logType != nullptr && strcmp(logType, LOG_TYPE_INFO) == 0) return LogLevel::INFO;
+    if (logType != nullptr && strcmp(logType, LOG_TYPE_WARNING) == 0) return LogLevel::WARNING;
+    return LogLevel::ERROR; // Por defecto, ERROR
+}
+
+bool ErrorLogger::isAnySinkEnabled(LogModule module, const char* logType) {
+    LogLevel level = levelFromLogType(logType);
+    return isEnabled(LogSink::SD, module, level) || isEnabled(LogSink::REMOTE, module, level);
+}
+
 bool ErrorLogger::sendLog(SDManager& sdManager,
                           TimeManager& timeManager,
                           const String& fullLogUrl, 
                           const String& accessToken, 
                           const char* logType, 
                           const String& logMessage, 
-                          float internalTemp) {
+                          float internalTemp,
+                          LogModule module) {
 
     // --- Paso 1: Validación de Parámetros Básicos ---
     if (logType == nullptr || logMessage.isEmpty()) {
@@ -34,20 +86,17 @@ bool ErrorLogger::sendLog(SDManager& sdManager,
     // Obtiene la hora actual o el tiempo de actividad (uptime) si el NTP no se ha sincronizado
     String timestamp = timeManager.getCurrentTimestampString(); 
 
-    // --- Paso 3: Registrar Localmente en la SD (Siempre Intentar) ---
+    // Convierte el 'const char*' (para la API) al 'enum LogLevel' (para la SD y los filtros)
+    LogLevel levelEnum = levelFromLogType(logType);
+
+    // --- Paso 3: Registrar Localmente en la SD (si el filtro de SD lo permite) ---
     bool localLogSuccess = false;
-    if (sdManager.isSDAvailable()) { 
-        // Convierte el 'const char*' (para la API) al 'enum LogLevel' (para la SD)
-        LogLevel levelEnum;
-        if (strcmp(logType, LOG_TYPE_INFO) == 0) {
-            levelEnum = LogLevel::INFO;
-        } else if (strcmp(logType, LOG_TYPE_WARNING) == 0) {
-            levelEnum = LogLevel::WARNING;
-        } else { // Por defecto, ERROR
-            levelEnum = LogLevel::ERROR;
-        }
-        
-        // Intenta escribir en el archivo de log de la SD
+    if (!isEnabled(LogSink::SD, module, levelEnum)) {
+        #ifdef ENABLE_DEBUG_SERIAL
+            Serial.println(F("[ErrorLogger] SD log skipped by level filter."));
+        #endif
+    } else if (sdManager.isLocalStorageAvailable()) { 
+        // Intenta escribir en el archivo de log de la SD (o en el nivel rápido en flash)
         localLogSuccess = sdManager.logToFile(timestamp, levelEnum, logMessage, internalTemp);
         #ifdef ENABLE_DEBUG_SERIAL
             if (localLogSuccess) {
@@ -64,8 +113,13 @@ bool ErrorLogger::sendLog(SDManager& sdManager,
 
     // --- Paso 4: Intentar Enviar Log a API Remota (Condicionalmente) ---
     
-    // Solo proceder si hay WiFi y se proporcionó una URL
-    if (WiFi.status() == WL_CONNECTED && !fullLogUrl.isEmpty()) {
+    // Solo proceder si el filtro remoto lo permite, hay WiFi, se proporcionó una URL
+    // y el plazo de la fase en curso no venció (el log ya quedó en la SD)
+    if (!isEnabled(LogSink::REMOTE, module, levelEnum)) {
+        #ifdef ENABLE_DEBUG_SERIAL
+            Serial.println(F("[ErrorLogger] Remote log skipped by level filter."));
+        #endif
+    } else if (WiFi.status() == WL_CONNECTED && !fullLogUrl.isEmpty() && !PhaseDeadline::expired()) {
         #ifdef ENABLE_DEBUG_SERIAL
             Serial.println(F("[ErrorLogger] WiFi connected. Attempting to send log to remote API."));
             if (accessToken.isEmpty()) {
@@ -98,7 +152,7 @@ bool ErrorLogger::sendLog(SDManager& sdManager,
         http.setReuse(false); // Evitar conexiones "stale" (obsoletas)
 
         if (http.begin(fullLogUrl)) {
-            http.setTimeout(LOG_HTTP_REQUEST_TIMEOUT);
+            http.setTimeout(PhaseDeadline::boundTimeout(LOG_HTTP_REQUEST_TIMEOUT));
             http.addHeader("Content-Type", "application/json");
             http.addHeader("Connection", "close");
             if (!accessToken.isEmpty()) {
@@ -106,7 +160,9 @@ bool ErrorLogger::sendLog(SDManager& sdManager,
             }
 
             // Enviar la petición POST
-            int httpResponseCode = http.POST(jsonPayload);
+            TRACE_BEGIN(HTTP_POST_LOG);
+            int httpResponseCode = FAULT_INJECT(HTTP_REQUEST) ? HTTPC_ERROR_CONNECTION_LOST : http.POST(jsonPayload);
+            TRACE_END(HTTP_POST_LOG);
 
             if (httpResponseCode >= 200 && httpResponseCode < 300) {
                 #ifdef ENABLE_DEBUG_SERIAL
@@ -134,6 +190,9 @@ bool ErrorLogger::sendLog(SDManager& sdManager,
             if (fullLogUrl.isEmpty()) {
                  Serial.println(F("[ErrorLogger] Remote log URL is empty. Remote log not sent."));
             }
+            if (PhaseDeadline::expired()) {
+                Serial.println(F("[ErrorLogger] Phase deadline expired. Remote log not sent (kept on SD)."));
+            }
         #endif
     }
     
@@ -148,9 +207,13 @@ bool ErrorLogger::logToSdOnly(SDManager& sdManager,
                               TimeManager& timeManager,
                               LogLevel level,
                               const String& logMessage,
-                              float internalTemp) {
+                              float internalTemp,
+                              LogModule module) {
                                   
-    // --- Paso 1: Validación ---
+    // --- Paso 1: Validación y filtro de nivel ---
+    if (!isEnabled(LogSink::SD, module, level)) {
+        return false;
+    }
     if (logMessage.isEmpty()) {
         #ifdef ENABLE_DEBUG_SERIAL
             Serial.println(F("[ErrorLoggerSdOnly] Skipped logging: Missing message."));
@@ -158,9 +221,9 @@ bool ErrorLogger::logToSdOnly(SDManager& sdManager,
         return false;
     }
 
-    if (!sdManager.isSDAvailable()) { 
+    if (!sdManager.isLocalStorageAvailable()) { 
         #ifdef ENABLE_DEBUG_SERIAL
-            Serial.println(F("[ErrorLoggerSdOnly] SD card not available. Cannot write log."));
+            Serial.println(F("[ErrorLoggerSdOnly] No local storage (SD or hot tier) available. Cannot write log."));
         #endif
         return false;
     }
@@ -8,6 +8,7 @@
 // en este archivo .h, reduciendo dependencias y tiempos de compilación.
 class SDManager;
 class TimeManager;
+struct Config;
 enum class LogLevel;
 
 // Definición de tipos de log estándar
@@ -15,6 +16,48 @@ extern const char LOG_TYPE_INFO[];
 extern const char LOG_TYPE_WARNING[];
 extern const char LOG_TYPE_ERROR[];
 
+/**
+ * @brief Módulo de origen de un log (para el filtrado por módulo).
+ */
+enum class LogModule : uint8_t {
+    CORE,        ///< Ciclo principal / setup (solo filtrado por destino)
+    API,
+    SDMANAGER,
+    IMAGE,
+    ENVIRONMENT,
+    WIFI,
+    COUNT
+};
+
+/**
+ * @brief Destino de un log (para el filtrado por destino).
+ */
+enum class LogSink : uint8_t {
+    SD,
+    REMOTE,
+    COUNT
+};
+
+// --- Macros de log con filtrado previo ---
+// El nivel se comprueba ANTES de evaluar 'message', por lo que la concatenación
+// de Strings (y la URL del endpoint) no se construye si el log está filtrado.
+
+/// Log solo en SD. 'module' y 'level' son los nombres del enumerador (ej. IMAGE, ERROR).
+#define LOG_SD(sd, tm, module, level, message, temp) \
+    do { \
+        if (ErrorLogger::isEnabled(LogSink::SD, LogModule::module, LogLevel::level)) { \
+            ErrorLogger::logToSdOnly(sd, tm, LogLevel::level, message, temp, LogModule::module); \
+        } \
+    } while (0)
+
+/// Log en SD y API remota. 'logType' es LOG_TYPE_INFO/WARNING/ERROR (puede ser una variable).
+#define LOG_SEND(sd, tm, url, token, module, logType, message, temp) \
+    do { \
+        if (ErrorLogger::isAnySinkEnabled(LogModule::module, logType)) { \
+            ErrorLogger::sendLog(sd, tm, url, token, logType, message, temp, LogModule::module); \
+        } \
+    } while (0)
+
 /**
  * @class ErrorLogger
  * @brief Clase de utilidad (estática) para gestionar el registro de eventos
@@ -36,10 +79,12 @@ public:
      * @param logType Tipo de log (ej. LOG_TYPE_INFO, LOG_TYPE_ERROR).
      * @param logMessage El mensaje de log detallado (String).
      * @param internalTemp Opcional. Temperatura interna del dispositivo (float).
+     * @param module Opcional. Módulo de origen (para el filtrado por módulo).
      *
      * @return `true` si el log se guardó exitosamente en la tarjeta SD.
-     * `false` si falló el guardado en la SD.
+     * `false` si falló el guardado en la SD (o si el filtro de SD lo descartó).
      * @note El valor de retorno *no* indica si el envío remoto fue exitoso.
+     * @note Preferir la macro LOG_SEND, que evita construir el mensaje si está filtrado.
      */
     static bool sendLog(SDManager& sdManager,        
                        TimeManager& timeManager,      
@@ -47,7 +92,8 @@ public:
                        const String& accessToken, 
                        const char* logType, 
                        const String& logMessage, 
-                       float internalTemp = NAN);
+                       float internalTemp = NAN,
+                       LogModule module = LogModule::CORE);
 
     /**
      * @brief Envía un mensaje de log *exclusivamente* a la tarjeta SD local.
@@ -60,15 +106,50 @@ public:
      * @param level Nivel de severidad (enum LogLevel de SDManager.h).
      * @param logMessage El mensaje de log detallado (String).
      * @param internalTemp Opcional. Temperatura interna del dispositivo (float).
+     * @param module Opcional. Módulo de origen (para el filtrado por módulo).
      *
      * @return `true` si el log se guardó exitosamente en la SD.
-     * `false` si falló el guardado.
+     * `false` si falló el guardado (o si el filtro de SD lo descartó).
+     * @note Preferir la macro LOG_SD, que evita construir el mensaje si está filtrado.
      */
     static bool logToSdOnly(SDManager& sdManager,
                             TimeManager& timeManager,
                             LogLevel level,
                             const String& logMessage,
-                            float internalTemp = NAN);
+                            float internalTemp = NAN,
+                            LogModule module = LogModule::CORE);
+
+    /**
+     * @brief Carga los niveles mínimos de log (por destino y por módulo) desde la configuración.
+     * Llamar después de loadConfigurationFromFile(). Sin llamarla, todo se registra (INFO).
+     * @param cfg Configuración (claves log_level_*: "INFO", "WARNING", "ERROR" o "NONE").
+     */
+    static void configureFilters(const Config& cfg);
+
+    /**
+     * @brief Indica si un log de este nivel y módulo debe escribirse en el destino indicado.
+     * Es una comparación de enteros; no construye ningún String.
+     */
+    static inline bool isEnabled(LogSink sink, LogModule module, LogLevel level) {
+        uint8_t lvl = static_cast<uint8_t>(level);
+        return lvl >= _sinkMinLevel[static_cast<uint8_t>(sink)] &&
+               lvl >= _moduleMinLevel[static_cast<uint8_t>(module)];
+    }
+
+    /**
+     * @brief Indica si un log (por su tipo LOG_TYPE_*) pasa el filtro de algún destino.
+     */
+    static bool isAnySinkEnabled(LogModule module, const char* logType);
+
+private:
+    /// Nivel mínimo por destino / por módulo (valor de LogLevel; 3 = "NONE").
+    static uint8_t _sinkMinLevel[static_cast<uint8_t>(LogSink::COUNT)];
+    static uint8_t _moduleMinLevel[static_cast<uint8_t>(LogModule::COUNT)];
+
+    /**
+     * @brief (Helper) Convierte el tipo de log (LOG_TYPE_*) al enum LogLevel.
+     */
+    static LogLevel levelFromLogType(const char* logType);
 };
 
 #endif // ERRORLOGGER_H
\ No newline at end of file
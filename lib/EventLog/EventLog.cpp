@@ -0,0 +1,308 @@
+#include "EventLog.h"
+#include <math.h>         // Para isnan() y lroundf()
+#include "SDManager.h"    // Para la escritura en SD y el enum LogLevel
+#include "TimeManager.h"  // Para obtener la hora de cada evento
+#include "ErrorLogger.h"  // Para los filtros de nivel/módulo
+
+// Nivel de cada evento (mismo orden que EventId)
+static const LogLevel EVENT_LOG_LEVELS[] = {
+#define EVENT(id, level, module, fmt) LogLevel::level,
+#include "EventLogMessages.def"
+#undef EVENT
+};
+
+// Módulo de cada evento (mismo orden que EventId)
+static const LogModule EVENT_LOG_MODULES[] = {
+#define EVENT(id, level, module, fmt) LogModule::module,
+#include "EventLogMessages.def"
+#undef EVENT
+};
+
+static const char* levelToText(LogLevel level) {
+    switch (level) {
+        case LogLevel::INFO:    return "INFO";
+        case LogLevel::WARNING: return "WARNING";
+        case LogLevel::ERROR:   return "ERROR";
+        default:                return "UNKNOWN";
+    }
+}
+
+// --- EventFrameWriter ---
+
+void EventFrameWriter::putVarint(uint32_t value) {
+    // LEB128: 7 bits por byte, bit alto = "siguen más bytes"
+    do {
+        if (_len >= EVENT_LOG_MAX_PAYLOAD) {
+            _overflow = true;
+            return;
+        }
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        if (value) byte |= 0x80;
+        _buf[_len++] = byte;
+    } while (value);
+}
+
+void EventFrameWriter::putFloat(float value) {
+    if (_len + sizeof(float) > EVENT_LOG_MAX_PAYLOAD) {
+        _overflow = true;
+        return;
+    }
+    memcpy(&_buf[_len], &value, sizeof(float)); // ESP32 es little-endian
+    _len += sizeof(float);
+}
+
+void EventFrameWriter::putString(const char* str, size_t len) {
+    if (len > EVENT_LOG_MAX_STRING_LEN) len = EVENT_LOG_MAX_STRING_LEN;
+    putVarint(len);
+    if (_overflow || _len + len > EVENT_LOG_MAX_PAYLOAD) {
+        _overflow = true;
+        return;
+    }
+    memcpy(&_buf[_len], str, len);
+    _len += len;
+}
+
+// --- EventLog ---
+
+LogLevel EventLog::levelOf(EventId id) {
+    if ((size_t)id >= (size_t)EventId::COUNT) return LogLevel::ERROR;
+    return EVENT_LOG_LEVELS[(size_t)id];
+}
+
+bool EventLog::isEnabled(EventId id) {
+    if ((size_t)id >= (size_t)EventId::COUNT) return false;
+    return ErrorLogger::isEnabled(LogSink::SD, EVENT_LOG_MODULES[(size_t)id], EVENT_LOG_LEVELS[(size_t)id]);
+}
+
+uint8_t EventLog::crc8(const uint8_t* data, size_t len, uint8_t crc) {
+    for (size_t i = 0; i < len; ++i) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+bool EventLog::commit(SDManager& sdManager, TimeManager& timeManager, EventId id, float internalTemp, const EventFrameWriter& args) {
+    if (!sdManager.isLocalStorageAvailable()) {
+        #ifdef ENABLE_DEBUG_SERIAL
+            Serial.println(F("[EventLog] No local storage (SD or hot tier) available. Cannot write event."));
+        #endif
+        return false;
+    }
+    if (args.overflow()) {
+        #ifdef ENABLE_DEBUG_SERIAL
+            Serial.printf("[EventLog] Event %u dropped: arguments exceed %d bytes.\n", (unsigned)id, EVENT_LOG_MAX_PAYLOAD);
+        #endif
+        return false;
+    }
+
+    // --- Hora: segundos del día (la fecha va en el nombre del archivo) o uptime sin NTP ---
+    String fileDate = "";
+    uint32_t seconds = millis() / 1000;
+    bool isUptime = true;
+    if (timeManager.isTimeSynced()) {
+        String ts = timeManager.getCurrentTimestampString(true); // YYYYMMDD_HHMMSS
+        int hh, mm, ss;
+        if (ts.length() >= 15 && sscanf(ts.c_str() + 9, "%2d%2d%2d", &hh, &mm, &ss) == 3) {
+            fileDate = ts.substring(0, 8);
+            seconds = (uint32_t)(hh * 3600 + mm * 60 + ss);
+            isUptime = false;
+        }
+    }
+
+    bool hasTemp = !isnan(internalTemp);
+    EventFrameWriter header;
+    header.putVarint(seconds);
+    header.putVarint(((uint32_t)id << 2) | (hasTemp ? 0x02 : 0x00) | (isUptime ? 0x01 : 0x00));
+    if (hasTemp) header.putSigned((int32_t)lroundf(internalTemp * 10.0f));
+
+    size_t payloadLen = header.length() + args.length();
+    if (header.overflow() || payloadLen > EVENT_LOG_MAX_PAYLOAD) return false;
+
+    // --- Trama: SYNC + LEN + PAYLOAD + CRC8 ---
+    uint8_t frame[EVENT_LOG_MAX_PAYLOAD + 3];
+    frame[0] = EVENT_LOG_SYNC_BYTE;
+    frame[1] = (uint8_t)payloadLen;
+    memcpy(&frame[2], header.data(), header.length());
+    memcpy(&frame[2 + header.length()], args.data(), args.length());
+    frame[2 + payloadLen] = crc8(&frame[1], payloadLen + 1);
+
+    bool written = sdManager.appendBinaryLog(fileDate, frame, payloadLen + 3);
+
+    #ifdef ENABLE_DEBUG_SERIAL
+        char line[192];
+        if (formatPayload(&frame[2], payloadLen, fileDate.c_str(), line, sizeof(line)) > 0) {
+            Serial.printf("[EventLog] %s (%u bytes)%s\n", line, (unsigned)(payloadLen + 3), written ? "" : " - SD write FAILED");
+        }
+    #endif
+    return written;
+}
+
+// (Lee un varint LEB128 del payload. Devuelve false si se sale del buffer)
+static bool readVarint(const uint8_t* data, size_t len, size_t& pos, uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (pos >= len) return false;
+        uint8_t byte = data[pos++];
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false; // Varint demasiado largo
+}
+
+size_t EventLog::formatPayload(const uint8_t* payload, size_t len, const char* fileDate, char* out, size_t outSize) {
+    if (outSize == 0) return 0;
+    size_t pos = 0;
+    uint32_t seconds, header;
+    if (!readVarint(payload, len, pos, seconds) || !readVarint(payload, len, pos, header)) return 0;
+
+    uint32_t idValue = header >> 2;
+    if (idValue >= (uint32_t)EventId::COUNT) return 0; // ID desconocido (firmware más nuevo)
+    bool hasTemp = header & 0x02;
+    bool isUptime = header & 0x01;
+
+    int32_t tempTenths = 0;
+    if (hasTemp) {
+        uint32_t zz;
+        if (!readVarint(payload, len, pos, zz)) return 0;
+        tempTenths = (int32_t)(zz >> 1) ^ -(int32_t)(zz & 1);
+    }
+
+    size_t n = 0;
+    // (Añade texto al buffer de salida sin desbordar)
+    auto append = [&](const char* text, size_t textLen) {
+        for (size_t i = 0; i < textLen && n + 1 < outSize; ++i) out[n++] = text[i];
+    };
+    char tmp[64];
+
+    // --- Timestamp + nivel (mismo formato que el log de texto) ---
+    int tmpLen;
+    if (!isUptime && fileDate && strlen(fileDate) == 8) {
+        tmpLen = snprintf(tmp, sizeof(tmp), "%.4s-%.2s-%.2sT%02lu:%02lu:%02lu", fileDate, fileDate + 4, fileDate + 6,
+                          (unsigned long)(seconds / 3600), (unsigned long)((seconds / 60) % 60), (unsigned long)(seconds % 60));
+    } else {
+        tmpLen = snprintf(tmp, sizeof(tmp), "UPTIME_%02luh%02lum%02lus",
+                          (unsigned long)((seconds / 3600) % 24), (unsigned long)((seconds / 60) % 60), (unsigned long)(seconds % 60));
+    }
+    append(tmp, tmpLen);
+    tmpLen = snprintf(tmp, sizeof(tmp), " [%s] ", levelToText(EVENT_LOG_LEVELS[idValue]));
+    append(tmp, tmpLen);
+
+    // --- Mensaje: recorre el formato consumiendo un argumento por especificador ---
+    const char* f = EVENT_LOG_FORMATS[idValue];
+    while (*f) {
+        if (*f != '%') {
+            append(f++, 1);
+            continue;
+        }
+        if (f[1] == '%') {
+            append("%", 1);
+            f += 2;
+            continue;
+        }
+        // Copia el especificador completo (ej. "%.1f") para reutilizarlo en snprintf
+        char spec[12];
+        size_t specLen = 0;
+        spec[specLen++] = *f++;
+        while (*f && ((*f >= '0' && *f <= '9') || *f == '.' || *f == '-') && specLen < sizeof(spec) - 2) {
+            spec[specLen++] = *f++;
+        }
+        char conv = *f ? *f++ : '\0';
+        spec[specLen++] = conv;
+        spec[specLen] = '\0';
+
+        uint32_t raw;
+        switch (conv) {
+            case 'd':
+                if (!readVarint(payload, len, pos, raw)) return 0;
+                tmpLen = snprintf(tmp, sizeof(tmp), spec, (int)((int32_t)(raw >> 1) ^ -(int32_t)(raw & 1)));
+                append(tmp, tmpLen);
+                break;
+            case 'u':
+                if (!readVarint(payload, len, pos, raw)) return 0;
+                spec[specLen - 1] = 'u';
+                tmpLen = snprintf(tmp, sizeof(tmp), spec, (unsigned)raw);
+                append(tmp, tmpLen);
+                break;
+            case 'f': {
+                float value;
+                if (pos + sizeof(float) > len) return 0;
+                memcpy(&value, &payload[pos], sizeof(float));
+                pos += sizeof(float);
+                tmpLen = snprintf(tmp, sizeof(tmp), spec, value);
+                append(tmp, tmpLen);
+                break;
+            }
+            case 's':
+                if (!readVarint(payload, len, pos, raw) || pos + raw > len) return 0;
+                append((const char*)&payload[pos], raw);
+                pos += raw;
+                break;
+            default:
+                return 0; // Especificador no soportado en la tabla
+        }
+    }
+
+    if (hasTemp) {
+        tmpLen = snprintf(tmp, sizeof(tmp), " (DevTemp: %.1fC )", tempTenths / 10.0f);
+        append(tmp, tmpLen);
+    }
+
+    if (pos != len) return 0; // Bytes sobrantes: la trama no corresponde al formato
+    out[n] = '\0';
+    return n;
+}
+
+// --- EventLogReader ---
+
+EventLogReader::EventLogReader(File file, const String& fileName) : _file(file) {
+    _fileDate[0] = '\0';
+    // Solo los archivos "YYYYMMDD_log.bin" tienen fecha; "UPTIME_log.bin" no
+    if (fileName.length() >= 8 && isdigit((unsigned char)fileName[0])) {
+        memcpy(_fileDate, fileName.c_str(), 8);
+        _fileDate[8] = '\0';
+    }
+}
+
+EventLogReader::~EventLogReader() {
+    if (_file) _file.close();
+}
+
+bool EventLogReader::nextLine(String& line) {
+    uint8_t payload[EVENT_LOG_MAX_PAYLOAD];
+    char text[256];
+
+    while (_file && _file.available()) {
+        // Busca el byte de sincronización (salta la cabecera "EVL1" y basura)
+        if (_file.read() != EVENT_LOG_SYNC_BYTE) continue;
+        size_t resyncPos = _file.position();
+
+        // Toda trama inválida (longitud, corte o CRC) re-sincroniza desde el byte siguiente al de
+        // sincronización: ese byte puede ser el inicio de la trama siguiente
+        int len = _file.read();
+        if (len <= 0 || len > EVENT_LOG_MAX_PAYLOAD) {
+            _file.seek(resyncPos);
+            continue;
+        }
+        int crc = -1;
+        if (_file.read(payload, len) == (size_t)len) crc = _file.read();
+        if (crc < 0) {
+            _file.seek(resyncPos); // Trama cortada (o sync falso cerca del final)
+            continue;
+        }
+
+        uint8_t lenByte = (uint8_t)len;
+        uint8_t expected = EventLog::crc8(payload, len, EventLog::crc8(&lenByte, 1));
+        size_t textLen = (expected == (uint8_t)crc) ? EventLog::formatPayload(payload, len, _fileDate, text, sizeof(text)) : 0;
+        if (textLen == 0) {
+            _file.seek(resyncPos);
+            continue;
+        }
+        line = String(text);
+        return true;
+    }
+    return false;
+}
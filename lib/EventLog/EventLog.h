@@ -0,0 +1,236 @@
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <Arduino.h>
+#include "FS.h"
+#include <type_traits> // Para std::decay en la verificación de argumentos
+
+// Declaraciones anticipadas (evitan incluir SDManager.h / TimeManager.h aquí)
+class SDManager;
+class TimeManager;
+enum class LogLevel;
+
+// --- Formato de trama (binario, little-endian) ---
+// [SYNC 0xA5][LEN][PAYLOAD (LEN bytes)][CRC8 sobre LEN+PAYLOAD]
+// PAYLOAD: varint(segundos del día | segundos de uptime)
+//          varint(ID << 2 | tieneTemp << 1 | esUptime)
+//          [zigzag varint(temp * 10)]  (solo si tieneTemp)
+//          argumentos según el formato: %d zigzag varint, %u varint,
+//          %f float32, %s varint(longitud) + bytes.
+#define EVENT_LOG_MAGIC "EVL1"          // Cabecera de 4 bytes al crear cada archivo .bin
+#define EVENT_LOG_SYNC_BYTE 0xA5
+#define EVENT_LOG_MAX_PAYLOAD 128       // Bytes máximos de payload por evento
+#define EVENT_LOG_MAX_STRING_LEN 48     // Los argumentos %s se truncan a esta longitud
+
+/**
+ * @brief IDs de evento, generados en compilación desde EventLogMessages.def.
+ */
+enum class EventId : uint16_t {
+#define EVENT(id, level, module, fmt) id,
+#include "EventLogMessages.def"
+#undef EVENT
+    COUNT
+};
+
+// Tabla de formatos (constexpr para poder verificar los argumentos en compilación)
+constexpr const char* const EVENT_LOG_FORMATS[] = {
+#define EVENT(id, level, module, fmt) fmt,
+#include "EventLogMessages.def"
+#undef EVENT
+};
+
+namespace eventlog_detail {
+
+// (Salta flags/ancho/precisión y devuelve el carácter de conversión: 'd', 'u', 'f', 's')
+constexpr char conversionChar(const char* f) {
+    return ((*f >= '0' && *f <= '9') || *f == '.' || *f == '-') ? conversionChar(f + 1) : *f;
+}
+
+// (Carácter de conversión del n-ésimo especificador del formato, '\0' si no existe)
+constexpr char specAt(const char* f, unsigned n) {
+    return *f == '\0' ? '\0'
+         : *f != '%' ? specAt(f + 1, n)
+         : f[1] == '%' ? specAt(f + 2, n)
+         : n == 0 ? conversionChar(f + 1)
+         : specAt(f + 1, n - 1);
+}
+
+// (Número de especificadores del formato)
+constexpr unsigned countSpecs(const char* f) {
+    return *f == '\0' ? 0
+         : *f != '%' ? countSpecs(f + 1)
+         : f[1] == '%' ? countSpecs(f + 2)
+         : 1 + countSpecs(f + 1);
+}
+
+// Tipo C++ -> carácter de conversión. Un tipo no listado no compila.
+template<typename T> struct ArgKind;
+template<> struct ArgKind<int>            { static constexpr char value = 'd'; };
+template<> struct ArgKind<long>           { static constexpr char value = 'd'; };
+template<> struct ArgKind<short>          { static constexpr char value = 'd'; };
+template<> struct ArgKind<signed char>    { static constexpr char value = 'd'; };
+template<> struct ArgKind<unsigned int>   { static constexpr char value = 'u'; };
+template<> struct ArgKind<unsigned long>  { static constexpr char value = 'u'; };
+template<> struct ArgKind<unsigned short> { static constexpr char value = 'u'; };
+template<> struct ArgKind<unsigned char>  { static constexpr char value = 'u'; };
+template<> struct ArgKind<bool>           { static constexpr char value = 'u'; };
+template<> struct ArgKind<float>          { static constexpr char value = 'f'; };
+template<> struct ArgKind<double>         { static constexpr char value = 'f'; };
+template<> struct ArgKind<const char*>    { static constexpr char value = 's'; };
+template<> struct ArgKind<char*>          { static constexpr char value = 's'; };
+template<> struct ArgKind<String>         { static constexpr char value = 's'; };
+
+// (Verifica que cada argumento coincida con su especificador)
+template<unsigned N, typename... Ts> struct ArgsMatch;
+template<unsigned N> struct ArgsMatch<N> {
+    static constexpr bool check(const char*) { return true; }
+};
+template<unsigned N, typename T, typename... Rest> struct ArgsMatch<N, T, Rest...> {
+    static constexpr bool check(const char* f) {
+        return ArgKind<typename std::decay<T>::type>::value == specAt(f, N) && ArgsMatch<N + 1, Rest...>::check(f);
+    }
+};
+
+} // namespace eventlog_detail
+
+/**
+ * @class EventFrameWriter
+ * @brief Construye el payload de un evento en un buffer fijo (sin memoria dinámica).
+ */
+class EventFrameWriter {
+public:
+    EventFrameWriter() : _len(0), _overflow(false) {}
+
+    void putVarint(uint32_t value);
+    void putSigned(int32_t value) { putVarint(((uint32_t)value << 1) ^ (uint32_t)(value >> 31)); }
+    void putFloat(float value);
+    void putString(const char* str, size_t len);
+
+    // --- Serialización de argumentos (un overload por tipo admitido en ArgKind) ---
+    void putArg(int v)            { putSigned(v); }
+    void putArg(long v)           { putSigned((int32_t)v); }
+    void putArg(short v)          { putSigned(v); }
+    void putArg(signed char v)    { putSigned(v); }
+    void putArg(unsigned int v)   { putVarint(v); }
+    void putArg(unsigned long v)  { putVarint((uint32_t)v); }
+    void putArg(unsigned short v) { putVarint(v); }
+    void putArg(unsigned char v)  { putVarint(v); }
+    void putArg(bool v)           { putVarint(v ? 1 : 0); }
+    void putArg(float v)          { putFloat(v); }
+    void putArg(double v)         { putFloat((float)v); }
+    void putArg(const char* v)    { putString(v, v ? strlen(v) : 0); }
+    void putArg(const String& v)  { putString(v.c_str(), v.length()); }
+
+    void putArgs() {}
+    template<typename T, typename... Rest>
+    void putArgs(const T& first, const Rest&... rest) {
+        putArg(first);
+        putArgs(rest...);
+    }
+
+    const uint8_t* data() const { return _buf; }
+    size_t length() const { return _len; }
+    bool overflow() const { return _overflow; }
+
+private:
+    uint8_t _buf[EVENT_LOG_MAX_PAYLOAD];
+    size_t _len;
+    bool _overflow;
+};
+
+/**
+ * @class EventLog
+ * @brief Clase de utilidad (estática) para el log binario estructurado en la SD.
+ *
+ * Sustituye las líneas de texto repetitivas de `logToSdOnly` por eventos de
+ * ~10-20 bytes (ID + argumentos tipados). Los archivos se nombran
+ * /logs/YYYYMMDD_log.bin y se decodifican a texto en el portal web
+ * (EventLogReader) o en el PC (tools/decode_eventlog.py).
+ */
+class EventLog {
+public:
+    /**
+     * @brief Registra un evento en el log binario de la SD.
+     * El número y tipo de argumentos se verifica en compilación contra el formato.
+     * @tparam Id ID del evento (EventId::...).
+     * @param sdManager Referencia a la instancia de SDManager.
+     * @param timeManager Referencia a la instancia de TimeManager.
+     * @param internalTemp Temperatura interna del dispositivo (NAN si no aplica).
+     * @param args Argumentos del formato.
+     * @return True si el evento se escribió en la SD.
+     */
+    template<EventId Id, typename... Args>
+    static bool log(SDManager& sdManager, TimeManager& timeManager, float internalTemp, const Args&... args) {
+        static_assert(eventlog_detail::countSpecs(EVENT_LOG_FORMATS[(size_t)Id]) == sizeof...(Args),
+                      "EventLog: number of arguments does not match the event format");
+        static_assert(eventlog_detail::ArgsMatch<0, Args...>::check(EVENT_LOG_FORMATS[(size_t)Id]),
+                      "EventLog: argument types do not match the event format");
+        if (!isEnabled(Id)) return false; // Filtrado por nivel/módulo antes de serializar
+        EventFrameWriter argWriter;
+        argWriter.putArgs(args...);
+        return commit(sdManager, timeManager, Id, internalTemp, argWriter);
+    }
+
+    /**
+     * @brief Obtiene el nivel de severidad asociado a un evento.
+     */
+    static LogLevel levelOf(EventId id);
+
+    /**
+     * @brief Indica si el evento pasa los filtros de log de la SD (ErrorLogger::isEnabled).
+     */
+    static bool isEnabled(EventId id);
+
+    /**
+     * @brief Convierte el payload de una trama a una línea de texto.
+     * Formato equivalente al log de texto: "YYYY-MM-DDTHH:MM:SS [LEVEL] mensaje (DevTemp: x C )".
+     * @param payload Payload de la trama (sin SYNC, LEN ni CRC).
+     * @param len Longitud del payload.
+     * @param fileDate Fecha del archivo ("YYYYMMDD"), o "" para eventos sin hora NTP.
+     * @param out Buffer de salida.
+     * @param outSize Tamaño del buffer de salida.
+     * @return Longitud del texto escrito, o 0 si el payload no es válido.
+     */
+    static size_t formatPayload(const uint8_t* payload, size_t len, const char* fileDate, char* out, size_t outSize);
+
+    /**
+     * @brief CRC-8 (polinomio 0x07) usado en las tramas.
+     */
+    static uint8_t crc8(const uint8_t* data, size_t len, uint8_t crc = 0);
+
+private:
+    /**
+     * @brief (Helper) Añade la cabecera (hora, ID, temperatura) y escribe la trama en la SD.
+     */
+    static bool commit(SDManager& sdManager, TimeManager& timeManager, EventId id, float internalTemp, const EventFrameWriter& args);
+};
+
+/**
+ * @class EventLogReader
+ * @brief Lee un archivo .bin trama a trama y lo devuelve como texto.
+ * Tolera tramas corruptas o cortadas (re-sincroniza con el byte SYNC).
+ */
+class EventLogReader {
+public:
+    /**
+     * @param file Archivo abierto para lectura. El lector lo cierra en su destructor.
+     * @param fileName Nombre del archivo (ej. "20251031_log.bin"), para obtener la fecha.
+     */
+    EventLogReader(File file, const String& fileName);
+    ~EventLogReader();
+    EventLogReader(const EventLogReader&) = delete;            // Dueño único del File
+    EventLogReader& operator=(const EventLogReader&) = delete;
+
+    /**
+     * @brief Decodifica la siguiente trama válida.
+     * @param[out] line Línea de texto (sin salto de línea).
+     * @return False al llegar al final del archivo.
+     */
+    bool nextLine(String& line);
+
+private:
+    File _file;
+    char _fileDate[9]; ///< "YYYYMMDD" o "" si el archivo no tiene fecha (UPTIME)
+};
+
+#endif // EVENT_LOG_H
@@ -0,0 +1,160 @@
+#include "FaultInjection.h"
+#include <string.h>
+#include <stdlib.h>
+
+#ifdef ARDUINO
+    #include <Arduino.h> // delay()
+#else
+    #include <chrono>
+    #include <thread>
+#endif
+
+static const char* const FAULT_POINT_NAMES[] = {
+#define FAULT_POINT_NAME(name) #name,
+    FAULT_POINT_LIST(FAULT_POINT_NAME)
+#undef FAULT_POINT_NAME
+};
+
+#define POINT_COUNT ((size_t)FaultPoint::COUNT)
+
+FaultInjection::PointState FaultInjection::_points[POINT_COUNT];
+uint32_t FaultInjection::_seed = 0x5EED1234u;
+
+void FaultInjection::_resetState(size_t index) {
+    PointState& p = _points[index];
+    p.calls = 0;
+    p.failures = 0;
+    // Semilla distinta por punto (xorshift32 no admite estado 0)
+    p.rng = (_seed ^ (0x9E3779B9u * (uint32_t)(index + 1))) | 1u;
+}
+
+void FaultInjection::seed(uint32_t seed) {
+    _seed = seed;
+    for (size_t i = 0; i < POINT_COUNT; i++) _resetState(i);
+}
+
+void FaultInjection::configure(FaultPoint point, const FaultSchedule& schedule) {
+    size_t i = (size_t)point;
+    if (i >= POINT_COUNT) return;
+    _points[i].schedule = schedule;
+    _points[i].active = schedule.failNth > 0 || schedule.probability > 0.0f || schedule.latencyMs > 0;
+    _resetState(i);
+}
+
+void FaultInjection::clearAll() {
+    for (size_t i = 0; i < POINT_COUNT; i++) {
+        _points[i].schedule = FaultSchedule();
+        _points[i].active = false;
+        _resetState(i);
+    }
+}
+
+uint32_t FaultInjection::_nextRandom(PointState& state) {
+    uint32_t x = state.rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    state.rng = x;
+    return x;
+}
+
+void FaultInjection::_sleepMs(uint32_t ms) {
+#ifdef ARDUINO
+    delay(ms);
+#else
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+#endif
+}
+
+bool FaultInjection::shouldFail(FaultPoint point) {
+    size_t i = (size_t)point;
+    if (i >= POINT_COUNT || !_points[i].active) return false;
+
+    PointState& p = _points[i];
+    const FaultSchedule& s = p.schedule;
+    p.calls++;
+
+    if (s.latencyMs > 0) _sleepMs(s.latencyMs);
+
+    bool fail = s.failNth > 0 && p.calls >= s.failNth && p.calls < s.failNth + s.failCount;
+    if (s.probability > 0.0f) {
+        // El PRNG avanza en cada llamada para que la secuencia dependa solo del número de llamada
+        bool randomFail = (float)(_nextRandom(p) >> 8) / 16777216.0f < s.probability;
+        fail = fail || randomFail;
+    }
+
+    if (fail) p.failures++;
+    return fail;
+}
+
+uint32_t FaultInjection::callCount(FaultPoint point) {
+    size_t i = (size_t)point;
+    return i < POINT_COUNT ? _points[i].calls : 0;
+}
+
+uint32_t FaultInjection::failureCount(FaultPoint point) {
+    size_t i = (size_t)point;
+    return i < POINT_COUNT ? _points[i].failures : 0;
+}
+
+const char* FaultInjection::nameOf(FaultPoint point) {
+    size_t i = (size_t)point;
+    return i < POINT_COUNT ? FAULT_POINT_NAMES[i] : "UNKNOWN";
+}
+
+int FaultInjection::configureFromString(const char* spec) {
+    if (spec == nullptr) return -1;
+
+    // Se valida todo antes de aplicar nada
+    FaultSchedule parsed[POINT_COUNT];
+    bool present[POINT_COUNT] = {false};
+
+    const char* cursor = spec;
+    while (*cursor) {
+        // --- Entrada "PUNTO:clave=valor,..." hasta ';' o fin ---
+        const char* entryEnd = strchr(cursor, ';');
+        size_t entryLen = entryEnd ? (size_t)(entryEnd - cursor) : strlen(cursor);
+        char entry[96];
+        if (entryLen >= sizeof(entry)) return -1;
+        memcpy(entry, cursor, entryLen);
+        entry[entryLen] = '\0';
+        cursor += entryLen + (entryEnd ? 1 : 0);
+        if (entryLen == 0) continue;
+
+        char* colon = strchr(entry, ':');
+        if (!colon) return -1;
+        *colon = '\0';
+
+        size_t index = POINT_COUNT;
+        for (size_t i = 0; i < POINT_COUNT; i++) {
+            if (strcmp(entry, FAULT_POINT_NAMES[i]) == 0) { index = i; break; }
+        }
+        if (index == POINT_COUNT) return -1;
+
+        FaultSchedule schedule;
+        char* savePtr = nullptr;
+        for (char* kv = strtok_r(colon + 1, ",", &savePtr); kv; kv = strtok_r(nullptr, ",", &savePtr)) {
+            char* eq = strchr(kv, '=');
+            if (!eq) return -1;
+            *eq = '\0';
+            const char* value = eq + 1;
+            char* end = nullptr;
+            if (strcmp(kv, "nth") == 0)          schedule.failNth = strtoul(value, &end, 10);
+            else if (strcmp(kv, "count") == 0)   schedule.failCount = strtoul(value, &end, 10);
+            else if (strcmp(kv, "latency") == 0) schedule.latencyMs = strtoul(value, &end, 10);
+            else if (strcmp(kv, "p") == 0)       schedule.probability = strtof(value, &end);
+            else return -1;
+            if (end == value || *end != '\0') return -1;
+        }
+        parsed[index] = schedule;
+        present[index] = true;
+    }
+
+    int configured = 0;
+    for (size_t i = 0; i < POINT_COUNT; i++) {
+        if (!present[i]) continue;
+        configure((FaultPoint)i, parsed[i]);
+        configured++;
+    }
+    return configured;
+}
@@ -0,0 +1,108 @@
+#ifndef FAULT_INJECTION_H
+#define FAULT_INJECTION_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Sin dependencias de Arduino: la misma librería se puede compilar en un build
+// de host (con std::this_thread para la latencia) o en el dispositivo.
+
+/**
+ * @brief Puntos de inyección (uno por cada shim instrumentado).
+ * Los nombres (para configureFromString) se generan con la misma lista.
+ */
+#define FAULT_POINT_LIST(X) \
+    X(SD_OPEN)            /* Apertura de archivo para escritura/append */ \
+    X(SD_WRITE_PARTIAL)   /* writeTextFile/writeBinaryFile escriben solo la mitad */ \
+    X(SD_RENAME)          /* moveFile (rename) falla */ \
+    X(HTTP_REQUEST)       /* POST/GET devuelve HTTPC_ERROR_CONNECTION_LOST */ \
+    X(WIFI_DROP)          /* WiFi.disconnect() justo antes de un envío de datos */ \
+    X(I2C_MLX_FRAME)      /* mlx.getFrame() falla (NACK) */ \
+    X(I2C_BME_READ)       /* Lectura del BME280 devuelve NAN */
+
+enum class FaultPoint : uint8_t {
+#define FAULT_POINT_ENUM(name) name,
+    FAULT_POINT_LIST(FAULT_POINT_ENUM)
+#undef FAULT_POINT_ENUM
+    COUNT
+};
+
+/**
+ * @brief Programa de fallos de un punto. Los criterios se combinan (OR).
+ */
+struct FaultSchedule {
+    uint32_t failNth = 0;       ///< Falla la llamada N (1 = la primera). 0 = desactivado.
+    uint32_t failCount = 1;     ///< Llamadas consecutivas que fallan a partir de failNth.
+    float probability = 0.0f;   ///< Probabilidad de fallo por llamada (0..1), PRNG con semilla.
+    uint32_t latencyMs = 0;     ///< Retardo añadido a cada llamada (falle o no).
+};
+
+/**
+ * @class FaultInjection
+ * @brief Clase de utilidad (estática) con programas de fallo deterministas.
+ *
+ * Cada punto tiene su propio contador de llamadas y su propio PRNG (xorshift32
+ * derivado de la semilla global), así que la secuencia de fallos de un punto no
+ * depende de cuántas veces se consulten los demás.
+ * En el firmware se usa a través de la macro FAULT_INJECT(punto), que vale
+ * `false` (sin coste) si no se compila con -D ENABLE_FAULT_INJECTION.
+ */
+class FaultInjection {
+public:
+    /**
+     * @brief Fija la semilla y reinicia contadores y PRNGs (mantiene los programas).
+     */
+    static void seed(uint32_t seed);
+
+    /**
+     * @brief Asigna el programa de un punto y reinicia su contador.
+     */
+    static void configure(FaultPoint point, const FaultSchedule& schedule);
+
+    /**
+     * @brief Configura varios puntos desde texto (ej. el campo `fault_injection` de config.json).
+     * Formato: "PUNTO:clave=valor,clave=valor;PUNTO:..." con claves nth, count, p, latency.
+     * Ej: "SD_RENAME:nth=2;HTTP_REQUEST:p=0.25,latency=1500".
+     * @return Número de puntos configurados, o -1 si el texto no es válido (no se aplica nada).
+     */
+    static int configureFromString(const char* spec);
+
+    /**
+     * @brief Desactiva todos los programas y reinicia los contadores.
+     */
+    static void clearAll();
+
+    /**
+     * @brief Registra una llamada al punto, aplica la latencia y decide si debe fallar.
+     * @return True si el shim debe simular el fallo.
+     */
+    static bool shouldFail(FaultPoint point);
+
+    static uint32_t callCount(FaultPoint point);
+    static uint32_t failureCount(FaultPoint point);
+    static const char* nameOf(FaultPoint point);
+
+private:
+    struct PointState {
+        FaultSchedule schedule;
+        bool active;
+        uint32_t calls;
+        uint32_t failures;
+        uint32_t rng;
+    };
+
+    static PointState _points[(size_t)FaultPoint::COUNT];
+    static uint32_t _seed;
+
+    static uint32_t _nextRandom(PointState& state);
+    static void _resetState(size_t index);
+    static void _sleepMs(uint32_t ms);
+};
+
+#ifdef ENABLE_FAULT_INJECTION
+    #define FAULT_INJECT(point) FaultInjection::shouldFail(FaultPoint::point)
+#else
+    #define FAULT_INJECT(point) false
+#endif
+
+#endif // FAULT_INJECTION_H
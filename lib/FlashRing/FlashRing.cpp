@@ -0,0 +1,435 @@
+#include "FlashRing.h"
+
+#define FLASH_RING_CURSOR_FILE "/ring.cur"
+#define FLASH_RING_CURSOR_TMP "/ring.tmp"
+
+FlashRing::FlashRing()
+    : _available(false), _headSeq(1), _headSize(0), _tailSeq(1), _tailOffset(0),
+      _pendingRecords(0), _pendingBytes(0), _droppedRecords(0), _droppedBytes(0) {
+    // Constructor
+}
+
+bool FlashRing::begin(const char* partitionLabel, const char* basePath) {
+    if (_available) return true;
+
+    // formatOnFail = true: la partición es solo para este anillo, un FS dañado se recrea vacío
+    if (!_fs.begin(true, basePath, 4, partitionLabel)) {
+        #ifdef ENABLE_DEBUG_SERIAL
+            Serial.printf("[FlashRing] Partition '%s' not found or mount failed. Hot tier disabled.\n", partitionLabel);
+        #endif
+        return false;
+    }
+    _available = true;
+
+    // --- Localizar el segmento más antiguo y el más reciente ---
+    uint32_t minSeq = 0, maxSeq = 0;
+    File root = _fs.open("/");
+    if (root && root.isDirectory()) {
+        File entry = root.openNextFile();
+        while (entry) {
+            String name = entry.name();
+            name = name.substring(name.lastIndexOf('/') + 1); // (Según la versión del core, name() incluye la ruta)
+            if (name.startsWith("seg_") && name.endsWith(".bin")) {
+                uint32_t seq = strtoul(name.c_str() + 4, nullptr, 10);
+                if (seq > 0) {
+                    if (minSeq == 0 || seq < minSeq) minSeq = seq;
+                    if (seq > maxSeq) maxSeq = seq;
+                }
+            }
+            entry.close();
+            entry = root.openNextFile();
+        }
+    }
+    if (root) root.close();
+
+    // --- Recuperar el cursor de migración ---
+    uint32_t cursorSeq = 0, cursorOffset = 0;
+    bool hasCursor = _loadCursor(cursorSeq, cursorOffset);
+
+    if (maxSeq == 0) {
+        // Sin segmentos: se continúa la numeración del cursor (o se empieza en 1)
+        _headSeq = _tailSeq = (hasCursor && cursorSeq > 0) ? cursorSeq : 1;
+        _tailOffset = 0;
+    } else if (!hasCursor || cursorSeq < minSeq) {
+        // El segmento del cursor ya se descartó: se empieza por el más antiguo que queda
+        _headSeq = maxSeq;
+        _tailSeq = minSeq;
+        _tailOffset = 0;
+    } else {
+        _headSeq = maxSeq > cursorSeq ? maxSeq : cursorSeq;
+        _tailSeq = cursorSeq;
+        _tailOffset = cursorOffset;
+        // Segmentos ya migrados cuyo borrado no llegó a hacerse (reinicio a mitad de migrate)
+        for (uint32_t seq = minSeq; seq < _tailSeq; seq++) {
+            _fs.remove(_segmentPath(seq).c_str());
+        }
+    }
+
+    _recount();
+
+    File head = _fs.open(_segmentPath(_headSeq).c_str(), FILE_READ);
+    _headSize = head ? (uint32_t)head.size() : 0;
+    if (head) head.close();
+
+    #ifdef ENABLE_DEBUG_SERIAL
+        Serial.printf("[FlashRing] Mounted at %s. Segments %lu..%lu, %lu records (%lu bytes) pending migration.\n",
+                      basePath, (unsigned long)_tailSeq, (unsigned long)_headSeq,
+                      (unsigned long)_pendingRecords, (unsigned long)_pendingBytes);
+    #endif
+    return true;
+}
+
+void FlashRing::end() {
+    if (!_available) return;
+    _fs.end();
+    _available = false;
+}
+
+bool FlashRing::isAvailable() const {
+    return _available;
+}
+
+uint32_t FlashRing::pendingRecords() const { return _pendingRecords; }
+uint32_t FlashRing::pendingBytes() const { return _pendingBytes; }
+uint32_t FlashRing::droppedRecords() const { return _droppedRecords; }
+uint32_t FlashRing::droppedBytes() const { return _droppedBytes; }
+
+bool FlashRing::append(HotRecordType type, const String& target, const uint8_t* data, size_t length) {
+    if (!_available) return false;
+    if (length > FLASH_RING_MAX_DATA || target.isEmpty() || target.length() > 255) return false;
+
+    const size_t targetLen = target.length();
+    const size_t recordLen = FLASH_RING_HEADER_LEN + targetLen + length;
+
+    // Segmento lleno: se abre el siguiente y, si el anillo está completo, se descarta el más antiguo
+    if (_headSize > 0 && _headSize + recordLen > FLASH_RING_SEGMENT_BYTES) {
+        _headSeq++;
+        _headSize = 0;
+        while (_headSeq - _tailSeq + 1 > FLASH_RING_MAX_SEGMENTS) {
+            _dropOldestSegment();
+        }
+    }
+
+    uint8_t header[FLASH_RING_HEADER_LEN];
+    const uint16_t payloadLen = (uint16_t)(targetLen + length);
+    header[0] = FLASH_RING_SYNC_BYTE;
+    header[1] = (uint8_t)type;
+    header[2] = (uint8_t)(payloadLen & 0xFF);
+    header[3] = (uint8_t)(payloadLen >> 8);
+    header[4] = (uint8_t)targetLen;
+    uint16_t crc = _crc16(0xFFFF, header + 1, 4);
+    crc = _crc16(crc, (const uint8_t*)target.c_str(), targetLen);
+    crc = _crc16(crc, data, length);
+    header[5] = (uint8_t)(crc & 0xFF);
+    header[6] = (uint8_t)(crc >> 8);
+
+    File segment = _fs.open(_segmentPath(_headSeq).c_str(), FILE_APPEND);
+    if (!segment) {
+        #ifdef ENABLE_DEBUG_SERIAL
+            Serial.println("[FlashRing] Failed to open segment for appending: " + _segmentPath(_headSeq));
+        #endif
+        return false;
+    }
+    size_t written = segment.write(header, FLASH_RING_HEADER_LEN);
+    written += segment.write((const uint8_t*)target.c_str(), targetLen);
+    if (length > 0) written += segment.write(data, length);
+    segment.close();
+
+    if (written != recordLen) {
+        // Registro incompleto (partición llena): el siguiente va a un segmento nuevo y este
+        // se descarta al migrar por su CRC
+        _headSize = FLASH_RING_SEGMENT_BYTES;
+        #ifdef ENABLE_DEBUG_SERIAL
+            Serial.println(F("[FlashRing] Error: Record not fully written."));
+        #endif
+        return false;
+    }
+
+    _headSize += recordLen;
+    _pendingRecords++;
+    _pendingBytes += length;
+    return true;
+}
+
+int FlashRing::migrate(const Visitor& apply, int maxRecords, const Committer& commit) {
+    if (!_available || maxRecords <= 0) return 0;
+    if (_pendingRecords == 0 && _tailSeq == _headSeq) return 0;
+
+    // Destino + datos del registro más grande, más un byte para terminar el destino en '\0'
+    uint8_t* buffer = (uint8_t*)malloc(255 + FLASH_RING_MAX_DATA + 1);
+    if (buffer == nullptr) return 0;
+
+    int migrated = 0;
+    bool stopped = false;
+    bool damaged = false;
+    const uint32_t startSeq = _tailSeq;
+    const uint32_t startOffset = _tailOffset;
+
+    // Último punto confirmado: si commit() falla, el cursor vuelve aquí
+    uint32_t committedOffset = _tailOffset;
+    int uncommittedRecords = 0;
+    uint32_t uncommittedBytes = 0;
+    auto confirm = [&]() -> bool {
+        if (uncommittedRecords == 0 || !commit || commit()) {
+            committedOffset = _tailOffset;
+            uncommittedRecords = 0;
+            uncommittedBytes = 0;
+            return true;
+        }
+        _tailOffset = committedOffset;
+        migrated -= uncommittedRecords;
+        _pendingRecords += uncommittedRecords;
+        _pendingBytes += uncommittedBytes;
+        return false;
+    };
+
+    while (!stopped && migrated < maxRecords) {
+        File segment = _fs.open(_segmentPath(_tailSeq).c_str(), FILE_READ);
+        const size_t segmentSize = segment ? segment.size() : 0;
+        if (segment) segment.seek(_tailOffset);
+
+        while (_tailOffset < segmentSize && migrated < maxRecords) {
+            uint8_t header[FLASH_RING_HEADER_LEN] = {0};
+            const size_t recordLen = _readHeader(segment, segmentSize - _tailOffset, header);
+            const size_t payloadLen = recordLen > 0 ? recordLen - FLASH_RING_HEADER_LEN : 0;
+            const uint8_t targetLen = header[4];
+            bool valid = recordLen > 0 && segment.read(buffer, payloadLen) == payloadLen;
+            if (valid) {
+                uint16_t crc = _crc16(0xFFFF, header + 1, 4);
+                crc = _crc16(crc, buffer, payloadLen);
+                valid = crc == (uint16_t)(header[5] | (header[6] << 8));
+            }
+            if (!valid) {
+                // Registro dañado o cortado: no se puede resincronizar, se salta el resto del segmento.
+                // Se cuentan los registros que aún tienen cabecera legible (al menos el dañado);
+                // los que haya tras una cabecera ilegible solo constan en los bytes descartados.
+                uint32_t lostBytes = 0;
+                uint32_t lost = _countRecords(segment, _tailOffset, segmentSize, lostBytes);
+                if (lost == 0) lost = 1;
+                #ifdef ENABLE_DEBUG_SERIAL
+                    Serial.printf("[FlashRing] Damaged record in segment %lu at offset %lu. Skipping segment (%lu records, %lu bytes).\n",
+                                  (unsigned long)_tailSeq, (unsigned long)_tailOffset, (unsigned long)lost,
+                                  (unsigned long)(segmentSize - _tailOffset));
+                #endif
+                _droppedRecords += lost;
+                _droppedBytes += segmentSize - _tailOffset;
+                _tailOffset = segmentSize;
+                damaged = true;
+                break;
+            }
+
+            uint8_t saved = buffer[targetLen];
+            buffer[targetLen] = '\0';
+            String target((const char*)buffer);
+            buffer[targetLen] = saved;
+
+            const size_t dataLen = payloadLen - targetLen;
+            if (!apply((HotRecordType)header[1], target, buffer + targetLen, dataLen)) {
+                stopped = true;
+                break;
+            }
+            _tailOffset += recordLen;
+            migrated++;
+            uncommittedRecords++;
+            uncommittedBytes += dataLen;
+            if (_pendingRecords > 0) _pendingRecords--;
+            _pendingBytes = _pendingBytes > dataLen ? _pendingBytes - dataLen : 0;
+        }
+        if (segment) segment.close();
+
+        if (stopped || _tailSeq == _headSeq || _tailOffset < segmentSize) break;
+        if (!confirm()) break; // El segmento no se borra hasta que sus registros son persistentes
+
+        // Segmento migrado por completo: se borra y se continúa con el siguiente
+        _fs.remove(_segmentPath(_tailSeq).c_str());
+        _tailSeq++;
+        _tailOffset = 0;
+        committedOffset = 0;
+    }
+    free(buffer);
+    confirm();
+
+    if (damaged) _recount();
+    if (_tailSeq != startSeq || _tailOffset != startOffset) _saveCursor();
+    return migrated;
+}
+
+bool FlashRing::writeState(const char* name, const String& data) {
+    if (!_available) return false;
+
+    String path = _statePath(name);
+    String tmpPath = path + ".tmp";
+    File file = _fs.open(tmpPath.c_str(), FILE_WRITE);
+    if (!file) return false;
+    bool ok = file.print(data) == data.length();
+    file.close();
+
+    // rename() de LittleFS reemplaza el destino de forma atómica: nunca queda un estado a medias
+    if (!ok || !_fs.rename(tmpPath.c_str(), path.c_str())) {
+        #ifdef ENABLE_DEBUG_SERIAL
+            Serial.println("[FlashRing] Failed to write state file: " + path);
+        #endif
+        _fs.remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool FlashRing::readState(const char* name, String& dataOut) {
+    dataOut = "";
+    if (!_available) return false;
+
+    String path = _statePath(name);
+    if (!_fs.exists(path.c_str())) return false;
+    File file = _fs.open(path.c_str(), FILE_READ);
+    if (!file) return false;
+    dataOut = file.readString();
+    file.close();
+    return !dataOut.isEmpty();
+}
+
+void FlashRing::clear() {
+    if (!_available) return;
+    for (uint32_t seq = _tailSeq; seq <= _headSeq; seq++) {
+        _fs.remove(_segmentPath(seq).c_str());
+    }
+    _fs.remove(FLASH_RING_CURSOR_FILE);
+    _headSeq = _tailSeq = 1;
+    _headSize = _tailOffset = 0;
+    _pendingRecords = _pendingBytes = _droppedRecords = _droppedBytes = 0;
+}
+
+String FlashRing::_segmentPath(uint32_t seq) const {
+    char path[24];
+    snprintf(path, sizeof(path), "/seg_%08lu.bin", (unsigned long)seq);
+    return String(path);
+}
+
+String FlashRing::_statePath(const char* name) const {
+    return String("/state_") + name;
+}
+
+size_t FlashRing::_readHeader(File& file, size_t remaining, uint8_t* header) const {
+    if (remaining < FLASH_RING_HEADER_LEN) return 0;
+    if (file.read(header, FLASH_RING_HEADER_LEN) != FLASH_RING_HEADER_LEN) return 0;
+
+    const uint16_t payloadLen = (uint16_t)(header[2] | (header[3] << 8));
+    const uint8_t targetLen = header[4];
+    if (header[0] != FLASH_RING_SYNC_BYTE) return 0;
+    if (header[1] < (uint8_t)HotRecordType::WRITE_FILE || header[1] > (uint8_t)HotRecordType::EVENT_FRAME) return 0;
+    if (targetLen == 0 || payloadLen < targetLen || payloadLen - targetLen > FLASH_RING_MAX_DATA) return 0;
+    if (FLASH_RING_HEADER_LEN + (size_t)payloadLen > remaining) return 0; // Cortado por un reinicio
+    return FLASH_RING_HEADER_LEN + payloadLen;
+}
+
+uint32_t FlashRing::_countRecords(File& segment, size_t pos, size_t segmentSize, uint32_t& dataBytes) const {
+    uint32_t count = 0;
+    dataBytes = 0;
+    uint8_t header[FLASH_RING_HEADER_LEN];
+    size_t recordLen;
+    segment.seek(pos);
+    while (pos < segmentSize && (recordLen = _readHeader(segment, segmentSize - pos, header)) > 0) {
+        count++;
+        dataBytes += recordLen - FLASH_RING_HEADER_LEN - header[4];
+        pos += recordLen;
+        segment.seek(pos);
+    }
+    return count;
+}
+
+void FlashRing::_recount() {
+    _pendingRecords = 0;
+    _pendingBytes = 0;
+    bool headTorn = false;
+
+    for (uint32_t seq = _tailSeq; seq <= _headSeq; seq++) {
+        File segment = _fs.open(_segmentPath(seq).c_str(), FILE_READ);
+        if (!segment) continue;
+        const size_t segmentSize = segment.size();
+        size_t pos = (seq == _tailSeq) ? _tailOffset : 0;
+        segment.seek(pos);
+        while (pos < segmentSize) {
+            uint8_t header[FLASH_RING_HEADER_LEN];
+            size_t recordLen = _readHeader(segment, segmentSize - pos, header);
+            if (recordLen == 0) {
+                if (seq == _headSeq) headTorn = true;
+                break;
+            }
+            _pendingRecords++;
+            _pendingBytes += recordLen - FLASH_RING_HEADER_LEN - header[4];
+            pos += recordLen;
+            segment.seek(pos);
+        }
+        segment.close();
+    }
+
+    // Lo que se añada después de un registro cortado no sería alcanzable: segmento nuevo
+    if (headTorn) {
+        _headSeq++;
+        _headSize = 0;
+    }
+}
+
+void FlashRing::_dropOldestSegment() {
+    uint32_t lost = 0;
+    uint32_t lostBytes = 0;
+    File segment = _fs.open(_segmentPath(_tailSeq).c_str(), FILE_READ);
+    if (segment) {
+        const size_t segmentSize = segment.size();
+        lost = _countRecords(segment, _tailOffset, segmentSize, lostBytes);
+        if (segmentSize > _tailOffset) _droppedBytes += segmentSize - _tailOffset;
+        segment.close();
+    }
+
+    #ifdef ENABLE_DEBUG_SERIAL
+        Serial.printf("[FlashRing] Ring full. Dropping segment %lu (%lu records not migrated).\n",
+                      (unsigned long)_tailSeq, (unsigned long)lost);
+    #endif
+    _fs.remove(_segmentPath(_tailSeq).c_str());
+    _droppedRecords += lost;
+    _pendingRecords = _pendingRecords > lost ? _pendingRecords - lost : 0;
+    _pendingBytes = _pendingBytes > lostBytes ? _pendingBytes - lostBytes : 0;
+    _tailSeq++;
+    _tailOffset = 0;
+    _saveCursor();
+}
+
+bool FlashRing::_saveCursor() {
+    uint8_t buf[8];
+    for (int i = 0; i < 4; i++) {
+        buf[i] = (uint8_t)(_tailSeq >> (8 * i));
+        buf[4 + i] = (uint8_t)(_tailOffset >> (8 * i));
+    }
+    File file = _fs.open(FLASH_RING_CURSOR_TMP, FILE_WRITE);
+    if (!file) return false;
+    bool ok = file.write(buf, sizeof(buf)) == sizeof(buf);
+    file.close();
+    return ok && _fs.rename(FLASH_RING_CURSOR_TMP, FLASH_RING_CURSOR_FILE);
+}
+
+bool FlashRing::_loadCursor(uint32_t& seq, uint32_t& offset) {
+    File file = _fs.open(FLASH_RING_CURSOR_FILE, FILE_READ);
+    if (!file) return false;
+    uint8_t buf[8];
+    bool ok = file.read(buf, sizeof(buf)) == sizeof(buf);
+    file.close();
+    if (!ok) return false;
+    seq = 0;
+    offset = 0;
+    for (int i = 0; i < 4; i++) {
+        seq |= (uint32_t)buf[i] << (8 * i);
+        offset |= (uint32_t)buf[4 + i] << (8 * i);
+    }
+    return true;
+}
+
+// CRC-16/CCITT-FALSE (polinomio 0x1021)
+uint16_t FlashRing::_crc16(uint16_t crc, const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
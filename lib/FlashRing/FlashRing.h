@@ -0,0 +1,175 @@
+#ifndef FLASH_RING_H
+#define FLASH_RING_H
+
+#include <Arduino.h>
+#include "FS.h"
+#include <LittleFS.h>
+#include <functional> // Para std::function (visitante de migrate)
+
+// --- Partición y montaje (ver partitions.csv) ---
+#define FLASH_RING_PARTITION "hotring"   // Etiqueta de la partición LittleFS dedicada
+#define FLASH_RING_MOUNT "/hot"          // Punto de montaje VFS (el LittleFS de config usa /littlefs)
+
+// --- Geometría del anillo ---
+#define FLASH_RING_SEGMENT_BYTES 16384   // Tamaño máximo de cada archivo de segmento
+#define FLASH_RING_MAX_SEGMENTS 24       // 24 x 16 KB = 384 KB (deja margen a LittleFS en 512 KB)
+#define FLASH_RING_MAX_DATA 1024         // Registros mayores van directos a la SD
+
+// --- Formato de registro (binario, little-endian) ---
+// [SYNC 0x5A][TIPO][LEN u16 (destino + datos)][LEN_DESTINO u8][CRC16 u16][DESTINO][DATOS]
+// CRC-16/CCITT sobre TIPO, LEN, LEN_DESTINO, DESTINO y DATOS.
+#define FLASH_RING_SYNC_BYTE 0x5A
+#define FLASH_RING_HEADER_LEN 7
+
+/**
+ * @brief Qué hacer con el registro al migrarlo a la SD.
+ */
+enum class HotRecordType : uint8_t {
+    WRITE_FILE = 1,   ///< Crear/sobrescribir el archivo destino con los datos (ej. JSON ambiental)
+    APPEND_LINE = 2,  ///< Añadir los datos + salto de línea al archivo destino (log de texto)
+    EVENT_FRAME = 3   ///< Añadir una trama de EventLog (con cabecera EVENT_LOG_MAGIC si el archivo es nuevo)
+};
+
+/**
+ * @class FlashRing
+ * @brief Anillo de registros pequeños en una partición LittleFS de la flash interna.
+ *
+ * Nivel "rápido" del almacenamiento: los registros pequeños (ambientales, líneas de log,
+ * tramas de EventLog) se añaden aquí en lugar de abrir un archivo en la SD por cada uno,
+ * y `migrate()` los entrega después por lotes, en orden, a quien los escribe en la SD.
+ * Los registros se agrupan en archivos de segmento `/seg_NNNNNNNN.bin` de hasta
+ * FLASH_RING_SEGMENT_BYTES; los segmentos ya migrados se borran y se crean otros nuevos,
+ * así que las escrituras recorren toda la partición (LittleFS reparte el desgaste por bloques).
+ * Si se alcanzan FLASH_RING_MAX_SEGMENTS se descarta el segmento más antiguo.
+ * El cursor de migración se guarda en `/ring.cur` (escritura en temporal + rename), una vez
+ * por lote. Un registro cortado por un reinicio se detecta por su CRC y se descarta.
+ */
+class FlashRing {
+public:
+    /**
+     * @brief Recibe cada registro durante la migración. Devuelve false para detenerla
+     * (ej. fallo de la SD): el registro se volverá a entregar en la siguiente llamada.
+     */
+    typedef std::function<bool(HotRecordType type, const String& target, const uint8_t* data, size_t length)> Visitor;
+
+    /**
+     * @brief Confirma que lo entregado al visitante ya es persistente (ej. vuelca un buffer).
+     * Devuelve false si falló: los registros desde la última confirmación se vuelven a entregar.
+     */
+    typedef std::function<bool()> Committer;
+
+    FlashRing();
+
+    /**
+     * @brief Monta la partición (la formatea si no tiene un LittleFS válido) y recupera
+     * el cursor de migración y los contadores.
+     * @param partitionLabel Etiqueta de la partición en la tabla de particiones.
+     * @param basePath Punto de montaje VFS.
+     * @return True si el anillo está disponible. False si la partición no existe.
+     */
+    bool begin(const char* partitionLabel = FLASH_RING_PARTITION, const char* basePath = FLASH_RING_MOUNT);
+
+    /**
+     * @brief Desmonta la partición (los datos pendientes se conservan).
+     */
+    void end();
+
+    /**
+     * @brief Verifica si el anillo está montado.
+     */
+    bool isAvailable() const;
+
+    /**
+     * @brief Añade un registro al final del anillo.
+     * @param type Acción a aplicar al migrarlo.
+     * @param target Ruta destino en la SD (máx. 255 caracteres).
+     * @param data Datos del registro.
+     * @param length Longitud de los datos (máx. FLASH_RING_MAX_DATA).
+     * @return True si se escribió completo.
+     */
+    bool append(HotRecordType type, const String& target, const uint8_t* data, size_t length);
+
+    /**
+     * @brief Entrega al visitante los registros pendientes, del más antiguo al más reciente.
+     * El cursor avanza solo por los registros aceptados y se persiste al terminar.
+     * @param apply Visitante que escribe cada registro en la SD.
+     * @param maxRecords Máximo de registros en esta llamada.
+     * @param commit (Opcional) Se llama antes de borrar cada segmento migrado y antes de
+     * guardar el cursor, para visitantes que acumulan las escrituras: debe dejar lo entregado
+     * sincronizado en su destino antes de devolver true (con false, el cursor vuelve al último punto confirmado).
+     * @return Número de registros migrados (y confirmados).
+     */
+    int migrate(const Visitor& apply, int maxRecords, const Committer& commit = Committer());
+
+    /**
+     * @brief Guarda un archivo de estado pequeño fuera del anillo (sobrescribe de forma atómica).
+     * @param name Nombre del estado (ej. "api_state").
+     * @param data Contenido.
+     * @return True si se guardó.
+     */
+    bool writeState(const char* name, const String& data);
+
+    /**
+     * @brief Lee un archivo de estado guardado con writeState().
+     * @return True si existe y no está vacío.
+     */
+    bool readState(const char* name, String& dataOut);
+
+    /**
+     * @brief Borra todos los segmentos, el cursor y los contadores (no los estados).
+     */
+    void clear();
+
+    uint32_t pendingRecords() const;  ///< Registros aún no migrados
+    uint32_t pendingBytes() const;    ///< Bytes de datos aún no migrados (sin cabeceras)
+    uint32_t droppedRecords() const;  ///< Registros perdidos desde begin() (anillo lleno o dañados)
+    uint32_t droppedBytes() const;    ///< Bytes de segmento descartados desde begin() (cabeceras incluidas)
+
+private:
+    fs::LittleFSFS _fs;
+    bool _available;
+
+    uint32_t _headSeq;    // Segmento en el que se escribe
+    uint32_t _headSize;   // Tamaño actual del segmento de escritura
+    uint32_t _tailSeq;    // Segmento del siguiente registro a migrar
+    uint32_t _tailOffset; // Posición del siguiente registro a migrar dentro de _tailSeq
+
+    uint32_t _pendingRecords;
+    uint32_t _pendingBytes;
+    uint32_t _droppedRecords;
+    uint32_t _droppedBytes;
+
+    String _segmentPath(uint32_t seq) const;
+    String _statePath(const char* name) const;
+
+    /**
+     * @brief (Helper) Lee y valida la cabecera del registro en la posición actual de `file`.
+     * @return Longitud total del registro (cabecera incluida), o 0 si no hay un registro válido.
+     */
+    size_t _readHeader(File& file, size_t remaining, uint8_t* header) const;
+
+    /**
+     * @brief (Helper) Cuenta los registros de `segment` desde `pos` leyendo solo las cabeceras
+     * (se detiene en la primera cabecera inválida).
+     * @param[out] dataBytes Bytes de datos de esos registros (sin cabeceras ni destino).
+     */
+    uint32_t _countRecords(File& segment, size_t pos, size_t segmentSize, uint32_t& dataBytes) const;
+
+    /**
+     * @brief (Helper) Recorre los segmentos desde el cursor y recalcula los contadores.
+     * Si el segmento de escritura termina en un registro cortado, abre uno nuevo.
+     */
+    void _recount();
+
+    /**
+     * @brief (Helper) Descarta el segmento más antiguo (anillo lleno).
+     */
+    void _dropOldestSegment();
+
+    bool _saveCursor();
+    bool _loadCursor(uint32_t& seq, uint32_t& offset);
+
+    static uint16_t _crc16(uint16_t crc, const uint8_t* data, size_t length);
+};
+
+#endif // FLASH_RING_H
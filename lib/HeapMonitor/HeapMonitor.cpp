@@ -0,0 +1,197 @@
+#include "HeapMonitor.h"
+#include "esp_heap_caps.h"
+
+// Capacidad de heap_caps asociada a cada región (mismo orden que HeapRegion)
+static const uint32_t HEAP_REGION_CAPS[] = { MALLOC_CAP_INTERNAL, MALLOC_CAP_SPIRAM };
+static const char* const HEAP_REGION_NAMES[] = { "internal", "psram" };
+
+// Nombres de LogModule (mismo orden que el enum) para el JSON del portal
+static const char* const HEAP_TAG_MODULE_NAMES[] = { "core", "api", "sdmanager", "image", "environment", "wifi" };
+static_assert(sizeof(HEAP_TAG_MODULE_NAMES) / sizeof(HEAP_TAG_MODULE_NAMES[0]) == (size_t)LogModule::COUNT,
+              "HEAP_TAG_MODULE_NAMES must match LogModule");
+
+#define REGION_COUNT ((size_t)HeapRegion::COUNT)
+#define MODULE_COUNT ((size_t)LogModule::COUNT)
+
+HeapSnapshot HeapMonitor::_last[REGION_COUNT];
+uint32_t HeapMonitor::_streakStartUsed[REGION_COUNT] = {0};
+uint16_t HeapMonitor::_growthStreak[REGION_COUNT] = {0};
+bool HeapMonitor::_hasBaseline = false;
+uint32_t HeapMonitor::_cycleCount = 0;
+
+HeapMonitor::CycleRecord HeapMonitor::_history[HEAP_HISTORY_LEN];
+uint16_t HeapMonitor::_historyHead = 0;
+uint16_t HeapMonitor::_historyCount = 0;
+
+uint32_t HeapMonitor::_tagFreeAtBegin[MODULE_COUNT] = {0};
+uint8_t HeapMonitor::_tagDepth[MODULE_COUNT] = {0};
+int32_t HeapMonitor::_tagNetBytes[MODULE_COUNT] = {0};
+int32_t HeapMonitor::_tagLastCycle[MODULE_COUNT] = {0};
+
+HeapSnapshot HeapMonitor::snapshot(HeapRegion region) {
+    HeapSnapshot snap;
+    uint32_t caps = HEAP_REGION_CAPS[(size_t)region];
+
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, caps);
+    snap.totalBytes = heap_caps_get_total_size(caps);
+    snap.freeBytes = info.total_free_bytes;
+    snap.largestFreeBlock = info.largest_free_block;
+    snap.minFreeEver = info.minimum_free_bytes;
+    return snap;
+}
+
+bool HeapMonitor::sampleCycle() {
+    CycleRecord& record = _history[_historyHead];
+
+    for (size_t r = 0; r < REGION_COUNT; r++) {
+        HeapSnapshot now = snapshot((HeapRegion)r);
+        uint32_t used = now.usedBytes();
+
+        if (!_hasBaseline || now.totalBytes == 0) {
+            _streakStartUsed[r] = used;
+            _growthStreak[r] = 0;
+        } else {
+            uint32_t prevUsed = _last[r].usedBytes();
+            if (used > prevUsed + HEAP_GROWTH_NOISE_BYTES) {
+                if (_growthStreak[r] == 0) _streakStartUsed[r] = prevUsed;
+                _growthStreak[r]++;
+            } else if (used + HEAP_GROWTH_NOISE_BYTES < prevUsed) {
+                // Bajó de forma clara: se descarta la racha
+                _growthStreak[r] = 0;
+                _streakStartUsed[r] = used;
+            }
+            // (Variación dentro del ruido: la racha se mantiene)
+        }
+
+        _last[r] = now;
+        record.usedBytes[r] = used;
+        record.largestFreeBlock[r] = now.largestFreeBlock;
+    }
+    _hasBaseline = true;
+    _cycleCount++;
+
+    _historyHead = (_historyHead + 1) % HEAP_HISTORY_LEN;
+    if (_historyCount < HEAP_HISTORY_LEN) _historyCount++;
+
+    // Cierra el ciclo de los balances por módulo
+    for (size_t m = 0; m < MODULE_COUNT; m++) {
+        _tagLastCycle[m] = _tagNetBytes[m];
+        _tagNetBytes[m] = 0;
+    }
+
+    bool flagged = isGrowthFlagged();
+    #ifdef ENABLE_DEBUG_SERIAL
+        Serial.printf("[HeapMonitor] Cycle %u: %s%s\n", (unsigned int)_cycleCount, summary().c_str(),
+                      flagged ? " [GROWTH]" : "");
+    #endif
+    return flagged;
+}
+
+bool HeapMonitor::isGrowthFlagged() {
+    for (size_t r = 0; r < REGION_COUNT; r++) {
+        if (_growthStreak[r] >= HEAP_GROWTH_STREAK_CYCLES) return true;
+    }
+    return false;
+}
+
+// (Formato compacto: 1234 -> "1.2k", 8123456 -> "7.7M")
+static String formatBytes(uint32_t bytes) {
+    if (bytes >= 1024UL * 1024UL) return String(bytes / (1024.0f * 1024.0f), 1) + "M";
+    if (bytes >= 1024UL) return String(bytes / 1024.0f, 1) + "k";
+    return String(bytes);
+}
+
+String HeapMonitor::summary() {
+    String out = "Heap";
+    for (size_t r = 0; r < REGION_COUNT; r++) {
+        const HeapSnapshot& s = _last[r];
+        if (s.totalBytes == 0) continue; // Región no presente (ej. placa sin PSRAM)
+        out += (r == 0) ? " " : ", ";
+        out += (r == (size_t)HeapRegion::INTERNAL) ? "int " : "psram ";
+        out += formatBytes(s.freeBytes) + " free/" + formatBytes(s.largestFreeBlock) + " blk/" +
+               formatBytes(s.minFreeEver) + " min";
+    }
+    return out;
+}
+
+String HeapMonitor::growthDetails() {
+    String out;
+    for (size_t r = 0; r < REGION_COUNT; r++) {
+        if (_growthStreak[r] < HEAP_GROWTH_STREAK_CYCLES) continue;
+        if (!out.isEmpty()) out += "; ";
+        out += String(HEAP_REGION_NAMES[r]) + " +" + String((long)(_last[r].usedBytes() - _streakStartUsed[r])) +
+               " B over " + String(_growthStreak[r]) + " cycles";
+    }
+
+    // Módulo con mayor balance positivo en el último ciclo (solo con etiquetado)
+    int32_t worst = 0;
+    size_t worstModule = MODULE_COUNT;
+    for (size_t m = 0; m < MODULE_COUNT; m++) {
+        if (_tagLastCycle[m] > worst) {
+            worst = _tagLastCycle[m];
+            worstModule = m;
+        }
+    }
+    if (worstModule < MODULE_COUNT) {
+        out += " (top module: " + String(HEAP_TAG_MODULE_NAMES[worstModule]) + " +" + String((long)worst) + " B)";
+    }
+    return out;
+}
+
+void HeapMonitor::toJson(JsonObject root) {
+    root["cycles"] = _cycleCount;
+    root["growth_flagged"] = isGrowthFlagged();
+    root["growth_streak_threshold"] = HEAP_GROWTH_STREAK_CYCLES;
+
+    for (size_t r = 0; r < REGION_COUNT; r++) {
+        HeapSnapshot now = snapshot((HeapRegion)r);
+        JsonObject region = root[HEAP_REGION_NAMES[r]].to<JsonObject>();
+        region["total"] = now.totalBytes;
+        region["free"] = now.freeBytes;
+        region["largest_free_block"] = now.largestFreeBlock;
+        region["min_free_ever"] = now.minFreeEver;
+        region["fragmentation_pct"] = now.fragmentationPct();
+        region["growth_streak"] = _growthStreak[r];
+        region["growth_bytes"] = _growthStreak[r] > 0 ? (long)(_last[r].usedBytes() - _streakStartUsed[r]) : 0L;
+
+        // Historial de uso (bytes usados / bloque libre mayor), del más antiguo al más reciente
+        JsonArray used = region["history_used"].to<JsonArray>();
+        JsonArray largest = region["history_largest_block"].to<JsonArray>();
+        uint16_t start = (_historyHead + HEAP_HISTORY_LEN - _historyCount) % HEAP_HISTORY_LEN;
+        for (uint16_t i = 0; i < _historyCount; i++) {
+            const CycleRecord& rec = _history[(start + i) % HEAP_HISTORY_LEN];
+            used.add(rec.usedBytes[r]);
+            largest.add(rec.largestFreeBlock[r]);
+        }
+    }
+
+    #ifdef ENABLE_HEAP_TAGGING
+        JsonObject tags = root["module_net_bytes"].to<JsonObject>();
+        for (size_t m = 0; m < MODULE_COUNT; m++) {
+            tags[HEAP_TAG_MODULE_NAMES[m]] = _tagLastCycle[m];
+        }
+    #endif
+}
+
+uint32_t HeapMonitor::_totalFree() {
+    return heap_caps_get_free_size(MALLOC_CAP_INTERNAL) + heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+}
+
+void HeapMonitor::tagBegin(LogModule module) {
+    size_t m = (size_t)module;
+    if (m >= MODULE_COUNT) return;
+    // Solo cuenta el bloque más externo (evita contar dos veces si se anidan)
+    if (_tagDepth[m]++ == 0) {
+        _tagFreeAtBegin[m] = _totalFree();
+    }
+}
+
+void HeapMonitor::tagEnd(LogModule module) {
+    size_t m = (size_t)module;
+    if (m >= MODULE_COUNT || _tagDepth[m] == 0) return;
+    if (--_tagDepth[m] == 0) {
+        // Positivo = el bloque dejó memoria reservada al salir
+        _tagNetBytes[m] += (int32_t)(_tagFreeAtBegin[m] - _totalFree());
+    }
+}
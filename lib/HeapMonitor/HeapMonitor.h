@@ -0,0 +1,143 @@
+#ifndef HEAP_MONITOR_H
+#define HEAP_MONITOR_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "ErrorLogger.h" // LogModule (etiquetado de asignaciones por módulo)
+
+// --- Parámetros de detección de crecimiento ---
+#define HEAP_GROWTH_STREAK_CYCLES 6     // Ciclos seguidos creciendo para marcar fuga
+#define HEAP_GROWTH_NOISE_BYTES   256   // Variaciones menores se consideran ruido (ni crece ni baja)
+#define HEAP_HISTORY_LEN          48    // Ciclos guardados para el portal (48 = 1 día a 30 min)
+
+/**
+ * @brief Regiones de memoria monitorizadas (capacidades de heap_caps).
+ */
+enum class HeapRegion : uint8_t {
+    INTERNAL, ///< MALLOC_CAP_INTERNAL (SRAM interna)
+    PSRAM,    ///< MALLOC_CAP_SPIRAM
+    COUNT
+};
+
+/**
+ * @brief Instantánea de una región de memoria (heap_caps_get_info).
+ */
+struct HeapSnapshot {
+    uint32_t totalBytes = 0;
+    uint32_t freeBytes = 0;
+    uint32_t largestFreeBlock = 0;
+    uint32_t minFreeEver = 0;   ///< Mínimo histórico de memoria libre desde el arranque
+
+    uint32_t usedBytes() const { return totalBytes - freeBytes; }
+    /// Fragmentación (%): 0 = todo lo libre es un único bloque.
+    uint8_t fragmentationPct() const {
+        return freeBytes == 0 ? 0 : (uint8_t)(100 - (uint64_t)largestFreeBlock * 100 / freeBytes);
+    }
+};
+
+/**
+ * @class HeapMonitor
+ * @brief Clase de utilidad (estática) para la telemetría de memoria por ciclo.
+ *
+ * Al final de cada ciclo se toma una instantánea de la SRAM interna y la PSRAM.
+ * Si el uso neto crece durante HEAP_GROWTH_STREAK_CYCLES ciclos seguidos, el
+ * ciclo se marca como posible fuga. Con -D ENABLE_HEAP_TAGGING, las macros
+ * HEAP_TAG_SCOPE acumulan el balance neto de memoria de cada módulo en el ciclo.
+ */
+class HeapMonitor {
+public:
+    /**
+     * @brief Obtiene el estado actual de una región.
+     */
+    static HeapSnapshot snapshot(HeapRegion region);
+
+    /**
+     * @brief Registra el fin de un ciclo: guarda la instantánea y actualiza la detección.
+     * Llamar en el mismo punto de cada ciclo, después de liberar los buffers del ciclo.
+     * @return True si el ciclo queda marcado como posible fuga.
+     */
+    static bool sampleCycle();
+
+    /**
+     * @brief Indica si el último ciclo se marcó como posible fuga.
+     */
+    static bool isGrowthFlagged();
+
+    /**
+     * @brief Resumen de una línea para el log de fin de ciclo.
+     * Ej: "Heap int 142.3k free/86.0k blk/120.1k min, psram 7.8M free/7.6M blk/7.7M min".
+     */
+    static String summary();
+
+    /**
+     * @brief Descripción de la fuga sospechada (regiones, bytes, módulo con mayor balance).
+     */
+    static String growthDetails();
+
+    /**
+     * @brief Vuelca el estado actual, la detección, el historial y los balances por módulo.
+     */
+    static void toJson(JsonObject root);
+
+    // --- Etiquetado por módulo (usar las macros HEAP_TAG_*) ---
+    static void tagBegin(LogModule module);
+    static void tagEnd(LogModule module);
+
+private:
+    struct CycleRecord {
+        uint32_t usedBytes[(size_t)HeapRegion::COUNT];
+        uint32_t largestFreeBlock[(size_t)HeapRegion::COUNT];
+    };
+
+    static HeapSnapshot _last[(size_t)HeapRegion::COUNT];      ///< Instantánea del último ciclo
+    static uint32_t _streakStartUsed[(size_t)HeapRegion::COUNT]; ///< Uso al iniciar la racha
+    static uint16_t _growthStreak[(size_t)HeapRegion::COUNT];  ///< Ciclos seguidos creciendo
+    static bool _hasBaseline;
+    static uint32_t _cycleCount;
+
+    static CycleRecord _history[HEAP_HISTORY_LEN];
+    static uint16_t _historyHead;
+    static uint16_t _historyCount;
+
+    static uint32_t _tagFreeAtBegin[(size_t)LogModule::COUNT];
+    static uint8_t _tagDepth[(size_t)LogModule::COUNT];          ///< Anidamiento (solo cuenta el externo)
+    static int32_t _tagNetBytes[(size_t)LogModule::COUNT];     ///< Ciclo en curso
+    static int32_t _tagLastCycle[(size_t)LogModule::COUNT];    ///< Último ciclo cerrado
+
+    /**
+     * @brief (Helper) Memoria libre total (interna + PSRAM), para el etiquetado.
+     */
+    static uint32_t _totalFree();
+};
+
+/**
+ * @class HeapTagScope
+ * @brief (RAII) Atribuye al módulo el balance neto de memoria de un bloque.
+ */
+class HeapTagScope {
+public:
+    explicit HeapTagScope(LogModule module) : _module(module) { HeapMonitor::tagBegin(_module); }
+    ~HeapTagScope() { HeapMonitor::tagEnd(_module); }
+    HeapTagScope(const HeapTagScope&) = delete;
+    HeapTagScope& operator=(const HeapTagScope&) = delete;
+
+private:
+    LogModule _module;
+};
+
+// --- Macros de etiquetado ---
+// Sin -D ENABLE_HEAP_TAGGING no generan código.
+#define HEAP_TAG_CONCAT_INNER(a, b) a##b
+#define HEAP_TAG_CONCAT(a, b) HEAP_TAG_CONCAT_INNER(a, b)
+
+#ifdef ENABLE_HEAP_TAGGING
+    #define HEAP_TAG_BEGIN(module) HeapMonitor::tagBegin(LogModule::module)
+    #define HEAP_TAG_END(module)   HeapMonitor::tagEnd(LogModule::module)
+    #define HEAP_TAG_SCOPE(module) HeapTagScope HEAP_TAG_CONCAT(_heapTag_, __LINE__)(LogModule::module)
+#else
+    #define HEAP_TAG_BEGIN(module) do {} while (0)
+    #define HEAP_TAG_END(module)   do {} while (0)
+    #define HEAP_TAG_SCOPE(module) do {} while (0)
+#endif
+
+#endif // HEAP_MONITOR_H
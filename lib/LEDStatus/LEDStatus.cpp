@@ -3,9 +3,9 @@
  * @brief Implementa la clase LEDStatus para controlar el LED de estado (WS2812).
  */
 #include "LEDStatus.h"
+#include "BoardProfile.h" // Board::LED_PIN (línea de datos del NeoPixel)
 
 // --- Configuración Hardware ---
-#define LED_PIN 48   ///< Pin GPIO donde se conecta la línea de datos del NeoPixel.
 #define NUMPIXELS 1  ///< Número de NeoPixels (debe ser 1 para esta clase).
 // ----------------------------
 
@@ -15,7 +15,7 @@
  * y establece el estado interno inicial en OFF.
  */
 LEDStatus::LEDStatus() : 
-    pixels(NUMPIXELS, LED_PIN, NEO_GRB + NEO_KHZ800),
+    pixels(NUMPIXELS, Board::LED_PIN, NEO_GRB + NEO_KHZ800),
     _currentState(OFF) // Inicializa el estado interno
     {
     // (Vacío intencionalmente)
@@ -0,0 +1,15 @@
+#include "LogFormat.h"
+#include <stdio.h>
+#include <math.h>
+
+size_t formatTimestamp(const struct tm& timeinfo, bool forFileNames, char* out, size_t size) {
+    return strftime(out, size, forFileNames ? "%Y%m%d_%H%M%S" : "%Y-%m-%dT%H:%M:%S", &timeinfo);
+}
+
+size_t formatLogLine(char* out, size_t size, const char* timestamp, const char* level,
+                     const char* message, float internalTemp) {
+    int length = isnan(internalTemp)
+        ? snprintf(out, size, "%s [%s] %s", timestamp, level, message)
+        : snprintf(out, size, "%s [%s] %s (DevTemp: %.1fC )", timestamp, level, message, internalTemp);
+    return length > 0 ? (size_t)length : 0;
+}
@@ -0,0 +1,29 @@
+#ifndef LOG_FORMAT_H
+#define LOG_FORMAT_H
+
+#include <stddef.h>
+#include <time.h>
+
+// Sin dependencias de Arduino: el formato de timestamps y de líneas de log también compila
+// en el host (tools/host_bench). TimeManager y SDManager lo envuelven en String en el ESP32.
+
+#define LOG_FORMAT_TIMESTAMP_LEN 32   // Buffer suficiente para cualquier timestamp
+#define LOG_FORMAT_LINE_STACK_LEN 192 // Líneas habituales: se forman sin reservar heap
+
+/**
+ * @brief Formatea `timeinfo` como "YYYY-MM-DDTHH:MM:SS" (ISO 8601 local) o, para nombres
+ * de archivo, como "YYYYMMDD_HHMMSS".
+ * @return Caracteres escritos (sin el terminador); 0 si no caben en `size`.
+ */
+size_t formatTimestamp(const struct tm& timeinfo, bool forFileNames, char* out, size_t size);
+
+/**
+ * @brief Forma una línea del log de texto: "<timestamp> [<nivel>] <mensaje>", más
+ * " (DevTemp: <t>C )" con un decimal si `internalTemp` no es NaN.
+ * @return Longitud de la línea completa, como snprintf: si es >= `size` la salida
+ * se truncó y hace falta un buffer de ese tamaño + 1.
+ */
+size_t formatLogLine(char* out, size_t size, const char* timestamp, const char* level,
+                     const char* message, float internalTemp);
+
+#endif // LOG_FORMAT_H
@@ -3,6 +3,11 @@
  * @brief Implementa los métodos de la clase wrapper MLX90640Sensor.
  */
 #include "MLX90640Sensor.h"
+#include "Trace.h" // Instrumentación de trazas (no-op sin ENABLE_TRACE)
+#include "FaultInjection.h" // Inyección de fallos (no-op sin ENABLE_FAULT_INJECTION)
+#include "SensorTrace.h" // Grabación/reproducción de lecturas (no-op sin ENABLE_SENSOR_TRACE)
+#include "PhaseDeadline.h" // Cancelación cooperativa entre muestras
+#include "BoardProfile.h" // Interruptor de alimentación del perfil (Board::THERMAL_POWER_PIN)
 
 // --- Configuración para Promediado Temporal (Temporal Averaging) ---
 
@@ -15,14 +20,27 @@
 // Para 0.5Hz, el periodo es 2000ms. Se añade un pequeño margen.
 #define INTER_SAMPLE_DELAY_MS 2500
 
+// Arranque del sensor tras volver a alimentarlo, antes de hablarle por I2C (datasheet: 80 ms).
+#define POWER_UP_DELAY_MS 80
+
 
 // Constructor: Inicializa la referencia TwoWire y el buffer 'frame' (a ceros).
-MLX90640Sensor::MLX90640Sensor(TwoWire &wire) : _wire(wire), frame{} {
+MLX90640Sensor::MLX90640Sensor(TwoWire &wire) : _wire(wire), frame{}, _powerState(SensorPowerState::ACTIVE) {
     // El objeto 'mlx' se construye por defecto aquí.
 }
 
 // Inicializa la comunicación con el sensor y establece los parámetros operativos.
 bool MLX90640Sensor::begin() {
+    // En reproducción los fotogramas vienen de la traza: no se necesita el sensor
+    if (SENSOR_TRACE_REPLAYING()) return true;
+
+    // Con interruptor de carga, el sensor se alimenta aquí (también al volver de OFF)
+    if (Board::THERMAL_POWER_PIN >= 0) {
+        pinMode(Board::THERMAL_POWER_PIN, OUTPUT);
+        digitalWrite(Board::THERMAL_POWER_PIN, HIGH);
+        delay(POWER_UP_DELAY_MS);
+    }
+
     if (!mlx.begin(MLX90640_I2CADDR_DEFAULT, &_wire)) {
         #ifdef ENABLE_DEBUG_SERIAL
             Serial.println(F("[MLX90640] Failed to initialize sensor. Check wiring and I2C address."));
@@ -39,6 +57,40 @@ bool MLX90640Sensor::begin() {
     mlx.setResolution(MLX90640_ADC_18BIT);
     mlx.setRefreshRate(MLX90640_0_5_HZ); // 0.5 Hz = 1 fotograma cada 2 segundos
 
+    _powerState = SensorPowerState::ACTIVE;
+    return true;
+}
+
+// STANDBY no cambia nada (sin modo de reposo); OFF solo con interruptor de alimentación.
+bool MLX90640Sensor::setPowerState(SensorPowerState state) {
+    if (SENSOR_TRACE_REPLAYING()) {
+        _powerState = state;
+        return true;
+    }
+    if (state == SensorPowerState::OFF && Board::THERMAL_POWER_PIN < 0) {
+        state = SensorPowerState::STANDBY;
+    }
+    if (state == _powerState) return true;
+
+    if (state == SensorPowerState::OFF) {
+        digitalWrite(Board::THERMAL_POWER_PIN, LOW);
+        _powerState = SensorPowerState::OFF;
+        #ifdef ENABLE_DEBUG_SERIAL
+            Serial.println(F("[MLX90640] Powered off."));
+        #endif
+        return true;
+    }
+
+    if (_powerState == SensorPowerState::OFF) {
+        // El primer fotograma tras el arranque no es fiable: se lee uno completo y se descarta
+        if (!begin() || mlx.getFrame(frame) != 0) {
+            #ifdef ENABLE_DEBUG_SERIAL
+                Serial.println(F("[MLX90640] ERROR: Sensor did not come back after power-up."));
+            #endif
+            return false;
+        }
+    }
+    _powerState = state;
     return true;
 }
 
@@ -54,10 +106,14 @@ bool MLX90640Sensor::begin() {
  * @return True si el fotograma promediado se leyó exitosamente, false en caso contrario.
  */
 bool MLX90640Sensor::readFrame() {
+    TRACE_SCOPE(MLX_READ_FRAME);
+
+    if (_powerState == SensorPowerState::OFF) return false; // Sin alimentación
+
     // Si el promediado está deshabilitado (muestras <= 1), realiza una lectura única.
     if (NUM_SAMPLES_TO_AVERAGE <= 1) {
         // retorna 'true' si getFrame() devuelve 0 (éxito)
-        return (mlx.getFrame(frame) == 0);
+        return (acquireSample(frame) == 0);
     }
 
     #ifdef ENABLE_DEBUG_SERIAL
@@ -74,16 +130,29 @@ bool MLX90640Sensor::readFrame() {
     }
 
     // Paso 2: Adquirir y acumular múltiples muestras.
+    uint8_t samplesTaken = 0;
     for (uint8_t s = 0; s < NUM_SAMPLES_TO_AVERAGE; s++) {
+        // Con el plazo de la fase vencido se promedian las muestras ya leídas (al menos una)
+        if (s > 0 && PhaseDeadline::expired()) {
+            #ifdef ENABLE_DEBUG_SERIAL
+                Serial.printf("[MLX90640] Phase deadline expired. Averaging %d of %d samples.\n", s, NUM_SAMPLES_TO_AVERAGE);
+            #endif
+            break;
+        }
+
         // Para la primera muestra (s=0), no esperamos. Para las siguientes,
         // esperamos el periodo de refresco del sensor (INTER_SAMPLE_DELAY_MS)
         // para asegurar que estamos leyendo datos nuevos.
-        if (s > 0) {
+        // (En reproducción el ritmo lo marca la traza)
+        if (s > 0 && !SENSOR_TRACE_REPLAYING()) {
+            TRACE_BEGIN(MLX_SAMPLE_WAIT);
             delay(INTER_SAMPLE_DELAY_MS);
+            TRACE_END(MLX_SAMPLE_WAIT);
         }
 
         // Intenta leer un fotograma en el buffer temporal.
-        if (mlx.getFrame(tempFrame) != 0) {
+        int frameStatus = acquireSample(tempFrame);
+        if (frameStatus != 0) {
             #ifdef ENABLE_DEBUG_SERIAL
                 Serial.printf("[MLX90640] ERROR: Failed to read sample %d/%d.\n", s + 1, NUM_SAMPLES_TO_AVERAGE);
             #endif
@@ -98,11 +167,12 @@ bool MLX90640Sensor::readFrame() {
         for (int i = 0; i < 768; i++) {
             frame[i] += tempFrame[i];
         }
+        samplesTaken++;
     }
 
     // Paso 3: Calcula el promedio final para cada píxel.
     for (int i = 0; i < 768; i++) {
-        frame[i] /= NUM_SAMPLES_TO_AVERAGE;
+        frame[i] /= samplesTaken;
     }
 
     #ifdef ENABLE_DEBUG_SERIAL
@@ -112,6 +182,21 @@ bool MLX90640Sensor::readFrame() {
     return true; // Retorna 'true' indicando éxito.
 }
 
+// Obtiene una muestra del sensor (o de la traza en reproducción) y la graba si procede.
+int MLX90640Sensor::acquireSample(float* dest) {
+    if (SENSOR_TRACE_REPLAYING()) {
+        return SensorTrace::replayThermalFrame(dest) ? 0 : -1;
+    }
+
+    TRACE_BEGIN(MLX_GET_FRAME);
+    // Un fallo inyectado se reporta como un error de bus I2C (-1)
+    int frameStatus = FAULT_INJECT(I2C_MLX_FRAME) ? -1 : mlx.getFrame(dest);
+    TRACE_END(MLX_GET_FRAME);
+
+    SENSOR_TRACE_RECORD(recordThermalFrame(dest, frameStatus == 0));
+    return frameStatus;
+}
+
 // Retorna un puntero directo al buffer interno que contiene los datos del último fotograma leído.
 float* MLX90640Sensor::getThermalData() {
     // Los datos apuntados son el resultado de la última llamada exitosa a readFrame().
@@ -12,6 +12,7 @@
 #include <Arduino.h>           
 #include <Wire.h>              // Requerido para la comunicación I2C (clase TwoWire)
 #include <Adafruit_MLX90640.h> // Incluye la librería base de Adafruit MLX90640
+#include "SensorPower.h"       // SensorPowerState
 
 /**
  * @class MLX90640Sensor
@@ -74,10 +75,32 @@ public:
      */
     float* getThermalData();
 
+    /**
+     * @brief Cambia el estado de energía entre ciclos.
+     *
+     * El MLX90640 no tiene modo de reposo ni modo paso a paso (solo convierte de forma
+     * continua) y ya trabaja a su tasa mínima (0.5 Hz), así que STANDBY lo deja como está.
+     * OFF corta la alimentación si el perfil tiene interruptor (`Board::THERMAL_POWER_PIN`);
+     * si no, equivale a STANDBY. Al volver de OFF se repite begin() y se descarta un
+     * fotograma completo (la llamada vuelve cuando el sensor ya da datos válidos).
+     *
+     * @return false si el sensor no respondió al volver a alimentarlo.
+     */
+    bool setPowerState(SensorPowerState state);
+    SensorPowerState powerState() const { return _powerState; }
+
 private:
+    /**
+     * @brief Obtiene una muestra (un getFrame()) del sensor o de la traza en reproducción.
+     * Graba la muestra si hay una grabación de SensorTrace en curso.
+     * @return 0 si la muestra es válida, negativo en caso de error (como getFrame()).
+     */
+    int acquireSample(float* dest);
+
     Adafruit_MLX90640 mlx;    ///< Instancia de la librería Adafruit MLX90640 subyacente.
     float frame[32 * 24];     ///< Buffer interno para almacenar 768 temp. (Celsius, $^{\circ}C$).
     TwoWire &_wire;           ///< Referencia al bus I2C (ej. Wire o Wire1) a utilizar.
+    SensorPowerState _powerState; ///< OFF solo con interruptor de alimentación.
 };
 
 #endif // MLX90640SENSOR_H
\ No newline at end of file
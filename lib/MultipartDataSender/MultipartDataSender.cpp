@@ -8,6 +8,10 @@
 #include <esp_random.h>  // Para generar el 'boundary' aleatorio
 #include <math.h>        // Para INFINITY, NAN, isnan
 #include <WiFi.h>        // Para la comprobación WiFi.status()
+#include "Trace.h"       // Instrumentación de trazas (no-op sin ENABLE_TRACE)
+#include "FaultInjection.h" // Inyección de fallos (no-op sin ENABLE_FAULT_INJECTION)
+#include "PhaseDeadline.h"  // Plazo de la fase en curso (acota el timeout del POST)
+#include "ThermalStats.h"   // Máximo, mínimo y media del cuadro (portables al host)
 
 // Timeout para peticiones HTTP que envían datos de captura (milisegundos)
 #define CAPTURE_DATA_HTTP_REQUEST_TIMEOUT 20000
@@ -20,7 +24,8 @@
     const String& timestamp,
     float* thermalData,
     uint8_t* jpegImage,
-    size_t jpegLength
+    size_t jpegLength,
+    const VegetationStats* vegetation
 ) {
     // --- Paso 1: Validar Datos de Entrada ---
     if (fullCaptureDataUrl.isEmpty()) {
@@ -43,10 +48,16 @@
         #endif
         return -13; // Error cliente: Sin WiFi
     }
+    if (PhaseDeadline::expired()) {
+        #ifdef ENABLE_DEBUG_SERIAL
+            Serial.println(F("[MultipartSender Error] Skipped sending: phase deadline expired."));
+        #endif
+        return -18; // Error cliente: Plazo de la fase vencido (los datos quedan pendientes)
+    }
     // NOTA: La imagen (jpegImage) SÍ puede ser nula (opcional).
 
     // --- Paso 2: Crear Payload JSON para Datos Térmicos ---
-    String thermalJsonString = createThermalJson(timestamp, thermalData);
+    String thermalJsonString = createThermalJson(timestamp, thermalData, vegetation);
     if (thermalJsonString.isEmpty()) {
         #ifdef ENABLE_DEBUG_SERIAL
           Serial.println(F("[MultipartSender Error] Failed to create thermal JSON."));
@@ -77,7 +88,7 @@
 /**
  * @brief Crea un string JSON con estadísticas y datos crudos.
  */
-/* static */ String MultipartDataSender::createThermalJson(const String& timestamp, float* thermalData) {
+/* static */ String MultipartDataSender::createThermalJson(const String& timestamp, float* thermalData, const VegetationStats* vegetation) {
     // 1. Calcular estadísticas
     float maxTemp = calculateMaxTemperature(thermalData);
     float minTemp = calculateMinTemperature(thermalData);
@@ -98,6 +109,26 @@
     doc["min_temp"] = minTemp;
     doc["avg_temp"] = avgTemp;
 
+    // Índices de vegetación de la imagen (solo si hubo imagen y se pudo analizar)
+    if (vegetation != nullptr && vegetation->valid) {
+        JsonObject veg = doc["vegetation"].to<JsonObject>();
+        veg["exg"] = vegetation->exg;
+        veg["exgr"] = vegetation->exgr;
+        veg["canopy_fraction"] = vegetation->canopyFraction;
+        veg["width"] = vegetation->width;
+        veg["height"] = vegetation->height;
+        // Temperaturas solo del dosel (homografía calibrada y dosel suficiente a la vista)
+        const CanopyThermalStats& canopy = vegetation->canopyThermal;
+        if (canopy.valid) {
+            JsonObject canopyObj = veg["canopy_thermal"].to<JsonObject>();
+            canopyObj["max_temp"] = canopy.maxTemp;
+            canopyObj["min_temp"] = canopy.minTemp;
+            canopyObj["avg_temp"] = canopy.avgTemp;
+            canopyObj["pixels"] = canopy.canopyPixels;
+            canopyObj["covered_pixels"] = canopy.coveredPixels;
+        }
+    }
+
     // 3. Añadir el array de temperaturas
     JsonArray tempArray = doc["temperatures"].to<JsonArray>();
     if (tempArray.isNull()) {
@@ -132,45 +163,41 @@
     return jsonString;
 }
 
+/* static */ bool MultipartDataSender::readVegetationJson(JsonDocument& doc, VegetationStats& vegetation) {
+    vegetation = VegetationStats();
+    JsonObject veg = doc["vegetation"];
+    if (veg.isNull()) return false;
+    vegetation.exg = veg["exg"] | NAN;
+    vegetation.exgr = veg["exgr"] | NAN;
+    vegetation.canopyFraction = veg["canopy_fraction"] | NAN;
+    vegetation.width = veg["width"] | 0;
+    vegetation.height = veg["height"] | 0;
+    JsonObject canopyObj = veg["canopy_thermal"];
+    if (!canopyObj.isNull()) {
+        CanopyThermalStats& canopy = vegetation.canopyThermal;
+        canopy.maxTemp = canopyObj["max_temp"] | NAN;
+        canopy.minTemp = canopyObj["min_temp"] | NAN;
+        canopy.avgTemp = canopyObj["avg_temp"] | NAN;
+        canopy.canopyPixels = canopyObj["pixels"] | 0;
+        canopy.coveredPixels = canopyObj["covered_pixels"] | 0;
+        canopy.valid = !isnan(canopy.avgTemp);
+    }
+    vegetation.valid = !isnan(vegetation.canopyFraction);
+    return vegetation.valid;
+}
+
 // --- Implementación de cálculos estadísticos ---
 
 float MultipartDataSender::calculateMaxTemperature(float* thermalData) {
-    if (thermalData == nullptr) return -INFINITY;
-    float maxTemp = -INFINITY;
-    for (int i = 0; i < THERMAL_PIXELS; ++i) {
-        // Ignorar valores NaN
-        if (!isnan(thermalData[i]) && thermalData[i] > maxTemp) {
-            maxTemp = thermalData[i];
-        }
-    }
-    return maxTemp;
+    return thermalMax(thermalData, THERMAL_PIXELS);
 }
 
 float MultipartDataSender::calculateMinTemperature(float* thermalData) {
-     if (thermalData == nullptr) return INFINITY;
-    float minTemp = INFINITY;
-    for (int i = 0; i < THERMAL_PIXELS; ++i) {
-        // Ignorar valores NaN
-        if (!isnan(thermalData[i]) && thermalData[i] < minTemp) {
-            minTemp = thermalData[i];
-        }
-    }
-    return minTemp;
+    return thermalMin(thermalData, THERMAL_PIXELS);
 }
 
 float MultipartDataSender::calculateAverageTemperature(float* thermalData) {
-    if (thermalData == nullptr) return NAN;
-    double sumTemp = 0.0; // Usar double para precisión en la suma
-    int validPixelCount = 0;
-    for (int i = 0; i < THERMAL_PIXELS; ++i) {
-        // Ignorar valores NaN
-        if (!isnan(thermalData[i])) {
-            sumTemp += thermalData[i];
-            validPixelCount++;
-        }
-    }
-    // Evitar división por cero
-    return (validPixelCount > 0) ? (float)(sumTemp / validPixelCount) : NAN;
+    return thermalAverage(thermalData, THERMAL_PIXELS);
 }
 
 
@@ -239,7 +266,8 @@ float MultipartDataSender::calculateAverageTemperature(float* thermalData) {
 
     http.setReuse(false); // No reutilizar conexiones
     if (http.begin(apiUrl)) {
-        http.setTimeout(CAPTURE_DATA_HTTP_REQUEST_TIMEOUT);
+        http.setConnectTimeout(PhaseDeadline::boundTimeout(HTTPCLIENT_DEFAULT_TCP_TIMEOUT));
+        http.setTimeout(PhaseDeadline::boundTimeout(CAPTURE_DATA_HTTP_REQUEST_TIMEOUT));
         http.addHeader("Connection", "close");
         // Cabecera clave que define el tipo multipart y el boundary
         http.addHeader("Content-Type", "multipart/form-data; boundary=" + boundary);
@@ -249,7 +277,12 @@ float MultipartDataSender::calculateAverageTemperature(float* thermalData) {
         }
         
         // Enviar la petición POST con el puntero al vector de bytes y su tamaño
-        httpResponseCode = http.POST(const_cast<uint8_t*>(payload.data()), payload.size());
+        if (FAULT_INJECT(WIFI_DROP)) WiFi.disconnect();
+        TRACE_BEGIN(HTTP_POST_CAPTURE);
+        httpResponseCode = FAULT_INJECT(HTTP_REQUEST)
+            ? HTTPC_ERROR_CONNECTION_LOST
+            : http.POST(const_cast<uint8_t*>(payload.data()), payload.size());
+        TRACE_END(HTTP_POST_CAPTURE);
 
         #ifdef ENABLE_DEBUG_SERIAL
             if (httpResponseCode > 0) {
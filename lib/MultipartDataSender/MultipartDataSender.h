@@ -15,6 +15,7 @@
 #include <ArduinoJson.h>     // Requerido para crear el JSON de datos térmicos
 #include <vector>            // Requerido para std::vector (construcción del payload)
 #include <math.h>            // Requerido para INFINITY, NAN, isnan
+#include "VegetationIndex.h"   // VegetationStats (índices de la imagen, opcional)
 
 /**
  * @class MultipartDataSender
@@ -40,6 +41,7 @@ public:
      * "timestamp" y el array de "temperatures".
      * 2. 'image' (tipo image/jpeg): Contiene los datos binarios de la imagen JPEG.
      * (Esta parte es opcional; si jpegImage es null, no se incluye).
+     * Si se pasan índices de vegetación válidos, el JSON incluye el objeto "vegetation".
      *
      * @param fullCaptureDataUrl URL completa (String) del endpoint de la API.
      * @param accessToken Token de acceso (String) para la cabecera `Authorization`.
@@ -47,6 +49,7 @@ public:
      * @param thermalData Puntero al array (float[768]) de lecturas térmicas.
      * @param jpegImage Puntero al buffer (uint8_t*) de la imagen JPEG. (Opcional, puede ser nullptr).
      * @param jpegLength Tamaño (size_t) de los datos de la imagen JPEG. (Ignorado si jpegImage es nullptr).
+     * @param vegetation Índices de vegetación de la imagen (Opcional, puede ser nullptr).
      *
      * @return El código de estado HTTP del servidor. Retorna un valor negativo
      * si ocurre un error del lado del cliente (ej. -11, -12, -13, etc.).
@@ -57,19 +60,32 @@ public:
         const String& timestamp,
         float* thermalData,
         uint8_t* jpegImage,
-        size_t jpegLength
+        size_t jpegLength,
+        const VegetationStats* vegetation = nullptr
     );
 
     /**
      * @brief Crea un string JSON con estadísticas térmicas y el array de datos crudos.
      * @param timestamp Timestamp (String) ISO 8601.
      * @param thermalData Puntero al array (float[768]) de temperaturas.
+     * @param vegetation Índices de vegetación (Opcional). Si son válidos se añade el objeto
+     * "vegetation" con exg, exgr, canopy_fraction, width y height, y dentro "canopy_thermal"
+     * (max_temp, min_temp, avg_temp, pixels, covered_pixels) si hay estadísticas del dosel.
      * @return String con el JSON formateado. Retorna String vacío si falla el cálculo o la serialización.
      */
-    static String createThermalJson(const String& timestamp, float* thermalData);
+    static String createThermalJson(const String& timestamp, float* thermalData, const VegetationStats* vegetation = nullptr);
+
+    /**
+     * @brief Lee el objeto "vegetation" de un JSON creado por `createThermalJson`.
+     * @param doc Documento JSON ya deserializado.
+     * @param[out] vegetation Índices leídos (valid = false si el JSON no los tiene).
+     * @return True si el JSON tenía índices de vegetación.
+     */
+    static bool readVegetationJson(JsonDocument& doc, VegetationStats& vegetation);
 
 
     // --- Funciones de Ayuda (Helpers) para Cálculo de Datos Térmicos ---
+    // (Envoltorios de lib/ThermalStats sobre los 768 píxeles; el cálculo también compila en el host)
 
     /**
      * @brief Calcula la temperatura máxima del array de datos térmicos.
@@ -96,6 +112,7 @@ public:
     static float calculateAverageTemperature(float* thermalData);
 
 private:
+    friend struct BenchmarkAccess; ///< (Solo test/test_benchmarks) acceso a los helpers privados
 
     /**
      * @brief Construye el payload completo (multipart/form-data) como un vector de bytes.
@@ -4,36 +4,28 @@
  */
 #include "OV2640Sensor.h"
 #include "esp_camera.h"   // Header principal del driver de cámara de ESP-IDF
+#include "Trace.h"        // Instrumentación de trazas (no-op sin ENABLE_TRACE)
+#include "SensorTrace.h"  // Grabación/reproducción de capturas (no-op sin ENABLE_SENSOR_TRACE)
+#include "BoardProfile.h" // Pines de la cámara del perfil de placa (Board::CAM_*)
+#include "driver/ledc.h"  // Pausa del XCLK en reposo
 
-// --- Configuración de Pines Hardware ---
-// Definición de pines para la placa ESP32-S3 específica del proyecto.
-// ¡Modificar estos pines según las conexiones de hardware específicas!
-#define PWDN_GPIO_NUM     -1 ///< Pin Power Down (-1 = no usado).
-#define RESET_GPIO_NUM    -1 ///< Pin Reset (-1 = no usado).
-#define XCLK_GPIO_NUM     15 ///< Pin de Reloj Externo (XCLK).
-#define SIOD_GPIO_NUM     4  ///< Pin de Datos SCCB (I2C) (SIOD).
-#define SIOC_GPIO_NUM     5  ///< Pin de Reloj SCCB (I2C) (SIOC).
-
-// Pines de Datos de la Cámara (Interfaz paralela de 8 bits)
-#define Y9_GPIO_NUM       16 ///< Pin de Bus de Datos 7 (Y9/D7).
-#define Y8_GPIO_NUM       17 ///< Pin de Bus de Datos 6 (Y8/D6).
-#define Y7_GPIO_NUM       18 ///< Pin de Bus de Datos 5 (Y7/D5).
-#define Y6_GPIO_NUM       12 ///< Pin de Bus de Datos 4 (Y6/D4).
-#define Y5_GPIO_NUM       10 ///< Pin de Bus de Datos 3 (Y5/D3).
-#define Y4_GPIO_NUM       8  ///< Pin de Bus de Datos 2 (Y4/D2).
-#define Y3_GPIO_NUM       9  ///< Pin de Bus de Datos 1 (Y3/D1).
-#define Y2_GPIO_NUM       11 ///< Pin de Bus de Datos 0 (Y2/D0).
-
-// Pines de Sincronización de la Cámara
-#define VSYNC_GPIO_NUM    6  ///< Pin de Sincronización Vertical (VSYNC).
-#define HREF_GPIO_NUM     7  ///< Pin de Referencia Horizontal (HREF).
-#define PCLK_GPIO_NUM     13 ///< Pin de Reloj de Píxel (PCLK).
-// --------------------------------
+// XCLK generado por LEDC (el ESP32-S3 solo tiene LEDC de baja velocidad)
+#define XCLK_LEDC_TIMER   LEDC_TIMER_0
+#define XCLK_LEDC_CHANNEL LEDC_CHANNEL_0
+
+// Registro COM2 (0x09) del banco del sensor: en set_reg() el bit 8 selecciona ese banco.
+// Bit 4 = standby: el sensor deja de convertir y conserva sus registros.
+#define OV2640_REG_COM2      0x109
+#define OV2640_COM2_STANDBY  0x10
+
+// Fotogramas descartados al despertar: el primero puede ser de antes del reposo
+// (CAMERA_GRAB_WHEN_EMPTY) y la exposición automática necesita unos pocos para ajustarse.
+#define WAKE_DISCARD_FRAMES  3
 
 /**
  * @brief Constructor por defecto.
  */
-OV2640Sensor::OV2640Sensor() {
+OV2640Sensor::OV2640Sensor() : _powerState(SensorPowerState::OFF) {
     // Intencionalmente vacío. La inicialización ocurre en begin().
 }
 
@@ -41,33 +33,39 @@ OV2640Sensor::OV2640Sensor() {
  * @brief Inicializa el hardware y el driver de la cámara.
  */
 bool OV2640Sensor::begin() {
+    // En reproducción las capturas vienen de la traza: no se inicializa la cámara
+    if (SENSOR_TRACE_REPLAYING()) {
+        _powerState = SensorPowerState::ACTIVE;
+        return true;
+    }
+
     // Estructura de configuración requerida por esp_camera_init.
     camera_config_t config;
 
     // --- Configuración de Pines ---
-    config.pin_pwdn = PWDN_GPIO_NUM;
-    config.pin_reset = RESET_GPIO_NUM;
-    config.pin_xclk = XCLK_GPIO_NUM;
-    config.pin_sccb_sda = SIOD_GPIO_NUM;
-    config.pin_sccb_scl = SIOC_GPIO_NUM;
-
-    config.pin_d0 = Y2_GPIO_NUM;
-    config.pin_d1 = Y3_GPIO_NUM;
-    config.pin_d2 = Y4_GPIO_NUM;
-    config.pin_d3 = Y5_GPIO_NUM;
-    config.pin_d4 = Y6_GPIO_NUM;
-    config.pin_d5 = Y7_GPIO_NUM;
-    config.pin_d6 = Y8_GPIO_NUM;
-    config.pin_d7 = Y9_GPIO_NUM;
-
-    config.pin_vsync = VSYNC_GPIO_NUM;
-    config.pin_href = HREF_GPIO_NUM;
-    config.pin_pclk = PCLK_GPIO_NUM;
+    config.pin_pwdn = Board::CAM_PWDN_PIN;
+    config.pin_reset = Board::CAM_RESET_PIN;
+    config.pin_xclk = Board::CAM_XCLK_PIN;
+    config.pin_sccb_sda = Board::CAM_SIOD_PIN;
+    config.pin_sccb_scl = Board::CAM_SIOC_PIN;
+
+    config.pin_d0 = Board::CAM_Y2_PIN;
+    config.pin_d1 = Board::CAM_Y3_PIN;
+    config.pin_d2 = Board::CAM_Y4_PIN;
+    config.pin_d3 = Board::CAM_Y5_PIN;
+    config.pin_d4 = Board::CAM_Y6_PIN;
+    config.pin_d5 = Board::CAM_Y7_PIN;
+    config.pin_d6 = Board::CAM_Y8_PIN;
+    config.pin_d7 = Board::CAM_Y9_PIN;
+
+    config.pin_vsync = Board::CAM_VSYNC_PIN;
+    config.pin_href = Board::CAM_HREF_PIN;
+    config.pin_pclk = Board::CAM_PCLK_PIN;
 
     // --- Configuración de Reloj, Formato, Tamaño y Buffers ---
     config.xclk_freq_hz = 20000000;       // Frecuencia del reloj externo (ej. 20MHz).
-    config.ledc_channel = LEDC_CHANNEL_0; // Canal LEDC para generar XCLK.
-    config.ledc_timer = LEDC_TIMER_0;     // Timer LEDC para XCLK.
+    config.ledc_channel = XCLK_LEDC_CHANNEL; // Canal LEDC para generar XCLK.
+    config.ledc_timer = XCLK_LEDC_TIMER;     // Timer LEDC para XCLK (se pausa en reposo).
 
     config.pixel_format = PIXFORMAT_JPEG; // Formato de píxel deseado (JPEG para uso directo).
     config.frame_size = FRAMESIZE_VGA;    // Tamaño del fotograma (640x480).
@@ -89,6 +87,64 @@ bool OV2640Sensor::begin() {
 
     // Cámara inicializada exitosamente.
     // (Opcional: configurar brillo, contraste, etc. aquí).
+    _powerState = SensorPowerState::ACTIVE;
+    return true;
+}
+
+/**
+ * @brief Standby por registro + XCLK detenido, o driver liberado (OFF).
+ */
+bool OV2640Sensor::setPowerState(SensorPowerState state) {
+    if (SENSOR_TRACE_REPLAYING()) {
+        _powerState = state;
+        return true;
+    }
+    if (state == _powerState) return true;
+
+    if (state == SensorPowerState::OFF) {
+        end();
+        if (Board::CAM_PWDN_PIN >= 0) {
+            pinMode(Board::CAM_PWDN_PIN, OUTPUT);
+            digitalWrite(Board::CAM_PWDN_PIN, HIGH); // esp_camera_init lo vuelve a bajar
+        }
+        return true;
+    }
+
+    // Desde OFF hay que volver a inicializar el driver (también para pasar a STANDBY)
+    if (_powerState == SensorPowerState::OFF) {
+        if (!begin()) return false;
+        if (state == SensorPowerState::ACTIVE) return discardWakeFrames();
+    }
+
+    sensor_t *s = esp_camera_sensor_get();
+    if (!s) return false;
+
+    if (state == SensorPowerState::STANDBY) {
+        // El SCCB necesita el XCLK: primero el registro, después se detiene el reloj
+        if (s->set_reg(s, OV2640_REG_COM2, OV2640_COM2_STANDBY, OV2640_COM2_STANDBY) < 0) return false;
+        ledc_timer_pause(LEDC_LOW_SPEED_MODE, XCLK_LEDC_TIMER);
+        _powerState = SensorPowerState::STANDBY;
+        return true;
+    }
+
+    // STANDBY -> ACTIVE
+    ledc_timer_resume(LEDC_LOW_SPEED_MODE, XCLK_LEDC_TIMER);
+    if (s->set_reg(s, OV2640_REG_COM2, OV2640_COM2_STANDBY, 0) < 0) return false;
+    _powerState = SensorPowerState::ACTIVE;
+    return discardWakeFrames();
+}
+
+bool OV2640Sensor::discardWakeFrames() {
+    for (int i = 0; i < WAKE_DISCARD_FRAMES; i++) {
+        camera_fb_t *fb = esp_camera_fb_get();
+        if (!fb) {
+#ifdef ENABLE_DEBUG_SERIAL
+            Serial.println("[OV2640Sensor] ERROR: No frame after waking the camera.");
+#endif
+            return false;
+        }
+        esp_camera_fb_return(fb);
+    }
     return true;
 }
 
@@ -99,12 +155,28 @@ uint8_t* OV2640Sensor::captureJPEG(size_t &length) {
     // Reinicia el parámetro de salida 'length'.
     length = 0;
 
+    // En reproducción se devuelve la siguiente captura grabada (mismo contrato: buffer en PSRAM)
+    if (SENSOR_TRACE_REPLAYING()) {
+        return SensorTrace::replayJpeg(length);
+    }
+
+    // En reposo no llegan fotogramas: esp_camera_fb_get() solo esperaría a su timeout
+    if (_powerState != SensorPowerState::ACTIVE) {
+#ifdef ENABLE_DEBUG_SERIAL
+        Serial.println("[OV2640Sensor] Capture requested while the camera is not active.");
+#endif
+        return nullptr;
+    }
+
     // 1. Adquirir un framebuffer del driver que contiene la imagen capturada.
+    TRACE_BEGIN(CAMERA_CAPTURE);
     camera_fb_t *fb = esp_camera_fb_get();
+    TRACE_END(CAMERA_CAPTURE);
     if (!fb) {
 #ifdef ENABLE_DEBUG_SERIAL
         Serial.println("[OV2640Sensor] CRITICAL: esp_camera_fb_get() returned NULL!");
 #endif
+        SENSOR_TRACE_RECORD(recordJpeg(nullptr, 0));
         return nullptr; // Falla al obtener el frame.
     }
 
@@ -139,6 +211,7 @@ uint8_t* OV2640Sensor::captureJPEG(size_t &length) {
     // 5. Retornar el framebuffer *original* del driver para que pueda ser reutilizado.
     // Esto es absolutamente crítico; si no se hace, el driver se quedará sin buffers.
     esp_camera_fb_return(fb);
+    SENSOR_TRACE_RECORD(recordJpeg(jpegData, length));
 
     // 6. Retornar el puntero a nuestra *copia* de los datos JPEG en PSRAM.
     // El llamador (caller) es ahora responsable de esta memoria.
@@ -149,6 +222,9 @@ uint8_t* OV2640Sensor::captureJPEG(size_t &length) {
  * @brief Desinicializa el driver de la cámara, liberando recursos.
  */
 void OV2640Sensor::end() {
+    _powerState = SensorPowerState::OFF;
+    if (SENSOR_TRACE_REPLAYING()) return; // La cámara no se inicializó
+
     // Llama a la función de ESP-IDF para apagar correctamente el driver
     // y liberar los recursos hardware (I2S, DMA, pines de cámara).
     esp_camera_deinit();
@@ -4,8 +4,8 @@
  * usando el driver ESP-IDF.
  *
  * Proporciona métodos para inicializar la cámara (con pines predefinidos
- * para la placa ESP32-S3 del proyecto), capturar imágenes JPEG y
- * desinicializar la cámara para liberar recursos.
+ * para la placa ESP32-S3 del proyecto), capturar imágenes JPEG, dormirla
+ * entre ciclos y desinicializarla para liberar recursos.
  */
 #ifndef OV2640SENSOR_H
 #define OV2640SENSOR_H
@@ -13,6 +13,7 @@
 #include <Arduino.h>  
 // Requerido para funciones de alocación de memoria (ej. ps_malloc en PSRAM)
 #include "esp_heap_caps.h"   
+#include "SensorPower.h"     // SensorPowerState
 
 /**
  * @class OV2640Sensor
@@ -60,10 +61,26 @@ public:
      * contiene los datos JPEG.
      * **El llamador (caller) es responsable de liberar esta memoria**
      * usando `free()` (o `ps_free()`) cuando ya no la necesite.
-     * Retorna `nullptr` si la captura o la alocación de memoria fallan.
+     * Retorna `nullptr` si la captura o la alocación de memoria fallan, o si la
+     * cámara no está en ACTIVE.
      */
     uint8_t* captureJPEG(size_t &length);
 
+    /**
+     * @brief Cambia el estado de energía entre ciclos.
+     *
+     * - STANDBY: bit de standby del registro COM2 del sensor y XCLK detenido; el
+     *   driver y sus buffers se conservan.
+     * - OFF: `end()` (libera DMA y buffers) y, si el perfil tiene pin PWDN, lo activa.
+     * - ACTIVE: deshace lo anterior (desde OFF con `begin()`) y descarta los primeros
+     *   fotogramas mientras se ajusta la exposición; vuelve cuando la cámara ya da
+     *   imágenes válidas.
+     *
+     * @return false si el sensor no respondió o no llegaron fotogramas al despertar.
+     */
+    bool setPowerState(SensorPowerState state);
+    SensorPowerState powerState() const { return _powerState; }
+
     /**
      * @brief Desinicializa el driver de la cámara y libera los recursos hardware.
      *
@@ -74,8 +91,15 @@ public:
     void end();
 
 private:
+    /**
+     * @brief Obtiene y devuelve al driver los fotogramas de después de despertar.
+     * @return false si alguno no llegó (timeout del driver).
+     */
+    bool discardWakeFrames();
+
     // La configuración y estado de la cámara son gestionados internamente
     // por las funciones del driver ESP-IDF (esp_camera).
+    SensorPowerState _powerState; ///< OFF hasta begin() y tras end().
 };
 
 #endif // OV2640SENSOR_H
\ No newline at end of file
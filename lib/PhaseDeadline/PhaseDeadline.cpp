@@ -0,0 +1,121 @@
+#include "PhaseDeadline.h"
+#include <stdio.h>
+
+#ifdef ARDUINO
+    #include <Arduino.h> // millis()
+#else
+    #include <chrono>
+#endif
+
+// Nombres de DeadlinePhase (mismo orden que el enum) para los logs
+static const char* const PHASE_NAMES[] = { "ENVIRONMENT", "IMAGE", "UPLOAD", "DRAIN", "MAINTENANCE" };
+static_assert(sizeof(PHASE_NAMES) / sizeof(PHASE_NAMES[0]) == (size_t)DeadlinePhase::COUNT,
+              "PHASE_NAMES must match DeadlinePhase");
+
+#define PHASE_COUNT ((size_t)DeadlinePhase::COUNT)
+
+uint32_t PhaseDeadline::_budgets[PHASE_COUNT] = {0};
+PhaseDeadline::Frame PhaseDeadline::_stack[PHASE_DEADLINE_MAX_DEPTH];
+uint8_t PhaseDeadline::_depth = 0;
+PhaseOverrun PhaseDeadline::_overruns[PHASE_DEADLINE_MAX_OVERRUNS];
+uint8_t PhaseDeadline::_overrunCount = 0;
+uint32_t PhaseDeadline::_totalOverruns[PHASE_COUNT] = {0};
+uint32_t (*PhaseDeadline::_clock)() = nullptr;
+
+uint32_t PhaseDeadline::_now() {
+    if (_clock) return _clock();
+#ifdef ARDUINO
+    return millis();
+#else
+    using namespace std::chrono;
+    return (uint32_t)duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void PhaseDeadline::setClock(uint32_t (*clock)()) {
+    _clock = clock;
+}
+
+void PhaseDeadline::setBudget(DeadlinePhase phase, uint32_t budgetMs) {
+    if ((size_t)phase < PHASE_COUNT) _budgets[(size_t)phase] = budgetMs;
+}
+
+uint32_t PhaseDeadline::budget(DeadlinePhase phase) {
+    return (size_t)phase < PHASE_COUNT ? _budgets[(size_t)phase] : 0;
+}
+
+bool PhaseDeadline::begin(DeadlinePhase phase) {
+    if (_depth >= PHASE_DEADLINE_MAX_DEPTH || (size_t)phase >= PHASE_COUNT) return false;
+    Frame& frame = _stack[_depth++];
+    frame.phase = phase;
+    frame.startMs = _now();
+    frame.budgetMs = _budgets[(size_t)phase];
+    return true;
+}
+
+bool PhaseDeadline::end() {
+    if (_depth == 0) return false;
+    const Frame& frame = _stack[--_depth];
+    uint32_t elapsed = _now() - frame.startMs;
+    if (frame.budgetMs == 0 || elapsed <= frame.budgetMs) return false;
+
+    _totalOverruns[(size_t)frame.phase]++;
+    if (_overrunCount < PHASE_DEADLINE_MAX_OVERRUNS) {
+        PhaseOverrun& overrun = _overruns[_overrunCount++];
+        overrun.phase = frame.phase;
+        overrun.elapsedMs = elapsed;
+        overrun.budgetMs = frame.budgetMs;
+    }
+    return true;
+}
+
+uint32_t PhaseDeadline::remainingMs() {
+    uint32_t now = _now();
+    uint32_t remaining = UINT32_MAX;
+    for (uint8_t i = 0; i < _depth; i++) {
+        const Frame& frame = _stack[i];
+        if (frame.budgetMs == 0) continue;
+        uint32_t elapsed = now - frame.startMs; // Aritmética sin signo: válida tras el desborde de millis()
+        uint32_t left = elapsed >= frame.budgetMs ? 0 : frame.budgetMs - elapsed;
+        if (left < remaining) remaining = left;
+    }
+    return remaining;
+}
+
+bool PhaseDeadline::expired() {
+    return remainingMs() == 0;
+}
+
+uint32_t PhaseDeadline::boundTimeout(uint32_t timeoutMs) {
+    uint32_t remaining = remainingMs();
+    if (remaining == UINT32_MAX) return timeoutMs;
+    if (remaining < PHASE_DEADLINE_MIN_IO_MS) remaining = PHASE_DEADLINE_MIN_IO_MS;
+    return remaining < timeoutMs ? remaining : timeoutMs;
+}
+
+DeadlinePhase PhaseDeadline::currentPhase() {
+    return _depth > 0 ? _stack[_depth - 1].phase : DeadlinePhase::COUNT;
+}
+
+const char* PhaseDeadline::phaseName(DeadlinePhase phase) {
+    return (size_t)phase < PHASE_COUNT ? PHASE_NAMES[(size_t)phase] : "NONE";
+}
+
+size_t PhaseDeadline::describeOverruns(char* out, size_t outSize) {
+    if (outSize == 0) return 0;
+    out[0] = '\0';
+    size_t length = 0;
+    for (uint8_t i = 0; i < _overrunCount && length < outSize; i++) {
+        const PhaseOverrun& overrun = _overruns[i];
+        int written = snprintf(out + length, outSize - length, "%s%s %lu/%lu ms", i > 0 ? ", " : "",
+                               PHASE_NAMES[(size_t)overrun.phase], (unsigned long)overrun.elapsedMs, (unsigned long)overrun.budgetMs);
+        if (written < 0) break;
+        length += (size_t)written;
+    }
+    return length < outSize ? length : outSize - 1;
+}
+
+void PhaseDeadline::resetCycle() {
+    _depth = 0;
+    _overrunCount = 0;
+}
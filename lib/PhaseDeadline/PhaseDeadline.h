@@ -0,0 +1,139 @@
+#ifndef PHASE_DEADLINE_H
+#define PHASE_DEADLINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Sin dependencias de Arduino: el reloj es millis() en el dispositivo y se puede
+// sustituir (setClock) para probar los plazos sin esperar.
+
+#define PHASE_DEADLINE_MAX_DEPTH   4       // Fases anidadas como máximo (p. ej. IMAGE > UPLOAD)
+#define PHASE_DEADLINE_MAX_OVERRUNS 8      // Excesos guardados por ciclo
+#define PHASE_DEADLINE_MIN_IO_MS   1000    // Timeout mínimo de una operación de red acotada
+
+/**
+ * @brief Fases del ciclo con plazo propio.
+ */
+enum class DeadlinePhase : uint8_t {
+    ENVIRONMENT,    ///< Lectura y envío de datos ambientales
+    IMAGE,          ///< Captura, análisis, envío y guardado de imágenes
+    UPLOAD,         ///< Un envío (con su reintento tras 401), anidado en ENVIRONMENT o IMAGE
+    DRAIN,          ///< Vaciado de la cola de pendientes
+    MAINTENANCE,    ///< Migración del nivel rápido, compactación y limpieza de la SD
+    COUNT
+};
+
+/**
+ * @brief Una fase que terminó después de su plazo.
+ */
+struct PhaseOverrun {
+    DeadlinePhase phase;
+    uint32_t elapsedMs;
+    uint32_t budgetMs;
+};
+
+/**
+ * @class PhaseDeadline
+ * @brief Clase de utilidad (estática) con el plazo de la fase en curso y cancelación
+ * cooperativa.
+ *
+ * main.cpp abre cada fase con begin() y la cierra con end(); el plazo efectivo es el
+ * más cercano de las fases abiertas. El código de la fase no se interrumpe: consulta
+ * expired() entre pasos (submuestras del MLX90640, archivos de la cola, reintentos) y,
+ * si el plazo venció, deja de empezar trabajo nuevo y sigue su camino de limpieza
+ * (los datos no enviados van a pendientes, los buffers se liberan como siempre). Las
+ * operaciones de red acotan su timeout con boundTimeout() y no empiezan si ya venció.
+ * Las fases que terminan pasado su plazo se guardan para el log de fin de ciclo.
+ */
+class PhaseDeadline {
+public:
+    /**
+     * @brief Plazo de una fase (0 = sin límite). Se aplica en el siguiente begin().
+     */
+    static void setBudget(DeadlinePhase phase, uint32_t budgetMs);
+    static uint32_t budget(DeadlinePhase phase);
+
+    /**
+     * @brief Abre una fase (anidada si ya hay otra abierta).
+     * @return False si se superó PHASE_DEADLINE_MAX_DEPTH (la fase no se abre).
+     */
+    static bool begin(DeadlinePhase phase);
+
+    /**
+     * @brief Cierra la fase más interna.
+     * @return True si terminó pasado su plazo (queda registrado en overrun()).
+     */
+    static bool end();
+
+    /**
+     * @brief Punto de cancelación: true si venció el plazo de alguna fase abierta.
+     */
+    static bool expired();
+
+    /**
+     * @brief Milisegundos hasta el plazo más cercano (UINT32_MAX si no hay ninguno).
+     */
+    static uint32_t remainingMs();
+
+    /**
+     * @brief Timeout de una operación bloqueante acotado al tiempo que queda, con un
+     * mínimo de PHASE_DEADLINE_MIN_IO_MS. Sin plazo, devuelve timeoutMs tal cual.
+     */
+    static uint32_t boundTimeout(uint32_t timeoutMs);
+
+    static bool isActive() { return _depth > 0; }
+    static DeadlinePhase currentPhase();
+    static const char* phaseName(DeadlinePhase phase);
+
+    // --- Excesos (se vacían con resetCycle() al empezar cada ciclo) ---
+    static uint8_t overrunCount() { return _overrunCount; }
+    static const PhaseOverrun& overrun(uint8_t index) { return _overruns[index]; }
+    /// Excesos de una fase desde el arranque.
+    static uint32_t totalOverruns(DeadlinePhase phase) { return _totalOverruns[(size_t)phase]; }
+    /**
+     * @brief Describe los excesos del ciclo, ej. "IMAGE 131200/120000 ms, UPLOAD 52010/45000 ms".
+     * @return Longitud escrita (0 si no hubo excesos).
+     */
+    static size_t describeOverruns(char* out, size_t outSize);
+    /**
+     * @brief Cierra las fases que quedaran abiertas y vacía los excesos del ciclo.
+     */
+    static void resetCycle();
+
+    /**
+     * @brief (Tests) Sustituye el reloj en milisegundos (nullptr = millis()).
+     */
+    static void setClock(uint32_t (*clock)());
+
+private:
+    struct Frame {
+        DeadlinePhase phase;
+        uint32_t startMs;
+        uint32_t budgetMs;  // 0 = sin límite
+    };
+
+    static uint32_t _budgets[(size_t)DeadlinePhase::COUNT];
+    static Frame _stack[PHASE_DEADLINE_MAX_DEPTH];
+    static uint8_t _depth;
+    static PhaseOverrun _overruns[PHASE_DEADLINE_MAX_OVERRUNS];
+    static uint8_t _overrunCount;
+    static uint32_t _totalOverruns[(size_t)DeadlinePhase::COUNT];
+    static uint32_t (*_clock)();
+
+    static uint32_t _now();
+};
+
+/**
+ * @brief Abre una fase en el constructor y la cierra en el destructor.
+ */
+class PhaseDeadlineScope {
+public:
+    explicit PhaseDeadlineScope(DeadlinePhase phase) : _open(PhaseDeadline::begin(phase)) {}
+    ~PhaseDeadlineScope() { if (_open) PhaseDeadline::end(); }
+    PhaseDeadlineScope(const PhaseDeadlineScope&) = delete;
+    PhaseDeadlineScope& operator=(const PhaseDeadlineScope&) = delete;
+private:
+    bool _open;
+};
+
+#endif // PHASE_DEADLINE_H
@@ -0,0 +1,113 @@
+#include "ResumeCheckpoint.h"
+#include <esp_attr.h>       // RTC_NOINIT_ATTR
+#include <esp_rom_crc.h>    // CRC-32 de la ROM
+#include <stddef.h>         // offsetof
+#include <string.h>
+
+#define CHECKPOINT_MAX_CONSECUTIVE_RESUMES 3   // Más reinicios seguidos sin cerrar un ciclo: arranque en frío
+#define CHECKPOINT_MIN_VALID_EPOCH 1577836800  // 2020-01-01: por debajo el RTC no tiene hora
+
+// Memoria RTC lenta: sobrevive a watchdog, pánico, brownout y ESP.restart(), no a un corte de alimentación
+RTC_NOINIT_ATTR CheckpointData ResumeCheckpoint::_data;
+bool ResumeCheckpoint::_resumed = false;
+esp_reset_reason_t ResumeCheckpoint::_resetReason = ESP_RST_UNKNOWN;
+CyclePhase ResumeCheckpoint::_interruptedPhase = CyclePhase::SETUP;
+
+uint32_t ResumeCheckpoint::_crc(const CheckpointData& data) {
+    return esp_rom_crc32_le(0, (const uint8_t*)&data, offsetof(CheckpointData, crc));
+}
+
+void ResumeCheckpoint::seal(CheckpointData& data) {
+    data.magic = CHECKPOINT_MAGIC;
+    data.version = CHECKPOINT_VERSION;
+    data.size = sizeof(CheckpointData);
+    data.crc = _crc(data);
+}
+
+bool ResumeCheckpoint::isValid(const CheckpointData& data) {
+    return data.magic == CHECKPOINT_MAGIC && data.version == CHECKPOINT_VERSION &&
+           data.size == sizeof(CheckpointData) && data.crc == _crc(data);
+}
+
+void ResumeCheckpoint::_reset(uint32_t restoreFailures) {
+    memset(&_data, 0, sizeof(_data));
+    _data.restoreFailures = restoreFailures;
+    _data.phase = (uint8_t)CyclePhase::SETUP;
+    seal(_data);
+}
+
+bool ResumeCheckpoint::begin(esp_reset_reason_t reason) {
+    _resetReason = reason;
+    _resumed = false;
+
+    // Tras un encendido la memoria RTC tiene basura: ni siquiera se cuentan los fallos
+    if (reason == ESP_RST_POWERON || reason == ESP_RST_UNKNOWN || !isValid(_data)) {
+        bool wasGarbage = reason == ESP_RST_POWERON || reason == ESP_RST_UNKNOWN || _data.magic != CHECKPOINT_MAGIC;
+        _reset(wasGarbage ? 0 : _data.restoreFailures + 1);
+        return false;
+    }
+
+    // Checkpoint íntegro: descartarlo si es viejo o si el ciclo se repite reiniciando en la misma fase
+    time_t now = time(nullptr);
+    bool stale = now >= CHECKPOINT_MIN_VALID_EPOCH && _data.savedEpoch > 0 && now - _data.savedEpoch > CHECKPOINT_MAX_AGE_S;
+    if (stale || _data.consecutiveResumes >= CHECKPOINT_MAX_CONSECUTIVE_RESUMES) {
+        _reset(_data.restoreFailures + 1);
+        return false;
+    }
+
+    _interruptedPhase = (CyclePhase)_data.phase;
+    _data.consecutiveResumes++;
+    _data.resumes++;
+    seal(_data);
+    _resumed = true;
+    return true;
+}
+
+void ResumeCheckpoint::save(CyclePhase phase) {
+    time_t now = time(nullptr);
+    _data.savedEpoch = now >= CHECKPOINT_MIN_VALID_EPOCH ? (int64_t)now : 0;
+    _data.phase = (uint8_t)phase;
+    _data.sequence++;
+    if (phase == CyclePhase::IDLE) _data.consecutiveResumes = 0; // Ciclo completo: el reinicio no se repite
+    seal(_data);
+}
+
+void ResumeCheckpoint::markResumed() {
+    _data.lastResumeMs = millis();
+    seal(_data);
+}
+
+bool ResumeCheckpoint::rtcTimeTrusted(time_t now) {
+    if (!_resumed || now < CHECKPOINT_MIN_VALID_EPOCH) return false;
+    if (_data.savedEpoch <= 0 || _data.lastNtpSyncEpoch <= 0) return false;
+    if (now < _data.savedEpoch || now - _data.savedEpoch > CHECKPOINT_MAX_AGE_S) return false; // El RTC retrocedió o saltó
+    return now - _data.lastNtpSyncEpoch <= CHECKPOINT_NTP_TRUST_S;
+}
+
+const char* ResumeCheckpoint::phaseName(CyclePhase phase) {
+    switch (phase) {
+        case CyclePhase::SETUP: return "setup";
+        case CyclePhase::IDLE: return "idle";
+        case CyclePhase::AUTH: return "auth";
+        case CyclePhase::ENVIRONMENT: return "environment";
+        case CyclePhase::IMAGE: return "image";
+        case CyclePhase::MAINTENANCE: return "maintenance";
+    }
+    return "unknown";
+}
+
+const char* ResumeCheckpoint::resetReasonName(esp_reset_reason_t reason) {
+    switch (reason) {
+        case ESP_RST_POWERON: return "poweron";
+        case ESP_RST_EXT: return "external";
+        case ESP_RST_SW: return "software";
+        case ESP_RST_PANIC: return "panic";
+        case ESP_RST_INT_WDT: return "int_wdt";
+        case ESP_RST_TASK_WDT: return "task_wdt";
+        case ESP_RST_WDT: return "wdt";
+        case ESP_RST_DEEPSLEEP: return "deepsleep";
+        case ESP_RST_BROWNOUT: return "brownout";
+        case ESP_RST_SDIO: return "sdio";
+        default: return "unknown";
+    }
+}
@@ -0,0 +1,115 @@
+#ifndef RESUME_CHECKPOINT_H
+#define RESUME_CHECKPOINT_H
+
+#include <Arduino.h>
+#include <time.h>
+#include "esp_system.h"  // esp_reset_reason_t
+
+#define CHECKPOINT_MAGIC 0x52435031         // "RCP1"
+#define CHECKPOINT_VERSION 1
+#define CHECKPOINT_MAX_AGE_S 7200           // Un checkpoint más viejo no se usa (el RTC pudo derivar o reiniciarse)
+#define CHECKPOINT_NTP_TRUST_S 21600        // Hora del RTC fiable hasta 6 h después de la última sincronización NTP
+
+/**
+ * @brief Fase del ciclo en la que se escribió el checkpoint (la última frontera cruzada).
+ */
+enum class CyclePhase : uint8_t {
+    SETUP,          ///< Arranque en curso
+    IDLE,           ///< Ciclo terminado, esperando al siguiente
+    AUTH,           ///< Comprobación del backend / autenticación
+    ENVIRONMENT,    ///< Tareas ambientales
+    IMAGE,          ///< Captura y envío de imágenes
+    MAINTENANCE     ///< Migración, cola de pendientes y almacenamiento
+};
+
+#define CHECKPOINT_FLAG_SD_WARNING_SENT 0x01  ///< Aviso del 90 % de la SD ya enviado
+
+/**
+ * @brief Contenido del checkpoint (memoria RTC lenta, sin inicializar en el arranque).
+ */
+struct CheckpointData {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;                  ///< sizeof(CheckpointData): cambia si cambia la estructura
+    uint32_t sequence;              ///< Escrituras desde el último arranque en frío
+    uint32_t reserved;              ///< Relleno explícito antes de los int64 (entra en el CRC)
+    int64_t savedEpoch;             ///< Hora del RTC al escribirlo (0 = sin hora)
+    int64_t nextCollectionEpoch;    ///< Próximo ciclo programado
+    int64_t lastNtpSyncEpoch;       ///< Última comprobación NTP correcta
+    uint8_t phase;                  ///< CyclePhase
+    uint8_t flags;                  ///< CHECKPOINT_FLAG_*
+    uint16_t consecutiveResumes;    ///< Reinicios seguidos sin completar un ciclo
+    uint32_t cyclesCompleted;
+    uint32_t resumes;               ///< Reanudaciones correctas desde el arranque en frío
+    uint32_t restoreFailures;       ///< Checkpoints descartados (CRC, versión o antigüedad)
+    uint32_t lastResumeMs;          ///< Tiempo desde el arranque hasta reanudar el calendario
+    uint32_t crc;                   ///< CRC-32 de todo lo anterior
+};
+
+/**
+ * @class ResumeCheckpoint
+ * @brief (Estática) Estado del ciclo en memoria RTC para reanudar tras un reinicio que no
+ * sea de encendido (watchdog, brownout, pánico o ESP.restart()).
+ *
+ * El estado se sella con versión, tamaño y CRC-32 en cada frontera de fase. Al arrancar,
+ * begin() solo lo acepta si el reinicio no fue de encendido (la RTC no conserva nada), el
+ * CRC cuadra y no es más viejo que CHECKPOINT_MAX_AGE_S. Con un checkpoint válido el
+ * arranque restaura el calendario y, si la hora del RTC sigue siendo fiable, no espera a
+ * la sincronización NTP.
+ */
+class ResumeCheckpoint {
+public:
+    /**
+     * @brief Valida el checkpoint del arranque anterior. Llamar al principio de setup().
+     * @param reason Motivo del reinicio (por defecto, el de este arranque).
+     * @return True si hay un checkpoint válido para reanudar.
+     */
+    static bool begin(esp_reset_reason_t reason = esp_reset_reason());
+
+    static bool isResumed() { return _resumed; }
+    static esp_reset_reason_t resetReason() { return _resetReason; }
+    /// Fase en la que estaba el ciclo al reiniciarse (válido si isResumed()).
+    static CyclePhase interruptedPhase() { return _interruptedPhase; }
+
+    /**
+     * @brief Datos para leer o modificar; los cambios se guardan con save().
+     */
+    static CheckpointData& data() { return _data; }
+
+    /**
+     * @brief Marca la fase, la hora actual y sella el checkpoint.
+     */
+    static void save(CyclePhase phase);
+
+    /**
+     * @brief Registra que el calendario se reanudó (tiempo desde el arranque) y sella.
+     */
+    static void markResumed();
+
+    /**
+     * @brief True si la hora del RTC puede usarse sin esperar al NTP: hay checkpoint, la
+     * hora no retrocedió respecto a él y la última sincronización es reciente.
+     */
+    static bool rtcTimeTrusted(time_t now);
+
+    /**
+     * @brief Nombre de la fase y del motivo de reinicio (para logs).
+     */
+    static const char* phaseName(CyclePhase phase);
+    static const char* resetReasonName(esp_reset_reason_t reason);
+
+    // --- Validación (también para los tests) ---
+    static void seal(CheckpointData& data);
+    static bool isValid(const CheckpointData& data);
+
+private:
+    static CheckpointData _data;    // En RTC_NOINIT (ResumeCheckpoint.cpp)
+    static bool _resumed;
+    static esp_reset_reason_t _resetReason;
+    static CyclePhase _interruptedPhase;
+
+    static uint32_t _crc(const CheckpointData& data);
+    static void _reset(uint32_t restoreFailures);
+};
+
+#endif // RESUME_CHECKPOINT_H
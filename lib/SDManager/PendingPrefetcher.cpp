@@ -0,0 +1,183 @@
+#include "PendingPrefetcher.h"
+#include "SDManager.h"
+#include "Trace.h"
+#include "SdIo.h"
+#include <ArduinoJson.h>
+
+#define PENDING_PREFETCH_POLL_MS 50 // Espera máxima por una casilla libre antes de revisar la cancelación
+#define PENDING_DEFAULT_TIMESTAMP "0000-00-00_00:00:00"
+
+PendingPrefetcher::PendingPrefetcher()
+    : _nextJob(0), _freeSlots(nullptr), _readySlots(nullptr), _readerDone(nullptr),
+      _cancel(false), _threaded(false), _finished(true) {}
+
+PendingPrefetcher::~PendingPrefetcher() {
+    end();
+}
+
+bool PendingPrefetcher::begin(const std::vector<String>& jobs) {
+    end();
+    _jobs = jobs;
+    _nextJob = 0;
+    _stats = PendingPrefetchStats();
+    _cancel = false;
+    _finished = false;
+
+    for (int i = 0; i < PENDING_PREFETCH_SLOTS; i++) {
+        _slots[i].thermal = (float*)malloc(MultipartDataSender::THERMAL_PIXELS * sizeof(float));
+        if (!_slots[i].thermal) {
+            end();
+            return false;
+        }
+    }
+
+    // La cola de listos admite todas las casillas más la marca de fin (-1): la lectora nunca se bloquea al publicar
+    _freeSlots = xQueueCreate(PENDING_PREFETCH_SLOTS, sizeof(int));
+    _readySlots = xQueueCreate(PENDING_PREFETCH_SLOTS + 1, sizeof(int));
+    _readerDone = xSemaphoreCreateBinary();
+    if (_freeSlots && _readySlots && _readerDone) {
+        for (int i = 0; i < PENDING_PREFETCH_SLOTS; i++) {
+            xQueueSend(_freeSlots, &i, 0);
+        }
+        _threaded = xTaskCreatePinnedToCore(_taskEntry, "pending_prefetch", PENDING_PREFETCH_TASK_STACK, this,
+                                            PENDING_PREFETCH_TASK_PRIORITY, nullptr, PENDING_PREFETCH_TASK_CORE) == pdPASS;
+    }
+    _stats.threaded = _threaded;
+
+    #ifdef ENABLE_DEBUG_SERIAL
+        if (!_threaded) Serial.println(F("[PendingPrefetcher] Reader task not started. Loading items inline."));
+    #endif
+    return true;
+}
+
+PendingItem* PendingPrefetcher::next() {
+    if (_finished) return nullptr;
+
+    if (!_threaded) {
+        // Sin tarea: se carga en línea en la casilla 0 (mismo resultado, sin solapamiento)
+        if (_nextJob >= _jobs.size()) {
+            _finished = true;
+            return nullptr;
+        }
+        _load(_slots[0], _jobs[_nextJob++]);
+        return &_slots[0];
+    }
+
+    int index = -1;
+    unsigned long waitStart = millis();
+    xQueueReceive(_readySlots, &index, portMAX_DELAY);
+    _stats.waitMs += millis() - waitStart;
+    if (index < 0) {
+        _finished = true;
+        return nullptr;
+    }
+    return &_slots[index];
+}
+
+void PendingPrefetcher::release(PendingItem* item) {
+    if (!_threaded || item == nullptr) return;
+    int index = (int)(item - _slots);
+    xQueueSend(_freeSlots, &index, 0);
+}
+
+void PendingPrefetcher::end() {
+    if (_threaded) {
+        // La lectora revisa _cancel entre elementos: como mucho termina el que está leyendo
+        _cancel = true;
+        xSemaphoreTake(_readerDone, portMAX_DELAY);
+        _threaded = false;
+    }
+    if (_freeSlots) vQueueDelete(_freeSlots);
+    if (_readySlots) vQueueDelete(_readySlots);
+    if (_readerDone) vSemaphoreDelete(_readerDone);
+    _freeSlots = nullptr;
+    _readySlots = nullptr;
+    _readerDone = nullptr;
+
+    for (int i = 0; i < PENDING_PREFETCH_SLOTS; i++) {
+        free(_slots[i].thermal);
+        free(_slots[i].jpeg);
+        free(_slots[i].text);
+        _slots[i] = PendingItem();
+    }
+    _jobs.clear();
+    _finished = true;
+}
+
+void PendingPrefetcher::_taskEntry(void* arg) {
+    static_cast<PendingPrefetcher*>(arg)->_readerLoop();
+}
+
+void PendingPrefetcher::_readerLoop() {
+    while (!_cancel && _nextJob < _jobs.size()) {
+        int index = -1;
+        if (xQueueReceive(_freeSlots, &index, pdMS_TO_TICKS(PENDING_PREFETCH_POLL_MS)) != pdTRUE) continue;
+        if (_cancel) break;
+        _load(_slots[index], _jobs[_nextJob++]);
+        xQueueSend(_readySlots, &index, portMAX_DELAY);
+    }
+
+    int done = -1;
+    xQueueSend(_readySlots, &done, portMAX_DELAY);
+    xSemaphoreGive(_readerDone);
+    vTaskDelete(nullptr);
+}
+
+void PendingPrefetcher::_load(PendingItem& item, const String& path) {
+    TRACE_SCOPE(SD_PREFETCH_ITEM);
+    unsigned long loadStart = millis();
+
+    item.path = path;
+    item.jpegPath = "";
+    item.jpegLength = 0;
+    item.timestamp = PENDING_DEFAULT_TIMESTAMP;
+    item.status = PendingItemStatus::UNREADABLE;
+    String fileName = path.substring(path.lastIndexOf('/') + 1);
+
+    bool readable = SDManager::readRecordInto(path.c_str(), item.text, item.textCapacity, item.textLength);
+    JsonDocument doc;
+    // (const char*: ArduinoJson copia las cadenas y no modifica el buffer)
+    bool parsed = readable && !deserializeJson(doc, (const char*)item.text, item.textLength);
+    if (parsed) item.timestamp = doc["timestamp"] | PENDING_DEFAULT_TIMESTAMP;
+
+    if (!fileName.endsWith("_thermal.json")) {
+        // --- Ambiental ---
+        item.kind = PendingItemKind::AMBIENT;
+        item.name = fileName;
+        if (parsed) {
+            item.light = doc["light"] | NAN;
+            item.temperature = doc["temperature"] | NAN;
+            item.humidity = doc["humidity"] | NAN;
+            item.pressure = doc["pressure"] | NAN;
+            item.samples = doc["samples"] | 1;
+            item.windowEnd = doc["window_end"] | "";
+            item.status = PendingItemStatus::READY;
+        } else if (readable) {
+            item.status = PendingItemStatus::CORRUPTED;
+        }
+    } else {
+        // --- Captura: térmico, con o sin su JPEG ---
+        item.kind = PendingItemKind::CAPTURE;
+        item.name = fileName.substring(0, fileName.indexOf("_thermal.json"));
+        String visualJpgPath = String(CAPTURE_PENDING_DIR) + "/" + item.name + "_visual.jpg";
+        bool thermalOk = parsed && SDManager::readThermalArray(doc, item.thermal);
+        if (parsed) MultipartDataSender::readVegetationJson(doc, item.vegetation);
+        else item.vegetation = VegetationStats();
+        bool hasJpeg;
+        {
+            SdIoGuard ioGuard(SdIoClass::QUEUE); // El parseo JSON, arriba, no retiene la tarjeta
+            hasJpeg = SD_MMC.exists(visualJpgPath.c_str());
+        }
+
+        if (hasJpeg) {
+            item.jpegPath = visualJpgPath;
+            bool jpegOk = SDManager::readRecordInto(visualJpgPath.c_str(), item.jpeg, item.jpegCapacity, item.jpegLength);
+            item.status = (thermalOk && jpegOk) ? PendingItemStatus::READY : PendingItemStatus::CORRUPTED;
+        } else if (readable) {
+            item.status = thermalOk ? PendingItemStatus::READY : PendingItemStatus::CORRUPTED;
+        }
+    }
+
+    _stats.loaded++;
+    _stats.loadMs += millis() - loadStart;
+}
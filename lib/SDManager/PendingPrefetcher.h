@@ -0,0 +1,140 @@
+#ifndef PENDING_PREFETCHER_H
+#define PENDING_PREFETCHER_H
+
+#include <Arduino.h>
+#include <vector>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "VegetationIndex.h"
+
+// --- Pipeline de la cola de pendientes ---
+#define PENDING_PREFETCH_SLOTS 2            // Elementos en vuelo (uno se envía mientras se carga el otro)
+#define PENDING_PREFETCH_TASK_STACK 8192    // Pila de la tarea lectora (parseo JSON con ArduinoJson)
+#define PENDING_PREFETCH_TASK_PRIORITY 1    // Por debajo de WiFi/lwIP; el loop() espera en la red
+#define PENDING_PREFETCH_TASK_CORE 0        // El loop() de Arduino corre en el núcleo 1
+
+/**
+ * @brief Tipo de elemento de la cola de pendientes.
+ */
+enum class PendingItemKind : uint8_t {
+    AMBIENT,  ///< data_pending/ambient/*_env.json
+    CAPTURE   ///< data_pending/capture/*_thermal.json (+ _visual.jpg si existe)
+};
+
+/**
+ * @brief Resultado de la carga de un elemento.
+ */
+enum class PendingItemStatus : uint8_t {
+    READY,       ///< Leído y decodificado, listo para enviar
+    UNREADABLE,  ///< No se pudo leer el JSON (no existe, vacío, registro dañado)
+    CORRUPTED    ///< JSON sin los campos esperados, o JPEG ilegible en un par
+};
+
+/**
+ * @brief Casilla del pipeline: un elemento ya leído de la SD y decodificado.
+ * Los buffers se asignan una vez por vaciado y se reutilizan entre elementos.
+ */
+struct PendingItem {
+    PendingItemKind kind = PendingItemKind::AMBIENT;
+    PendingItemStatus status = PendingItemStatus::UNREADABLE;
+    String path;       ///< JSON (ambiental o térmico)
+    String name;       ///< Ambiental: nombre del archivo. Captura: nombre base ("YYYYMMDD_HHMMSS")
+    String jpegPath;   ///< Captura: ruta del JPEG ("" si el térmico no tiene pareja)
+    String timestamp;
+
+    // Ambiental
+    float light = NAN;
+    float temperature = NAN;
+    float humidity = NAN;
+    float pressure = NAN;
+    int samples = 1;   ///< Lecturas promediadas (> 1 en los resúmenes del backlog)
+    String windowEnd;  ///< Resumen: timestamp de la última lectura promediada
+
+    // Captura
+    float* thermal = nullptr;    ///< 768 píxeles
+    VegetationStats vegetation;  ///< Índices guardados con la captura (valid = false si no tiene)
+    uint8_t* jpeg = nullptr;
+    size_t jpegCapacity = 0;
+    size_t jpegLength = 0;
+
+    uint8_t* text = nullptr;     ///< Contenido del JSON leído
+    size_t textCapacity = 0;
+    size_t textLength = 0;
+};
+
+/**
+ * @brief Tiempos del último vaciado.
+ */
+struct PendingPrefetchStats {
+    uint32_t loaded = 0;     ///< Elementos cargados (incluidos los descartados al cancelar)
+    uint32_t loadMs = 0;     ///< Tiempo total de lectura y decodificación (tarea lectora)
+    uint32_t waitMs = 0;     ///< Tiempo que el emisor esperó a la tarea lectora
+    bool threaded = false;   ///< False si no se pudo crear la tarea (carga en línea)
+};
+
+/**
+ * @class PendingPrefetcher
+ * @brief Pipeline de dos etapas para processPendingApiCalls().
+ *
+ * Una tarea lectora carga y decodifica el elemento N+1 (SD + JSON) en una casilla
+ * preasignada mientras el loop() envía el elemento N (radio), así el vaciado tarda
+ * ~max(tiempo de SD, tiempo de red) por elemento en lugar de la suma. Hay
+ * PENDING_PREFETCH_SLOTS casillas: la lectora se bloquea cuando están todas en uso.
+ * end() cancela la lectura (ej. presupuesto de vaciado agotado) y espera a la tarea;
+ * lo cargado y no enviado se descarta sin tocar los archivos.
+ * Si no se puede crear la tarea, next() carga cada elemento en línea (mismo resultado).
+ */
+class PendingPrefetcher {
+public:
+    PendingPrefetcher();
+    ~PendingPrefetcher();
+
+    /**
+     * @brief Asigna las casillas y arranca la tarea lectora.
+     * @param jobs Rutas a procesar, en orden: ambientales (*_env.json) y térmicos (*_thermal.json).
+     * @return False si no hay memoria para las casillas.
+     */
+    bool begin(const std::vector<String>& jobs);
+
+    /**
+     * @brief Siguiente elemento cargado (espera a la tarea lectora si hace falta).
+     * @return La casilla, o nullptr cuando no quedan elementos.
+     */
+    PendingItem* next();
+
+    /**
+     * @brief Devuelve la casilla a la tarea lectora (llamar tras procesar cada elemento).
+     */
+    void release(PendingItem* item);
+
+    /**
+     * @brief Cancela la lectura pendiente, espera a la tarea y libera las casillas.
+     */
+    void end();
+
+    const PendingPrefetchStats& stats() const { return _stats; }
+
+private:
+    std::vector<String> _jobs;
+    size_t _nextJob;                   // Siguiente trabajo (tarea lectora, o next() en línea)
+    PendingItem _slots[PENDING_PREFETCH_SLOTS];
+    QueueHandle_t _freeSlots;          // Índices de casillas libres (emisor -> lectora)
+    QueueHandle_t _readySlots;         // Índices cargados, -1 al terminar (lectora -> emisor)
+    SemaphoreHandle_t _readerDone;
+    std::atomic<bool> _cancel;
+    bool _threaded;
+    bool _finished;
+    PendingPrefetchStats _stats;
+
+    static void _taskEntry(void* arg);
+    void _readerLoop();
+
+    /**
+     * @brief (Helper) Lee y decodifica un trabajo en una casilla.
+     */
+    void _load(PendingItem& item, const String& path);
+};
+
+#endif // PENDING_PREFETCHER_H
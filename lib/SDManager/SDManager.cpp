@@ -1,29 +1,94 @@
 #include "SDManager.h"
 #include "TimeManager.h" 
+#include "EventLog.h"
+#include "Trace.h"
+#include "PendingPrefetcher.h" // Lectura anticipada de la cola de pendientes
+#include "SdIo.h"             // Turnos de acceso a la tarjeta (loop, portal, lectora de pendientes)
+#include "FaultInjection.h" // Puntos de inyección de fallos (no-op sin ENABLE_FAULT_INJECTION)
+#include "PhaseDeadline.h"  // Cancelación cooperativa entre archivos (vaciado y mantenimiento)
+#include "BoardProfile.h"   // Pines SD_MMC (modo 1-bit) del perfil de placa
+#include "LogFormat.h"       // Formato de las líneas de log (portable al host)
+#include <esp_rom_crc.h>    // CRC-32 de la ROM (cabecera de registros)
 #include <ArduinoJson.h>
 
-// --- Pines para SD_MMC (Modo 1-bit) ---
-#define SD_CARD_MMC_CLK_PIN 39
-#define SD_CARD_MMC_CMD_PIN 38
-#define SD_CARD_MMC_D0_PIN  40
+// --- Helpers estáticos del formato de registro ---
 
-SDManager::SDManager() : _sdAvailable(false) {
+static uint32_t readLe32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// (Cabecera de registro: magic, longitud y CRC-32 del contenido)
+static void buildRecordHeader(uint8_t* header, const uint8_t* data, size_t length) {
+    uint32_t crc = esp_rom_crc32_le(0, data, length);
+    memcpy(header, RECORD_MAGIC, 4);
+    for (int i = 0; i < 4; i++) {
+        header[4 + i] = (uint8_t)((uint32_t)length >> (8 * i));
+        header[8 + i] = (uint8_t)(crc >> (8 * i));
+    }
+}
+
+// (True si la cabecera es de registro y su longitud cuadra con el tamaño del archivo)
+static bool recordHeaderMatchesSize(const uint8_t* header, size_t headerBytes, size_t fileSize) {
+    return headerBytes == RECORD_HEADER_LEN && memcmp(header, RECORD_MAGIC, 4) == 0 &&
+           readLe32(header + 4) == fileSize - RECORD_HEADER_LEN;
+}
+
+// (Nombre del temporal: la ruta destino sin la '/' inicial y con '/' -> '~'.
+//  Así recoverTornRecords() sabe a dónde renombrarlo)
+static String recordTempPath(const String& fullPath) {
+    String name = fullPath.substring(1);
+    name.replace("/", "~");
+    return String(RECORD_TMP_DIR) + "/" + name + ".tmp";
+}
+
+static String recordPathFromTempName(const String& tempName) {
+    if (!tempName.endsWith(".tmp")) return "";
+    String path = "/" + tempName.substring(0, tempName.length() - 4);
+    path.replace("~", "/");
+    return path;
+}
+
+SDManager::SDManager()
+    : _sdAvailable(false), _hotTierDroppedLogged(0), _clusterBytes(0), _mountGeneration(0), _seriesGeneration(0), _remountBackoffMs(SD_REMOUNT_BACKOFF_MIN_MS),
+      _nextRemountMs(0), _lastProbeMs(0), _probeFailures(0), _cardLostPendingLog(false), _attemptsSinceLoss(0),
+      _recoveryPendingLog(false), _recoveryChecked(0), _recoveryQuarantined(0), _recoveryRenamed(0), _recoveryRemoved(0) {
     // Constructor
 }
 
 bool SDManager::begin() {
+    // Antes de que el portal y la lectora de pendientes usen la tarjeta
+    SdIo::begin();
+
+    // Nivel rápido en flash interna: no depende de la tarjeta, se monta primero
+    _hotTier.begin();
+
+    if (_mountCard()) {
+        recoverTornRecords();
+        _lastProbeMs = millis();
+        return true;
+    }
+    // Sin tarjeta al arrancar: checkCardHealth() seguirá intentando montarla
+    _remountBackoffMs = SD_REMOUNT_BACKOFF_MIN_MS;
+    _nextRemountMs = millis() + _remountBackoffMs;
+    return false;
+}
+
+bool SDManager::_mountCard() {
+    SdIoGuard ioGuard(SdIoClass::MAINTENANCE);
     #ifdef ENABLE_DEBUG_SERIAL
         Serial.println(F("[SDManager] Initializing SD Card (SD_MMC 1-bit mode)..."));
-        Serial.printf("[SDManager] Using PINS: CLK=%d, CMD=%d, D0=%d\n", SD_CARD_MMC_CLK_PIN, SD_CARD_MMC_CMD_PIN, SD_CARD_MMC_D0_PIN);
+        Serial.printf("[SDManager] Using PINS: CLK=%d, CMD=%d, D0=%d\n", Board::SD_MMC_CLK_PIN, Board::SD_MMC_CMD_PIN, Board::SD_MMC_D0_PIN);
     #endif
 
      // Configura los pines para el periférico SD_MMC
-     SD_MMC.setPins(SD_CARD_MMC_CLK_PIN, SD_CARD_MMC_CMD_PIN, SD_CARD_MMC_D0_PIN);
+     SD_MMC.setPins(Board::SD_MMC_CLK_PIN, Board::SD_MMC_CMD_PIN, Board::SD_MMC_D0_PIN);
     
-     // Intenta inicializar en modo 1-bit (tercer argumento 'true')
-    if (!SD_MMC.begin("/sdcard", true, true, SDMMC_FREQ_DEFAULT)) { 
+     // Intenta inicializar en modo 1-bit (segundo argumento 'true'). Nunca se formatea
+     // (tercer argumento 'false'): una tarjeta mal insertada o con un fallo puntual no debe
+     // perder 'data_pending' ni 'archive'; se informa y se reintenta con backoff
+    if (!SD_MMC.begin(SD_MOUNT_POINT, true, false, SDMMC_FREQ_DEFAULT)) { 
         #ifdef ENABLE_DEBUG_SERIAL
-            Serial.println(F("[SDManager] SD_MMC.begin failed. Card Mount Failed or no card present."));
+            Serial.println(F("[SDManager] SD_MMC.begin failed. Card Mount Failed or no card present (not formatted)."));
         #endif
         _sdAvailable = false;
         return false;
@@ -53,17 +118,27 @@ bool SDManager::begin() {
     if (_sdAvailable && !ensureDirectoryExists(ARCHIVE_DIR)) _sdAvailable = false;
     if (_sdAvailable && !ensureDirectoryExists(ARCHIVE_ENVIRONMENTAL_DIR)) _sdAvailable = false;
     if (_sdAvailable && !ensureDirectoryExists(ARCHIVE_CAPTURES_DIR)) _sdAvailable = false;
+    if (_sdAvailable && !ensureDirectoryExists(ARCHIVE_TIMESERIES_DIR)) _sdAvailable = false;
+    if (_sdAvailable && !ensureDirectoryExists(RECORD_TMP_DIR)) _sdAvailable = false;
+    if (_sdAvailable && !ensureDirectoryExists(QUARANTINE_DIR)) _sdAvailable = false;
 
     if (!_sdAvailable) { 
          #ifdef ENABLE_DEBUG_SERIAL
             Serial.println(F("[SDManager] CRITICAL: Failed to create one or more essential directories. SD operations might fail."));
         #endif
+        SD_MMC.end(); // Para que el siguiente intento de montaje empiece de cero
         return false; 
     }
     
     #ifdef ENABLE_DEBUG_SERIAL
         Serial.println(F("[SDManager] SD Card initialized successfully and directories checked/created."));
     #endif
+    // Bloque de ClusterWriter = cluster de esta tarjeta (varía según el formato)
+    _clusterBytes = ClusterWriter::detectClusterSize();
+    #ifdef ENABLE_DEBUG_SERIAL
+        Serial.printf("[SDManager] FAT cluster size: %u bytes.\n", (unsigned)_clusterBytes);
+    #endif
+    _mountGeneration++; // Invalida los File que el portal abrió en el montaje anterior
     return true; 
 }
 
@@ -72,6 +147,220 @@ bool SDManager::isSDAvailable() const {
     return _sdAvailable;
 }
 
+bool SDManager::isHotTierAvailable() const {
+    return _hotTier.isAvailable();
+}
+
+bool SDManager::isLocalStorageAvailable() const {
+    return _sdAvailable || _hotTier.isAvailable();
+}
+
+bool SDManager::isBulkStorageAvailable() const {
+    return _sdAvailable || psramFound();
+}
+
+SDHealthStats SDManager::getHealthStats() const {
+    SDHealthStats stats = _health;
+    uint32_t now = millis();
+    stats.nextRemountInMs = (_sdAvailable || (int32_t)(_nextRemountMs - now) <= 0) ? 0 : _nextRemountMs - now;
+    return stats;
+}
+
+const FlashRing& SDManager::getHotTier() const {
+    return _hotTier;
+}
+
+const ClusterWriterStats& SDManager::getWriterStats() const {
+    return _writerStats;
+}
+
+size_t SDManager::getClusterSize() const {
+    return _clusterBytes;
+}
+
+uint32_t SDManager::getMountGeneration() const {
+    return _mountGeneration;
+}
+
+void SDManager::checkCardHealth(TimeManager& timeMgr, float internalTempForLog) {
+    const uint32_t now = millis();
+
+    if (_sdAvailable) {
+        // Sondeo periódico: detecta una tarjeta extraída aunque no haya escrituras. Un /logs
+        // borrado se recrea sin más; un sondeo fallido aislado no basta para desmontar
+        if (now - _lastProbeMs >= SD_HEALTH_PROBE_INTERVAL_MS) {
+            _lastProbeMs = now;
+            SdIoGuard ioGuard(SdIoClass::MAINTENANCE);
+            bool ok = SD_MMC.exists(LOG_DIR) || ensureDirectoryExists(LOG_DIR);
+            _probeFailures = ok ? 0 : _probeFailures + 1;
+            if (!_recordSdResult(ok) && _sdAvailable && _probeFailures >= SD_HEALTH_PROBE_FAIL_THRESHOLD) {
+                _unmountCard();
+            }
+        }
+    } else if ((int32_t)(now - _nextRemountMs) >= 0) {
+        _health.remountAttempts++;
+        _attemptsSinceLoss++;
+        if (_mountCard()) {
+            // Antes de volcar nada: completa o aparta lo que dejó la caída (turnos por archivo)
+            recoverTornRecords();
+            _health.remounts++;
+            _health.lastRemountMs = now;
+            _health.consecutiveFailures = 0;
+            _lastProbeMs = now;
+            _remountBackoffMs = SD_REMOUNT_BACKOFF_MIN_MS;
+            int flushed = _flushWriteBuffer();
+            #ifdef ENABLE_DEBUG_SERIAL
+                Serial.printf("[SDManager] SD card remounted after %lu attempts. %d buffered writes flushed.\n",
+                              (unsigned long)_attemptsSinceLoss, flushed);
+            #endif
+            EventLog::log<EventId::SD_CARD_REMOUNTED>(*this, timeMgr, internalTempForLog, (unsigned)_attemptsSinceLoss,
+                                                     (unsigned)flushed, (unsigned)_health.bufferedWrites, (unsigned)_health.droppedWrites);
+            _attemptsSinceLoss = 0;
+        } else {
+            _remountBackoffMs = _remountBackoffMs >= SD_REMOUNT_BACKOFF_MAX_MS / 2 ? SD_REMOUNT_BACKOFF_MAX_MS : _remountBackoffMs * 2;
+            _nextRemountMs = now + _remountBackoffMs;
+            #ifdef ENABLE_DEBUG_SERIAL
+                Serial.printf("[SDManager] SD remount failed. Next attempt in %lu ms.\n", (unsigned long)_remountBackoffMs);
+            #endif
+            // Intentos 1, 2, 4, 8...: una tarjeta ausente durante días no llena el log
+            if ((_attemptsSinceLoss & (_attemptsSinceLoss - 1)) == 0) {
+                EventLog::log<EventId::SD_MOUNT_FAILED>(*this, timeMgr, internalTempForLog, (unsigned)_attemptsSinceLoss,
+                                                       (unsigned)_remountBackoffMs);
+            }
+        }
+    }
+
+    // La caída se detecta dentro de una escritura; se registra aquí (ya con el nivel rápido como destino)
+    if (_cardLostPendingLog) {
+        _cardLostPendingLog = false;
+        EventLog::log<EventId::SD_CARD_LOST>(*this, timeMgr, internalTempForLog, (unsigned)_health.consecutiveFailures,
+                                            (unsigned)_health.failures, (unsigned)_health.operations);
+    }
+    // La pasada de recuperación corre al montar, antes de tener TimeManager; se registra aquí
+    if (_recoveryPendingLog) {
+        _recoveryPendingLog = false;
+        EventLog::log<EventId::SD_RECORDS_RECOVERED>(*this, timeMgr, internalTempForLog, (unsigned)_recoveryQuarantined,
+                                                    (unsigned)_recoveryRenamed, (unsigned)_recoveryRemoved,
+                                                    (unsigned)_recoveryChecked, (unsigned)_health.lastRecoveryScanMs);
+    }
+}
+
+void SDManager::_unmountCard() {
+    SdIoGuard ioGuard(SdIoClass::MAINTENANCE);
+    #ifdef ENABLE_DEBUG_SERIAL
+        Serial.printf("[SDManager] SD card marked unavailable after %lu consecutive failures. Unmounting.\n",
+                      (unsigned long)_health.consecutiveFailures);
+    #endif
+    SD_MMC.end();
+    _sdAvailable = false;
+    _health.unmounts++;
+    _cardLostPendingLog = true;
+    _attemptsSinceLoss = 0;
+    _probeFailures = 0;
+    _remountBackoffMs = SD_REMOUNT_BACKOFF_MIN_MS;
+    _nextRemountMs = millis() + _remountBackoffMs;
+}
+
+bool SDManager::_recordSdResult(bool ok) {
+    _health.operations++;
+    if (ok) {
+        _health.consecutiveFailures = 0;
+        return true;
+    }
+    _health.failures++;
+    _health.consecutiveFailures++;
+    if (_sdAvailable && _health.consecutiveFailures >= SD_HEALTH_FAIL_THRESHOLD) {
+        _unmountCard();
+    }
+    return false;
+}
+
+bool SDManager::_isLogicalOpenFailure(const String& path) {
+    int lastSlash = path.lastIndexOf('/');
+    if (lastSlash <= 0) return false;
+    String parent = path.substring(0, lastSlash);
+    // El padre existe: la apertura falló por la tarjeta. Si no se puede recrear, también
+    return !SD_MMC.exists(parent.c_str()) && ensureDirectoryExists(parent.c_str());
+}
+
+bool SDManager::_bufferWrite(const String& path, const uint8_t* data, size_t length) {
+    if (!psramFound() || length > SD_WRITE_BUFFER_MAX_BYTES) {
+        _health.droppedWrites++;
+        return false;
+    }
+
+    // FILE_WRITE sobrescribe: una escritura nueva sobre la misma ruta sustituye a la retenida
+    for (size_t i = 0; i < _writeBuffer.size(); i++) {
+        if (_writeBuffer[i].path == path) {
+            free(_writeBuffer[i].data);
+            _health.bufferedBytes -= _writeBuffer[i].length;
+            _health.bufferedWrites--;
+            _writeBuffer.erase(_writeBuffer.begin() + i);
+            break;
+        }
+    }
+    while (!_writeBuffer.empty() && _health.bufferedBytes + length > SD_WRITE_BUFFER_MAX_BYTES) {
+        _dropOldestBufferedWrite();
+    }
+
+    uint8_t* copy = (uint8_t*)ps_malloc(length > 0 ? length : 1);
+    if (copy == nullptr) {
+        _health.droppedWrites++;
+        return false;
+    }
+    memcpy(copy, data, length);
+    BufferedWrite entry;
+    entry.path = path;
+    entry.data = copy;
+    entry.length = length;
+    _writeBuffer.push_back(entry);
+    _health.bufferedWrites++;
+    _health.bufferedBytes += length;
+    #ifdef ENABLE_DEBUG_SERIAL
+        Serial.printf("[SDManager] SD unavailable. Buffered %u bytes in PSRAM for %s (%lu writes buffered).\n",
+                      (unsigned)length, path.c_str(), (unsigned long)_health.bufferedWrites);
+    #endif
+    return true;
+}
+
+void SDManager::_dropOldestBufferedWrite() {
+    if (_writeBuffer.empty()) return;
+    #ifdef ENABLE_DEBUG_SERIAL
+        Serial.println("[SDManager] PSRAM write buffer full. Dropping: " + _writeBuffer.front().path);
+    #endif
+    free(_writeBuffer.front().data);
+    _health.bufferedBytes -= _writeBuffer.front().length;
+    _health.bufferedWrites--;
+    _health.droppedWrites++;
+    _writeBuffer.erase(_writeBuffer.begin());
+}
+
+int SDManager::_flushWriteBuffer() {
+    int flushed = 0;
+    while (!_writeBuffer.empty() && _sdAvailable) {
+        SdIoGuard ioGuard(SdIoClass::MAINTENANCE); // Un turno por escritura retenida
+        BufferedWrite& entry = _writeBuffer.front();
+        bool logicalError = false;
+        if (!_writeRecordFile(entry.path, entry.data, entry.length, &logicalError)) {
+            if (!logicalError) _recordSdResult(false);
+            break; // Se reintenta en el siguiente remontaje
+        }
+        _recordSdResult(true);
+
+        free(entry.data);
+        _health.bufferedBytes -= entry.length;
+        _health.bufferedWrites--;
+        _health.flushedWrites++;
+        _writeBuffer.erase(_writeBuffer.begin());
+        flushed++;
+    }
+    return flushed;
+}
+
+uint32_t SDManager::hotTierPendingRecords() const {
+    return _hotTier.isAvailable() ? _hotTier.pendingRecords() : 0;
+}
+
 // (Helper para convertir LogLevel a String)
 String SDManager::logLevelToString(LogLevel level) {
     switch (level) {
@@ -82,9 +371,22 @@ String SDManager::logLevelToString(LogLevel level) {
     }
 }
 
+String SDManager::formatLogLine(const String& timestamp, LogLevel level, const String& message, float internalTemp) {
+    // Las líneas habituales se forman en la pila; solo las más largas reservan su tamaño exacto
+    String levelName = logLevelToString(level);
+    char line[LOG_FORMAT_LINE_STACK_LEN];
+    size_t length = ::formatLogLine(line, sizeof(line), timestamp.c_str(), levelName.c_str(), message.c_str(), internalTemp);
+    if (length < sizeof(line)) return String(line);
+
+    std::vector<char> longLine(length + 1);
+    ::formatLogLine(longLine.data(), longLine.size(), timestamp.c_str(), levelName.c_str(), message.c_str(), internalTemp);
+    return String(longLine.data());
+}
+
 float SDManager::getUsageInfo(uint64_t& outUsedBytes, uint64_t& outTotalBytes) {
     outUsedBytes = 0;
     outTotalBytes = 0;
+    SdIoGuard ioGuard(SdIoClass::MAINTENANCE);
     if (!_sdAvailable) return -1.0f;
 
     outTotalBytes = SD_MMC.totalBytes();
@@ -97,7 +399,7 @@ float SDManager::getUsageInfo(uint64_t& outUsedBytes, uint64_t& outTotalBytes) {
 }
 
 bool SDManager::logToFile(const String& timestamp, LogLevel level, const String& message, float internalTemp) {
-    if (!_sdAvailable) return false;
+    if (!_sdAvailable && !_hotTier.isAvailable()) return false;
 
     // Extrae la fecha (ej. "2025-10-31") y la convierte a "20251031"
     String datePart = timestamp.substring(0, 10); 
@@ -105,27 +407,162 @@ bool SDManager::logToFile(const String& timestamp, LogLevel level, const String&
     datePart.remove(4, 1); // Quita el primer '-'
     String dailyLogFilename = String(LOG_DIR) + "/" + datePart + "_log.txt";
 
+    String logEntry = formatLogLine(timestamp, level, message, internalTemp);
+
+    // Nivel rápido: la línea llega al archivo diario en la siguiente migración
+    if (_hotTier.isAvailable() &&
+        _hotTier.append(HotRecordType::APPEND_LINE, dailyLogFilename, (const uint8_t*)logEntry.c_str(), logEntry.length())) {
+        return true;
+    }
+    SdIoGuard ioGuard(SdIoClass::CAPTURE_WRITE);
+    if (!_sdAvailable) return false;
+
+    TRACE_SCOPE(SD_LOG_APPEND);
     // Abre el archivo en modo "append" (añadir al final)
-    File logFile = SD_MMC.open(dailyLogFilename.c_str(), FILE_APPEND);
+    File logFile = FAULT_INJECT(SD_OPEN) ? File() : SD_MMC.open(dailyLogFilename.c_str(), FILE_APPEND);
     if (!logFile) {
         #ifdef ENABLE_DEBUG_SERIAL
             Serial.println("[SDManager] Failed to open log file for appending: " + dailyLogFilename);
         #endif
-        return false;
+        return _isLogicalOpenFailure(dailyLogFilename) ? false : _recordSdResult(false);
     }
 
-    String logEntry = timestamp + " [" + logLevelToString(level) + "] " + message;
-    // Añade la temperatura interna si se proporciona un valor válido
-    if (!isnan(internalTemp)) {
-        logEntry += " (DevTemp: " + String(internalTemp, 1) + "C )";
+    bool ok = logFile.println(logEntry) == logEntry.length() + 2;
+    logFile.close();
+    return _recordSdResult(ok);
+}
+
+bool SDManager::appendBinaryLog(const String& fileDate, const uint8_t* frame, size_t length) {
+    if (!_sdAvailable && !_hotTier.isAvailable()) return false;
+
+    String dailyLogFilename = String(LOG_DIR) + "/" + (fileDate.isEmpty() ? String("UPTIME") : fileDate) + "_log.bin";
+
+    // Nivel rápido: la cabecera EVENT_LOG_MAGIC la escribe la migración al crear el archivo
+    if (_hotTier.isAvailable() && _hotTier.append(HotRecordType::EVENT_FRAME, dailyLogFilename, frame, length)) {
+        return true;
+    }
+    SdIoGuard ioGuard(SdIoClass::CAPTURE_WRITE);
+    if (!_sdAvailable) return false;
+
+    TRACE_SCOPE(SD_LOG_APPEND);
+
+    File logFile = FAULT_INJECT(SD_OPEN) ? File() : SD_MMC.open(dailyLogFilename.c_str(), FILE_APPEND);
+    if (!logFile) {
+        #ifdef ENABLE_DEBUG_SERIAL
+            Serial.println("[SDManager] Failed to open binary log file for appending: " + dailyLogFilename);
+        #endif
+        return _isLogicalOpenFailure(dailyLogFilename) ? false : _recordSdResult(false);
     }
 
-    logFile.println(logEntry);
+    // Archivo nuevo: cabecera de formato (permite versionar el formato en el futuro)
+    bool ok = true;
+    if (logFile.size() == 0) {
+        ok = logFile.write((const uint8_t*)EVENT_LOG_MAGIC, 4) == 4;
+    }
+    ok = ok && logFile.write(frame, length) == length;
     logFile.close();
-    return true;
+    return _recordSdResult(ok);
+}
+
+// Ruta VFS de la serie `file` del día local de `epoch`
+static String seriesPath(SeriesFile file, time_t epoch) {
+    struct tm timeinfo;
+    localtime_r(&epoch, &timeinfo);
+    char date[9];
+    strftime(date, sizeof(date), "%Y%m%d", &timeinfo);
+    return String(SD_MOUNT_POINT ARCHIVE_TIMESERIES_DIR "/") + date + (file == SeriesFile::THERMAL ? "_thermal.ts" : "_ambient.ts");
+}
+
+// Inicio (00:00 local) del día siguiente al de `epoch`
+static time_t nextLocalDay(time_t epoch) {
+    struct tm timeinfo;
+    localtime_r(&epoch, &timeinfo);
+    timeinfo.tm_mday++;
+    timeinfo.tm_hour = 0;
+    timeinfo.tm_min = 0;
+    timeinfo.tm_sec = 0;
+    timeinfo.tm_isdst = -1;
+    return mktime(&timeinfo);
+}
+
+bool SDManager::_appendSeries(SeriesFile file, uint32_t epoch, const float values[TS_COLUMNS]) {
+    if (epoch == 0) return false; // Sin hora no hay archivo diario ni orden de las muestras
+    SdIoGuard ioGuard(SdIoClass::CAPTURE_WRITE);
+    if (!_sdAvailable) return false;
+
+    String path = seriesPath(file, (time_t)epoch);
+    int result = _seriesStore.append(path.c_str(), epoch, values);
+    if (result == TS_ERR_OUT_OF_ORDER) {
+        // (Ej. el reloj retrocedió tras una resincronización NTP: no es un fallo de la tarjeta)
+        #ifdef ENABLE_DEBUG_SERIAL
+            Serial.printf("[SDManager] Series sample %u not newer than the last one in %s. Skipped.\n", (unsigned)epoch, path.c_str());
+        #endif
+        return false;
+    }
+    if (result == TS_OK) _seriesGeneration++;
+    return _recordSdResult(result == TS_OK);
+}
+
+bool SDManager::appendAmbientSample(uint32_t epoch, float light, float temperature, float humidity, float pressure) {
+    float values[TS_COLUMNS];
+    values[TS_LIGHT] = light;
+    values[TS_TEMPERATURE] = temperature;
+    values[TS_HUMIDITY] = humidity;
+    values[TS_PRESSURE] = pressure;
+    return _appendSeries(SeriesFile::AMBIENT, epoch, values);
+}
+
+bool SDManager::appendThermalSummary(uint32_t epoch, float maxTemp, float minTemp, float avgTemp, float canopyAvgTemp) {
+    float values[TS_COLUMNS];
+    values[TS_THERMAL_MAX] = maxTemp;
+    values[TS_THERMAL_MIN] = minTemp;
+    values[TS_THERMAL_AVG] = avgTemp;
+    values[TS_CANOPY_AVG] = canopyAvgTemp;
+    return _appendSeries(SeriesFile::THERMAL, epoch, values);
+}
+
+bool SDManager::scanSeries(SeriesFile file, uint32_t from, uint32_t to, TsSampleCallback callback, void* context, TsReadStats* stats) {
+    if (from > to) return false;
+
+    bool ok = true;
+    time_t day = (time_t)from;
+    // (Un rango de N días toca hasta N + 1 archivos diarios)
+    for (int i = 0; i <= SERIES_QUERY_MAX_DAYS && day <= (time_t)to; i++) {
+        SdIoGuard ioGuard(SdIoClass::PORTAL_READ); // Un turno por archivo diario
+        if (!_sdAvailable) return false;
+        ok = _seriesStore.scan(seriesPath(file, day).c_str(), from, to, callback, context, stats) && ok;
+        day = nextLocalDay(day);
+    }
+    return ok;
+}
+
+bool SDManager::aggregateSeries(SeriesFile file, uint32_t from, uint32_t to, TsAggregate out[TS_COLUMNS], TsReadStats* stats) {
+    if (from > to) return false;
+
+    bool ok = true;
+    time_t day = (time_t)from;
+    for (int i = 0; i <= SERIES_QUERY_MAX_DAYS && day <= (time_t)to; i++) {
+        SdIoGuard ioGuard(SdIoClass::PORTAL_READ);
+        if (!_sdAvailable) return false;
+        ok = _seriesStore.aggregate(seriesPath(file, day).c_str(), from, to, out, stats) && ok;
+        day = nextLocalDay(day);
+    }
+    return ok;
+}
+
+uint32_t SDManager::getSeriesGeneration() const {
+    return _seriesGeneration;
 }
 
 bool SDManager::saveApiState(const String& stateJson) {
+    // Nivel rápido: reemplazo atómico en flash, sin tocar la SD
+    if (_hotTier.isAvailable() && _hotTier.writeState(API_STATE_HOT_NAME, stateJson)) {
+        #ifdef ENABLE_DEBUG_SERIAL
+            Serial.println(F("[SDManager] API state saved to internal flash (hot tier)."));
+        #endif
+        return true;
+    }
+    SdIoGuard ioGuard(SdIoClass::QUEUE);
     if (!_sdAvailable) return false;
 
     // --- IMPLEMENTACIÓN EN TEXTO PLANO ---
@@ -140,16 +577,21 @@ bool SDManager::saveApiState(const String& stateJson) {
         #ifdef ENABLE_DEBUG_SERIAL
             Serial.println("[SDManager] Failed to open API state file for writing.");
         #endif
-        return false;
+        return _isLogicalOpenFailure(API_STATE_FILENAME) ? false : _recordSdResult(false);
     }
-    stateFile.print(stateJson);
+    bool ok = stateFile.print(stateJson) == stateJson.length();
     stateFile.close();
-    return true;
+    return _recordSdResult(ok);
 }
 
 bool SDManager::readApiState(String& stateJsonOut) {
-    if (!_sdAvailable) return false;
     stateJsonOut = "";
+    if (_hotTier.isAvailable() && _hotTier.readState(API_STATE_HOT_NAME, stateJsonOut)) {
+        return true;
+    }
+    // Sin estado en flash (primer arranque con nivel rápido, o sin partición): se usa el de la SD
+    SdIoGuard ioGuard(SdIoClass::QUEUE);
+    if (!_sdAvailable) return false;
 
     // --- IMPLEMENTACIÓN EN TEXTO PLANO ---
     #ifdef ENABLE_DEBUG_SERIAL
@@ -176,51 +618,167 @@ bool SDManager::readApiState(String& stateJsonOut) {
 }
 
 bool SDManager::writeTextFile(const String& fullPath, const String& data) {
-    if (!_sdAvailable) return false;
-    
-    // FILE_WRITE: Crea si no existe, sobrescribe (trunca) si existe.
-    File file = SD_MMC.open(fullPath.c_str(), FILE_WRITE);
-    if (!file) {
-        #ifdef ENABLE_DEBUG_SERIAL
-            Serial.println("[SDManager] Failed to open text file for writing: " + fullPath);
-        #endif
-        return false;
-    }
-    size_t bytesWritten = file.print(data);
-    file.close();
+    SdIoGuard ioGuard(SdIoClass::CAPTURE_WRITE);
+    // Sin tarjeta: se retiene en PSRAM hasta el remontaje
+    if (!_sdAvailable) return _bufferWrite(fullPath, (const uint8_t*)data.c_str(), data.length());
+    TRACE_SCOPE(SD_WRITE_TEXT);
 
-    // Verifica que se haya escrito todo el contenido
-    if (bytesWritten != data.length()) {
+    bool logicalError = false;
+    if (!_writeRecordFile(fullPath, (const uint8_t*)data.c_str(), data.length(), &logicalError)) {
         #ifdef ENABLE_DEBUG_SERIAL
-            Serial.println("[SDManager] Error: Not all text data written to file: " + fullPath);
+            Serial.println("[SDManager] Failed to write text record: " + fullPath);
         #endif
+        if (logicalError) return false; // No es la tarjeta: no cuenta para la salud
+        // Si este fallo dio la tarjeta por caída, los datos no se pierden: quedan en PSRAM
+        if (!_recordSdResult(false) && !_sdAvailable) return _bufferWrite(fullPath, (const uint8_t*)data.c_str(), data.length());
         return false;
     }
-    return true;
+    return _recordSdResult(true);
 }
 
 bool SDManager::writeBinaryFile(const String& fullPath, const uint8_t* data, size_t length) {
-    if (!_sdAvailable) return false;
+    SdIoGuard ioGuard(SdIoClass::CAPTURE_WRITE);
+    // Sin tarjeta: se retiene en PSRAM hasta el remontaje
+    if (!_sdAvailable) return _bufferWrite(fullPath, data, length);
+    TRACE_SCOPE(SD_WRITE_BINARY);
 
-    File file = SD_MMC.open(fullPath.c_str(), FILE_WRITE);
-    if (!file) {
+    bool logicalError = false;
+    if (!_writeRecordFile(fullPath, data, length, &logicalError)) {
         #ifdef ENABLE_DEBUG_SERIAL
-            Serial.println("[SDManager] Failed to open binary file for writing: " + fullPath);
+            Serial.println("[SDManager] Failed to write binary record: " + fullPath);
         #endif
+        if (logicalError) return false;
+        if (!_recordSdResult(false) && !_sdAvailable) return _bufferWrite(fullPath, data, length);
         return false;
     }
-    size_t bytesWritten = file.write(data, length);
-    file.close();
+    return _recordSdResult(true);
+}
 
-    if (bytesWritten != length) {
-        #ifdef ENABLE_DEBUG_SERIAL
-            Serial.println("[SDManager] Error: Not all binary data written to file: " + fullPath);
-        #endif
+// (Helper: registro completo o nada. Un corte antes del rename deja el destino anterior intacto
+//  y un temporal que recoverTornRecords() completa o borra en el siguiente montaje)
+bool SDManager::_writeRecordFile(const String& fullPath, const uint8_t* data, size_t length, bool* logicalError) {
+    if (logicalError) *logicalError = false;
+    if (!ensureParentDirectoryExists(fullPath)) return false;
+    String tmpPath = recordTempPath(fullPath);
+
+    // Tamaño conocido: la cadena de clusters se reserva entera al abrir
+    ClusterWriter writer(_clusterBytes > 0 ? _clusterBytes : CLUSTER_WRITER_DEFAULT_CHUNK);
+    if (FAULT_INJECT(SD_OPEN) || !writer.open((SD_MOUNT_POINT + tmpPath).c_str(), false, RECORD_HEADER_LEN + length)) {
+        if (logicalError) *logicalError = _isLogicalOpenFailure(tmpPath);
+        return false;
+    }
+    uint8_t header[RECORD_HEADER_LEN];
+    buildRecordHeader(header, data, length);
+    // Con inyección de fallos se simula una escritura parcial (tarjeta llena / extraída)
+    size_t toWrite = FAULT_INJECT(SD_WRITE_PARTIAL) ? length / 2 : length;
+    bool ok = writer.write(header, RECORD_HEADER_LEN) == RECORD_HEADER_LEN &&
+              writer.write(data, toWrite) == length;
+    ok = writer.close() && ok; // close() hace fsync: el contenido está en la tarjeta antes del rename
+    _writerStats.add(writer.stats());
+
+    if (!ok) {
+        SD_MMC.remove(tmpPath.c_str());
+        return false;
+    }
+    // FAT no sobrescribe en un rename: primero se borra la versión anterior
+    if (SD_MMC.exists(fullPath.c_str())) SD_MMC.remove(fullPath.c_str());
+    if (!SD_MMC.rename(tmpPath.c_str(), fullPath.c_str())) {
+        SD_MMC.remove(tmpPath.c_str());
+        // El destino sigue ahí (ej. es un directorio): no se pudo reemplazar, no es la tarjeta
+        if (logicalError) *logicalError = SD_MMC.exists(fullPath.c_str());
         return false;
     }
     return true;
 }
 
+bool SDManager::storeSmallFile(const String& fullPath, const String& data) {
+    if (_hotTier.isAvailable() && data.length() <= FLASH_RING_MAX_DATA &&
+        _hotTier.append(HotRecordType::WRITE_FILE, fullPath, (const uint8_t*)data.c_str(), data.length())) {
+        return true;
+    }
+    return writeTextFile(fullPath, data);
+}
+
+int SDManager::migrateHotTier(TimeManager& timeMgr, int maxRecords, float internalTempForLog) {
+    if (!_sdAvailable || !_hotTier.isAvailable() || _hotTier.pendingRecords() == 0) return 0;
+    SdIoGuard ioGuard(SdIoClass::QUEUE);
+
+    // Log abierto para añadir: las líneas seguidas de un mismo archivo comparten apertura y se
+    // escriben por bloques alineados al cluster (el archivo crece por pasos y se recorta al cerrar)
+    ClusterWriter appendWriter(_clusterBytes > 0 ? _clusterBytes : CLUSTER_WRITER_DEFAULT_CHUNK);
+    String appendPath;
+    bool appendFailed = false; // Un volcado falló: lo migrado desde la última confirmación se repite
+    bool logicalError = false; // El último registro falló por un error lógico (no cuenta para la salud)
+
+    auto closeAppend = [&]() {
+        if (!appendWriter.isOpen()) return;
+        if (!appendWriter.close()) appendFailed = true;
+        _writerStats.add(appendWriter.stats());
+        appendPath = "";
+    };
+
+    auto applyRecord = [&](HotRecordType type, const String& target, const uint8_t* data, size_t length) -> bool {
+        if (type == HotRecordType::WRITE_FILE) {
+            closeAppend();
+            return !appendFailed && _writeRecordFile(target, data, length, &logicalError);
+        }
+
+        if (!appendWriter.isOpen() || appendPath != target) {
+            closeAppend();
+            if (appendFailed || !ensureParentDirectoryExists(target)) return false;
+            if (FAULT_INJECT(SD_OPEN) ||
+                !appendWriter.open((SD_MOUNT_POINT + target).c_str(), true, 0, CLUSTER_WRITER_LOG_GROW_STEP)) {
+                return false;
+            }
+            appendPath = target;
+            // Archivo .bin nuevo: cabecera de formato, igual que appendBinaryLog()
+            if (type == HotRecordType::EVENT_FRAME && appendWriter.size() == 0 &&
+                appendWriter.write((const uint8_t*)EVENT_LOG_MAGIC, 4) != 4) {
+                return false;
+            }
+        }
+        if (appendWriter.write(data, length) != length) return false;
+        if (type == HotRecordType::APPEND_LINE) {
+            return appendWriter.write((const uint8_t*)"\r\n", 2) == 2; // Igual que println()
+        }
+        return true;
+    };
+
+    int migrated = _hotTier.migrate([&](HotRecordType type, const String& target, const uint8_t* data, size_t length) -> bool {
+        if (!_sdAvailable) return false; // La tarjeta cayó durante este lote
+        if (applyRecord(type, target, data, length)) return _recordSdResult(true);
+        // Se cierra antes de contabilizar el fallo, que puede desmontar la tarjeta
+        closeAppend();
+        if (logicalError) {
+            logicalError = false;
+            return false;
+        }
+        return _recordSdResult(false);
+    }, maxRecords, [&]() -> bool {
+        // Antes de borrar un segmento del anillo (o guardar el cursor), lo migrado tiene que estar
+        // en la tarjeta: close() vuelca el buffer, recorta la reserva y sincroniza. Un flush()
+        // sin fsync lo dejaría en la caché del FS y un corte perdería registros ya borrados
+        // del anillo. El siguiente registro vuelve a abrir el archivo
+        closeAppend();
+        bool ok = !appendFailed;
+        appendFailed = false;
+        return ok;
+    });
+    closeAppend();
+
+    #ifdef ENABLE_DEBUG_SERIAL
+        Serial.printf("[SDManager] Hot tier: %d records migrated to SD, %lu pending.\n",
+                      migrated, (unsigned long)_hotTier.pendingRecords());
+    #endif
+    uint32_t dropped = _hotTier.droppedRecords();
+    if (migrated > 0 || dropped != _hotTierDroppedLogged) {
+        EventLog::log<EventId::HOT_TIER_MIGRATED>(*this, timeMgr, internalTempForLog, migrated,
+                                                 (unsigned)_hotTier.pendingRecords(), (unsigned)(dropped - _hotTierDroppedLogged));
+        _hotTierDroppedLogged = dropped;
+    }
+    return migrated;
+}
+
 // (Wrapper para guardar en directorio 'pending/ambient')
 bool SDManager::savePendingTextData(const String& subDir, const String& filename, const String& data) {
     if (!_sdAvailable) return false;
@@ -250,7 +808,9 @@ bool SDManager::savePendingBinaryData(const String& subDir, const String& filena
 
 
 bool SDManager::moveFile(const String& srcPath, const String& destPath) {
+    SdIoGuard ioGuard(SdIoClass::QUEUE);
     if (!_sdAvailable) return false;
+    TRACE_SCOPE(SD_MOVE_FILE);
 
     if (!SD_MMC.exists(srcPath.c_str())) {
         #ifdef ENABLE_DEBUG_SERIAL
@@ -272,19 +832,28 @@ bool SDManager::moveFile(const String& srcPath, const String& destPath) {
     }
 
     // `rename` es el método de SD_MMC para mover archivos eficientemente
-    if (SD_MMC.rename(srcPath.c_str(), destPath.c_str())) {
+    if (!FAULT_INJECT(SD_RENAME) && SD_MMC.rename(srcPath.c_str(), destPath.c_str())) {
         #ifdef ENABLE_DEBUG_SERIAL
             Serial.println("[SDManager] File moved successfully from " + srcPath + " to " + destPath);
         #endif
-        return true;
+        return _recordSdResult(true);
     } else {
         #ifdef ENABLE_DEBUG_SERIAL
             Serial.println("[SDManager] moveFile: Failed to rename/move file from " + srcPath + " to " + destPath);
         #endif
-        return false;
+        // FAT no sobrescribe en un rename: un destino ya existente es un error lógico
+        if (SD_MMC.exists(destPath.c_str())) return false;
+        return _recordSdResult(false);
     }
 }
 
+// (Helper para crear el directorio que contiene un archivo)
+bool SDManager::ensureParentDirectoryExists(const String& fullPath) {
+    int lastSlash = fullPath.lastIndexOf('/');
+    if (lastSlash <= 0) return true;
+    return ensureDirectoryExists(fullPath.substring(0, lastSlash).c_str());
+}
+
 // (Helper para crear directorios)
 bool SDManager::ensureDirectoryExists(const char* path) {
     if (!SD_MMC.exists(path)) {
@@ -307,6 +876,7 @@ void SDManager::listDir(const char * dirname, uint8_t levels){
 }
 
 bool SDManager::deleteFile(const char* path) {
+    SdIoGuard ioGuard(SdIoClass::QUEUE);
     if (!_sdAvailable) return false;
     #ifdef ENABLE_DEBUG_SERIAL
         Serial.printf("[SDManager] Deleting file: %s\n", path);
@@ -323,6 +893,7 @@ bool SDManager::deleteFile(const char* path) {
 
 // (Helper para Web Portal: Listar logs como JSON)
 String SDManager::listLogFilesJSON(const char* dirname) {
+    SdIoGuard ioGuard(SdIoClass::PORTAL_READ);
     String jsonOutput = "[]"; 
     if (!_sdAvailable) return jsonOutput;
 
@@ -351,6 +922,7 @@ String SDManager::listLogFilesJSON(const char* dirname) {
 
 // (Helper para Web Portal: Obtener archivo de log para streaming)
 File SDManager::getLogFile(const String& path) {
+    SdIoGuard ioGuard(SdIoClass::PORTAL_READ);
     if (!_sdAvailable) {
         return File(); // Devuelve objeto File inválido
     }
@@ -369,51 +941,195 @@ File SDManager::getLogFile(const String& path) {
 
 // --- Helpers Estáticos para Lectura de Archivos (usados en processPendingApiCalls) ---
 
-// (Lee un archivo de texto completo a un String)
-static String readFileToString(const char* path) {
-    if (!SD_MMC.exists(path)) return "";
-    File file = SD_MMC.open(path);
-    if (!file || file.isDirectory()) {
-        if (file) file.close();
-        return "";
-    }
-    String content = file.readString();
-    file.close();
-    return content;
-}
-
-// (Lee un archivo binario completo a un buffer. El llamador debe hacer free())
-static uint8_t* readBinaryFileToBuffer(const char* path, size_t& fileSize) {
-    fileSize = 0;
-    if (!SD_MMC.exists(path)) return nullptr;
+bool SDManager::readRecordInto(const char* path, uint8_t*& buffer, size_t& capacity, size_t& length) {
+    // Si es un registro, verifica longitud y CRC y devuelve solo el contenido; los archivos
+    // sin cabecera, de versiones anteriores, se devuelven completos
+    length = 0;
+    SdIoGuard ioGuard(SdIoClass::QUEUE);
+    if (!SD_MMC.exists(path)) return false;
     File file = SD_MMC.open(path, FILE_READ);
     if (!file || file.isDirectory()) {
         if (file) file.close();
-        return nullptr;
+        return false;
     }
-    
-    fileSize = file.size();
-    if (fileSize == 0) {
+
+    size_t totalSize = file.size();
+    uint8_t header[RECORD_HEADER_LEN];
+    size_t headerBytes = totalSize >= RECORD_HEADER_LEN ? file.read(header, RECORD_HEADER_LEN) : 0;
+    bool framed = headerBytes == RECORD_HEADER_LEN && memcmp(header, RECORD_MAGIC, 4) == 0;
+    if (framed && !recordHeaderMatchesSize(header, headerBytes, totalSize)) {
         file.close();
-        return nullptr;
+        return false; // Registro cortado
     }
+    if (!framed) file.seek(0);
 
-    uint8_t* buffer = (uint8_t*)malloc(fileSize); // Aloca en HEAP (o PSRAM si malloc está configurado)
-    if (!buffer) {
+    size_t payloadLength = framed ? totalSize - RECORD_HEADER_LEN : totalSize;
+    if (payloadLength == 0) {
         file.close();
-        return nullptr;
+        return false;
+    }
+
+    if (buffer == nullptr || capacity < payloadLength + 1) {
+        uint8_t* grown = (uint8_t*)realloc(buffer, payloadLength + 1); // HEAP (o PSRAM si malloc está configurado)
+        if (!grown) {
+            file.close();
+            return false;
+        }
+        buffer = grown;
+        capacity = payloadLength + 1;
     }
 
-    size_t bytesRead = file.read(buffer, fileSize);
+    size_t bytesRead = file.read(buffer, payloadLength);
     file.close();
 
-    if (bytesRead != fileSize) {
+    if (bytesRead != payloadLength || (framed && esp_rom_crc32_le(0, buffer, payloadLength) != readLe32(header + 8))) {
+        return false;
+    }
+    buffer[payloadLength] = '\0';
+    length = payloadLength;
+    return true;
+}
+
+// (Lee el contenido de un archivo a un buffer terminado en '\0'. El llamador debe hacer free())
+static uint8_t* readBinaryFileToBuffer(const char* path, size_t& fileSize) {
+    uint8_t* buffer = nullptr;
+    size_t capacity = 0;
+    if (!SDManager::readRecordInto(path, buffer, capacity, fileSize)) {
         free(buffer);
         return nullptr;
     }
     return buffer;
 }
 
+// (Lee el contenido de un archivo de texto a un String; "" si no existe o está dañado)
+static String readFileToString(const char* path) {
+    size_t length = 0;
+    uint8_t* buffer = readBinaryFileToBuffer(path, length);
+    if (!buffer) return "";
+    String content((const char*)buffer);
+    free(buffer);
+    return content;
+}
+
+bool SDManager::readRecordText(const String& fullPath, String& dataOut) {
+    dataOut = _sdAvailable ? readFileToString(fullPath.c_str()) : String();
+    return !dataOut.isEmpty();
+}
+
+uint8_t* SDManager::readRecordBinary(const String& fullPath, size_t& length) {
+    length = 0;
+    return _sdAvailable ? readBinaryFileToBuffer(fullPath.c_str(), length) : nullptr;
+}
+
+// --- Recuperación tras un corte de luz ---
+
+int SDManager::recoverTornRecords() {
+    if (!_sdAvailable) return 0;
+    unsigned long start = millis();
+    _recoveryChecked = 0;
+    _recoveryQuarantined = 0;
+    _recoveryRenamed = 0;
+    _recoveryRemoved = 0;
+
+    // 1. Temporales: se recogen primero (no se renombra dentro de un directorio mientras se recorre)
+    std::vector<std::pair<String, bool>> temps; // Nombre, completo
+    {
+        SdIoGuard ioGuard(SdIoClass::MAINTENANCE); // Un turno para el listado
+        File tmpDir = SD_MMC.open(RECORD_TMP_DIR);
+        if (tmpDir && tmpDir.isDirectory()) {
+            File entry = tmpDir.openNextFile();
+            while (entry) {
+                if (!entry.isDirectory()) {
+                    uint8_t header[RECORD_HEADER_LEN];
+                    size_t size = entry.size();
+                    size_t headerBytes = size >= RECORD_HEADER_LEN ? entry.read(header, RECORD_HEADER_LEN) : 0;
+                    String name = entry.name();
+                    name = name.substring(name.lastIndexOf('/') + 1); // (Según la versión del core, name() incluye la ruta)
+                    temps.push_back(std::make_pair(name, recordHeaderMatchesSize(header, headerBytes, size)));
+                    _recoveryChecked++;
+                }
+                entry.close();
+                entry = tmpDir.openNextFile();
+            }
+        }
+        if (tmpDir) tmpDir.close();
+    }
+
+    for (size_t i = 0; i < temps.size(); i++) {
+        SdIoGuard ioGuard(SdIoClass::MAINTENANCE); // Un turno por archivo
+        String tmpPath = String(RECORD_TMP_DIR) + "/" + temps[i].first;
+        String destPath = recordPathFromTempName(temps[i].first);
+        // Completo (pasó el fsync): el corte fue entre el borrado del anterior y el rename
+        if (temps[i].second && !destPath.isEmpty() && ensureParentDirectoryExists(destPath)) {
+            if (SD_MMC.exists(destPath.c_str())) SD_MMC.remove(destPath.c_str());
+            if (SD_MMC.rename(tmpPath.c_str(), destPath.c_str())) {
+                _recoveryRenamed++;
+                continue;
+            }
+        }
+        if (SD_MMC.remove(tmpPath.c_str())) _recoveryRemoved++;
+    }
+
+    // 2. Cola de pendientes: solo la cabecera de cada archivo
+    _recoveryQuarantined += _quarantineTornRecords(AMBIENT_PENDING_DIR, _recoveryChecked);
+    _recoveryQuarantined += _quarantineTornRecords(CAPTURE_PENDING_DIR, _recoveryChecked);
+
+    _health.quarantinedRecords += _recoveryQuarantined;
+    _health.recoveredRecords += _recoveryRenamed;
+    _health.lastRecoveryScanMs = millis() - start;
+    _recoveryPendingLog = _recoveryQuarantined > 0 || _recoveryRenamed > 0 || _recoveryRemoved > 0;
+    #ifdef ENABLE_DEBUG_SERIAL
+        Serial.printf("[SDManager] Recovery scan: %lu files checked in %lu ms. %lu quarantined, %lu temp files completed, %lu removed.\n",
+                      (unsigned long)_recoveryChecked, (unsigned long)_health.lastRecoveryScanMs, (unsigned long)_recoveryQuarantined,
+                      (unsigned long)_recoveryRenamed, (unsigned long)_recoveryRemoved);
+    #endif
+    return (int)_recoveryQuarantined;
+}
+
+// (Helper recuperación: aparta los registros cuya cabecera no cuadra con el tamaño del archivo)
+int SDManager::_quarantineTornRecords(const char* dirPath, uint32_t& checked) {
+    std::vector<String> torn;
+    {
+        SdIoGuard ioGuard(SdIoClass::MAINTENANCE); // Un turno para el listado (solo cabeceras)
+        File root = SD_MMC.open(dirPath);
+        if (!root || !root.isDirectory()) {
+            if (root) root.close();
+            return 0;
+        }
+        File entry = root.openNextFile();
+        while (entry) {
+            if (!entry.isDirectory()) {
+                uint8_t header[RECORD_HEADER_LEN];
+                size_t size = entry.size();
+                size_t headerBytes = entry.read(header, size < RECORD_HEADER_LEN ? size : RECORD_HEADER_LEN);
+                bool framed = headerBytes >= 4 && memcmp(header, RECORD_MAGIC, 4) == 0;
+                // Vacío, o registro más corto (o más largo) de lo que dice su cabecera
+                if (size == 0 || (framed && !recordHeaderMatchesSize(header, headerBytes, size))) {
+                    torn.push_back(String(entry.path()));
+                }
+                checked++;
+            }
+            entry.close();
+            entry = root.openNextFile();
+        }
+        root.close();
+    }
+
+    int quarantined = 0;
+    for (size_t i = 0; i < torn.size(); i++) {
+        SdIoGuard ioGuard(SdIoClass::MAINTENANCE); // Un turno por archivo
+        String destPath = String(QUARANTINE_DIR) + torn[i].substring(torn[i].lastIndexOf('/'));
+        if (SD_MMC.exists(destPath.c_str())) SD_MMC.remove(destPath.c_str());
+        if (SD_MMC.rename(torn[i].c_str(), destPath.c_str())) {
+            quarantined++;
+            #ifdef ENABLE_DEBUG_SERIAL
+                Serial.println("[SDManager] Torn record quarantined: " + torn[i]);
+            #endif
+        }
+    }
+    return quarantined;
+}
+
 
 // --- Lógica de Negocio Principal ---
 
@@ -429,147 +1145,128 @@ bool SDManager::processPendingApiCalls(API& api_comm, TimeManager& timeMgr, Conf
     bool workDone = false; // Flag para saber si se hizo algún trabajo
     String logUrl = api_comm.getBaseApiUrl() + cfg.apiLogPath; // Para logs remotos
 
-    // --- 1. Procesar Datos Ambientales Pendientes (ambient_pending) ---
+    // --- Presupuesto de vaciado (evita saturar el enlace y retrasar el ciclo actual) ---
+    const unsigned long drainStartMillis = millis();
+    const unsigned long drainBudgetMillis = (cfg.backlog_drain_budget_seconds > 0) ? (unsigned long)cfg.backlog_drain_budget_seconds * 1000UL : 0;
+    int itemsAttempted = 0;
+    bool budgetExhausted = false;
+    // (Devuelve true si ya no se deben intentar más envíos en este ciclo)
+    auto drainBudgetExceeded = [&]() -> bool {
+        if (budgetExhausted) return true;
+        bool maxItemsReached = (cfg.backlog_max_items_per_cycle > 0 && itemsAttempted >= cfg.backlog_max_items_per_cycle);
+        bool timeExceeded = (drainBudgetMillis > 0 && (millis() - drainStartMillis) >= drainBudgetMillis) || PhaseDeadline::expired();
+        if (maxItemsReached || timeExceeded) {
+            budgetExhausted = true;
+            EventLog::log<EventId::PENDING_DRAIN_BUDGET_REACHED>(*this, timeMgr, internalTempForLog, itemsAttempted, (millis() - drainStartMillis) / 1000UL);
+        }
+        return budgetExhausted;
+    };
+
+    // --- 1. Listar la cola: datos ambientales y capturas, cada tipo del más antiguo al más reciente ---
     #ifdef ENABLE_DEBUG_SERIAL
-        Serial.println(F("[SDManager_Pending] Checking for pending ambient data..."));
+        Serial.println(F("[SDManager_Pending] Checking for pending ambient and capture data..."));
     #endif
-    File ambientPendingDir = SD_MMC.open(AMBIENT_PENDING_DIR);
-    if (ambientPendingDir && ambientPendingDir.isDirectory()) {
-        File entry = ambientPendingDir.openNextFile();
-        while (entry) {
-            // Solo procesa archivos .json que no sean directorios
-            if (!entry.isDirectory() && String(entry.name()).endsWith("_env.json")) {
-                workDone = true;
-                String filePath = String(entry.path());
-                String fileNameOnly = String(entry.name());
-                entry.close(); // Cierra el handle del archivo (importante!)
-
-                String jsonData = readFileToString(filePath.c_str());
-                if (!jsonData.isEmpty()) {
-                    // Re-parsea el JSON para obtener los valores individuales
-                    JsonDocument doc;
-                    DeserializationError error = deserializeJson(doc, jsonData);
-                    if (!error) {
-                        String timestamp = doc["timestamp"] | "0000-00-00_00:00:00";
-                        float light = doc["light"] | NAN; 
-                        float temp = doc["temperature"] | NAN;
-                        float hum = doc["humidity"] | NAN;
-                        float press = doc["pressure"] | NAN;
-
-                        // Intenta el reenvío usando la función de envío original
-                        String targetApiUrl = api_comm.getBaseApiUrl() + cfg.apiAmbientDataPath;
-                        int httpCode = EnvironmentDataJSON::IOEnvironmentData(targetApiUrl, api_comm.getAccessToken(), timestamp, light, temp, hum, press);
-
-                        if (httpCode == 200 || httpCode == 204) {
-                            // Éxito: Mover a 'archive'
-                            ErrorLogger::logToSdOnly(*this, timeMgr, LogLevel::INFO, "Sent pending ambient data: " + fileNameOnly, internalTempForLog);
-                            String archivePath = String(ARCHIVE_ENVIRONMENTAL_DIR) + "/" + fileNameOnly;
-                            archiveFile(filePath, archivePath);
-                        } else if (httpCode == 401) {
-                            // Error de Auth: No hacer nada, esperar refresco de token
-                            ErrorLogger::logToSdOnly(*this, timeMgr, LogLevel::WARNING, "Auth error sending pending ambient: " + fileNameOnly + ". HTTP: " + String(httpCode), internalTempForLog);
-                        } else {
-                            // Otro error (500, timeout, etc): Reintentar en la próxima vuelta
-                            ErrorLogger::logToSdOnly(*this, timeMgr, LogLevel::WARNING, "Failed send pending ambient: " + fileNameOnly + ". HTTP: " + String(httpCode), internalTempForLog);
-                        }
-                    } else {
-                        // Error de parseo: JSON corrupto, no se puede reenviar
-                        ErrorLogger::logToSdOnly(*this, timeMgr, LogLevel::ERROR, "Failed to parse pending ambient JSON: " + fileNameOnly, internalTempForLog);
-                        // (Considerar mover a un directorio "corrupto")
-                    }
+    std::vector<FileInfo> ambientFiles;
+    std::vector<FileInfo> thermalFiles;
+    {
+        SdIoGuard ioGuard(SdIoClass::QUEUE); // Solo el listado: los envíos no retienen la tarjeta
+        // (Los nombres sin fecha válida se envían primero en lugar de quedarse en la cola para siempre)
+        ambientFiles = _collectTimestampedFiles(AMBIENT_PENDING_DIR, "_env.json", true);
+        thermalFiles = _collectTimestampedFiles(CAPTURE_PENDING_DIR, "_thermal.json", true);
+    }
+
+    // Intercalados (ambiental, captura, ambiental...): el presupuesto del ciclo se reparte entre
+    // los dos tipos y una cola ambiental grande no deja sin enviar las capturas
+    std::vector<String> pendingJobs;
+    pendingJobs.reserve(ambientFiles.size() + thermalFiles.size());
+    for (size_t i = 0; i < ambientFiles.size() || i < thermalFiles.size(); ++i) {
+        if (i < ambientFiles.size()) pendingJobs.push_back(ambientFiles[i].path);
+        if (i < thermalFiles.size()) pendingJobs.push_back(thermalFiles[i].path);
+    }
+    if (pendingJobs.empty()) return false;
+
+    // --- 2. Enviar: la tarea lectora carga el siguiente elemento mientras se envía el actual ---
+    PendingPrefetcher prefetcher;
+    if (!prefetcher.begin(pendingJobs)) return false; // Sin memoria para las casillas: se reintenta en el próximo ciclo
+
+    while (PendingItem* item = prefetcher.next()) {
+        if (drainBudgetExceeded()) {
+            prefetcher.release(item);
+            break; // end() descarta lo ya cargado sin tocar los archivos
+        }
+        workDone = true;
+        itemsAttempted++;
+
+        if (item->kind == PendingItemKind::AMBIENT) {
+            const String& fileNameOnly = item->name;
+            if (item->status == PendingItemStatus::READY) {
+                // Intenta el reenvío usando la función de envío original
+                String targetApiUrl = api_comm.getBaseApiUrl() + cfg.apiAmbientDataPath;
+                int httpCode = EnvironmentDataJSON::IOEnvironmentData(targetApiUrl, api_comm.getAccessToken(), item->timestamp,
+                                                                      item->light, item->temperature, item->humidity, item->pressure,
+                                                                      item->samples, item->windowEnd);
+
+                if (httpCode == 200 || httpCode == 204) {
+                    // Éxito: Mover a 'archive'
+                    EventLog::log<EventId::PENDING_AMBIENT_SENT>(*this, timeMgr, internalTempForLog, fileNameOnly);
+                    String archivePath = String(ARCHIVE_ENVIRONMENTAL_DIR) + "/" + fileNameOnly;
+                    archiveFile(item->path, archivePath);
+                } else if (httpCode == 401) {
+                    // Error de Auth: No hacer nada, esperar refresco de token
+                    EventLog::log<EventId::PENDING_AMBIENT_AUTH_ERROR>(*this, timeMgr, internalTempForLog, fileNameOnly, httpCode);
                 } else {
-                     ErrorLogger::logToSdOnly(*this, timeMgr, LogLevel::WARNING, "Empty/unreadable pending ambient file: " + fileNameOnly, internalTempForLog);
+                    // Otro error (500, timeout, etc): Reintentar en la próxima vuelta
+                    EventLog::log<EventId::PENDING_AMBIENT_SEND_FAILED>(*this, timeMgr, internalTempForLog, fileNameOnly, httpCode);
                 }
-                entry = ambientPendingDir.openNextFile(); // Siguiente archivo
+            } else if (item->status == PendingItemStatus::CORRUPTED) {
+                // Error de parseo: JSON corrupto, no se puede reenviar
+                EventLog::log<EventId::PENDING_AMBIENT_PARSE_FAILED>(*this, timeMgr, internalTempForLog, fileNameOnly);
+                // (Considerar mover a un directorio "corrupto")
             } else {
-                entry.close(); // Cierra el directorio o archivo no procesado
-                entry = ambientPendingDir.openNextFile(); // Siguiente entrada
+                EventLog::log<EventId::PENDING_AMBIENT_UNREADABLE>(*this, timeMgr, internalTempForLog, fileNameOnly);
             }
+            prefetcher.release(item);
+            continue;
         }
-        if(entry) entry.close(); 
-        ambientPendingDir.close();
-    }
 
-    // --- 2. Procesar Datos de Captura Pendientes (capture_pending) ---
-    #ifdef ENABLE_DEBUG_SERIAL
-        Serial.println(F("[SDManager_Pending] Checking for pending capture data..."));
-    #endif
-    File capturePendingDir = SD_MMC.open(CAPTURE_PENDING_DIR);
-    if (!capturePendingDir) return false;
-    
-    // Estrategia: Obtener todos los archivos JSON térmicos primero
-    std::vector<String> thermalJsonFiles;
-    File entryCap = capturePendingDir.openNextFile();
-    while(entryCap){
-        if(!entryCap.isDirectory() && String(entryCap.name()).endsWith("_thermal.json")){
-            thermalJsonFiles.push_back(String(entryCap.path()));
-        }
-        entryCap.close(); 
-        entryCap = capturePendingDir.openNextFile();
-    }
-    capturePendingDir.close();
-
-    // Itera sobre los archivos JSON encontrados
-    for (const String& thermalJsonPath : thermalJsonFiles) {
-        workDone = true;
-        // Extrae el nombre base (ej. "20251031_100000")
-        String baseName = thermalJsonPath.substring(thermalJsonPath.lastIndexOf('/') + 1);
-        baseName = baseName.substring(0, baseName.indexOf("_thermal.json"));
-        // Construye las rutas esperadas
-        String visualJpgPath = String(CAPTURE_PENDING_DIR) + "/" + baseName + "_visual.jpg";
+        const String& baseName = item->name;
         String thermalFileNameOnly = baseName + "_thermal.json";
-        
         #ifdef ENABLE_DEBUG_SERIAL
             Serial.println("[SDManager_Pending] Processing thermal file: " + thermalFileNameOnly);
         #endif
 
         // Diferenciar entre par completo o archivo térmico "huérfano"
-        if (SD_MMC.exists(visualJpgPath.c_str())) {
+        if (!item->jpegPath.isEmpty()) {
             // --- CASO 1: Par completo (Térmica + Visual) ---
             #ifdef ENABLE_DEBUG_SERIAL
                 Serial.println("[SDManager_Pending]   -> Visual counterpart found. Processing as a pair.");
             #endif
-            
-            String visualFileNameOnly = baseName + "_visual.jpg";
-            String thermalJsonContent = readFileToString(thermalJsonPath.c_str());
-            size_t jpegLength = 0;
-            uint8_t* jpegImage = readBinaryFileToBuffer(visualJpgPath.c_str(), jpegLength);
-
-            // Extraer timestamp del JSON térmico
-            JsonDocument doc;
-            String timestamp = "0000-00-00_00:00:00";
-            DeserializationError error = deserializeJson(doc, thermalJsonContent);
-            if (!error) timestamp = doc["timestamp"] | timestamp;
-
-            float* thermalDataArray = parseThermalJson(thermalJsonContent);
 
             // VERIFICACIÓN: Si el JSON térmico o la imagen están corruptos/ilegibles
-            if (!thermalDataArray || !jpegImage) {
-                ErrorLogger::logToSdOnly(*this, timeMgr, LogLevel::ERROR, "Corrupted pending pair: " + baseName + ". Deleting.", internalTempForLog);
-                deleteFile(thermalJsonPath.c_str());
-                deleteFile(visualJpgPath.c_str());
-                free(jpegImage); // Libera si solo uno de los dos falló
-                free(thermalDataArray);
+            if (item->status != PendingItemStatus::READY) {
+                EventLog::log<EventId::PENDING_PAIR_CORRUPTED>(*this, timeMgr, internalTempForLog, baseName);
+                deleteFile(item->path.c_str());
+                deleteFile(item->jpegPath.c_str());
+                prefetcher.release(item);
                 continue; // Siguiente archivo
             }
 
             int httpCode = MultipartDataSender::IOThermalAndImageData(
                 api_comm.getBaseApiUrl() + cfg.apiCaptureDataPath,
                 api_comm.getAccessToken(),
-                timestamp, 
-                thermalDataArray,
-                jpegImage,
-                jpegLength
+                item->timestamp,
+                item->thermal,
+                item->jpeg,
+                item->jpegLength,
+                &item->vegetation
             );
 
             if (httpCode >= 200 && httpCode < 300) { // Éxito
-                archiveFile(thermalJsonPath, String(ARCHIVE_CAPTURES_DIR) + "/" + thermalFileNameOnly);
-                archiveFile(visualJpgPath, String(ARCHIVE_CAPTURES_DIR) + "/" + visualFileNameOnly);
+                archiveFile(item->path, String(ARCHIVE_CAPTURES_DIR) + "/" + thermalFileNameOnly);
+                archiveFile(item->jpegPath, String(ARCHIVE_CAPTURES_DIR) + "/" + baseName + "_visual.jpg");
             } else { // Fallo (Auth, Server Error, etc)
-                 ErrorLogger::logToSdOnly(*this, timeMgr, LogLevel::WARNING, "Failed to send pending pair " + baseName + ", HTTP: " + String(httpCode), internalTempForLog);
+                 EventLog::log<EventId::PENDING_PAIR_SEND_FAILED>(*this, timeMgr, internalTempForLog, baseName, httpCode);
             }
-            free(thermalDataArray);
-            free(jpegImage);
 
         } else {
             // --- CASO 2: Archivo térmico huérfano (sin contraparte visual) ---
@@ -577,22 +1274,16 @@ bool SDManager::processPendingApiCalls(API& api_comm, TimeManager& timeMgr, Conf
                 Serial.println("[SDManager_Pending]   -> No visual counterpart. Processing as thermal-only.");
             #endif
 
-            String thermalJsonContent = readFileToString(thermalJsonPath.c_str());
-            if (thermalJsonContent.isEmpty()) {
-                ErrorLogger::logToSdOnly(*this, timeMgr, LogLevel::ERROR, "Unreadable pending thermal-only file: " + thermalFileNameOnly + ". Deleting.", internalTempForLog);
-                deleteFile(thermalJsonPath.c_str());
+            if (item->status == PendingItemStatus::UNREADABLE) {
+                EventLog::log<EventId::PENDING_THERMAL_UNREADABLE>(*this, timeMgr, internalTempForLog, thermalFileNameOnly);
+                deleteFile(item->path.c_str());
+                prefetcher.release(item);
                 continue; 
             }
-
-            JsonDocument doc;
-            String timestamp = "0000-00-00_00:00:00";
-            DeserializationError error = deserializeJson(doc, thermalJsonContent);
-            if (!error) timestamp = doc["timestamp"] | timestamp;
-
-            float* thermalDataArray = parseThermalJson(thermalJsonContent);
-            if (!thermalDataArray) { // JSON Corrupto
-                ErrorLogger::logToSdOnly(*this, timeMgr, LogLevel::ERROR, "Corrupted pending thermal-only JSON: " + thermalFileNameOnly + ". Deleting.", internalTempForLog);
-                deleteFile(thermalJsonPath.c_str());
+            if (item->status == PendingItemStatus::CORRUPTED) { // JSON Corrupto
+                EventLog::log<EventId::PENDING_THERMAL_CORRUPTED>(*this, timeMgr, internalTempForLog, thermalFileNameOnly);
+                deleteFile(item->path.c_str());
+                prefetcher.release(item);
                 continue;
             }
             
@@ -600,24 +1291,266 @@ bool SDManager::processPendingApiCalls(API& api_comm, TimeManager& timeMgr, Conf
             int httpCode = MultipartDataSender::IOThermalAndImageData(
                 api_comm.getBaseApiUrl() + cfg.apiCaptureDataPath,
                 api_comm.getAccessToken(),
-                timestamp,
-                thermalDataArray,
+                item->timestamp,
+                item->thermal,
                 nullptr, // Sin imagen
                 0        // Sin tamaño
             );
 
             if (httpCode >= 200 && httpCode < 300) { // Éxito
-                archiveFile(thermalJsonPath, String(ARCHIVE_CAPTURES_DIR) + "/" + thermalFileNameOnly);
+                archiveFile(item->path, String(ARCHIVE_CAPTURES_DIR) + "/" + thermalFileNameOnly);
             } else { // Fallo
-                ErrorLogger::logToSdOnly(*this, timeMgr, LogLevel::WARNING, "Failed to send pending thermal-only " + baseName + ", HTTP: " + String(httpCode), internalTempForLog);
+                EventLog::log<EventId::PENDING_THERMAL_SEND_FAILED>(*this, timeMgr, internalTempForLog, baseName, httpCode);
             }
-            free(thermalDataArray);
         }
+        prefetcher.release(item);
     }
+    prefetcher.end();
+
+    #ifdef ENABLE_DEBUG_SERIAL
+        const PendingPrefetchStats& prefetchStats = prefetcher.stats();
+        Serial.printf("[SDManager_Pending] Drain: %d attempted, %u loaded (%s), load %u ms, waited %u ms\n",
+                      itemsAttempted, (unsigned)prefetchStats.loaded, prefetchStats.threaded ? "reader task" : "inline",
+                      (unsigned)prefetchStats.loadMs, (unsigned)prefetchStats.waitMs);
+    #endif
     
     return workDone;
 }
 
+// --- Política de Backlog (cortes prolongados) ---
+
+void SDManager::compactPendingBacklog(TimeManager& timeMgr, Config& cfg, float internalTempForLog) {
+    // Sin turno para toda la pasada: los helpers toman uno por listado y por archivo
+    if (!_sdAvailable) return;
+
+    // Sin hora válida no se puede saber qué es "antiguo"
+    time_t now = timeMgr.getCurrentEpochTime();
+    if (now <= 0) return;
+
+    int thinnedFiles = 0;
+    int summarizedFiles = 0;
+    int cappedFiles = 0;
+
+    if (cfg.backlog_thin_after_hours > 0 && cfg.backlog_thin_interval_minutes > 0) {
+        time_t cutoff = now - (time_t)cfg.backlog_thin_after_hours * 3600;
+        thinnedFiles = _thinPendingCaptures(cutoff, cfg.backlog_thin_interval_minutes);
+    }
+
+    if (cfg.backlog_summary_after_hours > 0 && cfg.backlog_summary_bucket_minutes > 0) {
+        time_t cutoff = now - (time_t)cfg.backlog_summary_after_hours * 3600;
+        summarizedFiles = _summarizePendingAmbient(cutoff, cfg.backlog_summary_bucket_minutes);
+    }
+
+    if (cfg.backlog_max_pending_mb > 0) {
+        cappedFiles = _enforcePendingByteCap((uint64_t)cfg.backlog_max_pending_mb * 1024ULL * 1024ULL);
+    }
+
+    if (thinnedFiles > 0 || summarizedFiles > 0 || cappedFiles > 0) {
+        EventLog::log<EventId::BACKLOG_COMPACTED>(*this, timeMgr, internalTempForLog, thinnedFiles, summarizedFiles, cappedFiles);
+    }
+}
+
+// (Helper backlog: Una captura (solo térmica) por intervalo; el resto pasa a 'archive')
+int SDManager::_thinPendingCaptures(time_t cutoff, int intervalMinutes) {
+    std::vector<FileInfo> thermalFiles = _collectTimestampedFiles(CAPTURE_PENDING_DIR, "_thermal.json");
+    const time_t bucketSeconds = (time_t)intervalMinutes * 60;
+    time_t lastKeptBucket = -1;
+    int movedCount = 0;
+
+    // Archivos ordenados (más antiguo primero): el primero de cada intervalo se conserva.
+    // Al ser determinista, ejecuciones sucesivas conservan siempre la misma captura.
+    for (const FileInfo& info : thermalFiles) {
+        if (info.timestamp >= cutoff || PhaseDeadline::expired()) break; // Determinista: el siguiente ciclo sigue donde quedó
+        SdIoGuard ioGuard(SdIoClass::MAINTENANCE); // Un turno por captura (térmica + JPEG)
+
+        String thermalName = info.path.substring(info.path.lastIndexOf('/') + 1);
+        String baseName = thermalName.substring(0, thermalName.indexOf("_thermal.json"));
+        String visualName = baseName + "_visual.jpg";
+        String visualPath = String(CAPTURE_PENDING_DIR) + "/" + visualName;
+
+        // El JPEG nunca se sube desde el backlog antiguo; la copia completa queda en 'archive'
+        if (SD_MMC.exists(visualPath.c_str()) &&
+            moveFile(visualPath, String(ARCHIVE_CAPTURES_DIR) + "/" + visualName)) {
+            movedCount++;
+        }
+
+        time_t bucket = info.timestamp / bucketSeconds;
+        if (bucket != lastKeptBucket) {
+            lastKeptBucket = bucket; // Representante del intervalo: se mantiene pendiente
+            continue;
+        }
+        if (moveFile(info.path, String(ARCHIVE_CAPTURES_DIR) + "/" + thermalName)) {
+            movedCount++;
+        }
+    }
+    return movedCount;
+}
+
+// (Helper backlog: Promedia los datos ambientales de cada ventana en un único archivo)
+int SDManager::_summarizePendingAmbient(time_t cutoff, int bucketMinutes) {
+    std::vector<FileInfo> envFiles = _collectTimestampedFiles(AMBIENT_PENDING_DIR, "_env.json");
+    const time_t bucketSeconds = (time_t)bucketMinutes * 60;
+    int movedCount = 0;
+
+    size_t i = 0;
+    while (i < envFiles.size() && envFiles[i].timestamp < cutoff && !PhaseDeadline::expired()) {
+        // Agrupa los archivos consecutivos de la misma ventana (incluye resúmenes previos)
+        time_t bucket = envFiles[i].timestamp / bucketSeconds;
+        size_t groupEnd = i;
+        while (groupEnd < envFiles.size() && envFiles[groupEnd].timestamp < cutoff &&
+               envFiles[groupEnd].timestamp / bucketSeconds == bucket) {
+            groupEnd++;
+        }
+        if (groupEnd - i < 2) { // Nada que agregar
+            i = groupEnd;
+            continue;
+        }
+
+        // Acumula sumas ponderadas por el número de muestras de cada archivo
+        String firstTimestamp;
+        String lastTimestamp; // Fin de la ventana: último timestamp (o fin de un resumen previo)
+        int totalSamples = 0;
+        float sums[4] = {0, 0, 0, 0};
+        int counts[4] = {0, 0, 0, 0};
+        const char* keys[4] = {"light", "temperature", "humidity", "pressure"};
+        std::vector<bool> parsed(groupEnd - i, false);
+        for (size_t k = i; k < groupEnd; ++k) {
+            JsonDocument doc;
+            String content;
+            {
+                SdIoGuard ioGuard(SdIoClass::MAINTENANCE); // Un turno por archivo
+                content = readFileToString(envFiles[k].path.c_str());
+            }
+            if (deserializeJson(doc, content)) continue; // Corrupto: se deja como está en pendientes
+            parsed[k - i] = true;
+            int samples = doc["samples"] | 1;
+            if (firstTimestamp.isEmpty()) firstTimestamp = doc["timestamp"] | "";
+            String fileEnd = doc["window_end"] | "";
+            if (fileEnd.isEmpty()) fileEnd = doc["timestamp"] | "";
+            if (!fileEnd.isEmpty()) lastTimestamp = fileEnd;
+            totalSamples += samples;
+            for (int f = 0; f < 4; ++f) {
+                float value = doc[keys[f]] | NAN;
+                if (!isnan(value)) {
+                    sums[f] += value * samples;
+                    counts[f] += samples;
+                }
+            }
+        }
+        if (totalSamples == 0 || firstTimestamp.isEmpty()) {
+            i = groupEnd;
+            continue;
+        }
+
+        JsonDocument summary;
+        summary["timestamp"] = firstTimestamp;
+        const int decimals[4] = {2, 2, 1, 2};
+        for (int f = 0; f < 4; ++f) {
+            if (counts[f] > 0) summary[keys[f]] = serialized(String(sums[f] / counts[f], decimals[f]));
+            else summary[keys[f]] = nullptr;
+        }
+        summary["samples"] = totalSamples;
+        summary["window_end"] = lastTimestamp;
+        String summaryJson;
+        serializeJson(summary, summaryJson);
+
+        // Nombre: YYYYMMDD_HHMMSS del primer archivo + "_sum_env.json"
+        String firstName = envFiles[i].path.substring(envFiles[i].path.lastIndexOf('/') + 1);
+        String summaryPath = String(AMBIENT_PENDING_DIR) + "/" + firstName.substring(0, 15) + "_sum_env.json";
+        bool summaryWritten;
+        {
+            SdIoGuard ioGuard(SdIoClass::MAINTENANCE);
+            summaryWritten = writeTextFile(summaryPath, summaryJson);
+        }
+        if (!summaryWritten) {
+            i = groupEnd;
+            continue; // Sin resumen escrito no se toca ningún original
+        }
+
+        for (size_t k = i; k < groupEnd; ++k) {
+            const String& path = envFiles[k].path;
+            if (path == summaryPath || !parsed[k - i]) continue; // Resumen recién (re)escrito o archivo corrupto
+            SdIoGuard ioGuard(SdIoClass::MAINTENANCE);
+            String name = path.substring(path.lastIndexOf('/') + 1);
+            if (name.endsWith("_sum_env.json")) {
+                deleteFile(path.c_str()); // Resumen anterior, ya incluido en el nuevo
+            } else if (moveFile(path, String(ARCHIVE_ENVIRONMENTAL_DIR) + "/" + name)) {
+                movedCount++;
+            }
+        }
+        i = groupEnd;
+    }
+    return movedCount;
+}
+
+// (Helper backlog: Limita el total de bytes pendientes archivando lo más antiguo)
+int SDManager::_enforcePendingByteCap(uint64_t maxBytes) {
+    std::vector<FileInfo> files = _collectTimestampedFiles(AMBIENT_PENDING_DIR, "");
+    std::vector<FileInfo> captureFiles = _collectTimestampedFiles(CAPTURE_PENDING_DIR, "");
+    files.insert(files.end(), captureFiles.begin(), captureFiles.end());
+
+    uint64_t totalBytes = 0;
+    for (const FileInfo& info : files) totalBytes += info.size;
+    if (totalBytes <= maxBytes) return 0;
+
+    std::sort(files.begin(), files.end());
+    int movedCount = 0;
+    for (const FileInfo& info : files) {
+        if (totalBytes <= maxBytes || PhaseDeadline::expired()) break;
+        SdIoGuard ioGuard(SdIoClass::MAINTENANCE); // Un turno por archivo
+        String name = info.path.substring(info.path.lastIndexOf('/') + 1);
+        String archiveDir = info.path.startsWith(AMBIENT_PENDING_DIR) ? ARCHIVE_ENVIRONMENTAL_DIR : ARCHIVE_CAPTURES_DIR;
+        if (moveFile(info.path, archiveDir + "/" + name)) {
+            totalBytes -= info.size;
+            movedCount++;
+        }
+    }
+    return movedCount;
+}
+
+// (Helper: Lista archivos con timestamp completo y tamaño, ordenados del más antiguo al más reciente)
+std::vector<SDManager::FileInfo> SDManager::_collectTimestampedFiles(const char* dirPath, const char* suffix, bool includeUndated) {
+    SdIoGuard ioGuard(SdIoClass::MAINTENANCE); // Un turno para el listado (dentro del vaciado conserva QUEUE)
+    std::vector<FileInfo> files;
+    File root = SD_MMC.open(dirPath);
+    if (!root || !root.isDirectory()) {
+        if (root) root.close();
+        return files;
+    }
+
+    File entry = root.openNextFile();
+    while (entry) {
+        if (!entry.isDirectory()) {
+            String name = String(entry.name());
+            time_t timestamp = _parseFullTimestampFromFilename(name);
+            if ((timestamp > 0 || includeUndated) && name.endsWith(suffix)) {
+                files.push_back({String(entry.path()), timestamp, (uint64_t)entry.size()});
+            }
+        }
+        entry.close();
+        entry = root.openNextFile();
+    }
+    root.close();
+
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+// (Helper para parsear YYYYMMDD_HHMMSS de nombres de archivo a epoch time)
+time_t SDManager::_parseFullTimestampFromFilename(const String& filename) {
+    struct tm t{};
+    if (filename.length() < 15) return 0;
+
+    if (sscanf(filename.c_str(), "%4d%2d%2d_%2d%2d%2d", &t.tm_year, &t.tm_mon, &t.tm_mday,
+               &t.tm_hour, &t.tm_min, &t.tm_sec) == 6) {
+        t.tm_year -= 1900;
+        t.tm_mon -= 1;
+        t.tm_isdst = -1;
+        return mktime(&t);
+    }
+    return 0; // Falla de parseo
+}
+
 // (Helper para parsear YYYYMMDD... de nombres de archivo a epoch time)
 time_t SDManager::_parseTimestampFromFilename(const String& filename, TimeManager& timeMgr) {
     struct tm t{};
@@ -640,29 +1573,33 @@ time_t SDManager::_parseTimestampFromFilename(const String& filename, TimeManage
 uint64_t SDManager::_manageDirectory(const String& dirPath, TimeManager& timeMgr, int maxFileAgeDays, 
                                    uint64_t minTotalFreeBytes, uint64_t& currentTotalUsedBytes, uint64_t totalSdSizeBytes) {
     if (!_sdAvailable) return 0;
-
-    File root = SD_MMC.open(dirPath.c_str());
-    if (!root || !root.isDirectory()) {
-        if(root) root.close();
-        return 0;
-    }
+    // Con el plazo agotado solo queda la fase 2, y solo si falta espacio
+    if (PhaseDeadline::expired() && (totalSdSizeBytes - currentTotalUsedBytes) >= minTotalFreeBytes) return 0;
 
     // 1. Recopilar todos los archivos y sus timestamps
     std::vector<FileInfo> files;
-    File entry = root.openNextFile();
-    while (entry) {
-        if (!entry.isDirectory()) {
-            String path = String(entry.path()); 
-            String name = String(entry.name());
-            time_t timestamp = _parseTimestampFromFilename(name, timeMgr);
-            if (timestamp > 0) { // Solo gestiona archivos con timestamp parseable
-                files.push_back({path, timestamp});
+    {
+        SdIoGuard ioGuard(SdIoClass::MAINTENANCE); // Un turno para el listado
+        File root = SD_MMC.open(dirPath.c_str());
+        if (!root || !root.isDirectory()) {
+            if(root) root.close();
+            return 0;
+        }
+        File entry = root.openNextFile();
+        while (entry) {
+            if (!entry.isDirectory()) {
+                String path = String(entry.path()); 
+                String name = String(entry.name());
+                time_t timestamp = _parseTimestampFromFilename(name, timeMgr);
+                if (timestamp > 0) { // Solo gestiona archivos con timestamp parseable
+                    files.push_back({path, timestamp});
+                }
             }
+            entry.close();
+            entry = root.openNextFile();
         }
-        entry.close();
-        entry = root.openNextFile();
+        root.close();
     }
-    root.close();
 
     if (files.empty()) return 0;
     
@@ -678,9 +1615,11 @@ uint64_t SDManager::_manageDirectory(const String& dirPath, TimeManager& timeMgr
         int filesDeletedByAge = 0;
     #endif
     for (auto it = files.begin(); it != files.end(); /* no incrementar aquí */) {
+        if (PhaseDeadline::expired()) break; // El resto se poda en el próximo ciclo; la fase 2 sí se ejecuta
         bool removed = false;
         // Solo borra por antigüedad si tenemos una hora actual válida
         if (currentTime > 0 && (currentTime - it->timestamp) > maxAgeSeconds) {
+            SdIoGuard ioGuard(SdIoClass::MAINTENANCE); // Un turno por archivo
             File f = SD_MMC.open(it->path.c_str());
             uint64_t fileSize = f ? f.size() : 0;
             if(f) f.close();
@@ -707,8 +1646,10 @@ uint64_t SDManager::_manageDirectory(const String& dirPath, TimeManager& timeMgr
     #endif
     // Itera sobre los archivos restantes (ya ordenados, más antiguos primero)
     for (auto it = files.begin(); it != files.end(); /* no incrementar aquí */) {
-        // Comprueba si el espacio libre global es menor que el mínimo requerido
+        // Comprueba si el espacio libre global es menor que el mínimo requerido. No se cancela
+        // con el plazo: dejar la tarjeta por debajo del mínimo haría fallar las capturas
         if ((totalSdSizeBytes - currentTotalUsedBytes) < minTotalFreeBytes) {
+            SdIoGuard ioGuard(SdIoClass::MAINTENANCE); // Un turno por archivo
             File f = SD_MMC.open(it->path.c_str());
             uint64_t fileSize = f ? f.size() : 0;
             if(f) f.close();
@@ -737,10 +1678,16 @@ void SDManager::manageAllStorage(TimeManager& timeMgr, int maxFileAgeDays, float
     if (!_sdAvailable) return;
 
     // --- OPTIMIZACIÓN: Evitar escaneo costoso si el disco no está lleno ---
-    uint64_t totalBytes = SD_MMC.totalBytes();
+    uint64_t totalBytes;
+    uint64_t usedBytes;
+    {
+        // Sin turno para toda la limpieza: _manageDirectory() toma uno por listado y por archivo
+        SdIoGuard ioGuard(SdIoClass::MAINTENANCE);
+        totalBytes = SD_MMC.totalBytes();
+        usedBytes = SD_MMC.usedBytes();
+    }
     if (totalBytes == 0) return;
-    
-    uint64_t usedBytes = SD_MMC.usedBytes();
+
     float usagePercent = ((float)usedBytes / totalBytes) * 100.0f;
 
     // Define un umbral para activar la limpieza (ej. 90%)
@@ -764,6 +1711,7 @@ void SDManager::manageAllStorage(TimeManager& timeMgr, int maxFileAgeDays, float
     _manageDirectory(LOG_DIR, timeMgr, maxFileAgeDays, minFreeBytesAbsolute, usedBytes, totalBytes);
     _manageDirectory(ARCHIVE_ENVIRONMENTAL_DIR, timeMgr, maxFileAgeDays, minFreeBytesAbsolute, usedBytes, totalBytes);
     _manageDirectory(ARCHIVE_CAPTURES_DIR, timeMgr, maxFileAgeDays, minFreeBytesAbsolute, usedBytes, totalBytes);
+    _manageDirectory(ARCHIVE_TIMESERIES_DIR, timeMgr, maxFileAgeDays, minFreeBytesAbsolute, usedBytes, totalBytes);
 
     // (Logs de depuración finales)
 }
@@ -774,21 +1722,29 @@ float* SDManager::parseThermalJson(const String& jsonContent) {
     DeserializationError error = deserializeJson(thermalDoc, jsonContent);
     if (error) return nullptr;
 
+    // Aloja memoria para el array de floats
+    float* thermalDataArray = (float*)malloc(MultipartDataSender::THERMAL_PIXELS * sizeof(float));
+    if (!thermalDataArray) return nullptr; // Falla de alocación
+
+    if (!readThermalArray(thermalDoc, thermalDataArray)) {
+        free(thermalDataArray);
+        return nullptr;
+    }
+    return thermalDataArray;
+}
+
+bool SDManager::readThermalArray(JsonDocument& thermalDoc, float* out) {
     JsonArray temps = thermalDoc["temperatures"].as<JsonArray>();
     // Verifica que el array exista y tenga el tamaño correcto (768)
     if (temps.isNull() || temps.size() != MultipartDataSender::THERMAL_PIXELS) {
-        return nullptr;
+        return false;
     }
 
-    // Aloja memoria para el array de floats
-    float* thermalDataArray = (float*)malloc(MultipartDataSender::THERMAL_PIXELS * sizeof(float));
-    if (!thermalDataArray) return nullptr; // Falla de alocación
-
     // Copia los valores
     for (int i = 0; i < MultipartDataSender::THERMAL_PIXELS; ++i) {
-        thermalDataArray[i] = temps[i].as<float>();
+        out[i] = temps[i].as<float>();
     }
-    return thermalDataArray;
+    return true;
 }
 
 // (Helper para archivar o borrar archivos pendientes procesados)
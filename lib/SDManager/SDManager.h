@@ -14,6 +14,17 @@
 #include "ErrorLogger.h"   
 #include "EnvironmentDataJSON.h" 
 #include "MultipartDataSender.h" 
+#include "FlashRing.h"         // Nivel rápido en flash interna para registros pequeños
+#include "ClusterWriter.h"     // Escrituras alineadas al cluster (registros y logs migrados)
+#include "TimeSeriesStore.h"   // Series ambientales diarias en bloques comprimidos
+
+/**
+ * @brief Series diarias de ARCHIVE_TIMESERIES_DIR.
+ */
+enum class SeriesFile : uint8_t {
+    AMBIENT, ///< YYYYMMDD_ambient.ts: lecturas ambientales (columnas TsColumn)
+    THERMAL  ///< YYYYMMDD_thermal.ts: resumen de cada captura (columnas TsThermalColumn)
+};
 
 // Define los niveles de severidad para los logs
 enum class LogLevel {
@@ -22,6 +33,9 @@ enum class LogLevel {
     ERROR
 };
 
+// Punto de montaje VFS de la tarjeta (rutas stdio/POSIX: SD_MOUNT_POINT + ruta)
+#define SD_MOUNT_POINT "/sdcard"
+
 // --- Estructura de Directorios Estándar ---
 #define LOG_DIR "/logs"                 // Logs de eventos diarios
 #define SECURE_DATA_DIR "/secure_data"  // Para estado de API (tokens)
@@ -33,9 +47,55 @@ enum class LogLevel {
 #define ARCHIVE_DIR "/archive"
 #define ARCHIVE_ENVIRONMENTAL_DIR ARCHIVE_DIR "/environmental"
 #define ARCHIVE_CAPTURES_DIR ARCHIVE_DIR "/captures"
+#define ARCHIVE_TIMESERIES_DIR ARCHIVE_DIR "/timeseries" // Series diarias (YYYYMMDD_ambient.ts, YYYYMMDD_thermal.ts)
+
+// Tope de días por consulta de series (un archivo por día)
+#define SERIES_QUERY_MAX_DAYS 31
+
+// --- Registros con cabecera (writeTextFile / writeBinaryFile) ---
+// [MAGIC "REC1"][LONGITUD u32][CRC-32 del contenido u32][CONTENIDO], little-endian.
+// Se escriben en RECORD_TMP_DIR, se sincronizan (fsync) y se renombran a su ruta final:
+// un corte de luz deja como mucho un temporal, nunca un registro a medias.
+#define RECORD_MAGIC "REC1"
+#define RECORD_HEADER_LEN 12
+#define RECORD_TMP_DIR "/tmp_records"   // Temporales de escritura (se revisan al montar)
+#define QUARANTINE_DIR "/quarantine"    // Registros con cabecera inválida (no se reenvían)
 
 // Archivo de estado de la API
 #define API_STATE_FILENAME SECURE_DATA_DIR "/api_state.json" 
+#define API_STATE_HOT_NAME "api_state"  // Mismo estado en el nivel rápido (FlashRing::writeState)
+
+// Registros del nivel rápido que se pasan a la SD en cada llamada a migrateHotTier()
+#define HOT_TIER_MIGRATE_BATCH 512
+
+// --- Salud de la tarjeta (ver checkCardHealth) ---
+#define SD_HEALTH_FAIL_THRESHOLD 3               // Fallos seguidos que dan la tarjeta por caída
+#define SD_HEALTH_PROBE_INTERVAL_MS 30000UL      // Sondeo de la tarjeta montada
+#define SD_HEALTH_PROBE_FAIL_THRESHOLD 2         // Sondeos fallidos seguidos que desmontan la tarjeta
+#define SD_REMOUNT_BACKOFF_MIN_MS 5000UL         // Primer reintento de montaje
+#define SD_REMOUNT_BACKOFF_MAX_MS 600000UL       // Tope del backoff exponencial (10 min)
+#define SD_WRITE_BUFFER_MAX_BYTES (2UL * 1024 * 1024) // Escrituras retenidas en PSRAM sin tarjeta
+
+/**
+ * @brief Métricas de salud de la tarjeta SD (desde el arranque).
+ */
+struct SDHealthStats {
+    uint32_t operations = 0;          ///< Escrituras/movimientos intentados en la SD
+    uint32_t failures = 0;            ///< Operaciones fallidas
+    uint32_t consecutiveFailures = 0; ///< Fallos seguidos (se reinicia con cada éxito)
+    uint32_t unmounts = 0;            ///< Veces que la tarjeta se dio por caída y se desmontó
+    uint32_t remountAttempts = 0;     ///< Intentos de montaje tras una caída (o un arranque sin tarjeta)
+    uint32_t remounts = 0;            ///< Montajes con éxito tras una caída
+    uint32_t lastRemountMs = 0;       ///< millis() del último remontaje (0 = nunca)
+    uint32_t nextRemountInMs = 0;     ///< Espera hasta el siguiente intento (0 = montada)
+    uint32_t bufferedWrites = 0;      ///< Escrituras retenidas ahora en PSRAM
+    uint32_t bufferedBytes = 0;       ///< Bytes retenidos ahora en PSRAM
+    uint32_t flushedWrites = 0;       ///< Escrituras retenidas que llegaron a la SD
+    uint32_t droppedWrites = 0;       ///< Escrituras perdidas (buffer lleno o sin PSRAM)
+    uint32_t quarantinedRecords = 0;  ///< Registros cortados movidos a QUARANTINE_DIR
+    uint32_t recoveredRecords = 0;    ///< Temporales completos renombrados a su destino al montar
+    uint32_t lastRecoveryScanMs = 0;  ///< Duración de la última pasada de recuperación
+};
 
 class API; // Declaración anticipada
 
@@ -49,6 +109,21 @@ class API; // Declaración anticipada
  * 3. Almacenamiento de datos pendientes (para reintentos).
  * 4. Procesamiento y reenvío de datos pendientes.
  * 5. Limpieza automática de almacenamiento (logs y archivos antiguos).
+ *
+ * Almacenamiento por niveles: si existe la partición 'hotring', los registros pequeños
+ * (líneas de log, tramas de EventLog, JSON ambientales y el estado de la API) se escriben
+ * en un anillo en la flash interna (FlashRing) y `migrateHotTier()` los pasa a la SD por
+ * lotes. Las capturas (térmica + JPEG) siempre van a la SD. Sin tarjeta, el anillo sigue
+ * recogiendo los registros pequeños (modo degradado).
+ *
+ * Salud de la tarjeta: cada error de E/S en la SD (apertura, escritura, sincronización)
+ * cuenta para un contador de fallos; los errores lógicos (origen inexistente, destino ya
+ * existente, directorio borrado que se puede recrear) no cuentan. Tras
+ * SD_HEALTH_FAIL_THRESHOLD fallos seguidos (o SD_HEALTH_PROBE_FAIL_THRESHOLD sondeos
+ * periódicos fallidos seguidos) la tarjeta se
+ * desmonta y `checkCardHealth()` la vuelve a montar con backoff exponencial, verificando
+ * de nuevo los directorios. Mientras no hay tarjeta, las escrituras de archivos (capturas)
+ * se retienen en PSRAM y se vuelcan al remontar.
  */
 class SDManager {
 public:
@@ -56,8 +131,10 @@ public:
 
     /**
      * @brief Inicializa la tarjeta SD usando el periférico SD_MMC (modo 1-bit).
-     * Intenta montar la tarjeta y crea la estructura de directorios base.
-     * @return True si la SD está inicializada y disponible, false en caso contrario.
+     * Monta antes el nivel rápido en flash (independiente de la tarjeta), después
+     * intenta montar la tarjeta y crea la estructura de directorios base.
+     * @return True si la SD está inicializada y disponible, false en caso contrario
+     * (consultar isHotTierAvailable() para saber si se puede seguir en modo degradado).
      */
     bool begin();
 
@@ -67,9 +144,67 @@ public:
      */
     bool isSDAvailable() const;
 
+    /**
+     * @brief Verifica si el nivel rápido en flash interna (partición 'hotring') está montado.
+     */
+    bool isHotTierAvailable() const;
+
+    /**
+     * @brief Verifica si hay algún destino para los registros pequeños (SD o nivel rápido).
+     * Es la comprobación adecuada antes de logToFile(), appendBinaryLog(), storeSmallFile()
+     * y saveApiState(); las capturas siguen necesitando isSDAvailable().
+     */
+    bool isLocalStorageAvailable() const;
+
+    /**
+     * @brief Verifica si se pueden guardar archivos grandes (capturas): SD montada, o
+     * retenidos en PSRAM hasta que vuelva la tarjeta.
+     */
+    bool isBulkStorageAvailable() const;
+
+    /**
+     * @brief Vigila la tarjeta. Llamar en cada pasada del loop(): es barato si no toca hacer nada.
+     * - Montada: cada SD_HEALTH_PROBE_INTERVAL_MS comprueba que responde (un /logs borrado
+     *   se recrea); la desmonta tras SD_HEALTH_PROBE_FAIL_THRESHOLD sondeos fallidos seguidos.
+     * - Caída (o ausente desde el arranque): reintenta el montaje con backoff exponencial
+     *   (SD_REMOUNT_BACKOFF_MIN_MS..MAX_MS); al montar, recrea los directorios y vuelca
+     *   las escrituras retenidas en PSRAM.
+     * Registra en el log las caídas y los remontajes.
+     * @param timeMgr Referencia al TimeManager (para los logs).
+     * @param internalTempForLog Temperatura interna para los logs.
+     */
+    void checkCardHealth(TimeManager& timeMgr, float internalTempForLog = NAN);
+
+    /**
+     * @brief Métricas de salud de la SD (errores, remontajes, buffer en PSRAM).
+     */
+    SDHealthStats getHealthStats() const;
+
+    /**
+     * @brief Acceso de solo lectura al nivel rápido (métricas del anillo).
+     */
+    const FlashRing& getHotTier() const;
+
+    /**
+     * @brief Contadores acumulados de ClusterWriter (bytes, escrituras al FS, amplificación).
+     */
+    const ClusterWriterStats& getWriterStats() const;
+
+    /**
+     * @brief Tamaño de cluster de la tarjeta montada (0 si no se pudo obtener).
+     */
+    size_t getClusterSize() const;
+
+    /**
+     * @brief Contador de montajes. Un File abierto con otro valor pertenece a un montaje
+     * anterior (la tarjeta se desmontó entre medias) y no se debe seguir leyendo.
+     */
+    uint32_t getMountGeneration() const;
+
     /**
      * @brief Escribe un mensaje de log formateado en un archivo diario en la SD.
-     * Los archivos se nombran /logs/YYYYMMDD_log.txt.
+     * Los archivos se nombran /logs/YYYYMMDD_log.txt. Con el nivel rápido disponible,
+     * la línea se guarda en flash y llega al archivo en la siguiente migración.
      * @param timestamp String con la fecha y hora.
      * @param level Nivel de severidad (INFO, WARNING, ERROR).
      * @param message El mensaje de log.
@@ -78,8 +213,54 @@ public:
      */
     bool logToFile(const String& timestamp, LogLevel level, const String& message, float internalTemp = NAN);
 
+    /**
+     * @brief Añade una trama del log binario (EventLog) al archivo diario en la SD.
+     * Los archivos se nombran /logs/YYYYMMDD_log.bin (o /logs/UPTIME_log.bin sin hora NTP).
+     * Al crear el archivo se escribe la cabecera EVENT_LOG_MAGIC. Con el nivel rápido
+     * disponible, la trama se guarda en flash y llega al archivo en la siguiente migración.
+     * @param fileDate Fecha "YYYYMMDD", o "" si la hora no está sincronizada.
+     * @param frame Trama completa (SYNC + LEN + PAYLOAD + CRC).
+     * @param length Longitud de la trama en bytes.
+     * @return True si la escritura fue exitosa.
+     */
+    bool appendBinaryLog(const String& fileDate, const uint8_t* frame, size_t length);
+
+    /**
+     * @brief Añade una lectura ambiental a la serie del día (ARCHIVE_TIMESERIES_DIR/YYYYMMDD_ambient.ts,
+     * fecha local de `epoch`). Ver TimeSeriesStore para el formato.
+     * @param epoch Época de la medición (0 = hora sin sincronizar: no se guarda).
+     * @return True si la muestra quedó escrita y sincronizada.
+     */
+    bool appendAmbientSample(uint32_t epoch, float light, float temperature, float humidity, float pressure);
+
+    /**
+     * @brief Añade el resumen térmico de una captura a la serie del día (YYYYMMDD_thermal.ts).
+     * @param canopyAvgTemp Media del dosel (NaN si no hay calibración o imagen).
+     * @return True si la muestra quedó escrita y sincronizada.
+     */
+    bool appendThermalSummary(uint32_t epoch, float maxTemp, float minTemp, float avgTemp, float canopyAvgTemp);
+
+    /**
+     * @brief (Ayuda Web Portal) Recorre en orden las muestras de la serie `file` entre `from` y `to`
+     * (épocas, inclusive). Lee como mucho SERIES_QUERY_MAX_DAYS días desde `from`.
+     * @return False si la SD no está disponible o falló una lectura.
+     */
+    bool scanSeries(SeriesFile file, uint32_t from, uint32_t to, TsSampleCallback callback, void* context, TsReadStats* stats = nullptr);
+
+    /**
+     * @brief (Ayuda Web Portal) Mínimo, máximo, suma y número de muestras por columna
+     * entre `from` y `to`. Usa el índice de cada bloque cuando cae entero en el rango.
+     */
+    bool aggregateSeries(SeriesFile file, uint32_t from, uint32_t to, TsAggregate out[TS_COLUMNS], TsReadStats* stats = nullptr);
+
+    /**
+     * @brief Contador de muestras añadidas a las series (el portal lo usa para invalidar su caché).
+     */
+    uint32_t getSeriesGeneration() const;
+
     /**
      * @brief Guarda el estado de la aplicación (ej. tokens API) en un archivo JSON.
+     * Con el nivel rápido disponible se guarda allí (reemplazo atómico) y no en la SD.
      * @note Actualmente guarda en **texto plano**. La encriptación se puede añadir aquí.
      * @param stateJson El string JSON con el estado a guardar.
      * @return True si se guardó exitosamente, false en caso contrario.
@@ -88,6 +269,7 @@ public:
 
     /**
      * @brief Lee el estado de la aplicación desde un archivo JSON.
+     * Busca primero en el nivel rápido y después en la SD (estado de versiones anteriores).
      * @note Actualmente lee **texto plano**.
      * @param stateJsonOut Referencia a un String donde se almacenará el JSON leído.
      * @return True si se leyó exitosamente, false si el archivo no existe o falla.
@@ -115,14 +297,47 @@ public:
 
      /**
      * @brief Escribe datos de texto en una ruta específica (sobrescribe si existe).
+     * El archivo se guarda como registro (cabecera RECORD_MAGIC + longitud + CRC-32)
+     * con escritura en temporal, fsync y rename; se lee con readRecordText().
      * @param fullPath Ruta completa (ej. "/archive/environmental/data.json").
      * @param data Datos (String) a guardar.
      * @return True si la escritura fue exitosa.
      */
     bool writeTextFile(const String& fullPath, const String& data);
 
+    /**
+     * @brief Escribe un archivo de texto pequeño (ej. JSON ambiental) a través del nivel rápido.
+     * Si el nivel rápido está disponible y los datos caben en un registro (FLASH_RING_MAX_DATA),
+     * se guardan en flash y el archivo aparece en `fullPath` tras la siguiente migración.
+     * Si no, equivale a writeTextFile().
+     * @param fullPath Ruta completa en la SD (ej. "/data_pending/ambient/20251031_120000_env.json").
+     * @param data Datos (String) a guardar.
+     * @return True si los datos quedaron guardados en algún nivel.
+     */
+    bool storeSmallFile(const String& fullPath, const String& data);
+
+    /**
+     * @brief Pasa a la SD los registros pendientes del nivel rápido, en orden y por lotes.
+     * Las líneas consecutivas de un mismo archivo se escriben con una sola apertura.
+     * Antes de que el anillo borre un segmento migrado o guarde su cursor, el log abierto se
+     * cierra (volcado + fsync): lo que se borra de la flash ya está sincronizado en la SD.
+     * Llamar antes de compactar y procesar la cola de pendientes, para que vean los
+     * JSON ambientales guardados en flash. No hace nada sin SD o sin nivel rápido.
+     * @param timeMgr Referencia al TimeManager (para el log del resultado).
+     * @param maxRecords Máximo de registros en esta llamada.
+     * @param internalTempForLog Temperatura interna para registrar la migración.
+     * @return Número de registros migrados.
+     */
+    int migrateHotTier(TimeManager& timeMgr, int maxRecords = HOT_TIER_MIGRATE_BATCH, float internalTempForLog = NAN);
+
+    /**
+     * @brief Registros del nivel rápido aún no migrados a la SD (0 sin nivel rápido).
+     */
+    uint32_t hotTierPendingRecords() const;
+
     /**
      * @brief Escribe datos binarios en una ruta específica (sobrescribe si existe).
+     * Mismo formato y protocolo que writeTextFile(); se lee con readRecordBinary().
      * @param fullPath Ruta completa (ej. "/archive/captures/image.jpg").
      * @param data Puntero al buffer de datos binarios.
      * @param length Tamaño de los datos en bytes.
@@ -130,6 +345,54 @@ public:
      */
     bool writeBinaryFile(const String& fullPath, const uint8_t* data, size_t length);
 
+    /**
+     * @brief Lee el contenido de un registro de texto, verificando longitud y CRC.
+     * Los archivos sin cabecera (escritos por versiones anteriores) se devuelven completos.
+     * @param fullPath Ruta completa.
+     * @param dataOut Contenido (vacío si falla).
+     * @return True si existe y es válido.
+     */
+    bool readRecordText(const String& fullPath, String& dataOut);
+
+    /**
+     * @brief Lee el contenido de un registro binario, verificando longitud y CRC.
+     * @note El llamador debe liberar el buffer con free().
+     * @param fullPath Ruta completa.
+     * @param[out] length Longitud del contenido.
+     * @return Buffer con el contenido, o nullptr si no existe o está dañado.
+     */
+    uint8_t* readRecordBinary(const String& fullPath, size_t& length);
+
+    /**
+     * @brief Lee el contenido de un archivo (registro o archivo sin cabecera) en un buffer
+     * reutilizable, terminado en '\0'. Lo usan las lecturas anteriores y PendingPrefetcher.
+     * @param path Ruta completa.
+     * @param[in,out] buffer Buffer del llamador (se amplía con realloc si no cabe; el llamador hace free()).
+     * @param[in,out] capacity Capacidad actual de `buffer`.
+     * @param[out] length Longitud del contenido (0 si falla).
+     * @return True si existe, no está vacío y la longitud/CRC son correctos.
+     */
+    static bool readRecordInto(const char* path, uint8_t*& buffer, size_t& capacity, size_t& length);
+
+    /**
+     * @brief Copia el array "temperatures" (768 valores) de un JSON térmico ya parseado.
+     * @return False si falta el array o no tiene 768 elementos.
+     */
+    static bool readThermalArray(JsonDocument& thermalDoc, float* out);
+
+    /**
+     * @brief Pasada de recuperación tras un corte (se ejecuta en cada montaje de la tarjeta).
+     * Solo lee la cabecera de cada archivo, sin recorrer el contenido:
+     * - Temporales de RECORD_TMP_DIR: si están completos y su destino no existe, se
+     *   renombran a él (el corte fue entre el fsync y el rename); si no, se borran.
+     * - Registros de la cola 'pending' cuya longitud no cuadra con el tamaño del archivo:
+     *   se mueven a QUARANTINE_DIR, así nunca se envían ni se compactan.
+     * Cada listado y cada archivo tratado toma su propio turno (MAINTENANCE).
+     * El resultado se registra en el log desde checkCardHealth().
+     * @return Número de registros puestos en cuarentena.
+     */
+    int recoverTornRecords();
+
     /**
      * @brief Mueve un archivo (usa `rename` de SD_MMC para eficiencia).
      * @param srcPath Ruta de origen completa.
@@ -156,7 +419,8 @@ public:
      * @brief Procesa los datos pendientes (ambientales y de captura) guardados en la SD.
      * * Itera sobre los directorios 'pending'. Intenta reenviar los datos usando
      * el objeto API. Si el envío es exitoso, mueve los archivos al directorio
-     * 'archive' correspondiente.
+     * 'archive' correspondiente. Cada tipo se envía del más antiguo al más reciente,
+     * intercalando ambientales y capturas para repartir el presupuesto del ciclo.
      * * @param api_comm Referencia al objeto API (para tokens y URLs).
      * @param timeMgr Referencia al TimeManager (para logs).
      * @param cfg Referencia a la Configuración (para rutas de API).
@@ -165,6 +429,24 @@ public:
      */
     bool processPendingApiCalls(API& api_comm, TimeManager& timeMgr, Config& cfg, float internalTempForLog = NAN);
 
+    /**
+     * @brief Aplica la política de backlog sobre los directorios 'pending'.
+     * * Pensado para cortes de conexión prolongados (días/semanas). No requiere WiFi.
+     * 1. Capturas más antiguas que `backlog_thin_after_hours`: se conserva solo la
+     *    térmica de una captura por `backlog_thin_interval_minutes`; el resto (y todos
+     *    los JPEG) pasan a 'archive' sin enviarse.
+     * 2. Datos ambientales más antiguos que `backlog_summary_after_hours`: se agregan
+     *    (promedio) en un único archivo `*_sum_env.json` por ventana; los originales
+     *    pasan a 'archive'.
+     * 3. Si los pendientes superan `backlog_max_pending_mb`, los más antiguos pasan a 'archive'.
+     * @note Nunca borra datos originales: la resolución completa se conserva en 'archive'.
+     * Un valor <= 0 en cualquiera de los parámetros desactiva esa regla.
+     * @param timeMgr Referencia al TimeManager (requiere hora válida).
+     * @param cfg Referencia a la Configuración (parámetros backlog_*).
+     * @param internalTempForLog Temperatura interna para registrar la compactación.
+     */
+    void compactPendingBacklog(TimeManager& timeMgr, Config& cfg, float internalTempForLog = NAN);
+
     /**
      * @brief Gestiona el espacio de almacenamiento (logs y archivos).
      * * Borra archivos en `LOG_DIR` y `ARCHIVE_DIR` que sean más antiguos
@@ -172,6 +454,8 @@ public:
      * de `minFreeSpacePercentage` (borrando los más antiguos primero).
      * * @note Contiene una optimización para solo ejecutarse si el disco
      * supera un umbral de uso (ej. 90%).
+     * Con el plazo de la fase agotado (PhaseDeadline) la poda por antigüedad se deja para
+     * el próximo ciclo, pero el borrado por espacio sigue hasta recuperar el mínimo.
      *
      * @param timeMgr Referencia al TimeManager (para obtener la fecha actual).
      * @param maxFileAgeDays Edad máxima de los archivos (días).
@@ -202,12 +486,114 @@ public:
     File getLogFile(const String& path);
 
 private:
+    friend struct BenchmarkAccess; ///< (Solo test/test_benchmarks) acceso a los helpers privados
+    friend struct BacklogPolicyAccess; ///< (Solo test/test_backlog_policy) helpers de la política de backlog
+
     bool _sdAvailable; // Flag de estado de inicialización
+    FlashRing _hotTier; // Nivel rápido en flash interna (registros pequeños)
+    uint32_t _hotTierDroppedLogged; // Descartes del anillo ya registrados en el log
+    size_t _clusterBytes;               // Cluster del FAT (se obtiene al montar)
+    volatile uint32_t _mountGeneration; // Se incrementa en cada montaje (lo lee el portal, en otra tarea)
+    ClusterWriterStats _writerStats;    // Acumulado de todas las escrituras con ClusterWriter
+    TimeSeriesStore _seriesStore;       // Series diarias (se usa siempre con turno de la SD)
+    volatile uint32_t _seriesGeneration; // Muestras añadidas a las series (lo lee el portal, en otra tarea)
+
+    // --- Salud de la tarjeta ---
+    SDHealthStats _health;
+    uint32_t _remountBackoffMs;   // Espera actual entre intentos de montaje
+    uint32_t _nextRemountMs;      // millis() del siguiente intento
+    uint32_t _lastProbeMs;        // millis() del último sondeo con la tarjeta montada
+    uint8_t _probeFailures;       // Sondeos fallidos seguidos
+    bool _cardLostPendingLog;     // Caída aún no registrada (se registra desde checkCardHealth)
+    uint32_t _attemptsSinceLoss;  // Intentos de montaje desde la última caída
+    // Última pasada de recoverTornRecords() (se registra desde checkCardHealth)
+    bool _recoveryPendingLog;
+    uint32_t _recoveryChecked;     // Archivos revisados
+    uint32_t _recoveryQuarantined; // Registros puestos en cuarentena
+    uint32_t _recoveryRenamed;     // Temporales completos renombrados a su destino
+    uint32_t _recoveryRemoved;     // Temporales incompletos borrados
+
+    // Escritura de archivo (writeTextFile/writeBinaryFile) retenida en PSRAM mientras no hay tarjeta
+    struct BufferedWrite {
+        String path;
+        uint8_t* data;  // ps_malloc; lo libera _flushWriteBuffer() o _dropOldestBufferedWrite()
+        size_t length;
+    };
+    std::vector<BufferedWrite> _writeBuffer;
+
+    /**
+     * @brief (Helper) Monta la tarjeta y crea la estructura de directorios base.
+     * @return True si la SD quedó disponible.
+     */
+    bool _mountCard();
+
+    /**
+     * @brief (Helper) Da la tarjeta por caída: la desmonta y programa el primer reintento.
+     */
+    void _unmountCard();
+
+    /**
+     * @brief (Helper) Contabiliza el resultado de una operación en la SD. Solo para errores
+     * de E/S: los errores lógicos no se pasan aquí. Tras SD_HEALTH_FAIL_THRESHOLD fallos
+     * seguidos, desmonta la tarjeta.
+     * @return El mismo `ok` (para encadenar en los `return`).
+     */
+    bool _recordSdResult(bool ok);
+
+    /**
+     * @brief (Helper) Clasifica un open() fallido sobre `path`: si el directorio padre no
+     * existía y se ha podido recrear, el fallo es lógico (no cuenta para la salud).
+     * @return True si el fallo es lógico.
+     */
+    bool _isLogicalOpenFailure(const String& path);
+
+    /**
+     * @brief (Helper) Añade una muestra a la serie diaria `file` (turno CAPTURE_WRITE).
+     */
+    bool _appendSeries(SeriesFile file, uint32_t epoch, const float values[TS_COLUMNS]);
+
+    /**
+     * @brief (Helper) Retiene una escritura de archivo en PSRAM (sin tarjeta). Una escritura
+     * posterior sobre la misma ruta sustituye a la retenida. Si se supera
+     * SD_WRITE_BUFFER_MAX_BYTES se descartan las más antiguas.
+     * @return True si quedó retenida.
+     */
+    bool _bufferWrite(const String& path, const uint8_t* data, size_t length);
+
+    /**
+     * @brief (Helper) Vuelca a la SD las escrituras retenidas, en orden. Se detiene al primer fallo.
+     * @return Número de escrituras volcadas.
+     */
+    int _flushWriteBuffer();
+
+    void _dropOldestBufferedWrite();
+
+    /**
+     * @brief (Helper) Asegura que exista el directorio padre de `fullPath`.
+     */
+    bool ensureParentDirectoryExists(const String& fullPath);
+
+    /**
+     * @brief (Helper) Escribe un registro (cabecera + contenido) en RECORD_TMP_DIR, lo
+     * sincroniza y lo renombra a `fullPath`. No contabiliza el resultado en la salud.
+     * @param logicalError Si no es nullptr, indica si un fallo fue lógico (directorio de
+     *        temporales borrado, destino que no se puede reemplazar) y no de E/S.
+     * @return True si el registro quedó completo en su ruta final.
+     */
+    bool _writeRecordFile(const String& fullPath, const uint8_t* data, size_t length, bool* logicalError = nullptr);
+
+    /**
+     * @brief (Helper) Mueve a QUARANTINE_DIR los registros de `dirPath` con la cabecera
+     * cortada. Suma los archivos revisados a `checked`.
+     * @return Número de registros puestos en cuarentena.
+     */
+    int _quarantineTornRecords(const char* dirPath, uint32_t& checked);
 
     // Estructura para ayudar a ordenar archivos por fecha
     struct FileInfo {
         String path;
         time_t timestamp; // Epoch time para ordenar fácilmente
+        uint64_t size;    // Tamaño en bytes (solo se rellena donde se necesita)
 
         bool operator<(const FileInfo& other) const {
             return timestamp < other.timestamp; // Ordenar: más antiguo primero
@@ -226,6 +612,12 @@ private:
      */
     String logLevelToString(LogLevel level);
 
+    /**
+     * @brief (Helper) Arma una línea del log de texto: "timestamp [NIVEL] mensaje (DevTemp: x.xC )".
+     * La temperatura solo se añade si no es NaN.
+     */
+    String formatLogLine(const String& timestamp, LogLevel level, const String& message, float internalTemp);
+
     /**
      * @brief (Helper) Lógica de gestión para un único directorio (borrado por antigüedad/espacio).
      * @return Bytes liberados en esta ejecución.
@@ -238,6 +630,37 @@ private:
      */
     time_t _parseTimestampFromFilename(const String& filename, TimeManager& timeMgr);
 
+    /**
+     * @brief (Helper) Parsea fecha y hora completas (Formato: YYYYMMDD_HHMMSS...) de un nombre de archivo.
+     * @return Epoch time, o 0 si falla el parseo.
+     */
+    time_t _parseFullTimestampFromFilename(const String& filename);
+
+    /**
+     * @brief (Helper) Lista los archivos de un directorio cuyo nombre termina en `suffix`,
+     * con timestamp completo y tamaño. Ordenados del más antiguo al más reciente.
+     * @param includeUndated Incluye (al principio, con timestamp 0) los nombres sin fecha válida.
+     */
+    std::vector<FileInfo> _collectTimestampedFiles(const char* dirPath, const char* suffix, bool includeUndated = false);
+
+    /**
+     * @brief (Helper backlog) Adelgaza capturas pendientes anteriores a `cutoff`.
+     * @return Número de archivos movidos a 'archive'.
+     */
+    int _thinPendingCaptures(time_t cutoff, int intervalMinutes);
+
+    /**
+     * @brief (Helper backlog) Agrega datos ambientales pendientes anteriores a `cutoff`.
+     * @return Número de archivos originales movidos a 'archive'.
+     */
+    int _summarizePendingAmbient(time_t cutoff, int bucketMinutes);
+
+    /**
+     * @brief (Helper backlog) Mueve a 'archive' los pendientes más antiguos hasta quedar bajo `maxBytes`.
+     * @return Número de archivos movidos a 'archive'.
+     */
+    int _enforcePendingByteCap(uint64_t maxBytes);
+
     /**
      * @brief (Helper) Parsea un JSON térmico (String) y extrae el array de temperaturas.
      * @note El llamador es responsable de liberar la memoria del float* retornado.
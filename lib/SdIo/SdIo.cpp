@@ -0,0 +1,138 @@
+#include "SdIo.h"
+#include "esp_timer.h"
+
+static const char* const SD_IO_CLASS_NAMES[] = {"capture_write", "queue", "portal_read", "maintenance"};
+
+portMUX_TYPE SdIo::_mux = portMUX_INITIALIZER_UNLOCKED;
+bool SdIo::_ready = false;
+TaskHandle_t SdIo::_owner = nullptr;
+uint16_t SdIo::_depth = 0;
+SdIoClass SdIo::_ownerClass = SdIoClass::MAINTENANCE;
+int64_t SdIo::_grantedUs = 0;
+uint32_t SdIo::_sequence = 0;
+SdIo::Waiter SdIo::_waiters[SD_IO_MAX_WAITERS];
+StaticSemaphore_t SdIo::_wakeBuffers[SD_IO_MAX_WAITERS];
+SdIoClassStats SdIo::_stats[(size_t)SdIoClass::COUNT];
+
+void SdIo::begin() {
+    if (_ready) return;
+    for (int i = 0; i < SD_IO_MAX_WAITERS; i++) {
+        _waiters[i].task = nullptr;
+        _waiters[i].granted = false;
+        _waiters[i].wake = xSemaphoreCreateBinaryStatic(&_wakeBuffers[i]); // Sin heap: no puede fallar
+    }
+    _ready = true;
+}
+
+void SdIo::acquire(SdIoClass ioClass) {
+    if (!_ready) begin();
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    SdIoClassStats& classStats = _stats[(size_t)ioClass];
+    int64_t requestedUs = esp_timer_get_time();
+
+    while (true) {
+        int slot = -1;
+        portENTER_CRITICAL(&_mux);
+        if (_owner == self) {
+            _depth++; // Anidada: conserva la clase del turno exterior
+            portEXIT_CRITICAL(&_mux);
+            return;
+        }
+        classStats.requests++;
+        if (_owner == nullptr) {
+            // Libre: release() entrega el turno directamente, así que aquí no hay nadie esperando
+            _grant(self, ioClass, requestedUs);
+            portEXIT_CRITICAL(&_mux);
+            return;
+        }
+        for (int i = 0; i < SD_IO_MAX_WAITERS; i++) {
+            if (_waiters[i].task == nullptr) {
+                slot = i;
+                break;
+            }
+        }
+        if (slot >= 0) {
+            _waiters[slot].task = self;
+            _waiters[slot].ioClass = ioClass;
+            _waiters[slot].sequence = _sequence++;
+            _waiters[slot].granted = false;
+            classStats.contended++;
+            classStats.waiting++;
+            if (classStats.waiting > classStats.maxWaiting) classStats.maxWaiting = classStats.waiting;
+        } else {
+            classStats.requests--; // Sin casilla libre: se reintenta como petición nueva
+        }
+        portEXIT_CRITICAL(&_mux);
+
+        if (slot < 0) {
+            vTaskDelay(1);
+            continue;
+        }
+
+        // release() marca la casilla como concedida y nos hace dueños antes de despertarnos
+        xSemaphoreTake(_waiters[slot].wake, portMAX_DELAY);
+        uint32_t waitedUs = (uint32_t)(esp_timer_get_time() - requestedUs);
+        portENTER_CRITICAL(&_mux);
+        _waiters[slot].task = nullptr;
+        classStats.totalWaitUs += waitedUs;
+        if (waitedUs > classStats.maxWaitUs) classStats.maxWaitUs = waitedUs;
+        portEXIT_CRITICAL(&_mux);
+        return;
+    }
+}
+
+void SdIo::release() {
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    SemaphoreHandle_t wake = nullptr;
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&_mux);
+    if (_owner != self || --_depth > 0) {
+        portEXIT_CRITICAL(&_mux);
+        return;
+    }
+    uint32_t heldUs = (uint32_t)(now - _grantedUs);
+    SdIoClassStats& ownerStats = _stats[(size_t)_ownerClass];
+    if (heldUs > ownerStats.maxHoldUs) ownerStats.maxHoldUs = heldUs;
+
+    // Siguiente turno: clase de mayor prioridad y, dentro de ella, la más antigua
+    int next = -1;
+    for (int i = 0; i < SD_IO_MAX_WAITERS; i++) {
+        const Waiter& w = _waiters[i];
+        if (w.task == nullptr || w.granted) continue;
+        if (next < 0 || w.ioClass < _waiters[next].ioClass ||
+            (w.ioClass == _waiters[next].ioClass && (int32_t)(w.sequence - _waiters[next].sequence) < 0)) {
+            next = i;
+        }
+    }
+    if (next >= 0) {
+        _waiters[next].granted = true;
+        _stats[(size_t)_waiters[next].ioClass].waiting--;
+        _grant(_waiters[next].task, _waiters[next].ioClass, now);
+        wake = _waiters[next].wake;
+    } else {
+        _owner = nullptr;
+        _depth = 0;
+    }
+    portEXIT_CRITICAL(&_mux);
+
+    if (wake) xSemaphoreGive(wake);
+}
+
+SdIoClassStats SdIo::stats(SdIoClass ioClass) {
+    portENTER_CRITICAL(&_mux);
+    SdIoClassStats copy = _stats[(size_t)ioClass];
+    portEXIT_CRITICAL(&_mux);
+    return copy;
+}
+
+const char* SdIo::className(SdIoClass ioClass) {
+    return ioClass < SdIoClass::COUNT ? SD_IO_CLASS_NAMES[(size_t)ioClass] : "unknown";
+}
+
+void SdIo::_grant(TaskHandle_t task, SdIoClass ioClass, int64_t now) {
+    _owner = task;
+    _depth = 1;
+    _ownerClass = ioClass;
+    _grantedUs = now;
+}
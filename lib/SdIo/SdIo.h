@@ -0,0 +1,111 @@
+#ifndef SD_IO_H
+#define SD_IO_H
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+// --- Planificador de acceso a la SD ---
+#define SD_IO_MAX_WAITERS 8              // Tareas esperando a la vez (loop, AsyncTCP, lectora de pendientes...)
+#define SD_IO_PORTAL_SLICE_BYTES 4096    // Lectura máxima del portal por turno (ver WebPortal::handleViewLog)
+
+/**
+ * @brief Clase de cada petición, de mayor a menor prioridad.
+ */
+enum class SdIoClass : uint8_t {
+    CAPTURE_WRITE = 0, ///< Escrituras de datos nuevos (capturas, registros, logs)
+    QUEUE,             ///< Cola de pendientes: lecturas, archivado, borrado, migración del nivel rápido
+    PORTAL_READ,       ///< Portal web (AsyncTCP): listado y descarga de logs, consultas de series
+    MAINTENANCE,       ///< Montaje, sondeo, recuperación, compactación y limpieza
+    COUNT
+};
+
+/**
+ * @brief Métricas por clase desde el arranque.
+ */
+struct SdIoClassStats {
+    uint32_t requests = 0;   ///< Turnos pedidos (sin contar los anidados)
+    uint32_t contended = 0;  ///< Turnos que tuvieron que esperar
+    uint8_t waiting = 0;     ///< Tareas esperando ahora (profundidad de la cola)
+    uint8_t maxWaiting = 0;
+    uint64_t totalWaitUs = 0;
+    uint32_t maxWaitUs = 0;
+    uint32_t maxHoldUs = 0;  ///< Turno más largo (tiempo con la tarjeta tomada)
+};
+
+/**
+ * @class SdIo
+ * @brief Clase de utilidad (estática) que serializa el acceso a la tarjeta SD.
+ *
+ * El loop() (capturas, cola, mantenimiento), la tarea de AsyncTCP (portal web) y la
+ * lectora de PendingPrefetcher usan la tarjeta a la vez. Cada operación de SDManager
+ * pide un turno con SdIoGuard; si la tarjeta está ocupada la tarea espera, y al
+ * liberarse el turno pasa directamente a la petición en espera de mayor prioridad
+ * (por orden de llegada dentro de la misma clase). El turno es reentrante para la
+ * tarea que lo tiene: las operaciones anidadas conservan la clase de la exterior.
+ *
+ * Los turnos son cortos: las descargas del portal leen como mucho
+ * SD_IO_PORTAL_SLICE_BYTES por turno, así una escritura de captura espera a lo sumo
+ * una operación en curso. No se debe esperar a la red con un turno tomado.
+ */
+class SdIo {
+public:
+    /**
+     * @brief Crea los semáforos de espera. SDManager::begin() la llama antes de arrancar otras tareas.
+     */
+    static void begin();
+
+    /**
+     * @brief Toma la tarjeta (espera si otra tarea la tiene).
+     */
+    static void acquire(SdIoClass ioClass);
+
+    /**
+     * @brief Libera el turno tomado con acquire() y lo cede a la siguiente petición.
+     */
+    static void release();
+
+    /**
+     * @brief Copia de las métricas de una clase.
+     */
+    static SdIoClassStats stats(SdIoClass ioClass);
+
+    static const char* className(SdIoClass ioClass);
+
+private:
+    struct Waiter {
+        TaskHandle_t task;
+        SdIoClass ioClass;
+        uint32_t sequence;
+        bool granted;
+        SemaphoreHandle_t wake;
+    };
+
+    static portMUX_TYPE _mux;
+    static bool _ready;
+    static TaskHandle_t _owner;
+    static uint16_t _depth;
+    static SdIoClass _ownerClass;
+    static int64_t _grantedUs;
+    static uint32_t _sequence;
+    static Waiter _waiters[SD_IO_MAX_WAITERS];
+    static StaticSemaphore_t _wakeBuffers[SD_IO_MAX_WAITERS];
+    static SdIoClassStats _stats[(size_t)SdIoClass::COUNT];
+
+    static void _grant(TaskHandle_t task, SdIoClass ioClass, int64_t now);
+};
+
+/**
+ * @brief Turno RAII: toma la tarjeta al construirse y la libera al salir del ámbito.
+ */
+class SdIoGuard {
+public:
+    explicit SdIoGuard(SdIoClass ioClass) { SdIo::acquire(ioClass); }
+    ~SdIoGuard() { SdIo::release(); }
+
+private:
+    SdIoGuard(const SdIoGuard&);
+    SdIoGuard& operator=(const SdIoGuard&);
+};
+
+#endif // SD_IO_H
@@ -0,0 +1,147 @@
+#include "SensorPower.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef ARDUINO
+    #include <Arduino.h> // millis()
+#else
+    #include <chrono>
+#endif
+
+// Nombres de SensorPowerState (mismo orden que el enum) para config.json y los logs
+static const char* const STATE_NAMES[] = { "active", "standby", "off" };
+
+const char* sensorPowerStateName(SensorPowerState state) {
+    return (size_t)state < sizeof(STATE_NAMES) / sizeof(STATE_NAMES[0]) ? STATE_NAMES[(size_t)state] : "?";
+}
+
+bool parseSensorPowerState(const char* name, SensorPowerState& state) {
+    if (!name) return false;
+    for (size_t i = 0; i < sizeof(STATE_NAMES) / sizeof(STATE_NAMES[0]); i++) {
+        if (strcmp(name, STATE_NAMES[i]) == 0) {
+            state = (SensorPowerState)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+SensorPowerScheduler::SensorPowerScheduler()
+    : _count(0), _idleState(SensorPowerState::STANDBY), _clock(nullptr) {}
+
+uint32_t SensorPowerScheduler::_now() const {
+    if (_clock) return _clock();
+#ifdef ARDUINO
+    return millis();
+#else
+    using namespace std::chrono;
+    return (uint32_t)duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+int8_t SensorPowerScheduler::addSlot(const char* name, StateFn apply, void* sensor, uint32_t expectedWakeMs) {
+    if (_count >= SENSOR_POWER_MAX_SENSORS) return -1;
+    Slot& slot = _slots[_count];
+    slot.apply = apply;
+    slot.sensor = sensor;
+    slot.initialWakeMs = expectedWakeMs;
+    slot.awake = true;
+    memset(&slot.stats, 0, sizeof(slot.stats));
+    slot.stats.name = name;
+    return (int8_t)_count++;
+}
+
+uint32_t SensorPowerScheduler::expectedWakeMs(uint8_t index) const {
+    const Slot& slot = _slots[index];
+    return slot.stats.wakes == 0 ? slot.initialWakeMs : slot.stats.averageMs;
+}
+
+uint32_t SensorPowerScheduler::leadTimeMs() const {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < _count; i++) {
+        if (!_slots[i].awake) total += expectedWakeMs(i);
+    }
+    // Las latencias varían (la cámara depende de la exposición): un 25 % extra además del margen
+    return total == 0 ? 0 : total + total / 4 + SENSOR_WAKE_MARGIN_MS;
+}
+
+void SensorPowerScheduler::wake(uint8_t index, bool late) {
+    Slot& slot = _slots[index];
+    uint32_t startMs = _now();
+    bool ok = slot.apply(slot.sensor, SensorPowerState::ACTIVE);
+    uint32_t elapsed = _now() - startMs;
+
+    // Un despertar fallido también deja el sensor como despierto: la lectura fallará
+    // por el camino normal (reintentos, NaN) y no se reintenta en cada pasada del loop
+    slot.awake = true;
+    SensorWakeStats& stats = slot.stats;
+    if (!ok) {
+        stats.failures++;
+        return;
+    }
+    stats.lastMs = elapsed;
+    stats.averageMs = stats.wakes == 0 ? elapsed : stats.averageMs + ((int32_t)elapsed - (int32_t)stats.averageMs) / 4;
+    if (elapsed > stats.maxMs) stats.maxMs = elapsed;
+    stats.wakes++;
+    stats.lastLate = late;
+    if (late) stats.lateWakes++;
+}
+
+uint8_t SensorPowerScheduler::service(uint32_t msUntilCycle) {
+    uint32_t startMs = _now();
+    uint8_t woken = 0;
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_slots[i].awake) continue;
+        // Los despertares son bloqueantes: lo que falta se recalcula tras cada uno
+        uint32_t elapsed = _now() - startMs;
+        uint32_t remaining = msUntilCycle > elapsed ? msUntilCycle - elapsed : 0;
+        if (remaining > leadTimeMs()) break;
+        wake(i, false);
+        woken++;
+    }
+    return woken;
+}
+
+uint8_t SensorPowerScheduler::wakeAll() {
+    uint8_t woken = 0;
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_slots[i].awake) continue;
+        wake(i, true);
+        woken++;
+    }
+    return woken;
+}
+
+void SensorPowerScheduler::sleep(int8_t index) {
+    if (index < 0 || index >= _count || _idleState == SensorPowerState::ACTIVE) return;
+    Slot& slot = _slots[index];
+    if (!slot.awake) return;
+    if (slot.apply(slot.sensor, _idleState)) {
+        slot.awake = false;
+    } else {
+        slot.stats.failures++; // Sigue activo: el próximo ciclo no necesita despertarlo
+    }
+}
+
+void SensorPowerScheduler::sleepAll() {
+    for (uint8_t i = 0; i < _count; i++) sleep((int8_t)i);
+}
+
+bool SensorPowerScheduler::isAwake(int8_t index) const {
+    return index >= 0 && index < _count && _slots[index].awake;
+}
+
+size_t SensorPowerScheduler::describe(char* out, size_t outSize) const {
+    if (!out || outSize == 0) return 0;
+    out[0] = '\0';
+    size_t len = 0;
+    for (uint8_t i = 0; i < _count && len < outSize; i++) {
+        const SensorWakeStats& stats = _slots[i].stats;
+        if (stats.wakes == 0) continue;
+        int written = snprintf(out + len, outSize - len, "%s%s %lu/%lu ms%s", len > 0 ? ", " : "", stats.name,
+                               (unsigned long)stats.lastMs, (unsigned long)stats.averageMs, stats.lastLate ? " late" : "");
+        if (written < 0) break;
+        len += (size_t)written;
+    }
+    return len < outSize ? len : outSize - 1;
+}
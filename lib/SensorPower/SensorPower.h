@@ -0,0 +1,143 @@
+#ifndef SENSOR_POWER_H
+#define SENSOR_POWER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Sin dependencias de Arduino: el reloj es millis() en el dispositivo y se puede
+// sustituir (setClock) para probar la secuencia de despertares sin esperar.
+
+#define SENSOR_POWER_MAX_SENSORS 4      // BME280, BH1750, MLX90640 y OV2640
+// Holgura del despertar previo al ciclo: el horario tiene resolución de 1 s y una pasada
+// del loop (conversión del DS18B20 incluida) tarda hasta ~1 s.
+#define SENSOR_WAKE_MARGIN_MS    1500
+
+/**
+ * @brief Estado de energía de un sensor entre ciclos.
+ */
+enum class SensorPowerState : uint8_t {
+    ACTIVE,     ///< Listo para medir
+    STANDBY,    ///< Reposo de bajo consumo; conserva la configuración (despertar rápido)
+    OFF         ///< Driver liberado o alimentación cortada; despertar = inicializar de nuevo
+};
+
+const char* sensorPowerStateName(SensorPowerState state);
+/**
+ * @brief Convierte "active", "standby" u "off" (config.json) en un estado.
+ * @return False si el nombre no es válido (state no cambia).
+ */
+bool parseSensorPowerState(const char* name, SensorPowerState& state);
+
+/**
+ * @brief Latencias de despertar de un sensor (desde la orden hasta que está listo).
+ */
+struct SensorWakeStats {
+    const char* name;
+    uint32_t lastMs;        ///< Último despertar
+    uint32_t averageMs;     ///< Media EWMA (peso 1/4) de los despertares
+    uint32_t maxMs;         ///< Máximo desde el arranque
+    uint32_t wakes;
+    uint32_t lateWakes;     ///< Despertares que no terminaron antes del inicio del ciclo
+    uint32_t failures;      ///< Cambios de estado que el sensor no pudo completar
+    bool lastLate;
+};
+
+/**
+ * @class SensorPowerScheduler
+ * @brief Pone los sensores en reposo entre ciclos y los despierta justo a tiempo.
+ *
+ * Cada sensor registrado expone setPowerState(SensorPowerState) y se despierta de
+ * forma bloqueante (la llamada vuelve cuando el sensor ya puede medir), así que la
+ * duración de esa llamada es su latencia de despertar. main.cpp llama a service() en
+ * cada pasada del loop con el tiempo que falta para el ciclo: los sensores se despiertan
+ * en orden de registro, y el siguiente empieza cuando lo que falta es menor que la suma
+ * de las latencias esperadas de los que quedan dormidos (más SENSOR_WAKE_MARGIN_MS).
+ * Al empezar el ciclo, wakeAll() despierta los que no llegaron (cuentan como tardíos).
+ * Tras usar un sensor, sleep() lo devuelve al estado de reposo configurado.
+ */
+class SensorPowerScheduler {
+public:
+    SensorPowerScheduler();
+
+    /**
+     * @brief Registra un sensor (los sensores empiezan activos, como tras su begin()).
+     * @param expectedWakeMs Latencia supuesta hasta medir el primer despertar.
+     * @return Índice del sensor, o -1 si se superó SENSOR_POWER_MAX_SENSORS.
+     */
+    template <typename Sensor>
+    int8_t add(const char* name, Sensor& sensor, uint32_t expectedWakeMs) {
+        return addSlot(name, &applyState<Sensor>, &sensor, expectedWakeMs);
+    }
+
+    /**
+     * @brief Estado de reposo entre ciclos. ACTIVE = sin gestión (los sensores no duermen).
+     */
+    void setIdleState(SensorPowerState state) { _idleState = state; }
+    SensorPowerState idleState() const { return _idleState; }
+
+    /**
+     * @brief Despierta los sensores que ya deben empezar para estar listos a tiempo.
+     * @param msUntilCycle Milisegundos hasta el inicio del próximo ciclo.
+     * @return Sensores despertados en esta llamada.
+     */
+    uint8_t service(uint32_t msUntilCycle);
+
+    /**
+     * @brief Despierta los sensores que sigan dormidos (inicio del ciclo).
+     * @return Sensores despertados tarde.
+     */
+    uint8_t wakeAll();
+
+    /**
+     * @brief Devuelve un sensor al estado de reposo (no hace nada con reposo ACTIVE).
+     */
+    void sleep(int8_t index);
+    void sleepAll();
+
+    bool isAwake(int8_t index) const;
+    /**
+     * @brief Antelación con la que service() empieza a despertar los sensores dormidos.
+     */
+    uint32_t leadTimeMs() const;
+
+    uint8_t count() const { return _count; }
+    const SensorWakeStats& stats(uint8_t index) const { return _slots[index].stats; }
+    /**
+     * @brief Describe las latencias, ej. "BME280 115/112 ms, OV2640 420/390 ms late" (última/media).
+     * @return Longitud escrita (0 si ningún sensor se ha despertado aún).
+     */
+    size_t describe(char* out, size_t outSize) const;
+
+    /**
+     * @brief (Tests) Sustituye el reloj en milisegundos (nullptr = millis()).
+     */
+    void setClock(uint32_t (*clock)()) { _clock = clock; }
+
+private:
+    typedef bool (*StateFn)(void* sensor, SensorPowerState state);
+
+    template <typename Sensor>
+    static bool applyState(void* sensor, SensorPowerState state) {
+        return static_cast<Sensor*>(sensor)->setPowerState(state);
+    }
+
+    struct Slot {
+        StateFn apply;
+        void* sensor;
+        uint32_t initialWakeMs;
+        bool awake;
+        SensorWakeStats stats;
+    };
+
+    int8_t addSlot(const char* name, StateFn apply, void* sensor, uint32_t expectedWakeMs);
+    void wake(uint8_t index, bool late);
+    uint32_t expectedWakeMs(uint8_t index) const;
+    uint32_t _now() const;
+
+    Slot _slots[SENSOR_POWER_MAX_SENSORS];
+    uint8_t _count;
+    SensorPowerState _idleState;
+    uint32_t (*_clock)();
+};
+
+#endif // SENSOR_POWER_H
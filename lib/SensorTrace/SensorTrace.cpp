@@ -0,0 +1,312 @@
+#include "SensorTrace.h"
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+#ifdef ARDUINO
+    #include <Arduino.h> // millis(), delay(), ps_malloc()
+    #include "SdIo.h"    // Turnos de la SD (compartida con SDManager, el portal y la lectora de pendientes)
+    // Las lecturas y escrituras de la traza sustituyen o acompañan a una lectura de sensor del ciclo
+    #define SENSOR_TRACE_IO_GUARD() SdIoGuard ioGuard(SdIoClass::CAPTURE_WRITE)
+#else
+    #include <chrono>
+    #include <thread>
+    #define SENSOR_TRACE_IO_GUARD() do {} while (0)
+#endif
+
+#define CHANNEL_COUNT ((size_t)SensorChannel::COUNT)
+
+SensorTrace::Mode SensorTrace::_mode = SensorTrace::Mode::IDLE;
+FILE* SensorTrace::_file = nullptr;
+uint32_t SensorTrace::_bytesWritten = 0;
+uint32_t SensorTrace::_maxBytes = SENSOR_TRACE_MAX_BYTES;
+uint32_t SensorTrace::_startMs = 0;
+uint32_t SensorTrace::_startEpoch = 0;
+float SensorTrace::_speed = 1.0f;
+bool SensorTrace::_loop = false;
+std::vector<SensorTrace::RecordRef> SensorTrace::_index[CHANNEL_COUNT];
+size_t SensorTrace::_cursor[CHANNEL_COUNT];
+uint32_t SensorTrace::_recorded[CHANNEL_COUNT];
+
+// --- Helpers little-endian (el formato no depende del orden de bytes del host) ---
+static void putU32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t getU32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+uint32_t SensorTrace::_nowMs() {
+#ifdef ARDUINO
+    return millis();
+#else
+    return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void SensorTrace::_sleepMs(uint32_t ms) {
+#ifdef ARDUINO
+    delay(ms);
+#else
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+#endif
+}
+
+void SensorTrace::stop() {
+    if (_file) {
+        SENSOR_TRACE_IO_GUARD();
+        fclose(_file);
+        _file = nullptr;
+    }
+    for (size_t i = 0; i < CHANNEL_COUNT; i++) {
+        std::vector<RecordRef>().swap(_index[i]); // Libera la memoria del índice
+        _cursor[i] = 0;
+    }
+    _mode = Mode::IDLE;
+}
+
+// =========================================================================
+// ===                            GRABACIÓN                              ===
+// =========================================================================
+
+bool SensorTrace::nextSessionPath(const char* basePath, char* out, size_t outSize) {
+    if (!basePath || !out || outSize == 0) return false;
+    // La extensión empieza en el último '.' del nombre (no de un directorio)
+    const char* slash = strrchr(basePath, '/');
+    const char* dot = strrchr(basePath, '.');
+    size_t stemLen = (dot && (!slash || dot > slash)) ? (size_t)(dot - basePath) : strlen(basePath);
+    const char* extension = basePath + stemLen;
+
+    SENSOR_TRACE_IO_GUARD();
+    for (int session = 1; session <= SENSOR_TRACE_MAX_SESSIONS; session++) {
+        int written = snprintf(out, outSize, "%.*s_%04d%s", (int)stemLen, basePath, session, extension);
+        if (written < 0 || (size_t)written >= outSize) return false;
+        FILE* existing = fopen(out, "rb");
+        if (!existing) return true;
+        fclose(existing);
+    }
+    return false;
+}
+
+bool SensorTrace::beginRecording(const char* path, uint32_t startEpoch, uint32_t maxBytes) {
+    stop();
+    SENSOR_TRACE_IO_GUARD();
+    _file = fopen(path, "wb");
+    if (!_file) return false;
+
+    uint8_t header[SENSOR_TRACE_HEADER_SIZE] = {0};
+    memcpy(header, SENSOR_TRACE_MAGIC, 4);
+    header[4] = SENSOR_TRACE_VERSION;
+    putU32(header + 8, startEpoch);
+    if (fwrite(header, 1, sizeof(header), _file) != sizeof(header)) {
+        stop();
+        return false;
+    }
+    fflush(_file);
+
+    _bytesWritten = sizeof(header);
+    _maxBytes = maxBytes;
+    _startMs = _nowMs();
+    _startEpoch = startEpoch;
+    for (size_t i = 0; i < CHANNEL_COUNT; i++) _recorded[i] = 0;
+    _mode = Mode::RECORD;
+    return true;
+}
+
+bool SensorTrace::_writeRecord(SensorChannel channel, uint8_t flags, const void* data, uint32_t length) {
+    if (_mode != Mode::RECORD || !_file) return false;
+
+    // Al llegar al tope la grabación se cierra (el archivo queda válido hasta el último registro)
+    if (_bytesWritten + SENSOR_TRACE_RECORD_HEADER_SIZE + length > _maxBytes) {
+        stop();
+        return false;
+    }
+
+    uint8_t header[SENSOR_TRACE_RECORD_HEADER_SIZE] = {0};
+    header[0] = (uint8_t)channel;
+    header[1] = flags;
+    putU32(header + 4, _nowMs() - _startMs);
+    putU32(header + 8, length);
+
+    SENSOR_TRACE_IO_GUARD();
+    bool ok = fwrite(header, 1, sizeof(header), _file) == sizeof(header);
+    ok = ok && (length == 0 || fwrite(data, 1, length, _file) == length);
+    // Un registro por lectura: se vuelca enseguida para no perder la traza si se corta la alimentación
+    ok = ok && fflush(_file) == 0;
+    if (!ok) {
+        stop();
+        return false;
+    }
+    _bytesWritten += sizeof(header) + length;
+    _recorded[(size_t)channel]++;
+    return true;
+}
+
+void SensorTrace::recordScalar(SensorChannel channel, float value, bool ok) {
+    if (ok) {
+        uint8_t payload[4];
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        putU32(payload, bits);
+        _writeRecord(channel, 0, payload, sizeof(payload));
+    } else {
+        _writeRecord(channel, SENSOR_TRACE_FLAG_FAILED, nullptr, 0);
+    }
+}
+
+void SensorTrace::recordThermalFrame(const float* frame, bool ok) {
+    if (_mode != Mode::RECORD) return;
+    if (!ok || frame == nullptr) {
+        _writeRecord(SensorChannel::THERMAL_FRAME, SENSOR_TRACE_FLAG_FAILED, nullptr, 0);
+        return;
+    }
+
+    // Centésimas de grado en int16 (±327 °C): la mitad de tamaño sin perder la resolución del sensor
+    uint8_t payload[SENSOR_TRACE_THERMAL_PIXELS * 2];
+    for (int i = 0; i < SENSOR_TRACE_THERMAL_PIXELS; i++) {
+        int16_t centi = SENSOR_TRACE_THERMAL_NAN;
+        if (!isnan(frame[i])) {
+            float scaled = roundf(frame[i] * 100.0f);
+            if (scaled > 32767.0f) scaled = 32767.0f;
+            if (scaled < -32767.0f) scaled = -32767.0f;
+            centi = (int16_t)scaled;
+        }
+        payload[2 * i] = (uint8_t)centi;
+        payload[2 * i + 1] = (uint8_t)((uint16_t)centi >> 8);
+    }
+    _writeRecord(SensorChannel::THERMAL_FRAME, 0, payload, sizeof(payload));
+}
+
+void SensorTrace::recordJpeg(const uint8_t* data, size_t length) {
+    if (data == nullptr || length == 0) {
+        _writeRecord(SensorChannel::JPEG, SENSOR_TRACE_FLAG_FAILED, nullptr, 0);
+    } else {
+        _writeRecord(SensorChannel::JPEG, 0, data, (uint32_t)length);
+    }
+}
+
+// =========================================================================
+// ===                          REPRODUCCIÓN                             ===
+// =========================================================================
+
+bool SensorTrace::beginReplay(const char* path, float speed, bool loop) {
+    stop();
+    SENSOR_TRACE_IO_GUARD();
+    _file = fopen(path, "rb");
+    if (!_file) return false;
+
+    uint8_t header[SENSOR_TRACE_HEADER_SIZE];
+    if (fread(header, 1, sizeof(header), _file) != sizeof(header) ||
+        memcmp(header, SENSOR_TRACE_MAGIC, 4) != 0 || header[4] != SENSOR_TRACE_VERSION) {
+        stop();
+        return false;
+    }
+    _startEpoch = getU32(header + 8);
+
+    // Índice por canal: solo cabeceras (offset, longitud, tiempo), los datos se leen al reproducir
+    fseek(_file, 0, SEEK_END);
+    long fileSize = ftell(_file);
+    fseek(_file, sizeof(header), SEEK_SET);
+    uint32_t offset = sizeof(header);
+    uint8_t recordHeader[SENSOR_TRACE_RECORD_HEADER_SIZE];
+    while (fread(recordHeader, 1, sizeof(recordHeader), _file) == sizeof(recordHeader)) {
+        uint8_t channel = recordHeader[0];
+        RecordRef ref;
+        ref.flags = recordHeader[1];
+        ref.timeMs = getU32(recordHeader + 4);
+        ref.length = getU32(recordHeader + 8);
+        ref.offset = offset + sizeof(recordHeader);
+
+        // Un registro truncado (corte de alimentación durante la grabación) termina la traza
+        uint32_t end = ref.offset + ref.length;
+        if (end < ref.offset || (long)end > fileSize || fseek(_file, (long)end, SEEK_SET) != 0) break;
+
+        if (channel < CHANNEL_COUNT) { // Canales desconocidos (versiones futuras) se ignoran
+            _index[channel].push_back(ref);
+        }
+        offset = end;
+    }
+
+    _speed = speed;
+    _loop = loop;
+    _startMs = _nowMs();
+    _mode = Mode::REPLAY;
+    return true;
+}
+
+const SensorTrace::RecordRef* SensorTrace::_nextRecord(SensorChannel channel) {
+    if (_mode != Mode::REPLAY) return nullptr;
+    size_t c = (size_t)channel;
+    if (_cursor[c] >= _index[c].size()) {
+        if (!_loop || _index[c].empty()) return nullptr;
+        _cursor[c] = 0;
+    }
+    const RecordRef* ref = &_index[c][_cursor[c]++];
+
+    // Ritmo: el registro se entrega cuando ha pasado su tiempo original / speed desde el inicio.
+    // (En bucle el reloj no se reinicia: tras la primera vuelta las lecturas salen sin espera.)
+    if (_speed > 0.0f) {
+        uint32_t dueMs = (uint32_t)((float)ref->timeMs / _speed);
+        uint32_t elapsed = _nowMs() - _startMs;
+        if (dueMs > elapsed) _sleepMs(dueMs - elapsed);
+    }
+    return ref;
+}
+
+bool SensorTrace::_readPayload(const RecordRef& ref, void* out, uint32_t length) {
+    if (ref.length != length) return false;
+    SENSOR_TRACE_IO_GUARD();
+    return fseek(_file, (long)ref.offset, SEEK_SET) == 0 && fread(out, 1, length, _file) == length;
+}
+
+bool SensorTrace::replayScalar(SensorChannel channel, float& value) {
+    value = NAN;
+    const RecordRef* ref = _nextRecord(channel);
+    if (!ref || (ref->flags & SENSOR_TRACE_FLAG_FAILED)) return false;
+
+    uint8_t payload[4];
+    if (!_readPayload(*ref, payload, sizeof(payload))) return false;
+    uint32_t bits = getU32(payload);
+    memcpy(&value, &bits, sizeof(value));
+    return true;
+}
+
+bool SensorTrace::replayThermalFrame(float* frame) {
+    const RecordRef* ref = _nextRecord(SensorChannel::THERMAL_FRAME);
+    if (!ref || (ref->flags & SENSOR_TRACE_FLAG_FAILED)) return false;
+
+    uint8_t payload[SENSOR_TRACE_THERMAL_PIXELS * 2];
+    if (!_readPayload(*ref, payload, sizeof(payload))) return false;
+    for (int i = 0; i < SENSOR_TRACE_THERMAL_PIXELS; i++) {
+        int16_t centi = (int16_t)((uint16_t)payload[2 * i] | ((uint16_t)payload[2 * i + 1] << 8));
+        frame[i] = centi == SENSOR_TRACE_THERMAL_NAN ? NAN : (float)centi / 100.0f;
+    }
+    return true;
+}
+
+uint8_t* SensorTrace::replayJpeg(size_t& length) {
+    length = 0;
+    const RecordRef* ref = _nextRecord(SensorChannel::JPEG);
+    if (!ref || (ref->flags & SENSOR_TRACE_FLAG_FAILED) || ref->length == 0) return nullptr;
+
+#ifdef ARDUINO
+    uint8_t* data = (uint8_t*)ps_malloc(ref->length); // Igual que OV2640Sensor::captureJPEG
+#else
+    uint8_t* data = (uint8_t*)malloc(ref->length);
+#endif
+    if (!data) return nullptr;
+    if (!_readPayload(*ref, data, ref->length)) {
+        free(data);
+        return nullptr;
+    }
+    length = ref->length;
+    return data;
+}
+
+uint32_t SensorTrace::recordCount(SensorChannel channel) {
+    size_t c = (size_t)channel;
+    if (c >= CHANNEL_COUNT) return 0;
+    return _mode == Mode::REPLAY ? (uint32_t)_index[c].size() : _recorded[c];
+}
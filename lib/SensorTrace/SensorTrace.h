@@ -0,0 +1,154 @@
+#ifndef SENSOR_TRACE_H
+#define SENSOR_TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <vector>
+
+// Sin dependencias de Arduino: el archivo se lee y escribe con stdio (en el ESP32
+// la SD está montada en el VFS como "/sdcard"), así que el mismo código reproduce
+// trazas en un build de host. En el ESP32 cada acceso al archivo toma un turno de
+// SdIo, igual que las operaciones de SDManager.
+
+// --- Formato del archivo de traza (little-endian) ---
+// Cabecera (12 bytes): "ASTR", versión (1), 3 bytes reservados, época Unix del inicio (u32).
+// Registro: canal (u8), flags (u8), reservado (u16), ms desde el inicio (u32), longitud (u32), datos.
+//   - Escalares: float (4 bytes). Fotograma térmico: 768 × int16 en centésimas de °C.
+//   - JPEG: los bytes tal cual. Una lectura fallida se guarda con SENSOR_TRACE_FLAG_FAILED y sin datos.
+#define SENSOR_TRACE_MAGIC "ASTR"
+#define SENSOR_TRACE_VERSION 1
+#define SENSOR_TRACE_HEADER_SIZE 12
+#define SENSOR_TRACE_RECORD_HEADER_SIZE 12
+#define SENSOR_TRACE_FLAG_FAILED 0x01
+#define SENSOR_TRACE_THERMAL_PIXELS 768
+// Valor int16 reservado para píxeles NaN en los fotogramas térmicos
+#define SENSOR_TRACE_THERMAL_NAN INT16_MIN
+// Tope por defecto del tamaño de una grabación (al alcanzarlo se detiene)
+#define SENSOR_TRACE_MAX_BYTES (64UL * 1024UL * 1024UL)
+// Número máximo de sesión en los nombres de grabación ("_0001" ... "_9999")
+#define SENSOR_TRACE_MAX_SESSIONS 9999
+
+/**
+ * @brief Fuente de cada registro. Cada canal se reproduce con su propio cursor.
+ */
+enum class SensorChannel : uint8_t {
+    THERMAL_FRAME = 0,     ///< Muestra de MLX90640 (cada getFrame(), antes del promediado)
+    LIGHT,                 ///< BH1750 (lux)
+    AMBIENT_TEMPERATURE,   ///< BME280 (°C)
+    HUMIDITY,              ///< BME280 (%)
+    PRESSURE,              ///< BME280 (hPa)
+    DEVICE_TEMPERATURE,    ///< DS18B20 (°C)
+    JPEG,                  ///< OV2640
+    COUNT
+};
+
+/**
+ * @class SensorTrace
+ * @brief Clase de utilidad (estática) que graba las lecturas de los sensores a una traza
+ * y las reproduce a través de los mismos wrappers (MLX90640Sensor, BME280Sensor, ...).
+ *
+ * En modo reproducción los wrappers no tocan el hardware: begin() devuelve true y cada
+ * lectura devuelve el siguiente registro de su canal (incluidos los fallos grabados).
+ * El ritmo respeta los tiempos originales divididos por `speed` (0 = sin esperas).
+ */
+class SensorTrace {
+public:
+    /**
+     * @brief Abre (trunca) el archivo y empieza a grabar.
+     * @param path Ruta stdio (ej. "/sdcard/traces/20251031.trc").
+     * @param startEpoch Hora Unix del inicio (0 si aún no hay NTP); solo informativa.
+     */
+    static bool beginRecording(const char* path, uint32_t startEpoch, uint32_t maxBytes = SENSOR_TRACE_MAX_BYTES);
+
+    /**
+     * @brief Ruta de la grabación de esta sesión: inserta "_NNNN" antes de la extensión de
+     * basePath con el primer número que aún no existe (ej. "/sdcard/sensor_trace_0003.trc"),
+     * para que cada arranque grabe en su propio archivo en lugar de truncar el anterior.
+     * @return False si el nombre no cabe en out o ya existen SENSOR_TRACE_MAX_SESSIONS archivos.
+     */
+    static bool nextSessionPath(const char* basePath, char* out, size_t outSize);
+
+    /**
+     * @brief Indexa la traza y empieza a reproducirla.
+     * @param speed 1.0 = tiempo real, 10.0 = 10× más rápido, 0 = lo más rápido posible.
+     * @param loop Si es true, cada canal vuelve al principio al agotarse.
+     */
+    static bool beginReplay(const char* path, float speed = 1.0f, bool loop = false);
+
+    /**
+     * @brief Cierra la grabación o reproducción en curso.
+     */
+    static void stop();
+
+    static bool isRecording() { return _mode == Mode::RECORD; }
+    static bool isReplaying() { return _mode == Mode::REPLAY; }
+
+    // --- Grabación (sin efecto si no se está grabando) ---
+    static void recordScalar(SensorChannel channel, float value, bool ok = true);
+    static void recordThermalFrame(const float* frame, bool ok);
+    static void recordJpeg(const uint8_t* data, size_t length);
+
+    // --- Reproducción ---
+    /**
+     * @brief Siguiente lectura escalar del canal.
+     * @return False si la lectura grabada falló o el canal se agotó (value = NAN).
+     */
+    static bool replayScalar(SensorChannel channel, float& value);
+
+    /**
+     * @brief Siguiente fotograma térmico (768 floats).
+     * @return False si la lectura grabada falló o el canal se agotó.
+     */
+    static bool replayThermalFrame(float* frame);
+
+    /**
+     * @brief Siguiente JPEG, copiado a un buffer nuevo (PSRAM en el ESP32) que libera el llamador.
+     * @return nullptr si la captura grabada falló o el canal se agotó.
+     */
+    static uint8_t* replayJpeg(size_t& length);
+
+    // --- Estadísticas ---
+    static uint32_t recordCount(SensorChannel channel); ///< Registros grabados o disponibles para reproducir
+    static uint32_t bytesWritten() { return _bytesWritten; }
+    static uint32_t startEpoch() { return _startEpoch; }
+
+private:
+    enum class Mode : uint8_t { IDLE, RECORD, REPLAY };
+
+    struct RecordRef {
+        uint32_t offset;   ///< Posición de los datos en el archivo
+        uint32_t length;
+        uint32_t timeMs;
+        uint8_t flags;
+    };
+
+    static Mode _mode;
+    static FILE* _file;
+    static uint32_t _bytesWritten;
+    static uint32_t _maxBytes;
+    static uint32_t _startMs;          ///< Reloj local al empezar (grabación y reproducción)
+    static uint32_t _startEpoch;
+    static float _speed;
+    static bool _loop;
+    static std::vector<RecordRef> _index[(size_t)SensorChannel::COUNT];
+    static size_t _cursor[(size_t)SensorChannel::COUNT];
+    static uint32_t _recorded[(size_t)SensorChannel::COUNT];
+
+    static bool _writeRecord(SensorChannel channel, uint8_t flags, const void* data, uint32_t length);
+    static const RecordRef* _nextRecord(SensorChannel channel);
+    static bool _readPayload(const RecordRef& ref, void* out, uint32_t length);
+    static uint32_t _nowMs();
+    static void _sleepMs(uint32_t ms);
+};
+
+// Los wrappers de sensores usan estas macros: sin -D ENABLE_SENSOR_TRACE no generan código.
+#ifdef ENABLE_SENSOR_TRACE
+    #define SENSOR_TRACE_REPLAYING() SensorTrace::isReplaying()
+    #define SENSOR_TRACE_RECORD(call) SensorTrace::call
+#else
+    #define SENSOR_TRACE_REPLAYING() false
+    #define SENSOR_TRACE_RECORD(call) do {} while (0)
+#endif
+
+#endif // SENSOR_TRACE_H
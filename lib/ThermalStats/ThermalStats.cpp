@@ -0,0 +1,32 @@
+#include "ThermalStats.h"
+
+float thermalMax(const float* data, size_t pixels) {
+    if (data == nullptr) return -INFINITY;
+    float maxTemp = -INFINITY;
+    for (size_t i = 0; i < pixels; ++i) {
+        if (!isnan(data[i]) && data[i] > maxTemp) maxTemp = data[i];
+    }
+    return maxTemp;
+}
+
+float thermalMin(const float* data, size_t pixels) {
+    if (data == nullptr) return INFINITY;
+    float minTemp = INFINITY;
+    for (size_t i = 0; i < pixels; ++i) {
+        if (!isnan(data[i]) && data[i] < minTemp) minTemp = data[i];
+    }
+    return minTemp;
+}
+
+float thermalAverage(const float* data, size_t pixels) {
+    if (data == nullptr) return NAN;
+    double sumTemp = 0.0; // Double para no perder precisión en la suma
+    size_t validPixels = 0;
+    for (size_t i = 0; i < pixels; ++i) {
+        if (!isnan(data[i])) {
+            sumTemp += data[i];
+            validPixels++;
+        }
+    }
+    return validPixels > 0 ? (float)(sumTemp / validPixels) : NAN; // Evita dividir por cero
+}
@@ -0,0 +1,28 @@
+#ifndef THERMAL_STATS_H
+#define THERMAL_STATS_H
+
+#include <stddef.h>
+#include <math.h>
+
+// Sin dependencias de Arduino: las estadísticas del cuadro térmico también compilan en el
+// host (tools/host_bench). MultipartDataSender y las tareas de imagen las usan en el ESP32.
+
+/**
+ * @brief Temperatura máxima del cuadro, ignorando los píxeles NaN.
+ * @return -INFINITY si `data` es nullptr o todos los píxeles son NaN.
+ */
+float thermalMax(const float* data, size_t pixels);
+
+/**
+ * @brief Temperatura mínima del cuadro, ignorando los píxeles NaN.
+ * @return INFINITY si `data` es nullptr o todos los píxeles son NaN.
+ */
+float thermalMin(const float* data, size_t pixels);
+
+/**
+ * @brief Temperatura media del cuadro (suma en double), ignorando los píxeles NaN.
+ * @return NAN si `data` es nullptr o todos los píxeles son NaN.
+ */
+float thermalAverage(const float* data, size_t pixels);
+
+#endif // THERMAL_STATS_H
@@ -1,5 +1,6 @@
 #include "TimeManager.h"
 #include <WiFi.h> // Para verificar el estado de WiFi (WiFi.status())
+#include "LogFormat.h" // formatTimestamp (portable al host)
 
 // Timeouts para la función 'getLocalTime' (bloqueante)
 #define NTP_PER_SERVER_TIMEOUT_MS 15000 // 15 segundos por servidor
@@ -86,6 +87,16 @@ bool TimeManager::syncNtpTime() {
     return true;
 }
 
+bool TimeManager::adoptRtcTime(time_t now) {
+    // Por debajo de 2020 el RTC no tiene hora (arranque en frío o reloj perdido)
+    if (now < 1577836800) return false;
+    _timeSynchronized = true;
+    #ifdef ENABLE_DEBUG_SERIAL
+        Serial.printf("[TimeManager] Using retained RTC time (epoch %ld); SNTP keeps adjusting in background.\n", (long)now);
+    #endif
+    return true;
+}
+
 String TimeManager::getCurrentTimestampString(bool forFileNames) {
     // Fallback: Si no hay NTP, retorna un timestamp basado en millis() (tiempo de actividad).
     if (!_timeSynchronized) {
@@ -108,14 +119,9 @@ String TimeManager::getCurrentTimestampString(bool forFileNames) {
         return "TIME_STRUCT_ERROR";
     }
 
-    char buf[32];
-    if (forFileNames) {
-        // Formato para nombres de archivo: YYYYMMDD_HHMMSS
-        strftime(buf, sizeof(buf), "%Y%m%d_%H%M%S", &timeinfo);
-    } else {
-        // Formato estándar (ISO 8601 Local): YYYY-MM-DDTHH:MM:SS
-        strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", &timeinfo);
-    }
+    // Nombres de archivo: YYYYMMDD_HHMMSS. Estándar (ISO 8601 local): YYYY-MM-DDTHH:MM:SS
+    char buf[LOG_FORMAT_TIMESTAMP_LEN];
+    formatTimestamp(timeinfo, forFileNames, buf, sizeof(buf));
     return String(buf);
 }
 
@@ -41,6 +41,15 @@ public:
      */
     bool syncNtpTime();
 
+    /**
+     * @brief Da por buena la hora que conserva el RTC tras un reinicio (sin esperar al NTP).
+     * Llamar después de begin(): SNTP sigue corrigiendo la hora en segundo plano.
+     *
+     * @param now Hora actual del RTC (ya validada por el llamador, p. ej. ResumeCheckpoint).
+     * @return True si la hora es plausible y se marcó como sincronizada.
+     */
+    bool adoptRtcTime(time_t now);
+
     /**
      * @brief Obtiene el timestamp actual formateado como un String.
      *
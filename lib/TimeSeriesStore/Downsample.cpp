@@ -0,0 +1,79 @@
+#include "Downsample.h"
+#include <string.h>
+#include <math.h>
+
+size_t downsampleLttb(const TsPoint* in, size_t count, size_t threshold, TsPoint* out) {
+    if (threshold < 3) threshold = 3; // Primero, último y al menos un tramo
+    if (count <= threshold) {
+        memcpy(out, in, count * sizeof(TsPoint));
+        return count;
+    }
+
+    // Tiempos relativos al primer punto (en double para no perder segundos)
+    const double t0 = in[0].time;
+    const double every = (double)(count - 2) / (double)(threshold - 2);
+    size_t selected = 0; // Índice del último punto elegido
+    size_t written = 0;
+    out[written++] = in[0];
+
+    for (size_t bucket = 0; bucket < threshold - 2; bucket++) {
+        // Media del tramo siguiente (el último tramo usa el último punto)
+        size_t nextStart = (size_t)floor((bucket + 1) * every) + 1;
+        size_t nextEnd = (size_t)floor((bucket + 2) * every) + 1;
+        if (nextEnd > count) nextEnd = count;
+        double avgTime = 0.0, avgValue = 0.0;
+        for (size_t i = nextStart; i < nextEnd; i++) {
+            avgTime += in[i].time - t0;
+            avgValue += in[i].value;
+        }
+        size_t nextCount = nextEnd - nextStart;
+        avgTime /= nextCount;
+        avgValue /= nextCount;
+
+        // Punto del tramo actual con el triángulo de mayor área
+        size_t start = (size_t)floor(bucket * every) + 1;
+        size_t end = (size_t)floor((bucket + 1) * every) + 1;
+        double aTime = in[selected].time - t0;
+        double aValue = in[selected].value;
+        double maxArea = -1.0;
+        size_t best = start;
+        for (size_t i = start; i < end; i++) {
+            double area = fabs((aTime - avgTime) * (in[i].value - aValue) - (aTime - (in[i].time - t0)) * (avgValue - aValue));
+            if (area > maxArea) {
+                maxArea = area;
+                best = i;
+            }
+        }
+        out[written++] = in[best];
+        selected = best;
+    }
+
+    out[written++] = in[count - 1];
+    return written;
+}
+
+size_t downsampleMinMax(const TsPoint* in, size_t count, size_t threshold, TsPoint* out) {
+    if (count <= threshold) {
+        memcpy(out, in, count * sizeof(TsPoint));
+        return count;
+    }
+    size_t buckets = threshold / 2;
+    if (buckets == 0) buckets = 1;
+
+    size_t written = 0;
+    for (size_t bucket = 0; bucket < buckets; bucket++) {
+        size_t start = bucket * count / buckets;
+        size_t end = (bucket + 1) * count / buckets;
+        size_t minIndex = start, maxIndex = start;
+        for (size_t i = start + 1; i < end; i++) {
+            if (in[i].value < in[minIndex].value) minIndex = i;
+            if (in[i].value > in[maxIndex].value) maxIndex = i;
+        }
+        // En orden de tiempo; un tramo plano da un solo punto
+        size_t first = minIndex < maxIndex ? minIndex : maxIndex;
+        size_t second = minIndex < maxIndex ? maxIndex : minIndex;
+        out[written++] = in[first];
+        if (second != first) out[written++] = in[second];
+    }
+    return written;
+}
@@ -0,0 +1,37 @@
+#ifndef DOWNSAMPLE_H
+#define DOWNSAMPLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Sin dependencias de Arduino (igual que TimeSeriesStore.h).
+
+/**
+ * @brief Punto de una serie para graficar (época en segundos y valor).
+ */
+struct TsPoint {
+    uint32_t time;
+    float value;
+};
+
+/**
+ * @brief Reduce una serie a `threshold` puntos (mínimo 3) con LTTB (Largest-Triangle-Three-Buckets).
+ *
+ * Conserva el primero y el último; de cada tramo intermedio elige el punto que forma el
+ * triángulo de mayor área con el elegido en el tramo anterior y la media del siguiente,
+ * así que los picos y cambios de tendencia sobreviven aunque la serie se reduzca 50:1.
+ * @param in Serie ordenada por tiempo, sin NaN.
+ * @param out Destino con capacidad para `threshold` puntos (distinto de `in`).
+ * @return Puntos escritos: `count` (copia) si ya hay `threshold` o menos.
+ */
+size_t downsampleLttb(const TsPoint* in, size_t count, size_t threshold, TsPoint* out);
+
+/**
+ * @brief Reduce una serie a como mucho `threshold` puntos con el mínimo y el máximo de
+ * cada tramo (threshold / 2 tramos de igual número de puntos), en orden de tiempo.
+ * Conserva exactamente los extremos de cada tramo (útil para temperaturas máximas).
+ * @return Puntos escritos en `out` (capacidad `threshold`, distinto de `in`).
+ */
+size_t downsampleMinMax(const TsPoint* in, size_t count, size_t threshold, TsPoint* out);
+
+#endif // DOWNSAMPLE_H
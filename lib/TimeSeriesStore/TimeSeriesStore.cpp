@@ -0,0 +1,500 @@
+#include "TimeSeriesStore.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <math.h>
+#ifdef ESP_PLATFORM
+  #include <esp_rom_crc.h>
+#endif
+
+static_assert(sizeof(TsBlockHeader) == TS_HEADER_BYTES, "TsBlockHeader debe ocupar TS_HEADER_BYTES");
+
+#define TS_CRC_OFFSET (TS_HEADER_BYTES - 4)
+#define TS_NO_WINDOW 0xFF
+
+// Marcas de tiempo: prefijo y bits del delta de deltas por tramo (el último guarda 32 bits)
+static const uint8_t TIME_BUCKET_BITS[] = {7, 9, 12};
+
+// Estado del codificador: lo necesario para seguir añadiendo muestras al bloque
+struct TsCodecState {
+    uint32_t bitPos;
+    uint32_t prevTime;
+    int64_t prevDelta;
+    uint32_t prevValue[TS_COLUMNS];
+    uint8_t prevLeading[TS_COLUMNS];
+    uint8_t prevTrailing[TS_COLUMNS];  // TS_NO_WINDOW = aún sin ventana
+};
+
+// Resultado de decodeSamples()
+enum DecodeResult { DECODE_DONE, DECODE_STOPPED, DECODE_CORRUPT };
+
+// --- CRC ---
+
+static uint32_t blockCrc(const uint8_t* block) {
+    uint8_t crcField[4];
+    memcpy(crcField, block + TS_CRC_OFFSET, 4);
+    uint8_t* mutableBlock = (uint8_t*)block;
+    memset(mutableBlock + TS_CRC_OFFSET, 0, 4);
+#ifdef ESP_PLATFORM
+    uint32_t crc = esp_rom_crc32_le(0, block, TS_BLOCK_BYTES);
+#else
+    // CRC-32 (zlib) bit a bit: mismo resultado que esp_rom_crc32_le(0, ...)
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < TS_BLOCK_BYTES; i++) {
+        crc ^= block[i];
+        for (int b = 0; b < 8; b++) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+    crc = ~crc;
+#endif
+    memcpy(mutableBlock + TS_CRC_OFFSET, crcField, 4);
+    return crc;
+}
+
+// --- Bits (el más significativo primero) ---
+
+static bool putBits(uint8_t* payload, uint32_t& pos, uint32_t value, uint8_t count) {
+    if (pos + count > TS_PAYLOAD_BITS) return false;
+    for (int i = count - 1; i >= 0; i--) {
+        uint8_t mask = (uint8_t)(0x80 >> (pos & 7));
+        if ((value >> i) & 1u) payload[pos >> 3] |= mask;
+        else payload[pos >> 3] &= (uint8_t)~mask;
+        pos++;
+    }
+    return true;
+}
+
+static bool getBits(const uint8_t* payload, uint32_t& pos, uint32_t limit, uint8_t count, uint32_t& value) {
+    if (pos + count > limit) return false;
+    value = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        value = (value << 1) | ((payload[pos >> 3] >> (7 - (pos & 7))) & 1u);
+        pos++;
+    }
+    return true;
+}
+
+static uint8_t leadingZeros(uint32_t v) {
+    uint8_t n = 0;
+    while (!(v & 0x80000000u)) { v <<= 1; n++; }
+    return n;
+}
+
+static uint8_t trailingZeros(uint32_t v) {
+    uint8_t n = 0;
+    while (!(v & 1u)) { v >>= 1; n++; }
+    return n;
+}
+
+static uint32_t floatBits(float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+static float bitsFloat(uint32_t bits) {
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+// --- Codificación ---
+
+static void resetState(TsCodecState& state) {
+    memset(&state, 0, sizeof(state));
+    memset(state.prevTrailing, TS_NO_WINDOW, sizeof(state.prevTrailing));
+}
+
+static bool encodeSample(uint8_t* payload, TsCodecState& state, uint16_t index, uint32_t time, const float values[TS_COLUMNS]) {
+    uint32_t& pos = state.bitPos;
+
+    if (index == 0) {
+        // La primera marca de tiempo está en la cabecera; los valores van completos
+        for (int c = 0; c < TS_COLUMNS; c++) {
+            uint32_t bits = floatBits(values[c]);
+            if (!putBits(payload, pos, bits, 32)) return false;
+            state.prevValue[c] = bits;
+        }
+        state.prevTime = time;
+        state.prevDelta = 0;
+        return true;
+    }
+
+    // 1. Tiempo: delta de deltas en tramos 0 / 10+7 / 110+9 / 1110+12 / 1111+32 bits
+    int64_t delta = (int64_t)time - state.prevTime;
+    int64_t dod = delta - state.prevDelta;
+    if (dod == 0) {
+        if (!putBits(payload, pos, 0, 1)) return false;
+    } else {
+        bool written = false;
+        for (uint8_t b = 0; b < sizeof(TIME_BUCKET_BITS); b++) {
+            int64_t offset = (1 << (TIME_BUCKET_BITS[b] - 1)) - 1;
+            if (dod >= -offset && dod <= offset + 1) {
+                // Prefijo de b+1 unos y un cero
+                if (!putBits(payload, pos, ((1u << (b + 2)) - 2), b + 2)) return false;
+                if (!putBits(payload, pos, (uint32_t)(dod + offset), TIME_BUCKET_BITS[b])) return false;
+                written = true;
+                break;
+            }
+        }
+        if (!written) {
+            if (!putBits(payload, pos, 0xF, 4)) return false;
+            if (!putBits(payload, pos, (uint32_t)(int32_t)dod, 32)) return false;
+        }
+    }
+
+    // 2. Valores: XOR con el anterior de la columna
+    for (int c = 0; c < TS_COLUMNS; c++) {
+        uint32_t bits = floatBits(values[c]);
+        uint32_t xorValue = bits ^ state.prevValue[c];
+        if (xorValue == 0) {
+            if (!putBits(payload, pos, 0, 1)) return false;
+            continue;
+        }
+        uint8_t leading = leadingZeros(xorValue);
+        uint8_t trailing = trailingZeros(xorValue);
+        if (state.prevTrailing[c] != TS_NO_WINDOW && leading >= state.prevLeading[c] && trailing >= state.prevTrailing[c]) {
+            // Cabe en la ventana anterior: '10' + bits significativos de esa ventana
+            uint8_t meaningful = 32 - state.prevLeading[c] - state.prevTrailing[c];
+            if (!putBits(payload, pos, 2, 2)) return false;
+            if (!putBits(payload, pos, xorValue >> state.prevTrailing[c], meaningful)) return false;
+        } else {
+            // Ventana nueva: '11' + ceros a la izquierda (5 bits) + longitud - 1 (5 bits) + bits
+            uint8_t meaningful = 32 - leading - trailing;
+            if (!putBits(payload, pos, 3, 2)) return false;
+            if (!putBits(payload, pos, leading, 5)) return false;
+            if (!putBits(payload, pos, meaningful - 1, 5)) return false;
+            if (!putBits(payload, pos, xorValue >> trailing, meaningful)) return false;
+            state.prevLeading[c] = leading;
+            state.prevTrailing[c] = trailing;
+        }
+        state.prevValue[c] = bits;
+    }
+
+    state.prevDelta = delta;
+    state.prevTime = time;
+    return true;
+}
+
+// Descomprime las muestras de un bloque válido; deja en `state` el estado del codificador
+// tras la última. Entrega al callback (si lo hay) las que caen en [from, to].
+static DecodeResult decodeSamples(const uint8_t* block, TsCodecState& state, uint32_t from, uint32_t to,
+                                  TsSampleCallback callback, void* context, uint32_t* delivered) {
+    TsBlockHeader header;
+    memcpy(&header, block, sizeof(header));
+    const uint8_t* payload = block + TS_HEADER_BYTES;
+    uint32_t limit = header.bits;
+    resetState(state);
+    uint32_t& pos = state.bitPos;
+    float values[TS_COLUMNS];
+
+    for (uint16_t i = 0; i < header.count; i++) {
+        uint32_t time;
+        uint32_t bit;
+        if (i == 0) {
+            time = header.firstTime;
+            for (int c = 0; c < TS_COLUMNS; c++) {
+                if (!getBits(payload, pos, limit, 32, state.prevValue[c])) return DECODE_CORRUPT;
+            }
+        } else {
+            // 1. Tiempo
+            int64_t dod = 0;
+            uint8_t ones = 0;
+            while (ones < 4) {
+                if (!getBits(payload, pos, limit, 1, bit)) return DECODE_CORRUPT;
+                if (!bit) break;
+                ones++;
+            }
+            if (ones > 0) {
+                uint32_t raw;
+                if (ones < 4) {
+                    uint8_t width = TIME_BUCKET_BITS[ones - 1];
+                    if (!getBits(payload, pos, limit, width, raw)) return DECODE_CORRUPT;
+                    dod = (int64_t)raw - ((1 << (width - 1)) - 1);
+                } else {
+                    if (!getBits(payload, pos, limit, 32, raw)) return DECODE_CORRUPT;
+                    dod = (int32_t)raw;
+                }
+            }
+            int64_t delta = state.prevDelta + dod;
+            int64_t next = (int64_t)state.prevTime + delta;
+            if (delta <= 0 || next > (int64_t)UINT32_MAX) return DECODE_CORRUPT;
+            time = (uint32_t)next;
+            state.prevDelta = delta;
+
+            // 2. Valores
+            for (int c = 0; c < TS_COLUMNS; c++) {
+                if (!getBits(payload, pos, limit, 1, bit)) return DECODE_CORRUPT;
+                if (!bit) continue; // Repetido
+                if (!getBits(payload, pos, limit, 1, bit)) return DECODE_CORRUPT;
+                uint32_t meaningfulBits;
+                if (!bit) {
+                    if (state.prevTrailing[c] == TS_NO_WINDOW) return DECODE_CORRUPT;
+                    uint8_t meaningful = 32 - state.prevLeading[c] - state.prevTrailing[c];
+                    if (!getBits(payload, pos, limit, meaningful, meaningfulBits)) return DECODE_CORRUPT;
+                } else {
+                    uint32_t leading, length;
+                    if (!getBits(payload, pos, limit, 5, leading)) return DECODE_CORRUPT;
+                    if (!getBits(payload, pos, limit, 5, length)) return DECODE_CORRUPT;
+                    length += 1;
+                    if (leading + length > 32) return DECODE_CORRUPT;
+                    if (!getBits(payload, pos, limit, (uint8_t)length, meaningfulBits)) return DECODE_CORRUPT;
+                    state.prevLeading[c] = (uint8_t)leading;
+                    state.prevTrailing[c] = (uint8_t)(32 - leading - length);
+                }
+                state.prevValue[c] ^= meaningfulBits << state.prevTrailing[c];
+            }
+        }
+        state.prevTime = time;
+
+        if (callback != nullptr && time >= from && time <= to) {
+            for (int c = 0; c < TS_COLUMNS; c++) values[c] = bitsFloat(state.prevValue[c]);
+            if (delivered) (*delivered)++;
+            if (!callback(time, values, context)) return DECODE_STOPPED;
+        }
+    }
+    return pos == limit && state.prevTime == header.lastTime ? DECODE_DONE : DECODE_CORRUPT;
+}
+
+static void startBlock(uint8_t* block, TsCodecState& state) {
+    memset(block, 0, TS_BLOCK_BYTES);
+    TsBlockHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = TS_BLOCK_MAGIC;
+    header.version = TS_BLOCK_VERSION;
+    memcpy(block, &header, sizeof(header));
+    resetState(state);
+}
+
+static void mergeAggregate(TsAggregate& out, float min, float max, double sum, uint32_t count) {
+    if (count == 0) return;
+    if (out.count == 0) {
+        out.min = min;
+        out.max = max;
+    } else {
+        if (min < out.min) out.min = min;
+        if (max > out.max) out.max = max;
+    }
+    out.sum += sum;
+    out.count += count;
+}
+
+static bool aggregateSample(uint32_t time, const float values[TS_COLUMNS], void* context) {
+    (void)time;
+    TsAggregate* out = (TsAggregate*)context;
+    for (int c = 0; c < TS_COLUMNS; c++) {
+        if (!isnan(values[c])) mergeAggregate(out[c], values[c], values[c], values[c], 1);
+    }
+    return true;
+}
+
+// --- TimeSeriesStore ---
+
+TimeSeriesStore::TimeSeriesStore()
+    : _appendedSamples(0), _startedBlocks(0), _corruptTail(0) {
+    memset(_block, 0, sizeof(_block));
+}
+
+bool TimeSeriesStore::isValidBlock(const uint8_t* block) {
+    TsBlockHeader header;
+    memcpy(&header, block, sizeof(header));
+    if (header.magic != TS_BLOCK_MAGIC || header.version != TS_BLOCK_VERSION) return false;
+    if (header.count == 0 || header.bits > TS_PAYLOAD_BITS || header.lastTime < header.firstTime) return false;
+    return blockCrc(block) == header.crc;
+}
+
+bool TimeSeriesStore::_lastValidTime(int fd, int32_t lastBlock, uint32_t& lastTime) {
+    // El último bloque está dañado: la marca de tiempo de referencia es la del anterior válido
+    for (int32_t b = lastBlock; b >= 0; b--) {
+        if (pread(fd, _block, TS_BLOCK_BYTES, (off_t)b * TS_BLOCK_BYTES) != TS_BLOCK_BYTES) return false;
+        if (isValidBlock(_block)) {
+            TsBlockHeader header;
+            memcpy(&header, _block, sizeof(header));
+            lastTime = header.lastTime;
+            return true;
+        }
+    }
+    lastTime = 0;
+    return true;
+}
+
+int TimeSeriesStore::append(const char* path, uint32_t time, const float values[TS_COLUMNS]) {
+    if (path == nullptr || values == nullptr || time == 0) return TS_ERR_ARGS;
+
+    int fd = ::open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return TS_ERR_IO;
+    off_t size = lseek(fd, 0, SEEK_END);
+    if (size < 0) {
+        ::close(fd);
+        return TS_ERR_IO;
+    }
+
+    // 1. Último bloque: si es válido se sigue escribiendo en él
+    //    (un final que no llega a bloque completo es una escritura cortada: se sobrescribe)
+    int32_t blocks = (int32_t)(size / TS_BLOCK_BYTES);
+    off_t blockOffset = (off_t)blocks * TS_BLOCK_BYTES;
+    TsCodecState state;
+    bool continueBlock = false;
+    uint32_t lastTime = 0;
+    if (blocks > 0) {
+        off_t lastOffset = (off_t)(blocks - 1) * TS_BLOCK_BYTES;
+        if (pread(fd, _block, TS_BLOCK_BYTES, lastOffset) != TS_BLOCK_BYTES) {
+            ::close(fd);
+            return TS_ERR_IO;
+        }
+        if (isValidBlock(_block) && decodeSamples(_block, state, 0, 0, nullptr, nullptr, nullptr) == DECODE_DONE) {
+            continueBlock = true;
+            blockOffset = lastOffset;
+            lastTime = state.prevTime;
+        } else {
+            _corruptTail++;
+            if (!_lastValidTime(fd, blocks - 2, lastTime)) {
+                ::close(fd);
+                return TS_ERR_IO;
+            }
+        }
+    }
+    if (time <= lastTime) {
+        ::close(fd);
+        return TS_ERR_OUT_OF_ORDER;
+    }
+
+    // 2. Muestra comprimida al final de la carga; si no cabe, bloque nuevo
+    TsBlockHeader header;
+    if (continueBlock) {
+        memcpy(&header, _block, sizeof(header));
+        if (!encodeSample(_block + TS_HEADER_BYTES, state, header.count, time, values)) {
+            continueBlock = false;
+            blockOffset = (off_t)blocks * TS_BLOCK_BYTES;
+        }
+    }
+    if (!continueBlock) {
+        startBlock(_block, state);
+        memcpy(&header, _block, sizeof(header));
+        encodeSample(_block + TS_HEADER_BYTES, state, 0, time, values); // Siempre cabe
+        header.firstTime = time;
+        _startedBlocks++;
+    }
+
+    // 3. Índice del bloque: rango de tiempo y resumen por columna
+    header.count++;
+    header.bits = (uint16_t)state.bitPos;
+    header.lastTime = time;
+    for (int c = 0; c < TS_COLUMNS; c++) {
+        if (isnan(values[c])) continue;
+        TsColumnSummary& column = header.columns[c];
+        if (column.validCount == 0) {
+            column.min = values[c];
+            column.max = values[c];
+        } else {
+            if (values[c] < column.min) column.min = values[c];
+            if (values[c] > column.max) column.max = values[c];
+        }
+        column.sum += values[c];
+        column.validCount++;
+    }
+    header.crc = 0;
+    memcpy(_block, &header, sizeof(header));
+    header.crc = blockCrc(_block);
+    memcpy(_block, &header, sizeof(header));
+
+    // 4. Un sector alineado por muestra, sincronizado
+    bool ok = pwrite(fd, _block, TS_BLOCK_BYTES, blockOffset) == TS_BLOCK_BYTES;
+    ok = fsync(fd) == 0 && ok;
+    ok = ::close(fd) == 0 && ok;
+    if (!ok) return TS_ERR_IO;
+    _appendedSamples++;
+    return TS_OK;
+}
+
+bool TimeSeriesStore::scan(const char* path, uint32_t from, uint32_t to, TsSampleCallback callback, void* context,
+                           TsReadStats* stats) {
+    if (path == nullptr || callback == nullptr) return false;
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return errno == ENOENT;
+
+    bool ok = true;
+    TsCodecState state;
+    while (true) {
+        ssize_t got = read(fd, _block, TS_BLOCK_BYTES);
+        if (got < 0) ok = false;
+        if (got != TS_BLOCK_BYTES) break; // Fin (o bloque final cortado)
+        if (stats) stats->blocksRead++;
+        if (!isValidBlock(_block)) {
+            if (stats) stats->corruptBlocks++;
+            continue;
+        }
+        TsBlockHeader header;
+        memcpy(&header, _block, sizeof(header));
+        if (header.lastTime < from) {
+            if (stats) stats->blocksSkipped++;
+            continue;
+        }
+        if (header.firstTime > to) {
+            if (stats) stats->blocksSkipped++;
+            break; // Los bloques están en orden de tiempo
+        }
+        uint32_t delivered = 0;
+        DecodeResult result = decodeSamples(_block, state, from, to, callback, context, &delivered);
+        if (stats) {
+            stats->blocksDecoded++;
+            stats->samples += delivered;
+            if (result == DECODE_CORRUPT) stats->corruptBlocks++;
+        }
+        if (result == DECODE_STOPPED) break;
+    }
+    ::close(fd);
+    return ok;
+}
+
+bool TimeSeriesStore::aggregate(const char* path, uint32_t from, uint32_t to, TsAggregate out[TS_COLUMNS],
+                                TsReadStats* stats) {
+    if (path == nullptr || out == nullptr) return false;
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return errno == ENOENT;
+
+    bool ok = true;
+    TsCodecState state;
+    while (true) {
+        ssize_t got = read(fd, _block, TS_BLOCK_BYTES);
+        if (got < 0) ok = false;
+        if (got != TS_BLOCK_BYTES) break;
+        if (stats) stats->blocksRead++;
+        if (!isValidBlock(_block)) {
+            if (stats) stats->corruptBlocks++;
+            continue;
+        }
+        TsBlockHeader header;
+        memcpy(&header, _block, sizeof(header));
+        if (header.lastTime < from) {
+            if (stats) stats->blocksSkipped++;
+            continue;
+        }
+        if (header.firstTime > to) {
+            if (stats) stats->blocksSkipped++;
+            break;
+        }
+        if (header.firstTime >= from && header.lastTime <= to) {
+            // Bloque entero dentro del rango: basta con la cabecera
+            for (int c = 0; c < TS_COLUMNS; c++) {
+                const TsColumnSummary& column = header.columns[c];
+                mergeAggregate(out[c], column.min, column.max, column.sum, column.validCount);
+            }
+            if (stats) {
+                stats->blocksSummarized++;
+                stats->samples += header.count;
+            }
+            continue;
+        }
+        uint32_t delivered = 0;
+        DecodeResult result = decodeSamples(_block, state, from, to, aggregateSample, out, &delivered);
+        if (stats) {
+            stats->blocksDecoded++;
+            stats->samples += delivered;
+            if (result == DECODE_CORRUPT) stats->corruptBlocks++;
+        }
+    }
+    ::close(fd);
+    return ok;
+}
@@ -0,0 +1,168 @@
+#ifndef TIME_SERIES_STORE_H
+#define TIME_SERIES_STORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Sin dependencias de Arduino: lee y escribe con open()/pread()/pwrite() sobre el VFS
+// (en el ESP32 la SD está montada en "/sdcard"), igual que ClusterWriter, así que también
+// compila en el host.
+
+#define TS_COLUMNS 4                  // Columnas por archivo (ver TsColumn y TsThermalColumn)
+#define TS_BLOCK_BYTES 512            // Un sector de la SD: cada bloque se reescribe de una vez
+#define TS_BLOCK_MAGIC 0x5453         // "TS"
+#define TS_BLOCK_VERSION 1
+#define TS_HEADER_BYTES 84
+#define TS_PAYLOAD_BYTES (TS_BLOCK_BYTES - TS_HEADER_BYTES)
+#define TS_PAYLOAD_BITS (TS_PAYLOAD_BYTES * 8)
+
+// --- Resultados de append() ---
+#define TS_OK 0
+#define TS_ERR_IO -1            // No se pudo abrir, leer o escribir el archivo
+#define TS_ERR_OUT_OF_ORDER -2  // Marca de tiempo <= la última del archivo
+#define TS_ERR_ARGS -3          // Ruta nula o marca de tiempo 0 (hora sin sincronizar)
+
+/**
+ * @brief Columnas de la serie ambiental, en el orden de los arrays de valores.
+ */
+enum TsColumn : uint8_t {
+    TS_LIGHT = 0,
+    TS_TEMPERATURE = 1,
+    TS_HUMIDITY = 2,
+    TS_PRESSURE = 3
+};
+
+/**
+ * @brief Columnas de la serie de capturas (resumen térmico de cada captura).
+ */
+enum TsThermalColumn : uint8_t {
+    TS_THERMAL_MAX = 0,
+    TS_THERMAL_MIN = 1,
+    TS_THERMAL_AVG = 2,
+    TS_CANOPY_AVG = 3   ///< Media del dosel (NaN sin calibración o sin imagen)
+};
+
+/**
+ * @brief Resumen de una columna en un bloque (o agregado de un rango).
+ * Los valores NaN (lecturas fallidas) se guardan pero no entran en el resumen.
+ */
+struct TsColumnSummary {
+    float min;
+    float max;
+    float sum;
+    uint16_t validCount;  ///< Muestras no NaN
+    uint16_t reserved;
+};
+
+/**
+ * @brief Cabecera de bloque (little-endian, 84 bytes). Es el índice del archivo: permite
+ * saltar bloques fuera del rango y agregar bloques completos sin descomprimirlos.
+ */
+struct TsBlockHeader {
+    uint16_t magic;
+    uint16_t count;       ///< Muestras en el bloque
+    uint16_t bits;        ///< Bits ocupados de la carga comprimida
+    uint16_t version;
+    uint32_t firstTime;   ///< Época (s) de la primera muestra
+    uint32_t lastTime;    ///< Época (s) de la última muestra
+    TsColumnSummary columns[TS_COLUMNS];
+    uint32_t crc;         ///< CRC-32 del bloque completo con este campo a 0
+};
+
+/**
+ * @brief Agregado de una columna en un rango de tiempo.
+ */
+struct TsAggregate {
+    float min = 0.0f;
+    float max = 0.0f;
+    double sum = 0.0;
+    uint32_t count = 0;   ///< Muestras válidas (no NaN)
+
+    float avg() const { return count > 0 ? (float)(sum / count) : 0.0f; }
+};
+
+/**
+ * @brief Contadores de lectura, acumulables entre archivos (ej. varios días).
+ */
+struct TsReadStats {
+    uint32_t blocksRead = 0;        ///< Bloques leídos de la tarjeta
+    uint32_t blocksSkipped = 0;     ///< Fuera del rango: solo se miró la cabecera
+    uint32_t blocksSummarized = 0;  ///< Dentro del rango: agregados con el resumen de la cabecera
+    uint32_t blocksDecoded = 0;     ///< Descomprimidos muestra a muestra
+    uint32_t corruptBlocks = 0;     ///< Magic, versión o CRC incorrectos (se ignoran)
+    uint32_t samples = 0;           ///< Muestras entregadas o agregadas
+};
+
+/**
+ * @brief Recibe cada muestra de scan(). Devuelve false para detener el recorrido.
+ */
+typedef bool (*TsSampleCallback)(uint32_t time, const float values[TS_COLUMNS], void* context);
+
+/**
+ * @class TimeSeriesStore
+ * @brief Almacén columnar de series (ambientales y resúmenes de captura): un archivo por día
+ * con bloques de 512 bytes.
+ *
+ * Cada bloque lleva una cabecera con el rango de tiempo y el mínimo, máximo y suma de cada
+ * columna, y una carga comprimida al estilo Gorilla: las marcas de tiempo como delta de
+ * deltas (1 bit si el intervalo no cambia) y cada valor como XOR con el anterior de su
+ * columna (1 bit si se repite; si no, solo los bits significativos, reutilizando la ventana
+ * de ceros del valor anterior cuando cabe). Con lecturas reales de los sensores caben unas
+ * 30-80 muestras por bloque: un día cada 5 minutos ocupa 4-5 KB, frente a un archivo JSON
+ * (y un cluster) por muestra.
+ *
+ * append() lee el último bloque, comprueba su CRC, lo descomprime para recuperar el estado
+ * del codificador y lo reescribe entero (un sector, alineado) con la muestra nueva, o abre
+ * un bloque nuevo si no cabe. Un corte durante la escritura solo puede dañar ese bloque: se
+ * detecta por el CRC, las lecturas lo ignoran y la siguiente muestra empieza otro.
+ */
+class TimeSeriesStore {
+public:
+    TimeSeriesStore();
+
+    /**
+     * @brief Añade una muestra al archivo (lo crea si no existe) y sincroniza.
+     * @param path Ruta VFS (ej. "/sdcard/archive/timeseries/20251031_ambient.ts").
+     * @param time Época en segundos; debe ser mayor que la última del archivo.
+     * @param values Un valor por columna (NaN = lectura fallida).
+     * @return TS_OK o un código TS_ERR_*.
+     */
+    int append(const char* path, uint32_t time, const float values[TS_COLUMNS]);
+
+    /**
+     * @brief Entrega, en orden, las muestras del archivo con from <= tiempo <= to.
+     * @return False si el archivo no se pudo abrir o leer (un archivo inexistente no es error: no hay muestras).
+     */
+    bool scan(const char* path, uint32_t from, uint32_t to, TsSampleCallback callback, void* context,
+              TsReadStats* stats = nullptr);
+
+    /**
+     * @brief Acumula en `out` (una entrada por columna) las muestras del rango.
+     * Los bloques completamente dentro del rango se agregan con su cabecera, sin descomprimir.
+     * Se puede llamar con varios archivos seguidos sobre el mismo `out`.
+     */
+    bool aggregate(const char* path, uint32_t from, uint32_t to, TsAggregate out[TS_COLUMNS],
+                   TsReadStats* stats = nullptr);
+
+    /**
+     * @brief Comprueba magic, versión, límites y CRC de un bloque.
+     */
+    static bool isValidBlock(const uint8_t* block);
+
+    uint32_t appendedSamples() const { return _appendedSamples; }
+    uint32_t startedBlocks() const { return _startedBlocks; }   ///< Bloques nuevos abiertos por append()
+    uint32_t corruptTailBlocks() const { return _corruptTail; } ///< Últimos bloques dañados encontrados al añadir
+
+private:
+    uint8_t _block[TS_BLOCK_BYTES];   // Bloque en curso (append) o leído (scan/aggregate)
+    uint32_t _appendedSamples;
+    uint32_t _startedBlocks;
+    uint32_t _corruptTail;
+
+    bool _lastValidTime(int fd, int32_t lastBlock, uint32_t& lastTime);
+
+    TimeSeriesStore(const TimeSeriesStore&);
+    TimeSeriesStore& operator=(const TimeSeriesStore&);
+};
+
+#endif // TIME_SERIES_STORE_H
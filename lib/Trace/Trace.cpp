@@ -0,0 +1,169 @@
+#include "Trace.h"
+#include "esp_heap_caps.h"
+
+// --- Tablas generadas desde TraceEvents.def ---
+static const char* const TRACE_NAMES[] = {
+#define TRACE_EVENT(id, name, category) name,
+#include "TraceEvents.def"
+#undef TRACE_EVENT
+};
+
+static const char* const TRACE_CATEGORIES[] = {
+#define TRACE_EVENT(id, name, category) category,
+#include "TraceEvents.def"
+#undef TRACE_EVENT
+};
+
+Trace::Ring Trace::_rings[TRACE_NUM_CORES];
+std::atomic<bool> Trace::_enabled(false);
+std::atomic<uint8_t> Trace::_pauseDepth(0);
+
+bool Trace::begin() {
+    for (uint8_t core = 0; core < TRACE_NUM_CORES; core++) {
+        if (_rings[core].events) continue; // Ya reservado (begin() llamado de nuevo)
+
+        // Preferir PSRAM; los buffers no se leen en la ruta crítica.
+        TraceEvent* events = (TraceEvent*)heap_caps_calloc(TRACE_RING_CAPACITY, sizeof(TraceEvent), MALLOC_CAP_SPIRAM);
+        if (!events) {
+            events = (TraceEvent*)calloc(TRACE_RING_CAPACITY, sizeof(TraceEvent));
+        }
+        if (!events) {
+            #ifdef ENABLE_DEBUG_SERIAL
+                Serial.printf("[Trace] ERROR: Failed to allocate %u bytes for core %u ring.\n",
+                              (unsigned int)(sizeof(TraceEvent) * TRACE_RING_CAPACITY), core);
+            #endif
+            return false;
+        }
+        _rings[core].events = events;
+        _rings[core].head.store(0);
+    }
+
+    _enabled.store(true);
+    #ifdef ENABLE_DEBUG_SERIAL
+        Serial.printf("[Trace] Tracing enabled (%u events per core).\n", (unsigned int)TRACE_RING_CAPACITY);
+    #endif
+    return true;
+}
+
+void Trace::setEnabled(bool enabled) {
+    // Solo se puede activar si los buffers existen
+    _enabled.store(enabled && isReady());
+}
+
+bool Trace::isEnabled() {
+    return _enabled.load();
+}
+
+void Trace::pause() {
+    _pauseDepth.fetch_add(1);
+}
+
+void Trace::unpause() {
+    // Un unpause() sin pause() no debe dejar el contador en 255
+    uint8_t depth = _pauseDepth.load();
+    while (depth > 0 && !_pauseDepth.compare_exchange_weak(depth, (uint8_t)(depth - 1))) {}
+}
+
+bool Trace::isReady() {
+    for (uint8_t core = 0; core < TRACE_NUM_CORES; core++) {
+        if (!_rings[core].events) return false;
+    }
+    return true;
+}
+
+void Trace::clear() {
+    for (uint8_t core = 0; core < TRACE_NUM_CORES; core++) {
+        _rings[core].head.store(0);
+    }
+}
+
+const char* Trace::nameOf(uint16_t id) {
+    return id < (uint16_t)TraceId::COUNT ? TRACE_NAMES[id] : "unknown";
+}
+
+const char* Trace::categoryOf(uint16_t id) {
+    return id < (uint16_t)TraceId::COUNT ? TRACE_CATEGORIES[id] : "unknown";
+}
+
+// --- TraceExporter ---
+
+TraceExporter::TraceExporter()
+    : _stage(Stage::HEADER), _core(0), _chunkLen(0), _chunkPos(0) {
+    Trace::pause();
+
+    // Instantánea de los índices: solo se exportan los eventos que siguen en el buffer
+    for (uint8_t core = 0; core < TRACE_NUM_CORES; core++) {
+        uint32_t head = Trace::_rings[core].head.load();
+        _end[core] = head;
+        _next[core] = head > TRACE_RING_CAPACITY ? head - TRACE_RING_CAPACITY : 0;
+    }
+}
+
+TraceExporter::~TraceExporter() {
+    Trace::unpause();
+}
+
+size_t TraceExporter::read(uint8_t* buffer, size_t maxLen) {
+    size_t written = 0;
+    while (written < maxLen) {
+        if (_chunkPos >= _chunkLen) {
+            if (!_fillChunk()) break; // JSON completo
+        }
+        size_t n = std::min(maxLen - written, _chunkLen - _chunkPos);
+        memcpy(buffer + written, _chunk + _chunkPos, n);
+        written += n;
+        _chunkPos += n;
+    }
+    return written;
+}
+
+bool TraceExporter::_fillChunk() {
+    _chunkPos = 0;
+    _chunkLen = 0;
+    int n = 0;
+
+    switch (_stage) {
+        case Stage::HEADER:
+            n = snprintf(_chunk, sizeof(_chunk),
+                         "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+                         "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"ArandanoIRT\"}},\n"
+                         "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"core0\"}},\n"
+                         "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"core1\"}}");
+            _stage = Stage::EVENTS;
+            break;
+
+        case Stage::EVENTS: {
+            // Avanza al siguiente núcleo con eventos pendientes
+            while (_core < TRACE_NUM_CORES && _next[_core] >= _end[_core]) {
+                _core++;
+            }
+            if (_core >= TRACE_NUM_CORES || !Trace::_rings[_core].events) {
+                _stage = Stage::FOOTER;
+                return _fillChunk();
+            }
+
+            const TraceEvent& ev = Trace::_rings[_core].events[_next[_core] & (TRACE_RING_CAPACITY - 1)];
+            _next[_core]++;
+
+            unsigned long long ts = ((unsigned long long)ev.timestampHigh << 32) | ev.timestampUs;
+
+            n = snprintf(_chunk, sizeof(_chunk),
+                         ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%llu,\"pid\":1,\"tid\":%u%s}",
+                         Trace::nameOf(ev.id), Trace::categoryOf(ev.id), (char)ev.phase, ts, _core,
+                         ev.phase == (uint8_t)TracePhase::INSTANT ? ",\"s\":\"t\"" : "");
+            break;
+        }
+
+        case Stage::FOOTER:
+            n = snprintf(_chunk, sizeof(_chunk), "\n]}\n");
+            _stage = Stage::DONE;
+            break;
+
+        case Stage::DONE:
+            return false;
+    }
+
+    if (n < 0) return false;
+    _chunkLen = std::min((size_t)n, sizeof(_chunk) - 1);
+    return true;
+}
@@ -0,0 +1,191 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "esp_timer.h"
+
+// --- Configuración del buffer de trazas ---
+#ifndef TRACE_RING_CAPACITY
+#define TRACE_RING_CAPACITY 2048    // Eventos por núcleo (potencia de 2). 8 bytes c/u, en PSRAM.
+#endif
+#define TRACE_NUM_CORES 2           // ESP32-S3: PRO_CPU (0) y APP_CPU (1)
+
+static_assert((TRACE_RING_CAPACITY & (TRACE_RING_CAPACITY - 1)) == 0,
+              "TRACE_RING_CAPACITY must be a power of 2");
+
+/**
+ * @brief IDs de evento de traza, generados en compilación desde TraceEvents.def.
+ */
+enum class TraceId : uint16_t {
+#define TRACE_EVENT(id, name, category) id,
+#include "TraceEvents.def"
+#undef TRACE_EVENT
+    COUNT
+};
+
+/**
+ * @brief Fase del evento (mismos caracteres que el campo "ph" de Chrome trace_event).
+ */
+enum class TracePhase : uint8_t {
+    BEGIN = 'B',
+    END = 'E',
+    INSTANT = 'i'
+};
+
+/**
+ * @brief Evento compacto almacenado en el buffer circular (8 bytes).
+ */
+struct TraceEvent {
+    uint32_t timestampUs; ///< Microsegundos desde el arranque (esp_timer), 32 bits bajos.
+    uint16_t id;          ///< TraceId
+    uint8_t phase;        ///< TracePhase
+    uint8_t timestampHigh; ///< Bits 32-39 del timestamp (40 bits = ~12 días de uptime).
+};
+
+/**
+ * @class Trace
+ * @brief Clase de utilidad (estática) para registrar eventos de traza.
+ *
+ * Mantiene un buffer circular por núcleo (sin locks: cada escritor reserva su
+ * casilla con un fetch_add atómico) y sobrescribe los eventos más antiguos.
+ * No usar directamente: usar las macros TRACE_*, que desaparecen si el firmware
+ * no se compila con -D ENABLE_TRACE.
+ */
+class Trace {
+public:
+    /**
+     * @brief Reserva los buffers (PSRAM si está disponible) y activa el registro.
+     * @return True si los buffers se reservaron correctamente.
+     */
+    static bool begin();
+
+    /**
+     * @brief Registra un evento en el buffer del núcleo actual.
+     */
+    static inline void record(TraceId id, TracePhase phase) {
+        if (!_enabled.load(std::memory_order_relaxed) || _pauseDepth.load(std::memory_order_relaxed) != 0) return;
+        Ring& ring = _rings[xPortGetCoreID()];
+        uint32_t slot = ring.head.fetch_add(1, std::memory_order_relaxed);
+        TraceEvent& ev = ring.events[slot & (TRACE_RING_CAPACITY - 1)];
+        uint64_t now = (uint64_t)esp_timer_get_time();
+        ev.timestampUs = (uint32_t)now;
+        ev.timestampHigh = (uint8_t)(now >> 32);
+        ev.id = (uint16_t)id;
+        ev.phase = (uint8_t)phase;
+    }
+
+    /**
+     * @brief Activa o desactiva el registro (independiente de las pausas).
+     */
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+
+    /**
+     * @brief Pausa el registro mientras haya al menos una pausa abierta (contador de
+     * profundidad: varias exportaciones simultáneas no se pisan el estado).
+     */
+    static void pause();
+    static void unpause();
+
+    /**
+     * @brief Indica si begin() reservó los buffers.
+     */
+    static bool isReady();
+
+    /**
+     * @brief Descarta todos los eventos registrados.
+     */
+    static void clear();
+
+    static const char* nameOf(uint16_t id);
+    static const char* categoryOf(uint16_t id);
+
+private:
+    friend class TraceExporter;
+
+    struct Ring {
+        TraceEvent* events;
+        std::atomic<uint32_t> head; ///< Total de eventos escritos (la casilla es head % capacidad)
+    };
+
+    static Ring _rings[TRACE_NUM_CORES];
+    static std::atomic<bool> _enabled;
+    static std::atomic<uint8_t> _pauseDepth; ///< Pausas abiertas (exportaciones en curso)
+};
+
+/**
+ * @class TraceScope
+ * @brief (RAII) Registra BEGIN al construirse y END al destruirse.
+ */
+class TraceScope {
+public:
+    explicit TraceScope(TraceId id) : _id(id) { Trace::record(_id, TracePhase::BEGIN); }
+    ~TraceScope() { Trace::record(_id, TracePhase::END); }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    TraceId _id;
+};
+
+/**
+ * @class TraceExporter
+ * @brief Convierte los buffers a JSON de Chrome trace_event de forma incremental.
+ *
+ * Genera un evento a la vez en un buffer pequeño, así que puede alimentar una
+ * respuesta chunked sin copiar la traza completa a RAM. Mientras existe, el
+ * registro queda pausado (para que los buffers no se sobrescriban a mitad de la
+ * exportación); el destructor cierra su pausa y el registro se reanuda cuando
+ * termina la última exportación.
+ */
+class TraceExporter {
+public:
+    TraceExporter();
+    ~TraceExporter();
+    TraceExporter(const TraceExporter&) = delete;
+    TraceExporter& operator=(const TraceExporter&) = delete;
+
+    /**
+     * @brief Escribe el siguiente fragmento del JSON.
+     * @param buffer Buffer de salida.
+     * @param maxLen Tamaño del buffer de salida.
+     * @return Bytes escritos; 0 cuando el JSON está completo.
+     */
+    size_t read(uint8_t* buffer, size_t maxLen);
+
+private:
+    enum class Stage : uint8_t { HEADER, EVENTS, FOOTER, DONE };
+
+    /**
+     * @brief (Helper) Genera el siguiente fragmento en _chunk. False si no queda nada.
+     */
+    bool _fillChunk();
+
+    Stage _stage;
+    uint8_t _core;                        ///< Núcleo que se está exportando
+    uint32_t _next[TRACE_NUM_CORES];      ///< Siguiente evento a exportar (contador absoluto)
+    uint32_t _end[TRACE_NUM_CORES];       ///< Valor de head al iniciar la exportación
+    char _chunk[320];
+    size_t _chunkLen;
+    size_t _chunkPos;
+};
+
+// --- Macros de instrumentación ---
+// Sin -D ENABLE_TRACE no generan código (ni siquiera evalúan el ID).
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#ifdef ENABLE_TRACE
+    #define TRACE_BEGIN(id)   Trace::record(TraceId::id, TracePhase::BEGIN)
+    #define TRACE_END(id)     Trace::record(TraceId::id, TracePhase::END)
+    #define TRACE_INSTANT(id) Trace::record(TraceId::id, TracePhase::INSTANT)
+    #define TRACE_SCOPE(id)   TraceScope TRACE_CONCAT(_traceScope_, __LINE__)(TraceId::id)
+#else
+    #define TRACE_BEGIN(id)   do {} while (0)
+    #define TRACE_END(id)     do {} while (0)
+    #define TRACE_INSTANT(id) do {} while (0)
+    #define TRACE_SCOPE(id)   do {} while (0)
+#endif
+
+#endif // TRACE_H
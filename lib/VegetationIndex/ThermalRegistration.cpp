@@ -0,0 +1,144 @@
+#include "ThermalRegistration.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef ESP_PLATFORM
+    #include "esp_heap_caps.h"
+#endif
+
+#define HOMOGRAPHY_MIN_DET 1e-12f // Por debajo, la matriz se considera singular
+#define HOMOGRAPHY_MIN_W 1e-6f    // Puntos en (o tras) la recta del horizonte: fuera de campo
+
+static float determinant3(const float h[9]) {
+    return h[0] * (h[4] * h[8] - h[5] * h[7])
+         - h[1] * (h[3] * h[8] - h[5] * h[6])
+         + h[2] * (h[3] * h[7] - h[4] * h[6]);
+}
+
+bool parseHomography(const char* text, float h[9]) {
+    if (text == nullptr) return false;
+    const char* p = text;
+    for (int i = 0; i < 9; i++) {
+        while (*p == ' ' || *p == ',' || *p == '\t') p++;
+        char* end = nullptr;
+        h[i] = strtof(p, &end);
+        if (end == p || !isfinite(h[i])) return false;
+        p = end;
+    }
+    while (*p == ' ' || *p == ',' || *p == '\t') p++;
+    if (*p != '\0') return false; // Sobran valores
+    return fabsf(determinant3(h)) > HOMOGRAPHY_MIN_DET;
+}
+
+ThermalRegistration::ThermalRegistration()
+    : _calibrated(false), _lut(nullptr), _lutCapacity(0), _lutWidth(0), _lutHeight(0), _lutScale(0) {
+    memset(_h, 0, sizeof(_h));
+    memset(_canopy, 0, sizeof(_canopy));
+}
+
+ThermalRegistration::~ThermalRegistration() {
+    free(_lut);
+}
+
+bool ThermalRegistration::setHomography(const float h[9]) {
+    if (fabsf(determinant3(h)) <= HOMOGRAPHY_MIN_DET) {
+        clear();
+        return false;
+    }
+    if (_calibrated && memcmp(_h, h, sizeof(_h)) == 0) return true; // Misma calibración: se conserva la tabla
+    memcpy(_h, h, sizeof(_h));
+    _calibrated = true;
+    _lutWidth = 0; // Tabla obsoleta
+    return true;
+}
+
+void ThermalRegistration::clear() {
+    _calibrated = false;
+    _lutWidth = 0;
+}
+
+bool ThermalRegistration::_buildLut(uint16_t maskWidth, uint16_t maskHeight, uint8_t scale) {
+    size_t cells = (size_t)maskWidth * maskHeight;
+    if (cells > _lutCapacity) {
+        free(_lut);
+        #ifdef ESP_PLATFORM
+            _lut = (uint16_t*)heap_caps_malloc(cells * sizeof(uint16_t), MALLOC_CAP_SPIRAM);
+            if (!_lut) _lut = (uint16_t*)malloc(cells * sizeof(uint16_t));
+        #else
+            _lut = (uint16_t*)malloc(cells * sizeof(uint16_t));
+        #endif
+        _lutCapacity = _lut ? cells : 0;
+        if (!_lut) return false;
+    }
+
+    // Centro de cada celda en coordenadas de la imagen completa -> píxel térmico que lo contiene
+    for (uint16_t y = 0; y < maskHeight; y++) {
+        float vy = (y + 0.5f) * scale;
+        for (uint16_t x = 0; x < maskWidth; x++) {
+            float vx = (x + 0.5f) * scale;
+            float w = _h[6] * vx + _h[7] * vy + _h[8];
+            uint16_t target = THERMAL_REG_PIXELS;
+            if (w > HOMOGRAPHY_MIN_W) {
+                float u = (_h[0] * vx + _h[1] * vy + _h[2]) / w;
+                float v = (_h[3] * vx + _h[4] * vy + _h[5]) / w;
+                if (u >= 0.0f && u < THERMAL_REG_WIDTH && v >= 0.0f && v < THERMAL_REG_HEIGHT) {
+                    target = (uint16_t)((int)v * THERMAL_REG_WIDTH + (int)u);
+                }
+            }
+            _lut[(size_t)y * maskWidth + x] = target;
+        }
+    }
+    _lutWidth = maskWidth;
+    _lutHeight = maskHeight;
+    _lutScale = scale;
+    return true;
+}
+
+bool ThermalRegistration::project(const uint8_t* mask, uint16_t maskWidth, uint16_t maskHeight, uint8_t scale,
+                                  const float* thermal, CanopyThermalStats& stats) {
+    stats = CanopyThermalStats();
+    if (!_calibrated || mask == nullptr || thermal == nullptr || maskWidth == 0 || maskHeight == 0 || scale == 0) return false;
+    if (maskWidth != _lutWidth || maskHeight != _lutHeight || scale != _lutScale) {
+        if (!_buildLut(maskWidth, maskHeight, scale)) return false;
+    }
+
+    // 1. Celdas (y celdas de dosel) por píxel térmico
+    memset(_cells, 0, sizeof(_cells));
+    memset(_canopyCells, 0, sizeof(_canopyCells));
+    size_t cells = (size_t)maskWidth * maskHeight;
+    for (size_t i = 0; i < cells; i++) {
+        uint16_t target = _lut[i];
+        _cells[target]++;
+        _canopyCells[target] += mask[i];
+    }
+
+    // 2. Píxeles térmicos de dosel (al menos la mitad de sus celdas) y sus estadísticas
+    float sum = 0.0f;
+    float maxTemp = -INFINITY;
+    float minTemp = INFINITY;
+    uint16_t canopy = 0;
+    uint16_t covered = 0;
+    for (int i = 0; i < THERMAL_REG_PIXELS; i++) {
+        uint8_t isCanopy = (_cells[i] > 0) & (2 * _canopyCells[i] >= _cells[i]) & !isnan(thermal[i]);
+        _canopy[i] = isCanopy;
+        covered += _cells[i] > 0;
+        if (isCanopy) {
+            float t = thermal[i];
+            sum += t;
+            if (t > maxTemp) maxTemp = t;
+            if (t < minTemp) minTemp = t;
+            canopy++;
+        }
+    }
+
+    stats.canopyPixels = canopy;
+    stats.coveredPixels = covered;
+    if (canopy >= THERMAL_REG_MIN_CANOPY_PIXELS) {
+        stats.maxTemp = maxTemp;
+        stats.minTemp = minTemp;
+        stats.avgTemp = sum / canopy;
+        stats.valid = true;
+    }
+    return true;
+}
@@ -0,0 +1,91 @@
+#ifndef THERMAL_REGISTRATION_H
+#define THERMAL_REGISTRATION_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "VegetationIndex.h"
+
+// Sin dependencias de Arduino (igual que VegetationIndex.h).
+
+#define THERMAL_REG_WIDTH 32                 // Columnas del MLX90640
+#define THERMAL_REG_HEIGHT 24                // Filas del MLX90640
+#define THERMAL_REG_PIXELS (THERMAL_REG_WIDTH * THERMAL_REG_HEIGHT)
+#define THERMAL_REG_MIN_CANOPY_PIXELS 4      // Por debajo, las estadísticas del dosel no son representativas
+
+/**
+ * @brief Lee una homografía de 9 coeficientes (fila a fila, separados por comas o espacios),
+ * el formato de `thermal_homography` en config.json que genera tools/thermal_calibration.py.
+ * @param[out] h Coeficientes leídos.
+ * @return False si el texto no tiene exactamente 9 números o la matriz es singular.
+ */
+bool parseHomography(const char* text, float h[9]);
+
+/**
+ * @class ThermalRegistration
+ * @brief Proyecta la máscara de dosel de la imagen visual sobre la rejilla térmica de 32x24
+ * y calcula las estadísticas térmicas solo del dosel.
+ *
+ * La homografía lleva coordenadas de píxel de la imagen visual completa (640x480) a
+ * coordenadas de la rejilla térmica: el píxel térmico (columna c, fila r) cubre
+ * [c, c+1) x [r, r+1). Se ajusta una vez por equipo con tools/thermal_calibration.py.
+ *
+ * La proyección se precalcula en una tabla (una entrada por celda de la máscara: el índice
+ * del píxel térmico que la contiene, o una casilla de descarte si queda fuera del campo
+ * térmico). Por ciclo solo se recorre la tabla (4800 celdas para VGA a 1/8) y los 768
+ * píxeles térmicos, sin divisiones ni saltos por celda. Un píxel térmico es dosel si al
+ * menos la mitad de las celdas que caen en él lo son.
+ */
+class ThermalRegistration {
+public:
+    ThermalRegistration();
+    ~ThermalRegistration();
+
+    /**
+     * @brief Fija la homografía. Si cambia, la tabla se recalcula en la siguiente proyección.
+     * @return False (y queda sin calibrar) si la matriz es singular.
+     */
+    bool setHomography(const float h[9]);
+
+    /**
+     * @brief Quita la calibración: project() devuelve false hasta un nuevo setHomography().
+     */
+    void clear();
+
+    bool isCalibrated() const { return _calibrated; }
+
+    /**
+     * @brief Estadísticas térmicas de los píxeles de dosel.
+     * @param mask Máscara de dosel (1 = dosel), maskWidth x maskHeight, de VegetationAnalyzer.
+     * @param scale Factor de reducción de la máscara respecto a la imagen visual (VEGETATION_DECODE_SCALE).
+     * @param thermal Frame térmico (768 valores, NaN = píxel inválido).
+     * @param[out] stats Resultado; valid = false si hay menos de THERMAL_REG_MIN_CANOPY_PIXELS.
+     * @return False si no hay calibración, faltan datos o no se pudo reservar la tabla.
+     */
+    bool project(const uint8_t* mask, uint16_t maskWidth, uint16_t maskHeight, uint8_t scale,
+                 const float* thermal, CanopyThermalStats& stats);
+
+    /**
+     * @brief Clasificación de la última proyección: 1 por píxel térmico de dosel (768 valores).
+     */
+    const uint8_t* canopyPixels() const { return _canopy; }
+
+private:
+    float _h[9];
+    bool _calibrated;
+    uint16_t* _lut;          // Celda de la máscara -> píxel térmico (THERMAL_REG_PIXELS = fuera de campo)
+    size_t _lutCapacity;
+    uint16_t _lutWidth;      // Dimensiones para las que está calculada la tabla (0 = sin calcular)
+    uint16_t _lutHeight;
+    uint8_t _lutScale;
+    // Una casilla más que píxeles térmicos: ahí caen las celdas fuera de campo
+    uint16_t _cells[THERMAL_REG_PIXELS + 1];
+    uint16_t _canopyCells[THERMAL_REG_PIXELS + 1];
+    uint8_t _canopy[THERMAL_REG_PIXELS];
+
+    bool _buildLut(uint16_t maskWidth, uint16_t maskHeight, uint8_t scale);
+
+    ThermalRegistration(const ThermalRegistration&);
+    ThermalRegistration& operator=(const ThermalRegistration&);
+};
+
+#endif // THERMAL_REGISTRATION_H
@@ -0,0 +1,149 @@
+#include "VegetationIndex.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+    #include "esp_jpg_decode.h"
+    #include "esp_heap_caps.h"
+    #include "esp_timer.h"
+#endif
+
+void computeVegetationIndices(const uint8_t* rgb, size_t pixels, VegetationStats& stats, uint8_t* mask) {
+    float sumExg = 0.0f;
+    float sumExgr = 0.0f;
+    uint32_t lit = 0;
+    uint32_t canopy = 0;
+
+    for (size_t i = 0; i < pixels; i++) {
+        int32_t r = rgb[3 * i];
+        int32_t g = rgb[3 * i + 1];
+        int32_t b = rgb[3 * i + 2];
+        int32_t sum = r + g + b;
+        // Los píxeles oscuros cuentan como no dosel y no entran en las medias (sin saltos: peso 0/1)
+        int32_t isLit = sum >= VEGETATION_MIN_BRIGHTNESS;
+        float weight = isLit ? 1.0f / (float)sum : 0.0f;
+        sumExg += (float)(2 * g - r - b) * weight;
+        sumExgr += (3.0f * g - 2.4f * r - (float)b) * weight;
+        // ExGR > 0  <=>  3g - 2.4r - b > 0  <=>  30G - 24R - 10B > 0 (enteros, sin dividir)
+        int32_t isCanopy = isLit & (30 * g - 24 * r - 10 * b > 0);
+        lit += isLit;
+        canopy += isCanopy;
+        if (mask) mask[i] = (uint8_t)isCanopy;
+    }
+
+    stats.exg = lit ? sumExg / lit : NAN;
+    stats.exgr = lit ? sumExgr / lit : NAN;
+    stats.canopyFraction = pixels ? (float)canopy / pixels : NAN;
+}
+
+bool jpegDimensions(const uint8_t* jpeg, size_t length, uint16_t& width, uint16_t& height) {
+    if (jpeg == nullptr || length < 4 || jpeg[0] != 0xFF || jpeg[1] != 0xD8) return false;
+    size_t pos = 2;
+    while (pos + 4 <= length) {
+        if (jpeg[pos] != 0xFF) return false;
+        uint8_t marker = jpeg[pos + 1];
+        if (marker == 0xFF) { // Relleno entre marcadores
+            pos++;
+            continue;
+        }
+        size_t segment = ((size_t)jpeg[pos + 2] << 8) | jpeg[pos + 3];
+        if (marker >= 0xC0 && marker <= 0xC2) {
+            if (pos + 9 > length) return false;
+            height = ((uint16_t)jpeg[pos + 5] << 8) | jpeg[pos + 6];
+            width = ((uint16_t)jpeg[pos + 7] << 8) | jpeg[pos + 8];
+            return width > 0 && height > 0;
+        }
+        if (marker == 0xDA || marker == 0xD9) return false; // Datos de imagen sin SOF antes
+        pos += 2 + segment;
+    }
+    return false;
+}
+
+VegetationAnalyzer::VegetationAnalyzer()
+    : _rgb(nullptr), _mask(nullptr), _capacity(0), _width(0), _height(0), _maskValid(false),
+      _jpeg(nullptr), _jpegLength(0) {}
+
+VegetationAnalyzer::~VegetationAnalyzer() {
+    free(_rgb);
+    free(_mask);
+}
+
+bool VegetationAnalyzer::_reserve(size_t pixels) {
+    if (pixels <= _capacity) return true;
+    free(_rgb);
+    free(_mask);
+    #ifdef ESP_PLATFORM
+        _rgb = (uint8_t*)heap_caps_malloc(pixels * 3, MALLOC_CAP_SPIRAM);
+        _mask = (uint8_t*)heap_caps_malloc(pixels, MALLOC_CAP_SPIRAM);
+        if (!_rgb) _rgb = (uint8_t*)malloc(pixels * 3); // Sin PSRAM: RAM interna (4.8 KB para VGA)
+        if (!_mask) _mask = (uint8_t*)malloc(pixels);
+    #else
+        _rgb = (uint8_t*)malloc(pixels * 3);
+        _mask = (uint8_t*)malloc(pixels);
+    #endif
+    if (!_rgb || !_mask) {
+        free(_rgb);
+        free(_mask);
+        _rgb = nullptr;
+        _mask = nullptr;
+        _capacity = 0;
+        return false;
+    }
+    _capacity = pixels;
+    return true;
+}
+
+bool VegetationAnalyzer::analyze(const uint8_t* jpeg, size_t length, VegetationStats& stats) {
+    stats = VegetationStats();
+    _maskValid = false;
+
+    uint16_t fullWidth, fullHeight;
+    if (!jpegDimensions(jpeg, length, fullWidth, fullHeight)) return false;
+    // TJpgDec redondea hacia arriba al reducir (bloques MCU parciales)
+    _width = (fullWidth + VEGETATION_DECODE_SCALE - 1) / VEGETATION_DECODE_SCALE;
+    _height = (fullHeight + VEGETATION_DECODE_SCALE - 1) / VEGETATION_DECODE_SCALE;
+    size_t pixels = (size_t)_width * _height;
+    if (!_reserve(pixels)) return false;
+
+    #ifdef ESP_PLATFORM
+        int64_t decodeStart = esp_timer_get_time();
+        memset(_rgb, 0, pixels * 3);
+        _jpeg = jpeg;
+        _jpegLength = length;
+        esp_err_t result = esp_jpg_decode(length, JPG_SCALE_8X, _read, _write, this);
+        _jpeg = nullptr;
+        if (result != ESP_OK) return false;
+        int64_t computeStart = esp_timer_get_time();
+        computeVegetationIndices(_rgb, pixels, stats, _mask);
+        stats.decodeUs = (uint32_t)(computeStart - decodeStart);
+        stats.computeUs = (uint32_t)(esp_timer_get_time() - computeStart);
+        stats.width = _width;
+        stats.height = _height;
+        stats.valid = true;
+        _maskValid = true;
+        return true;
+    #else
+        return false; // En el host no hay decodificador: usar computeVegetationIndices() con RGB ya reducido
+    #endif
+}
+
+size_t VegetationAnalyzer::_read(void* arg, size_t index, uint8_t* buf, size_t len) {
+    VegetationAnalyzer* self = static_cast<VegetationAnalyzer*>(arg);
+    if (index >= self->_jpegLength) return 0;
+    if (index + len > self->_jpegLength) len = self->_jpegLength - index;
+    if (buf) memcpy(buf, self->_jpeg + index, len); // buf == NULL: el decodificador salta datos
+    return len;
+}
+
+bool VegetationAnalyzer::_write(void* arg, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t* data) {
+    if (data == nullptr) return true; // Aviso de inicio/fin de la imagen
+    VegetationAnalyzer* self = static_cast<VegetationAnalyzer*>(arg);
+    if (x >= self->_width || y >= self->_height) return true;
+    // Cada bloque llega como RGB888 de w x h; se recorta a la imagen reducida
+    uint16_t copyWidth = (x + w > self->_width) ? self->_width - x : w;
+    uint16_t rows = (y + h > self->_height) ? self->_height - y : h;
+    for (uint16_t row = 0; row < rows; row++) {
+        memcpy(self->_rgb + ((size_t)(y + row) * self->_width + x) * 3, data + (size_t)row * w * 3, (size_t)copyWidth * 3);
+    }
+    return true;
+}
@@ -0,0 +1,108 @@
+#ifndef VEGETATION_INDEX_H
+#define VEGETATION_INDEX_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+// Sin dependencias de Arduino: el cálculo por píxel también compila en el host
+// (tools/vegetation_bench). La decodificación del JPEG solo existe en el ESP32.
+
+#define VEGETATION_DECODE_SCALE 8          // Escala de decodificación (1/8: solo coeficientes DC)
+#define VEGETATION_MIN_BRIGHTNESS 24       // R+G+B mínimo: por debajo la cromaticidad es ruido (sombra)
+
+/**
+ * @brief Estadísticas térmicas solo de los píxeles del MLX90640 que caen sobre dosel
+ * (ver ThermalRegistration). Sin calibración o con poco dosel a la vista, valid = false.
+ */
+struct CanopyThermalStats {
+    uint16_t canopyPixels = 0;   ///< Píxeles térmicos clasificados como dosel
+    uint16_t coveredPixels = 0;  ///< Píxeles térmicos dentro del campo de la cámara visual
+    float maxTemp = NAN;
+    float minTemp = NAN;
+    float avgTemp = NAN;
+    bool valid = false;
+};
+
+/**
+ * @brief Índices de vegetación de una imagen, calculados sobre la versión reducida 1/8.
+ * ExG = 2g - r - b y ExGR = ExG - ExR (ExR = 1.4r - g), con r, g, b coordenadas
+ * cromáticas (R/(R+G+B)...). Un píxel es dosel si ExGR > 0 (umbral de Meyer y Neto).
+ */
+struct VegetationStats {
+    uint16_t width = 0;          ///< Ancho de la imagen reducida (80 para VGA)
+    uint16_t height = 0;         ///< Alto de la imagen reducida (60 para VGA)
+    float exg = NAN;             ///< ExG medio de los píxeles con luz suficiente
+    float exgr = NAN;            ///< ExGR medio de los píxeles con luz suficiente
+    float canopyFraction = NAN;  ///< Fracción de píxeles de dosel (0-1) sobre el total
+    uint32_t decodeUs = 0;       ///< Tiempo de decodificación 1/8
+    uint32_t computeUs = 0;      ///< Tiempo del cálculo por píxel
+    bool valid = false;
+    CanopyThermalStats canopyThermal; ///< Temperaturas del dosel (si hay homografía calibrada)
+};
+
+/**
+ * @brief Calcula ExG, ExGR y la fracción de dosel de una imagen RGB888.
+ *
+ * El bucle no tiene saltos que dependan de los datos (el umbral de dosel es una
+ * comparación entera, 30G - 24R - 10B > 0, equivalente a ExGR > 0), así que el
+ * compilador lo puede vectorizar o desenrollar.
+ * @param rgb Píxeles RGB888 consecutivos.
+ * @param pixels Número de píxeles.
+ * @param[out] stats Medias y fracción (width/height y tiempos no se tocan).
+ * @param[out] mask Opcional: 1 por píxel de dosel, 0 si no (mismo orden que `rgb`).
+ */
+void computeVegetationIndices(const uint8_t* rgb, size_t pixels, VegetationStats& stats, uint8_t* mask = nullptr);
+
+/**
+ * @brief Lee el ancho y alto del marcador SOF de un JPEG.
+ * @return False si no es un JPEG o no tiene marcador SOF0/1/2.
+ */
+bool jpegDimensions(const uint8_t* jpeg, size_t length, uint16_t& width, uint16_t& height);
+
+/**
+ * @class VegetationAnalyzer
+ * @brief Decodifica el JPEG de la cámara a 1/8 de escala y calcula sus índices de vegetación.
+ *
+ * La decodificación 1/8 de TJpgDec (esp_jpg_decode) usa solo el coeficiente DC de cada
+ * bloque de 8x8: no hay IDCT, así que cuesta una fracción de una decodificación completa.
+ * Los buffers (RGB y máscara, 80x60 para VGA) se asignan en PSRAM en el primer uso y se
+ * reutilizan mientras el tamaño no crezca. La máscara del último análisis queda disponible.
+ */
+class VegetationAnalyzer {
+public:
+    VegetationAnalyzer();
+    ~VegetationAnalyzer();
+
+    /**
+     * @brief Decodifica `jpeg` a 1/8 y rellena `stats` (stats.valid = false si falla).
+     * @return True si se pudo decodificar.
+     */
+    bool analyze(const uint8_t* jpeg, size_t length, VegetationStats& stats);
+
+    /**
+     * @brief Máscara de dosel del último análisis correcto (width x height, 1 = dosel), o nullptr.
+     */
+    const uint8_t* mask() const { return _maskValid ? _mask : nullptr; }
+    uint16_t width() const { return _width; }
+    uint16_t height() const { return _height; }
+
+private:
+    uint8_t* _rgb;
+    uint8_t* _mask;
+    size_t _capacity;    // Píxeles que caben en los buffers
+    uint16_t _width;
+    uint16_t _height;
+    bool _maskValid;
+    const uint8_t* _jpeg; // Entrada de la decodificación en curso (callbacks)
+    size_t _jpegLength;
+
+    bool _reserve(size_t pixels);
+    static size_t _read(void* arg, size_t index, uint8_t* buf, size_t len);
+    static bool _write(void* arg, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t* data);
+
+    VegetationAnalyzer(const VegetationAnalyzer&);
+    VegetationAnalyzer& operator=(const VegetationAnalyzer&);
+};
+
+#endif // VEGETATION_INDEX_H
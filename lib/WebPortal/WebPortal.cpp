@@ -1,9 +1,23 @@
 #include "WebPortal.h"
 #include "ConfigManager.h" // Para acceder a la 'config' global
 #include "SDManager.h"     // Para acceder a sdManager
+#include "SdIo.h"          // Turnos de lectura de la SD (descargas por porciones)
+#include "EventLog.h"      // Para decodificar los logs binarios
+#include "Trace.h"         // Para exportar la traza (Chrome trace_event JSON)
+#include "HeapMonitor.h"   // Para la telemetría de memoria
 #include <LittleFS.h>
 #include <ESPmDNS.h>
 #include <WiFi.h>
+#include <memory>          // std::shared_ptr para el estado de la respuesta chunked
+
+// --- Consultas de series (/api/ambient y /api/chart) ---
+#define AMBIENT_MAX_POINTS 500                 // Tope de puntos por respuesta (promedio por tramos)
+#define AMBIENT_DEFAULT_HOURS 24
+#define AMBIENT_MIN_VALID_EPOCH 1700000000UL   // Por debajo, el reloj no está sincronizado
+#define CHART_DEFAULT_POINTS 200
+#define CHART_MIN_POINTS 10
+#define CHART_MAX_RAW_POINTS 9000              // Lecturas leídas por consulta (31 días cada 5 min)
+#define CHART_CACHE_TTL_MS 600000UL            // Aunque no haya muestras nuevas, la ventana avanza
 
 /**
  * @brief Constructor. Inicializa la referencia al servidor y al SDManager.
@@ -109,6 +123,11 @@ void WebPortal::setupRoutes() {
     server.on("/api/config", HTTP_GET, std::bind(&WebPortal::handleGetConfig, this, std::placeholders::_1));
     server.on("/api/logs/list", HTTP_GET, std::bind(&WebPortal::handleListLogs, this, std::placeholders::_1));
     server.on("/api/logs/view", HTTP_GET, std::bind(&WebPortal::handleViewLog, this, std::placeholders::_1));
+    server.on("/api/trace", HTTP_GET, std::bind(&WebPortal::handleTrace, this, std::placeholders::_1));
+    server.on("/api/heap", HTTP_GET, std::bind(&WebPortal::handleHeap, this, std::placeholders::_1));
+    server.on("/api/storage", HTTP_GET, std::bind(&WebPortal::handleStorage, this, std::placeholders::_1));
+    server.on("/api/ambient", HTTP_GET, std::bind(&WebPortal::handleAmbient, this, std::placeholders::_1));
+    server.on("/api/chart", HTTP_GET, std::bind(&WebPortal::handleChart, this, std::placeholders::_1));
 
     // Handler para guardar la configuración (recibe JSON)
     AsyncCallbackJsonWebHandler* saveHandler = new AsyncCallbackJsonWebHandler(
@@ -190,7 +209,7 @@ void WebPortal::handleJs(AsyncWebServerRequest *request) {
  * @brief Maneja GET /api/config. Devuelve la configuración actual.
  */
 void WebPortal::handleGetConfig(AsyncWebServerRequest *request) {
-    StaticJsonDocument<512> doc; // Ajustar tamaño si la config crece
+    StaticJsonDocument<1536> doc; // Ajustar tamaño si la config crece
 
     // Lee desde la variable 'config' global
     doc["wifi_ssid"] = config.wifi_ssid;
@@ -205,6 +224,33 @@ void WebPortal::handleGetConfig(AsyncWebServerRequest *request) {
     doc["apiAmbientDataPath"] = config.apiAmbientDataPath;
     doc["apiCaptureDataPath"] = config.apiCaptureDataPath;
     doc["data_interval_minutes"] = config.data_interval_minutes;
+    doc["backlog_thin_after_hours"] = config.backlog_thin_after_hours;
+    doc["backlog_thin_interval_minutes"] = config.backlog_thin_interval_minutes;
+    doc["backlog_summary_after_hours"] = config.backlog_summary_after_hours;
+    doc["backlog_summary_bucket_minutes"] = config.backlog_summary_bucket_minutes;
+    doc["backlog_max_pending_mb"] = config.backlog_max_pending_mb;
+    doc["backlog_max_items_per_cycle"] = config.backlog_max_items_per_cycle;
+    doc["backlog_drain_budget_seconds"] = config.backlog_drain_budget_seconds;
+    doc["deadline_environment_seconds"] = config.deadline_environment_seconds;
+    doc["deadline_image_seconds"] = config.deadline_image_seconds;
+    doc["deadline_upload_seconds"] = config.deadline_upload_seconds;
+    doc["deadline_maintenance_seconds"] = config.deadline_maintenance_seconds;
+    doc["sensor_idle_state"] = config.sensor_idle_state;
+    doc["thermal_homography"] = config.thermal_homography;
+    doc["burst_z_threshold"] = config.burst_z_threshold;
+    doc["burst_interval_minutes"] = config.burst_interval_minutes;
+    doc["burst_duration_minutes"] = config.burst_duration_minutes;
+    doc["burst_cooldown_minutes"] = config.burst_cooldown_minutes;
+    doc["burst_max_captures_per_day"] = config.burst_max_captures_per_day;
+    doc["log_level_sd"] = config.log_level_sd;
+    doc["log_level_remote"] = config.log_level_remote;
+    doc["log_level_api"] = config.log_level_api;
+    doc["log_level_sdmanager"] = config.log_level_sdmanager;
+    doc["log_level_image"] = config.log_level_image;
+    doc["log_level_environment"] = config.log_level_environment;
+    doc["log_level_wifi"] = config.log_level_wifi;
+    doc["fault_injection"] = config.fault_injection;
+    doc["fault_injection_seed"] = config.fault_injection_seed;
     
     String output;
     serializeJson(doc, output);
@@ -215,12 +261,9 @@ void WebPortal::handleGetConfig(AsyncWebServerRequest *request) {
  * @brief Maneja POST /api/save. Guarda la config y reinicia.
  */
 void WebPortal::handleSaveConfig(AsyncWebServerRequest *request, JsonVariant &json) {
-    StaticJsonDocument<512> doc = json.as<JsonObject>();
-    String output;
-    serializeJson(doc, output); // Convierte el JSON recibido a String
-
-    // Llama al ConfigManager para guardar en LittleFS
-    bool success = saveConfiguration(output);
+    // Llama al ConfigManager para guardar en LittleFS. Las claves que el formulario no
+    // envía se conservan del config.json actual en lugar de borrarse.
+    bool success = mergeConfiguration(json.as<JsonObjectConst>());
 
     if (success) {
         request->send(200, "application/json", "{\"success\":true}");
@@ -263,27 +306,77 @@ void WebPortal::handleViewLog(AsyncWebServerRequest *request) {
         request->send(400, "text/plain", "Error: Nombre de archivo no válido (..)");
         return;
     }
-    if (!filename.endsWith(".txt")) { 
-        request->send(400, "text/plain", "Error: Archivo no es .txt");
+    bool isBinaryLog = filename.endsWith(".bin");
+    if (!filename.endsWith(".txt") && !isBinaryLog) { 
+        request->send(400, "text/plain", "Error: Archivo no es .txt ni .bin");
         return;
     }
 
     String path = String(LOG_DIR) + "/" + filename;
 
+    if (isBinaryLog) {
+        // Log binario (EventLog): se decodifica a texto trama a trama (respuesta chunked)
+        File binFile = sdManager.getLogFile(path);
+        if (!binFile) {
+            request->send(404, "text/plain", "Error 404: Archivo no encontrado en " + path);
+            return;
+        }
+        // El lector (y el File) se liberan cuando el servidor destruye la respuesta
+        std::shared_ptr<EventLogReader> reader(new EventLogReader(binFile, filename), [](EventLogReader* r) {
+            SdIoGuard ioGuard(SdIoClass::PORTAL_READ); // El destructor cierra el File
+            delete r;
+        });
+        std::shared_ptr<String> pending(new String());
+        SDManager* sd = &sdManager;
+        uint32_t generation = sdManager.getMountGeneration();
+
+        AsyncWebServerResponse *response = request->beginChunkedResponse("text/plain",
+            [reader, pending, sd, generation](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+                // Un turno por porción: las escrituras del loop() no esperan a toda la descarga
+                SdIoGuard ioGuard(SdIoClass::PORTAL_READ);
+                if (!sd->isSDAvailable() || sd->getMountGeneration() != generation) return 0; // Tarjeta desmontada
+                if (maxLen > SD_IO_PORTAL_SLICE_BYTES) maxLen = SD_IO_PORTAL_SLICE_BYTES;
+                size_t written = 0;
+                while (written < maxLen) {
+                    if (pending->isEmpty()) {
+                        String line;
+                        if (!reader->nextLine(line)) break; // Fin del archivo
+                        *pending = line + "\n";
+                    }
+                    size_t chunk = std::min(maxLen - written, (size_t)pending->length());
+                    memcpy(buffer + written, pending->c_str(), chunk);
+                    written += chunk;
+                    pending->remove(0, chunk);
+                }
+                return written; // 0 = respuesta terminada
+            });
+        request->send(response);
+        return;
+    }
+
     // Obtiene el archivo desde el SDManager
     File logFile = sdManager.getLogFile(path); 
     
     if (logFile) {
-        // Inicia una respuesta de streaming
-        AsyncWebServerResponse *response = request->beginResponse(logFile, path, "text/plain");
-
-        // Callback para cerrar el archivo cuando el cliente se desconecte
-        request->onDisconnect([logFile]() mutable {
-            logFile.close(); 
+        // El archivo se cierra cuando el servidor destruye la respuesta (fin o desconexión)
+        std::shared_ptr<File> file(new File(logFile), [](File* f) {
+            SdIoGuard ioGuard(SdIoClass::PORTAL_READ);
+            f->close();
+            delete f;
             #ifdef ENABLE_DEBUG_SERIAL
                 Serial.println("[WebPortal] Log file stream finished and file closed.");
             #endif
         });
+        SDManager* sd = &sdManager;
+        uint32_t generation = sdManager.getMountGeneration();
+
+        // Inicia una respuesta de streaming, leída por porciones de SD_IO_PORTAL_SLICE_BYTES
+        AsyncWebServerResponse *response = request->beginChunkedResponse("text/plain",
+            [file, sd, generation](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+                SdIoGuard ioGuard(SdIoClass::PORTAL_READ);
+                if (!sd->isSDAvailable() || sd->getMountGeneration() != generation) return 0; // Tarjeta desmontada
+                return file->read(buffer, std::min(maxLen, (size_t)SD_IO_PORTAL_SLICE_BYTES)); // 0 = fin
+            });
 
         request->send(response);
 
@@ -292,6 +385,423 @@ void WebPortal::handleViewLog(AsyncWebServerRequest *request) {
     }
 }
 
+/**
+ * @brief Maneja GET /api/trace. Descarga la traza como JSON de Chrome trace_event
+ * (abrir con chrome://tracing o ui.perfetto.dev).
+ */
+void WebPortal::handleTrace(AsyncWebServerRequest *request) {
+    if (!Trace::isReady()) {
+        request->send(404, "text/plain", "Error: Trazas no disponibles (compilar con -D ENABLE_TRACE)");
+        return;
+    }
+
+    // El exportador pausa el registro; se reanuda cuando el servidor destruye la respuesta
+    std::shared_ptr<TraceExporter> exporter(new TraceExporter());
+
+    AsyncWebServerResponse *response = request->beginChunkedResponse("application/json",
+        [exporter](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+            return exporter->read(buffer, maxLen); // 0 = respuesta terminada
+        });
+    response->addHeader("Content-Disposition", "attachment; filename=\"trace.json\"");
+    request->send(response);
+}
+
+/**
+ * @brief Maneja GET /api/heap. Devuelve la telemetría de memoria (actual + historial por ciclo).
+ */
+void WebPortal::handleHeap(AsyncWebServerRequest *request) {
+    JsonDocument doc;
+    HeapMonitor::toJson(doc.to<JsonObject>());
+
+    String output;
+    serializeJson(doc, output);
+    request->send(200, "application/json", output);
+}
+
+/**
+ * @brief (API) Métricas de almacenamiento: salud de la SD, buffer en PSRAM y nivel rápido.
+ */
+void WebPortal::handleStorage(AsyncWebServerRequest *request) {
+    JsonDocument doc;
+    SDHealthStats health = sdManager.getHealthStats();
+
+    JsonObject sd = doc["sd"].to<JsonObject>();
+    sd["available"] = sdManager.isSDAvailable();
+    sd["operations"] = health.operations;
+    sd["failures"] = health.failures;
+    sd["consecutive_failures"] = health.consecutiveFailures;
+    sd["unmounts"] = health.unmounts;
+    sd["remount_attempts"] = health.remountAttempts;
+    sd["remounts"] = health.remounts;
+    sd["last_remount_ms"] = health.lastRemountMs;
+    sd["next_remount_in_ms"] = health.nextRemountInMs;
+    sd["quarantined_records"] = health.quarantinedRecords;
+    sd["recovered_records"] = health.recoveredRecords;
+    sd["last_recovery_scan_ms"] = health.lastRecoveryScanMs;
+
+    JsonObject buffer = doc["psram_buffer"].to<JsonObject>();
+    buffer["writes"] = health.bufferedWrites;
+    buffer["bytes"] = health.bufferedBytes;
+    buffer["flushed"] = health.flushedWrites;
+    buffer["dropped"] = health.droppedWrites;
+
+    const FlashRing& hot = sdManager.getHotTier();
+    JsonObject hotTier = doc["hot_tier"].to<JsonObject>();
+    hotTier["available"] = hot.isAvailable();
+    hotTier["pending_records"] = hot.pendingRecords();
+    hotTier["pending_bytes"] = hot.pendingBytes();
+    hotTier["dropped_records"] = hot.droppedRecords();
+    hotTier["dropped_bytes"] = hot.droppedBytes();
+
+    const ClusterWriterStats& writes = sdManager.getWriterStats();
+    JsonObject writer = doc["writer"].to<JsonObject>();
+    writer["cluster_bytes"] = sdManager.getClusterSize();
+    writer["payload_bytes"] = writes.payloadBytes;
+    writer["device_bytes"] = writes.deviceBytes;
+    writer["write_calls"] = writes.writeCalls;
+    writer["preallocations"] = writes.preallocations;
+    writer["amplification"] = serialized(String(writes.amplification(), 3));
+
+    // Turnos de acceso a la tarjeta por clase (de mayor a menor prioridad)
+    JsonObject io = doc["io"].to<JsonObject>();
+    for (uint8_t c = 0; c < (uint8_t)SdIoClass::COUNT; c++) {
+        SdIoClassStats ioStats = SdIo::stats((SdIoClass)c);
+        JsonObject ioClass = io[SdIo::className((SdIoClass)c)].to<JsonObject>();
+        ioClass["requests"] = ioStats.requests;
+        ioClass["contended"] = ioStats.contended;
+        ioClass["waiting"] = ioStats.waiting;
+        ioClass["max_waiting"] = ioStats.maxWaiting;
+        ioClass["avg_wait_us"] = ioStats.requests > 0 ? (uint32_t)(ioStats.totalWaitUs / ioStats.requests) : 0;
+        ioClass["max_wait_us"] = ioStats.maxWaitUs;
+        ioClass["max_hold_us"] = ioStats.maxHoldUs;
+    }
+
+    String output;
+    serializeJson(doc, output);
+    request->send(200, "application/json", output);
+}
+
+// Series que se pueden consultar (/api/ambient solo acepta las ambientales)
+struct ChartSeriesInfo {
+    const char* name;
+    SeriesFile file;
+    uint8_t column;
+};
+static const ChartSeriesInfo CHART_SERIES[] = {
+    {"light", SeriesFile::AMBIENT, TS_LIGHT},
+    {"temperature", SeriesFile::AMBIENT, TS_TEMPERATURE},
+    {"humidity", SeriesFile::AMBIENT, TS_HUMIDITY},
+    {"pressure", SeriesFile::AMBIENT, TS_PRESSURE},
+    {"thermal_max", SeriesFile::THERMAL, TS_THERMAL_MAX},
+    {"thermal_min", SeriesFile::THERMAL, TS_THERMAL_MIN},
+    {"thermal_avg", SeriesFile::THERMAL, TS_THERMAL_AVG},
+    {"canopy_avg", SeriesFile::THERMAL, TS_CANOPY_AVG},
+};
+#define CHART_SERIES_COUNT (sizeof(CHART_SERIES) / sizeof(CHART_SERIES[0]))
+
+static int findChartSeries(const String& name) {
+    for (size_t i = 0; i < CHART_SERIES_COUNT; i++) {
+        if (name == CHART_SERIES[i].name) return (int)i;
+    }
+    return -1;
+}
+
+/**
+ * @brief (Helper) Rango de una consulta de series: `from`/`to` explícitos (épocas) o las
+ * últimas `hours` horas (por defecto AMBIENT_DEFAULT_HOURS). Si no es válido, responde el error.
+ * @param[out] hours Horas pedidas (0 si el rango es explícito).
+ */
+static bool parseSeriesRange(AsyncWebServerRequest *request, uint32_t& from, uint32_t& to, uint32_t& hours) {
+    hours = 0;
+    if (request->hasParam("from") && request->hasParam("to")) {
+        from = (uint32_t)strtoul(request->getParam("from")->value().c_str(), nullptr, 10);
+        to = (uint32_t)strtoul(request->getParam("to")->value().c_str(), nullptr, 10);
+    } else {
+        uint32_t now = (uint32_t)time(nullptr);
+        if (now < AMBIENT_MIN_VALID_EPOCH) {
+            request->send(503, "text/plain", "Error: Hora no sincronizada (use 'from' y 'to')");
+            return false;
+        }
+        long requested = request->hasParam("hours") ? request->getParam("hours")->value().toInt() : AMBIENT_DEFAULT_HOURS;
+        if (requested < 1) requested = 1;
+        if (requested > SERIES_QUERY_MAX_DAYS * 24) requested = SERIES_QUERY_MAX_DAYS * 24;
+        hours = (uint32_t)requested;
+        to = now;
+        from = now - hours * 3600UL;
+    }
+    if (from == 0 || from > to || to - from > (uint32_t)SERIES_QUERY_MAX_DAYS * 86400UL) {
+        request->send(400, "text/plain", "Error: Rango no válido");
+        return false;
+    }
+    return true;
+}
+
+// Muestras de una columna promediadas por tramos de `bucketSeconds` (tiempo y valor), como
+// mucho un punto por tramo. Con tramos más cortos que el intervalo de muestreo quedan las
+// lecturas originales. Los NaN (lecturas fallidas) se descartan.
+struct SeriesCollector {
+    uint8_t column;
+    uint32_t from;
+    uint32_t bucketSeconds;
+    TsPoint* points;
+    size_t count;
+    size_t capacity;
+    uint32_t bucket;    // Tramo en curso
+    uint64_t timeSum;
+    double valueSum;
+    uint32_t samples;
+};
+
+static void beginSeriesCollector(SeriesCollector& collector, uint8_t column, uint32_t from, uint32_t to,
+                                 TsPoint* points, size_t capacity) {
+    collector.column = column;
+    collector.from = from;
+    collector.bucketSeconds = (to - from) / capacity + 1; // Como mucho `capacity` tramos
+    collector.points = points;
+    collector.count = 0;
+    collector.capacity = capacity;
+    collector.bucket = 0;
+    collector.timeSum = 0;
+    collector.valueSum = 0.0;
+    collector.samples = 0;
+}
+
+static void flushSeriesBucket(SeriesCollector& collector) {
+    if (collector.samples == 0) return;
+    if (collector.count < collector.capacity) {
+        TsPoint& point = collector.points[collector.count++];
+        point.time = (uint32_t)(collector.timeSum / collector.samples);
+        point.value = (float)(collector.valueSum / collector.samples);
+    }
+    collector.timeSum = 0;
+    collector.valueSum = 0.0;
+    collector.samples = 0;
+}
+
+static bool collectSeriesSample(uint32_t time, const float values[TS_COLUMNS], void* context) {
+    SeriesCollector& collector = *(SeriesCollector*)context;
+    float value = values[collector.column];
+    if (isnan(value)) return true;
+    uint32_t bucket = (time - collector.from) / collector.bucketSeconds;
+    if (bucket != collector.bucket) flushSeriesBucket(collector);
+    collector.bucket = bucket;
+    collector.timeSum += time;
+    collector.valueSum += value;
+    collector.samples++;
+    return true;
+}
+
+// Buffer de puntos en PSRAM (en RAM interna si no hay)
+static TsPoint* allocPoints(size_t count) {
+    TsPoint* points = (TsPoint*)ps_malloc(count * sizeof(TsPoint));
+    if (!points) points = (TsPoint*)malloc(count * sizeof(TsPoint));
+    return points;
+}
+
+/**
+ * @brief (API) Serie ambiental de un rango: resumen y puntos para graficar.
+ * Parámetros: `field` (light, temperature, humidity o pressure) y `hours` (últimas N horas,
+ * por defecto 24) o `from`/`to` (épocas). Como mucho SERIES_QUERY_MAX_DAYS días.
+ */
+void WebPortal::handleAmbient(AsyncWebServerRequest *request) {
+    int series = findChartSeries(request->hasParam("field") ? request->getParam("field")->value() : String("temperature"));
+    if (series < 0 || CHART_SERIES[series].file != SeriesFile::AMBIENT) {
+        request->send(400, "text/plain", "Error: 'field' debe ser light, temperature, humidity o pressure");
+        return;
+    }
+    uint8_t column = CHART_SERIES[series].column;
+    uint32_t from, to, hours;
+    if (!parseSeriesRange(request, from, to, hours)) return;
+
+    JsonDocument doc;
+    doc["field"] = CHART_SERIES[series].name;
+    doc["from"] = from;
+    doc["to"] = to;
+
+    // 1. Resumen (los bloques completos usan el índice de su cabecera)
+    TsAggregate aggregate[TS_COLUMNS];
+    TsReadStats stats;
+    if (!sdManager.aggregateSeries(SeriesFile::AMBIENT, from, to, aggregate, &stats)) {
+        request->send(503, "text/plain", "Error: Tarjeta SD no disponible");
+        return;
+    }
+    doc["count"] = aggregate[column].count;
+    if (aggregate[column].count > 0) {
+        doc["min"] = aggregate[column].min;
+        doc["max"] = aggregate[column].max;
+        doc["avg"] = serialized(String(aggregate[column].avg(), 2));
+    }
+
+    // 2. Puntos (promedio por tramos si el rango tiene más lecturas que AMBIENT_MAX_POINTS)
+    JsonArray points = doc["points"].to<JsonArray>();
+    if (aggregate[column].count > 0) {
+        TsPoint* buffer = allocPoints(AMBIENT_MAX_POINTS);
+        if (!buffer) {
+            request->send(500, "text/plain", "Error: Sin memoria");
+            return;
+        }
+        SeriesCollector collector;
+        beginSeriesCollector(collector, column, from, to, buffer, AMBIENT_MAX_POINTS);
+        sdManager.scanSeries(SeriesFile::AMBIENT, from, to, collectSeriesSample, &collector, &stats);
+        flushSeriesBucket(collector);
+        for (size_t i = 0; i < collector.count; i++) {
+            JsonArray point = points.add<JsonArray>();
+            point.add(buffer[i].time);
+            point.add(serialized(String(buffer[i].value, 2)));
+        }
+        free(buffer);
+    }
+
+    JsonObject blocks = doc["blocks"].to<JsonObject>();
+    blocks["read"] = stats.blocksRead;
+    blocks["skipped"] = stats.blocksSkipped;
+    blocks["summarized"] = stats.blocksSummarized;
+    blocks["decoded"] = stats.blocksDecoded;
+    blocks["corrupt"] = stats.corruptBlocks;
+
+    String output;
+    serializeJson(doc, output);
+    request->send(200, "application/json", output);
+}
+
+/**
+ * @brief (Helper) Lee y reduce una serie a `points` puntos en `entry` (que ya tiene `data`).
+ * @return False si la SD no está disponible o no hay memoria.
+ */
+bool WebPortal::_buildChart(ChartCacheEntry& entry, uint32_t from, uint32_t to) {
+    // 1. Lecturas del rango (promediadas solo si superan CHART_MAX_RAW_POINTS)
+    TsPoint* raw = allocPoints(CHART_MAX_RAW_POINTS);
+    if (!raw) return false;
+    SeriesCollector collector;
+    beginSeriesCollector(collector, CHART_SERIES[entry.series].column, from, to, raw, CHART_MAX_RAW_POINTS);
+    if (!sdManager.scanSeries(CHART_SERIES[entry.series].file, from, to, collectSeriesSample, &collector)) {
+        free(raw);
+        return false;
+    }
+    flushSeriesBucket(collector);
+
+    // 2. Reducción a los puntos pedidos
+    if (entry.method == CHART_METHOD_MINMAX) {
+        entry.count = (uint16_t)downsampleMinMax(raw, collector.count, entry.points, entry.data);
+    } else {
+        entry.count = (uint16_t)downsampleLttb(raw, collector.count, entry.points, entry.data);
+    }
+    free(raw);
+    entry.from = from;
+    entry.to = to;
+    entry.raw = (uint32_t)collector.count;
+    entry.generation = sdManager.getSeriesGeneration();
+    entry.builtMs = millis();
+    return true;
+}
+
+/**
+ * @brief (API) Serie reducida para graficar en el navegador.
+ * Parámetros: `series` (ambientales o thermal_max, thermal_min, thermal_avg, canopy_avg),
+ * `hours` o `from`/`to` (como /api/ambient), `points` (CHART_MIN_POINTS-CHART_MAX_POINTS),
+ * `method` (lttb o minmax) y `format` (json o bin). Las consultas de 24 h y 7 días se
+ * guardan en caché hasta que llega una muestra nueva o pasan CHART_CACHE_TTL_MS.
+ *
+ * Formato bin (little-endian): "CHT1", u16 puntos, u8 método (0 = lttb, 1 = minmax),
+ * u8 flags (bit 0 = de la caché), u32 from, u32 to, u32 lecturas originales y
+ * después, por punto, u32 época y float valor.
+ */
+void WebPortal::handleChart(AsyncWebServerRequest *request) {
+    int series = findChartSeries(request->hasParam("series") ? request->getParam("series")->value() : String("temperature"));
+    if (series < 0) {
+        request->send(400, "text/plain", "Error: Serie desconocida");
+        return;
+    }
+    uint8_t method = CHART_METHOD_LTTB;
+    if (request->hasParam("method")) {
+        String name = request->getParam("method")->value();
+        if (name == "minmax") method = CHART_METHOD_MINMAX;
+        else if (name != "lttb") {
+            request->send(400, "text/plain", "Error: 'method' debe ser lttb o minmax");
+            return;
+        }
+    }
+    long points = request->hasParam("points") ? request->getParam("points")->value().toInt() : CHART_DEFAULT_POINTS;
+    if (points < CHART_MIN_POINTS) points = CHART_MIN_POINTS;
+    if (points > CHART_MAX_POINTS) points = CHART_MAX_POINTS;
+    bool binary = request->hasParam("format") && request->getParam("format")->value() == "bin";
+    uint32_t from, to, hours;
+    if (!parseSeriesRange(request, from, to, hours)) return;
+
+    // 1. Caché: mismos parámetros y ninguna muestra nueva desde que se calculó
+    uint32_t generation = sdManager.getSeriesGeneration();
+    bool cacheable = hours == 24 || hours == 24 * 7;
+    ChartCacheEntry* entry = nullptr;
+    bool cached = false;
+    if (cacheable) {
+        ChartCacheEntry* oldest = &_chartCache[0];
+        for (int i = 0; i < CHART_CACHE_ENTRIES; i++) {
+            ChartCacheEntry& candidate = _chartCache[i];
+            if (candidate.data && candidate.series == series && candidate.method == method && candidate.points == points &&
+                candidate.hours == hours && candidate.generation == generation && millis() - candidate.builtMs < CHART_CACHE_TTL_MS) {
+                entry = &candidate;
+                cached = true;
+                break;
+            }
+            if (!candidate.data || candidate.builtMs < oldest->builtMs) oldest = &candidate;
+        }
+        if (!entry) entry = oldest; // Se reutiliza la entrada más antigua (o una libre)
+    } else {
+        entry = &_chartScratch;
+    }
+
+    // 2. Cálculo (si no estaba en caché)
+    if (!cached) {
+        if (!entry->data) entry->data = allocPoints(CHART_MAX_POINTS);
+        entry->series = (uint8_t)series;
+        entry->method = method;
+        entry->points = (uint16_t)points;
+        entry->hours = (uint16_t)hours;
+        entry->count = 0;
+        if (!entry->data || !_buildChart(*entry, from, to)) {
+            entry->builtMs = 0;
+            entry->generation = UINT32_MAX; // Entrada inválida
+            request->send(503, "text/plain", "Error: Tarjeta SD no disponible o sin memoria");
+            return;
+        }
+    }
+
+    // 3. Respuesta
+    if (binary) {
+        AsyncResponseStream *response = request->beginResponseStream("application/octet-stream");
+        uint8_t header[20];
+        uint16_t count = entry->count;
+        memcpy(header, "CHT1", 4);
+        memcpy(header + 4, &count, 2);
+        header[6] = entry->method;
+        header[7] = cached ? 1 : 0;
+        memcpy(header + 8, &entry->from, 4);
+        memcpy(header + 12, &entry->to, 4);
+        memcpy(header + 16, &entry->raw, 4);
+        response->write(header, sizeof(header));
+        response->write((const uint8_t*)entry->data, count * sizeof(TsPoint));
+        request->send(response);
+        return;
+    }
+
+    // JSON compacto: tiempos como diferencias con el punto anterior
+    AsyncResponseStream *response = request->beginResponseStream("application/json");
+    response->printf("{\"series\":\"%s\",\"method\":\"%s\",\"from\":%lu,\"to\":%lu,\"raw\":%lu,\"cached\":%s,\"t0\":%lu,\"dt\":[",
+                     CHART_SERIES[series].name, method == CHART_METHOD_MINMAX ? "minmax" : "lttb",
+                     (unsigned long)entry->from, (unsigned long)entry->to, (unsigned long)entry->raw,
+                     cached ? "true" : "false", entry->count > 0 ? (unsigned long)entry->data[0].time : 0UL);
+    for (uint16_t i = 0; i < entry->count; i++) {
+        uint32_t dt = i == 0 ? 0 : entry->data[i].time - entry->data[i - 1].time;
+        response->printf(i == 0 ? "%lu" : ",%lu", (unsigned long)dt);
+    }
+    response->print("],\"v\":[");
+    for (uint16_t i = 0; i < entry->count; i++) {
+        response->printf(i == 0 ? "%.2f" : ",%.2f", entry->data[i].value);
+    }
+    response->print("]}");
+    request->send(response);
+}
+
 /**
  * @brief Manejador 404.
  */
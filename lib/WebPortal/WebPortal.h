@@ -5,6 +5,30 @@
 #include <AsyncJson.h>         // Manejo de JSON asíncrono
 #include <ArduinoJson.h>       // Librería de JSON
 #include <DNSServer.h>         // Para el portal cautivo
+#include "Downsample.h"        // Reducción de series para /api/chart
+
+#define CHART_MAX_POINTS 1000   ///< Tope de puntos por gráfica
+#define CHART_CACHE_ENTRIES 4   ///< Gráficas de 24 h / 7 días guardadas (cada una ocupa 8 KB de PSRAM)
+#define CHART_METHOD_LTTB 0
+#define CHART_METHOD_MINMAX 1
+
+/**
+ * @brief Gráfica ya reducida (caché de /api/chart).
+ * Vale mientras no cambie la generación de las series y no caduque.
+ */
+struct ChartCacheEntry {
+    uint8_t series = 0;         ///< Índice en la tabla de series de WebPortal.cpp
+    uint8_t method = CHART_METHOD_LTTB;
+    uint16_t points = 0;        ///< Puntos pedidos
+    uint16_t hours = 0;         ///< Ventana pedida (horas hasta ahora)
+    uint16_t count = 0;         ///< Puntos calculados en `data`
+    uint32_t generation = UINT32_MAX; ///< SDManager::getSeriesGeneration() al calcularla
+    uint32_t builtMs = 0;
+    uint32_t from = 0;
+    uint32_t to = 0;
+    uint32_t raw = 0;           ///< Lecturas originales del rango
+    TsPoint* data = nullptr;    ///< CHART_MAX_POINTS puntos (se reserva al primer uso)
+};
 
 // Declaración anticipada (Forward declaration)
 class SDManager;
@@ -71,5 +95,18 @@ private:
     void handleSaveConfig(AsyncWebServerRequest *request, JsonVariant &json);
     void handleListLogs(AsyncWebServerRequest *request);
     void handleViewLog(AsyncWebServerRequest *request);
+    void handleTrace(AsyncWebServerRequest *request);
+    void handleHeap(AsyncWebServerRequest *request);
+    void handleStorage(AsyncWebServerRequest *request);
+    void handleAmbient(AsyncWebServerRequest *request);
+    void handleChart(AsyncWebServerRequest *request);
+
+    ChartCacheEntry _chartCache[CHART_CACHE_ENTRIES]; ///< Rangos habituales (24 h y 7 días)
+    ChartCacheEntry _chartScratch;                    ///< Resto de rangos (sin caché)
+
+    /**
+     * @brief Lee la serie de `entry` entre `from` y `to` y la reduce a `entry.points` puntos.
+     */
+    bool _buildChart(ChartCacheEntry& entry, uint32_t from, uint32_t to);
     void handleNotFound(AsyncWebServerRequest *request);
 };
\ No newline at end of file
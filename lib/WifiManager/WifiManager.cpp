@@ -5,6 +5,8 @@
 #include "WiFiManager.h"
 // (El .h ya incluye WiFi.h, HTTPClient.h, y LEDStatus.h)
 #include <WiFiClientSecure.h> // Incluido por el usuario, se mantiene aunque no se use activamente.
+#include "Trace.h"            // Instrumentación de trazas (no-op sin ENABLE_TRACE)
+#include "FaultInjection.h"   // Inyección de fallos (no-op sin ENABLE_FAULT_INJECTION)
 
 // Timeout para el chequeo de conectividad a Internet
 #define INTERNET_CHECK_TIMEOUT 5000 
@@ -211,7 +213,9 @@ bool WiFiManager::checkInternetConnection(const String& testUrl) {
     if (http.begin(testUrl)) { 
         http.setTimeout(INTERNET_CHECK_TIMEOUT);
         
-        httpCode = http.GET();
+        TRACE_BEGIN(HTTP_CONNECTIVITY_CHECK);
+        httpCode = FAULT_INJECT(HTTP_REQUEST) ? HTTPC_ERROR_CONNECTION_LOST : http.GET();
+        TRACE_END(HTTP_CONNECTIVITY_CHECK);
         
         #ifdef ENABLE_DEBUG_SERIAL
             // Salida de terminal en inglés
@@ -93,7 +93,7 @@ bool handleApiAuthenticationAndActivation_Ctrl(SDManager& sdMgr, TimeManager& ti
                 Serial.println(F("[Ctrl_API] Activation successful (HTTP 200)."));
             #endif
             // Registra el éxito
-            ErrorLogger::sendLog(sdMgr, timeMgr, logUrl, api_obj.getAccessToken(), LOG_TYPE_INFO, "Device activated successfully. DeviceID: " + String(cfg.deviceId), internalTempForLog);
+            LOG_SEND(sdMgr, timeMgr, logUrl, api_obj.getAccessToken(), API, LOG_TYPE_INFO, "Device activated successfully. DeviceID: " + String(cfg.deviceId), internalTempForLog);
             // (La activación fue exitosa, api_obj.isActivated() ahora es true)
         } else {
             // Fallo en la activación
@@ -101,7 +101,7 @@ bool handleApiAuthenticationAndActivation_Ctrl(SDManager& sdMgr, TimeManager& ti
                 Serial.printf("[Ctrl_API] Activation failed. HTTP Code: %d\n", activationHttpCode);
             #endif
             status_led.setState(ERROR_AUTH);
-            ErrorLogger::sendLog(sdMgr, timeMgr, logUrl, "", LOG_TYPE_ERROR, "Device activation failed. HTTP Code: " + String(activationHttpCode) + ", DeviceID: " + String(cfg.deviceId), internalTempForLog);
+            LOG_SEND(sdMgr, timeMgr, logUrl, "", API, LOG_TYPE_ERROR, "Device activation failed. HTTP Code: " + String(activationHttpCode) + ", DeviceID: " + String(cfg.deviceId), internalTempForLog);
             return false; // No se puede continuar si la activación falla
         }
     }
@@ -134,7 +134,7 @@ bool handleApiAuthenticationAndActivation_Ctrl(SDManager& sdMgr, TimeManager& ti
         if (!api_obj.isActivated()) { 
             errorMessage += ". Device has been deactivated.";
         }
-        ErrorLogger::sendLog(sdMgr, timeMgr, logUrl, api_obj.getAccessToken(), LOG_TYPE_ERROR, errorMessage, internalTempForLog);
+        LOG_SEND(sdMgr, timeMgr, logUrl, api_obj.getAccessToken(), API, LOG_TYPE_ERROR, errorMessage, internalTempForLog);
         return false;
     }
 }
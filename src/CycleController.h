@@ -16,7 +16,6 @@
 #include "WiFiManager.h"   
 #include "API.h"           
 #include "LEDStatus.h"     
-#include "OV2640Sensor.h"   
 #include "SDManager.h" 
 #include "TimeManager.h"
 
@@ -1,10 +1,14 @@
 #include "EnvironmentTasks.h"
 #include "ErrorLogger.h"         // Para registrar errores
+#include "EventLog.h"            // Para el log binario de eventos repetitivos
 #include "EnvironmentDataJSON.h" // Para formatear y enviar el JSON
+#include "Trace.h"               // Instrumentación de trazas (no-op sin ENABLE_TRACE)
+#include "PhaseDeadline.h"       // Plazo del envío (anidado en la fase ambiental)
 
 // Define el número de reintentos para la lectura de sensores
 #define SENSOR_READ_RETRIES 3
 
+#if BOARD_HAS_LIGHT_SENSOR
 /**
  * @brief Lee el sensor de luz BH1750 con reintentos.
  */
@@ -32,6 +36,7 @@ bool readLightSensorWithRetry_Env(BH1750Sensor& lightSensor, float &lightLevel)
     #endif
     return false;
 }
+#endif // BOARD_HAS_LIGHT_SENSOR
 
 /**
  * @brief Lee el sensor BME280 (Temp, Hum, Pres) con reintentos.
@@ -95,7 +100,7 @@ bool sendEnvironmentDataToServer_Env(SDManager& sdMgr, TimeManager& timeMgr, Con
         #ifdef ENABLE_DEBUG_SERIAL
             Serial.println(F("[EnvTasks] Env data send failed (401). Attempting token refresh..."));
         #endif
-        ErrorLogger::sendLog(sdMgr, timeMgr, logUrl, token, LOG_TYPE_WARNING, 
+        LOG_SEND(sdMgr, timeMgr, logUrl, token, ENVIRONMENT, LOG_TYPE_WARNING, 
                              "Env data send returned 401. Attempting token refresh.", 
                              internalTempForLog); 
         
@@ -106,7 +111,7 @@ bool sendEnvironmentDataToServer_Env(SDManager& sdMgr, TimeManager& timeMgr, Con
             #ifdef ENABLE_DEBUG_SERIAL
                 Serial.println(F("[EnvTasks] Token refresh successful. Re-trying env data send..."));
             #endif
-            ErrorLogger::sendLog(sdMgr, timeMgr, logUrl, api_obj.getAccessToken(), LOG_TYPE_INFO, 
+            LOG_SEND(sdMgr, timeMgr, logUrl, api_obj.getAccessToken(), ENVIRONMENT, LOG_TYPE_INFO, 
                                  "Token refreshed successfully after env data 401.", 
                                  internalTempForLog); 
             
@@ -123,7 +128,7 @@ bool sendEnvironmentDataToServer_Env(SDManager& sdMgr, TimeManager& timeMgr, Con
                  #ifdef ENABLE_DEBUG_SERIAL
                     Serial.printf("[EnvTasks] Env data send failed on retry. HTTP Code: %d\n", httpCode);
                 #endif
-                ErrorLogger::sendLog(sdMgr, timeMgr, logUrl, token, LOG_TYPE_ERROR, 
+                LOG_SEND(sdMgr, timeMgr, logUrl, token, ENVIRONMENT, LOG_TYPE_ERROR, 
                                      String("Env data send failed on retry after refresh. HTTP: ") + String(httpCode), 
                                      internalTempForLog); 
             }
@@ -131,7 +136,7 @@ bool sendEnvironmentDataToServer_Env(SDManager& sdMgr, TimeManager& timeMgr, Con
             #ifdef ENABLE_DEBUG_SERIAL
                 Serial.printf("[EnvTasks] Token refresh failed after 401. HTTP Code: %d\n", refreshHttpCode);
             #endif
-             ErrorLogger::sendLog(sdMgr, timeMgr, logUrl, token, LOG_TYPE_ERROR, 
+             LOG_SEND(sdMgr, timeMgr, logUrl, token, ENVIRONMENT, LOG_TYPE_ERROR, 
                                   String("Token refresh failed after env data 401. Refresh HTTP: ") + String(refreshHttpCode), 
                                   internalTempForLog); 
         }
@@ -139,7 +144,7 @@ bool sendEnvironmentDataToServer_Env(SDManager& sdMgr, TimeManager& timeMgr, Con
         #ifdef ENABLE_DEBUG_SERIAL
             Serial.printf("[EnvTasks] Error sending environmental data. HTTP Code: %d\n", httpCode);
         #endif
-         ErrorLogger::sendLog(sdMgr, timeMgr, logUrl, token, LOG_TYPE_ERROR, 
+         LOG_SEND(sdMgr, timeMgr, logUrl, token, ENVIRONMENT, LOG_TYPE_ERROR, 
                               String("Failed to send environmental data. HTTP Code: ") + String(httpCode), 
                               internalTempForLog); 
     }
@@ -153,12 +158,13 @@ bool sendEnvironmentDataToServer_Env(SDManager& sdMgr, TimeManager& timeMgr, Con
 /**
  * @brief Orquesta la lectura, envío y archivo/guardado de datos ambientales.
  */
-bool performEnvironmentTasks_Env(SDManager& sdMgr, TimeManager& timeMgr, Config& cfg, API& api_obj, BH1750Sensor& lightSensor, BME280Sensor& bmeSensor, LEDStatus& sysLed, float internalTempForLog) { 
+bool performEnvironmentTasks_Env(SDManager& sdMgr, TimeManager& timeMgr, Config& cfg, API& api_obj, BH1750Sensor* lightSensor, BME280Sensor& bmeSensor, LEDStatus& sysLed, float internalTempForLog, float* airTemperature) { 
     #ifdef ENABLE_DEBUG_SERIAL
         Serial.println(F("[EnvTasks] --- Reading Environment Sensors & Sending Data ---"));
     #endif
 
     String timestamp = timeMgr.getCurrentTimestampString();
+    uint32_t epoch = (uint32_t)timeMgr.getCurrentEpochTime(); // 0 si la hora no está sincronizada
     float lightLevel = -1.0f;
     float temperature = NAN;
     float humidity = NAN;
@@ -167,15 +173,24 @@ bool performEnvironmentTasks_Env(SDManager& sdMgr, TimeManager& timeMgr, Config&
     sysLed.setState(TAKING_DATA);
 
     // --- 1. Leer Sensores ---
-    bool lightOK = readLightSensorWithRetry_Env(lightSensor, lightLevel);
+    TRACE_BEGIN(ENV_SENSORS_READ);
+    #if BOARD_HAS_LIGHT_SENSOR
+        bool lightOK = lightSensor && readLightSensorWithRetry_Env(*lightSensor, lightLevel);
+    #else
+        (void)lightSensor;
+        lightLevel = NAN; // Perfil sin sensor de luz: no se envía ni se guarda
+        bool lightOK = true;
+    #endif
     bool bmeOK = readBmeSensorWithRetry_Env(bmeSensor, temperature, humidity, pressure);
+    TRACE_END(ENV_SENSORS_READ);
+    if (airTemperature) *airTemperature = temperature;
 
     if (!lightOK || !bmeOK) {
         #ifdef ENABLE_DEBUG_SERIAL
             Serial.println(F("[EnvTasks] Error: Failed to read one or more environment sensors after retries."));
         #endif
         sysLed.setState(ERROR_SENSOR);
-        ErrorLogger::sendLog(sdMgr, timeMgr, api_obj.getBaseApiUrl() + cfg.apiLogPath, api_obj.getAccessToken(), LOG_TYPE_ERROR, 
+        LOG_SEND(sdMgr, timeMgr, api_obj.getBaseApiUrl() + cfg.apiLogPath, api_obj.getAccessToken(), ENVIRONMENT, LOG_TYPE_ERROR, 
                              String("Failed to read environment sensors."), 
                              internalTempForLog); 
         return false;
@@ -191,7 +206,9 @@ bool performEnvironmentTasks_Env(SDManager& sdMgr, TimeManager& timeMgr, Config&
     String envDataJsonString;
     JsonDocument doc;
     doc["timestamp"] = timestamp;
-    if (!isnan(lightLevel)) doc["light"] = lightLevel; else doc["light"] = nullptr;
+    #if BOARD_HAS_LIGHT_SENSOR
+        if (!isnan(lightLevel)) doc["light"] = lightLevel; else doc["light"] = nullptr;
+    #endif
     if (!isnan(temperature)) doc["temperature"] = serialized(String(temperature, 2)); else doc["temperature"] = nullptr;
     if (!isnan(humidity)) doc["humidity"] = serialized(String(humidity, 1)); else doc["humidity"] = nullptr;
     if (!isnan(pressure)) doc["pressure"] = serialized(String(pressure, 2)); else doc["pressure"] = nullptr; 
@@ -206,17 +223,31 @@ bool performEnvironmentTasks_Env(SDManager& sdMgr, TimeManager& timeMgr, Config&
             Serial.println(F("[EnvTasks] Failed to create JSON string from sensor data. Cannot send or archive."));
         #endif
         sysLed.setState(ERROR_DATA); 
-        ErrorLogger::sendLog(sdMgr, timeMgr, api_obj.getBaseApiUrl() + cfg.apiLogPath, api_obj.getAccessToken(), LOG_TYPE_ERROR, 
+        LOG_SEND(sdMgr, timeMgr, api_obj.getBaseApiUrl() + cfg.apiLogPath, api_obj.getAccessToken(), ENVIRONMENT, LOG_TYPE_ERROR, 
                              "Failed to create env JSON for sending/archiving.", 
                              internalTempForLog);
         return false; // Falla crítica si no se puede formar el JSON
     }
 
     // --- 3. Intentar Enviar Datos ---
-    sentSuccessfully = sendEnvironmentDataToServer_Env(sdMgr, timeMgr, cfg, api_obj, timestamp, lightLevel, temperature, humidity, pressure, sysLed, internalTempForLog);
+    // Con el plazo vencido el envío no empieza y los datos van a 'pending' (paso 5)
+    {
+        PhaseDeadlineScope uploadDeadline(DeadlinePhase::UPLOAD);
+        sentSuccessfully = sendEnvironmentDataToServer_Env(sdMgr, timeMgr, cfg, api_obj, timestamp, lightLevel, temperature, humidity, pressure, sysLed, internalTempForLog);
+    }
     
-    // --- 4. Guardar en SD (Archive o Pending) ---
-    if (sdMgr.isSDAvailable()) {
+    // --- 4. Serie ambiental diaria (columnar, para consultas por rango desde el portal) ---
+    bool storedInSeries = sdMgr.appendAmbientSample(epoch, lightLevel, temperature, humidity, pressure);
+
+    // --- 5. Guardar en SD (Archive o Pending) ---
+    // Registro pequeño: pasa por el nivel rápido en flash si existe (se migra a la SD por lotes),
+    // así que también se conserva sin tarjeta (modo degradado)
+    if (sentSuccessfully && storedInSeries) {
+        // Ya enviado y archivado en la serie: no hace falta un JSON por muestra en 'archive'
+        #ifdef ENABLE_DEBUG_SERIAL
+            Serial.println(F("[EnvTasks] Environmental data archived in the daily time series."));
+        #endif
+    } else if (sdMgr.isLocalStorageAvailable()) {
         String filename = timeMgr.getCurrentTimestampString(true) + "_env.json"; // Formato YYYYMMDD_HHMMSS_env.json
         String targetPath;
 
@@ -235,11 +266,11 @@ bool performEnvironmentTasks_Env(SDManager& sdMgr, TimeManager& timeMgr, Config&
         }
         
         // Escribir el archivo JSON en la ruta decidida
-        if (!sdMgr.writeTextFile(targetPath, envDataJsonString)) {
+        if (!sdMgr.storeSmallFile(targetPath, envDataJsonString)) {
             #ifdef ENABLE_DEBUG_SERIAL
                 Serial.println("[EnvTasks] Failed to write environmental data to SD card at: " + targetPath);
             #endif
-            ErrorLogger::logToSdOnly(sdMgr, timeMgr, LogLevel::ERROR, "Failed to write env data to " + targetPath, internalTempForLog);
+            EventLog::log<EventId::ENV_WRITE_FAILED>(sdMgr, timeMgr, internalTempForLog, targetPath);
         }
     } else {
         #ifdef ENABLE_DEBUG_SERIAL
@@ -247,7 +278,7 @@ bool performEnvironmentTasks_Env(SDManager& sdMgr, TimeManager& timeMgr, Config&
         #endif
         // Si no hay SD, el log de "falla de envío" (si ocurrió) ya se intentó
         // enviar a la API, pero el log local falla.
-        ErrorLogger::logToSdOnly(sdMgr, timeMgr, LogLevel::WARNING, "SD card not available, could not save env data.", internalTempForLog);
+        EventLog::log<EventId::ENV_SD_UNAVAILABLE>(sdMgr, timeMgr, internalTempForLog);
     }
 
 
@@ -8,7 +8,10 @@
 
 #include <Arduino.h>
 // Inclusión de tipos de datos usados en los parámetros
+#include "BoardProfile.h"   // BOARD_HAS_LIGHT_SENSOR
+#if BOARD_HAS_LIGHT_SENSOR
 #include "BH1750Sensor.h"
+#endif
 #include "API.h"
 #include "LEDStatus.h"
 #include "ConfigManager.h" 
@@ -16,6 +19,8 @@
 #include "TimeManager.h"
 #include "BME280Sensor.h"
 
+class BH1750Sensor; // Solo declarado en perfiles sin sensor de luz
+
 // --- Prototipos de Funciones de Tareas Ambientales ---
 
 /**
@@ -30,14 +35,18 @@
  * @param timeMgr Referencia al TimeManager.
  * @param cfg Referencia a la Configuración global.
  * @param api_obj Referencia al objeto API (para envío y tokens).
- * @param lightSensor Referencia al sensor BH1750.
+ * @param lightSensor Sensor BH1750, o nullptr si el perfil no lo incluye (la luz no se lee
+ * ni se envía).
  * @param bmeSensor Referencia al sensor BME280.
  * @param sysLed Referencia al LEDStatus.
  * @param internalTempForLog Temperatura interna para incluir en logs.
+ * @param[out] airTemperature (Opcional) Temperatura del aire leída (NaN si la lectura falló),
+ * para el detector de anomalías térmicas.
  * @return true si los datos se leyeron Y se enviaron exitosamente.
  */
-bool performEnvironmentTasks_Env(SDManager& sdMgr, TimeManager& timeMgr, Config& cfg, API& api_obj, BH1750Sensor& lightSensor, BME280Sensor& bmeSensor, LEDStatus& sysLed, float internalTempForLog);
+bool performEnvironmentTasks_Env(SDManager& sdMgr, TimeManager& timeMgr, Config& cfg, API& api_obj, BH1750Sensor* lightSensor, BME280Sensor& bmeSensor, LEDStatus& sysLed, float internalTempForLog, float* airTemperature = nullptr);
 
+#if BOARD_HAS_LIGHT_SENSOR
 /**
  * @brief Lee el sensor de luz (BH1750) con lógica de reintentos.
  * @param lightSensor Referencia al sensor BH1750.
@@ -45,6 +54,7 @@ bool performEnvironmentTasks_Env(SDManager& sdMgr, TimeManager& timeMgr, Config&
  * @return true si la lectura fue exitosa (>= 0.0 lux).
  */
 bool readLightSensorWithRetry_Env(BH1750Sensor& lightSensor, float &lightLevel);
+#endif
 
 /**
  * @brief Lee los sensores Temp/Hum/Presión (BME280) con lógica de reintentos.
@@ -4,7 +4,10 @@
  */
 #include "ImageTasks.h"
 #include "ErrorLogger.h"         // Para registro de errores
+#include "EventLog.h"            // Para el log binario de eventos repetitivos
 #include "MultipartDataSender.h" // Para enviar los datos multipart
+#include "Trace.h"               // Instrumentación de trazas (no-op sin ENABLE_TRACE)
+#include "PhaseDeadline.h"       // Cancelación cooperativa y plazo del envío
 
 ///< Lúmenes mínimos para capturar una imagen visual (RGB).
 #define RGB_CAPTURE_MIN_LIGHT_LEVEL_LUX 1000.0f
@@ -13,6 +16,13 @@
 #include "esp_heap_caps.h"
 #endif
 
+#if BOARD_HAS_CAMERA
+// Decodificador 1/8 de la imagen visual; sus buffers (PSRAM) se reutilizan entre ciclos
+static VegetationAnalyzer vegetationAnalyzer;
+// Proyección de la máscara de dosel sobre la rejilla térmica (tabla recalculada solo si cambia la calibración)
+static ThermalRegistration thermalRegistration;
+#endif
+
 
 /**
  * @brief Captura un frame térmico y lo *copia* en un nuevo buffer alocado (con `ps_malloc`).
@@ -30,7 +40,7 @@ bool captureAndCopyThermalData_Img(SDManager& sdMgr, TimeManager& timeMgr, MLX90
         #ifdef ENABLE_DEBUG_SERIAL
             Serial.println("[ImgTasks] Error: Failed to read thermal frame from MLX90640 sensor.");
         #endif
-        ErrorLogger::logToSdOnly(sdMgr, timeMgr, LogLevel::ERROR, "Failed to read thermal frame from MLX90640.", internalTempForLog);
+        EventLog::log<EventId::THERMAL_READ_FAILED>(sdMgr, timeMgr, internalTempForLog);
         return false;
     }
 
@@ -40,7 +50,7 @@ bool captureAndCopyThermalData_Img(SDManager& sdMgr, TimeManager& timeMgr, MLX90
         #ifdef ENABLE_DEBUG_SERIAL
             Serial.println("[ImgTasks] Error: Failed to get thermal data pointer from sensor (null).");
         #endif
-        ErrorLogger::logToSdOnly(sdMgr, timeMgr, LogLevel::ERROR, "Failed to get thermal data pointer from MLX90640 (null).", internalTempForLog);
+        EventLog::log<EventId::THERMAL_DATA_NULL>(sdMgr, timeMgr, internalTempForLog);
         return false;
     }
     #ifdef ENABLE_DEBUG_SERIAL
@@ -62,7 +72,7 @@ bool captureAndCopyThermalData_Img(SDManager& sdMgr, TimeManager& timeMgr, MLX90
             Serial.printf("[ImgTasks] CRITICAL ERROR: Failed to allocate %zu bytes for thermal data copy!\n", thermalDataSizeInBytes);
         #endif
         // Este es un error crítico, se loguea remotamente si es posible
-        ErrorLogger::sendLog(sdMgr, timeMgr, api_obj.getBaseApiUrl() + cfg.apiLogPath, api_obj.getAccessToken(), LOG_TYPE_ERROR, 
+        LOG_SEND(sdMgr, timeMgr, api_obj.getBaseApiUrl() + cfg.apiLogPath, api_obj.getAccessToken(), IMAGE, LOG_TYPE_ERROR, 
                              "Critical failure: Thermal data buffer allocation failed.", 
                              internalTempForLog); 
         return false;
@@ -76,6 +86,7 @@ bool captureAndCopyThermalData_Img(SDManager& sdMgr, TimeManager& timeMgr, MLX90
     return true;
 }
 
+#if BOARD_HAS_CAMERA
 /**
  * @brief Captura una imagen JPEG visual. La memoria es alocada por `visCamera.captureJPEG`.
  * Registra errores críticos si la captura o alocación fallan.
@@ -97,7 +108,7 @@ bool captureVisualJPEG_Img(SDManager& sdMgr, TimeManager& timeMgr, OV2640Sensor&
             Serial.println("[ImgTasks] Error: Failed to capture JPEG image or allocation failed.");
         #endif
         // Error crítico, loguear remotamente
-        ErrorLogger::sendLog(sdMgr, timeMgr, api_obj.getBaseApiUrl() + cfg.apiLogPath, api_obj.getAccessToken(), LOG_TYPE_ERROR, 
+        LOG_SEND(sdMgr, timeMgr, api_obj.getBaseApiUrl() + cfg.apiLogPath, api_obj.getAccessToken(), IMAGE, LOG_TYPE_ERROR, 
                              "Critical failure: JPEG image capture or buffer allocation failed.", 
                              internalTempForLog); 
         return false;
@@ -160,20 +171,21 @@ bool captureImages_Img(SDManager& sdMgr, TimeManager& timeMgr, OV2640Sensor& vis
     #endif
     return true;
 }
+#endif // BOARD_HAS_CAMERA
 
 /**
  * @brief Envía los datos de captura (multipart/form-data) al servidor.
  * Maneja el reintento por error 401 (token).
  * @note `thermalData` es mandatorio. `jpegImage` es opcional.
  */
-bool sendImageData_Img(SDManager& sdMgr, TimeManager& timeMgr, Config& cfg, API& api_obj, const String& timestamp, uint8_t* jpegImage, size_t jpegLength, float* thermalData, LEDStatus& sysLed, float internalTempForLog) {
+bool sendImageData_Img(SDManager& sdMgr, TimeManager& timeMgr, Config& cfg, API& api_obj, const String& timestamp, uint8_t* jpegImage, size_t jpegLength, float* thermalData, LEDStatus& sysLed, float internalTempForLog, const VegetationStats* vegetation) {
     // Los datos térmicos son obligatorios para este endpoint
     if (!thermalData) {
         #ifdef ENABLE_DEBUG_SERIAL
             Serial.println(F("[ImgTasks] Error: Invalid data provided to sendImageData_Img (thermalData is null)."));
         #endif
         sysLed.setState(ERROR_DATA);
-        ErrorLogger::sendLog(sdMgr, timeMgr, api_obj.getBaseApiUrl() + cfg.apiLogPath, api_obj.getAccessToken(), LOG_TYPE_ERROR, "sendImageData_Img called with null thermal data.", internalTempForLog);
+        LOG_SEND(sdMgr, timeMgr, api_obj.getBaseApiUrl() + cfg.apiLogPath, api_obj.getAccessToken(), IMAGE, LOG_TYPE_ERROR, "sendImageData_Img called with null thermal data.", internalTempForLog);
         return false;
     }
     
@@ -188,7 +200,7 @@ bool sendImageData_Img(SDManager& sdMgr, TimeManager& timeMgr, Config& cfg, API&
 
     // 1. Primer intento de envío
     // MultipartDataSender maneja internamente si jpegImage es nullptr
-    int httpCode = MultipartDataSender::IOThermalAndImageData(fullUrl, token, timestamp, thermalData, jpegImage, jpegLength);
+    int httpCode = MultipartDataSender::IOThermalAndImageData(fullUrl, token, timestamp, thermalData, jpegImage, jpegLength, vegetation);
 
     if (httpCode >= 200 && httpCode < 300) {
         #ifdef ENABLE_DEBUG_SERIAL
@@ -202,7 +214,7 @@ bool sendImageData_Img(SDManager& sdMgr, TimeManager& timeMgr, Config& cfg, API&
         #ifdef ENABLE_DEBUG_SERIAL
             Serial.println(F("[ImgTasks] Capture data send failed (401). Attempting token refresh..."));
         #endif
-        ErrorLogger::logToSdOnly(sdMgr, timeMgr, LogLevel::WARNING, "Capture data send failed (401 Unauthorized). Attempting token refresh.", internalTempForLog);
+        EventLog::log<EventId::CAPTURE_SEND_UNAUTHORIZED>(sdMgr, timeMgr, internalTempForLog);
         
         // Intenta refrescar el token
         int refreshHttpCode = api_obj.performTokenRefresh(); 
@@ -214,7 +226,7 @@ bool sendImageData_Img(SDManager& sdMgr, TimeManager& timeMgr, Config& cfg, API&
             
             // 3. Segundo intento de envío (con el nuevo token)
             token = api_obj.getAccessToken();
-            httpCode = MultipartDataSender::IOThermalAndImageData(fullUrl, token, timestamp, thermalData, jpegImage, jpegLength);
+            httpCode = MultipartDataSender::IOThermalAndImageData(fullUrl, token, timestamp, thermalData, jpegImage, jpegLength, vegetation);
             
             if (httpCode >= 200 && httpCode < 300) {
                 #ifdef ENABLE_DEBUG_SERIAL
@@ -229,7 +241,7 @@ bool sendImageData_Img(SDManager& sdMgr, TimeManager& timeMgr, Config& cfg, API&
     #ifdef ENABLE_DEBUG_SERIAL
         Serial.printf("[ImgTasks] Error sending capture data. Final HTTP Code: %d\n", httpCode);
     #endif
-    ErrorLogger::logToSdOnly(sdMgr, timeMgr, LogLevel::ERROR, "Error sending capture data. Final HTTP Code: " + String(httpCode), internalTempForLog);
+    EventLog::log<EventId::CAPTURE_SEND_FAILED>(sdMgr, timeMgr, internalTempForLog, httpCode);
     sysLed.setState(ERROR_SEND);
     return false;
 }
@@ -237,36 +249,54 @@ bool sendImageData_Img(SDManager& sdMgr, TimeManager& timeMgr, Config& cfg, API&
 /**
  * @brief Orquesta la captura, envío y archivo/guardado de los datos de imagen.
  */
-bool performImageTasks_Img(SDManager& sdMgr, TimeManager& timeMgr, Config& cfg, API& api_obj, OV2640Sensor& visCamera, MLX90640Sensor& thermalSensor, LEDStatus& sysLed, float lightLevel, uint8_t** jpegImage, size_t& jpegLength, float** thermalData, float internalTempForLog) { 
+bool performImageTasks_Img(SDManager& sdMgr, TimeManager& timeMgr, Config& cfg, API& api_obj, OV2640Sensor* visCamera, MLX90640Sensor& thermalSensor, LEDStatus& sysLed, float lightLevel, uint8_t** jpegImage, size_t& jpegLength, float** thermalData, float internalTempForLog, float* surfaceTemperature) { 
 
     #ifdef ENABLE_DEBUG_SERIAL
         Serial.println(F("\n[ImgTasks] --- Performing Image Data Tasks (Capture, Send, Archive) ---"));
     #endif
 
     String timestamp = timeMgr.getCurrentTimestampString();
+    uint32_t epoch = (uint32_t)timeMgr.getCurrentEpochTime(); // Para la serie de resúmenes térmicos
     *jpegImage = nullptr;
     jpegLength = 0;
     *thermalData = nullptr;
+    if (surfaceTemperature) *surfaceTemperature = NAN;
     
     sysLed.setState(TAKING_DATA);
 
     // --- 1. Decidir si capturar la imagen visual ---
-    // (Basado en el nivel de luz medido por la tarea ambiental)
-    bool captureVisual = (lightLevel >= RGB_CAPTURE_MIN_LIGHT_LEVEL_LUX);
-    if (!captureVisual) {
-        #ifdef ENABLE_DEBUG_SERIAL
-            Serial.printf("[ImgTasks] Low light condition (%.2f lux). Skipping visual image capture.\n", lightLevel);
-        #endif
-    }
+    // (Basado en el nivel de luz medido por la tarea ambiental; sin cámara en el perfil, nunca)
+    #if BOARD_HAS_CAMERA
+        bool captureVisual = (visCamera != nullptr && lightLevel >= RGB_CAPTURE_MIN_LIGHT_LEVEL_LUX);
+        if (!captureVisual) {
+            #ifdef ENABLE_DEBUG_SERIAL
+                Serial.printf("[ImgTasks] Low light condition (%.2f lux). Skipping visual image capture.\n", lightLevel);
+            #endif
+        }
+    #else
+        (void)visCamera;
+        (void)lightLevel;
+        bool captureVisual = false;
+    #endif
 
     // --- 2. Capturar Datos Térmicos (Mandatorio) ---
     if (!captureAndCopyThermalData_Img(sdMgr, timeMgr, thermalSensor, thermalData, cfg, api_obj, internalTempForLog)) {
         return false; // Falla crítica
     }
 
+    // Plazo de la fase vencido (lectura térmica lenta): solo se guarda la térmica en 'pending'
+    if (PhaseDeadline::expired()) {
+        #ifdef ENABLE_DEBUG_SERIAL
+            Serial.println(F("[ImgTasks] Phase deadline expired after thermal capture. Skipping visual capture and analysis."));
+        #endif
+        captureVisual = false;
+    }
+
+    VegetationStats vegetation; // Sin imagen visual (o sin cámara) queda inválido y no se envía
+    #if BOARD_HAS_CAMERA
     // --- 3. Capturar Datos Visuales (Opcional) ---
     if (captureVisual) {
-        if (!captureVisualJPEG_Img(sdMgr, timeMgr, visCamera, jpegImage, jpegLength, cfg, api_obj, internalTempForLog)) {
+        if (!captureVisualJPEG_Img(sdMgr, timeMgr, *visCamera, jpegImage, jpegLength, cfg, api_obj, internalTempForLog)) {
             // Falla la captura visual, pero la térmica tuvo éxito.
             // Limpiamos la térmica y retornamos false.
             if (*thermalData != nullptr) { free(*thermalData); *thermalData = nullptr; }
@@ -274,13 +304,57 @@ bool performImageTasks_Img(SDManager& sdMgr, TimeManager& timeMgr, Config& cfg,
         }
     }
 
+    // --- 3b. Índices de vegetación de la imagen (decodificación 1/8, sin IDCT) ---
+    if (*jpegImage && jpegLength > 0) {
+        TRACE_BEGIN(JPEG_VEGETATION);
+        vegetationAnalyzer.analyze(*jpegImage, jpegLength, vegetation); // Si falla, vegetation.valid = false y no se envía
+        TRACE_END(JPEG_VEGETATION);
+        #ifdef ENABLE_DEBUG_SERIAL
+            if (vegetation.valid) {
+                Serial.printf("[ImgTasks] Vegetation (%ux%u): ExG %.3f, ExGR %.3f, canopy %.1f%% (decode %lu us, compute %lu us)\n",
+                              vegetation.width, vegetation.height, vegetation.exg, vegetation.exgr, vegetation.canopyFraction * 100.0f,
+                              (unsigned long)vegetation.decodeUs, (unsigned long)vegetation.computeUs);
+            } else {
+                Serial.println(F("[ImgTasks] Warning: Could not decode JPEG for vegetation indices."));
+            }
+        #endif
+
+        // Temperaturas solo del dosel: la máscara 1/8 proyectada con la homografía calibrada
+        float homography[9];
+        if (cfg.thermal_homography.isEmpty() || !parseHomography(cfg.thermal_homography.c_str(), homography)) {
+            #ifdef ENABLE_DEBUG_SERIAL
+                if (!cfg.thermal_homography.isEmpty()) Serial.println(F("[ImgTasks] Warning: Invalid thermal_homography in config. Canopy stats disabled."));
+            #endif
+            thermalRegistration.clear();
+        } else {
+            thermalRegistration.setHomography(homography);
+        }
+        if (vegetation.valid && thermalRegistration.isCalibrated()) {
+            thermalRegistration.project(vegetationAnalyzer.mask(), vegetationAnalyzer.width(), vegetationAnalyzer.height(),
+                                        VEGETATION_DECODE_SCALE, *thermalData, vegetation.canopyThermal);
+            #ifdef ENABLE_DEBUG_SERIAL
+                const CanopyThermalStats& canopy = vegetation.canopyThermal;
+                Serial.printf("[ImgTasks] Canopy thermal: %u/%u px, avg %.2f C, min %.2f C, max %.2f C%s\n",
+                              canopy.canopyPixels, canopy.coveredPixels, canopy.avgTemp, canopy.minTemp, canopy.maxTemp,
+                              canopy.valid ? "" : " (not enough canopy)");
+            #endif
+        }
+    }
+    #endif // BOARD_HAS_CAMERA
+
     // --- 4. Intentar Enviar Datos ---
-    // (Se envían los datos térmicos, y los visuales *si existen*)
-    bool sentSuccessfully = sendImageData_Img(sdMgr, timeMgr, cfg, api_obj, timestamp, *jpegImage, jpegLength, *thermalData, sysLed, internalTempForLog);
+    // (Se envían los datos térmicos, y los visuales *si existen*; con el plazo vencido no se
+    // envía nada y el paso 5 los deja en 'pending')
+    bool sentSuccessfully = false;
+    {
+        PhaseDeadlineScope uploadDeadline(DeadlinePhase::UPLOAD);
+        sentSuccessfully = sendImageData_Img(sdMgr, timeMgr, cfg, api_obj, timestamp, *jpegImage, jpegLength, *thermalData, sysLed, internalTempForLog, &vegetation);
+    }
 
     // --- 5. Guardar en SD (Archive o Pending) ---
     // Esto se hace *independientemente* de si los buffers se liberan después.
-    if (sdMgr.isSDAvailable()) {
+    // Sin tarjeta, SDManager retiene los archivos en PSRAM hasta que se vuelva a montar.
+    if (sdMgr.isBulkStorageAvailable()) {
         String baseFilename = timeMgr.getCurrentTimestampString(true); // YYYYMMDD_HHMMSS
         // Decide el directorio de destino basado en el éxito del envío
         String targetDir = sentSuccessfully ? String(ARCHIVE_CAPTURES_DIR) : String(CAPTURE_PENDING_DIR);
@@ -290,7 +364,7 @@ bool performImageTasks_Img(SDManager& sdMgr, TimeManager& timeMgr, Config& cfg,
 
         // Guardar el JSON térmico (siempre)
         if (*thermalData) {
-            String thermalJsonString = MultipartDataSender::createThermalJson(timestamp, *thermalData);
+            String thermalJsonString = MultipartDataSender::createThermalJson(timestamp, *thermalData, &vegetation);
             if (!thermalJsonString.isEmpty()) {
                 if(sdMgr.writeTextFile(targetDir + "/" + baseFilename + "_thermal.json", thermalJsonString)) {
                    thermalWritten = true;
@@ -309,10 +383,27 @@ bool performImageTasks_Img(SDManager& sdMgr, TimeManager& timeMgr, Config& cfg,
             Serial.printf("[ImgTasks] Attempted save to SD: Thermal %s, Visual %s. Target: %s\n", (thermalWritten ? "OK" : "FAIL"), (visualWritten ? "OK" : (captureVisual ? "FAIL" : "SKIPPED")), targetDir.c_str());
         #endif
         // Loguear el resultado del guardado en SD
-        String sdLogMsg = "Capture data saved to SD. Target: " + targetDir + ". Thermal: " + (thermalWritten ? "OK" : "FAIL") + ". Visual: " + (visualWritten ? "OK" : (captureVisual ? "FAIL" : "SKIPPED"));
-        LogLevel sdLogLevel = (thermalWritten || visualWritten) ? LogLevel::INFO : LogLevel::WARNING;
-        ErrorLogger::logToSdOnly(sdMgr, timeMgr, sdLogLevel, sdLogMsg, internalTempForLog);
+        const char* thermalStatus = thermalWritten ? "OK" : "FAIL";
+        const char* visualStatus = visualWritten ? "OK" : (captureVisual ? "FAIL" : "SKIPPED");
+        if (thermalWritten || visualWritten) {
+            EventLog::log<EventId::CAPTURE_SAVED>(sdMgr, timeMgr, internalTempForLog, targetDir, thermalStatus, visualStatus);
+        } else {
+            EventLog::log<EventId::CAPTURE_SAVE_FAILED>(sdMgr, timeMgr, internalTempForLog, targetDir, thermalStatus, visualStatus);
+        }
     } 
+
+    // --- 6. Resumen de la captura en la serie térmica diaria (gráficas del portal) ---
+    if (*thermalData) {
+        float maxTemp = MultipartDataSender::calculateMaxTemperature(*thermalData);
+        float minTemp = MultipartDataSender::calculateMinTemperature(*thermalData);
+        float avgTemp = MultipartDataSender::calculateAverageTemperature(*thermalData);
+        float canopyAvg = vegetation.canopyThermal.valid ? vegetation.canopyThermal.avgTemp : NAN;
+        if (isfinite(maxTemp) && isfinite(minTemp) && isfinite(avgTemp)) {
+            sdMgr.appendThermalSummary(epoch, maxTemp, minTemp, avgTemp, canopyAvg);
+            // Con calibración, solo el dosel (sin imagen visual no hay dato); sin ella o sin cámara, el cuadro entero
+            if (surfaceTemperature) *surfaceTemperature = (!BOARD_HAS_CAMERA || cfg.thermal_homography.isEmpty()) ? avgTemp : canopyAvg;
+        }
+    }
     
     // El resultado final de la tarea depende de si se ENVIÓ exitosamente.
     if (!sentSuccessfully) {
@@ -8,13 +8,20 @@
 
 #include <Arduino.h>
 // Inclusión de tipos de datos usados en los parámetros
+#include "BoardProfile.h"   // BOARD_HAS_CAMERA
+#if BOARD_HAS_CAMERA
 #include "OV2640Sensor.h"
+#include "ThermalRegistration.h"
+#endif
 #include "MLX90640Sensor.h"
 #include "API.h"
 #include "LEDStatus.h"
 #include "ConfigManager.h" 
 #include "SDManager.h"   
 #include "TimeManager.h"
+#include "VegetationIndex.h"
+
+class OV2640Sensor; // Solo declarado en perfiles sin cámara
 
 // --- Prototipos de Funciones de Tareas de Imagen ---
 
@@ -30,7 +37,7 @@
  * @param timeMgr Referencia al TimeManager.
  * @param cfg Referencia a la Configuración global.
  * @param api_obj Referencia al objeto API (para envío y tokens).
- * @param visCamera Referencia al sensor OV2640.
+ * @param visCamera Sensor OV2640, o nullptr si el perfil no incluye cámara (solo térmica).
  * @param thermalSensor Referencia al sensor MLX90640.
  * @param sysLed Referencia al LEDStatus.
  * @param lightLevel Nivel de luz (lux) para decidir si se captura la imagen RGB.
@@ -38,10 +45,13 @@
  * @param[out] jpegLength Referencia (size_t) donde se almacenará el tamaño del JPEG.
  * @param[out] thermalData Puntero a un (float*) donde se almacenará el buffer de datos térmicos (alocado).
  * @param internalTempForLog Temperatura interna para incluir en logs.
+ * @param[out] surfaceTemperature (Opcional) Media del dosel si hay calibración (NaN sin imagen
+ * visual) o del cuadro térmico si no la hay, para el detector de anomalías térmicas.
  * @return true si los datos se capturaron Y se enviaron exitosamente.
  */
-bool performImageTasks_Img(SDManager& sdMgr, TimeManager& timeMgr, Config& cfg, API& api_obj, OV2640Sensor& visCamera, MLX90640Sensor& thermalSensor, LEDStatus& sysLed, float lightLevel, uint8_t** jpegImage, size_t& jpegLength, float** thermalData, float internalTempForLog);
+bool performImageTasks_Img(SDManager& sdMgr, TimeManager& timeMgr, Config& cfg, API& api_obj, OV2640Sensor* visCamera, MLX90640Sensor& thermalSensor, LEDStatus& sysLed, float lightLevel, uint8_t** jpegImage, size_t& jpegLength, float** thermalData, float internalTempForLog, float* surfaceTemperature = nullptr);
 
+#if BOARD_HAS_CAMERA
 /**
  * @brief Orquesta la captura de las imágenes térmica y visual.
  *
@@ -57,6 +67,7 @@ bool performImageTasks_Img(SDManager& sdMgr, TimeManager& timeMgr, Config& cfg,
 bool captureImages_Img(SDManager& sdMgr, TimeManager& timeMgr, OV2640Sensor& visCamera, MLX90640Sensor& thermalSensor, LEDStatus& sysLed,
                        uint8_t** jpegImage, size_t& jpegLength, float** thermalData,
                        Config& cfg, API& api_obj, float internalTempForLog);
+#endif
 
 /**
  * @brief Envía los datos de captura (JSON térmico y JPEG visual) al endpoint de la API.
@@ -71,9 +82,10 @@ bool captureImages_Img(SDManager& sdMgr, TimeManager& timeMgr, OV2640Sensor& vis
  * @param jpegImage Puntero al buffer JPEG (o nullptr si no se capturó).
  * @param jpegLength Tamaño del JPEG (0 si no se capturó).
  * @param thermalData Puntero al buffer de datos térmicos (mandatorio).
+ * @param vegetation Índices de vegetación de la imagen (o nullptr si no se capturó o no se pudo analizar).
  * @return true si los datos se enviaron exitosamente (HTTP 200-299).
  */
-bool sendImageData_Img(SDManager& sdMgr, TimeManager& timeMgr, Config& cfg, API& api_obj, const String& timestamp, uint8_t* jpegImage, size_t jpegLength, float* thermalData, LEDStatus& sysLed, float internalTempForLog);
+bool sendImageData_Img(SDManager& sdMgr, TimeManager& timeMgr, Config& cfg, API& api_obj, const String& timestamp, uint8_t* jpegImage, size_t jpegLength, float* thermalData, LEDStatus& sysLed, float internalTempForLog, const VegetationStats* vegetation = nullptr);
 
 
 /**
@@ -89,6 +101,7 @@ bool sendImageData_Img(SDManager& sdMgr, TimeManager& timeMgr, Config& cfg, API&
  */
 bool captureAndCopyThermalData_Img(SDManager& sdMgr, TimeManager& timeMgr, MLX90640Sensor& thermalSensor, float** thermalDataBuffer, Config& cfg, API& api_obj, float internalTempForLog);
 
+#if BOARD_HAS_CAMERA
 /**
  * @brief Captura una imagen JPEG visual.
  *
@@ -102,5 +115,6 @@ bool captureAndCopyThermalData_Img(SDManager& sdMgr, TimeManager& timeMgr, MLX90
  * @note El llamador es responsable de liberar la memoria de `*jpegImageBuffer`.
  */
 bool captureVisualJPEG_Img(SDManager& sdMgr, TimeManager& timeMgr, OV2640Sensor& visCamera, uint8_t** jpegImageBuffer, size_t& jpegLength, Config& cfg, API& api_obj, float internalTempForLog);
+#endif
 
 #endif // IMAGE_TASKS_H
\ No newline at end of file
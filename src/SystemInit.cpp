@@ -2,6 +2,13 @@
 #include <Wire.h>         // Para inicialización I2C
 #include <LittleFS.h>     // Para LittleFS.end() en el manejador de fallos
 #include "ErrorLogger.h" // Para registro de errores
+#include "EventLog.h"    // Para el log binario de eventos
+#if BOARD_HAS_CAMERA
+#include "OV2640Sensor.h"
+#endif
+#if BOARD_HAS_LIGHT_SENSOR
+#include "BH1750Sensor.h"
+#endif
 
 // --- Definiciones para rutinas robustas de inicio (Setup) ---
 
@@ -50,10 +57,10 @@ void initI2C_Sys(int sdaPin, int sclPin, uint32_t frequency) {
 
 
 /**
- * @brief Inicializa todos los sensores en secuencia.
+ * @brief Inicializa todos los sensores del perfil en secuencia.
  * @return String vacío si OK, o lista de sensores fallidos.
  */
-String initializeSensors_Sys(BME280Sensor& bme, BH1750Sensor& light, MLX90640Sensor& thermal, OV2640Sensor& visCamera) {
+String initializeSensors_Sys(BME280Sensor& bme, BH1750Sensor* light, MLX90640Sensor& thermal, OV2640Sensor* visCamera) {
     String failures = ""; // Acumulador de fallos
     bool allOk = true;
 
@@ -71,10 +78,11 @@ String initializeSensors_Sys(BME280Sensor& bme, BH1750Sensor& light, MLX90640Sen
     delay(100);
 
     // --- Inicializar BH1750 (Luz) ---
+    #if BOARD_HAS_LIGHT_SENSOR
     #ifdef ENABLE_DEBUG_SERIAL
         Serial.println("[SysInit] Initializing BH1750 (Light Sensor)...");
     #endif
-    if (!light.begin()) {
+    if (!light || !light->begin()) {
         #ifdef ENABLE_DEBUG_SERIAL
             Serial.println("[SysInit] !!! BH1750 Light Sensor Initialization FAILED !!!");
         #endif
@@ -82,6 +90,9 @@ String initializeSensors_Sys(BME280Sensor& bme, BH1750Sensor& light, MLX90640Sen
         allOk = false;
     }
     delay(100);
+    #else
+    (void)light; // El perfil no incluye sensor de luz
+    #endif
 
     // --- Inicializar MLX90640 (Térmica) ---
     #ifdef ENABLE_DEBUG_SERIAL
@@ -105,10 +116,11 @@ String initializeSensors_Sys(BME280Sensor& bme, BH1750Sensor& light, MLX90640Sen
     delay(2000); 
 
     // --- Inicializar OV2640 (Visual) ---
+    #if BOARD_HAS_CAMERA
     #ifdef ENABLE_DEBUG_SERIAL
         Serial.println("[SysInit] Initializing OV2640 (Visual Camera)...");
     #endif
-    if (!visCamera.begin()) {
+    if (!visCamera || !visCamera->begin()) {
         #ifdef ENABLE_DEBUG_SERIAL
             Serial.println("[SysInit] !!! OV2640 Camera Initialization FAILED !!!");
         #endif
@@ -116,6 +128,9 @@ String initializeSensors_Sys(BME280Sensor& bme, BH1750Sensor& light, MLX90640Sen
         allOk = false;
     }
     delay(500);
+    #else
+    (void)visCamera; // El perfil no incluye cámara
+    #endif
 
     if (allOk) {
         #ifdef ENABLE_DEBUG_SERIAL
@@ -142,7 +157,7 @@ void handleSensorInitFailure_Sys(SDManager& sdManager, TimeManager& timeManager,
 
     // Registra el error fatal en la SD (si es posible)
     String logMsg = "CRITICAL: Sensor init failed. Failed: [" + failedSensors + "]. System halted.";
-    ErrorLogger::logToSdOnly(sdManager, timeManager, LogLevel::ERROR, logMsg);
+    LOG_SD(sdManager, timeManager, CORE, ERROR, logMsg, NAN);
 
     // Desmonta el sistema de archivos de forma segura
     LittleFS.end();
@@ -166,7 +181,7 @@ void handleSensorInitFailure_Sys(SDManager& sdManager, TimeManager& timeManager,
  * @return true si se conecta, false si falla todos los reintentos.
  */
 bool initializeWiFi_Sys(WiFiManager& wifiMgr, LEDStatus& led, Config& cfg, API* api_comm, 
-                        SDManager& sdMgr, TimeManager& timeMgr, OV2640Sensor& visCamera) {
+                        SDManager& sdMgr, TimeManager& timeMgr) {
     #ifdef ENABLE_DEBUG_SERIAL
         Serial.println(F("[SysInit_WiFi] Initializing WiFiManager and setting credentials..."));
     #endif
@@ -185,7 +200,7 @@ bool initializeWiFi_Sys(WiFiManager& wifiMgr, LEDStatus& led, Config& cfg, API*
             #ifdef ENABLE_DEBUG_SERIAL
                 Serial.println(F("[SysInit_WiFi] WARNING: Could not obtain MAC address for API object."));
             #endif
-            ErrorLogger::logToSdOnly(sdMgr, timeMgr, LogLevel::WARNING, "Could not obtain MAC address for API object.");
+            LOG_SD(sdMgr, timeMgr, WIFI, WARNING, "Could not obtain MAC address for API object.", NAN);
         }
     }
 
@@ -236,7 +251,7 @@ bool initializeWiFi_Sys(WiFiManager& wifiMgr, LEDStatus& led, Config& cfg, API*
         Serial.println("[SysInit_WiFi] " + errorMsg);
     #endif
     led.setState(ERROR_WIFI);
-    ErrorLogger::logToSdOnly(sdMgr, timeMgr, LogLevel::ERROR, errorMsg);
+    LOG_SD(sdMgr, timeMgr, WIFI, ERROR, errorMsg, NAN);
 
     return false; // Fallo
 }
@@ -253,7 +268,7 @@ bool initializeNTP_Sys(TimeManager& timeMgr, SDManager& sdMgr, API* api_comm, Co
          #ifdef ENABLE_DEBUG_SERIAL
             Serial.println(F("[SysInit_NTP] FATAL: WiFi not connected. Cannot sync NTP. Halting."));
          #endif
-         ErrorLogger::logToSdOnly(sdMgr, timeMgr, LogLevel::ERROR, "FATAL: WiFi not connected. Cannot sync NTP. Halting.");
+         LOG_SD(sdMgr, timeMgr, CORE, ERROR, "FATAL: WiFi not connected. Cannot sync NTP. Halting.", NAN);
         delay(SYSTEM_HALT_DELAY_MS); // Espera 1 hora
         ESP.restart();
     }
@@ -275,7 +290,7 @@ bool initializeNTP_Sys(TimeManager& timeMgr, SDManager& sdMgr, API* api_comm, Co
                 Serial.println("[SysInit_NTP] NTP time synchronized: " + timeMgr.getCurrentTimestampString());
             #endif
             // Loguea el éxito solo a la SD (la API puede necesitar la hora)
-            ErrorLogger::logToSdOnly(sdMgr, timeMgr, LogLevel::INFO, "NTP time synchronized successfully at setup.");
+            EventLog::log<EventId::NTP_SYNC_OK_SETUP>(sdMgr, timeMgr, NAN);
             return true; // Éxito
         }
 
@@ -297,7 +312,7 @@ bool initializeNTP_Sys(TimeManager& timeMgr, SDManager& sdMgr, API* api_comm, Co
         Serial.println("[SysInit_NTP] " + errorMsg);
     #endif
     // El timestamp del log será basado en UPTIME, ya que NTP falló.
-    ErrorLogger::logToSdOnly(sdMgr, timeMgr, LogLevel::ERROR, errorMsg);
+    LOG_SD(sdMgr, timeMgr, CORE, ERROR, errorMsg, NAN);
 
     #ifdef ENABLE_DEBUG_SERIAL
         Serial.println(F("--- SYSTEM HALTED ---"));
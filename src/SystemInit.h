@@ -11,9 +11,8 @@
 
 #include <Arduino.h>
 // Inclusión de tipos de datos usados en los parámetros
+#include "BoardProfile.h"   // Sensores opcionales del perfil (BOARD_HAS_*)
 #include "BME280Sensor.h" 
-#include "OV2640Sensor.h"
-#include "BH1750Sensor.h"   
 #include "MLX90640Sensor.h" 
 #include "WiFiManager.h"    
 #include "LEDStatus.h"      
@@ -24,6 +23,10 @@
 #include "CycleController.h" 
 #include "SDManager.h"
 
+// Sensores opcionales: solo se declaran (el driver se compila únicamente si el perfil lo incluye)
+class OV2640Sensor;
+class BH1750Sensor;
+
 // --- Prototipos de Funciones de Inicialización del Sistema ---
 
 /**
@@ -41,16 +44,16 @@ void initSerial_Sys();
 void initI2C_Sys(int sdaPin, int sclPin, uint32_t frequency = 100000);
 
 /**
- * @brief Inicializa secuencialmente todos los sensores hardware.
+ * @brief Inicializa secuencialmente todos los sensores hardware del perfil de placa.
  *
  * @param bme Sensor BME280 (Temp, Hum, Pres).
- * @param light Sensor BH1750 (Luz) (usa I2C).
+ * @param light Sensor BH1750 (Luz) (usa I2C). nullptr si el perfil no lo incluye.
  * @param thermal Sensor MLX90640 (Térmica) (usa I2C).
- * @param visCamera Sensor OV2640 (Visual).
+ * @param visCamera Sensor OV2640 (Visual). nullptr si el perfil no incluye cámara.
  * @return String vacío ("") si todos los sensores inicializaron correctamente.
  * Retorna un String con los nombres de los sensores que fallaron (ej. "BME280,MLX90640").
  */
-String initializeSensors_Sys(BME280Sensor& bme, BH1750Sensor& light, MLX90640Sensor& thermal, OV2640Sensor& visCamera);
+String initializeSensors_Sys(BME280Sensor& bme, BH1750Sensor* light, MLX90640Sensor& thermal, OV2640Sensor* visCamera);
 
 /**
  * @brief Maneja el fallo crítico durante la inicialización de sensores.
@@ -77,11 +80,10 @@ void handleSensorInitFailure_Sys(SDManager& sdManager, TimeManager& timeManager,
  * @param api_comm Puntero al objeto API (para establecer la MAC).
  * @param sdMgr Referencia al SDManager (para logs).
  * @param timeMgr Referencia al TimeManager (para logs).
- * @param visCamera (Parámetro obsoleto, mantenido por compatibilidad).
  * @return true si el WiFi se conectó exitosamente, false si fallaron todos los reintentos.
  */
 bool initializeWiFi_Sys(WiFiManager& wifiMgr, LEDStatus& led, Config& cfg, API* api_comm, 
-                        SDManager& sdMgr, TimeManager& timeMgr, OV2640Sensor& visCamera);
+                        SDManager& sdMgr, TimeManager& timeMgr);
 
 /**
  * @brief Sincroniza la hora NTP de forma robusta (bloqueante, con reintentos).
@@ -19,18 +19,32 @@
 #include "esp_sntp.h"
 
 // --- Local Libraries (Project Specific Classes from lib/) ---
+#include "BoardProfile.h"   // Pins and optional sensors of this build (-D BOARD_PROFILE_*)
+#if BOARD_HAS_CAMERA
 #include "OV2640Sensor.h"
+#endif
 #include "BME280Sensor.h"
+#if BOARD_HAS_LIGHT_SENSOR
 #include "BH1750Sensor.h"
+#endif
 #include "MLX90640Sensor.h"
 #include "LEDStatus.h"
 #include "WiFiManager.h"
 #include "API.h"
 #include "ErrorLogger.h"
+#include "EventLog.h"
 #include "SDManager.h"
 #include "TimeManager.h"
 #include "DS18B20Sensor.h" 
 #include "WebPortal.h"
+#include "Trace.h"
+#include "FaultInjection.h"
+#include "SensorTrace.h"
+#include "HeapMonitor.h"
+#include "AnomalyDetector.h"
+#include "ResumeCheckpoint.h"
+#include "PhaseDeadline.h"
+#include "SensorPower.h"
 
 // --- Modularized Helper Files (from src/) ---
 #include "ConfigManager.h"
@@ -39,11 +53,6 @@
 #include "EnvironmentTasks.h"
 #include "ImageTasks.h"
 
-// --- Hardware Pin Definitions ---
-#define I2C_SDA_PIN 47
-#define I2C_SCL_PIN 21
-#define TEMP_INTERNAL_PIN 14
-
 // --- Fan Control Thresholds ---
 #define FAN_ON_TEMP_C           20.0f
 #define FAN_OFF_TEMP_C          15.0f
@@ -66,23 +75,89 @@ WiFiManager wifiManager;
 API* api_comm = nullptr;
 WebPortal webPortal(sdManager);
 
-BH1750Sensor lightSensor(Wire);
 MLX90640Sensor thermalSensor(Wire);
-OV2640Sensor camera;
 BME280Sensor bmeExternalSensor(Wire);
-DS18B20Sensor dsInternalSensor(TEMP_INTERNAL_PIN);
+DS18B20Sensor dsInternalSensor(Board::TEMP_INTERNAL_PIN);
+// Optional sensors only exist in profiles that have them; the tasks receive nullptr otherwise
+#if BOARD_HAS_LIGHT_SENSOR
+BH1750Sensor lightSensor(Wire, Board::I2C_SDA_PIN, Board::I2C_SCL_PIN);
+static BH1750Sensor* const profileLightSensor = &lightSensor;
+#else
+static BH1750Sensor* const profileLightSensor = nullptr;
+#endif
+#if BOARD_HAS_CAMERA
+OV2640Sensor camera;
+static OV2640Sensor* const profileCamera = &camera;
+#else
+static OV2640Sensor* const profileCamera = nullptr;
+#endif
+AnomalyDetector anomalyDetector; // Thermal stress -> burst captures (state kept in NVS)
+SensorPowerScheduler sensorPower; // Sensors sleep between cycles and wake just before the next one
+static int8_t lightPowerIndex = -1;   // -1 = sensor not in this profile (sleep() ignores it)
+static int8_t bmePowerIndex = -1;
 
 // --- State Variables ---
 static time_t nextDataCollectionEpochTime = 0;
 static bool sdUsageWarning90PercentSent = false;
 static bool isInConfigMode = false;
 
+// Keeps the schedule in RTC memory so a watchdog/brownout reset resumes instead of starting over
+static void saveScheduleCheckpoint(CyclePhase phase) {
+    CheckpointData& checkpoint = ResumeCheckpoint::data();
+    checkpoint.nextCollectionEpoch = nextDataCollectionEpochTime;
+    checkpoint.flags = sdUsageWarning90PercentSent ? CHECKPOINT_FLAG_SD_WARNING_SENT : 0;
+    if (phase == CyclePhase::IDLE) checkpoint.cyclesCompleted++;
+    ResumeCheckpoint::save(phase);
+}
+
+// Next collection time: the burst capture if one is due, otherwise the next slot aligned to the interval
+static time_t scheduleNextCollection(time_t cycleStartTime, unsigned long intervalMinutes, uint32_t burstDelaySeconds) {
+    if (burstDelaySeconds > 0) {
+        return cycleStartTime + burstDelaySeconds; // Runs right away if the cycle took longer
+    }
+
+    time_t lastRunTime = timeManager.getCurrentEpochTime();
+    struct tm timeinfo;
+    localtime_r(&lastRunTime, &timeinfo);
+
+    int minutes_past_slot = timeinfo.tm_min % intervalMinutes;
+    int minutes_to_add = (minutes_past_slot == 0) ? intervalMinutes : (intervalMinutes - minutes_past_slot);
+
+    time_t next_run_base_time = lastRunTime + (minutes_to_add * 60);
+
+    localtime_r(&next_run_base_time, &timeinfo);
+    timeinfo.tm_sec = 0;
+    time_t nextRunTime = mktime(&timeinfo);
+
+    if (nextRunTime <= lastRunTime) {
+        nextRunTime += (intervalMinutes * 60);
+    }
+    return nextRunTime;
+}
+
 // =========================================================================
 // ===                           SETUP FUNCTION                          ===
 // =========================================================================
 void setup() {
     initSerial_Sys(); 
 
+    // Non-power-on reset with a valid checkpoint: pick the schedule up where it stopped
+    if (ResumeCheckpoint::begin()) {
+        const CheckpointData& checkpoint = ResumeCheckpoint::data();
+        nextDataCollectionEpochTime = checkpoint.nextCollectionEpoch;
+        lastNtpSyncEpochTime = checkpoint.lastNtpSyncEpoch;
+        sdUsageWarning90PercentSent = (checkpoint.flags & CHECKPOINT_FLAG_SD_WARNING_SENT) != 0;
+        #ifdef ENABLE_DEBUG_SERIAL
+            Serial.printf("[MainSetup] Resuming after %s reset (interrupted in phase: %s, resume #%u).\n",
+                          ResumeCheckpoint::resetReasonName(ResumeCheckpoint::resetReason()),
+                          ResumeCheckpoint::phaseName(ResumeCheckpoint::interruptedPhase()), (unsigned)checkpoint.consecutiveResumes);
+        #endif
+    }
+
+    #ifdef ENABLE_TRACE
+        Trace::begin(); // Trace ring buffers (downloadable from the portal at /api/trace)
+    #endif
+
     #ifdef ENABLE_DEBUG_SERIAL
         Serial.println(F("[MainSetup] Initializing LED..."));
     #endif
@@ -110,29 +185,109 @@ void setup() {
         #ifdef ENABLE_DEBUG_SERIAL
             Serial.println(F("[MainSetup] CRITICAL: LittleFS init failed. Halting."));
         #endif
-        ErrorLogger::logToSdOnly(sdManager, timeManager, LogLevel::ERROR, "CRITICAL: LittleFS init failed. Halting.");
+        LOG_SD(sdManager, timeManager, CORE, ERROR, "CRITICAL: LittleFS init failed. Halting.", NAN);
         while(1) { delay(1000); }
     }
     loadConfigurationFromFile(); 
+    ErrorLogger::configureFilters(config); // Log-level filters come from config.json
+
+    // Burst parameters come from config.json; the learned baseline survives reboots in NVS
+    AnomalyConfig anomalyConfig;
+    anomalyConfig.zThreshold = config.burst_z_threshold;
+    anomalyConfig.burstIntervalSeconds = (uint32_t)max(1, config.burst_interval_minutes) * 60;
+    anomalyConfig.burstDurationSeconds = (uint32_t)max(0, config.burst_duration_minutes) * 60;
+    anomalyConfig.cooldownSeconds = (uint32_t)max(0, config.burst_cooldown_minutes) * 60;
+    anomalyConfig.maxBurstCapturesPerDay = (uint16_t)constrain(config.burst_max_captures_per_day, 0, 1000);
+    anomalyDetector.configure(anomalyConfig);
+    if (!anomalyDetector.loadState()) {
+        #ifdef ENABLE_DEBUG_SERIAL
+            Serial.println(F("[MainSetup] No anomaly detector state in NVS. Learning a new baseline."));
+        #endif
+    }
+
+    // Per-phase deadlines (0 = unlimited). The drain keeps its own soft budget between items;
+    // its hard deadline leaves room for the send that was in flight when that budget ran out.
+    PhaseDeadline::setBudget(DeadlinePhase::ENVIRONMENT, (uint32_t)max(0, config.deadline_environment_seconds) * 1000UL);
+    PhaseDeadline::setBudget(DeadlinePhase::IMAGE, (uint32_t)max(0, config.deadline_image_seconds) * 1000UL);
+    PhaseDeadline::setBudget(DeadlinePhase::UPLOAD, (uint32_t)max(0, config.deadline_upload_seconds) * 1000UL);
+    PhaseDeadline::setBudget(DeadlinePhase::MAINTENANCE, (uint32_t)max(0, config.deadline_maintenance_seconds) * 1000UL);
+    PhaseDeadline::setBudget(DeadlinePhase::DRAIN, config.backlog_drain_budget_seconds > 0
+        ? (uint32_t)(config.backlog_drain_budget_seconds + max(0, config.deadline_upload_seconds)) * 1000UL : 0);
+
+    // Sensor power between cycles, registered in the order the cycle uses them (light, BME280, MLX90640, camera).
+    // Wake latencies are first guesses; the scheduler replaces them with the measured ones.
+    SensorPowerState sensorIdleState = SensorPowerState::STANDBY;
+    if (!parseSensorPowerState(config.sensor_idle_state.c_str(), sensorIdleState)) {
+        #ifdef ENABLE_DEBUG_SERIAL
+            Serial.println("[MainSetup] Invalid sensor_idle_state ignored: " + config.sensor_idle_state);
+        #endif
+    }
+    sensorPower.setIdleState(sensorIdleState);
+    bool sensorsPowerOff = sensorIdleState == SensorPowerState::OFF;
+    #if BOARD_HAS_LIGHT_SENSOR
+        lightPowerIndex = sensorPower.add("BH1750", lightSensor, 200);
+    #endif
+    bmePowerIndex = sensorPower.add("BME280", bmeExternalSensor, 150);
+    sensorPower.add("MLX90640", thermalSensor, sensorsPowerOff && Board::THERMAL_POWER_PIN >= 0 ? 4500 : 10);
+    #if BOARD_HAS_CAMERA
+        sensorPower.add("OV2640", camera, sensorsPowerOff ? 1500 : 500);
+    #endif
+
+    #ifdef ENABLE_FAULT_INJECTION
+        // Fault schedules for resilience testing come from config.json ("" = no faults)
+        FaultInjection::seed((uint32_t)config.fault_injection_seed);
+        if (FaultInjection::configureFromString(config.fault_injection.c_str()) < 0) {
+            #ifdef ENABLE_DEBUG_SERIAL
+                Serial.println("[MainSetup] Invalid fault_injection spec ignored: " + config.fault_injection);
+            #endif
+        }
+    #endif
 
     #ifdef ENABLE_DEBUG_SERIAL
         Serial.println(F("[MainSetup] Initializing SD Card..."));
     #endif
     if (!sdManager.begin()) {
         led.setState(ERROR_DATA); 
+        // Degraded mode: ambient data, logs and API state go to the internal flash ring and
+        // captures are held in PSRAM; checkCardHealth() in loop() keeps retrying the mount
         #ifdef ENABLE_DEBUG_SERIAL
-            Serial.println(F("[MainSetup] CRITICAL: SD Card init failed. Halting."));
+            Serial.println(F("[MainSetup] WARNING: SD Card init failed. Continuing in degraded mode until the card is mounted."));
         #endif
-        ErrorLogger::logToSdOnly(sdManager, timeManager, LogLevel::ERROR, "CRITICAL: SD Card init failed. Halting.");
-        while(1) { delay(1000); } 
+        EventLog::log<EventId::SD_DEGRADED_MODE>(sdManager, timeManager, NAN, sdManager.isHotTierAvailable());
     }
+
+    #ifdef ENABLE_SENSOR_TRACE
+        // Sensor trace record/replay (config.json). Must start before the sensors are initialized,
+        // so that in replay mode their begin() succeeds without hardware.
+        if (config.sensor_trace_mode == "record" || config.sensor_trace_mode == "replay") {
+            String tracePath = "/sdcard" + config.sensor_trace_file; // SD_MMC VFS mount point
+            time_t nowEpoch = time(nullptr);
+            bool traceStarted = false;
+            if (config.sensor_trace_mode == "replay") {
+                traceStarted = SensorTrace::beginReplay(tracePath.c_str(), config.sensor_trace_speed, config.sensor_trace_loop);
+            } else {
+                // Each boot records to its own numbered file, so a reset never truncates the previous session
+                char sessionPath[128];
+                if (SensorTrace::nextSessionPath(tracePath.c_str(), sessionPath, sizeof(sessionPath))) {
+                    tracePath = sessionPath;
+                    traceStarted = SensorTrace::beginRecording(sessionPath, nowEpoch > 1600000000 ? (uint32_t)nowEpoch : 0);
+                }
+            }
+            String traceFile = tracePath.substring(strlen("/sdcard"));
+            if (traceStarted) {
+                LOG_SD(sdManager, timeManager, CORE, INFO, "Sensor trace " + config.sensor_trace_mode + " started: " + traceFile, NAN);
+            } else {
+                LOG_SD(sdManager, timeManager, CORE, WARNING, "Sensor trace " + config.sensor_trace_mode + " failed to open: " + traceFile, NAN);
+            }
+        }
+    #endif
     
     #ifdef ENABLE_DEBUG_SERIAL
         Serial.println(F("[MainSetup] Initializing API communication object..."));
     #endif
     api_comm = new API(sdManager, config.apiBaseUrl, config.apiActivatePath, config.apiAuthPath, config.apiRefreshTokenPath);
     if (api_comm == nullptr) {
-        ErrorLogger::logToSdOnly(sdManager, timeManager, LogLevel::ERROR, "API object allocation failed in setup.");
+        LOG_SD(sdManager, timeManager, CORE, ERROR, "API object allocation failed in setup.", NAN);
         led.setState(ERROR_AUTH); 
         #ifdef ENABLE_DEBUG_SERIAL
             Serial.println(F("[MainSetup] CRITICAL: API object allocation failed. Halting."));
@@ -156,7 +311,7 @@ void setup() {
         #ifdef ENABLE_DEBUG_SERIAL
             Serial.println(F("[WifiConfig] WiFi settings found. Attempting to connect..."));
         #endif
-        wifiSuccess = initializeWiFi_Sys(wifiManager, led, config, api_comm, sdManager, timeManager, camera);
+        wifiSuccess = initializeWiFi_Sys(wifiManager, led, config, api_comm, sdManager, timeManager);
     }
 
     if (wifiSuccess) {
@@ -170,19 +325,31 @@ void setup() {
 
     webPortal.beginSTAMode(); 
 
+    // The RTC keeps counting through a watchdog/brownout reset: if the last sync is recent, SNTP
+    // corrects it in the background instead of blocking the boot on a fresh sync
+    bool ntpSkipped = ResumeCheckpoint::rtcTimeTrusted(time(nullptr));
+    if (ntpSkipped) {
+        timeManager.begin(DEFAULT_NTP_SERVER_1, DEFAULT_NTP_SERVER_2, COLOMBIA_GMT_OFFSET_SEC, COLOMBIA_DAYLIGHT_OFFSET_SEC);
+        ntpSkipped = timeManager.adoptRtcTime(time(nullptr));
+    }
+
     #ifdef ENABLE_DEBUG_SERIAL
-        Serial.println(F("[MainSetup] Executing robust NTP startup..."));
+        if (!ntpSkipped) Serial.println(F("[MainSetup] Executing robust NTP startup..."));
     #endif
-    if (!initializeNTP_Sys(timeManager, sdManager, api_comm, config, COLOMBIA_GMT_OFFSET_SEC, COLOMBIA_DAYLIGHT_OFFSET_SEC)) {
-        ErrorLogger::logToSdOnly(sdManager, timeManager, LogLevel::ERROR, "NTP initialization failed in setup.");
+    if (!ntpSkipped && !initializeNTP_Sys(timeManager, sdManager, api_comm, config, COLOMBIA_GMT_OFFSET_SEC, COLOMBIA_DAYLIGHT_OFFSET_SEC)) {
+        LOG_SD(sdManager, timeManager, CORE, ERROR, "NTP initialization failed in setup.", NAN);
         led.setState(ERROR_TIMER);
         #ifdef ENABLE_DEBUG_SERIAL
             Serial.println(F("[MainSetup] CRITICAL: NTP init failed. Halting."));
         #endif
-        ErrorLogger::logToSdOnly(sdManager, timeManager, LogLevel::ERROR, "CRITICAL: NTP init failed. Halting.");
+        LOG_SD(sdManager, timeManager, CORE, ERROR, "CRITICAL: NTP init failed. Halting.", NAN);
         delay(ERROR_RESTART_DELAY_MS); 
         ESP.restart();
     }
+    if (!ntpSkipped) {
+        ResumeCheckpoint::data().lastNtpSyncEpoch = timeManager.getCurrentEpochTime();
+    }
+    saveScheduleCheckpoint(CyclePhase::SETUP);
 
     #ifdef ENABLE_DEBUG_SERIAL
         Serial.println(F("[MainSetup] Initializing Internal DS18B20 Sensor..."));
@@ -192,13 +359,15 @@ void setup() {
     #ifdef ENABLE_DEBUG_SERIAL
         Serial.println(F("[MainSetup] Initializing I2C bus..."));
     #endif
-    initI2C_Sys(I2C_SDA_PIN, I2C_SCL_PIN); 
+    initI2C_Sys(Board::I2C_SDA_PIN, Board::I2C_SCL_PIN); 
 
     #ifdef ENABLE_DEBUG_SERIAL
         Serial.println(F("[MainSetup] Initializing external sensors..."));
     #endif
 
-    String failedSensors = initializeSensors_Sys(bmeExternalSensor, lightSensor, thermalSensor, camera);
+    unsigned long sensorsInitStartMs = millis();
+    String failedSensors = initializeSensors_Sys(bmeExternalSensor, profileLightSensor, thermalSensor, profileCamera);
+    unsigned long sensorsInitMs = millis() - sensorsInitStartMs;
 
     if (!failedSensors.isEmpty()) { 
         
@@ -208,13 +377,37 @@ void setup() {
         led.setState(ERROR_SENSOR);
         handleSensorInitFailure_Sys(sdManager, timeManager, failedSensors);
     }
+    if (timeManager.getCurrentEpochTime() < nextDataCollectionEpochTime) {
+        sensorPower.sleepAll(); // A cold boot runs the first cycle right away; a resumed schedule waits
+    }
     
     String setupCompleteMsg = "Device setup completed (STA Mode). Initial Time: " + timeManager.getCurrentTimestampString();
-    ErrorLogger::logToSdOnly(sdManager, timeManager, LogLevel::INFO, "WiFi connected. Starting Normal Operation (STA Mode).");
+    if (ResumeCheckpoint::isResumed()) {
+        ResumeCheckpoint::markResumed();
+        const CheckpointData& checkpoint = ResumeCheckpoint::data();
+        setupCompleteMsg += " Resumed after " + String(ResumeCheckpoint::resetReasonName(ResumeCheckpoint::resetReason())) +
+                            " reset in phase " + ResumeCheckpoint::phaseName(ResumeCheckpoint::interruptedPhase()) +
+                            " (" + String(checkpoint.lastResumeMs) + " ms, NTP " + (ntpSkipped ? "skipped" : "synced") +
+                            ", resumes " + String(checkpoint.resumes) + ", discarded " + String(checkpoint.restoreFailures) + ").";
+    } else if (ResumeCheckpoint::data().restoreFailures > 0) {
+        setupCompleteMsg += " Checkpoint discarded (" + String(ResumeCheckpoint::data().restoreFailures) + " so far).";
+    }
+
+    // Build profile footprint, to compare profiles on real hardware (see tools/profile_report.py)
+    unsigned long bootMs = millis();
+    setupCompleteMsg += " Profile " BOARD_PROFILE_NAME " (boot " + String(bootMs) + " ms, sensors " + String(sensorsInitMs) +
+                        " ms, sketch " + String(ESP.getSketchSize()) + " B, free heap " + String(ESP.getFreeHeap()) +
+                        " B, free PSRAM " + String(ESP.getFreePsram()) + " B).";
+    #ifdef ENABLE_DEBUG_SERIAL
+        Serial.printf("BOOT_PROFILE {\"profile\":\"%s\",\"boot_ms\":%lu,\"sensors_ms\":%lu,\"sketch_bytes\":%u,\"free_heap\":%u,\"min_free_heap\":%u,\"free_psram\":%u}\n",
+                      BOARD_PROFILE_NAME, bootMs, sensorsInitMs, (unsigned)ESP.getSketchSize(), (unsigned)ESP.getFreeHeap(),
+                      (unsigned)ESP.getMinFreeHeap(), (unsigned)ESP.getFreePsram());
+    #endif
+    EventLog::log<EventId::WIFI_STA_MODE_START>(sdManager, timeManager, NAN);
     if (api_comm && api_comm->isActivated()){
-        ErrorLogger::sendLog(sdManager, timeManager, api_comm->getBaseApiUrl() + config.apiLogPath, api_comm->getAccessToken(), LOG_TYPE_INFO, setupCompleteMsg, NAN);
+        LOG_SEND(sdManager, timeManager, api_comm->getBaseApiUrl() + config.apiLogPath, api_comm->getAccessToken(), CORE, LOG_TYPE_INFO, setupCompleteMsg, NAN);
     } else {
-        ErrorLogger::logToSdOnly(sdManager, timeManager, LogLevel::INFO, setupCompleteMsg, NAN);
+        LOG_SD(sdManager, timeManager, CORE, INFO, setupCompleteMsg, NAN);
     }
 
     #ifdef ENABLE_DEBUG_SERIAL
@@ -226,7 +419,7 @@ void setup() {
         #ifdef ENABLE_DEBUG_SERIAL
             Serial.println(F("[WebPortal] Connection failed or no configuration. Starting Configuration Mode (AP)."));
         #endif
-        ErrorLogger::logToSdOnly(sdManager, timeManager, LogLevel::INFO, "WiFi failed or no config. Starting Configuration (AP Mode).");
+        LOG_SD(sdManager, timeManager, WIFI, INFO, "WiFi failed or no config. Starting Configuration (AP Mode).", NAN);
         isInConfigMode = true;
         led.setState(CONFIG_MODE_AP); 
         
@@ -253,21 +446,33 @@ void loop() {
 
         // --- 1. Quick, continuous checks (runs on every single loop pass) ---
         float internalTemp = dsInternalSensor.readTemperature();
+        sdManager.checkCardHealth(timeManager, internalTemp); // Probe / remount with backoff
 
         // --- 2. Timing Gate: Check if it's time to run the data collection cycle ---
         time_t currentTime = timeManager.getCurrentEpochTime();
+        if (currentTime < nextDataCollectionEpochTime) {
+            // Sleeping sensors are woken one after another so each is ready when the cycle starts
+            time_t secondsUntilCycle = min(nextDataCollectionEpochTime - currentTime, (time_t)86400);
+            sensorPower.service((uint32_t)secondsUntilCycle * 1000UL);
+        }
         if (currentTime >= nextDataCollectionEpochTime) {
 
             // --- 3. It's time to run: Execute the full data collection and maintenance cycle ---
+            TRACE_SCOPE(CYCLE);
             #ifdef ENABLE_DEBUG_SERIAL
                 Serial.println(F("\n[MainLoop] >>> Starting Data Collection Cycle <<<"));
             #endif
 
             ledBlink_Ctrl(led);
             led.setState(ALL_OK);
+            PhaseDeadline::resetCycle();
+            sensorPower.wakeAll(); // Whatever the loop did not wake in time (counted as late)
             
             // --- 3A. Backend & Auth Check with new granular logic ---
             bool proceedWithDataCollection = false; // Default to not proceeding until a valid state is confirmed.
+            ResumeCheckpoint::save(CyclePhase::AUTH);
+            TRACE_BEGIN(AUTH_CHECK);
+            HEAP_TAG_BEGIN(API);
 
             for (int attempt = 1; attempt <= AUTH_MAX_RETRIES; ++attempt) {
                 int resultCode = 0;
@@ -294,7 +499,7 @@ void loop() {
                         #ifdef ENABLE_DEBUG_SERIAL
                             Serial.println("[MainLoop] Backend appears offline. Proceeding to collect data for pending queue.");
                         #endif
-                        ErrorLogger::logToSdOnly(sdManager, timeManager, LogLevel::WARNING, "Backend offline (Code: " + String(resultCode) + "). Proceeding with queue.");
+                        EventLog::log<EventId::BACKEND_OFFLINE>(sdManager, timeManager, NAN, resultCode);
                         proceedWithDataCollection = true; // Per new logic, we proceed anyway.
                         break; // Don't retry if server is down, just break and continue the cycle.
                     }
@@ -303,8 +508,8 @@ void loop() {
                     #ifdef ENABLE_DEBUG_SERIAL
                         Serial.printf("[MainLoop] Auth check failed with client-side error (Code: %d). Retrying (%d/%d)...\n", resultCode, attempt, AUTH_MAX_RETRIES);
                     #endif
-                    String authErrMsg = "Auth check failed (Code: " + String(resultCode) + "). Retrying (" + String(attempt) + "/" + String(AUTH_MAX_RETRIES) + ").";
-                    ErrorLogger::logToSdOnly(sdManager, timeManager, LogLevel::ERROR, authErrMsg);
+                    LOG_SD(sdManager, timeManager, API, ERROR,
+                           "Auth check failed (Code: " + String(resultCode) + "). Retrying (" + String(attempt) + "/" + String(AUTH_MAX_RETRIES) + ").", NAN);
                 }
 
                 // If we are here, it means a critical auth/activation error occurred, and we should retry.
@@ -313,23 +518,32 @@ void loop() {
                 }
             }
 
+            HEAP_TAG_END(API);
+            TRACE_END(AUTH_CHECK);
+
             // --- 3B. Execute or Skip Cycle based on Auth Check ---
             if (!proceedWithDataCollection) {
                 // This only happens if activation or a critical auth check (like 4xx) fails all retries.
                 #ifdef ENABLE_DEBUG_SERIAL
                     Serial.println(F("[MainLoop] CRITICAL: Cannot authenticate or activate. Skipping cycle and retrying later."));
                 #endif
-                ErrorLogger::logToSdOnly(sdManager, timeManager, LogLevel::ERROR, "Critical Auth/Activation failed. Cycle skipped.");
+                EventLog::log<EventId::CYCLE_AUTH_FAILED>(sdManager, timeManager, NAN);
                 led.setState(ERROR_AUTH);
                 
                 // Schedule next attempt after the standard interval
                 unsigned long intervalMinutes = api_comm->getDataCollectionTimeMinutes() > 0 ? api_comm->getDataCollectionTimeMinutes() : config.data_interval_minutes;
                 nextDataCollectionEpochTime = timeManager.getCurrentEpochTime() + (intervalMinutes * 60);
+                saveScheduleCheckpoint(CyclePhase::IDLE);
+                sensorPower.sleepAll();
                 return; // Skip the rest of this cycle.
             }
             
             // --- 3C. Data Capture ---
-            float lightLevel = lightSensor.readLightLevel();
+            #if BOARD_HAS_LIGHT_SENSOR
+                float lightLevel = lightSensor.readLightLevel();
+            #else
+                float lightLevel = NAN; // No light sensor: no visual capture either
+            #endif
 
             #ifdef ENABLE_DEBUG_SERIAL
                 Serial.printf("[MainLoop] Current Time: %s\n", timeManager.getCurrentTimestampString().c_str());
@@ -338,47 +552,121 @@ void loop() {
             bool cycleStatusOK = true;
 
             // perform...Tasks functions will internally handle failed sends by saving to pending.
-            if (!performEnvironmentTasks_Env(sdManager, timeManager, config, *api_comm, lightSensor, bmeExternalSensor, led, internalTemp)) {
+            float airTemp = NAN;      // For the thermal anomaly detector
+            float surfaceTemp = NAN;
+
+            ResumeCheckpoint::save(CyclePhase::ENVIRONMENT);
+            TRACE_BEGIN(ENV_TASKS);
+            HEAP_TAG_BEGIN(ENVIRONMENT);
+            PhaseDeadline::begin(DeadlinePhase::ENVIRONMENT);
+            if (!performEnvironmentTasks_Env(sdManager, timeManager, config, *api_comm, profileLightSensor, bmeExternalSensor, led, internalTemp, &airTemp)) {
                 cycleStatusOK = false;
             }
+            PhaseDeadline::end();
+            HEAP_TAG_END(ENVIRONMENT);
+            TRACE_END(ENV_TASKS);
+            sensorPower.sleep(lightPowerIndex); // The image phase only needs the lux already read
+            sensorPower.sleep(bmePowerIndex);
             
             uint8_t* localJpegImage = nullptr;
             size_t localJpegLength = 0;
             float* localThermalData = nullptr;
+            HEAP_TAG_BEGIN(IMAGE); // Closed after cleanupImageBuffers_Ctrl (the buffers outlive the tasks)
             if (cycleStatusOK) {
-                if (!performImageTasks_Img(sdManager, timeManager, config, *api_comm, camera, thermalSensor, led, lightLevel, &localJpegImage, localJpegLength, &localThermalData, internalTemp)) {
+                TRACE_SCOPE(IMAGE_TASKS);
+                ResumeCheckpoint::save(CyclePhase::IMAGE);
+                PhaseDeadlineScope imageDeadline(DeadlinePhase::IMAGE); // On expiry the capture goes to pending; buffers are freed below
+                if (!performImageTasks_Img(sdManager, timeManager, config, *api_comm, profileCamera, thermalSensor, led, lightLevel, &localJpegImage, localJpegLength, &localThermalData, internalTemp, &surfaceTemp)) {
                     cycleStatusOK = false;
                 }
             }
             
+            sensorPower.sleepAll(); // Thermal camera and OV2640 (or everything, if the image phase was skipped)
+
             // --- 3D. End-of-Cycle Signaling & Cleanup ---
-            const char* logType = cycleStatusOK ? LOG_TYPE_INFO : LOG_TYPE_WARNING;
-            String logMessage = cycleStatusOK ? "Main data cycle completed successfully." : "Main data cycle completed with errors.";
-            ErrorLogger::sendLog(sdManager, timeManager, api_comm->getBaseApiUrl() + config.apiLogPath, api_comm->getAccessToken(), logType, logMessage, internalTemp);
-            
+            cleanupImageBuffers_Ctrl(localJpegImage, localThermalData);
+            HEAP_TAG_END(IMAGE);
+
+            // Canopy-minus-air against the learned baseline; a stress event switches to burst cadence (step 4)
+            if (anomalyDetector.update((uint32_t)currentTime, surfaceTemp, airTemp) == ANOMALY_TRIGGERED) {
+                LOG_SEND(sdManager, timeManager, api_comm->getBaseApiUrl() + config.apiLogPath, api_comm->getAccessToken(), CORE, LOG_TYPE_WARNING,
+                         "Thermal anomaly: surface-air " + String(surfaceTemp - airTemp, 2) + " C (z=" + String(anomalyDetector.lastZ(), 1) +
+                         "). Capturing every " + String(config.burst_interval_minutes) + " min for up to " + String(config.burst_duration_minutes) + " min.",
+                         internalTemp);
+            }
+
             ledBlink_Ctrl(led);
             led.setState(OFF);
 
             // --- 3E. Maintenance Tasks ---
-            cleanupImageBuffers_Ctrl(localJpegImage, localThermalData);
+            // This slot's data is already captured: the next slot is checkpointed before maintenance,
+            // so a reset from here on waits for it instead of capturing the same slot again
+            uint32_t burstDelaySeconds = anomalyDetector.nextBurstDelay((uint32_t)currentTime);
+            anomalyDetector.saveState(); // Baseline, burst and budget survive a reboot
+
+            unsigned long intervalMinutes = api_comm->getDataCollectionTimeMinutes();
+            if (intervalMinutes == 0) {
+                intervalMinutes = config.data_interval_minutes;
+            }
+            nextDataCollectionEpochTime = scheduleNextCollection(currentTime, intervalMinutes, burstDelaySeconds);
+            saveScheduleCheckpoint(CyclePhase::MAINTENANCE);
+
+            // Small records (ambient, logs) move from the internal flash ring to the SD in batches,
+            // before the backlog policy and the pending queue look at the SD directories
+            PhaseDeadline::begin(DeadlinePhase::MAINTENANCE);
+            if (sdManager.hotTierPendingRecords() > 0) {
+                TRACE_BEGIN(HOT_TIER_MIGRATE);
+                sdManager.migrateHotTier(timeManager, HOT_TIER_MIGRATE_BATCH, internalTemp);
+                TRACE_END(HOT_TIER_MIGRATE);
+            }
+
+            // Backlog policy runs even offline so the queue stays bounded during long outages
+            TRACE_BEGIN(BACKLOG_COMPACT);
+            sdManager.compactPendingBacklog(timeManager, config, internalTemp);
+            TRACE_END(BACKLOG_COMPACT);
+            PhaseDeadline::end();
 
             if (wifiManager.getConnectionStatus() == WiFiManager::CONNECTED) {
-                ErrorLogger::logToSdOnly(sdManager, timeManager, LogLevel::INFO, "Processing pending API call queue...");
+                TRACE_SCOPE(PENDING_QUEUE);
+                HEAP_TAG_SCOPE(SDMANAGER);
+                PhaseDeadlineScope drainDeadline(DeadlinePhase::DRAIN);
+                EventLog::log<EventId::PENDING_QUEUE_PROCESSING>(sdManager, timeManager, internalTemp);
                 sdManager.processPendingApiCalls(*api_comm, timeManager, config, internalTemp);
             }
+
+            // Heap is sampled once every tagged scope of the cycle has closed (image buffers and
+            // pending queue included), so each cycle is measured at the same point
+            bool heapGrowthFlagged = HeapMonitor::sampleCycle();
+            const char* logType = cycleStatusOK ? LOG_TYPE_INFO : LOG_TYPE_WARNING;
+            const char* logMessage = cycleStatusOK ? "Main data cycle completed successfully." : "Main data cycle completed with errors.";
+            String cycleSummary = String(logMessage) + " " + HeapMonitor::summary();
+            char sensorWakes[128];
+            if (sensorPower.describe(sensorWakes, sizeof(sensorWakes)) > 0) {
+                cycleSummary += ". Sensor wake (last/avg): " + String(sensorWakes);
+            }
+            LOG_SEND(sdManager, timeManager, api_comm->getBaseApiUrl() + config.apiLogPath, api_comm->getAccessToken(), CORE, logType,
+                     cycleSummary, internalTemp);
+            if (heapGrowthFlagged) {
+                LOG_SEND(sdManager, timeManager, api_comm->getBaseApiUrl() + config.apiLogPath, api_comm->getAccessToken(), CORE, LOG_TYPE_WARNING,
+                         "Possible memory leak: " + HeapMonitor::growthDetails(), internalTemp);
+            }
             
             if (sdManager.isSDAvailable()) {
+                TRACE_BEGIN(STORAGE_MAINTENANCE);
+                PhaseDeadline::begin(DeadlinePhase::MAINTENANCE);
                 sdManager.manageAllStorage(timeManager); 
+                PhaseDeadline::end();
+                TRACE_END(STORAGE_MAINTENANCE);
                 
                 uint64_t sdUsed, sdTotal;
                 float usagePercent = sdManager.getUsageInfo(sdUsed, sdTotal);
                 if (usagePercent >= 90.0f && !sdUsageWarning90PercentSent) {
-                    String msg = "CRITICAL WARNING: SD Card usage is at " + String(usagePercent, 1) + "%";
-                    ErrorLogger::sendLog(sdManager, timeManager, api_comm->getBaseApiUrl() + config.apiLogPath, api_comm->getAccessToken(), LOG_TYPE_WARNING, msg, internalTemp);
+                    LOG_SEND(sdManager, timeManager, api_comm->getBaseApiUrl() + config.apiLogPath, api_comm->getAccessToken(), SDMANAGER, LOG_TYPE_WARNING,
+                             "CRITICAL WARNING: SD Card usage is at " + String(usagePercent, 1) + "%", internalTemp);
                     sdUsageWarning90PercentSent = true;
                 } else if (usagePercent < 85.0f && sdUsageWarning90PercentSent) {
-                    String msg = "INFO: SD Card usage is now " + String(usagePercent, 1) + "%. Warning resolved.";
-                    ErrorLogger::sendLog(sdManager, timeManager, api_comm->getBaseApiUrl() + config.apiLogPath, api_comm->getAccessToken(), LOG_TYPE_INFO, msg, internalTemp);
+                    LOG_SEND(sdManager, timeManager, api_comm->getBaseApiUrl() + config.apiLogPath, api_comm->getAccessToken(), SDMANAGER, LOG_TYPE_INFO,
+                             "INFO: SD Card usage is now " + String(usagePercent, 1) + "%. Warning resolved.", internalTemp);
                     sdUsageWarning90PercentSent = false;
                 }
             }
@@ -392,45 +680,47 @@ void loop() {
                     #ifdef ENABLE_DEBUG_SERIAL
                         Serial.println(F("[TimeManager] WARNING: NTP sync has been lost! Attempting to re-initialize..."));
                     #endif
-                    ErrorLogger::logToSdOnly(sdManager, timeManager, LogLevel::WARNING, "NTP sync lost during operation. Attempting re-sync.");
+                    EventLog::log<EventId::NTP_SYNC_LOST>(sdManager, timeManager, NAN);
                     led.setState(ERROR_TIMER);
-                    initializeNTP_Sys(timeManager, sdManager, api_comm, config, COLOMBIA_GMT_OFFSET_SEC, COLOMBIA_DAYLIGHT_OFFSET_SEC);
+                    TRACE_SCOPE(NTP_SYNC);
+                    if (initializeNTP_Sys(timeManager, sdManager, api_comm, config, COLOMBIA_GMT_OFFSET_SEC, COLOMBIA_DAYLIGHT_OFFSET_SEC)) {
+                        ResumeCheckpoint::data().lastNtpSyncEpoch = timeManager.getCurrentEpochTime();
+                    }
 
                 } else {
                     #ifdef ENABLE_DEBUG_SERIAL
                         Serial.println(F("[TimeManager] Periodic NTP check: Sync status is OK."));
                     #endif
+                    ResumeCheckpoint::data().lastNtpSyncEpoch = currentTimeForSyncCheck;
                 }
 
                 lastNtpSyncEpochTime = timeManager.getCurrentEpochTime();
             }
 
-            
-            // --- 4. Schedule the NEXT data collection cycle ---
-            unsigned long intervalMinutes = api_comm->getDataCollectionTimeMinutes();
-            if (intervalMinutes == 0) {
-                intervalMinutes = config.data_interval_minutes;
+            // --- 3G. Phase Deadline Overruns (work past the deadline was cancelled and left for the next cycle) ---
+            if (PhaseDeadline::overrunCount() > 0) {
+                for (uint8_t i = 0; i < PhaseDeadline::overrunCount(); i++) {
+                    const PhaseOverrun& overrun = PhaseDeadline::overrun(i);
+                    EventLog::log<EventId::PHASE_DEADLINE_OVERRUN>(sdManager, timeManager, internalTemp, PhaseDeadline::phaseName(overrun.phase),
+                                                                   (unsigned)overrun.elapsedMs, (unsigned)overrun.budgetMs);
+                }
+                char overruns[160];
+                PhaseDeadline::describeOverruns(overruns, sizeof(overruns));
+                LOG_SEND(sdManager, timeManager, api_comm->getBaseApiUrl() + config.apiLogPath, api_comm->getAccessToken(), CORE, LOG_TYPE_WARNING,
+                         "Phase deadline overrun: " + String(overruns), internalTemp);
             }
 
-            time_t lastRunTime = timeManager.getCurrentEpochTime(); 
-            struct tm timeinfo;
-            localtime_r(&lastRunTime, &timeinfo);
-
-            int minutes_past_slot = timeinfo.tm_min % intervalMinutes;
-            int minutes_to_add = (minutes_past_slot == 0) ? intervalMinutes : (intervalMinutes - minutes_past_slot);
-            
-            time_t next_run_base_time = lastRunTime + (minutes_to_add * 60);
-
-            localtime_r(&next_run_base_time, &timeinfo);
-            timeinfo.tm_sec = 0;
-            nextDataCollectionEpochTime = mktime(&timeinfo);
             
-            if (nextDataCollectionEpochTime <= lastRunTime) {
-                nextDataCollectionEpochTime += (intervalMinutes * 60);
-            }
+            // --- 4. Schedule the NEXT data collection cycle ---
+            // Same burst decision as the maintenance checkpoint (during a thermal anomaly burst the next
+            // capture comes sooner, within the daily budget); the slot is recomputed in case
+            // maintenance ran past it
+            nextDataCollectionEpochTime = scheduleNextCollection(currentTime, intervalMinutes, burstDelaySeconds);
+            saveScheduleCheckpoint(CyclePhase::IDLE);
 
             #ifdef ENABLE_DEBUG_SERIAL
                 char time_buf[50];
+                struct tm timeinfo;
                 localtime_r(&nextDataCollectionEpochTime, &timeinfo);
                 strftime(time_buf, sizeof(time_buf), "%Y-%m-%d %H:%M:%S", &timeinfo);
                 Serial.printf("[MainLoop] <<< Cycle Complete >>> Next run scheduled for: %s\n\n", time_buf);
@@ -0,0 +1,162 @@
+// AnomalyDetector (thermal stress -> burst captures) tests.
+// No sensors needed: synthetic canopy/air traces are replayed through the same schedule the
+// main loop uses (update() after each capture, then nextBurstDelay() to pick the next one).
+
+// Include necessary libraries
+#include <Arduino.h>            // Arduino core framework
+#include <unity.h>              // Unity test framework
+#include <string.h>             // memcmp for state comparisons
+#include "AnomalyDetector.h"    // Detector under test
+
+// First capture: 2025-10-31 00:00:00 UTC
+#define TEST_START_EPOCH 1761868800UL
+// Normal capture period (data_interval_minutes = 30)
+#define TEST_INTERVAL_S 1800
+#define TEST_DAY_S 86400UL
+
+// --- Shared fixtures ---
+// Canopy-minus-air offset: diurnal cycle plus sensor-like noise (deterministic)
+static float normalDelta(uint32_t time) {
+    float hour = (float)((time - TEST_START_EPOCH) % TEST_DAY_S) / 3600.0f;
+    uint32_t noise = (time / 60) * 2654435761UL;
+    return -1.0f + 1.5f * sinf((hour - 6.0f) * 3.14159f / 12.0f) + (float)(noise >> 24) / 255.0f * 0.6f - 0.3f;
+}
+
+// Irrigation failure: the canopy runs `extra` degrees warmer during [from, to)
+struct StressWindow {
+    uint32_t from;
+    uint32_t to;
+    float extra;
+};
+
+// Outcome of replaying a trace with the main-loop schedule
+struct ReplayResult {
+    int captures;
+    int triggers;
+    int burstCaptures;
+    uint32_t firstTrigger;
+};
+
+static ReplayResult replay(AnomalyDetector& detector, uint32_t from, uint32_t to, const StressWindow* stress) {
+    ReplayResult result = {0, 0, 0, 0};
+    const float air = 22.0f;
+    uint32_t time = from;
+    while (time < to) {
+        float delta = normalDelta(time);
+        if (stress && time >= stress->from && time < stress->to) delta += stress->extra;
+        if (detector.update(time, air + delta, air) == ANOMALY_TRIGGERED) {
+            if (result.triggers == 0) result.firstTrigger = time;
+            result.triggers++;
+        }
+        result.captures++;
+        uint32_t burstDelay = detector.nextBurstDelay(time);
+        if (burstDelay > 0) {
+            result.burstCaptures++;
+            time += burstDelay;
+        } else {
+            time += TEST_INTERVAL_S - (time % TEST_INTERVAL_S); // Next slot, as the scheduler aligns it
+        }
+    }
+    return result;
+}
+
+// setUp function: runs before each test
+void setUp(void) {}
+// tearDown function: runs after each test
+void tearDown(void) {}
+
+// Three ordinary days: the baseline learns the diurnal cycle and never fires
+void test_diurnal_trace_no_trigger() {
+    AnomalyDetector detector;
+    ReplayResult result = replay(detector, TEST_START_EPOCH, TEST_START_EPOCH + 3 * TEST_DAY_S, nullptr);
+    TEST_ASSERT_EQUAL_INT(3 * 48, result.captures);
+    TEST_ASSERT_EQUAL_INT(0, result.triggers);
+    TEST_ASSERT_EQUAL_INT(0, result.burstCaptures);
+    TEST_ASSERT_FALSE(detector.inBurst(TEST_START_EPOCH + 3 * TEST_DAY_S));
+}
+
+// A hot afternoon with failed irrigation starts one burst at the configured cadence
+void test_stress_event_starts_burst() {
+    AnomalyDetector detector;
+    const uint32_t day3 = TEST_START_EPOCH + 2 * TEST_DAY_S;
+    StressWindow stress = {day3 + 14 * 3600, day3 + 16 * 3600, 4.0f};
+    ReplayResult result = replay(detector, TEST_START_EPOCH, day3 + TEST_DAY_S, &stress);
+
+    TEST_ASSERT_EQUAL_INT(1, result.triggers);
+    TEST_ASSERT_EQUAL_UINT32(stress.from, result.firstTrigger); // Caught on the first stressed capture
+    // 60 min burst every 5 min: 12 extra-cadence captures, then back to the 30 min slots
+    TEST_ASSERT_EQUAL_INT(12, result.burstCaptures);
+    TEST_ASSERT_EQUAL_INT(3 * 48 + 12 - 2, result.captures); // The burst replaces two normal slots
+    // The event must not become the new normal
+    TEST_ASSERT_LESS_THAN_FLOAT(1.0f, detector.baselineMean());
+}
+
+// Cooldown blocks a second burst right away; the daily budget caps the extra captures
+void test_cooldown_and_budget() {
+    AnomalyConfig config;
+    config.cooldownSeconds = 4 * 3600;
+    config.maxBurstCapturesPerDay = 18;
+    AnomalyDetector detector(config);
+    const uint32_t day3 = TEST_START_EPOCH + 2 * TEST_DAY_S;
+    StressWindow stress = {day3 + 8 * 3600, day3 + 20 * 3600, 5.0f};
+    ReplayResult result = replay(detector, TEST_START_EPOCH, day3 + TEST_DAY_S, &stress);
+
+    // Burst at 08:00, cooldown until 13:00, second burst cut short by the budget (18 = 12 + 6)
+    TEST_ASSERT_EQUAL_INT(2, result.triggers);
+    TEST_ASSERT_EQUAL_INT(18, result.burstCaptures);
+    TEST_ASSERT_EQUAL_UINT16(18, detector.state().budgetUsed);
+}
+
+// The persisted state resumes exactly where it left off; damaged blobs are rejected
+void test_state_survives_restart() {
+    AnomalyDetector before;
+    const uint32_t half = TEST_START_EPOCH + 2 * TEST_DAY_S;
+    replay(before, TEST_START_EPOCH, half, nullptr);
+
+    AnomalyDetector after;
+    TEST_ASSERT_TRUE(after.restore(before.state()));
+    TEST_ASSERT_EQUAL_MEMORY(&before.state(), &after.state(), sizeof(AnomalyState));
+    replay(before, half, half + TEST_DAY_S, nullptr);
+    replay(after, half, half + TEST_DAY_S, nullptr);
+    TEST_ASSERT_EQUAL_MEMORY(&before.state(), &after.state(), sizeof(AnomalyState));
+
+    AnomalyState damaged = before.state();
+    damaged.magic = 0;
+    TEST_ASSERT_FALSE(after.restore(damaged));
+    damaged = before.state();
+    damaged.variance = NAN;
+    TEST_ASSERT_FALSE(after.restore(damaged));
+    TEST_ASSERT_EQUAL_MEMORY(&before.state(), &after.state(), sizeof(AnomalyState));
+}
+
+// Failed readings, an unsynced clock and repeated timestamps leave the baseline untouched
+void test_invalid_samples_skipped() {
+    AnomalyDetector detector;
+    TEST_ASSERT_EQUAL_UINT8(ANOMALY_LEARNING, detector.update(TEST_START_EPOCH, 24.0f, 22.0f));
+    TEST_ASSERT_EQUAL_UINT8(ANOMALY_SKIPPED, detector.update(TEST_START_EPOCH + 60, NAN, 22.0f));
+    TEST_ASSERT_EQUAL_UINT8(ANOMALY_SKIPPED, detector.update(TEST_START_EPOCH + 60, 24.0f, NAN));
+    TEST_ASSERT_EQUAL_UINT8(ANOMALY_SKIPPED, detector.update(0, 24.0f, 22.0f));
+    TEST_ASSERT_EQUAL_UINT8(ANOMALY_SKIPPED, detector.update(TEST_START_EPOCH, 30.0f, 22.0f));
+    TEST_ASSERT_EQUAL_UINT32(1, detector.state().samples);
+    TEST_ASSERT_EQUAL_FLOAT(2.0f, detector.baselineMean());
+    TEST_ASSERT_EQUAL_UINT32(0, detector.nextBurstDelay(TEST_START_EPOCH + 60));
+}
+
+// Setup function: runs once at the beginning
+void setup() {
+    // Wait for the serial monitor to connect
+    delay(2000);
+
+    // Begin the Unity test framework
+    UNITY_BEGIN();
+    RUN_TEST(test_diurnal_trace_no_trigger);
+    RUN_TEST(test_stress_event_starts_burst);
+    RUN_TEST(test_cooldown_and_budget);
+    RUN_TEST(test_state_survives_restart);
+    RUN_TEST(test_invalid_samples_skipped);
+    // End the Unity test framework and report results
+    UNITY_END();
+}
+
+// Loop function: runs repeatedly after setup (empty for tests)
+void loop() {}
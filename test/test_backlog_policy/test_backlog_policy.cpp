@@ -0,0 +1,191 @@
+// Backlog policy (SDManager::compactPendingBacklog helpers) tests.
+// Needs the SD card: the helpers work on the real pending directories, so every fixture is
+// dated 1999 (older than any real record) and removed, from pending and archive, after each
+// test. Without a card every test is reported as IGNORED.
+
+// Include necessary libraries
+#include <Arduino.h>         // Arduino core framework
+#include <unity.h>           // Unity test framework
+#include <ArduinoJson.h>     // Summary contents
+#include "SDManager.h"       // Policy under test
+
+// Prefix shared by every fixture (used by the cleanup)
+#define BP_FIXTURE_PREFIX "19990101_"
+// Every fixture is older than this
+#define BP_CUTOFF_NAME "20000101_000000"
+
+// Access to the private backlog helpers (friend of SDManager)
+struct BacklogPolicyAccess {
+    static int thin(SDManager& sd, time_t cutoff, int intervalMinutes) {
+        return sd._thinPendingCaptures(cutoff, intervalMinutes);
+    }
+    static int summarize(SDManager& sd, time_t cutoff, int bucketMinutes) {
+        return sd._summarizePendingAmbient(cutoff, bucketMinutes);
+    }
+    static int cap(SDManager& sd, uint64_t maxBytes) {
+        return sd._enforcePendingByteCap(maxBytes);
+    }
+    static time_t parseName(SDManager& sd, const String& name) {
+        return sd._parseFullTimestampFromFilename(name);
+    }
+    static uint64_t pendingBytes(SDManager& sd) {
+        uint64_t total = 0;
+        for (const auto& info : sd._collectTimestampedFiles(AMBIENT_PENDING_DIR, "")) total += info.size;
+        for (const auto& info : sd._collectTimestampedFiles(CAPTURE_PENDING_DIR, "")) total += info.size;
+        return total;
+    }
+};
+
+// --- Shared fixtures ---
+SDManager testSd;
+bool sdReady = false;
+time_t cutoff = 0;
+
+static String ambientPath(const char* base) {
+    return String(AMBIENT_PENDING_DIR) + "/" BP_FIXTURE_PREFIX + base + "_env.json";
+}
+
+static String ambientJson(const char* time, int light, float temperature) {
+    return "{\"timestamp\":\"1999-01-01_" + String(time) + "\",\"light\":" + String(light) +
+           ",\"temperature\":" + String(temperature, 1) + ",\"humidity\":60,\"pressure\":1013}";
+}
+
+static String thermalPath(const char* base) {
+    return String(CAPTURE_PENDING_DIR) + "/" BP_FIXTURE_PREFIX + base + "_thermal.json";
+}
+
+static bool exists(const String& path) {
+    return SD_MMC.exists(path.c_str());
+}
+
+// Archive path of a pending file
+static String archived(const String& path) {
+    String name = path.substring(path.lastIndexOf('/') + 1);
+    return String(path.startsWith(AMBIENT_PENDING_DIR) ? ARCHIVE_ENVIRONMENTAL_DIR : ARCHIVE_CAPTURES_DIR) + "/" + name;
+}
+
+// Deletes every fixture from a directory
+static void removeFixtures(const char* dirPath) {
+    File dir = SD_MMC.open(dirPath);
+    if (!dir) return;
+    std::vector<String> files;
+    for (File entry = dir.openNextFile(); entry; entry = dir.openNextFile()) {
+        String name = String(entry.name()).substring(String(entry.name()).lastIndexOf('/') + 1);
+        if (name.startsWith(BP_FIXTURE_PREFIX)) files.push_back(String(dirPath) + "/" + name);
+        entry.close();
+    }
+    dir.close();
+    for (const String& path : files) testSd.deleteFile(path.c_str());
+}
+
+// setUp function: runs before each test
+void setUp(void) {
+    if (!sdReady) {
+        TEST_IGNORE_MESSAGE("SD card not available");
+    }
+}
+// tearDown function: runs after each test
+void tearDown(void) {
+    if (!sdReady) return;
+    removeFixtures(AMBIENT_PENDING_DIR);
+    removeFixtures(CAPTURE_PENDING_DIR);
+    removeFixtures(ARCHIVE_ENVIRONMENTAL_DIR);
+    removeFixtures(ARCHIVE_CAPTURES_DIR);
+}
+
+// Thinning keeps the first capture of each interval; the rest and every old JPEG are archived
+void test_thin_keeps_one_capture_per_interval() {
+    const char* bases[4] = {"000000", "000500", "001000", "010000"};
+    for (const char* base : bases) {
+        TEST_ASSERT_TRUE(testSd.writeTextFile(thermalPath(base), "{\"temperatures\":[]}"));
+    }
+    const uint8_t jpeg[] = {0xFF, 0xD8, 0xFF, 0xD9};
+    String jpegPath = String(CAPTURE_PENDING_DIR) + "/" BP_FIXTURE_PREFIX "000500_visual.jpg";
+    TEST_ASSERT_TRUE(testSd.writeBinaryFile(jpegPath, jpeg, sizeof(jpeg)));
+
+    TEST_ASSERT_EQUAL_INT(3, BacklogPolicyAccess::thin(testSd, cutoff, 60));
+    TEST_ASSERT_TRUE(exists(thermalPath("000000")));
+    TEST_ASSERT_TRUE(exists(thermalPath("010000")));
+    TEST_ASSERT_TRUE(exists(archived(thermalPath("000500"))));
+    TEST_ASSERT_TRUE(exists(archived(thermalPath("001000"))));
+    TEST_ASSERT_TRUE(exists(archived(jpegPath)));
+    TEST_ASSERT_FALSE(exists(jpegPath));
+
+    // Deterministic: a second pass keeps the same representatives
+    TEST_ASSERT_EQUAL_INT(0, BacklogPolicyAccess::thin(testSd, cutoff, 60));
+    TEST_ASSERT_TRUE(exists(thermalPath("000000")));
+}
+
+// Summaries average each window weighted by samples; corrupt files stay pending untouched
+void test_summarize_averages_and_skips_corrupt() {
+    TEST_ASSERT_TRUE(testSd.writeTextFile(ambientPath("000000"), ambientJson("00:00:00", 100, 20.0f)));
+    TEST_ASSERT_TRUE(testSd.writeTextFile(ambientPath("001000"), ambientJson("00:10:00", 200, 22.0f)));
+    TEST_ASSERT_TRUE(testSd.writeTextFile(ambientPath("002000"), "{\"light\":"));
+    TEST_ASSERT_TRUE(testSd.writeTextFile(ambientPath("010000"), ambientJson("01:00:00", 300, 25.0f)));
+
+    TEST_ASSERT_EQUAL_INT(2, BacklogPolicyAccess::summarize(testSd, cutoff, 60));
+    String summaryPath = String(AMBIENT_PENDING_DIR) + "/" BP_FIXTURE_PREFIX "000000_sum_env.json";
+    String content;
+    TEST_ASSERT_TRUE(testSd.readRecordText(summaryPath, content));
+    JsonDocument summary;
+    TEST_ASSERT_FALSE(deserializeJson(summary, content));
+    TEST_ASSERT_EQUAL_STRING("1999-01-01_00:00:00", summary["timestamp"] | "");
+    TEST_ASSERT_EQUAL_STRING("1999-01-01_00:10:00", summary["window_end"] | "");
+    TEST_ASSERT_EQUAL_INT(2, summary["samples"] | 0);
+    TEST_ASSERT_EQUAL_FLOAT(150.0f, summary["light"] | NAN);
+    TEST_ASSERT_EQUAL_FLOAT(21.0f, summary["temperature"] | NAN);
+
+    TEST_ASSERT_TRUE(exists(archived(ambientPath("000000"))));
+    TEST_ASSERT_TRUE(exists(archived(ambientPath("001000"))));
+    TEST_ASSERT_TRUE(exists(ambientPath("002000")));           // Corrupt: left in pending
+    TEST_ASSERT_FALSE(exists(archived(ambientPath("002000"))));
+    TEST_ASSERT_TRUE(exists(ambientPath("010000")));           // Alone in its window
+
+    // A second pass re-reads the summary with its weight and still leaves the corrupt file alone
+    TEST_ASSERT_EQUAL_INT(0, BacklogPolicyAccess::summarize(testSd, cutoff, 60));
+    TEST_ASSERT_TRUE(testSd.readRecordText(summaryPath, content));
+    TEST_ASSERT_FALSE(deserializeJson(summary, content));
+    TEST_ASSERT_EQUAL_INT(2, summary["samples"] | 0);
+    TEST_ASSERT_EQUAL_STRING("1999-01-01_00:10:00", summary["window_end"] | "");
+    TEST_ASSERT_TRUE(exists(ambientPath("002000")));
+}
+
+// The byte cap archives the oldest pending files until the total fits
+void test_byte_cap_archives_oldest_first() {
+    TEST_ASSERT_TRUE(testSd.writeTextFile(ambientPath("020000"), ambientJson("02:00:00", 100, 20.0f)));
+    TEST_ASSERT_TRUE(testSd.writeTextFile(ambientPath("020100"), ambientJson("02:01:00", 100, 20.0f)));
+    TEST_ASSERT_TRUE(testSd.writeTextFile(thermalPath("020200"), "{\"temperatures\":[]}"));
+
+    uint64_t total = BacklogPolicyAccess::pendingBytes(testSd);
+    TEST_ASSERT_EQUAL_INT(0, BacklogPolicyAccess::cap(testSd, total));
+
+    // One byte over the cap: only the oldest file (first fixture) has to go
+    TEST_ASSERT_EQUAL_INT(1, BacklogPolicyAccess::cap(testSd, total - 1));
+    TEST_ASSERT_TRUE(exists(archived(ambientPath("020000"))));
+    TEST_ASSERT_TRUE(exists(ambientPath("020100")));
+    TEST_ASSERT_TRUE(exists(thermalPath("020200")));
+    TEST_ASSERT_TRUE(BacklogPolicyAccess::pendingBytes(testSd) < total);
+}
+
+// Setup function: runs once at the beginning
+void setup() {
+    // Wait for the serial monitor to connect
+    delay(2000);
+
+    sdReady = testSd.begin();
+    if (sdReady) {
+        cutoff = BacklogPolicyAccess::parseName(testSd, BP_CUTOFF_NAME);
+        tearDown(); // Leftovers from an interrupted run
+    }
+
+    // Begin the Unity test framework
+    UNITY_BEGIN();
+    RUN_TEST(test_thin_keeps_one_capture_per_interval);
+    RUN_TEST(test_summarize_averages_and_skips_corrupt);
+    RUN_TEST(test_byte_cap_archives_oldest_first);
+    // End the Unity test framework and report results
+    UNITY_END();
+}
+
+// Loop function: runs repeatedly after setup (empty for tests)
+void loop() {}
@@ -0,0 +1,131 @@
+// Minimal benchmark harness shared by the benchmark suite.
+// Timing uses the CPU cycle counter on the ESP32 and std::chrono on a host build,
+// so the harness itself has no Arduino dependency.
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm> // std::sort (for the p95)
+
+#ifdef ARDUINO
+    #include <Arduino.h>
+    #include <esp_heap_caps.h>
+    #include <esp_cpu.h>
+#else
+    #include <chrono>
+#endif
+
+// Maximum number of timed iterations kept for the percentile calculation
+#define BENCH_MAX_ITERATIONS 200
+// Untimed iterations run first (caches, lazy allocations, TLS buffers...)
+#define BENCH_WARMUP_ITERATIONS 3
+// Prefix of every result line. tools/bench_compare.py only reads these lines.
+#define BENCH_JSON_PREFIX "BENCH_JSON "
+
+// Result of a single benchmark
+struct BenchResult {
+    const char* name;
+    uint32_t iterations;
+    double meanUs;
+    double p95Us;
+    double minUs;
+    double maxUs;
+    long heapDeltaInternal; // Bytes still allocated after the timed iterations (internal RAM)
+    long heapDeltaPsram;    // Same, for PSRAM
+};
+
+namespace bench {
+
+// Current time in timer ticks (CPU cycles on the device, nanoseconds on the host)
+inline uint32_t ticks() {
+#ifdef ARDUINO
+    return esp_cpu_get_cycle_count();
+#else
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Timer ticks per microsecond
+inline double ticksPerUs() {
+#ifdef ARDUINO
+    return (double)getCpuFrequencyMhz();
+#else
+    return 1000.0;
+#endif
+}
+
+inline long freeInternal() {
+#ifdef ARDUINO
+    return (long)heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+#else
+    return 0;
+#endif
+}
+
+inline long freePsram() {
+#ifdef ARDUINO
+    return (long)heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+#else
+    return 0;
+#endif
+}
+
+// Prints one result as a single JSON line
+inline void printResult(const BenchResult& r) {
+    char line[256];
+    snprintf(line, sizeof(line),
+             BENCH_JSON_PREFIX "{\"name\":\"%s\",\"iterations\":%u,\"mean_us\":%.2f,\"p95_us\":%.2f,"
+             "\"min_us\":%.2f,\"max_us\":%.2f,\"heap_delta_internal\":%ld,\"heap_delta_psram\":%ld}",
+             r.name, (unsigned)r.iterations, r.meanUs, r.p95Us, r.minUs, r.maxUs,
+             r.heapDeltaInternal, r.heapDeltaPsram);
+#ifdef ARDUINO
+    Serial.println(line);
+#else
+    puts(line);
+#endif
+}
+
+// Runs 'fn' 'iterations' times (after a warm-up) and prints the result.
+// Note: a 32-bit cycle counter wraps after ~17 s at 240 MHz, far above any single iteration.
+template<typename Fn>
+BenchResult run(const char* name, uint32_t iterations, Fn fn) {
+    if (iterations > BENCH_MAX_ITERATIONS) iterations = BENCH_MAX_ITERATIONS;
+    if (iterations == 0) iterations = 1;
+
+    for (uint32_t i = 0; i < BENCH_WARMUP_ITERATIONS; i++) {
+        fn();
+    }
+
+    static uint32_t samples[BENCH_MAX_ITERATIONS];
+    long internalBefore = freeInternal();
+    long psramBefore = freePsram();
+
+    for (uint32_t i = 0; i < iterations; i++) {
+        uint32_t start = ticks();
+        fn();
+        samples[i] = ticks() - start;
+    }
+
+    BenchResult r;
+    r.name = name;
+    r.iterations = iterations;
+    r.heapDeltaInternal = internalBefore - freeInternal();
+    r.heapDeltaPsram = psramBefore - freePsram();
+
+    double sum = 0;
+    for (uint32_t i = 0; i < iterations; i++) sum += samples[i];
+    std::sort(samples, samples + iterations);
+
+    double scale = ticksPerUs();
+    uint32_t p95Index = (uint32_t)((iterations - 1) * 95 / 100);
+    r.meanUs = sum / iterations / scale;
+    r.p95Us = samples[p95Index] / scale;
+    r.minUs = samples[0] / scale;
+    r.maxUs = samples[iterations - 1] / scale;
+
+    printResult(r);
+    return r;
+}
+
+} // namespace bench
@@ -0,0 +1,383 @@
+// Microbenchmarks for the firmware hot paths.
+// Each test prints one "BENCH_JSON {...}" line (mean/p95/min/max in microseconds and
+// heap deltas). Capture the output and compare it against the committed baseline:
+//   pio test -e freenove_esp32_s3_wroom -f test_benchmarks -v > bench.log
+//   python3 tools/bench_compare.py bench.log
+// The tests only assert that each operation still produces a valid result; timing
+// regressions are judged by tools/bench_compare.py, not by Unity.
+
+// Include necessary libraries
+#include <Arduino.h>        // Arduino core framework
+#include <unity.h>          // Unity test framework
+#include <SD_MMC.h>         // Direct file reads for the SD benchmarks
+#include "esp_random.h"
+#include "img_converters.h" // fmt2jpg: encodes the synthetic vegetation frame
+
+#include "API.h"
+#include "MultipartDataSender.h"
+#include "SDManager.h"
+#include "TimeManager.h"
+#include "EventLog.h"
+#include "VegetationIndex.h"
+#include "bench_harness.h"
+
+// Iterations per benchmark (kept low for the slow SD and crypto paths)
+#define FAST_ITERATIONS 100
+#define SLOW_ITERATIONS 20
+#define STREAM_ITERATIONS 5   // Sustained SD writes (256 KB each)
+
+// Sizes matching real cycle payloads
+#define THERMAL_PIXELS 768
+#define BENCH_JPEG_SIZE (32 * 1024)   // Typical OV2640 JPEG at the configured quality
+#define BENCH_TEXT_SIZE 1024          // Typical pending ambient JSON / log chunk
+#define BENCH_SD_TEXT_PATH "/bench_text.txt"
+#define BENCH_SD_BIN_PATH "/bench_bin.bin"
+#define BENCH_SD_STREAM_PATH "/bench_stream.bin"
+#define BENCH_STREAM_BYTES (256 * 1024)  // Bytes written per sustained-write iteration
+#define BENCH_LOG_LINE_SIZE 120          // Typical log line / migrated hot-tier record
+#define BENCH_VGA_WIDTH 640              // OV2640 frame size (FRAMESIZE_VGA)
+#define BENCH_VGA_HEIGHT 480
+
+// Grants access to the private helpers that are part of the measured hot paths
+// (declared as friend in SDManager, MultipartDataSender and API).
+struct BenchmarkAccess {
+    static float* parseThermalJson(SDManager& sd, const String& json) {
+        return sd.parseThermalJson(json);
+    }
+    static std::vector<uint8_t> buildMultipartPayload(const String& boundary, const String& json, uint8_t* jpeg, size_t jpegLength) {
+        return MultipartDataSender::buildMultipartPayload(boundary, json, jpeg, jpegLength);
+    }
+    static String formatLogLine(SDManager& sd, const String& timestamp, LogLevel level, const String& message, float internalTemp) {
+        return sd.formatLogLine(timestamp, level, message, internalTemp);
+    }
+    static bool encryptApiState(const uint8_t* key, const String& plain, String& encoded) {
+        return API::_encryptState(key, plain, encoded);
+    }
+    static int decryptApiState(const uint8_t* key, const String& encoded, String& plain) {
+        return API::_decryptState(key, encoded, plain);
+    }
+};
+
+// --- Shared fixtures ---
+static float thermalFrame[THERMAL_PIXELS];
+static uint8_t* jpegFixture = nullptr;
+static String thermalJsonFixture;
+static SDManager benchSd;
+static bool sdReady = false;
+static TimeManager benchTime;
+static uint8_t* vegetationJpeg = nullptr; // VGA JPEG: left half canopy, right half soil
+static size_t vegetationJpegLength = 0;
+
+// Fills the thermal frame with a deterministic 15-35 C pattern and a few NaN pixels
+static void fillThermalFrame() {
+    for (int i = 0; i < THERMAL_PIXELS; i++) {
+        thermalFrame[i] = 15.0f + (float)((i * 37) % 200) / 10.0f;
+    }
+    thermalFrame[10] = NAN;
+    thermalFrame[500] = NAN;
+}
+
+// Encodes a VGA frame with canopy green on the left half and bare soil on the right half.
+// R and B are equal in both colors, so the channel order used by fmt2jpg does not matter.
+static void buildVegetationJpeg() {
+    size_t frameSize = (size_t)BENCH_VGA_WIDTH * BENCH_VGA_HEIGHT * 3;
+    uint8_t* frame = (uint8_t*)ps_malloc(frameSize);
+    if (!frame) return;
+    for (size_t i = 0; i < (size_t)BENCH_VGA_WIDTH * BENCH_VGA_HEIGHT; i++) {
+        bool canopy = (i % BENCH_VGA_WIDTH) < BENCH_VGA_WIDTH / 2;
+        frame[3 * i] = canopy ? 50 : 110;
+        frame[3 * i + 1] = canopy ? 150 : 90;
+        frame[3 * i + 2] = canopy ? 50 : 110;
+    }
+    if (!fmt2jpg(frame, frameSize, BENCH_VGA_WIDTH, BENCH_VGA_HEIGHT, PIXFORMAT_RGB888, 80, &vegetationJpeg, &vegetationJpegLength)) {
+        vegetationJpeg = nullptr;
+        vegetationJpegLength = 0;
+    }
+    free(frame);
+}
+
+// Builds a String of 'count' copies of 'c' (Arduino String has no fill constructor)
+static String repeatChar(char c, size_t count) {
+    String out;
+    out.reserve(count);
+    for (size_t i = 0; i < count; i++) out += c;
+    return out;
+}
+
+// setUp function: runs before each test (currently empty)
+void setUp(void) {}
+// tearDown function: runs after each test (currently empty)
+void tearDown(void) {}
+
+// Thermal statistics (max/min/average over the 768 pixels)
+void bench_thermal_stats() {
+    volatile float sink = 0;
+    bench::run("thermal_stats", FAST_ITERATIONS, [&]() {
+        sink = MultipartDataSender::calculateMaxTemperature(thermalFrame)
+             + MultipartDataSender::calculateMinTemperature(thermalFrame)
+             + MultipartDataSender::calculateAverageTemperature(thermalFrame);
+    });
+    TEST_ASSERT_FALSE(isnan(sink));
+}
+
+// Thermal JSON serialization (stats + 768 temperatures)
+void bench_create_thermal_json() {
+    size_t length = 0;
+    bench::run("create_thermal_json", SLOW_ITERATIONS, [&]() {
+        String json = MultipartDataSender::createThermalJson("2025-10-31T12:00:00", thermalFrame);
+        length = json.length();
+    });
+    TEST_ASSERT_GREATER_THAN_UINT32(0, length);
+}
+
+// Thermal JSON parsing (pending queue path)
+void bench_parse_thermal_json() {
+    bool ok = true;
+    bench::run("parse_thermal_json", SLOW_ITERATIONS, [&]() {
+        float* parsed = BenchmarkAccess::parseThermalJson(benchSd, thermalJsonFixture);
+        ok = ok && parsed != nullptr;
+        free(parsed);
+    });
+    TEST_ASSERT_TRUE_MESSAGE(ok, "parseThermalJson failed on the fixture");
+}
+
+// Multipart payload assembly (thermal JSON + 32 KB JPEG)
+void bench_build_multipart_payload() {
+    TEST_ASSERT_NOT_NULL_MESSAGE(jpegFixture, "JPEG fixture allocation failed");
+    size_t payloadSize = 0;
+    bench::run("build_multipart_payload", SLOW_ITERATIONS, [&]() {
+        std::vector<uint8_t> payload = BenchmarkAccess::buildMultipartPayload(
+            "----ArandanoBenchBoundary", thermalJsonFixture, jpegFixture, BENCH_JPEG_SIZE);
+        payloadSize = payload.size();
+    });
+    TEST_ASSERT_GREATER_THAN_UINT32(BENCH_JPEG_SIZE, payloadSize);
+}
+
+// 1/8-scale (DC-only) JPEG decode plus vegetation indices, as run after each visual capture
+void bench_vegetation_decode() {
+    TEST_ASSERT_NOT_NULL_MESSAGE(vegetationJpeg, "Vegetation JPEG fixture encoding failed");
+    VegetationAnalyzer analyzer;
+    VegetationStats stats;
+    bool ok = true;
+    bench::run("vegetation_decode", SLOW_ITERATIONS, [&]() {
+        ok = analyzer.analyze(vegetationJpeg, vegetationJpegLength, stats) && ok;
+    });
+    TEST_ASSERT_TRUE_MESSAGE(ok, "1/8 JPEG decode failed");
+    Serial.printf("[Bench] vegetation %ux%u: decode %lu us, compute %lu us, canopy %.3f, ExG %.3f, ExGR %.3f\n",
+                  stats.width, stats.height, (unsigned long)stats.decodeUs, (unsigned long)stats.computeUs,
+                  stats.canopyFraction, stats.exg, stats.exgr);
+    TEST_ASSERT_EQUAL_UINT16(BENCH_VGA_WIDTH / 8, stats.width);
+    TEST_ASSERT_EQUAL_UINT16(BENCH_VGA_HEIGHT / 8, stats.height);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 0.5f, stats.canopyFraction);
+    TEST_ASSERT_NOT_NULL(analyzer.mask());
+}
+
+// Vegetation kernel alone over an 80x60 frame (the decode output size)
+void bench_vegetation_kernel() {
+    static uint8_t rgb[(BENCH_VGA_WIDTH / 8) * (BENCH_VGA_HEIGHT / 8) * 3];
+    static uint8_t mask[(BENCH_VGA_WIDTH / 8) * (BENCH_VGA_HEIGHT / 8)];
+    esp_fill_random(rgb, sizeof(rgb));
+    VegetationStats stats;
+    bench::run("vegetation_kernel", FAST_ITERATIONS, [&]() {
+        computeVegetationIndices(rgb, sizeof(mask), stats, mask);
+    });
+    TEST_ASSERT_FALSE(isnan(stats.canopyFraction));
+}
+
+// API state encryption (AES-256-GCM + Base64) through the helpers used by API::_saveCurrentApiStateToSd
+// and API::_loadPersistentData
+void bench_api_state_encrypt_decrypt() {
+    uint8_t key[API_AES_KEY_SIZE];
+    esp_fill_random(key, sizeof(key));
+    String plain = "{\"accessToken\":\"" + repeatChar('a', 300) + "\",\"refreshToken\":\"" + repeatChar('b', 200) +
+                   "\",\"dataCollectionTime\":30,\"isActivated\":true}";
+    String encoded;
+    bool encrypted = true;
+
+    bench::run("api_state_encrypt", SLOW_ITERATIONS, [&]() {
+        encrypted = BenchmarkAccess::encryptApiState(key, plain, encoded) && encrypted;
+    });
+    TEST_ASSERT_TRUE_MESSAGE(encrypted, "API state encryption failed");
+
+    String decrypted;
+    int decryptResult = -1;
+    bench::run("api_state_decrypt", SLOW_ITERATIONS, [&]() {
+        decryptResult = BenchmarkAccess::decryptApiState(key, encoded, decrypted);
+    });
+    TEST_ASSERT_EQUAL_INT_MESSAGE(0, decryptResult, "GCM round trip failed");
+    TEST_ASSERT_EQUAL_STRING(plain.c_str(), decrypted.c_str());
+}
+
+// Timestamp formatting (called for every log line and file name)
+void bench_timestamp_format() {
+    size_t length = 0;
+    bench::run("timestamp_format", FAST_ITERATIONS, [&]() {
+        length = benchTime.getCurrentTimestampString().length();
+    });
+    TEST_ASSERT_GREATER_THAN_UINT32(0, length);
+}
+
+// Log formatting: text line (SDManager::logToFile) vs binary EventLog frame
+void bench_log_format() {
+    String fileName = "20251031_120000_thermal.json";
+    size_t textLength = 0;
+    bench::run("log_format_text", FAST_ITERATIONS, [&]() {
+        String entry = BenchmarkAccess::formatLogLine(benchSd, "2025-10-31T12:00:00", LogLevel::WARNING,
+                                                      "Failed send pending ambient: " + fileName + ". HTTP: " + String(-11), 31.4f);
+        textLength = entry.length();
+    });
+    TEST_ASSERT_GREATER_THAN_UINT32(0, textLength);
+
+    EventFrameWriter frame;
+    bench::run("log_encode_binary", FAST_ITERATIONS, [&]() {
+        frame = EventFrameWriter();
+        frame.putVarint(43200);                                                      // Seconds of day
+        frame.putVarint(((uint32_t)EventId::PENDING_AMBIENT_SEND_FAILED << 2) | 2);  // ID + hasTemp
+        frame.putSigned(314);                                                        // DevTemp * 10
+        frame.putArgs(fileName, -11);
+    });
+    TEST_ASSERT_FALSE(frame.overflow());
+
+    char line[192];
+    size_t decoded = 0;
+    bench::run("log_decode_binary", FAST_ITERATIONS, [&]() {
+        decoded = EventLog::formatPayload(frame.data(), frame.length(), "20251031", line, sizeof(line));
+    });
+    TEST_ASSERT_GREATER_THAN_UINT32(0, decoded);
+}
+
+// SD write/read primitives (skipped when no card is inserted)
+void bench_sd_write_read() {
+    if (!sdReady) {
+        TEST_IGNORE_MESSAGE("SD card not available");
+        return;
+    }
+
+    String text = repeatChar('x', BENCH_TEXT_SIZE);
+    bool ok = true;
+    bench::run("sd_write_text_1k", SLOW_ITERATIONS, [&]() {
+        ok = benchSd.writeTextFile(BENCH_SD_TEXT_PATH, text) && ok;
+    });
+    bench::run("sd_write_binary_32k", SLOW_ITERATIONS, [&]() {
+        ok = benchSd.writeBinaryFile(BENCH_SD_BIN_PATH, jpegFixture, BENCH_JPEG_SIZE) && ok;
+    });
+    TEST_ASSERT_TRUE_MESSAGE(ok, "SD write failed");
+
+    size_t bytesRead = 0;
+    bench::run("sd_read_binary_32k", SLOW_ITERATIONS, [&]() {
+        File f = SD_MMC.open(BENCH_SD_BIN_PATH, FILE_READ);
+        bytesRead = f && f.seek(RECORD_HEADER_LEN) ? f.read(jpegFixture, BENCH_JPEG_SIZE) : 0; // Payload only
+        f.close();
+    });
+    TEST_ASSERT_EQUAL_UINT32(BENCH_JPEG_SIZE, bytesRead);
+
+    benchSd.deleteFile(BENCH_SD_TEXT_PATH);
+    benchSd.deleteFile(BENCH_SD_BIN_PATH);
+}
+
+// Sustained SD write throughput, plain File vs ClusterWriter, for the two write patterns of the
+// firmware: many small appends (logs) and whole JPEGs from PSRAM. Prints MB/s and amplification.
+void bench_sd_sustained_write() {
+    if (!sdReady || !jpegFixture) {
+        TEST_IGNORE_MESSAGE("SD card not available");
+        return;
+    }
+    const String vfsPath = String(SD_MOUNT_POINT) + BENCH_SD_STREAM_PATH;
+    const size_t chunk = benchSd.getClusterSize() > 0 ? benchSd.getClusterSize() : CLUSTER_WRITER_DEFAULT_CHUNK;
+    bool ok = true;
+    ClusterWriterStats logStats;
+    ClusterWriterStats jpegStats;
+
+    BenchResult logPlain = bench::run("sd_stream_log_plain", STREAM_ITERATIONS, [&]() {
+        File f = SD_MMC.open(BENCH_SD_STREAM_PATH, FILE_WRITE);
+        for (size_t done = 0; f && done < BENCH_STREAM_BYTES; done += BENCH_LOG_LINE_SIZE) {
+            ok = f.write(jpegFixture + done % BENCH_JPEG_SIZE, BENCH_LOG_LINE_SIZE) == BENCH_LOG_LINE_SIZE && ok;
+        }
+        if (f) f.close();
+        else ok = false;
+    });
+    BenchResult logClustered = bench::run("sd_stream_log_clustered", STREAM_ITERATIONS, [&]() {
+        ClusterWriter writer(chunk);
+        ok = writer.open(vfsPath.c_str(), false, 0, CLUSTER_WRITER_LOG_GROW_STEP) && ok;
+        for (size_t done = 0; writer.isOpen() && done < BENCH_STREAM_BYTES; done += BENCH_LOG_LINE_SIZE) {
+            ok = writer.write(jpegFixture + done % BENCH_JPEG_SIZE, BENCH_LOG_LINE_SIZE) == BENCH_LOG_LINE_SIZE && ok;
+        }
+        ok = writer.close() && ok;
+        logStats = writer.stats();
+    });
+
+    BenchResult jpegPlain = bench::run("sd_stream_jpeg_plain", STREAM_ITERATIONS, [&]() {
+        File f = SD_MMC.open(BENCH_SD_STREAM_PATH, FILE_WRITE);
+        for (size_t done = 0; f && done < BENCH_STREAM_BYTES; done += BENCH_JPEG_SIZE) {
+            ok = f.write(jpegFixture, BENCH_JPEG_SIZE) == BENCH_JPEG_SIZE && ok;
+        }
+        if (f) f.close();
+        else ok = false;
+    });
+    BenchResult jpegClustered = bench::run("sd_stream_jpeg_clustered", STREAM_ITERATIONS, [&]() {
+        ClusterWriter writer(chunk);
+        ok = writer.open(vfsPath.c_str(), false, BENCH_STREAM_BYTES) && ok;
+        for (size_t done = 0; writer.isOpen() && done < BENCH_STREAM_BYTES; done += BENCH_JPEG_SIZE) {
+            ok = writer.write(jpegFixture, BENCH_JPEG_SIZE) == BENCH_JPEG_SIZE && ok;
+        }
+        ok = writer.close() && ok;
+        jpegStats = writer.stats();
+    });
+    TEST_ASSERT_TRUE_MESSAGE(ok, "SD stream write failed");
+
+    // Amplification if every log line reached the FS as its own write (open/append/close per line)
+    ClusterWriterStats perLine;
+    for (size_t done = 0; done < BENCH_STREAM_BYTES; done += BENCH_LOG_LINE_SIZE) {
+        perLine.payloadBytes += BENCH_LOG_LINE_SIZE;
+        perLine.deviceBytes += ClusterWriterStats::sectorSpan(done, BENCH_LOG_LINE_SIZE);
+    }
+    // Bytes per microsecond == MB/s
+    Serial.printf("[Bench] cluster %u B | log: plain %.2f MB/s, clustered %.2f MB/s, amplification %.3f (per-line %.3f) | "
+                  "jpeg: plain %.2f MB/s, clustered %.2f MB/s, amplification %.3f\n",
+                  (unsigned)chunk, BENCH_STREAM_BYTES / logPlain.meanUs, BENCH_STREAM_BYTES / logClustered.meanUs,
+                  logStats.amplification(), perLine.amplification(),
+                  BENCH_STREAM_BYTES / jpegPlain.meanUs, BENCH_STREAM_BYTES / jpegClustered.meanUs, jpegStats.amplification());
+    TEST_ASSERT_LESS_THAN_FLOAT(1.01f, logStats.amplification());
+
+    benchSd.deleteFile(BENCH_SD_STREAM_PATH);
+}
+
+// Setup function: runs once at the beginning
+void setup() {
+    // Results are printed on the serial port
+    Serial.begin(115200);
+    // Initial delay
+    delay(2000);
+
+    // Prepare the fixtures
+    fillThermalFrame();
+    thermalJsonFixture = MultipartDataSender::createThermalJson("2025-10-31T12:00:00", thermalFrame);
+    jpegFixture = (uint8_t*)ps_malloc(BENCH_JPEG_SIZE);
+    if (jpegFixture) {
+        esp_fill_random(jpegFixture, BENCH_JPEG_SIZE);
+    }
+    buildVegetationJpeg();
+    sdReady = benchSd.begin();
+
+    // Begin the Unity test framework
+    UNITY_BEGIN();
+    RUN_TEST(bench_thermal_stats);
+    RUN_TEST(bench_create_thermal_json);
+    RUN_TEST(bench_parse_thermal_json);
+    RUN_TEST(bench_build_multipart_payload);
+    RUN_TEST(bench_vegetation_decode);
+    RUN_TEST(bench_vegetation_kernel);
+    RUN_TEST(bench_api_state_encrypt_decrypt);
+    RUN_TEST(bench_timestamp_format);
+    RUN_TEST(bench_log_format);
+    RUN_TEST(bench_sd_write_read);
+    RUN_TEST(bench_sd_sustained_write);
+    // End the Unity test framework
+    UNITY_END();
+
+    free(jpegFixture);
+    free(vegetationJpeg);
+}
+
+// Loop function: runs repeatedly after setup (empty for tests)
+void loop() {}
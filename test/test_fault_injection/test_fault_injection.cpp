@@ -0,0 +1,377 @@
+// Fault injection tests.
+// The schedule tests (nth, probability, latency, config parsing) only need the library.
+// The recovery scenarios drive the real SD and MLX90640 shims, so they need the firmware
+// built with -D ENABLE_FAULT_INJECTION (add it to build_flags) and the hardware present;
+// otherwise they are reported as IGNORED. The record framing/recovery tests only need the SD card.
+
+// Include necessary libraries
+#include <Arduino.h>         // Arduino core framework
+#include <unity.h>           // Unity test framework
+#include <Wire.h>            // I2C bus for the MLX90640
+#include "FaultInjection.h"  // Fault schedules under test
+#include "SDManager.h"       // SD shims (open / partial write / rename)
+#include "MLX90640Sensor.h"  // I2C shim (getFrame)
+#include "TimeManager.h"     // Needed by SDManager::checkCardHealth (event logs)
+
+// Define I2C pins (same as the main code)
+#define SDA_PIN 47
+#define SCL_PIN 21
+
+// Scratch directory for the SD scenarios (removed at the end)
+#define FI_TEST_DIR "/fi_test"
+// Files written in the data-loss scenario
+#define FI_FILE_COUNT 20
+// Upper bound for a sensor to be usable again after an injected I2C fault
+#define MAX_I2C_RECOVERY_MS 2000
+
+// --- Shared fixtures ---
+TwoWire testWire(0);
+MLX90640Sensor testMlxSensor(testWire);
+SDManager testSd;
+TimeManager testTime;
+bool sdReady = false;
+bool mlxInitialized = false;
+
+// Drives SDManager's health check until the card is mounted again (or the remount budget runs out)
+static bool waitForRemount() {
+    unsigned long start = millis();
+    while (!testSd.isSDAvailable() && millis() - start < 3 * SD_REMOUNT_BACKOFF_MIN_MS) {
+        testSd.checkCardHealth(testTime);
+        delay(100);
+    }
+    return testSd.isSDAvailable();
+}
+
+// Calls shouldFail() 'calls' times and stores the outcome of each call
+static void recordSequence(FaultPoint point, bool* out, int calls) {
+    for (int i = 0; i < calls; i++) {
+        out[i] = FaultInjection::shouldFail(point);
+    }
+}
+
+// setUp function: runs before each test (every test starts without faults)
+void setUp(void) {
+    FaultInjection::seed(1234);
+    FaultInjection::clearAll();
+}
+// tearDown function: runs after each test (no fault must leak into the next test)
+void tearDown(void) {
+    FaultInjection::clearAll();
+}
+
+// "Fail the Nth call" fails exactly calls N..N+count-1
+void test_fail_nth_is_exact() {
+    FaultSchedule schedule;
+    schedule.failNth = 3;
+    schedule.failCount = 2;
+    FaultInjection::configure(FaultPoint::SD_RENAME, schedule);
+
+    bool outcome[8];
+    recordSequence(FaultPoint::SD_RENAME, outcome, 8);
+    for (int i = 0; i < 8; i++) {
+        bool expected = (i == 2 || i == 3); // Calls 3 and 4 (1-based)
+        TEST_ASSERT_EQUAL_MESSAGE(expected, outcome[i], "Unexpected outcome for a failNth schedule");
+    }
+    TEST_ASSERT_EQUAL_UINT32(8, FaultInjection::callCount(FaultPoint::SD_RENAME));
+    TEST_ASSERT_EQUAL_UINT32(2, FaultInjection::failureCount(FaultPoint::SD_RENAME));
+}
+
+// The same seed gives the same failure sequence; the rate stays close to p
+void test_probability_is_seeded_and_bounded() {
+    FaultSchedule schedule;
+    schedule.probability = 0.25f;
+    static bool first[1000];
+    static bool second[1000];
+
+    FaultInjection::configure(FaultPoint::HTTP_REQUEST, schedule);
+    recordSequence(FaultPoint::HTTP_REQUEST, first, 1000);
+    uint32_t failures = FaultInjection::failureCount(FaultPoint::HTTP_REQUEST);
+
+    // Querying another point must not change the sequence of this one
+    FaultInjection::seed(1234);
+    FaultInjection::configure(FaultPoint::SD_OPEN, schedule);
+    FaultInjection::shouldFail(FaultPoint::SD_OPEN);
+    recordSequence(FaultPoint::HTTP_REQUEST, second, 1000);
+
+    TEST_ASSERT_EQUAL_MEMORY_MESSAGE(first, second, sizeof(first), "Same seed produced a different sequence");
+    // 1000 Bernoulli(0.25) trials: mean 250, sd ~13.7 -> +-5 sd
+    TEST_ASSERT_UINT32_WITHIN(70, 250, failures);
+}
+
+// Added latency is applied to every call, failing or not
+void test_latency_is_applied() {
+    FaultSchedule schedule;
+    schedule.latencyMs = 50;
+    FaultInjection::configure(FaultPoint::HTTP_REQUEST, schedule);
+
+    unsigned long start = millis();
+    bool failed = FaultInjection::shouldFail(FaultPoint::HTTP_REQUEST);
+    unsigned long elapsed = millis() - start;
+
+    TEST_ASSERT_FALSE_MESSAGE(failed, "A latency-only schedule must not fail");
+    TEST_ASSERT_UINT32_WITHIN(10, 55, elapsed); // 50 ms (+ up to one tick of jitter)
+}
+
+// Schedules from config.json: valid specs apply, invalid ones apply nothing
+void test_configure_from_string() {
+    TEST_ASSERT_EQUAL_INT(2, FaultInjection::configureFromString("SD_RENAME:nth=2;I2C_MLX_FRAME:nth=1,count=3"));
+    TEST_ASSERT_FALSE(FaultInjection::shouldFail(FaultPoint::SD_RENAME));
+    TEST_ASSERT_TRUE(FaultInjection::shouldFail(FaultPoint::SD_RENAME));
+
+    FaultInjection::clearAll();
+    TEST_ASSERT_EQUAL_INT(-1, FaultInjection::configureFromString("SD_RENAME:nth=2;UNKNOWN_POINT:nth=1"));
+    TEST_ASSERT_EQUAL_INT(-1, FaultInjection::configureFromString("HTTP_REQUEST:p=abc"));
+    TEST_ASSERT_FALSE_MESSAGE(FaultInjection::shouldFail(FaultPoint::SD_RENAME), "Invalid spec was partially applied");
+    TEST_ASSERT_EQUAL_INT(0, FaultInjection::configureFromString(""));
+}
+
+// Data-loss bound: with injected open/partial-write faults, every write reported as
+// successful reads back intact, and the files lost are at most the writes reported as failed
+void test_sd_write_faults_bounded_loss() {
+#ifndef ENABLE_FAULT_INJECTION
+    TEST_IGNORE_MESSAGE("Build with -D ENABLE_FAULT_INJECTION to run the SD scenarios");
+#else
+    if (!sdReady) {
+        TEST_IGNORE_MESSAGE("SD card not available");
+        return;
+    }
+    FaultInjection::configureFromString("SD_OPEN:p=0.15;SD_WRITE_PARTIAL:nth=4,count=3");
+
+    uint8_t payload[512];
+    for (size_t i = 0; i < sizeof(payload); i++) payload[i] = (uint8_t)(i * 7);
+
+    bool reported[FI_FILE_COUNT];
+    int reportedFailures = 0;
+    for (int i = 0; i < FI_FILE_COUNT; i++) {
+        String path = String(FI_TEST_DIR) + "/f" + String(i) + ".bin";
+        reported[i] = testSd.writeBinaryFile(path, payload, sizeof(payload));
+        if (!reported[i]) reportedFailures++;
+    }
+    FaultInjection::clearAll();
+
+    // Three partial writes in a row look like a failing card: SDManager unmounts it and keeps
+    // later writes in PSRAM until the remount flushes them
+    TEST_ASSERT_TRUE_MESSAGE(waitForRemount(), "SD card was not remounted after the injected faults");
+
+    int intact = 0;
+    for (int i = 0; i < FI_FILE_COUNT; i++) {
+        String path = String(FI_TEST_DIR) + "/f" + String(i) + ".bin";
+        size_t length = 0;
+        uint8_t* readBack = testSd.readRecordBinary(path, length);
+        bool ok = readBack && length == sizeof(payload) && memcmp(readBack, payload, sizeof(payload)) == 0;
+        free(readBack);
+        if (reported[i]) {
+            TEST_ASSERT_TRUE_MESSAGE(ok, "A write reported as successful is missing or corrupt (silent loss)");
+        }
+        if (ok) intact++;
+    }
+    TEST_ASSERT_GREATER_OR_EQUAL_INT(2, reportedFailures); // The partial write that unmounts the card is kept in PSRAM
+    TEST_ASSERT_GREATER_OR_EQUAL_INT(FI_FILE_COUNT - reportedFailures, intact);
+#endif
+}
+
+// A failed rename keeps the source file (nothing lost) and the next attempt succeeds
+void test_sd_rename_fault_recovers() {
+#ifndef ENABLE_FAULT_INJECTION
+    TEST_IGNORE_MESSAGE("Build with -D ENABLE_FAULT_INJECTION to run the SD scenarios");
+#else
+    if (!sdReady) {
+        TEST_IGNORE_MESSAGE("SD card not available");
+        return;
+    }
+    String src = String(FI_TEST_DIR) + "/move_src.txt";
+    String dest = String(FI_TEST_DIR) + "/moved/move_dest.txt";
+    TEST_ASSERT_TRUE(testSd.writeTextFile(src, "pending data"));
+
+    FaultInjection::configureFromString("SD_RENAME:nth=1");
+    TEST_ASSERT_FALSE_MESSAGE(testSd.moveFile(src, dest), "Injected rename fault was not reported");
+    TEST_ASSERT_TRUE_MESSAGE(SD_MMC.exists(src.c_str()), "Source lost after a failed rename");
+
+    // Recovery: the retry (next cycle in the firmware) moves the file
+    TEST_ASSERT_TRUE(testSd.moveFile(src, dest));
+    TEST_ASSERT_TRUE(SD_MMC.exists(dest.c_str()));
+    TEST_ASSERT_FALSE(SD_MMC.exists(src.c_str()));
+    testSd.deleteFile(dest.c_str());
+#endif
+}
+
+// Consecutive open failures unmount the card; the write that trips it is buffered in PSRAM
+// and reaches the SD after the automatic remount (recovery time is printed)
+void test_sd_unmount_and_remount() {
+#ifndef ENABLE_FAULT_INJECTION
+    TEST_IGNORE_MESSAGE("Build with -D ENABLE_FAULT_INJECTION to run the SD scenarios");
+#else
+    if (!sdReady) {
+        TEST_IGNORE_MESSAGE("SD card not available");
+        return;
+    }
+    SDHealthStats before = testSd.getHealthStats();
+    String path = String(FI_TEST_DIR) + "/remount.txt";
+
+    FaultInjection::configureFromString((String("SD_OPEN:nth=1,count=") + String(SD_HEALTH_FAIL_THRESHOLD)).c_str());
+    for (int i = 1; i < SD_HEALTH_FAIL_THRESHOLD; i++) {
+        TEST_ASSERT_FALSE(testSd.writeTextFile(path, "lost"));
+    }
+    TEST_ASSERT_TRUE_MESSAGE(testSd.writeTextFile(path, "kept in PSRAM"), "Write that unmounted the card was not buffered");
+    TEST_ASSERT_FALSE(testSd.isSDAvailable());
+    FaultInjection::clearAll();
+
+    unsigned long start = millis();
+    TEST_ASSERT_TRUE_MESSAGE(waitForRemount(), "SD card was not remounted");
+    Serial.printf("[FaultInjection] SD remount latency: %lu ms\n", millis() - start);
+
+    SDHealthStats after = testSd.getHealthStats();
+    TEST_ASSERT_EQUAL_UINT32(before.unmounts + 1, after.unmounts);
+    TEST_ASSERT_EQUAL_UINT32(before.remounts + 1, after.remounts);
+    TEST_ASSERT_EQUAL_UINT32(0, after.bufferedWrites);
+
+    String content;
+    TEST_ASSERT_TRUE_MESSAGE(testSd.readRecordText(path, content), "Buffered write missing after remount");
+    TEST_ASSERT_EQUAL_STRING("kept in PSRAM", content.c_str());
+    testSd.deleteFile(path.c_str());
+#endif
+}
+
+// Writes raw bytes to the SD, bypassing SDManager (simulates what a power cut leaves behind)
+static bool writeRaw(const String& path, const uint8_t* data, size_t length) {
+    File f = SD_MMC.open(path.c_str(), FILE_WRITE);
+    bool ok = f && f.write(data, length) == length;
+    if (f) f.close();
+    return ok;
+}
+
+// Records read back only when length and CRC match; files without a header are read whole
+void test_record_reader_rejects_corruption() {
+    if (!sdReady) {
+        TEST_IGNORE_MESSAGE("SD card not available");
+        return;
+    }
+    String path = String(FI_TEST_DIR) + "/record.txt";
+    String content;
+    TEST_ASSERT_TRUE(testSd.writeTextFile(path, "{\"light\":120}"));
+    TEST_ASSERT_TRUE(testSd.readRecordText(path, content));
+    TEST_ASSERT_EQUAL_STRING("{\"light\":120}", content.c_str());
+
+    // Flip one payload byte: same length, wrong CRC
+    File f = SD_MMC.open(path.c_str(), FILE_READ);
+    uint8_t raw[64];
+    size_t rawLength = f ? f.read(raw, sizeof(raw)) : 0;
+    if (f) f.close();
+    TEST_ASSERT_EQUAL(RECORD_HEADER_LEN + 13, rawLength);
+    raw[RECORD_HEADER_LEN + 3] ^= 0x01;
+    TEST_ASSERT_TRUE(writeRaw(path, raw, rawLength));
+    TEST_ASSERT_FALSE_MESSAGE(testSd.readRecordText(path, content), "Corrupted record was returned");
+
+    // Legacy file (no header)
+    TEST_ASSERT_TRUE(writeRaw(path, (const uint8_t*)"legacy", 6));
+    TEST_ASSERT_TRUE(testSd.readRecordText(path, content));
+    TEST_ASSERT_EQUAL_STRING("legacy", content.c_str());
+    testSd.deleteFile(path.c_str());
+}
+
+// Mount-time recovery: a torn pending record is quarantined, a complete temp file is renamed to
+// its destination, an incomplete one is removed, and intact records are left alone
+void test_recovery_scan_after_power_cut() {
+    if (!sdReady) {
+        TEST_IGNORE_MESSAGE("SD card not available");
+        return;
+    }
+    String intactPath = String(AMBIENT_PENDING_DIR) + "/fi_intact_env.json";
+    String tornPath = String(AMBIENT_PENDING_DIR) + "/fi_torn_env.json";
+    String rolledPath = String(FI_TEST_DIR) + "/rolled.txt";
+    String partialTemp = String(RECORD_TMP_DIR) + "/fi_test~partial.txt.tmp";
+    TEST_ASSERT_TRUE(testSd.writeTextFile(intactPath, "{\"light\":1}"));
+
+    // Header announces 100 bytes, only 10 reached the card
+    uint8_t torn[RECORD_HEADER_LEN + 10] = {'R', 'E', 'C', '1', 100, 0, 0, 0, 0, 0, 0, 0};
+    TEST_ASSERT_TRUE(writeRaw(tornPath, torn, sizeof(torn)));
+
+    // Complete temp file whose rename never happened
+    TEST_ASSERT_TRUE(testSd.writeTextFile(rolledPath, "rolled forward"));
+    TEST_ASSERT_TRUE(SD_MMC.rename(rolledPath.c_str(), RECORD_TMP_DIR "/fi_test~rolled.txt.tmp"));
+    TEST_ASSERT_TRUE(writeRaw(partialTemp, torn, 6));
+
+    SDHealthStats before = testSd.getHealthStats();
+    unsigned long start = millis();
+    TEST_ASSERT_GREATER_OR_EQUAL_INT(1, testSd.recoverTornRecords());
+    Serial.printf("[FaultInjection] Recovery scan: %lu ms\n", millis() - start);
+    SDHealthStats after = testSd.getHealthStats();
+
+    TEST_ASSERT_FALSE_MESSAGE(SD_MMC.exists(tornPath.c_str()), "Torn record left in the pending queue");
+    TEST_ASSERT_TRUE(SD_MMC.exists(QUARANTINE_DIR "/fi_torn_env.json"));
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(before.quarantinedRecords + 1, after.quarantinedRecords);
+
+    String content;
+    TEST_ASSERT_TRUE_MESSAGE(testSd.readRecordText(intactPath, content), "Intact record was touched");
+    TEST_ASSERT_TRUE_MESSAGE(testSd.readRecordText(rolledPath, content), "Complete temp file was not renamed");
+    TEST_ASSERT_EQUAL_STRING("rolled forward", content.c_str());
+    TEST_ASSERT_FALSE(SD_MMC.exists(partialTemp.c_str()));
+    TEST_ASSERT_FALSE(SD_MMC.exists(FI_TEST_DIR "/partial.txt"));
+
+    testSd.deleteFile(intactPath.c_str());
+    testSd.deleteFile(rolledPath.c_str());
+    testSd.deleteFile(QUARANTINE_DIR "/fi_torn_env.json");
+}
+
+// An injected I2C fault on the thermal sensor fails one read; the next read recovers in time
+void test_mlx_i2c_fault_recovers() {
+#ifndef ENABLE_FAULT_INJECTION
+    TEST_IGNORE_MESSAGE("Build with -D ENABLE_FAULT_INJECTION to run the I2C scenario");
+#else
+    if (!mlxInitialized) {
+        TEST_IGNORE_MESSAGE("MLX90640 not available");
+        return;
+    }
+    FaultInjection::configureFromString("I2C_MLX_FRAME:nth=1");
+    TEST_ASSERT_FALSE_MESSAGE(testMlxSensor.readFrame(), "Injected I2C fault was not reported");
+
+    unsigned long start = millis();
+    bool recovered = testMlxSensor.readFrame();
+    unsigned long recoveryMs = millis() - start;
+    Serial.printf("[FaultInjection] MLX90640 recovery latency: %lu ms\n", recoveryMs);
+
+    TEST_ASSERT_TRUE_MESSAGE(recovered, "MLX90640 did not recover after the injected fault");
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(MAX_I2C_RECOVERY_MS, recoveryMs);
+#endif
+}
+
+// Setup function: runs once at the beginning
+void setup() {
+    // Scenario results (recovery latency) are printed on the serial port
+    Serial.begin(115200);
+    // Initial delay for stability
+    delay(2000);
+
+    // Hardware for the recovery scenarios (tests are ignored if missing)
+    sdReady = testSd.begin() && (SD_MMC.exists(FI_TEST_DIR) || SD_MMC.mkdir(FI_TEST_DIR));
+    testWire.begin(SDA_PIN, SCL_PIN);
+    testWire.setClock(400000);
+    delay(100);
+    mlxInitialized = testMlxSensor.begin();
+    delay(500);
+
+    // Begin the Unity test framework
+    UNITY_BEGIN();
+    RUN_TEST(test_fail_nth_is_exact);
+    RUN_TEST(test_probability_is_seeded_and_bounded);
+    RUN_TEST(test_latency_is_applied);
+    RUN_TEST(test_configure_from_string);
+    RUN_TEST(test_sd_write_faults_bounded_loss);
+    RUN_TEST(test_sd_rename_fault_recovers);
+    RUN_TEST(test_sd_unmount_and_remount);
+    RUN_TEST(test_record_reader_rejects_corruption);
+    RUN_TEST(test_recovery_scan_after_power_cut);
+    RUN_TEST(test_mlx_i2c_fault_recovers);
+    // End the Unity test framework and report results
+    UNITY_END();
+
+    // Clean up the scratch files
+    if (sdReady) {
+        for (int i = 0; i < FI_FILE_COUNT; i++) {
+            testSd.deleteFile((String(FI_TEST_DIR) + "/f" + String(i) + ".bin").c_str());
+        }
+    }
+}
+
+// Loop function: runs repeatedly after setup (empty for tests)
+void loop() {}
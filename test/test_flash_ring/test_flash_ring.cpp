@@ -0,0 +1,207 @@
+// FlashRing (hot storage tier) tests.
+// Run on the device against the 'hotring' partition from partitions.csv; the ring is cleared
+// before each test, so anything pending there is lost. Without the partition every test is
+// reported as IGNORED.
+
+// Include necessary libraries
+#include <Arduino.h>         // Arduino core framework
+#include <unity.h>           // Unity test framework
+#include <stdio.h>           // fopen() on the VFS mount point (torn record test)
+#include <vector>            // Collected records
+#include "FlashRing.h"       // Ring under test
+
+// --- Shared fixtures ---
+FlashRing ring;
+bool ringReady = false;
+
+struct CollectedRecord {
+    HotRecordType type;
+    String target;
+    String data;
+};
+std::vector<CollectedRecord> collected;
+
+// Visitor that stores every record and accepts the first `acceptLimit` of them
+static FlashRing::Visitor collector(size_t acceptLimit = SIZE_MAX) {
+    return [acceptLimit](HotRecordType type, const String& target, const uint8_t* data, size_t length) -> bool {
+        if (collected.size() >= acceptLimit) return false;
+        String text;
+        for (size_t i = 0; i < length; i++) text += (char)data[i];
+        collected.push_back({type, target, text});
+        return true;
+    };
+}
+
+static bool appendText(HotRecordType type, const String& target, const String& text) {
+    return ring.append(type, target, (const uint8_t*)text.c_str(), text.length());
+}
+
+// setUp function: runs before each test (empty ring, no collected records)
+void setUp(void) {
+    if (!ringReady) {
+        TEST_IGNORE_MESSAGE("hotring partition not available");
+    }
+    ring.clear();
+    collected.clear();
+}
+// tearDown function: runs after each test
+void tearDown(void) {}
+
+// Records come back in order, with their type, target and data intact
+void test_append_and_migrate_in_order() {
+    TEST_ASSERT_TRUE(appendText(HotRecordType::WRITE_FILE, "/data_pending/ambient/a_env.json", "{\"light\":120}"));
+    TEST_ASSERT_TRUE(appendText(HotRecordType::APPEND_LINE, "/logs/20251031_log.txt", "line one"));
+    const uint8_t frame[] = {0xA5, 0x02, 0x10, 0x20, 0x7E};
+    TEST_ASSERT_TRUE(ring.append(HotRecordType::EVENT_FRAME, "/logs/20251031_log.bin", frame, sizeof(frame)));
+    TEST_ASSERT_EQUAL_UINT32(3, ring.pendingRecords());
+
+    TEST_ASSERT_EQUAL_INT(3, ring.migrate(collector(), 100));
+    TEST_ASSERT_EQUAL_UINT32(0, ring.pendingRecords());
+    TEST_ASSERT_EQUAL(3, (int)collected.size());
+    TEST_ASSERT_TRUE(collected[0].type == HotRecordType::WRITE_FILE);
+    TEST_ASSERT_EQUAL_STRING("/data_pending/ambient/a_env.json", collected[0].target.c_str());
+    TEST_ASSERT_EQUAL_STRING("{\"light\":120}", collected[0].data.c_str());
+    TEST_ASSERT_TRUE(collected[1].type == HotRecordType::APPEND_LINE);
+    TEST_ASSERT_EQUAL_STRING("line one", collected[1].data.c_str());
+    TEST_ASSERT_TRUE(collected[2].type == HotRecordType::EVENT_FRAME);
+    TEST_ASSERT_EQUAL(sizeof(frame), collected[2].data.length());
+    TEST_ASSERT_EQUAL_UINT8(0x7E, (uint8_t)collected[2].data[4]);
+
+    // Nothing is delivered twice
+    TEST_ASSERT_EQUAL_INT(0, ring.migrate(collector(), 100));
+}
+
+// A rejected record stops the migration and is delivered again, also after a remount
+void test_cursor_survives_remount() {
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_TRUE(appendText(HotRecordType::APPEND_LINE, "/logs/20251031_log.txt", "entry " + String(i)));
+    }
+    TEST_ASSERT_EQUAL_INT(2, ring.migrate(collector(2), 100));
+    TEST_ASSERT_EQUAL_UINT32(3, ring.pendingRecords());
+
+    ring.end();
+    TEST_ASSERT_TRUE(ring.begin());
+    TEST_ASSERT_EQUAL_UINT32(3, ring.pendingRecords());
+
+    collected.clear();
+    TEST_ASSERT_EQUAL_INT(3, ring.migrate(collector(), 100));
+    TEST_ASSERT_EQUAL_STRING("entry 2", collected[0].data.c_str());
+    TEST_ASSERT_EQUAL_STRING("entry 4", collected[2].data.c_str());
+}
+
+// When the ring is full the oldest segment is dropped and counted; the newest records survive
+void test_full_ring_drops_oldest() {
+    String payload;
+    while (payload.length() < 1000) payload += "0123456789";
+    const int total = FLASH_RING_MAX_SEGMENTS * (FLASH_RING_SEGMENT_BYTES / 1040) + 40;
+    for (int i = 0; i < total; i++) {
+        TEST_ASSERT_TRUE(appendText(HotRecordType::WRITE_FILE, "/p/" + String(i), payload));
+    }
+    TEST_ASSERT_GREATER_THAN_UINT32(0, ring.droppedRecords());
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)total, ring.pendingRecords() + ring.droppedRecords());
+
+    uint32_t pending = ring.pendingRecords();
+    TEST_ASSERT_EQUAL_INT((int)pending, ring.migrate(collector(), total));
+    TEST_ASSERT_EQUAL_STRING(("/p/" + String(total - (int)pending)).c_str(), collected[0].target.c_str());
+    TEST_ASSERT_EQUAL_STRING(("/p/" + String(total - 1)).c_str(), collected.back().target.c_str());
+}
+
+// A record cut by a reset is dropped; records written after the remount are not lost
+void test_torn_record_is_skipped() {
+    TEST_ASSERT_TRUE(appendText(HotRecordType::APPEND_LINE, "/logs/a.txt", "before 1"));
+    TEST_ASSERT_TRUE(appendText(HotRecordType::APPEND_LINE, "/logs/a.txt", "before 2"));
+    ring.end();
+
+    // Header of a record whose payload never reached the flash
+    FILE* segment = fopen(FLASH_RING_MOUNT "/seg_00000001.bin", "ab");
+    TEST_ASSERT_NOT_NULL(segment);
+    const uint8_t torn[] = {FLASH_RING_SYNC_BYTE, (uint8_t)HotRecordType::APPEND_LINE, 0x40, 0x00};
+    fwrite(torn, 1, sizeof(torn), segment);
+    fclose(segment);
+
+    TEST_ASSERT_TRUE(ring.begin());
+    TEST_ASSERT_EQUAL_UINT32(2, ring.pendingRecords());
+    TEST_ASSERT_TRUE(appendText(HotRecordType::APPEND_LINE, "/logs/a.txt", "after"));
+
+    TEST_ASSERT_EQUAL_INT(3, ring.migrate(collector(), 100));
+    TEST_ASSERT_EQUAL_STRING("before 2", collected[1].data.c_str());
+    TEST_ASSERT_EQUAL_STRING("after", collected[2].data.c_str());
+}
+
+// A CRC failure skips the rest of the segment and counts every record that was skipped
+void test_damaged_record_counts_skipped() {
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_TRUE(appendText(HotRecordType::APPEND_LINE, "/logs/a.txt", "line " + String(i)));
+    }
+    ring.end();
+
+    // Flip the first target byte of the first record: its header is still valid, its CRC is not
+    FILE* segment = fopen(FLASH_RING_MOUNT "/seg_00000001.bin", "r+b");
+    TEST_ASSERT_NOT_NULL(segment);
+    fseek(segment, 0, SEEK_END);
+    long segmentSize = ftell(segment);
+    fseek(segment, FLASH_RING_HEADER_LEN, SEEK_SET);
+    int original = fgetc(segment);
+    fseek(segment, FLASH_RING_HEADER_LEN, SEEK_SET);
+    fputc(original ^ 0xFF, segment);
+    fclose(segment);
+
+    TEST_ASSERT_TRUE(ring.begin());
+    TEST_ASSERT_EQUAL_INT(0, ring.migrate(collector(), 100));
+    TEST_ASSERT_EQUAL_UINT32(3, ring.droppedRecords());
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)segmentSize, ring.droppedBytes());
+    TEST_ASSERT_EQUAL_UINT32(0, ring.pendingRecords());
+}
+
+// A failed commit rolls the cursor back: the uncommitted records are delivered again
+void test_failed_commit_redelivers() {
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(appendText(HotRecordType::APPEND_LINE, "/logs/a.txt", "line " + String(i)));
+    }
+    TEST_ASSERT_EQUAL_INT(0, ring.migrate(collector(), 100, []() { return false; }));
+    TEST_ASSERT_EQUAL(4, (int)collected.size());
+    TEST_ASSERT_EQUAL_UINT32(4, ring.pendingRecords());
+
+    collected.clear();
+    TEST_ASSERT_EQUAL_INT(4, ring.migrate(collector(), 100, []() { return true; }));
+    TEST_ASSERT_EQUAL_STRING("line 0", collected[0].data.c_str());
+    TEST_ASSERT_EQUAL_UINT32(0, ring.pendingRecords());
+}
+
+// State files are replaced atomically and are not part of the ring
+void test_state_round_trip() {
+    String out;
+    TEST_ASSERT_TRUE(ring.writeState("test_state", "{\"v\":1}"));
+    TEST_ASSERT_TRUE(ring.writeState("test_state", "{\"v\":2}"));
+    TEST_ASSERT_TRUE(ring.readState("test_state", out));
+    TEST_ASSERT_EQUAL_STRING("{\"v\":2}", out.c_str());
+    TEST_ASSERT_EQUAL_UINT32(0, ring.pendingRecords());
+    TEST_ASSERT_FALSE(ring.readState("missing_state", out));
+}
+
+// Setup function: runs once at the beginning
+void setup() {
+    // Wait for the serial monitor to connect
+    delay(2000);
+
+    ringReady = ring.begin();
+
+    // Begin the Unity test framework
+    UNITY_BEGIN();
+    RUN_TEST(test_append_and_migrate_in_order);
+    RUN_TEST(test_cursor_survives_remount);
+    RUN_TEST(test_full_ring_drops_oldest);
+    RUN_TEST(test_torn_record_is_skipped);
+    RUN_TEST(test_damaged_record_counts_skipped);
+    RUN_TEST(test_failed_commit_redelivers);
+    RUN_TEST(test_state_round_trip);
+    // End the Unity test framework and report results
+    UNITY_END();
+
+    if (ringReady) {
+        ring.clear();
+    }
+}
+
+// Loop function: runs repeatedly after setup (empty for tests)
+void loop() {}
@@ -0,0 +1,191 @@
+// PendingPrefetcher (pending queue pipeline) tests.
+// Needs the SD card: the jobs are written to a scratch directory, except the thermal/JPEG
+// pair, which has to live in the capture pending directory for the JPEG to be found. All
+// files are removed at the end. Without a card every test is reported as IGNORED.
+
+// Include necessary libraries
+#include <Arduino.h>             // Arduino core framework
+#include <unity.h>               // Unity test framework
+#include "SDManager.h"           // Record writer (files read back by the prefetcher)
+#include "PendingPrefetcher.h"   // Pipeline under test
+
+// Scratch directory (removed at the end)
+#define PF_TEST_DIR "/pf_test"
+// Base name of the pair written to the real capture pending directory
+#define PF_PAIR_BASE "19990101_000000"
+// Jobs queued in the cancellation test
+#define PF_CANCEL_JOBS 12
+
+// --- Shared fixtures ---
+SDManager testSd;
+bool sdReady = false;
+
+// Thermal JSON with 'pixels' temperatures (768 is a valid frame)
+static String thermalJson(int pixels, float first) {
+    String json = "{\"timestamp\":\"2025-10-31_10:00:00\",\"temperatures\":[";
+    for (int i = 0; i < pixels; i++) {
+        if (i > 0) json += ",";
+        json += String(i == 0 ? first : 20.5f, 1);
+    }
+    return json + "]}";
+}
+
+static String ambientJson(int light) {
+    return "{\"timestamp\":\"2025-10-31_10:0" + String(light % 10) + ":00\",\"light\":" + String(light) +
+           ",\"temperature\":21.5,\"humidity\":60,\"pressure\":1013}";
+}
+
+// setUp function: runs before each test
+void setUp(void) {
+    if (!sdReady) {
+        TEST_IGNORE_MESSAGE("SD card not available");
+    }
+}
+// tearDown function: runs after each test
+void tearDown(void) {}
+
+// Items come back in job order with their values decoded
+void test_items_in_job_order() {
+    std::vector<String> jobs;
+    for (int i = 0; i < 4; i++) {
+        String path = String(PF_TEST_DIR) + "/a" + String(i) + "_env.json";
+        TEST_ASSERT_TRUE(testSd.writeTextFile(path, ambientJson(100 + i)));
+        jobs.push_back(path);
+    }
+
+    PendingPrefetcher prefetcher;
+    TEST_ASSERT_TRUE(prefetcher.begin(jobs));
+    for (int i = 0; i < 4; i++) {
+        PendingItem* item = prefetcher.next();
+        TEST_ASSERT_NOT_NULL(item);
+        TEST_ASSERT_TRUE(item->kind == PendingItemKind::AMBIENT);
+        TEST_ASSERT_TRUE(item->status == PendingItemStatus::READY);
+        TEST_ASSERT_EQUAL_STRING(jobs[i].c_str(), item->path.c_str());
+        TEST_ASSERT_EQUAL_STRING(("a" + String(i) + "_env.json").c_str(), item->name.c_str());
+        TEST_ASSERT_EQUAL_FLOAT(100 + i, item->light);
+        TEST_ASSERT_EQUAL_FLOAT(21.5f, item->temperature);
+        prefetcher.release(item);
+    }
+    TEST_ASSERT_NULL(prefetcher.next());
+    TEST_ASSERT_EQUAL_UINT32(4, prefetcher.stats().loaded);
+    prefetcher.end();
+}
+
+// A thermal file is paired with its JPEG when there is one; otherwise it is thermal-only
+void test_pair_and_thermal_only() {
+    String pairThermal = String(CAPTURE_PENDING_DIR) + "/" PF_PAIR_BASE "_thermal.json";
+    String pairJpeg = String(CAPTURE_PENDING_DIR) + "/" PF_PAIR_BASE "_visual.jpg";
+    String orphanThermal = String(PF_TEST_DIR) + "/19990101_000100_thermal.json";
+    const uint8_t jpeg[] = {0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 0xFF, 0xD9};
+    TEST_ASSERT_TRUE(testSd.writeTextFile(pairThermal, thermalJson(MultipartDataSender::THERMAL_PIXELS, 31.5f)));
+    TEST_ASSERT_TRUE(testSd.writeBinaryFile(pairJpeg, jpeg, sizeof(jpeg)));
+    TEST_ASSERT_TRUE(testSd.writeTextFile(orphanThermal, thermalJson(MultipartDataSender::THERMAL_PIXELS, 12.0f)));
+
+    PendingPrefetcher prefetcher;
+    TEST_ASSERT_TRUE(prefetcher.begin({pairThermal, orphanThermal}));
+
+    PendingItem* pair = prefetcher.next();
+    TEST_ASSERT_NOT_NULL(pair);
+    TEST_ASSERT_TRUE(pair->kind == PendingItemKind::CAPTURE);
+    TEST_ASSERT_TRUE(pair->status == PendingItemStatus::READY);
+    TEST_ASSERT_EQUAL_STRING(PF_PAIR_BASE, pair->name.c_str());
+    TEST_ASSERT_EQUAL_STRING(pairJpeg.c_str(), pair->jpegPath.c_str());
+    TEST_ASSERT_EQUAL(sizeof(jpeg), pair->jpegLength);
+    TEST_ASSERT_EQUAL_MEMORY(jpeg, pair->jpeg, sizeof(jpeg));
+    TEST_ASSERT_EQUAL_FLOAT(31.5f, pair->thermal[0]);
+    TEST_ASSERT_EQUAL_STRING("2025-10-31_10:00:00", pair->timestamp.c_str());
+    prefetcher.release(pair);
+
+    PendingItem* orphan = prefetcher.next();
+    TEST_ASSERT_NOT_NULL(orphan);
+    TEST_ASSERT_TRUE(orphan->status == PendingItemStatus::READY);
+    TEST_ASSERT_TRUE(orphan->jpegPath.isEmpty());
+    TEST_ASSERT_EQUAL_FLOAT(12.0f, orphan->thermal[0]);
+    prefetcher.release(orphan);
+    prefetcher.end();
+
+    testSd.deleteFile(pairThermal.c_str());
+    testSd.deleteFile(pairJpeg.c_str());
+}
+
+// Missing files are UNREADABLE; bad JSON or a short thermal array are CORRUPTED
+void test_status_classification() {
+    String missing = String(PF_TEST_DIR) + "/missing_env.json";
+    String badJson = String(PF_TEST_DIR) + "/bad_env.json";
+    String shortThermal = String(PF_TEST_DIR) + "/19990101_000200_thermal.json";
+    TEST_ASSERT_TRUE(testSd.writeTextFile(badJson, "{\"light\":"));
+    TEST_ASSERT_TRUE(testSd.writeTextFile(shortThermal, thermalJson(10, 20.0f)));
+
+    PendingPrefetcher prefetcher;
+    TEST_ASSERT_TRUE(prefetcher.begin({missing, badJson, shortThermal}));
+    PendingItem* item = prefetcher.next();
+    TEST_ASSERT_TRUE(item->status == PendingItemStatus::UNREADABLE);
+    prefetcher.release(item);
+    item = prefetcher.next();
+    TEST_ASSERT_TRUE(item->status == PendingItemStatus::CORRUPTED);
+    prefetcher.release(item);
+    item = prefetcher.next();
+    TEST_ASSERT_TRUE(item->kind == PendingItemKind::CAPTURE);
+    TEST_ASSERT_TRUE(item->status == PendingItemStatus::CORRUPTED);
+    prefetcher.release(item);
+    TEST_ASSERT_NULL(prefetcher.next());
+    prefetcher.end();
+}
+
+// end() stops the reader after at most the slots in flight; the prefetcher can be reused
+void test_cancel_mid_queue() {
+    std::vector<String> jobs;
+    for (int i = 0; i < PF_CANCEL_JOBS; i++) {
+        String path = String(PF_TEST_DIR) + "/c" + String(i) + "_env.json";
+        TEST_ASSERT_TRUE(testSd.writeTextFile(path, ambientJson(i)));
+        jobs.push_back(path);
+    }
+
+    PendingPrefetcher prefetcher;
+    TEST_ASSERT_TRUE(prefetcher.begin(jobs));
+    PendingItem* item = prefetcher.next();
+    TEST_ASSERT_NOT_NULL(item);
+    prefetcher.release(item);
+    prefetcher.end();
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(1 + PENDING_PREFETCH_SLOTS, prefetcher.stats().loaded);
+    TEST_ASSERT_NULL(prefetcher.next());
+
+    TEST_ASSERT_TRUE(prefetcher.begin({jobs.back()}));
+    item = prefetcher.next();
+    TEST_ASSERT_NOT_NULL(item);
+    TEST_ASSERT_EQUAL_FLOAT(PF_CANCEL_JOBS - 1, item->light);
+    prefetcher.release(item);
+    prefetcher.end();
+}
+
+// Setup function: runs once at the beginning
+void setup() {
+    // Wait for the serial monitor to connect
+    delay(2000);
+
+    sdReady = testSd.begin() && (SD_MMC.exists(PF_TEST_DIR) || SD_MMC.mkdir(PF_TEST_DIR));
+
+    // Begin the Unity test framework
+    UNITY_BEGIN();
+    RUN_TEST(test_items_in_job_order);
+    RUN_TEST(test_pair_and_thermal_only);
+    RUN_TEST(test_status_classification);
+    RUN_TEST(test_cancel_mid_queue);
+    // End the Unity test framework and report results
+    UNITY_END();
+
+    if (sdReady) {
+        File dir = SD_MMC.open(PF_TEST_DIR);
+        std::vector<String> files;
+        for (File entry = dir.openNextFile(); entry; entry = dir.openNextFile()) {
+            files.push_back(String(PF_TEST_DIR) + "/" + String(entry.name()).substring(String(entry.name()).lastIndexOf('/') + 1));
+            entry.close();
+        }
+        dir.close();
+        for (const String& path : files) testSd.deleteFile(path.c_str());
+        SD_MMC.rmdir(PF_TEST_DIR);
+    }
+}
+
+// Loop function: runs repeatedly after setup (empty for tests)
+void loop() {}
@@ -0,0 +1,127 @@
+// PhaseDeadline (per-phase deadlines, cooperative cancellation) tests.
+// The clock is replaced with a manual one, so budgets of minutes run instantly.
+
+// Include necessary libraries
+#include <Arduino.h>            // Arduino core framework
+#include <unity.h>              // Unity test framework
+#include "PhaseDeadline.h"      // Deadlines under test
+
+// --- Shared fixtures ---
+static uint32_t fakeNowMs = 0;
+static uint32_t fakeClock() { return fakeNowMs; }
+
+// setUp function: runs before each test
+void setUp(void) {
+    fakeNowMs = 1000;
+    PhaseDeadline::setClock(fakeClock);
+    PhaseDeadline::resetCycle();
+    for (size_t i = 0; i < (size_t)DeadlinePhase::COUNT; i++) PhaseDeadline::setBudget((DeadlinePhase)i, 0);
+}
+// tearDown function: runs after each test
+void tearDown(void) {
+    PhaseDeadline::setClock(nullptr);
+}
+
+// Without an open phase (or with budget 0) nothing expires and timeouts pass through
+void test_no_deadline() {
+    TEST_ASSERT_FALSE(PhaseDeadline::expired());
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, PhaseDeadline::remainingMs());
+    TEST_ASSERT_EQUAL_UINT32(20000, PhaseDeadline::boundTimeout(20000));
+
+    PhaseDeadline::begin(DeadlinePhase::MAINTENANCE);
+    fakeNowMs += 3600000;
+    TEST_ASSERT_FALSE(PhaseDeadline::expired());
+    TEST_ASSERT_FALSE(PhaseDeadline::end());
+}
+
+// Socket timeouts shrink to the remaining budget, never below the minimum
+void test_bound_timeout() {
+    PhaseDeadline::setBudget(DeadlinePhase::IMAGE, 30000);
+    PhaseDeadline::begin(DeadlinePhase::IMAGE);
+    TEST_ASSERT_EQUAL_UINT32(20000, PhaseDeadline::boundTimeout(20000));
+    fakeNowMs += 25000;
+    TEST_ASSERT_EQUAL_UINT32(5000, PhaseDeadline::remainingMs());
+    TEST_ASSERT_EQUAL_UINT32(5000, PhaseDeadline::boundTimeout(20000));
+    fakeNowMs += 4800;
+    TEST_ASSERT_EQUAL_UINT32(PHASE_DEADLINE_MIN_IO_MS, PhaseDeadline::boundTimeout(20000));
+    TEST_ASSERT_FALSE(PhaseDeadline::expired());
+    fakeNowMs += 200;
+    TEST_ASSERT_TRUE(PhaseDeadline::expired());
+    PhaseDeadline::end();
+}
+
+// A nested phase is bounded by the closer of its own and its parent's deadline
+void test_nested_phases() {
+    PhaseDeadline::setBudget(DeadlinePhase::IMAGE, 60000);
+    PhaseDeadline::setBudget(DeadlinePhase::UPLOAD, 45000);
+    PhaseDeadline::begin(DeadlinePhase::IMAGE);
+    fakeNowMs += 40000;                                 // Capture and analysis took 40 s
+    PhaseDeadline::begin(DeadlinePhase::UPLOAD);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)DeadlinePhase::UPLOAD, (uint8_t)PhaseDeadline::currentPhase());
+    TEST_ASSERT_EQUAL_UINT32(20000, PhaseDeadline::remainingMs()); // Parent is closer
+    fakeNowMs += 20000;
+    TEST_ASSERT_TRUE(PhaseDeadline::expired());
+    TEST_ASSERT_FALSE(PhaseDeadline::end());            // Upload itself was within its 45 s
+    TEST_ASSERT_TRUE(PhaseDeadline::expired());         // Image still past its deadline
+    fakeNowMs += 500;                                   // Cleanup path
+    TEST_ASSERT_TRUE(PhaseDeadline::end());
+    TEST_ASSERT_FALSE(PhaseDeadline::isActive());
+}
+
+// Overruns are kept per cycle with the phase that caused them
+void test_overrun_recorded() {
+    PhaseDeadline::setBudget(DeadlinePhase::ENVIRONMENT, 30000);
+    PhaseDeadline::setBudget(DeadlinePhase::DRAIN, 120000);
+    uint32_t environmentBefore = PhaseDeadline::totalOverruns(DeadlinePhase::ENVIRONMENT);
+
+    PhaseDeadline::begin(DeadlinePhase::ENVIRONMENT);
+    fakeNowMs += 31500;
+    TEST_ASSERT_TRUE(PhaseDeadline::end());
+    PhaseDeadline::begin(DeadlinePhase::DRAIN);
+    fakeNowMs += 90000;
+    TEST_ASSERT_FALSE(PhaseDeadline::end());
+
+    TEST_ASSERT_EQUAL_UINT8(1, PhaseDeadline::overrunCount());
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)DeadlinePhase::ENVIRONMENT, (uint8_t)PhaseDeadline::overrun(0).phase);
+    TEST_ASSERT_EQUAL_UINT32(31500, PhaseDeadline::overrun(0).elapsedMs);
+    TEST_ASSERT_EQUAL_UINT32(environmentBefore + 1, PhaseDeadline::totalOverruns(DeadlinePhase::ENVIRONMENT));
+
+    char text[64];
+    PhaseDeadline::describeOverruns(text, sizeof(text));
+    TEST_ASSERT_EQUAL_STRING("ENVIRONMENT 31500/30000 ms", text);
+
+    PhaseDeadline::resetCycle();
+    TEST_ASSERT_EQUAL_UINT8(0, PhaseDeadline::overrunCount());
+    TEST_ASSERT_EQUAL_UINT32(0, PhaseDeadline::describeOverruns(text, sizeof(text)));
+}
+
+// The clock wrapping around (millis() after ~49 days) does not break the deadline
+void test_clock_wraparound() {
+    fakeNowMs = UINT32_MAX - 5000;
+    PhaseDeadline::setBudget(DeadlinePhase::UPLOAD, 10000);
+    PhaseDeadline::begin(DeadlinePhase::UPLOAD);
+    fakeNowMs += 8000; // Wrapped
+    TEST_ASSERT_EQUAL_UINT32(2000, PhaseDeadline::remainingMs());
+    fakeNowMs += 2000;
+    TEST_ASSERT_TRUE(PhaseDeadline::expired());
+    PhaseDeadline::end();
+}
+
+// Setup function: runs once at the beginning
+void setup() {
+    // Wait for the serial monitor to connect
+    delay(2000);
+
+    // Begin the Unity test framework
+    UNITY_BEGIN();
+    RUN_TEST(test_no_deadline);
+    RUN_TEST(test_bound_timeout);
+    RUN_TEST(test_nested_phases);
+    RUN_TEST(test_overrun_recorded);
+    RUN_TEST(test_clock_wraparound);
+    // End the Unity test framework and report results
+    UNITY_END();
+}
+
+// Loop function: runs repeatedly after setup (empty for tests)
+void loop() {}
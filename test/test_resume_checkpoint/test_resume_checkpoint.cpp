@@ -0,0 +1,124 @@
+// ResumeCheckpoint (RTC-memory resume after watchdog/brownout) tests.
+// No reset needed: begin() takes the reset reason, so each test simulates the reboot by calling
+// it again on the same RTC variable. Runs without NTP (the clock stays near 1970).
+
+// Include necessary libraries
+#include <Arduino.h>            // Arduino core framework
+#include <unity.h>              // Unity test framework
+#include <string.h>             // memcpy for corrupted copies
+#include "ResumeCheckpoint.h"   // Checkpoint under test
+
+// 2025-10-31 00:00:00 UTC
+#define TEST_EPOCH 1761868800LL
+
+// Cold boot followed by one cycle that stopped in `phase` (due slot at TEST_EPOCH)
+static void coldBootAndRunUntil(CyclePhase phase) {
+    ResumeCheckpoint::begin(ESP_RST_POWERON);
+    ResumeCheckpoint::data().nextCollectionEpoch = TEST_EPOCH;
+    ResumeCheckpoint::data().flags = CHECKPOINT_FLAG_SD_WARNING_SENT;
+    ResumeCheckpoint::save(phase);
+}
+
+// setUp function: runs before each test
+void setUp(void) {}
+// tearDown function: runs after each test
+void tearDown(void) {}
+
+// Sealed data validates; a flipped byte, another version or size is rejected
+void test_seal_and_validate() {
+    CheckpointData data;
+    memset(&data, 0, sizeof(data));
+    data.nextCollectionEpoch = TEST_EPOCH;
+    ResumeCheckpoint::seal(data);
+    TEST_ASSERT_TRUE(ResumeCheckpoint::isValid(data));
+
+    CheckpointData damaged = data;
+    ((uint8_t*)&damaged)[offsetof(CheckpointData, nextCollectionEpoch)] ^= 0x01;
+    TEST_ASSERT_FALSE(ResumeCheckpoint::isValid(damaged));
+    damaged = data;
+    damaged.version = CHECKPOINT_VERSION + 1;
+    TEST_ASSERT_FALSE(ResumeCheckpoint::isValid(damaged));
+    damaged = data;
+    damaged.size = sizeof(CheckpointData) - 4;
+    TEST_ASSERT_FALSE(ResumeCheckpoint::isValid(damaged));
+}
+
+// A watchdog reset mid-cycle restores the schedule and the interrupted phase
+void test_resume_after_watchdog() {
+    coldBootAndRunUntil(CyclePhase::IMAGE);
+    TEST_ASSERT_TRUE(ResumeCheckpoint::begin(ESP_RST_TASK_WDT));
+    TEST_ASSERT_TRUE(ResumeCheckpoint::isResumed());
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)CyclePhase::IMAGE, (uint8_t)ResumeCheckpoint::interruptedPhase());
+    const CheckpointData& data = ResumeCheckpoint::data();
+    TEST_ASSERT_TRUE(data.nextCollectionEpoch == TEST_EPOCH);
+    TEST_ASSERT_EQUAL_UINT8(CHECKPOINT_FLAG_SD_WARNING_SENT, data.flags);
+    TEST_ASSERT_EQUAL_UINT32(1, data.resumes);
+    TEST_ASSERT_EQUAL_UINT32(0, data.restoreFailures);
+}
+
+// Power-on never resumes (RTC memory is garbage); a corrupted checkpoint is counted and dropped
+void test_power_on_and_corruption() {
+    coldBootAndRunUntil(CyclePhase::IDLE);
+    TEST_ASSERT_FALSE(ResumeCheckpoint::begin(ESP_RST_POWERON));
+    TEST_ASSERT_TRUE(ResumeCheckpoint::data().nextCollectionEpoch == 0);
+
+    coldBootAndRunUntil(CyclePhase::IDLE);
+    ResumeCheckpoint::data().nextCollectionEpoch++; // Changed without sealing (e.g. brownout mid-write)
+    TEST_ASSERT_FALSE(ResumeCheckpoint::begin(ESP_RST_BROWNOUT));
+    TEST_ASSERT_FALSE(ResumeCheckpoint::isResumed());
+    TEST_ASSERT_EQUAL_UINT32(1, ResumeCheckpoint::data().restoreFailures);
+    TEST_ASSERT_TRUE(ResumeCheckpoint::isValid(ResumeCheckpoint::data())); // Fresh checkpoint sealed
+}
+
+// A cycle that keeps crashing in the same phase falls back to a cold start
+void test_reset_loop_falls_back() {
+    coldBootAndRunUntil(CyclePhase::ENVIRONMENT);
+    TEST_ASSERT_TRUE(ResumeCheckpoint::begin(ESP_RST_PANIC));
+    TEST_ASSERT_TRUE(ResumeCheckpoint::begin(ESP_RST_PANIC));
+    TEST_ASSERT_TRUE(ResumeCheckpoint::begin(ESP_RST_PANIC));
+    TEST_ASSERT_FALSE(ResumeCheckpoint::begin(ESP_RST_PANIC));
+    TEST_ASSERT_EQUAL_UINT32(1, ResumeCheckpoint::data().restoreFailures);
+
+    // Completing a cycle clears the streak
+    coldBootAndRunUntil(CyclePhase::ENVIRONMENT);
+    TEST_ASSERT_TRUE(ResumeCheckpoint::begin(ESP_RST_PANIC));
+    ResumeCheckpoint::save(CyclePhase::IDLE);
+    TEST_ASSERT_EQUAL_UINT16(0, ResumeCheckpoint::data().consecutiveResumes);
+}
+
+// RTC time is trusted only shortly after a checkpoint and a recent NTP sync
+void test_rtc_time_trust() {
+    coldBootAndRunUntil(CyclePhase::IDLE);
+    TEST_ASSERT_FALSE(ResumeCheckpoint::rtcTimeTrusted(TEST_EPOCH)); // Not resumed
+
+    ResumeCheckpoint::data().savedEpoch = TEST_EPOCH;
+    ResumeCheckpoint::data().lastNtpSyncEpoch = TEST_EPOCH - 3600;
+    ResumeCheckpoint::seal(ResumeCheckpoint::data());
+    TEST_ASSERT_TRUE(ResumeCheckpoint::begin(ESP_RST_SW));
+    TEST_ASSERT_TRUE(ResumeCheckpoint::rtcTimeTrusted(TEST_EPOCH + 60));
+    TEST_ASSERT_FALSE(ResumeCheckpoint::rtcTimeTrusted(TEST_EPOCH - 60));                      // Clock went back
+    TEST_ASSERT_FALSE(ResumeCheckpoint::rtcTimeTrusted(TEST_EPOCH + CHECKPOINT_MAX_AGE_S + 1)); // Too old
+    TEST_ASSERT_FALSE(ResumeCheckpoint::rtcTimeTrusted(60));                                    // Clock lost
+
+    ResumeCheckpoint::data().lastNtpSyncEpoch = TEST_EPOCH - CHECKPOINT_NTP_TRUST_S - 1;
+    TEST_ASSERT_FALSE(ResumeCheckpoint::rtcTimeTrusted(TEST_EPOCH + 60));                      // Sync too old
+}
+
+// Setup function: runs once at the beginning
+void setup() {
+    // Wait for the serial monitor to connect
+    delay(2000);
+
+    // Begin the Unity test framework
+    UNITY_BEGIN();
+    RUN_TEST(test_seal_and_validate);
+    RUN_TEST(test_resume_after_watchdog);
+    RUN_TEST(test_power_on_and_corruption);
+    RUN_TEST(test_reset_loop_falls_back);
+    RUN_TEST(test_rtc_time_trust);
+    // End the Unity test framework and report results
+    UNITY_END();
+}
+
+// Loop function: runs repeatedly after setup (empty for tests)
+void loop() {}
@@ -0,0 +1,126 @@
+// SdIo (SD access scheduler) tests.
+// Only the scheduler is exercised (no SD card needed): helper tasks queue up behind a turn
+// held by the test task and the order in which they are granted the card is checked.
+
+// Include necessary libraries
+#include <Arduino.h>         // Arduino core framework
+#include <unity.h>           // Unity test framework
+#include "SdIo.h"            // Scheduler under test
+
+// Time given to each helper task to queue up before the next one starts
+#define QUEUE_SETTLE_MS 20
+// Helper tasks per test (must not exceed SD_IO_MAX_WAITERS)
+#define MAX_HELPERS 4
+
+// --- Shared fixtures ---
+struct Helper {
+    SdIoClass ioClass;
+    int id;
+};
+Helper helpers[MAX_HELPERS];
+volatile int grantOrder[MAX_HELPERS];
+volatile int grantCount = 0;
+SemaphoreHandle_t helpersDone;
+
+// Helper task: takes one turn, records its id and exits
+static void helperTask(void* arg) {
+    Helper* helper = static_cast<Helper*>(arg);
+    {
+        SdIoGuard ioGuard(helper->ioClass);
+        grantOrder[grantCount++] = helper->id; // Only the turn owner writes here
+        delay(2);
+    }
+    xSemaphoreGive(helpersDone);
+    vTaskDelete(nullptr);
+}
+
+// Queues one helper per class (in the given order) behind a turn held by the test task
+static void runQueued(const SdIoClass* classes, int count) {
+    grantCount = 0;
+    SdIo::acquire(SdIoClass::MAINTENANCE);
+    for (int i = 0; i < count; i++) {
+        helpers[i].ioClass = classes[i];
+        helpers[i].id = i;
+        xTaskCreatePinnedToCore(helperTask, "sd_io_helper", 4096, &helpers[i], 2, nullptr, 0);
+        delay(QUEUE_SETTLE_MS);
+    }
+    TEST_ASSERT_GREATER_THAN_UINT8(0, SdIo::stats(classes[0]).waiting); // The helpers are queued, not running
+    SdIo::release();
+    for (int i = 0; i < count; i++) {
+        TEST_ASSERT_TRUE(xSemaphoreTake(helpersDone, pdMS_TO_TICKS(1000)) == pdTRUE);
+    }
+    TEST_ASSERT_EQUAL_INT(count, grantCount);
+}
+
+// setUp function: runs before each test
+void setUp(void) {}
+// tearDown function: runs after each test
+void tearDown(void) {}
+
+// The owner can nest turns (SDManager operations call each other) without blocking
+void test_nested_turns_do_not_block() {
+    uint32_t before = SdIo::stats(SdIoClass::QUEUE).requests;
+    SdIo::acquire(SdIoClass::QUEUE);
+    SdIo::acquire(SdIoClass::CAPTURE_WRITE);
+    SdIo::acquire(SdIoClass::PORTAL_READ);
+    SdIo::release();
+    SdIo::release();
+    SdIo::release();
+    // Nested turns keep the outer class and are not counted as new requests
+    TEST_ASSERT_EQUAL_UINT32(before + 1, SdIo::stats(SdIoClass::QUEUE).requests);
+
+    // The card is free again: another task gets it right away
+    const SdIoClass classes[] = {SdIoClass::MAINTENANCE};
+    runQueued(classes, 1);
+}
+
+// Waiting requests are granted by priority, not by arrival
+void test_higher_priority_goes_first() {
+    const SdIoClass classes[] = {SdIoClass::MAINTENANCE, SdIoClass::PORTAL_READ, SdIoClass::QUEUE, SdIoClass::CAPTURE_WRITE};
+    runQueued(classes, 4);
+    TEST_ASSERT_EQUAL_INT(3, grantOrder[0]); // CAPTURE_WRITE
+    TEST_ASSERT_EQUAL_INT(2, grantOrder[1]); // QUEUE
+    TEST_ASSERT_EQUAL_INT(1, grantOrder[2]); // PORTAL_READ
+    TEST_ASSERT_EQUAL_INT(0, grantOrder[3]); // MAINTENANCE
+}
+
+// Within a class, requests are granted in arrival order
+void test_same_class_is_fifo() {
+    const SdIoClass classes[] = {SdIoClass::PORTAL_READ, SdIoClass::PORTAL_READ, SdIoClass::PORTAL_READ};
+    runQueued(classes, 3);
+    TEST_ASSERT_EQUAL_INT(0, grantOrder[0]);
+    TEST_ASSERT_EQUAL_INT(1, grantOrder[1]);
+    TEST_ASSERT_EQUAL_INT(2, grantOrder[2]);
+}
+
+// Contended turns show up in the metrics with their wait time
+void test_wait_metrics() {
+    SdIoClassStats before = SdIo::stats(SdIoClass::CAPTURE_WRITE);
+    const SdIoClass classes[] = {SdIoClass::CAPTURE_WRITE};
+    runQueued(classes, 1);
+    SdIoClassStats after = SdIo::stats(SdIoClass::CAPTURE_WRITE);
+    TEST_ASSERT_EQUAL_UINT32(before.contended + 1, after.contended);
+    TEST_ASSERT_EQUAL_UINT8(0, after.waiting);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32((QUEUE_SETTLE_MS - 5) * 1000, after.maxWaitUs);
+}
+
+// Setup function: runs once at the beginning
+void setup() {
+    // Wait for the serial monitor to connect
+    delay(2000);
+
+    SdIo::begin();
+    helpersDone = xSemaphoreCreateCounting(MAX_HELPERS, 0);
+
+    // Begin the Unity test framework
+    UNITY_BEGIN();
+    RUN_TEST(test_nested_turns_do_not_block);
+    RUN_TEST(test_higher_priority_goes_first);
+    RUN_TEST(test_same_class_is_fifo);
+    RUN_TEST(test_wait_metrics);
+    // End the Unity test framework and report results
+    UNITY_END();
+}
+
+// Loop function: runs repeatedly after setup (empty for tests)
+void loop() {}
@@ -0,0 +1,156 @@
+// SensorPowerScheduler (standby between cycles, just-in-time wake-ups) tests.
+// Fake sensors advance a manual clock while they wake, like the blocking wrappers do.
+
+// Include necessary libraries
+#include <Arduino.h>            // Arduino core framework
+#include <unity.h>              // Unity test framework
+#include "SensorPower.h"        // Scheduler under test
+
+// --- Shared fixtures ---
+static uint32_t fakeNowMs = 0;
+static uint32_t fakeClock() { return fakeNowMs; }
+
+struct FakeSensor {
+    uint32_t wakeMs;
+    bool failWake;
+    SensorPowerState state;
+    uint32_t readyAtMs;     // Clock value when the last wake-up finished
+
+    explicit FakeSensor(uint32_t wake) : wakeMs(wake), failWake(false), state(SensorPowerState::ACTIVE), readyAtMs(0) {}
+
+    bool setPowerState(SensorPowerState newState) {
+        if (newState == SensorPowerState::ACTIVE) {
+            fakeNowMs += wakeMs;
+            readyAtMs = fakeNowMs;
+            if (failWake) return false;
+        }
+        state = newState;
+        return true;
+    }
+};
+
+// setUp function: runs before each test
+void setUp(void) {
+    fakeNowMs = 1000;
+}
+// tearDown function: runs after each test
+void tearDown(void) {}
+
+// State names round-trip through the config.json spelling
+void test_state_names() {
+    SensorPowerState state = SensorPowerState::ACTIVE;
+    TEST_ASSERT_TRUE(parseSensorPowerState("off", state));
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)SensorPowerState::OFF, (uint8_t)state);
+    TEST_ASSERT_EQUAL_STRING("standby", sensorPowerStateName(SensorPowerState::STANDBY));
+    TEST_ASSERT_FALSE(parseSensorPowerState("sleep", state));
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)SensorPowerState::OFF, (uint8_t)state);
+}
+
+// Sensors are woken in order, each starting only when the remaining lead time requires it
+void test_just_in_time_sequence() {
+    SensorPowerScheduler scheduler;
+    scheduler.setClock(fakeClock);
+    FakeSensor bme(100), camera(400);
+    int8_t bmeIndex = scheduler.add("BME280", bme, 100);
+    int8_t cameraIndex = scheduler.add("OV2640", camera, 400);
+    scheduler.sleepAll();
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)SensorPowerState::STANDBY, (uint8_t)bme.state);
+    TEST_ASSERT_FALSE(scheduler.isAwake(cameraIndex));
+
+    // 500 ms of wake-ups + 25 % + margin
+    uint32_t lead = 500 + 125 + SENSOR_WAKE_MARGIN_MS;
+    TEST_ASSERT_EQUAL_UINT32(lead, scheduler.leadTimeMs());
+    TEST_ASSERT_EQUAL_UINT8(0, scheduler.service(lead + 1));
+    TEST_ASSERT_FALSE(scheduler.isAwake(bmeIndex));
+
+    uint32_t cycleAtMs = fakeNowMs + lead;
+    TEST_ASSERT_EQUAL_UINT8(1, scheduler.service(lead));   // Only the BME280: the camera still has time
+    TEST_ASSERT_TRUE(scheduler.isAwake(bmeIndex));
+    TEST_ASSERT_FALSE(scheduler.isAwake(cameraIndex));
+
+    fakeNowMs = cycleAtMs - scheduler.leadTimeMs();
+    TEST_ASSERT_EQUAL_UINT8(1, scheduler.service(cycleAtMs - fakeNowMs));
+    TEST_ASSERT_TRUE(camera.readyAtMs <= cycleAtMs);
+    TEST_ASSERT_EQUAL_UINT8(0, scheduler.wakeAll());
+    TEST_ASSERT_EQUAL_UINT32(400, scheduler.stats(cameraIndex).lastMs);
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.stats(cameraIndex).lateWakes);
+}
+
+// The lead time follows the measured latency, not the initial guess
+void test_measured_latency() {
+    SensorPowerScheduler scheduler;
+    scheduler.setClock(fakeClock);
+    FakeSensor camera(800);
+    int8_t index = scheduler.add("OV2640", camera, 200);
+    scheduler.sleepAll();
+    TEST_ASSERT_EQUAL_UINT32(200 + 50 + SENSOR_WAKE_MARGIN_MS, scheduler.leadTimeMs());
+
+    TEST_ASSERT_EQUAL_UINT8(1, scheduler.wakeAll());    // Cycle started with the camera asleep
+    const SensorWakeStats& stats = scheduler.stats(index);
+    TEST_ASSERT_EQUAL_UINT32(800, stats.lastMs);
+    TEST_ASSERT_EQUAL_UINT32(800, stats.averageMs);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.lateWakes);
+
+    scheduler.sleep(index);
+    TEST_ASSERT_EQUAL_UINT32(800 + 200 + SENSOR_WAKE_MARGIN_MS, scheduler.leadTimeMs());
+    camera.wakeMs = 400;
+    scheduler.service(0);
+    TEST_ASSERT_EQUAL_UINT32(700, stats.averageMs);     // EWMA: 800 + (400 - 800) / 4
+    TEST_ASSERT_EQUAL_UINT32(800, stats.maxMs);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.wakes);
+
+    char text[64];
+    scheduler.describe(text, sizeof(text));
+    TEST_ASSERT_EQUAL_STRING("OV2640 400/700 ms", text);
+}
+
+// A failed wake-up is counted once and not retried on every loop pass
+void test_failed_wake() {
+    SensorPowerScheduler scheduler;
+    scheduler.setClock(fakeClock);
+    FakeSensor mlx(50);
+    int8_t index = scheduler.add("MLX90640", mlx, 50);
+    scheduler.sleepAll();
+    mlx.failWake = true;
+    TEST_ASSERT_EQUAL_UINT8(1, scheduler.service(0));
+    TEST_ASSERT_TRUE(scheduler.isAwake(index));
+    TEST_ASSERT_EQUAL_UINT8(0, scheduler.service(0));
+    TEST_ASSERT_EQUAL_UINT32(1, scheduler.stats(index).failures);
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.stats(index).wakes);
+}
+
+// Idle state ACTIVE disables power management: sensors never sleep
+void test_idle_active() {
+    SensorPowerScheduler scheduler;
+    scheduler.setClock(fakeClock);
+    FakeSensor bme(100);
+    int8_t index = scheduler.add("BME280", bme, 100);
+    scheduler.setIdleState(SensorPowerState::ACTIVE);
+    scheduler.sleepAll();
+    TEST_ASSERT_TRUE(scheduler.isAwake(index));
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.leadTimeMs());
+    TEST_ASSERT_EQUAL_UINT8(0, scheduler.wakeAll());
+
+    char text[16];
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.describe(text, sizeof(text)));
+    TEST_ASSERT_EQUAL_STRING("", text);
+}
+
+// Setup function: runs once at the beginning
+void setup() {
+    // Wait for the serial monitor to connect
+    delay(2000);
+
+    // Begin the Unity test framework
+    UNITY_BEGIN();
+    RUN_TEST(test_state_names);
+    RUN_TEST(test_just_in_time_sequence);
+    RUN_TEST(test_measured_latency);
+    RUN_TEST(test_failed_wake);
+    RUN_TEST(test_idle_active);
+    // End the Unity test framework and report results
+    UNITY_END();
+}
+
+// Loop function: runs repeatedly after setup (empty for tests)
+void loop() {}
@@ -0,0 +1,177 @@
+// Sensor trace record/replay tests.
+// A synthetic trace is recorded on the SD card and read back. The format and pacing tests
+// only need the library; the wrapper test replays the trace through BH1750Sensor and
+// BME280Sensor, so it needs the firmware built with -D ENABLE_SENSOR_TRACE (no sensors
+// have to be connected). Without an SD card every test is reported as IGNORED.
+
+// Include necessary libraries
+#include <Arduino.h>         // Arduino core framework
+#include <unity.h>           // Unity test framework
+#include <Wire.h>            // I2C bus passed to the wrappers (not used while replaying)
+#include "SDManager.h"       // Mounts the SD card at /sdcard
+#include "SensorTrace.h"     // Recorder / replay driver under test
+#include "BH1750Sensor.h"    // Wrappers fed by the replay
+#include "BME280Sensor.h"
+
+// Trace file used by the tests (stdio path on the SD_MMC mount point)
+#define TEST_TRACE_PATH "/sdcard/test_sensor_trace.trc"
+// Gap between the two recorded light readings
+#define RECORD_GAP_MS 400
+
+// --- Shared fixtures ---
+SDManager testSd;
+bool sdReady = false;
+float recordedFrame[SENSOR_TRACE_THERMAL_PIXELS];
+
+// Records: thermal frame, failed thermal frame, light (x2, RECORD_GAP_MS apart), BME triple, JPEG
+static bool recordFixtureTrace() {
+    if (!SensorTrace::beginRecording(TEST_TRACE_PATH, 1761912000)) return false;
+    for (int i = 0; i < SENSOR_TRACE_THERMAL_PIXELS; i++) {
+        recordedFrame[i] = 15.0f + (float)((i * 37) % 200) / 10.0f;
+    }
+    recordedFrame[100] = NAN;
+
+    SensorTrace::recordThermalFrame(recordedFrame, true);
+    SensorTrace::recordThermalFrame(nullptr, false);
+    SensorTrace::recordScalar(SensorChannel::LIGHT, 1520.5f);
+    delay(RECORD_GAP_MS);
+    SensorTrace::recordScalar(SensorChannel::LIGHT, 1490.0f);
+    SensorTrace::recordScalar(SensorChannel::AMBIENT_TEMPERATURE, 21.25f);
+    SensorTrace::recordScalar(SensorChannel::HUMIDITY, 80.5f);
+    SensorTrace::recordScalar(SensorChannel::PRESSURE, 850.75f);
+    const uint8_t jpeg[] = {0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 0xFF, 0xD9};
+    SensorTrace::recordJpeg(jpeg, sizeof(jpeg));
+    SensorTrace::stop();
+    return true;
+}
+
+// setUp function: runs before each test (skips everything without an SD card)
+void setUp(void) {
+    if (!sdReady) {
+        TEST_IGNORE_MESSAGE("SD card not available");
+    }
+}
+// tearDown function: runs after each test (closes any open trace)
+void tearDown(void) {
+    SensorTrace::stop();
+}
+
+// Every record comes back on its own channel, with failures and NaN pixels preserved
+void test_record_replay_round_trip() {
+    TEST_ASSERT_TRUE_MESSAGE(recordFixtureTrace(), "Could not create the trace file");
+    TEST_ASSERT_TRUE(SensorTrace::beginReplay(TEST_TRACE_PATH, 0.0f));
+    TEST_ASSERT_EQUAL_UINT32(1761912000, SensorTrace::startEpoch());
+    TEST_ASSERT_EQUAL_UINT32(2, SensorTrace::recordCount(SensorChannel::THERMAL_FRAME));
+
+    // Channels are independent: reading the JPEG first does not skip the other records
+    size_t jpegLength = 0;
+    uint8_t* jpeg = SensorTrace::replayJpeg(jpegLength);
+    TEST_ASSERT_NOT_NULL(jpeg);
+    TEST_ASSERT_EQUAL_UINT32(8, jpegLength);
+    TEST_ASSERT_EQUAL_HEX8(0xD9, jpeg[7]);
+    free(jpeg);
+
+    float frame[SENSOR_TRACE_THERMAL_PIXELS];
+    TEST_ASSERT_TRUE(SensorTrace::replayThermalFrame(frame));
+    for (int i = 0; i < SENSOR_TRACE_THERMAL_PIXELS; i++) {
+        if (i == 100) {
+            TEST_ASSERT_TRUE(isnan(frame[i]));
+        } else {
+            TEST_ASSERT_FLOAT_WITHIN(0.006f, recordedFrame[i], frame[i]); // 0.01 C quantization
+        }
+    }
+    TEST_ASSERT_FALSE_MESSAGE(SensorTrace::replayThermalFrame(frame), "Recorded failure was not replayed");
+    TEST_ASSERT_FALSE_MESSAGE(SensorTrace::replayThermalFrame(frame), "Exhausted channel returned data");
+
+    float value;
+    TEST_ASSERT_TRUE(SensorTrace::replayScalar(SensorChannel::LIGHT, value));
+    TEST_ASSERT_EQUAL_FLOAT(1520.5f, value);
+}
+
+// Replay pacing follows the recorded timestamps divided by the speed factor
+void test_replay_speed() {
+    TEST_ASSERT_TRUE(SensorTrace::beginReplay(TEST_TRACE_PATH, 4.0f));
+    float value;
+    unsigned long start = millis();
+    SensorTrace::replayScalar(SensorChannel::LIGHT, value);
+    SensorTrace::replayScalar(SensorChannel::LIGHT, value);
+    unsigned long elapsed = millis() - start;
+
+    TEST_ASSERT_EQUAL_FLOAT(1490.0f, value);
+    // Second reading was recorded RECORD_GAP_MS after the first -> ~RECORD_GAP_MS / 4 at 4x
+    TEST_ASSERT_UINT32_WITHIN(40, RECORD_GAP_MS / 4, elapsed);
+}
+
+// In loop mode an exhausted channel starts again from its first record
+void test_replay_loop() {
+    TEST_ASSERT_TRUE(SensorTrace::beginReplay(TEST_TRACE_PATH, 0.0f, true));
+    float value;
+    SensorTrace::replayScalar(SensorChannel::PRESSURE, value);
+    TEST_ASSERT_TRUE(SensorTrace::replayScalar(SensorChannel::PRESSURE, value));
+    TEST_ASSERT_EQUAL_FLOAT(850.75f, value);
+}
+
+// Each recording session gets the first unused number, so a reboot never truncates the last one
+void test_session_paths() {
+    char first[64];
+    char second[64];
+    TEST_ASSERT_TRUE(SensorTrace::nextSessionPath("/sdcard/test_session.trc", first, sizeof(first)));
+    TEST_ASSERT_TRUE(SensorTrace::beginRecording(first, 0));
+    SensorTrace::recordScalar(SensorChannel::LIGHT, 10.0f);
+    SensorTrace::stop();
+
+    TEST_ASSERT_TRUE(SensorTrace::nextSessionPath("/sdcard/test_session.trc", second, sizeof(second)));
+    TEST_ASSERT_TRUE(strcmp(first, second) != 0);
+    TEST_ASSERT_TRUE(SensorTrace::beginReplay(first, 0.0f));
+    TEST_ASSERT_EQUAL_UINT32(1, SensorTrace::recordCount(SensorChannel::LIGHT));
+    SensorTrace::stop();
+    remove(first);
+
+    TEST_ASSERT_FALSE_MESSAGE(SensorTrace::nextSessionPath("/sdcard/test_session.trc", second, 16), "Name did not fit");
+}
+
+// The sensor wrappers read from the trace (no hardware needed)
+void test_wrappers_replay_trace() {
+#ifndef ENABLE_SENSOR_TRACE
+    TEST_IGNORE_MESSAGE("Build with -D ENABLE_SENSOR_TRACE to replay through the wrappers");
+#else
+    TEST_ASSERT_TRUE(SensorTrace::beginReplay(TEST_TRACE_PATH, 0.0f));
+    BH1750Sensor light(Wire);
+    BME280Sensor bme(Wire);
+    TEST_ASSERT_TRUE_MESSAGE(light.begin(), "BH1750 begin() must succeed while replaying");
+    TEST_ASSERT_TRUE_MESSAGE(bme.begin(), "BME280 begin() must succeed while replaying");
+
+    TEST_ASSERT_EQUAL_FLOAT(1520.5f, light.readLightLevel());
+    TEST_ASSERT_EQUAL_FLOAT(1490.0f, light.readLightLevel());
+    TEST_ASSERT_TRUE_MESSAGE(light.readLightLevel() < 0, "Exhausted light channel must read as an error");
+    TEST_ASSERT_EQUAL_FLOAT(21.25f, bme.readTemperature());
+    TEST_ASSERT_EQUAL_FLOAT(80.5f, bme.readHumidity());
+    TEST_ASSERT_EQUAL_FLOAT(850.75f, bme.readPressure());
+#endif
+}
+
+// Setup function: runs once at the beginning
+void setup() {
+    // Initial delay for stability
+    delay(2000);
+
+    // The trace lives on the SD card
+    sdReady = testSd.begin();
+
+    // Begin the Unity test framework
+    UNITY_BEGIN();
+    RUN_TEST(test_record_replay_round_trip);
+    RUN_TEST(test_replay_speed);
+    RUN_TEST(test_replay_loop);
+    RUN_TEST(test_session_paths);
+    RUN_TEST(test_wrappers_replay_trace);
+    // End the Unity test framework and report results
+    UNITY_END();
+
+    if (sdReady) {
+        testSd.deleteFile("/test_sensor_trace.trc");
+    }
+}
+
+// Loop function: runs repeatedly after setup (empty for tests)
+void loop() {}
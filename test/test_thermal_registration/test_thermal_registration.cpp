@@ -0,0 +1,124 @@
+// ThermalRegistration (canopy mask -> thermal grid) tests.
+// No sensors needed: synthetic masks and thermal frames are projected with known homographies
+// (visual 640x480 -> thermal 32x24) and the canopy-only statistics are checked.
+
+// Include necessary libraries
+#include <Arduino.h>                // Arduino core framework
+#include <unity.h>                  // Unity test framework
+#include "ThermalRegistration.h"    // Projection under test
+
+// Mask size for a VGA frame decoded at 1/8
+#define MASK_WIDTH 80
+#define MASK_HEIGHT 60
+
+// --- Shared fixtures ---
+static uint8_t mask[MASK_WIDTH * MASK_HEIGHT];
+static float thermal[THERMAL_REG_PIXELS];
+// Thermal grid covers exactly the visual frame (20 visual px per thermal px)
+static const float SAME_FOV[9] = {0.05f, 0.0f, 0.0f, 0.0f, 0.05f, 0.0f, 0.0f, 0.0f, 1.0f};
+// Visual frame covers only the central 16x12 thermal pixels (wider thermal lens)
+static const float CENTER_FOV[9] = {0.025f, 0.0f, 8.0f, 0.0f, 0.025f, 6.0f, 0.0f, 0.0f, 1.0f};
+
+// Canopy on the left half of the visual frame; the left half of the thermal frame is warmer
+static void fillHalfScene() {
+    for (int i = 0; i < MASK_WIDTH * MASK_HEIGHT; i++) mask[i] = (i % MASK_WIDTH) < MASK_WIDTH / 2;
+    for (int i = 0; i < THERMAL_REG_PIXELS; i++) thermal[i] = (i % THERMAL_REG_WIDTH) < THERMAL_REG_WIDTH / 2 ? 30.0f : 20.0f;
+}
+
+// setUp function: runs before each test
+void setUp(void) {
+    fillHalfScene();
+}
+// tearDown function: runs after each test
+void tearDown(void) {}
+
+// The config string must hold exactly 9 numbers and a non-singular matrix
+void test_parse_homography() {
+    float h[9];
+    TEST_ASSERT_TRUE(parseHomography("0.05,0,0, 0,0.05,0, 0,0,1", h));
+    TEST_ASSERT_EQUAL_FLOAT(0.05f, h[0]);
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, h[8]);
+    TEST_ASSERT_FALSE(parseHomography("0.05,0,0,0,0.05,0,0,0", h));     // 8 values
+    TEST_ASSERT_FALSE(parseHomography("0.05,0,0,0,0.05,0,0,0,1,1", h)); // 10 values
+    TEST_ASSERT_FALSE(parseHomography("0.05,0,x,0,0.05,0,0,0,1", h));   // Not a number
+    TEST_ASSERT_FALSE(parseHomography("1,2,3,2,4,6,0,0,1", h));         // Singular
+}
+
+// Same field of view: only the warm (canopy) half enters the statistics
+void test_canopy_only_statistics() {
+    ThermalRegistration registration;
+    TEST_ASSERT_TRUE(registration.setHomography(SAME_FOV));
+    CanopyThermalStats stats;
+    TEST_ASSERT_TRUE(registration.project(mask, MASK_WIDTH, MASK_HEIGHT, 8, thermal, stats));
+    TEST_ASSERT_TRUE(stats.valid);
+    TEST_ASSERT_EQUAL_UINT16(THERMAL_REG_PIXELS, stats.coveredPixels);
+    TEST_ASSERT_EQUAL_UINT16(THERMAL_REG_PIXELS / 2, stats.canopyPixels);
+    TEST_ASSERT_EQUAL_FLOAT(30.0f, stats.avgTemp);
+    TEST_ASSERT_EQUAL_FLOAT(30.0f, stats.minTemp);
+    TEST_ASSERT_EQUAL_FLOAT(30.0f, stats.maxTemp);
+    TEST_ASSERT_EQUAL_UINT8(1, registration.canopyPixels()[0]);
+    TEST_ASSERT_EQUAL_UINT8(0, registration.canopyPixels()[THERMAL_REG_WIDTH - 1]);
+}
+
+// Thermal pixels outside the camera view are never canopy; NaN pixels are skipped
+void test_partial_field_of_view_and_nan() {
+    ThermalRegistration registration;
+    TEST_ASSERT_TRUE(registration.setHomography(CENTER_FOV));
+    thermal[6 * THERMAL_REG_WIDTH + 8] = NAN; // First covered pixel (canopy side)
+    thermal[6 * THERMAL_REG_WIDTH + 9] = 35.0f;
+    CanopyThermalStats stats;
+    TEST_ASSERT_TRUE(registration.project(mask, MASK_WIDTH, MASK_HEIGHT, 8, thermal, stats));
+    TEST_ASSERT_EQUAL_UINT16(16 * 12, stats.coveredPixels);
+    TEST_ASSERT_EQUAL_UINT16(8 * 12 - 1, stats.canopyPixels);
+    TEST_ASSERT_EQUAL_FLOAT(35.0f, stats.maxTemp);
+    TEST_ASSERT_EQUAL_UINT8(0, registration.canopyPixels()[0]); // Outside the camera view
+}
+
+// Without calibration, or with too little canopy in view, there are no canopy statistics
+void test_uncalibrated_and_sparse_canopy() {
+    ThermalRegistration registration;
+    CanopyThermalStats stats;
+    TEST_ASSERT_FALSE(registration.project(mask, MASK_WIDTH, MASK_HEIGHT, 8, thermal, stats));
+    TEST_ASSERT_FALSE(stats.valid);
+
+    TEST_ASSERT_TRUE(registration.setHomography(SAME_FOV));
+    memset(mask, 0, sizeof(mask));
+    mask[0] = 1; // A single canopy cell: not enough for its thermal pixel
+    TEST_ASSERT_TRUE(registration.project(mask, MASK_WIDTH, MASK_HEIGHT, 8, thermal, stats));
+    TEST_ASSERT_EQUAL_UINT16(0, stats.canopyPixels);
+    TEST_ASSERT_FALSE(stats.valid);
+
+    registration.clear();
+    TEST_ASSERT_FALSE(registration.isCalibrated());
+}
+
+// A new homography rebuilds the lookup table
+void test_homography_change_rebuilds_table() {
+    ThermalRegistration registration;
+    CanopyThermalStats stats;
+    TEST_ASSERT_TRUE(registration.setHomography(SAME_FOV));
+    TEST_ASSERT_TRUE(registration.project(mask, MASK_WIDTH, MASK_HEIGHT, 8, thermal, stats));
+    TEST_ASSERT_EQUAL_UINT16(THERMAL_REG_PIXELS, stats.coveredPixels);
+    TEST_ASSERT_TRUE(registration.setHomography(CENTER_FOV));
+    TEST_ASSERT_TRUE(registration.project(mask, MASK_WIDTH, MASK_HEIGHT, 8, thermal, stats));
+    TEST_ASSERT_EQUAL_UINT16(16 * 12, stats.coveredPixels);
+}
+
+// Setup function: runs once at the beginning
+void setup() {
+    // Wait for the serial monitor to connect
+    delay(2000);
+
+    // Begin the Unity test framework
+    UNITY_BEGIN();
+    RUN_TEST(test_parse_homography);
+    RUN_TEST(test_canopy_only_statistics);
+    RUN_TEST(test_partial_field_of_view_and_nan);
+    RUN_TEST(test_uncalibrated_and_sparse_canopy);
+    RUN_TEST(test_homography_change_rebuilds_table);
+    // End the Unity test framework and report results
+    UNITY_END();
+}
+
+// Loop function: runs repeatedly after setup (empty for tests)
+void loop() {}
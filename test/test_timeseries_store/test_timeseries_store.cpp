@@ -0,0 +1,280 @@
+// TimeSeriesStore (columnar ambient store) and chart downsampling tests.
+// Synthetic ambient series are appended to a file on the SD card and read back through
+// scan() and aggregate(). No sensors needed. Without an SD card every test is reported as IGNORED.
+
+// Include necessary libraries
+#include <Arduino.h>            // Arduino core framework
+#include <unity.h>              // Unity test framework
+#include <stdio.h>              // fopen/remove on the SD_MMC mount point
+#include "SDManager.h"          // Mounts the SD card at /sdcard
+#include "TimeSeriesStore.h"    // Store under test
+#include "Downsample.h"         // Chart downsampling (LTTB, min/max)
+
+// Store file used by the tests (VFS path on the SD_MMC mount point)
+#define TEST_TS_PATH "/sdcard/test_timeseries.ts"
+// First sample: 2025-10-31 12:00:00 UTC
+#define TEST_START_EPOCH 1761912000UL
+// Ambient task period
+#define TEST_INTERVAL_S 300
+
+// --- Shared fixtures ---
+SDManager testSd;
+bool sdReady = false;
+
+// Slowly varying ambient readings with sensor-like noise (deterministic)
+static void sampleAt(int i, float values[TS_COLUMNS]) {
+    values[TS_LIGHT] = (float)((i * 137) % 4000) / 2.0f;
+    values[TS_TEMPERATURE] = 18.0f + (float)((i * 7) % 50) / 10.0f;
+    values[TS_HUMIDITY] = 80.0f + (float)((i * 3) % 40) / 4.0f;
+    values[TS_PRESSURE] = 850.0f + (float)(i % 8) * 0.25f;
+}
+
+// Timestamps with a small jitter around the ambient period
+static uint32_t timeAt(int i) {
+    return TEST_START_EPOCH + (uint32_t)i * TEST_INTERVAL_S + (uint32_t)((i * 13) % 3);
+}
+
+static int appendSeries(TimeSeriesStore& store, int count) {
+    float values[TS_COLUMNS];
+    for (int i = 0; i < count; i++) {
+        sampleAt(i, values);
+        if (store.append(TEST_TS_PATH, timeAt(i), values) != TS_OK) return i;
+    }
+    return count;
+}
+
+static long fileSize() {
+    FILE* f = fopen(TEST_TS_PATH, "rb");
+    if (!f) return -1;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fclose(f);
+    return size;
+}
+
+// Collects scanned samples and checks them against the generator
+struct ScanCheck {
+    int next;
+    bool matches;
+};
+
+static bool checkSample(uint32_t time, const float values[TS_COLUMNS], void* context) {
+    ScanCheck* check = (ScanCheck*)context;
+    float expected[TS_COLUMNS];
+    sampleAt(check->next, expected);
+    if (time != timeAt(check->next) || memcmp(values, expected, sizeof(expected)) != 0) check->matches = false;
+    check->next++;
+    return true;
+}
+
+// setUp function: runs before each test (skips everything without an SD card)
+void setUp(void) {
+    if (!sdReady) {
+        TEST_IGNORE_MESSAGE("SD card not available");
+    }
+    remove(TEST_TS_PATH);
+}
+// tearDown function: runs after each test
+void tearDown(void) {}
+
+// Samples come back bit-exact (NaN included) after reopening the file with a new store
+void test_append_scan_round_trip() {
+    TimeSeriesStore store;
+    TEST_ASSERT_EQUAL_INT(10, appendSeries(store, 10));
+    TEST_ASSERT_EQUAL_INT32(TS_BLOCK_BYTES, fileSize());
+
+    TimeSeriesStore reader;
+    ScanCheck check = {0, true};
+    TsReadStats stats;
+    TEST_ASSERT_TRUE(reader.scan(TEST_TS_PATH, 0, UINT32_MAX, checkSample, &check, &stats));
+    TEST_ASSERT_TRUE(check.matches);
+    TEST_ASSERT_EQUAL_INT(10, check.next);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.blocksDecoded);
+
+    // A failed reading is stored as NaN and excluded from the block summary
+    float values[TS_COLUMNS] = {NAN, 20.0f, 85.0f, 851.0f};
+    TEST_ASSERT_EQUAL_INT(TS_OK, reader.append(TEST_TS_PATH, timeAt(10), values));
+    TsAggregate aggregate[TS_COLUMNS];
+    TEST_ASSERT_TRUE(reader.aggregate(TEST_TS_PATH, 0, UINT32_MAX, aggregate));
+    TEST_ASSERT_EQUAL_UINT32(10, aggregate[TS_LIGHT].count);
+    TEST_ASSERT_EQUAL_UINT32(11, aggregate[TS_PRESSURE].count);
+}
+
+// Timestamps must increase; a rejected sample leaves the file untouched
+void test_out_of_order_rejected() {
+    TimeSeriesStore store;
+    float values[TS_COLUMNS];
+    sampleAt(0, values);
+    TEST_ASSERT_EQUAL_INT(TS_ERR_ARGS, store.append(TEST_TS_PATH, 0, values)); // Clock not synced
+    TEST_ASSERT_EQUAL_INT(TS_OK, store.append(TEST_TS_PATH, TEST_START_EPOCH, values));
+    TEST_ASSERT_EQUAL_INT(TS_ERR_OUT_OF_ORDER, store.append(TEST_TS_PATH, TEST_START_EPOCH, values));
+    TEST_ASSERT_EQUAL_INT(TS_ERR_OUT_OF_ORDER, store.append(TEST_TS_PATH, TEST_START_EPOCH - 60, values));
+    TEST_ASSERT_EQUAL_UINT32(1, store.appendedSamples());
+    TEST_ASSERT_EQUAL_INT32(TS_BLOCK_BYTES, fileSize());
+}
+
+// A full day rolls over into several sector-sized blocks, all decodable in order
+void test_block_rollover() {
+    TimeSeriesStore store;
+    const int samples = 288; // One day at TEST_INTERVAL_S
+    TEST_ASSERT_EQUAL_INT(samples, appendSeries(store, samples));
+    long size = fileSize();
+    TEST_ASSERT_EQUAL_INT32(0, size % TS_BLOCK_BYTES);
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)(size / TS_BLOCK_BYTES), store.startedBlocks());
+    // Compression: at least 20 samples per block (a JSON file per sample is ~150 bytes + a cluster)
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(samples / 20, store.startedBlocks());
+
+    ScanCheck check = {0, true};
+    TEST_ASSERT_TRUE(store.scan(TEST_TS_PATH, 0, UINT32_MAX, checkSample, &check));
+    TEST_ASSERT_TRUE(check.matches);
+    TEST_ASSERT_EQUAL_INT(samples, check.next);
+}
+
+// Range aggregates match a brute-force pass; whole blocks use their header summary
+void test_range_aggregate() {
+    TimeSeriesStore store;
+    const int samples = 288;
+    TEST_ASSERT_EQUAL_INT(samples, appendSeries(store, samples));
+
+    const int first = 40, last = 250;
+    TsAggregate aggregate[TS_COLUMNS];
+    TsReadStats stats;
+    TEST_ASSERT_TRUE(store.aggregate(TEST_TS_PATH, timeAt(first), timeAt(last), aggregate, &stats));
+    for (int c = 0; c < TS_COLUMNS; c++) {
+        float values[TS_COLUMNS];
+        float minValue = INFINITY, maxValue = -INFINITY;
+        double sum = 0.0;
+        for (int i = first; i <= last; i++) {
+            sampleAt(i, values);
+            minValue = min(minValue, values[c]);
+            maxValue = max(maxValue, values[c]);
+            sum += values[c];
+        }
+        TEST_ASSERT_EQUAL_UINT32(last - first + 1, aggregate[c].count);
+        TEST_ASSERT_EQUAL_FLOAT(minValue, aggregate[c].min);
+        TEST_ASSERT_EQUAL_FLOAT(maxValue, aggregate[c].max);
+        TEST_ASSERT_FLOAT_WITHIN(0.01f, (float)(sum / (last - first + 1)), aggregate[c].avg());
+    }
+    TEST_ASSERT_GREATER_THAN_UINT32(0, stats.blocksSummarized);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(2, stats.blocksDecoded); // Only the blocks at the range edges
+
+    // scan() stops at the first block past the range
+    ScanCheck check = {first, true};
+    TEST_ASSERT_TRUE(store.scan(TEST_TS_PATH, timeAt(first), timeAt(first + 5), checkSample, &check));
+    TEST_ASSERT_TRUE(check.matches);
+    TEST_ASSERT_EQUAL_INT(first + 6, check.next);
+}
+
+// A damaged last block is skipped by readers and appends continue in a new block
+void test_corrupt_last_block() {
+    TimeSeriesStore store;
+    TEST_ASSERT_EQUAL_INT(150, appendSeries(store, 150));
+    long size = fileSize();
+    TEST_ASSERT_GREATER_THAN_INT32(TS_BLOCK_BYTES, size);
+
+    // Flip one payload byte of the last block (as a write torn by a power cut would)
+    FILE* f = fopen(TEST_TS_PATH, "r+b");
+    TEST_ASSERT_NOT_NULL(f);
+    fseek(f, size - 10, SEEK_SET);
+    uint8_t byte = (uint8_t)fgetc(f);
+    fseek(f, size - 10, SEEK_SET);
+    fputc(byte ^ 0x5A, f);
+    fclose(f);
+
+    TimeSeriesStore recovered;
+    TsReadStats stats;
+    TsAggregate aggregate[TS_COLUMNS];
+    TEST_ASSERT_TRUE(recovered.aggregate(TEST_TS_PATH, 0, UINT32_MAX, aggregate, &stats));
+    TEST_ASSERT_EQUAL_UINT32(1, stats.corruptBlocks);
+    uint32_t kept = aggregate[TS_PRESSURE].count;
+    TEST_ASSERT_LESS_THAN_UINT32(150, kept);
+
+    float values[TS_COLUMNS];
+    sampleAt(150, values);
+    TEST_ASSERT_EQUAL_INT(TS_OK, recovered.append(TEST_TS_PATH, timeAt(150), values));
+    TEST_ASSERT_EQUAL_UINT32(1, recovered.corruptTailBlocks());
+    TEST_ASSERT_EQUAL_INT32(size + TS_BLOCK_BYTES, fileSize());
+
+    TsAggregate after[TS_COLUMNS];
+    TEST_ASSERT_TRUE(recovered.aggregate(TEST_TS_PATH, 0, UINT32_MAX, after));
+    TEST_ASSERT_EQUAL_UINT32(kept + 1, after[TS_PRESSURE].count);
+}
+
+// Slow sine with a single spike, as a day of temperatures with a short hot spell
+static void chartSeries(TsPoint* points, int count, int spikeAt) {
+    for (int i = 0; i < count; i++) {
+        points[i].time = timeAt(i);
+        points[i].value = 20.0f + 5.0f * sinf((float)i / 40.0f);
+    }
+    points[spikeAt].value = 45.0f;
+}
+
+// LTTB keeps the first and last points, the spike and the time order
+void test_downsample_lttb() {
+    const int count = 2000, threshold = 100;
+    static TsPoint raw[2000];
+    static TsPoint out[100];
+    chartSeries(raw, count, 1234);
+
+    TEST_ASSERT_EQUAL_UINT32(threshold, downsampleLttb(raw, count, threshold, out));
+    TEST_ASSERT_EQUAL_UINT32(raw[0].time, out[0].time);
+    TEST_ASSERT_EQUAL_UINT32(raw[count - 1].time, out[threshold - 1].time);
+    bool spikeKept = false;
+    for (int i = 0; i < threshold; i++) {
+        if (out[i].value == 45.0f) spikeKept = true;
+        if (i > 0) TEST_ASSERT_GREATER_THAN_UINT32(out[i - 1].time, out[i].time);
+    }
+    TEST_ASSERT_TRUE(spikeKept);
+
+    // Short series are copied as they are
+    TEST_ASSERT_EQUAL_UINT32(50, downsampleLttb(raw, 50, threshold, out));
+    TEST_ASSERT_EQUAL_MEMORY(raw, out, 50 * sizeof(TsPoint));
+}
+
+// Min/max keeps the exact extremes of the series and never exceeds the threshold
+void test_downsample_minmax() {
+    const int count = 2000, threshold = 100;
+    static TsPoint raw[2000];
+    static TsPoint out[100];
+    chartSeries(raw, count, 77);
+    raw[1500].value = -3.0f;
+
+    size_t written = downsampleMinMax(raw, count, threshold, out);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(threshold, written);
+    float minValue = INFINITY, maxValue = -INFINITY;
+    for (size_t i = 0; i < written; i++) {
+        minValue = min(minValue, out[i].value);
+        maxValue = max(maxValue, out[i].value);
+        if (i > 0) TEST_ASSERT_GREATER_THAN_UINT32(out[i - 1].time, out[i].time);
+    }
+    TEST_ASSERT_EQUAL_FLOAT(-3.0f, minValue);
+    TEST_ASSERT_EQUAL_FLOAT(45.0f, maxValue);
+}
+
+// Setup function: runs once at the beginning
+void setup() {
+    // Initial delay for stability
+    delay(2000);
+
+    // The store lives on the SD card
+    sdReady = testSd.begin();
+
+    // Begin the Unity test framework
+    UNITY_BEGIN();
+    RUN_TEST(test_append_scan_round_trip);
+    RUN_TEST(test_out_of_order_rejected);
+    RUN_TEST(test_block_rollover);
+    RUN_TEST(test_range_aggregate);
+    RUN_TEST(test_corrupt_last_block);
+    RUN_TEST(test_downsample_lttb);
+    RUN_TEST(test_downsample_minmax);
+    // End the Unity test framework and report results
+    UNITY_END();
+
+    if (sdReady) {
+        remove(TEST_TS_PATH);
+    }
+}
+
+// Loop function: runs repeatedly after setup (empty for tests)
+void loop() {}
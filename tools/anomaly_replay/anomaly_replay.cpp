@@ -0,0 +1,159 @@
+// Reproducción en el host del detector de anomalías térmicas (lib/AnomalyDetector) sobre
+// series reales copiadas de la SD, para ajustar los parámetros burst_* antes de subirlos.
+//
+// Las series se exportan con tools/decode_timeseries.py:
+//     python3 tools/decode_timeseries.py 202510*_ambient.ts > ambiente.csv
+//     python3 tools/decode_timeseries.py 202510*_thermal.ts > termica.csv
+//
+// Compilar y ejecutar (Linux, sin dependencias):
+//     g++ -std=c++17 -O2 -Ilib/AnomalyDetector tools/anomaly_replay/anomaly_replay.cpp lib/AnomalyDetector/AnomalyDetector.cpp -o anomaly_replay
+//     ./anomaly_replay ambiente.csv termica.csv --z 3 --interval 5 --duration 60 --cooldown 180 --budget 24
+//
+// Cada captura usa canopy_avg (o thermal_avg si no hay calibración) y la lectura ambiental
+// más reciente de como mucho MAX_AIR_AGE_S antes. Se imprime cada captura fuera de lo normal
+// y cuántas capturas extra habría programado cada ráfaga; las capturas de ráfaga no existen
+// en la traza, así que entre dos capturas reales solo se cuenta la cadencia.
+
+#include "AnomalyDetector.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+
+#define MAX_AIR_AGE_S 900   // El ciclo lee el ambiente justo antes de la captura
+
+struct Row {
+    uint32_t time;
+    std::vector<float> values;   // Columnas tras epoch,time_utc (NaN si vacías)
+};
+
+// Lee un CSV de decode_timeseries.py: cabecera y filas epoch,time_utc,col1,...
+static bool loadCsv(const char* path, std::vector<std::string>& columns, std::vector<Row>& rows) {
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+    char line[512];
+    bool header = true;
+    while (fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        std::vector<std::string> fields;
+        for (char* p = line;; ) {
+            char* comma = strchr(p, ',');
+            fields.push_back(std::string(p, comma ? comma - p : strlen(p)));
+            if (!comma) break;
+            p = comma + 1;
+        }
+        if (fields.size() < 3) continue;
+        if (header) {
+            columns.assign(fields.begin() + 2, fields.end());
+            header = false;
+            continue;
+        }
+        Row row;
+        row.time = (uint32_t)strtoul(fields[0].c_str(), nullptr, 10);
+        for (size_t i = 2; i < fields.size(); i++) row.values.push_back(fields[i].empty() ? NAN : strtof(fields[i].c_str(), nullptr));
+        rows.push_back(row);
+    }
+    fclose(f);
+    return !header;
+}
+
+static int columnIndex(const std::vector<std::string>& columns, const char* name) {
+    for (size_t i = 0; i < columns.size(); i++) {
+        if (columns[i] == name) return (int)i;
+    }
+    return -1;
+}
+
+static float valueAt(const Row& row, int column) {
+    return column >= 0 && (size_t)column < row.values.size() ? row.values[column] : NAN;
+}
+
+static const char* resultName(AnomalyResult result) {
+    switch (result) {
+        case ANOMALY_SKIPPED: return "skipped";
+        case ANOMALY_LEARNING: return "learning";
+        case ANOMALY_NORMAL: return "normal";
+        case ANOMALY_SUPPRESSED: return "suppressed";
+        case ANOMALY_TRIGGERED: return "TRIGGERED";
+    }
+    return "?";
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Uso: %s ambiente.csv termica.csv [--z 3] [--interval 5] [--duration 60] [--cooldown 180] [--budget 24] [--alpha 0.05]\n", argv[0]);
+        return 1;
+    }
+    AnomalyConfig config;
+    for (int i = 3; i + 1 < argc; i += 2) {
+        float value = strtof(argv[i + 1], nullptr);
+        if (!strcmp(argv[i], "--z")) config.zThreshold = value;
+        else if (!strcmp(argv[i], "--interval")) config.burstIntervalSeconds = (uint32_t)(value * 60);
+        else if (!strcmp(argv[i], "--duration")) config.burstDurationSeconds = (uint32_t)(value * 60);
+        else if (!strcmp(argv[i], "--cooldown")) config.cooldownSeconds = (uint32_t)(value * 60);
+        else if (!strcmp(argv[i], "--budget")) config.maxBurstCapturesPerDay = (uint16_t)value;
+        else if (!strcmp(argv[i], "--alpha")) config.alpha = value;
+        else {
+            fprintf(stderr, "Opción desconocida: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    std::vector<std::string> ambientColumns, thermalColumns;
+    std::vector<Row> ambient, thermal;
+    if (!loadCsv(argv[1], ambientColumns, ambient) || !loadCsv(argv[2], thermalColumns, thermal)) {
+        fprintf(stderr, "No se pudieron leer los CSV (salida de tools/decode_timeseries.py)\n");
+        return 1;
+    }
+    int airColumn = columnIndex(ambientColumns, "temperature");
+    int canopyColumn = columnIndex(thermalColumns, "canopy_avg");
+    int frameColumn = columnIndex(thermalColumns, "thermal_avg");
+    if (airColumn < 0 || frameColumn < 0) {
+        fprintf(stderr, "Faltan columnas: se espera un CSV *_ambient.ts y otro *_thermal.ts\n");
+        return 1;
+    }
+
+    AnomalyDetector detector(config);
+    size_t nextAir = 0;
+    int triggers = 0, extraCaptures = 0, unmatched = 0;
+    for (size_t i = 0; i < thermal.size(); i++) {
+        const Row& capture = thermal[i];
+        while (nextAir < ambient.size() && ambient[nextAir].time <= capture.time) nextAir++;
+        if (nextAir == 0 || capture.time - ambient[nextAir - 1].time > MAX_AIR_AGE_S) {
+            unmatched++;
+            continue;
+        }
+        float surface = valueAt(capture, canopyColumn);
+        if (isnan(surface)) surface = valueAt(capture, frameColumn);
+        float air = valueAt(ambient[nextAir - 1], airColumn);
+
+        AnomalyResult result = detector.update(capture.time, surface, air);
+        if (result == ANOMALY_TRIGGERED) triggers++;
+        if (result == ANOMALY_TRIGGERED || result == ANOMALY_SUPPRESSED) {
+            printf("%u %-10s z=%.2f surface-air=%.2f baseline=%.2f+-%.2f\n", (unsigned)capture.time, resultName(result),
+                   detector.lastZ(), surface - air, detector.baselineMean(), detector.baselineStd());
+        }
+
+        // Cadencia que habría seguido el planificador hasta la siguiente captura real
+        uint32_t until = i + 1 < thermal.size() ? thermal[i + 1].time : capture.time + 86400;
+        uint32_t now = capture.time;
+        uint32_t delay;
+        int scheduled = 0;
+        while (now < until && (delay = detector.nextBurstDelay(now)) > 0) {
+            now += delay;
+            scheduled++;
+        }
+        if (scheduled > 0) {
+            extraCaptures += scheduled;
+            printf("%u burst      %d extra captures scheduled\n", (unsigned)capture.time, scheduled);
+        }
+    }
+
+    printf("captures=%zu unmatched=%d triggers=%d extra_captures=%d learned=%u baseline=%.2f+-%.2f\n",
+           thermal.size(), unmatched, triggers, extraCaptures, (unsigned)detector.state().samples,
+           detector.baselineMean(), detector.baselineStd());
+    return 0;
+}
@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+"""
+Compara los resultados del suite de benchmarks (test/test_benchmarks) con la
+línea base versionada y marca las regresiones.
+
+Lee las líneas "BENCH_JSON {...}" de la salida de `pio test` (el resto se ignora).
+
+Uso:
+    pio test -e freenove_esp32_s3_wroom -f test_benchmarks -v > bench.log
+    python3 tools/bench_compare.py bench.log
+    python3 tools/bench_compare.py bench.log --threshold 15
+    python3 tools/bench_compare.py bench.log --write-baseline   # actualiza la línea base
+
+Los kernels puros también se miden en el PC con tools/host_bench, contra su propia línea base:
+    ./host_bench > bench_host.log
+    python3 tools/bench_compare.py bench_host.log --host
+
+Código de salida: 0 sin regresiones, 1 si alguna métrica empeora más que el umbral
+o si la línea base está vacía (sin referencia no hay nada que comprobar).
+"""
+import argparse
+import json
+import os
+import sys
+
+PREFIX = "BENCH_JSON "
+DEFAULT_BASELINE = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                "..", "test", "test_benchmarks", "baseline.json")
+DEFAULT_HOST_BASELINE = os.path.join(os.path.dirname(DEFAULT_BASELINE), "baseline_host.json")
+# Métricas de tiempo comparadas (la media y el p95 capturan tanto el coste típico como los picos)
+TIME_METRICS = ("mean_us", "p95_us")
+# Bajo este tiempo absoluto las diferencias son ruido del contador
+MIN_SIGNIFICANT_US = 2.0
+
+
+def load_results(path):
+    """Devuelve {nombre: resultado} con las líneas BENCH_JSON del log."""
+    results = {}
+    with open(path, encoding="utf-8", errors="replace") as f:
+        for line in f:
+            idx = line.find(PREFIX)
+            if idx < 0:
+                continue
+            try:
+                entry = json.loads(line[idx + len(PREFIX):].strip())
+            except ValueError:
+                continue
+            results[entry["name"]] = entry
+    return results
+
+
+def load_baseline(path):
+    if not os.path.exists(path):
+        return {}
+    with open(path, encoding="utf-8") as f:
+        return json.load(f).get("benchmarks", {})
+
+
+def write_baseline(path, results, board):
+    data = {
+        "board": board,
+        "note": "Generated by tools/bench_compare.py --write-baseline",
+        "benchmarks": {name: {k: v for k, v in r.items() if k != "name"}
+                       for name, r in sorted(results.items())},
+    }
+    with open(path, "w", encoding="utf-8") as f:
+        json.dump(data, f, indent=2)
+        f.write("\n")
+
+
+def compare(results, baseline, threshold_pct):
+    """Imprime la tabla comparativa. Devuelve la lista de regresiones."""
+    regressions = []
+    print("%-26s %12s %12s %9s  %s" % ("benchmark", "base mean", "mean", "delta", "heap (int/psram)"))
+    for name in sorted(results):
+        r = results[name]
+        base = baseline.get(name)
+        heap = "%d/%d" % (r.get("heap_delta_internal", 0), r.get("heap_delta_psram", 0))
+        if base is None:
+            print("%-26s %12s %12.2f %9s  %s" % (name, "-", r["mean_us"], "new", heap))
+            continue
+
+        delta = (r["mean_us"] - base["mean_us"]) / base["mean_us"] * 100.0 if base["mean_us"] else 0.0
+        print("%-26s %12.2f %12.2f %+8.1f%%  %s" % (name, base["mean_us"], r["mean_us"], delta, heap))
+
+        for metric in TIME_METRICS:
+            old, new = base.get(metric, 0.0), r.get(metric, 0.0)
+            if old <= 0 or max(old, new) < MIN_SIGNIFICANT_US:
+                continue
+            change = (new - old) / old * 100.0
+            if change > threshold_pct:
+                regressions.append("%s: %s %.2f -> %.2f us (%+.1f%%)" % (name, metric, old, new, change))
+
+        # Un benchmark que antes no retenía memoria y ahora sí es una posible fuga
+        for metric in ("heap_delta_internal", "heap_delta_psram"):
+            if base.get(metric, 0) <= 0 < r.get(metric, 0):
+                regressions.append("%s: %s %d -> %d bytes" % (name, metric, base.get(metric, 0), r[metric]))
+
+    missing = sorted(set(baseline) - set(results))
+    for name in missing:
+        print("%-26s %12.2f %12s %9s" % (name, baseline[name]["mean_us"], "-", "missing"))
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare ArandanoIRT benchmark results with the baseline.")
+    parser.add_argument("log", help="Output of `pio test -f test_benchmarks -v`")
+    parser.add_argument("--baseline", default=None, help="Baseline JSON file (default: the device baseline)")
+    parser.add_argument("--host", action="store_true", help="Use the host baseline (tools/host_bench results)")
+    parser.add_argument("--threshold", type=float, default=10.0, help="Allowed slowdown in percent (default 10)")
+    parser.add_argument("--write-baseline", action="store_true", help="Replace the baseline with these results")
+    parser.add_argument("--board", default="freenove_esp32_s3_wroom", help="Board name stored in the baseline")
+    args = parser.parse_args()
+
+    if args.baseline is None:
+        args.baseline = DEFAULT_HOST_BASELINE if args.host else DEFAULT_BASELINE
+
+    results = load_results(args.log)
+    if not results:
+        sys.exit("No %s lines found in %s" % (PREFIX.strip(), args.log))
+
+    if args.write_baseline:
+        write_baseline(args.baseline, results, args.board)
+        print("Baseline written to %s (%d benchmarks)" % (args.baseline, len(results)))
+        return
+
+    baseline = load_baseline(args.baseline)
+    if not baseline:
+        sys.exit("Baseline %s is empty: record it first with --write-baseline." % args.baseline)
+    regressions = compare(results, baseline, args.threshold)
+
+    if regressions:
+        print("\nREGRESSIONS (> %.1f%%):" % args.threshold)
+        for r in regressions:
+            print("  " + r)
+        sys.exit(1)
+    print("\nNo regressions.")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+"""
+Decodificador de host para los logs binarios (/logs/YYYYMMDD_log.bin).
+
+Lee la tabla de mensajes directamente de lib/EventLog/EventLogMessages.def,
+por lo que siempre coincide con el firmware compilado desde el mismo árbol.
+
+Uso:
+    python3 tools/decode_eventlog.py 20251031_log.bin [otro.bin ...]
+    python3 tools/decode_eventlog.py --table ruta/EventLogMessages.def archivo.bin
+"""
+import argparse
+import os
+import re
+import struct
+import sys
+
+SYNC_BYTE = 0xA5
+MAGIC = b"EVL1"
+MAX_PAYLOAD = 128
+
+DEFAULT_TABLE = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                             "..", "lib", "EventLog", "EventLogMessages.def")
+
+EVENT_RE = re.compile(r'^\s*EVENT\(\s*(\w+)\s*,\s*(\w+)\s*,\s*\w+\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)', re.MULTILINE)
+SPEC_RE = re.compile(r"%%|%[-0-9.]*[duefs]")
+
+
+def load_table(path):
+    """Devuelve [(nombre, nivel, formato)] en el orden de la tabla (= ID)."""
+    with open(path, encoding="utf-8") as f:
+        source = f.read()
+    # Quita comentarios para no capturar ejemplos de la cabecera
+    source = re.sub(r"/\*.*?\*/", "", source, flags=re.DOTALL)
+    source = re.sub(r"//[^\n]*", "", source)
+    return [(m.group(1), m.group(2), bytes(m.group(3), "utf-8").decode("unicode_escape"))
+            for m in EVENT_RE.finditer(source)]
+
+
+def crc8(data, crc=0):
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def read_varint(data, pos):
+    value, shift = 0, 0
+    while shift < 35:
+        if pos >= len(data):
+            raise ValueError("varint truncated")
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return value, pos
+        shift += 7
+    raise ValueError("varint too long")
+
+
+def unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+def format_payload(payload, table, file_date):
+    seconds, pos = read_varint(payload, 0)
+    header, pos = read_varint(payload, pos)
+    event_id, has_temp, is_uptime = header >> 2, bool(header & 2), bool(header & 1)
+    if event_id >= len(table):
+        raise ValueError("unknown event id %d" % event_id)
+    _, level, fmt = table[event_id]
+
+    temp = None
+    if has_temp:
+        raw, pos = read_varint(payload, pos)
+        temp = unzigzag(raw) / 10.0
+
+    if not is_uptime and file_date:
+        stamp = "%s-%s-%sT%02d:%02d:%02d" % (file_date[0:4], file_date[4:6], file_date[6:8],
+                                             seconds // 3600, (seconds // 60) % 60, seconds % 60)
+    else:
+        stamp = "UPTIME_%02dh%02dm%02ds" % ((seconds // 3600) % 24, (seconds // 60) % 60, seconds % 60)
+
+    out = []
+    last = 0
+    for m in SPEC_RE.finditer(fmt):
+        out.append(fmt[last:m.start()])
+        last = m.end()
+        spec = m.group(0)
+        if spec == "%%":
+            out.append("%")
+            continue
+        conv = spec[-1]
+        if conv == "d":
+            raw, pos = read_varint(payload, pos)
+            out.append(spec % unzigzag(raw))
+        elif conv == "u":
+            raw, pos = read_varint(payload, pos)
+            out.append(spec % raw)
+        elif conv == "f":
+            if pos + 4 > len(payload):
+                raise ValueError("float truncated")
+            out.append(spec % struct.unpack_from("<f", payload, pos)[0])
+            pos += 4
+        elif conv == "s":
+            length, pos = read_varint(payload, pos)
+            if pos + length > len(payload):
+                raise ValueError("string truncated")
+            out.append(payload[pos:pos + length].decode("utf-8", "replace"))
+            pos += length
+        else:
+            raise ValueError("unsupported spec %s" % spec)
+    out.append(fmt[last:])
+
+    if pos != len(payload):
+        raise ValueError("trailing bytes")
+
+    line = "%s [%s] %s" % (stamp, level, "".join(out))
+    if temp is not None:
+        line += " (DevTemp: %.1fC )" % temp
+    return line
+
+
+def decode_file(path, table, out=sys.stdout):
+    """Decodifica un archivo. Devuelve (tramas válidas, bytes descartados)."""
+    with open(path, "rb") as f:
+        data = f.read()
+    name = os.path.basename(path)
+    file_date = name[:8] if name[:8].isdigit() else ""
+
+    pos = len(MAGIC) if data.startswith(MAGIC) else 0
+    frames, skipped = 0, 0
+    while pos < len(data):
+        if data[pos] != SYNC_BYTE:
+            pos += 1
+            skipped += 1
+            continue
+        length = data[pos + 1] if pos + 1 < len(data) else 0
+        end = pos + 2 + length
+        if length == 0 or length > MAX_PAYLOAD or end >= len(data):
+            pos += 1
+            skipped += 1
+            continue
+        payload = data[pos + 2:end]
+        if crc8(data[pos + 1:end]) != data[end]:
+            pos += 1
+            skipped += 1
+            continue
+        try:
+            line = format_payload(payload, table, file_date)
+        except ValueError:
+            pos += 1
+            skipped += 1
+            continue
+        out.write(line + "\n")
+        frames += 1
+        pos = end + 1
+    return frames, skipped
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode ArandanoIRT binary event logs (*_log.bin).")
+    parser.add_argument("files", nargs="+", help="Binary log files to decode")
+    parser.add_argument("--table", default=DEFAULT_TABLE, help="Path to EventLogMessages.def")
+    args = parser.parse_args()
+
+    table = load_table(args.table)
+    if not table:
+        sys.exit("No EVENT(...) entries found in %s" % args.table)
+
+    for path in args.files:
+        frames, skipped = decode_file(path, table)
+        if skipped:
+            sys.stderr.write("%s: %d frames, %d corrupt bytes skipped\n" % (path, frames, skipped))
+
+
+if __name__ == "__main__":
+    main()
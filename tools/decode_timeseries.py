@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+"""
+Decodificador de host para las series diarias (/archive/timeseries/YYYYMMDD_ambient.ts y
+YYYYMMDD_thermal.ts).
+
+Mismo formato que lib/TimeSeriesStore: bloques de 512 bytes con una cabecera de 84 bytes
+(rango de tiempo, resumen por columna y CRC-32) y las muestras comprimidas al estilo
+Gorilla (delta de deltas para el tiempo, XOR para los valores). Los bloques dañados se
+indican y se saltan. Los nombres de las columnas salen del sufijo del archivo.
+
+Uso:
+    python3 tools/decode_timeseries.py 20251031_ambient.ts [otro.ts ...] > ambiente.csv
+    python3 tools/decode_timeseries.py --blocks 20251031_ambient.ts
+"""
+import argparse
+import datetime
+import math
+import struct
+import sys
+import zlib
+
+BLOCK_BYTES = 512
+HEADER = struct.Struct("<HHHHII" + "fffHH" * 4 + "I")
+HEADER_BYTES = HEADER.size  # 84
+MAGIC = 0x5453
+VERSION = 1
+COLUMNS = ("light", "temperature", "humidity", "pressure")
+THERMAL_COLUMNS = ("thermal_max", "thermal_min", "thermal_avg", "canopy_avg")
+TIME_BUCKET_BITS = (7, 9, 12)
+
+
+class BitReader:
+    def __init__(self, data, limit):
+        self.data = data
+        self.limit = limit
+        self.pos = 0
+
+    def read(self, count):
+        if self.pos + count > self.limit:
+            raise ValueError("payload truncated")
+        value = 0
+        for _ in range(count):
+            value = (value << 1) | ((self.data[self.pos >> 3] >> (7 - (self.pos & 7))) & 1)
+            self.pos += 1
+        return value
+
+
+def as_float(bits):
+    return struct.unpack("<f", struct.pack("<I", bits))[0]
+
+
+def parse_header(block):
+    fields = HEADER.unpack_from(block)
+    header = {"magic": fields[0], "count": fields[1], "bits": fields[2], "version": fields[3],
+              "first": fields[4], "last": fields[5], "crc": fields[-1], "columns": []}
+    for c in range(len(COLUMNS)):
+        lo, hi, total, valid, _ = fields[6 + c * 5: 11 + c * 5]
+        header["columns"].append((lo, hi, total, valid))
+    return header
+
+
+def is_valid(block, header):
+    if header["magic"] != MAGIC or header["version"] != VERSION:
+        return False
+    if header["count"] == 0 or header["bits"] > (BLOCK_BYTES - HEADER_BYTES) * 8 or header["last"] < header["first"]:
+        return False
+    zeroed = block[:HEADER_BYTES - 4] + b"\0\0\0\0" + block[HEADER_BYTES:]
+    return zlib.crc32(zeroed) == header["crc"]
+
+
+def decode_block(block, header):
+    """Devuelve [(época, [valores])] del bloque."""
+    reader = BitReader(block[HEADER_BYTES:], header["bits"])
+    samples = []
+    values = [0] * len(COLUMNS)
+    leading = [0] * len(COLUMNS)
+    trailing = [None] * len(COLUMNS)
+    time, delta = header["first"], 0
+    for i in range(header["count"]):
+        if i == 0:
+            values = [reader.read(32) for _ in COLUMNS]
+        else:
+            ones = 0
+            while ones < 4 and reader.read(1):
+                ones += 1
+            dod = 0
+            if 0 < ones < 4:
+                width = TIME_BUCKET_BITS[ones - 1]
+                dod = reader.read(width) - ((1 << (width - 1)) - 1)
+            elif ones == 4:
+                dod = struct.unpack("<i", struct.pack("<I", reader.read(32)))[0]
+            delta += dod
+            time += delta
+            for c in range(len(COLUMNS)):
+                if not reader.read(1):
+                    continue
+                if not reader.read(1):
+                    if trailing[c] is None:
+                        raise ValueError("window reused before being set")
+                    bits = reader.read(32 - leading[c] - trailing[c])
+                else:
+                    leading[c] = reader.read(5)
+                    length = reader.read(5) + 1
+                    trailing[c] = 32 - leading[c] - length
+                    if trailing[c] < 0:
+                        raise ValueError("bad window")
+                    bits = reader.read(length)
+                values[c] ^= bits << trailing[c]
+        samples.append((time, [as_float(v) for v in values]))
+    if time != header["last"]:
+        raise ValueError("last timestamp mismatch")
+    return samples
+
+
+def blocks(path):
+    with open(path, "rb") as f:
+        index = 0
+        while True:
+            block = f.read(BLOCK_BYTES)
+            if len(block) < BLOCK_BYTES:
+                return
+            yield index, block
+            index += 1
+
+
+def column_names(path):
+    return THERMAL_COLUMNS if path.endswith("_thermal.ts") else COLUMNS
+
+
+def fmt(value):
+    return "" if math.isnan(value) else "%.2f" % value
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode ArandanoIRT time-series files to CSV.")
+    parser.add_argument("files", nargs="+", help="*_ambient.ts or *_thermal.ts files copied from the SD card (one kind per call)")
+    parser.add_argument("--blocks", action="store_true", help="Print the block index instead of the samples")
+    args = parser.parse_args()
+
+    if not args.blocks:
+        print("epoch,time_utc," + ",".join(column_names(args.files[0])))
+    for path in args.files:
+        for index, block in blocks(path):
+            header = parse_header(block)
+            if not is_valid(block, header):
+                print("%s: block %d corrupt, skipped" % (path, index), file=sys.stderr)
+                continue
+            if args.blocks:
+                summary = " ".join("%s=%s..%s" % (name, fmt(lo), fmt(hi)) if valid else "%s=-" % name
+                                   for name, (lo, hi, _, valid) in zip(column_names(path), header["columns"]))
+                print("%s #%d: %d samples, %d bits, %d..%d %s"
+                      % (path, index, header["count"], header["bits"], header["first"], header["last"], summary))
+                continue
+            try:
+                samples = decode_block(block, header)
+            except ValueError as error:
+                print("%s: block %d undecodable (%s), skipped" % (path, index, error), file=sys.stderr)
+                continue
+            for time, values in samples:
+                stamp = datetime.datetime.fromtimestamp(time, datetime.timezone.utc).strftime("%Y-%m-%dT%H:%M:%SZ")
+                print("%d,%s,%s" % (time, stamp, ",".join(fmt(v) for v in values)))
+
+
+if __name__ == "__main__":
+    main()
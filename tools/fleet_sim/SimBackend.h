@@ -0,0 +1,185 @@
+#ifndef SIM_BACKEND_H
+#define SIM_BACKEND_H
+
+#include "../mock_backend/MockBackend.h"
+
+#include <stdint.h>
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+// Modelo del backend compartido por todos los nodos del simulador de flota.
+// No abre sockets: cada petición se resuelve en tiempo virtual con una cola FIFO
+// de `slots` servidores (tiempo de servicio = base + bytes / ancho de banda). Los tokens
+// los gestiona MockBackend (tools/mock_backend), con el reloj virtual como hora: mismas
+// reglas que el servidor de pruebas (401 con token caducado, rotación del refresh token).
+// Solo se llama desde la fase serie del bucle de eventos, así que no necesita mutex.
+
+// --- Códigos de cliente (mismos valores que HTTPClient) ---
+#define SIM_HTTPC_ERROR_CONNECTION_REFUSED -1
+#define SIM_HTTPC_ERROR_READ_TIMEOUT -11
+
+/**
+ * @brief Ventana en la que el backend no responde (tiempo virtual, ms desde el inicio).
+ */
+struct SimOutage {
+    int64_t startMs;
+    int64_t endMs;
+};
+
+/**
+ * @brief Comportamiento del backend durante un corte.
+ */
+enum class SimOutageMode : uint8_t {
+    TIMEOUT,       ///< Sin respuesta: el cliente agota su timeout (-11)
+    REFUSED,       ///< Conexión rechazada en ~300 ms (-1)
+    SERVER_ERROR   ///< El proxy responde 503 enseguida
+};
+
+struct SimBackendConfig {
+    int serverSlots = 8;              ///< Peticiones atendidas en paralelo
+    int serviceBaseMs = 40;           ///< Coste fijo por petición
+    double slotKBps = 500.0;          ///< Ingesta por servidor (KB/s)
+    int accessTokenTtlMin = 60;       ///< Vida del access token
+    double errorRate = 0.0;           ///< Fracción de peticiones que devuelven 500
+    SimOutageMode outageMode = SimOutageMode::TIMEOUT;
+    std::vector<SimOutage> outages;
+};
+
+struct SimRequest {
+    uint32_t node;
+    MockEndpoint endpoint;
+    uint32_t bytes;        ///< Cuerpo enviado
+    std::string token;     ///< Access token (o refresh token en REFRESH_TOKEN)
+    int64_t sentMs;        ///< Inicio de la petición en el cliente
+    int64_t arrivalMs;     ///< Fin de la subida (llegada al backend)
+    int timeoutMs;         ///< Timeout del cliente
+};
+
+struct SimResponse {
+    int code = 0;
+    int64_t completeMs = 0;  ///< Cuándo ve el cliente el resultado
+    MockTokens tokens;       ///< Tokens nuevos (ACTIVATE / REFRESH_TOKEN con 200)
+};
+
+/**
+ * @brief Estado del backend: tokens por nodo, cola de servidores y estadísticas.
+ */
+class SimBackend {
+public:
+    SimBackend(const SimBackendConfig& cfg, int64_t epochBaseMs, uint32_t seed, int64_t durationMs)
+        : _cfg(cfg), _core(_coreConfig(cfg)), _epochBaseMs(epochBaseMs), _rng(seed ^ 0x5EEDBAC4u),
+          _arrivalsPerSecond((size_t)(durationMs / 1000) + 7200, 0) {
+        for (int i = 0; i < std::max(1, cfg.serverSlots); i++) _slotFreeAt.push(0);
+    }
+
+    bool inOutage(int64_t t) const {
+        for (const SimOutage& o : _cfg.outages) {
+            if (t >= o.startMs && t < o.endMs) return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Resuelve una petición. Las peticiones de un mismo instante deben llegar
+     * ordenadas (por nodo) para que el resultado no dependa del número de hilos.
+     */
+    SimResponse handle(const SimRequest& req) {
+        SimResponse resp;
+        const int64_t timeoutAt = req.sentMs + req.timeoutMs;
+
+        if (inOutage(req.arrivalMs)) {
+            _outageRejected++;
+            switch (_cfg.outageMode) {
+                case SimOutageMode::REFUSED:
+                    resp.code = SIM_HTTPC_ERROR_CONNECTION_REFUSED;
+                    resp.completeMs = std::min(timeoutAt, req.sentMs + 300);
+                    return resp;
+                case SimOutageMode::SERVER_ERROR:
+                    resp.code = 503;
+                    resp.completeMs = std::min(timeoutAt, req.arrivalMs + 20);
+                    return resp;
+                default:
+                    resp.code = SIM_HTTPC_ERROR_READ_TIMEOUT;
+                    resp.completeMs = timeoutAt;
+                    return resp;
+            }
+        }
+
+        size_t second = (size_t)(req.arrivalMs / 1000);
+        if (second < _arrivalsPerSecond.size()) _arrivalsPerSecond[second]++;
+        _requests[(size_t)req.endpoint]++;
+
+        // Cola FIFO: la petición ocupa el primer servidor libre
+        int64_t freeAt = _slotFreeAt.top();
+        _slotFreeAt.pop();
+        int64_t start = std::max(req.arrivalMs, freeAt);
+        int64_t service = _cfg.serviceBaseMs + (int64_t)((double)req.bytes / (_cfg.slotKBps * 1.024));
+        int64_t done = start + service;
+        _slotFreeAt.push(done);
+        _queueWaitMs.push_back((uint32_t)(start - req.arrivalMs));
+
+        if (done > timeoutAt) {
+            // El servidor termina el trabajo aunque el cliente ya se haya rendido
+            _clientTimeouts++;
+            resp.code = SIM_HTTPC_ERROR_READ_TIMEOUT;
+            resp.completeMs = timeoutAt;
+            return resp;
+        }
+        resp.completeMs = done;
+
+        if (_cfg.errorRate > 0.0 && std::uniform_real_distribution<double>(0.0, 1.0)(_rng) < _cfg.errorRate) {
+            resp.code = 500;
+            return resp;
+        }
+
+        const int64_t nowMs = _epochBaseMs + start;
+        switch (req.endpoint) {
+            case MockEndpoint::ACTIVATE:
+                resp.code = _core.activate(std::to_string(req.node + 1), "", nowMs, resp.tokens);
+                break;
+            case MockEndpoint::REFRESH_TOKEN:
+                resp.code = _core.refresh(req.token, nowMs, resp.tokens);
+                break;
+            default: // AUTH y endpoints de datos exigen un access token vigente
+                resp.code = _core.checkAccess(req.token, nowMs);
+                break;
+        }
+        if (resp.code == 401) _unauthorized++;
+        return resp;
+    }
+
+    // --- Estadísticas ---
+    const std::vector<uint32_t>& arrivalsPerSecond() const { return _arrivalsPerSecond; }
+    const std::vector<uint32_t>& queueWaitMs() const { return _queueWaitMs; }
+    uint64_t requests(MockEndpoint ep) const { return _requests[(size_t)ep]; }
+    uint64_t outageRejected() const { return _outageRejected; }
+    uint64_t clientTimeouts() const { return _clientTimeouts; }
+    uint64_t unauthorized() const { return _unauthorized; }
+
+private:
+    static MockBackendConfig _coreConfig(const SimBackendConfig& cfg) {
+        MockBackendConfig core;
+        core.accessTtlMs = (int64_t)cfg.accessTokenTtlMin * 60000;
+        core.keepRecords = false; // Millones de peticiones: solo cuentan las estadísticas de aquí
+        return core;
+    }
+
+    SimBackendConfig _cfg;
+    MockBackend _core;
+    int64_t _epochBaseMs;
+    std::mt19937 _rng;
+    std::priority_queue<int64_t, std::vector<int64_t>, std::greater<int64_t> > _slotFreeAt;
+
+    std::vector<uint32_t> _arrivalsPerSecond;
+    std::vector<uint32_t> _queueWaitMs;
+    uint64_t _requests[(size_t)MockEndpoint::COUNT] = {0};
+    uint64_t _outageRejected = 0;
+    uint64_t _clientTimeouts = 0;
+    uint64_t _unauthorized = 0;
+};
+
+#endif // SIM_BACKEND_H
@@ -0,0 +1,491 @@
+#ifndef SIM_NODE_H
+#define SIM_NODE_H
+
+#include "SimBackend.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+// Un dispositivo simulado: MODELO del ciclo de src/main.cpp como máquina de estados en
+// tiempo virtual (auth con refresh en 401, envío ambiental, captura, log remoto,
+// compactPendingBacklog y processPendingApiCalls con su presupuesto). No compila ni
+// ejecuta el código del firmware (depende de Arduino, SD_MMC y FreeRTOS): es una
+// reimplementación de sus tiempos, reintentos y política de cola, así que un cambio en
+// esa lógica del firmware hay que reflejarlo aquí a mano (las constantes de abajo indican
+// de dónde sale cada valor). La cola offline sí se guarda como archivos reales en el
+// directorio del nodo, con la misma estructura que la SD.
+// step() solo toca el estado del nodo y su directorio: los nodos avanzan en paralelo.
+
+// Mismos valores que el firmware
+#define SIM_AUTH_MAX_RETRIES 5              // main.cpp AUTH_MAX_RETRIES
+#define SIM_AUTH_RETRY_DELAY_MS 5000        // main.cpp AUTH_RETRY_DELAY_MS
+#define SIM_API_TIMEOUT_MS 10000            // API.cpp HTTP_REQUEST_TIMEOUT
+#define SIM_ENV_TIMEOUT_MS 10000            // EnvironmentDataJSON.cpp
+#define SIM_CAPTURE_TIMEOUT_MS 20000        // MultipartDataSender.cpp
+#define SIM_LOG_TIMEOUT_MS 5000             // ErrorLogger.cpp
+
+struct SimNodeConfig {
+    int intervalMinutes = 30;               ///< data_interval_minutes
+    int envSenseMs = 2000;                  ///< Lecturas BH1750 + BME280
+    int captureSenseMs = 16000;             ///< Promediado MLX90640 + OV2640
+    double uplinkKBps = 100.0;              ///< Subida WiFi del nodo (KB/s)
+    int64_t maxClockSkewMs = 2000;          ///< Desfase máximo del RTC tras NTP
+    int64_t bootSpreadMs = 600000;          ///< Los nodos arrancan repartidos en esta ventana
+    // --- Política de backlog (Config) ---
+    int thinAfterHours = 24;
+    int thinIntervalMinutes = 60;
+    int summaryAfterHours = 6;
+    int summaryBucketMinutes = 60;
+    int maxPendingMb = 256;
+    int maxItemsPerCycle = 20;
+    int drainBudgetSeconds = 120;
+    // --- Tamaños de payload ---
+    uint32_t ambientBytes = 190;
+    uint32_t thermalJsonBytes = 6600;
+    uint32_t jpegBytes = 32000;             ///< Media; cada captura varía ±25%
+    uint32_t logBytes = 320;
+    uint32_t multipartOverhead = 420;
+    bool writeFiles = true;                 ///< Refleja la cola en disco (false: solo en memoria)
+};
+
+/**
+ * @brief Estadísticas acumuladas por un nodo (se suman al final de la simulación).
+ */
+struct SimNodeStats {
+    std::vector<uint32_t> latencyMs[(size_t)MockEndpoint::COUNT]; ///< Visto por el cliente
+    std::vector<uint32_t> backlogDelaySec;  ///< Antigüedad de los datos entregados desde la cola
+    uint64_t cycles = 0;
+    uint64_t cyclesSkipped = 0;             ///< Sin auth tras SIM_AUTH_MAX_RETRIES
+    uint64_t ambientLive = 0, captureLive = 0;
+    uint64_t ambientFromBacklog = 0, captureFromBacklog = 0;
+    uint64_t thinned = 0, summarized = 0, capped = 0;
+    uint64_t maxPendingItems = 0;
+    uint64_t maxPendingBytes = 0;
+    uint64_t maxCycleMs = 0;
+};
+
+class SimNode {
+public:
+    SimNode(uint32_t id, const SimNodeConfig& cfg, int64_t epochBase, const std::string& dir, uint32_t seed)
+        : _id(id), _cfg(&cfg), _epochBase(epochBase), _dir(dir), _rng(seed + id * 2654435761u) {
+        std::uniform_int_distribution<int64_t> skew(-cfg.maxClockSkewMs, cfg.maxClockSkewMs);
+        _skewMs = skew(_rng);
+        _wakeMs = cfg.bootSpreadMs > 0 ? std::uniform_int_distribution<int64_t>(0, cfg.bootSpreadMs)(_rng) : 0;
+        if (cfg.writeFiles) {
+            std::filesystem::create_directories(_dir + "/pending/ambient");
+            std::filesystem::create_directories(_dir + "/pending/capture");
+        }
+    }
+
+    uint32_t id() const { return _id; }
+    int64_t wakeMs() const { return _wakeMs; }
+    uint64_t pendingItems() const { return _pending.size(); }
+    uint64_t pendingBytes() const { return _pendingBytes; }
+    const SimNodeStats& stats() const { return _stats; }
+
+    /**
+     * @brief Avanza la máquina de estados en el instante `now` (== wakeMs()).
+     * @return true si el nodo emite una petición (`out`); su wakeMs() lo fija deliver().
+     */
+    bool step(int64_t now, SimRequest& out) {
+        switch (_phase) {
+            case Phase::SLEEP:
+                _cycleStartMs = now;
+                _stats.cycles++;
+                _authAttempt = 1;
+                return _beginAuth(now, out);
+
+            case Phase::AUTH_RETRY_WAIT:
+                return _beginAuth(now, out);
+
+            case Phase::ACTIVATE:
+                if (_result.code == 200) {
+                    _activated = true;
+                    _access = _result.tokens.access;
+                    _refresh = _result.tokens.refresh;
+                    return _proceed(now);
+                }
+                return _authFailed(now, out);
+
+            case Phase::AUTH:
+                if (_result.code == 200) return _proceed(now);
+                if (_result.code == 401) return _request(now, Phase::REFRESH, MockEndpoint::REFRESH_TOKEN, 64, _refresh, SIM_API_TIMEOUT_MS, out);
+                if (_result.code >= 500 || _result.code < 0) return _proceed(now); // Backend caído: se sigue y se guarda en pending
+                return _authFailed(now, out);
+
+            case Phase::REFRESH:
+                if (_result.code == 200) {
+                    _access = _result.tokens.access;
+                    _refresh = _result.tokens.refresh;
+                    return _proceed(now);
+                }
+                if (_result.code == 401) { // Refresh rechazado: el dispositivo se desactiva
+                    _activated = false;
+                    return _authFailed(now, out);
+                }
+                if (_result.code >= 500 || _result.code < 0) return _proceed(now);
+                return _authFailed(now, out);
+
+            case Phase::ENV_SENSE:
+                _retried = false;
+                _cycleTs = _epochSec(now);
+                return _request(now, Phase::ENV_SEND, MockEndpoint::AMBIENT_DATA, _cfg->ambientBytes, _access, SIM_ENV_TIMEOUT_MS, out);
+
+            case Phase::ENV_SEND:
+                if (_result.code == 200 || _result.code == 204) {
+                    _stats.ambientLive++;
+                    _phase = Phase::CAPTURE_SENSE;
+                    _wakeMs = now + _cfg->captureSenseMs;
+                    return false;
+                }
+                if (_result.code == 401 && !_retried && _activated) {
+                    _retried = true;
+                    _resumePhase = Phase::ENV_SENSE_RETRY;
+                    return _request(now, Phase::DATA_REFRESH, MockEndpoint::REFRESH_TOKEN, 64, _refresh, SIM_API_TIMEOUT_MS, out);
+                }
+                // Fallo: a pending y el ciclo sigue sin captura (performEnvironmentTasks_Env devuelve false)
+                _savePending(Pending::AMBIENT, _cycleTs, _cfg->ambientBytes, 0);
+                return _request(now, Phase::LOG_SEND, MockEndpoint::LOG, _cfg->logBytes, _access, SIM_LOG_TIMEOUT_MS, out);
+
+            case Phase::ENV_SENSE_RETRY:
+                return _request(now, Phase::ENV_SEND, MockEndpoint::AMBIENT_DATA, _cfg->ambientBytes, _access, SIM_ENV_TIMEOUT_MS, out);
+
+            case Phase::CAPTURE_SENSE:
+                _retried = false;
+                _jpegBytes = _jpegSize();
+                return _request(now, Phase::CAPTURE_SEND, MockEndpoint::CAPTURE_DATA, _captureBytes(_cfg->thermalJsonBytes, _jpegBytes),
+                                _access, SIM_CAPTURE_TIMEOUT_MS, out);
+
+            case Phase::CAPTURE_SEND:
+                if (_result.code >= 200 && _result.code < 300) {
+                    _stats.captureLive++;
+                } else if (_result.code == 401 && !_retried && _activated) {
+                    _retried = true;
+                    _resumePhase = Phase::CAPTURE_SENSE_RETRY;
+                    return _request(now, Phase::DATA_REFRESH, MockEndpoint::REFRESH_TOKEN, 64, _refresh, SIM_API_TIMEOUT_MS, out);
+                } else {
+                    _savePending(Pending::CAPTURE, _cycleTs, _cfg->thermalJsonBytes, _jpegBytes);
+                }
+                return _request(now, Phase::LOG_SEND, MockEndpoint::LOG, _cfg->logBytes, _access, SIM_LOG_TIMEOUT_MS, out);
+
+            case Phase::CAPTURE_SENSE_RETRY:
+                return _request(now, Phase::CAPTURE_SEND, MockEndpoint::CAPTURE_DATA, _captureBytes(_cfg->thermalJsonBytes, _jpegBytes),
+                                _access, SIM_CAPTURE_TIMEOUT_MS, out);
+
+            case Phase::DATA_REFRESH:
+                if (_result.code == 200) {
+                    _access = _result.tokens.access;
+                    _refresh = _result.tokens.refresh;
+                    _phase = _resumePhase;
+                    return step(now, out);
+                }
+                _result.code = 401; // Se registra el 401 original como fallo final
+                _phase = _resumePhase == Phase::ENV_SENSE_RETRY ? Phase::ENV_SEND : Phase::CAPTURE_SEND;
+                return step(now, out);
+
+            case Phase::LOG_SEND: // El resultado del log remoto no cambia el ciclo
+                _compactBacklog(_epochSec(now));
+                return _beginDrain(now, out);
+
+            case Phase::DRAIN:
+                _finishDrainItem(now);
+                return _nextDrainItem(now, out);
+        }
+        return false;
+    }
+
+    /**
+     * @brief Entrega la respuesta del backend a la petición emitida por step().
+     */
+    void deliver(const SimRequest& req, const SimResponse& resp) {
+        _result = resp;
+        _wakeMs = resp.completeMs;
+        _stats.latencyMs[(size_t)req.endpoint].push_back((uint32_t)(resp.completeMs - req.sentMs));
+    }
+
+private:
+    enum class Phase : uint8_t {
+        SLEEP, AUTH_RETRY_WAIT, ACTIVATE, AUTH, REFRESH,
+        ENV_SENSE, ENV_SEND, ENV_SENSE_RETRY,
+        CAPTURE_SENSE, CAPTURE_SEND, CAPTURE_SENSE_RETRY,
+        DATA_REFRESH, LOG_SEND, DRAIN
+    };
+
+    struct Pending {
+        enum Kind : uint8_t { AMBIENT, CAPTURE };
+        Kind kind;
+        bool summary;       ///< Resumen de varias lecturas ambientales
+        int64_t ts;         ///< Época de la medida (nombre de archivo YYYYMMDD_HHMMSS)
+        uint32_t jsonBytes;
+        uint32_t jpegBytes; ///< 0 en capturas adelgazadas (solo térmica)
+    };
+
+    // --- Ciclo ---
+    bool _request(int64_t now, Phase next, MockEndpoint ep, uint32_t bytes, const std::string& token, int timeoutMs, SimRequest& out) {
+        _phase = next;
+        out.node = _id;
+        out.endpoint = ep;
+        out.bytes = bytes;
+        out.token = token;
+        out.sentMs = now;
+        out.arrivalMs = now + (int64_t)((double)bytes / (_cfg->uplinkKBps * 1.024));
+        out.timeoutMs = timeoutMs;
+        return true;
+    }
+
+    bool _beginAuth(int64_t now, SimRequest& out) {
+        if (!_activated) return _request(now, Phase::ACTIVATE, MockEndpoint::ACTIVATE, 96, "", SIM_API_TIMEOUT_MS, out);
+        return _request(now, Phase::AUTH, MockEndpoint::AUTH, 300, _access, SIM_API_TIMEOUT_MS, out);
+    }
+
+    bool _authFailed(int64_t now, SimRequest& out) {
+        (void)out;
+        if (_authAttempt < SIM_AUTH_MAX_RETRIES) {
+            _authAttempt++;
+            _phase = Phase::AUTH_RETRY_WAIT;
+            _wakeMs = now + SIM_AUTH_RETRY_DELAY_MS;
+            return false;
+        }
+        // Igual que el firmware: se reintenta un intervalo después, sin alinear al slot
+        _stats.cyclesSkipped++;
+        _phase = Phase::SLEEP;
+        _wakeMs = now + (int64_t)_cfg->intervalMinutes * 60000;
+        return false;
+    }
+
+    bool _proceed(int64_t now) {
+        _phase = Phase::ENV_SENSE;
+        _wakeMs = now + _cfg->envSenseMs;
+        return false;
+    }
+
+    // --- processPendingApiCalls: cada tipo del más antiguo al más reciente, intercalados
+    //     (ambiental, captura, ambiental...) para que una cola ambiental grande no deje sin
+    //     enviar las capturas ---
+    bool _beginDrain(int64_t now, SimRequest& out) {
+        _drainStartMs = now;
+        _drainItems = 0;
+        _drainCursor = 0;
+        _drainQueue.clear();
+        if (_activated) {
+            std::vector<int64_t> ambient, capture;
+            for (const Pending& p : _pending) (p.kind == Pending::AMBIENT ? ambient : capture).push_back(_key(p));
+            std::sort(ambient.begin(), ambient.end());
+            std::sort(capture.begin(), capture.end());
+            for (size_t i = 0; i < ambient.size() || i < capture.size(); ++i) {
+                if (i < ambient.size()) _drainQueue.push_back(ambient[i]);
+                if (i < capture.size()) _drainQueue.push_back(capture[i]);
+            }
+        }
+        return _nextDrainItem(now, out);
+    }
+
+    bool _nextDrainItem(int64_t now, SimRequest& out) {
+        bool maxItemsReached = _cfg->maxItemsPerCycle > 0 && _drainItems >= _cfg->maxItemsPerCycle;
+        bool timeExceeded = _cfg->drainBudgetSeconds > 0 && now - _drainStartMs >= (int64_t)_cfg->drainBudgetSeconds * 1000;
+        if (_drainCursor >= _drainQueue.size() || maxItemsReached || timeExceeded) {
+            _endCycle(now);
+            return false;
+        }
+        const Pending* p = _findPending(_drainQueue[_drainCursor]);
+        _drainCursor++;
+        if (!p) return _nextDrainItem(now, out);
+        _drainItems++;
+        if (p->kind == Pending::AMBIENT) {
+            return _request(now, Phase::DRAIN, MockEndpoint::AMBIENT_DATA, p->jsonBytes, _access, SIM_ENV_TIMEOUT_MS, out);
+        }
+        return _request(now, Phase::DRAIN, MockEndpoint::CAPTURE_DATA, _captureBytes(p->jsonBytes, p->jpegBytes),
+                        _access, SIM_CAPTURE_TIMEOUT_MS, out);
+    }
+
+    void _finishDrainItem(int64_t now) {
+        bool ok = _result.code >= 200 && _result.code < 300;
+        if (!ok) return; // 401 o error: se reintenta en el próximo ciclo
+        int64_t key = _drainQueue[_drainCursor - 1];
+        for (size_t i = 0; i < _pending.size(); i++) {
+            if (_key(_pending[i]) != key) continue;
+            const Pending& p = _pending[i];
+            if (p.kind == Pending::AMBIENT) _stats.ambientFromBacklog++;
+            else _stats.captureFromBacklog++;
+            _stats.backlogDelaySec.push_back((uint32_t)std::max<int64_t>(0, _epochSec(now) - p.ts));
+            _removePending(i); // Enviado: pasa a 'archive'
+            return;
+        }
+    }
+
+    void _endCycle(int64_t now) {
+        _stats.maxCycleMs = std::max<uint64_t>(_stats.maxCycleMs, (uint64_t)(now - _cycleStartMs));
+
+        // Siguiente slot alineado al reloj local del nodo (tm_min % intervalo, segundos a 0)
+        const int64_t slotSec = (int64_t)_cfg->intervalMinutes * 60;
+        int64_t local = _epochSec(now);
+        int64_t nextLocal = (local / slotSec + 1) * slotSec;
+        _phase = Phase::SLEEP;
+        _wakeMs = (nextLocal - _epochBase) * 1000 - _skewMs;
+    }
+
+    // --- Cola offline (pending/ambient y pending/capture) ---
+    int64_t _key(const Pending& p) const { return p.ts * 2 + (p.kind == Pending::CAPTURE ? 1 : 0); }
+
+    const Pending* _findPending(int64_t key) const {
+        for (const Pending& p : _pending) if (_key(p) == key) return &p;
+        return nullptr;
+    }
+
+    void _savePending(Pending::Kind kind, int64_t ts, uint32_t jsonBytes, uint32_t jpegBytes) {
+        Pending p = {kind, false, ts, jsonBytes, jpegBytes};
+        _pending.push_back(p);
+        _pendingBytes += jsonBytes + jpegBytes;
+        if (_cfg->writeFiles) {
+            if (kind == Pending::AMBIENT) {
+                _writeFile(_path(p, "_env.json"), jsonBytes);
+            } else {
+                _writeFile(_path(p, "_thermal.json"), jsonBytes);
+                if (jpegBytes > 0) _writeFile(_path(p, "_visual.jpg"), jpegBytes);
+            }
+        }
+        _stats.maxPendingItems = std::max<uint64_t>(_stats.maxPendingItems, _pending.size());
+        _stats.maxPendingBytes = std::max<uint64_t>(_stats.maxPendingBytes, _pendingBytes);
+    }
+
+    void _removePending(size_t index) {
+        const Pending& p = _pending[index];
+        _pendingBytes -= p.jsonBytes + p.jpegBytes;
+        if (_cfg->writeFiles) {
+            if (p.kind == Pending::AMBIENT) {
+                _deleteFile(_path(p, "_env.json"));
+            } else {
+                _deleteFile(_path(p, "_thermal.json"));
+                if (p.jpegBytes > 0) _deleteFile(_path(p, "_visual.jpg"));
+            }
+        }
+        _pending.erase(_pending.begin() + index);
+    }
+
+    // Misma política que SDManager::compactPendingBacklog (el orden de _pending es cronológico)
+    void _compactBacklog(int64_t nowSec) {
+        if (_cfg->thinAfterHours > 0 && _cfg->thinIntervalMinutes > 0) {
+            const int64_t cutoff = nowSec - (int64_t)_cfg->thinAfterHours * 3600;
+            const int64_t bucket = (int64_t)_cfg->thinIntervalMinutes * 60;
+            int64_t lastKept = -1;
+            for (size_t i = 0; i < _pending.size();) {
+                Pending& p = _pending[i];
+                if (p.kind != Pending::CAPTURE) { i++; continue; }
+                if (p.ts >= cutoff) break;
+                if (p.ts / bucket != lastKept) { // Primera del intervalo: se conserva solo la térmica
+                    lastKept = p.ts / bucket;
+                    if (p.jpegBytes > 0) {
+                        if (_cfg->writeFiles) _deleteFile(_path(p, "_visual.jpg"));
+                        _pendingBytes -= p.jpegBytes;
+                        p.jpegBytes = 0;
+                        _stats.thinned++;
+                    }
+                    i++;
+                } else {
+                    _removePending(i);
+                    _stats.thinned++;
+                }
+            }
+        }
+
+        if (_cfg->summaryAfterHours > 0 && _cfg->summaryBucketMinutes > 0) {
+            const int64_t cutoff = nowSec - (int64_t)_cfg->summaryAfterHours * 3600;
+            const int64_t bucket = (int64_t)_cfg->summaryBucketMinutes * 60;
+            size_t first = SIZE_MAX;
+            for (size_t i = 0; i < _pending.size();) {
+                Pending& p = _pending[i];
+                if (p.kind != Pending::AMBIENT) { i++; continue; }
+                if (p.ts >= cutoff) break;
+                if (first != SIZE_MAX && _pending[first].ts / bucket == p.ts / bucket) {
+                    _removePending(i); // Se integra en el resumen de su ventana
+                    _stats.summarized++;
+                    continue;
+                }
+                first = i;
+                p.summary = true;
+                i++;
+            }
+        }
+
+        if (_cfg->maxPendingMb > 0) {
+            const uint64_t cap = (uint64_t)_cfg->maxPendingMb * 1024ULL * 1024ULL;
+            while (_pendingBytes > cap && !_pending.empty()) {
+                _removePending(0);
+                _stats.capped++;
+            }
+        }
+    }
+
+    std::string _path(const Pending& p, const char* suffix) const {
+        time_t t = (time_t)p.ts;
+        struct tm tmv;
+        gmtime_r(&t, &tmv);
+        char name[32];
+        strftime(name, sizeof(name), "%Y%m%d_%H%M%S", &tmv);
+        return _dir + (p.kind == Pending::AMBIENT ? "/pending/ambient/" : "/pending/capture/") + name + suffix;
+    }
+
+    static void _writeFile(const std::string& path, uint32_t bytes) {
+        FILE* f = fopen(path.c_str(), "wb");
+        if (!f) return;
+        // Archivo disperso del tamaño real: la cola ocupa lo mismo en listados sin gastar disco
+        if (bytes > 0) {
+            fseek(f, (long)bytes - 1, SEEK_SET);
+            fputc(0, f);
+        }
+        fclose(f);
+    }
+
+    static void _deleteFile(const std::string& path) { remove(path.c_str()); }
+
+    // --- Utilidades ---
+    int64_t _epochSec(int64_t now) const { return _epochBase + (now + _skewMs) / 1000; }
+
+    uint32_t _jpegSize() {
+        std::uniform_real_distribution<double> spread(0.75, 1.25);
+        return (uint32_t)(_cfg->jpegBytes * spread(_rng));
+    }
+
+    uint32_t _captureBytes(uint32_t jsonBytes, uint32_t jpegBytes) const {
+        return jsonBytes + jpegBytes + _cfg->multipartOverhead;
+    }
+
+    uint32_t _id;
+    const SimNodeConfig* _cfg;
+    int64_t _epochBase;
+    std::string _dir;
+    std::mt19937 _rng;
+    int64_t _skewMs = 0;
+
+    Phase _phase = Phase::SLEEP;
+    Phase _resumePhase = Phase::SLEEP;
+    int64_t _wakeMs = 0;
+    SimResponse _result;
+
+    bool _activated = false;
+    std::string _access;
+    std::string _refresh;
+
+    int64_t _cycleStartMs = 0;
+    int64_t _cycleTs = 0;
+    int _authAttempt = 0;
+    bool _retried = false;
+    uint32_t _jpegBytes = 0;
+
+    int64_t _drainStartMs = 0;
+    int _drainItems = 0;
+    size_t _drainCursor = 0;
+    std::vector<int64_t> _drainQueue;
+
+    std::vector<Pending> _pending;
+    uint64_t _pendingBytes = 0;
+    SimNodeStats _stats;
+};
+
+#endif // SIM_NODE_H
@@ -0,0 +1,465 @@
+// Simulador de flota: N nodos ArandanoIRT contra un backend simulado, en un solo proceso.
+//
+// Cada nodo es un modelo del ciclo del firmware (SimNode.h, una reimplementación, no el
+// código del firmware) con su propio reloj
+// virtual (desfase NTP y arranque distintos) y su directorio de "SD"; todos comparten
+// el backend (SimBackend.h, con los tokens de tools/mock_backend/MockBackend.h).
+// El tiempo es virtual: un día de flota se simula en segundos.
+// Los nodos listos en un mismo instante avanzan en paralelo en un pool de hilos y el
+// backend resuelve sus peticiones en orden de nodo, así que el resultado es idéntico
+// con cualquier número de hilos.
+//
+// Compilar y ejecutar (Linux, sin dependencias):
+//     g++ -std=c++17 -O2 -pthread tools/fleet_sim/fleet_sim.cpp -o fleet_sim
+//     ./fleet_sim --nodes 300 --hours 48 --outage 10:6
+//
+// --help lista todas las opciones.
+
+#include "SimBackend.h"
+#include "SimNode.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <filesystem>
+
+// Inicio del tiempo virtual: 2025-10-31 00:00:00 UTC
+#define SIM_EPOCH_BASE 1761868800LL
+
+// =========================================================================
+// ===                          POOL DE HILOS                            ===
+// =========================================================================
+
+/**
+ * @brief Pool fijo de hilos con un único tipo de trabajo: parallelFor sobre índices.
+ */
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned count) {
+        for (unsigned i = 1; i < count; i++) _threads.emplace_back([this] { _worker(); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _wake.notify_all();
+        for (std::thread& t : _threads) t.join();
+    }
+
+    unsigned size() const { return (unsigned)_threads.size() + 1; }
+
+    /**
+     * @brief Ejecuta fn(i) para i en [0, count) y vuelve cuando han terminado todos.
+     * El hilo llamador también trabaja.
+     */
+    void parallelFor(size_t count, const std::function<void(size_t)>& fn) {
+        if (count < 4 || _threads.empty()) { // No compensa despertar a los hilos
+            for (size_t i = 0; i < count; i++) fn(i);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _fn = &fn;
+            _count = count;
+            _next = 0;
+            _busy = _threads.size();
+            _generation++;
+        }
+        _wake.notify_all();
+        _run();
+        std::unique_lock<std::mutex> lock(_mutex);
+        _done.wait(lock, [this] { return _busy == 0; });
+        _fn = nullptr;
+    }
+
+private:
+    void _run() {
+        for (size_t i = _next++; i < _count; i = _next++) (*_fn)(i);
+    }
+
+    void _worker() {
+        uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _wake.wait(lock, [&] { return _stop || _generation != seen; });
+                if (_stop) return;
+                seen = _generation;
+            }
+            _run();
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (--_busy == 0) _done.notify_one();
+        }
+    }
+
+    std::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    const std::function<void(size_t)>* _fn = nullptr;
+    size_t _count = 0;
+    std::atomic<size_t> _next{0};
+    size_t _busy = 0;
+    uint64_t _generation = 0;
+    bool _stop = false;
+};
+
+// =========================================================================
+// ===                            OPCIONES                               ===
+// =========================================================================
+
+struct Options {
+    uint32_t nodes = 100;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    double hours = 24.0;
+    int tickMs = 100;            ///< Resolución del reloj virtual
+    uint32_t seed = 1;
+    std::string workDir = "fleet_sim_data";
+    bool keepFiles = false;
+    SimNodeConfig node;
+    SimBackendConfig backend;
+};
+
+static void usage(const char* argv0) {
+    printf("Usage: %s [options]\n\n"
+           "Fleet:\n"
+           "  --nodes N                Simulated devices (default 100)\n"
+           "  --threads N              Worker threads (default: all cores)\n"
+           "  --hours H                Virtual duration (default 24)\n"
+           "  --seed N                 RNG seed (default 1)\n"
+           "  --tick-ms N              Virtual clock resolution (default 100)\n"
+           "  --interval MIN           data_interval_minutes (default 30)\n"
+           "  --skew-ms N              Max per-node clock offset after NTP (default 2000)\n"
+           "  --boot-spread-s N        Nodes boot spread over this window (default 600)\n"
+           "  --uplink-kBps N          Per-node WiFi uplink (default 100)\n"
+           "  --jpeg-bytes N           Mean JPEG size (default 32000)\n"
+           "Backlog policy (same keys as config.json):\n"
+           "  --max-items N            backlog_max_items_per_cycle (default 20)\n"
+           "  --drain-budget-s N       backlog_drain_budget_seconds (default 120)\n"
+           "  --max-pending-mb N       backlog_max_pending_mb (default 256)\n"
+           "  --thin-after-h N         backlog_thin_after_hours (default 24)\n"
+           "  --summary-after-h N      backlog_summary_after_hours (default 6)\n"
+           "Backend:\n"
+           "  --server-slots N         Requests served in parallel (default 8)\n"
+           "  --service-ms N           Fixed cost per request (default 40)\n"
+           "  --server-kBps N          Ingest rate per slot (default 500)\n"
+           "  --token-ttl-min N        Access token lifetime (default 60)\n"
+           "  --error-rate F           Fraction of requests answered with 500 (default 0)\n"
+           "  --outage START_H:DUR_H   Backend down window, repeatable (e.g. 10:6)\n"
+           "  --outage-mode M          timeout | refused | 503 (default timeout)\n"
+           "Output:\n"
+           "  --workdir DIR            Per-node SD directories (default fleet_sim_data)\n"
+           "  --keep-files             Keep DIR after the run\n"
+           "  --no-files               Keep the pending queues in memory only\n",
+           argv0);
+}
+
+static bool parseArgs(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "error: %s needs a value\n", a.c_str());
+                exit(2);
+            }
+            return argv[++i];
+        };
+        if (a == "--help" || a == "-h") { usage(argv[0]); exit(0); }
+        else if (a == "--nodes") opt.nodes = (uint32_t)atoi(next());
+        else if (a == "--threads") opt.threads = (unsigned)std::max(1, atoi(next()));
+        else if (a == "--hours") opt.hours = atof(next());
+        else if (a == "--seed") opt.seed = (uint32_t)strtoul(next(), nullptr, 10);
+        else if (a == "--tick-ms") opt.tickMs = std::max(1, atoi(next()));
+        else if (a == "--interval") opt.node.intervalMinutes = std::max(1, atoi(next()));
+        else if (a == "--skew-ms") opt.node.maxClockSkewMs = atoll(next());
+        else if (a == "--boot-spread-s") opt.node.bootSpreadMs = atoll(next()) * 1000;
+        else if (a == "--uplink-kBps") opt.node.uplinkKBps = atof(next());
+        else if (a == "--jpeg-bytes") opt.node.jpegBytes = (uint32_t)atoi(next());
+        else if (a == "--max-items") opt.node.maxItemsPerCycle = atoi(next());
+        else if (a == "--drain-budget-s") opt.node.drainBudgetSeconds = atoi(next());
+        else if (a == "--max-pending-mb") opt.node.maxPendingMb = atoi(next());
+        else if (a == "--thin-after-h") opt.node.thinAfterHours = atoi(next());
+        else if (a == "--summary-after-h") opt.node.summaryAfterHours = atoi(next());
+        else if (a == "--server-slots") opt.backend.serverSlots = std::max(1, atoi(next()));
+        else if (a == "--service-ms") opt.backend.serviceBaseMs = atoi(next());
+        else if (a == "--server-kBps") opt.backend.slotKBps = atof(next());
+        else if (a == "--token-ttl-min") opt.backend.accessTokenTtlMin = atoi(next());
+        else if (a == "--error-rate") opt.backend.errorRate = atof(next());
+        else if (a == "--outage") {
+            double start = 0, duration = 0;
+            if (sscanf(next(), "%lf:%lf", &start, &duration) != 2 || duration <= 0) {
+                fprintf(stderr, "error: --outage expects START_H:DURATION_H\n");
+                return false;
+            }
+            opt.backend.outages.push_back({(int64_t)(start * 3600000.0), (int64_t)((start + duration) * 3600000.0)});
+        } else if (a == "--outage-mode") {
+            std::string m = next();
+            if (m == "timeout") opt.backend.outageMode = SimOutageMode::TIMEOUT;
+            else if (m == "refused") opt.backend.outageMode = SimOutageMode::REFUSED;
+            else if (m == "503") opt.backend.outageMode = SimOutageMode::SERVER_ERROR;
+            else {
+                fprintf(stderr, "error: unknown outage mode '%s'\n", m.c_str());
+                return false;
+            }
+        }
+        else if (a == "--workdir") opt.workDir = next();
+        else if (a == "--keep-files") opt.keepFiles = true;
+        else if (a == "--no-files") opt.node.writeFiles = false;
+        else {
+            fprintf(stderr, "error: unknown option '%s' (see --help)\n", a.c_str());
+            return false;
+        }
+    }
+    if (opt.nodes == 0 || opt.hours <= 0) {
+        fprintf(stderr, "error: --nodes and --hours must be positive\n");
+        return false;
+    }
+    return true;
+}
+
+// =========================================================================
+// ===                            INFORME                                ===
+// =========================================================================
+
+static uint32_t percentile(std::vector<uint32_t>& v, double p) {
+    if (v.empty()) return 0;
+    size_t k = (size_t)(p * (double)(v.size() - 1) + 0.5);
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+static std::string hms(int64_t ms) {
+    char buf[32];
+    int64_t s = ms / 1000;
+    snprintf(buf, sizeof(buf), "%lldh%02lldm%02llds", (long long)(s / 3600), (long long)(s / 60 % 60), (long long)(s % 60));
+    return buf;
+}
+
+/**
+ * @brief Evolución de la cola agregada: pico y tiempo de recuperación tras cada corte.
+ */
+struct BacklogTracker {
+    uint64_t peakItems = 0;
+    uint64_t peakBytes = 0;
+    int64_t peakAtMs = 0;
+    std::vector<int64_t> recoveredAtMs; ///< Por corte: cuando la cola vuelve a 0 (-1 = no se recupera)
+
+    explicit BacklogTracker(size_t outages) : recoveredAtMs(outages, -1) {}
+
+    void sample(int64_t now, uint64_t items, uint64_t bytes, const std::vector<SimOutage>& outages) {
+        if (items > peakItems) {
+            peakItems = items;
+            peakAtMs = now;
+        }
+        peakBytes = std::max(peakBytes, bytes);
+        for (size_t i = 0; i < outages.size(); i++) {
+            if (now < outages[i].endMs) {
+                recoveredAtMs[i] = -1; // Aún dentro del corte (o antes)
+            } else if (items == 0 && recoveredAtMs[i] < 0) {
+                recoveredAtMs[i] = now;
+            }
+        }
+    }
+};
+
+static void printReport(const Options& opt, const SimBackend& backend, std::vector<SimNode>& nodes,
+                        const BacklogTracker& backlog, int64_t durationMs, double wallSeconds, uint64_t steps) {
+    const int64_t slotMs = (int64_t)opt.node.intervalMinutes * 60000;
+
+    // --- Nodos ---
+    SimNodeStats total;
+    std::vector<uint32_t> maxItemsPerNode, maxCyclePerNode;
+    uint64_t maxNodeBytes = 0;
+    for (SimNode& n : nodes) {
+        const SimNodeStats& s = n.stats();
+        for (size_t e = 0; e < (size_t)MockEndpoint::COUNT; e++) {
+            total.latencyMs[e].insert(total.latencyMs[e].end(), s.latencyMs[e].begin(), s.latencyMs[e].end());
+        }
+        total.backlogDelaySec.insert(total.backlogDelaySec.end(), s.backlogDelaySec.begin(), s.backlogDelaySec.end());
+        total.cycles += s.cycles;
+        total.cyclesSkipped += s.cyclesSkipped;
+        total.ambientLive += s.ambientLive;
+        total.captureLive += s.captureLive;
+        total.ambientFromBacklog += s.ambientFromBacklog;
+        total.captureFromBacklog += s.captureFromBacklog;
+        total.thinned += s.thinned;
+        total.summarized += s.summarized;
+        total.capped += s.capped;
+        maxItemsPerNode.push_back((uint32_t)s.maxPendingItems);
+        maxCyclePerNode.push_back((uint32_t)s.maxCycleMs);
+        maxNodeBytes = std::max(maxNodeBytes, s.maxPendingBytes);
+    }
+
+    printf("\n=== Fleet simulation: %u nodes, %.1f h virtual, %u threads ===\n", opt.nodes, opt.hours, opt.threads);
+    printf("Wall time %.2f s (%.0fx real time), %llu node steps\n", wallSeconds,
+           wallSeconds > 0 ? (double)durationMs / 1000.0 / wallSeconds : 0.0, (unsigned long long)steps);
+
+    // --- Throughput en el backend ---
+    const std::vector<uint32_t>& perSecond = backend.arrivalsPerSecond();
+    uint64_t served = 0;
+    uint32_t peak = 0;
+    size_t peakSecond = 0;
+    std::vector<uint32_t> active;
+    for (size_t s = 0; s < perSecond.size(); s++) {
+        served += perSecond[s];
+        if (perSecond[s] > peak) {
+            peak = perSecond[s];
+            peakSecond = s;
+        }
+        if (perSecond[s] > 0) active.push_back(perSecond[s]);
+    }
+    printf("\n-- Backend throughput --\n");
+    printf("Requests served %llu (%.2f req/s mean over the run)\n", (unsigned long long)served,
+           (double)served * 1000.0 / (double)durationMs);
+    printf("Peak %u req/s at %s; busy seconds p50 %u / p99 %u req/s\n", peak, hms((int64_t)peakSecond * 1000).c_str(),
+           percentile(active, 0.50), percentile(active, 0.99));
+    printf("Rejected during outages %llu, client timeouts under load %llu, 401 answers %llu\n",
+           (unsigned long long)backend.outageRejected(), (unsigned long long)backend.clientTimeouts(),
+           (unsigned long long)backend.unauthorized());
+    std::vector<uint32_t> waits = backend.queueWaitMs();
+    printf("Queue wait in backend p50 %u / p99 %u / max %u ms\n", percentile(waits, 0.50), percentile(waits, 0.99),
+           waits.empty() ? 0 : *std::max_element(waits.begin(), waits.end()));
+
+    // Reparto de la carga según la distancia al inicio del slot (efecto "manada")
+    static const int edges[] = {5, 15, 30, 60, 120, 300};
+    uint64_t buckets[7] = {0};
+    for (size_t s = 0; s < perSecond.size(); s++) {
+        int offset = (int)(((int64_t)s * 1000) % slotMs / 1000);
+        size_t b = 0;
+        while (b < 6 && offset >= edges[b]) b++;
+        buckets[b] += perSecond[s];
+    }
+    printf("Load by offset from slot start:");
+    for (size_t b = 0; b < 7; b++) {
+        char label[24];
+        if (b == 0) snprintf(label, sizeof(label), "<%ds", edges[0]);
+        else if (b < 6) snprintf(label, sizeof(label), "%d-%ds", edges[b - 1], edges[b]);
+        else snprintf(label, sizeof(label), ">=%ds", edges[5]);
+        printf(" %s %.1f%%", label, served ? 100.0 * (double)buckets[b] / (double)served : 0.0);
+    }
+    printf("\n");
+
+    // --- Latencias vistas por los nodos ---
+    printf("\n-- Client latency (ms, includes uplink, queueing and timeouts) --\n");
+    printf("%-15s %10s %8s %8s %8s %8s\n", "endpoint", "requests", "p50", "p95", "p99", "max");
+    for (size_t e = 0; e < (size_t)MockEndpoint::COUNT; e++) {
+        std::vector<uint32_t>& v = total.latencyMs[e];
+        if (v.empty()) continue;
+        uint32_t mx = *std::max_element(v.begin(), v.end());
+        printf("%-15s %10zu %8u %8u %8u %8u\n", mockEndpointName((MockEndpoint)e), v.size(),
+               percentile(v, 0.50), percentile(v, 0.95), percentile(v, 0.99), mx);
+    }
+
+    // --- Datos y cola offline ---
+    printf("\n-- Data delivery --\n");
+    printf("Cycles %llu (skipped without auth %llu); longest cycle p99 %s / max %s\n",
+           (unsigned long long)total.cycles, (unsigned long long)total.cyclesSkipped,
+           hms(percentile(maxCyclePerNode, 0.99)).c_str(), hms(percentile(maxCyclePerNode, 1.0)).c_str());
+    printf("Ambient: %llu live, %llu from backlog; captures: %llu live, %llu from backlog\n",
+           (unsigned long long)total.ambientLive, (unsigned long long)total.ambientFromBacklog,
+           (unsigned long long)total.captureLive, (unsigned long long)total.captureFromBacklog);
+    if (!total.backlogDelaySec.empty()) {
+        printf("Backlog delivery delay p50 %s / p99 %s\n",
+               hms((int64_t)percentile(total.backlogDelaySec, 0.50) * 1000).c_str(),
+               hms((int64_t)percentile(total.backlogDelaySec, 0.99) * 1000).c_str());
+    }
+    printf("Compaction: %llu thinned, %llu summarized, %llu dropped by byte cap\n",
+           (unsigned long long)total.thinned, (unsigned long long)total.summarized, (unsigned long long)total.capped);
+
+    printf("\n-- Pending queues --\n");
+    printf("Fleet peak %llu items / %.1f MB at %s\n", (unsigned long long)backlog.peakItems,
+           (double)backlog.peakBytes / 1048576.0, hms(backlog.peakAtMs).c_str());
+    printf("Per node max items p50 %u / p99 %u / max %u; max bytes %.1f MB\n", percentile(maxItemsPerNode, 0.50),
+           percentile(maxItemsPerNode, 0.99), percentile(maxItemsPerNode, 1.0), (double)maxNodeBytes / 1048576.0);
+    uint64_t leftItems = 0;
+    for (const SimNode& n : nodes) leftItems += n.pendingItems();
+    printf("Still pending at end %llu items\n", (unsigned long long)leftItems);
+
+    for (size_t i = 0; i < opt.backend.outages.size(); i++) {
+        const SimOutage& o = opt.backend.outages[i];
+        printf("Outage %s-%s: ", hms(o.startMs).c_str(), hms(o.endMs).c_str());
+        if (backlog.recoveredAtMs[i] < 0) printf("queues not drained by the end of the run\n");
+        else printf("queues drained %s after the backend came back\n", hms(backlog.recoveredAtMs[i] - o.endMs).c_str());
+    }
+}
+
+// =========================================================================
+// ===                         BUCLE DE EVENTOS                          ===
+// =========================================================================
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) return 2;
+
+    const int64_t durationMs = (int64_t)(opt.hours * 3600000.0);
+    const int64_t tick = opt.tickMs;
+
+    if (opt.node.writeFiles) std::filesystem::remove_all(opt.workDir);
+
+    std::vector<SimNode> nodes;
+    nodes.reserve(opt.nodes);
+    for (uint32_t i = 0; i < opt.nodes; i++) {
+        char dir[32];
+        snprintf(dir, sizeof(dir), "/node_%04u", i);
+        nodes.emplace_back(i, opt.node, SIM_EPOCH_BASE, opt.workDir + dir, opt.seed);
+    }
+    SimBackend backend(opt.backend, SIM_EPOCH_BASE * 1000, opt.seed, durationMs);
+    ThreadPool pool(opt.threads);
+    BacklogTracker backlog(opt.backend.outages.size());
+
+    // Los instantes se redondean al tick: los nodos que coinciden avanzan juntos
+    auto quantize = [tick](int64_t t) { return (t + tick - 1) / tick * tick; };
+
+    std::vector<uint32_t> due;
+    std::vector<SimRequest> requests(opt.nodes);
+    std::vector<uint8_t> emitted(opt.nodes);
+    uint64_t steps = 0;
+    auto wallStart = std::chrono::steady_clock::now();
+
+    for (;;) {
+        int64_t now = INT64_MAX;
+        for (const SimNode& n : nodes) now = std::min(now, quantize(n.wakeMs()));
+        if (now >= durationMs) break;
+
+        due.clear();
+        for (const SimNode& n : nodes) {
+            if (quantize(n.wakeMs()) == now) due.push_back(n.id());
+        }
+
+        // Fase paralela: cada nodo avanza su ciclo (archivos incluidos)
+        pool.parallelFor(due.size(), [&](size_t k) {
+            uint32_t id = due[k];
+            emitted[id] = nodes[id].step(now, requests[id]) ? 1 : 0;
+        });
+        steps += due.size();
+
+        // Fase serie: el backend atiende en orden de nodo (determinista)
+        for (uint32_t id : due) {
+            if (emitted[id]) nodes[id].deliver(requests[id], backend.handle(requests[id]));
+        }
+
+        uint64_t items = 0, bytes = 0;
+        for (const SimNode& n : nodes) {
+            items += n.pendingItems();
+            bytes += n.pendingBytes();
+        }
+        backlog.sample(now, items, bytes, opt.backend.outages);
+    }
+
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    printReport(opt, backend, nodes, backlog, durationMs, wallSeconds, steps);
+
+    if (opt.node.writeFiles && !opt.keepFiles) std::filesystem::remove_all(opt.workDir);
+    return 0;
+}
@@ -0,0 +1,83 @@
+// Benchmark en el host de los kernels puros de las rutas críticas: estadísticas térmicas
+// (lib/ThermalStats) y formato de timestamps y líneas de log (lib/LogFormat).
+//
+// Es el mismo código que mide test/test_benchmarks en el dispositivo, sin Arduino ni placa,
+// así que la comparación con la línea base del host puede ir en CI o antes de cada commit:
+//     g++ -std=c++17 -O2 -Ilib/ThermalStats -Ilib/LogFormat -Itest/test_benchmarks tools/host_bench/host_bench.cpp lib/ThermalStats/ThermalStats.cpp lib/LogFormat/LogFormat.cpp -o host_bench
+//     ./host_bench > bench.log
+//     python3 tools/bench_compare.py bench.log --baseline test/test_benchmarks/baseline_host.json
+//
+// En el host una llamada dura menos de lo que resuelve el reloj, así que cada iteración medida
+// repite el kernel HOST_BATCH veces: los tiempos de las líneas BENCH_JSON son por lote.
+// La línea base solo vale para la máquina y el compilador en que se registró (campo "board").
+
+#include "ThermalStats.h"
+#include "LogFormat.h"
+#include "bench_harness.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define HOST_ITERATIONS 200   // Iteraciones medidas por kernel (BENCH_MAX_ITERATIONS)
+#define HOST_BATCH 100        // Llamadas al kernel por iteración medida
+#define THERMAL_PIXELS 768    // Cuadro del MLX90640 (32x24)
+
+// Cuadro térmico determinista de 15-35 °C con algunos píxeles NaN (el mismo del dispositivo)
+static void fillThermalFrame(float* frame) {
+    for (int i = 0; i < THERMAL_PIXELS; i++) {
+        frame[i] = 15.0f + (float)((i * 37) % 200) / 10.0f;
+    }
+    frame[10] = NAN;
+    frame[500] = NAN;
+}
+
+int main() {
+    static float thermalFrame[THERMAL_PIXELS];
+    fillThermalFrame(thermalFrame);
+
+    // El resultado se acumula en un volatile para que el compilador no elimine el cálculo
+    volatile float thermalSink = 0;
+    bench::run("thermal_stats", HOST_ITERATIONS, [&]() {
+        for (int b = 0; b < HOST_BATCH; b++) {
+            thermalSink = thermalSink + thermalMax(thermalFrame, THERMAL_PIXELS)
+                        + thermalMin(thermalFrame, THERMAL_PIXELS)
+                        + thermalAverage(thermalFrame, THERMAL_PIXELS);
+        }
+    });
+
+    time_t epoch = 1761912000; // 2025-10-31 12:00:00 UTC
+    struct tm timeinfo;
+    gmtime_r(&epoch, &timeinfo);
+    char timestamp[LOG_FORMAT_TIMESTAMP_LEN];
+    volatile size_t timestampSink = 0;
+    bench::run("timestamp_format", HOST_ITERATIONS, [&]() {
+        for (int b = 0; b < HOST_BATCH; b++) {
+            timeinfo.tm_sec = b % 60;
+            timestampSink = timestampSink + formatTimestamp(timeinfo, (b & 1) != 0, timestamp, sizeof(timestamp));
+        }
+    });
+
+    // Misma línea que el benchmark del dispositivo (aviso de envío pendiente fallido)
+    const char* message = "Failed send pending ambient: 20251031_120000_thermal.json. HTTP: -11";
+    char line[LOG_FORMAT_LINE_STACK_LEN];
+    volatile size_t lineSink = 0;
+    bench::run("log_format_text", HOST_ITERATIONS, [&]() {
+        for (int b = 0; b < HOST_BATCH; b++) {
+            lineSink = lineSink + formatLogLine(line, sizeof(line), "2025-10-31T12:00:00", "WARNING", message, 31.4f);
+        }
+    });
+
+    // Comprobación de resultados: un kernel roto no debe pasar por una mejora de rendimiento
+    gmtime_r(&epoch, &timeinfo);
+    formatTimestamp(timeinfo, false, timestamp, sizeof(timestamp));
+    formatLogLine(line, sizeof(line), "2025-10-31T12:00:00", "WARNING", message, 31.4f);
+    float avg = thermalAverage(thermalFrame, THERMAL_PIXELS);
+    printf("thermal max %.1f min %.1f avg %.2f | %s | %s\n", thermalMax(thermalFrame, THERMAL_PIXELS),
+           thermalMin(thermalFrame, THERMAL_PIXELS), avg, timestamp, line);
+    if (isnan(avg) || strlen(timestamp) != 19 || strstr(line, "(DevTemp: 31.4C )") == nullptr) {
+        fprintf(stderr, "Resultado inesperado de un kernel\n");
+        return 1;
+    }
+    return 0;
+}
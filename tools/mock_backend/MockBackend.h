@@ -0,0 +1,417 @@
+#ifndef MOCK_BACKEND_H
+#define MOCK_BACKEND_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+// Lógica del backend simulado (sin red): endpoints /api/device-api/*, tokens con forma
+// de JWT y la misma semántica que espera la clase API:
+//   - activate: {deviceId, activationCode, macAddress} -> {accessToken, refreshToken, dataCollectionTime}
+//   - auth: {"token": access} -> 200 si el access token está vigente, 401 si caducó o no existe
+//   - refresh-token: {"token": refresh} -> tokens nuevos; el refresh anterior deja de valer (rotación)
+//   - log / ambient-data / capture-data: "Authorization: Device <access>" o 401
+// La usan el servidor HTTP (mock_backend.cpp) y el simulador de flota (tools/fleet_sim),
+// que le pasa su reloj virtual. Todas las operaciones públicas toman el mutex interno.
+
+enum class MockEndpoint : uint8_t {
+    ACTIVATE = 0,
+    AUTH,
+    REFRESH_TOKEN,
+    LOG,
+    AMBIENT_DATA,
+    CAPTURE_DATA,
+    COUNT
+};
+
+inline const char* mockEndpointName(MockEndpoint ep) {
+    static const char* const names[] = {"activate", "auth", "refresh-token", "log", "ambient-data", "capture-data"};
+    return ep < MockEndpoint::COUNT ? names[(size_t)ep] : "unknown";
+}
+
+inline bool mockEndpointFromName(const std::string& name, MockEndpoint& ep) {
+    for (size_t i = 0; i < (size_t)MockEndpoint::COUNT; i++) {
+        if (name == mockEndpointName((MockEndpoint)i)) {
+            ep = (MockEndpoint)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+struct MockBackendConfig {
+    std::string pathPrefix = "/api/device-api/";  ///< Mismas rutas que Config (ConfigManager.h)
+    int64_t accessTtlMs = 3600LL * 1000;          ///< Vida del access token
+    int64_t refreshTtlMs = 30LL * 24 * 3600 * 1000; ///< Vida del refresh token
+    int dataCollectionTime = 0;                   ///< Minutos devueltos al dispositivo (0 = no se envía)
+    std::string activationCode;                   ///< Vacío: se acepta cualquier código
+    double errorRate = 0.0;                       ///< Fracción de peticiones con error inyectado
+    double endpointErrorRate[(size_t)MockEndpoint::COUNT] = {-1, -1, -1, -1, -1, -1}; ///< -1 = usa errorRate
+    int errorStatus = 500;
+    int latencyMs = 0;                            ///< Retardo antes de responder
+    int jitterMs = 0;                             ///< + uniforme en [0, jitterMs]
+    double bandwidthKBps = 0.0;                   ///< Tope de lectura del cuerpo (0 = sin tope); lo aplica el transporte
+    bool keepRecords = true;                      ///< Guarda cada petición en memoria para las aserciones
+    uint32_t seed = 1;
+};
+
+struct MockTokens {
+    std::string access;
+    std::string refresh;
+};
+
+struct MockResponse {
+    int status = 0;
+    std::string body;
+    int64_t delayMs = 0;   ///< Latencia simulada que debe esperar el transporte
+};
+
+/**
+ * @brief Una petición atendida (para aserciones en tests y para el JSONL de --record).
+ */
+struct MockRecord {
+    uint64_t seq;
+    int64_t timeMs;
+    MockEndpoint endpoint;
+    std::string deviceId;  ///< Del token o del cuerpo de activate ("" si no se pudo saber)
+    int status;
+    uint32_t requestBytes;
+    int64_t delayMs;
+    bool injected;         ///< Error inyectado por errorRate
+};
+
+class MockBackend {
+public:
+    explicit MockBackend(const MockBackendConfig& cfg) : _cfg(cfg), _rng(cfg.seed) {}
+
+    const MockBackendConfig& config() const { return _cfg; }
+
+    /**
+     * @brief Atiende una petición HTTP ya parseada.
+     * @param authorization Valor de la cabecera Authorization ("" si no vino).
+     * @param nowMs Hora Unix en ms (real en el servidor, virtual en el simulador).
+     */
+    MockResponse handle(MockEndpoint ep, const std::string& authorization, const std::string& body, int64_t nowMs) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        MockResponse resp;
+        std::string deviceId;
+        bool injected = false;
+
+        resp.delayMs = _cfg.latencyMs;
+        if (_cfg.jitterMs > 0) resp.delayMs += std::uniform_int_distribution<int>(0, _cfg.jitterMs)(_rng);
+
+        double rate = _cfg.endpointErrorRate[(size_t)ep] >= 0.0 ? _cfg.endpointErrorRate[(size_t)ep] : _cfg.errorRate;
+        if (rate > 0.0 && std::uniform_real_distribution<double>(0.0, 1.0)(_rng) < rate) {
+            injected = true;
+            resp.status = _cfg.errorStatus;
+            resp.body = "{\"error\":\"injected\"}";
+        } else {
+            _dispatch(ep, authorization, body, nowMs, resp, deviceId);
+        }
+        _record(ep, deviceId, resp, (uint32_t)body.size(), nowMs, injected);
+        return resp;
+    }
+
+    // --- Primitivas de tokens (el simulador de flota las llama sin pasar por HTTP) ---
+
+    int activate(const std::string& deviceId, const std::string& code, int64_t nowMs, MockTokens& out) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _activate(deviceId, code, nowMs, out);
+    }
+
+    int checkAccess(const std::string& token, int64_t nowMs, std::string* deviceId = nullptr) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _checkAccess(token, nowMs, deviceId);
+    }
+
+    int refresh(const std::string& token, int64_t nowMs, MockTokens& out) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _refresh(token, nowMs, out);
+    }
+
+    /**
+     * @brief Caduca todos los access tokens: la próxima petición de cada dispositivo recibe 401.
+     */
+    void expireAccessTokens() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto& kv : _tokens) {
+            if (kv.second.isAccess) kv.second.expiresMs = 0;
+        }
+    }
+
+    /**
+     * @brief Revoca también los refresh tokens: los dispositivos tendrán que reactivarse.
+     */
+    void revokeAllTokens() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _tokens.clear();
+        _deviceTokens.clear();
+    }
+
+    /**
+     * @brief Borra tokens, contadores y registros.
+     */
+    void reset() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _tokens.clear();
+        _deviceTokens.clear();
+        _records.clear();
+        _seq = 0;
+        std::fill(_counts, _counts + (size_t)MockEndpoint::COUNT, 0);
+    }
+
+    // --- Registro de peticiones ---
+
+    uint64_t count(MockEndpoint ep) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _counts[(size_t)ep];
+    }
+
+    std::vector<MockRecord> records(uint64_t sinceSeq = 0) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::vector<MockRecord> out;
+        for (const MockRecord& r : _records) {
+            if (r.seq > sinceSeq) out.push_back(r);
+        }
+        return out;
+    }
+
+    static std::string recordToJson(const MockRecord& r) {
+        char buf[256];
+        snprintf(buf, sizeof(buf),
+                 "{\"seq\":%llu,\"timeMs\":%lld,\"endpoint\":\"%s\",\"deviceId\":\"%s\",\"status\":%d,"
+                 "\"requestBytes\":%u,\"delayMs\":%lld,\"injected\":%s}",
+                 (unsigned long long)r.seq, (long long)r.timeMs, mockEndpointName(r.endpoint),
+                 _jsonSafe(r.deviceId).c_str(), r.status, r.requestBytes, (long long)r.delayMs,
+                 r.injected ? "true" : "false");
+        return buf;
+    }
+
+    std::string statsJson() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::string out = "{";
+        for (size_t i = 0; i < (size_t)MockEndpoint::COUNT; i++) {
+            out += std::string(i ? "," : "") + "\"" + mockEndpointName((MockEndpoint)i) + "\":" + std::to_string(_counts[i]);
+        }
+        return out + ",\"activeDevices\":" + std::to_string(_deviceTokens.size()) + "}";
+    }
+
+    // --- Utilidades JSON mínimas (el firmware envía JSON plano de un nivel) ---
+
+    /**
+     * @brief Valor de "key" en un JSON plano: el texto de una cadena o el literal (número, bool).
+     */
+    static bool jsonField(const std::string& json, const std::string& key, std::string& value) {
+        size_t pos = json.find("\"" + key + "\"");
+        if (pos == std::string::npos) return false;
+        pos = json.find(':', pos + key.size() + 2);
+        if (pos == std::string::npos) return false;
+        pos = json.find_first_not_of(" \t\r\n", pos + 1);
+        if (pos == std::string::npos) return false;
+        if (json[pos] == '"') {
+            size_t end = json.find('"', pos + 1);
+            if (end == std::string::npos) return false;
+            value = json.substr(pos + 1, end - pos - 1);
+        } else {
+            size_t end = json.find_first_of(",} \t\r\n", pos);
+            value = json.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+        }
+        return true;
+    }
+
+private:
+    struct TokenInfo {
+        std::string deviceId;
+        bool isAccess;
+        int64_t expiresMs;
+    };
+
+    void _dispatch(MockEndpoint ep, const std::string& authorization, const std::string& body, int64_t nowMs,
+                   MockResponse& resp, std::string& deviceId) {
+        std::string field;
+        MockTokens tokens;
+        switch (ep) {
+            case MockEndpoint::ACTIVATE: {
+                std::string code;
+                if (!jsonField(body, "deviceId", deviceId) || !jsonField(body, "activationCode", code)) {
+                    _badRequest(resp, "deviceId and activationCode are required");
+                    return;
+                }
+                resp.status = _activate(deviceId, code, nowMs, tokens);
+                break;
+            }
+            case MockEndpoint::AUTH:
+                if (!jsonField(body, "token", field)) {
+                    _badRequest(resp, "token is required");
+                    return;
+                }
+                resp.status = _checkAccess(field, nowMs, &deviceId);
+                if (resp.status == 200) {
+                    resp.body = _cfg.dataCollectionTime > 0
+                        ? "{\"status\":\"ok\",\"dataCollectionTime\":" + std::to_string(_cfg.dataCollectionTime) + "}"
+                        : "{\"status\":\"ok\"}";
+                    return;
+                }
+                break;
+            case MockEndpoint::REFRESH_TOKEN:
+                if (!jsonField(body, "token", field)) {
+                    _badRequest(resp, "token is required");
+                    return;
+                }
+                resp.status = _refresh(field, nowMs, tokens);
+                deviceId = _deviceOf(tokens.access);
+                break;
+            default: {
+                // Endpoints de datos: "Authorization: Device <token>" (MultipartDataSender, EnvironmentDataJSON, ErrorLogger)
+                const std::string scheme = "Device ";
+                std::string token = authorization.compare(0, scheme.size(), scheme) == 0 ? authorization.substr(scheme.size()) : "";
+                resp.status = _checkAccess(token, nowMs, &deviceId);
+                if (resp.status != 200) break;
+                const char* missing = _missingDataField(ep, body);
+                if (missing) {
+                    _badRequest(resp, std::string(missing) + " is required");
+                    return;
+                }
+                resp.status = 200; // EnvironmentTasks solo acepta 200/204 para ambient-data
+                resp.body = "{\"status\":\"stored\"}";
+                return;
+            }
+        }
+
+        if (resp.status == 200) {
+            resp.body = "{\"accessToken\":\"" + tokens.access + "\",\"refreshToken\":\"" + tokens.refresh + "\"";
+            if (_cfg.dataCollectionTime > 0) resp.body += ",\"dataCollectionTime\":" + std::to_string(_cfg.dataCollectionTime);
+            resp.body += "}";
+        } else if (resp.status == 401) {
+            resp.body = "{\"error\":\"unauthorized\"}";
+        } else if (resp.status == 403) {
+            resp.body = "{\"error\":\"invalid activation code\"}";
+        }
+    }
+
+    static const char* _missingDataField(MockEndpoint ep, const std::string& body) {
+        std::string value;
+        switch (ep) {
+            case MockEndpoint::LOG:
+                return jsonField(body, "logType", value) ? nullptr : "logType";
+            case MockEndpoint::AMBIENT_DATA:
+                return jsonField(body, "timestamp", value) ? nullptr : "timestamp";
+            case MockEndpoint::CAPTURE_DATA: // Multipart con la parte "thermal" (la imagen es opcional)
+                return body.find("name=\"thermal\"") != std::string::npos ? nullptr : "thermal part";
+            default:
+                return nullptr;
+        }
+    }
+
+    static void _badRequest(MockResponse& resp, const std::string& message) {
+        resp.status = 400;
+        resp.body = "{\"error\":\"" + _jsonSafe(message) + "\"}";
+    }
+
+    int _activate(const std::string& deviceId, const std::string& code, int64_t nowMs, MockTokens& out) {
+        if (!_cfg.activationCode.empty() && code != _cfg.activationCode) return 403;
+        _issue(deviceId, nowMs, out); // Una reactivación invalida los tokens anteriores
+        return 200;
+    }
+
+    int _checkAccess(const std::string& token, int64_t nowMs, std::string* deviceId) {
+        auto it = _tokens.find(token);
+        if (it == _tokens.end() || !it->second.isAccess) return 401;
+        if (deviceId) *deviceId = it->second.deviceId;
+        return nowMs < it->second.expiresMs ? 200 : 401;
+    }
+
+    int _refresh(const std::string& token, int64_t nowMs, MockTokens& out) {
+        auto it = _tokens.find(token);
+        if (it == _tokens.end() || it->second.isAccess || nowMs >= it->second.expiresMs) return 401;
+        std::string deviceId = it->second.deviceId;
+        _issue(deviceId, nowMs, out); // Rotación: el refresh usado y el access anterior dejan de valer
+        return 200;
+    }
+
+    void _issue(const std::string& deviceId, int64_t nowMs, MockTokens& out) {
+        MockTokens& current = _deviceTokens[deviceId];
+        _tokens.erase(current.access);
+        _tokens.erase(current.refresh);
+        out.access = _makeJwt(deviceId, "access", nowMs, _cfg.accessTtlMs);
+        out.refresh = _makeJwt(deviceId, "refresh", nowMs, _cfg.refreshTtlMs);
+        _tokens[out.access] = TokenInfo{deviceId, true, nowMs + _cfg.accessTtlMs};
+        _tokens[out.refresh] = TokenInfo{deviceId, false, nowMs + _cfg.refreshTtlMs};
+        current = out;
+    }
+
+    std::string _deviceOf(const std::string& token) const {
+        auto it = _tokens.find(token);
+        return it == _tokens.end() ? "" : it->second.deviceId;
+    }
+
+    // JWT con cabecera y claims reales; la firma es un hash (el firmware no la verifica)
+    std::string _makeJwt(const std::string& deviceId, const char* type, int64_t nowMs, int64_t ttlMs) {
+        std::string header = _base64Url("{\"alg\":\"HS256\",\"typ\":\"JWT\"}");
+        std::string claims = _base64Url("{\"sub\":\"" + _jsonSafe(deviceId) + "\",\"typ\":\"" + type +
+                                        "\",\"iat\":" + std::to_string(nowMs / 1000) +
+                                        ",\"exp\":" + std::to_string((nowMs + ttlMs) / 1000) +
+                                        ",\"jti\":" + std::to_string(++_jti) + "}");
+        std::string signed_ = header + "." + claims;
+        uint64_t h1 = 1469598103934665603ULL, h2 = 1099511628211ULL ^ _cfg.seed;
+        for (unsigned char c : signed_) {
+            h1 = (h1 ^ c) * 1099511628211ULL;
+            h2 = (h2 ^ c) * 1469598103934665603ULL + 0x9E3779B97F4A7C15ULL;
+        }
+        std::string sig;
+        for (int i = 0; i < 8; i++) sig += (char)(h1 >> (8 * i));
+        for (int i = 0; i < 8; i++) sig += (char)(h2 >> (8 * i));
+        return signed_ + "." + _base64Url(sig);
+    }
+
+    static std::string _base64Url(const std::string& in) {
+        static const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+        std::string out;
+        uint32_t acc = 0;
+        int bits = 0;
+        for (unsigned char c : in) {
+            acc = (acc << 8) | c;
+            bits += 8;
+            while (bits >= 6) {
+                bits -= 6;
+                out += alphabet[(acc >> bits) & 0x3F];
+            }
+        }
+        if (bits > 0) out += alphabet[(acc << (6 - bits)) & 0x3F];
+        return out;
+    }
+
+    static std::string _jsonSafe(const std::string& s) {
+        std::string out;
+        for (char c : s) {
+            if (c == '"' || c == '\\') out += '\\';
+            if ((unsigned char)c >= 0x20) out += c;
+        }
+        return out;
+    }
+
+    void _record(MockEndpoint ep, const std::string& deviceId, const MockResponse& resp, uint32_t bytes, int64_t nowMs, bool injected) {
+        _counts[(size_t)ep]++;
+        ++_seq;
+        if (_cfg.keepRecords) {
+            _records.push_back(MockRecord{_seq, nowMs, ep, deviceId, resp.status, bytes, resp.delayMs, injected});
+        }
+    }
+
+    MockBackendConfig _cfg;
+    std::mutex _mutex;
+    std::mt19937 _rng;
+    std::map<std::string, TokenInfo> _tokens;
+    std::map<std::string, MockTokens> _deviceTokens; ///< Tokens vigentes por dispositivo
+    std::vector<MockRecord> _records;
+    uint64_t _counts[(size_t)MockEndpoint::COUNT] = {0};
+    uint64_t _seq = 0;
+    uint64_t _jti = 0;
+};
+
+#endif // MOCK_BACKEND_H
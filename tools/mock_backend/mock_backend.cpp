@@ -0,0 +1,375 @@
+// Backend simulado para pruebas sin conexión: servidor HTTP/1.1 (POSIX sockets, un hilo
+// por conexión) con los endpoints /api/device-api/* de MockBackend.h.
+//
+// Arranque (compila si hace falta):
+//     tools/mock_backend/run.sh --port 8080 --latency-ms 80 --error-rate capture-data=0.1
+// y en config.json del dispositivo: "api_base_url": "http://<ip-del-pc>:8080".
+//
+// Rutas de control para tests y benchmarks (fuera de la API del dispositivo):
+//     GET  /__mock/health               -> {"status":"ok"}
+//     GET  /__mock/stats                -> peticiones por endpoint y dispositivos activos
+//     GET  /__mock/requests?since=N     -> peticiones registradas con seq > N (JSON array)
+//     POST /__mock/expire-tokens        -> los access tokens caducan (próxima petición: 401)
+//     POST /__mock/revoke-tokens        -> también los refresh tokens (obliga a reactivar)
+//     POST /__mock/reset                -> borra tokens, contadores y registros
+//
+// --help lista todas las opciones.
+
+#include "MockBackend.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#define MAX_HEADER_BYTES (16 * 1024)
+#define MAX_BODY_BYTES (8 * 1024 * 1024)   // Muy por encima de una captura (JSON térmico + JPEG)
+#define SOCKET_TIMEOUT_SEC 30
+#define READ_CHUNK_BYTES 1460               // Un segmento TCP: granularidad del tope de ancho de banda
+
+struct ServerOptions {
+    std::string bind = "0.0.0.0";
+    int port = 8080;
+    std::string recordPath;
+    bool quiet = false;
+    MockBackendConfig backend;
+};
+
+static MockBackend* g_backend = nullptr;
+static ServerOptions g_opt;
+static FILE* g_recordFile = nullptr;
+static std::mutex g_outputMutex;
+static uint64_t g_lastWrittenSeq = 0;
+
+static int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static void usage(const char* argv0) {
+    printf("Usage: %s [options]\n\n"
+           "  --port N                 Listen port (default 8080)\n"
+           "  --bind ADDR              Listen address (default 0.0.0.0)\n"
+           "  --latency-ms N           Delay before every response (default 0)\n"
+           "  --jitter-ms N            Extra uniform delay in [0, N] (default 0)\n"
+           "  --bandwidth-kBps N       Cap on request body upload rate per connection (default: none)\n"
+           "  --error-rate [EP=]F      Fraction of requests answered with --error-status; EP limits it\n"
+           "                           to one endpoint (activate, auth, refresh-token, log,\n"
+           "                           ambient-data, capture-data). Repeatable\n"
+           "  --error-status N         Status used for injected errors (default 500)\n"
+           "  --access-ttl-s N         Access token lifetime (default 3600)\n"
+           "  --refresh-ttl-s N        Refresh token lifetime (default 30 days)\n"
+           "  --collection-time MIN    dataCollectionTime returned to devices (default: not sent)\n"
+           "  --activation-code CODE   Only accept this activation code (default: any)\n"
+           "  --path-prefix P          API prefix (default /api/device-api/)\n"
+           "  --record FILE            Append every request as a JSON line to FILE\n"
+           "  --seed N                 RNG seed for jitter and injected errors (default 1)\n"
+           "  --quiet                  Do not print one line per request\n",
+           argv0);
+}
+
+static bool parseArgs(int argc, char** argv, ServerOptions& opt) {
+    MockBackendConfig& b = opt.backend;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "error: %s needs a value\n", a.c_str());
+                exit(2);
+            }
+            return argv[++i];
+        };
+        if (a == "--help" || a == "-h") { usage(argv[0]); exit(0); }
+        else if (a == "--port") opt.port = atoi(next().c_str());
+        else if (a == "--bind") opt.bind = next();
+        else if (a == "--latency-ms") b.latencyMs = atoi(next().c_str());
+        else if (a == "--jitter-ms") b.jitterMs = atoi(next().c_str());
+        else if (a == "--bandwidth-kBps") b.bandwidthKBps = atof(next().c_str());
+        else if (a == "--error-rate") {
+            std::string v = next();
+            size_t eq = v.find('=');
+            if (eq == std::string::npos) {
+                b.errorRate = atof(v.c_str());
+            } else {
+                MockEndpoint ep;
+                if (!mockEndpointFromName(v.substr(0, eq), ep)) {
+                    fprintf(stderr, "error: unknown endpoint '%s'\n", v.substr(0, eq).c_str());
+                    return false;
+                }
+                b.endpointErrorRate[(size_t)ep] = atof(v.c_str() + eq + 1);
+            }
+        }
+        else if (a == "--error-status") b.errorStatus = atoi(next().c_str());
+        else if (a == "--access-ttl-s") b.accessTtlMs = atoll(next().c_str()) * 1000;
+        else if (a == "--refresh-ttl-s") b.refreshTtlMs = atoll(next().c_str()) * 1000;
+        else if (a == "--collection-time") b.dataCollectionTime = atoi(next().c_str());
+        else if (a == "--activation-code") b.activationCode = next();
+        else if (a == "--path-prefix") b.pathPrefix = next();
+        else if (a == "--record") opt.recordPath = next();
+        else if (a == "--seed") b.seed = (uint32_t)strtoul(next().c_str(), nullptr, 10);
+        else if (a == "--quiet") opt.quiet = true;
+        else {
+            fprintf(stderr, "error: unknown option '%s' (see --help)\n", a.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+// =========================================================================
+// ===                              HTTP                                 ===
+// =========================================================================
+
+struct HttpRequest {
+    std::string method;
+    std::string path;
+    std::string query;
+    std::string authorization;
+    std::string body;
+};
+
+static const char* reasonPhrase(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 411: return "Length Required";
+        case 413: return "Payload Too Large";
+        case 500: return "Internal Server Error";
+        case 502: return "Bad Gateway";
+        case 503: return "Service Unavailable";
+        case 504: return "Gateway Timeout";
+        default: return "Status";
+    }
+}
+
+static bool sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        sent += (size_t)n;
+    }
+    return true;
+}
+
+static void sendResponse(int fd, int status, const std::string& body) {
+    char header[256];
+    snprintf(header, sizeof(header),
+             "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+             status, reasonPhrase(status), body.size());
+    sendAll(fd, header + body);
+}
+
+/**
+ * @brief Lee una petición completa. El cuerpo se lee al ritmo de --bandwidth-kBps.
+ * @return Código de error HTTP a devolver (0 = petición válida, -1 = conexión perdida).
+ */
+static int readRequest(int fd, HttpRequest& req) {
+    std::string data;
+    char buf[4096];
+    size_t headerEnd;
+    while ((headerEnd = data.find("\r\n\r\n")) == std::string::npos) {
+        if (data.size() > MAX_HEADER_BYTES) return 413;
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) return -1;
+        data.append(buf, (size_t)n);
+    }
+
+    // Línea de petición y cabeceras
+    size_t lineEnd = data.find("\r\n");
+    std::string requestLine = data.substr(0, lineEnd);
+    size_t sp1 = requestLine.find(' ');
+    size_t sp2 = requestLine.find(' ', sp1 + 1);
+    if (sp1 == std::string::npos || sp2 == std::string::npos) return 400;
+    req.method = requestLine.substr(0, sp1);
+    std::string target = requestLine.substr(sp1 + 1, sp2 - sp1 - 1);
+    size_t q = target.find('?');
+    req.path = target.substr(0, q);
+    req.query = q == std::string::npos ? "" : target.substr(q + 1);
+
+    long contentLength = 0;
+    bool chunked = false;
+    size_t pos = lineEnd + 2;
+    while (pos < headerEnd) {
+        size_t end = data.find("\r\n", pos);
+        std::string line = data.substr(pos, end - pos);
+        pos = end + 2;
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) continue;
+        std::string name = line.substr(0, colon);
+        std::string value = line.substr(line.find_first_not_of(' ', colon + 1) == std::string::npos ? line.size() : line.find_first_not_of(' ', colon + 1));
+        if (strcasecmp(name.c_str(), "Content-Length") == 0) contentLength = atol(value.c_str());
+        else if (strcasecmp(name.c_str(), "Authorization") == 0) req.authorization = value;
+        else if (strcasecmp(name.c_str(), "Transfer-Encoding") == 0) chunked = true;
+    }
+    if (chunked) return 411; // HTTPClient del ESP32 siempre envía Content-Length
+    if (contentLength < 0) return 400;
+    if (contentLength > MAX_BODY_BYTES) return 413;
+
+    // Cuerpo, limitado al ancho de banda configurado
+    req.body = data.substr(headerEnd + 4);
+    const double bytesPerMs = g_opt.backend.bandwidthKBps * 1.024;
+    auto start = std::chrono::steady_clock::now();
+    while ((long)req.body.size() < contentLength) {
+        size_t want = std::min((size_t)(contentLength - (long)req.body.size()), (size_t)READ_CHUNK_BYTES);
+        ssize_t n = recv(fd, buf, want, 0);
+        if (n <= 0) return -1;
+        req.body.append(buf, (size_t)n);
+        if (bytesPerMs > 0) {
+            auto due = start + std::chrono::milliseconds((int64_t)((double)req.body.size() / bytesPerMs));
+            std::this_thread::sleep_until(due);
+        }
+    }
+    req.body.resize((size_t)contentLength);
+    return 0;
+}
+
+// =========================================================================
+// ===                             RUTAS                                 ===
+// =========================================================================
+
+static void flushRecords() {
+    if (!g_recordFile) return;
+    std::lock_guard<std::mutex> lock(g_outputMutex);
+    for (const MockRecord& r : g_backend->records(g_lastWrittenSeq)) {
+        fprintf(g_recordFile, "%s\n", MockBackend::recordToJson(r).c_str());
+        g_lastWrittenSeq = r.seq;
+    }
+    fflush(g_recordFile);
+}
+
+static void handleControl(int fd, const HttpRequest& req) {
+    const std::string route = req.path.substr(strlen("/__mock/"));
+    if (req.method == "GET" && route == "health") {
+        sendResponse(fd, 200, "{\"status\":\"ok\"}");
+    } else if (req.method == "GET" && route == "stats") {
+        sendResponse(fd, 200, g_backend->statsJson());
+    } else if (req.method == "GET" && route == "requests") {
+        uint64_t since = 0;
+        if (req.query.compare(0, 6, "since=") == 0) since = strtoull(req.query.c_str() + 6, nullptr, 10);
+        std::string out = "[";
+        for (const MockRecord& r : g_backend->records(since)) {
+            if (out.size() > 1) out += ",";
+            out += MockBackend::recordToJson(r);
+        }
+        sendResponse(fd, 200, out + "]");
+    } else if (req.method == "POST" && route == "expire-tokens") {
+        g_backend->expireAccessTokens();
+        sendResponse(fd, 200, "{\"status\":\"access tokens expired\"}");
+    } else if (req.method == "POST" && route == "revoke-tokens") {
+        g_backend->revokeAllTokens();
+        sendResponse(fd, 200, "{\"status\":\"all tokens revoked\"}");
+    } else if (req.method == "POST" && route == "reset") {
+        g_backend->reset();
+        std::lock_guard<std::mutex> lock(g_outputMutex);
+        g_lastWrittenSeq = 0;
+        sendResponse(fd, 200, "{\"status\":\"reset\"}");
+    } else {
+        sendResponse(fd, 404, "{\"error\":\"unknown control route\"}");
+    }
+}
+
+static void handleConnection(int fd) {
+    struct timeval tv = {SOCKET_TIMEOUT_SEC, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    HttpRequest req;
+    int error = readRequest(fd, req);
+    if (error != 0) {
+        if (error > 0) sendResponse(fd, error, "{\"error\":\"malformed request\"}");
+        close(fd);
+        return;
+    }
+
+    if (req.path.compare(0, 8, "/__mock/") == 0) {
+        handleControl(fd, req);
+        close(fd);
+        return;
+    }
+
+    const std::string& prefix = g_opt.backend.pathPrefix;
+    MockEndpoint ep;
+    if (req.path.compare(0, prefix.size(), prefix) != 0 || !mockEndpointFromName(req.path.substr(prefix.size()), ep)) {
+        sendResponse(fd, 404, "{\"error\":\"not found\"}");
+        close(fd);
+        return;
+    }
+    if (req.method != "POST") {
+        sendResponse(fd, 405, "{\"error\":\"POST only\"}");
+        close(fd);
+        return;
+    }
+
+    MockResponse resp = g_backend->handle(ep, req.authorization, req.body, nowMs());
+    if (resp.delayMs > 0) std::this_thread::sleep_for(std::chrono::milliseconds(resp.delayMs));
+    sendResponse(fd, resp.status, resp.body);
+    close(fd);
+
+    if (!g_opt.quiet) {
+        std::lock_guard<std::mutex> lock(g_outputMutex);
+        printf("POST %-28s %3d  %7zu B  +%lld ms\n", req.path.c_str(), resp.status, req.body.size(), (long long)resp.delayMs);
+        fflush(stdout);
+    }
+    flushRecords();
+}
+
+int main(int argc, char** argv) {
+    if (!parseArgs(argc, argv, g_opt)) return 2;
+
+    if (!g_opt.recordPath.empty()) {
+        g_recordFile = fopen(g_opt.recordPath.c_str(), "a");
+        if (!g_recordFile) {
+            perror(g_opt.recordPath.c_str());
+            return 1;
+        }
+    }
+    MockBackend backend(g_opt.backend);
+    g_backend = &backend;
+
+    int server = socket(AF_INET, SOCK_STREAM, 0);
+    int yes = 1;
+    setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)g_opt.port);
+    if (inet_pton(AF_INET, g_opt.bind.c_str(), &addr.sin_addr) != 1) {
+        fprintf(stderr, "error: invalid bind address '%s'\n", g_opt.bind.c_str());
+        return 2;
+    }
+    if (bind(server, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(server, 128) != 0) {
+        perror("bind/listen");
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    printf("Mock backend listening on http://%s:%d%s (latency %d+%d ms, bandwidth %s, access TTL %lld s)\n",
+           g_opt.bind.c_str(), g_opt.port, g_opt.backend.pathPrefix.c_str(), g_opt.backend.latencyMs, g_opt.backend.jitterMs,
+           g_opt.backend.bandwidthKBps > 0 ? (std::to_string((int)g_opt.backend.bandwidthKBps) + " kB/s").c_str() : "unlimited",
+           (long long)(g_opt.backend.accessTtlMs / 1000));
+    fflush(stdout);
+
+    for (;;) {
+        int fd = accept(server, nullptr, nullptr);
+        if (fd < 0) continue;
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        std::thread(handleConnection, fd).detach();
+    }
+}
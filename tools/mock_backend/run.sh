@@ -0,0 +1,11 @@
+#!/bin/sh
+# Compila (si hace falta) y arranca el backend simulado. Los argumentos pasan al servidor:
+#     tools/mock_backend/run.sh --port 8080 --latency-ms 80 --record requests.jsonl
+set -e
+DIR="$(cd "$(dirname "$0")" && pwd)"
+BIN="$DIR/.build/mock_backend"
+if [ ! -x "$BIN" ] || [ "$DIR/mock_backend.cpp" -nt "$BIN" ] || [ "$DIR/MockBackend.h" -nt "$BIN" ]; then
+    mkdir -p "$DIR/.build"
+    ${CXX:-g++} -std=c++17 -O2 -pthread "$DIR/mock_backend.cpp" -o "$BIN"
+fi
+exec "$BIN" "$@"
@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+"""
+Informe de tamaño, RAM y arranque por perfil de placa (lib/BoardProfile).
+
+Compila cada entorno de platformio.ini que selecciona un perfil (-D BOARD_PROFILE_*)
+y lee las líneas "RAM:" / "Flash:" del resumen de `pio run`. Opcionalmente añade los
+datos de arranque de los logs serie: el firmware imprime al terminar el setup una línea
+"BOOT_PROFILE {...}" (con ENABLE_DEBUG_SERIAL) con el perfil, el tiempo de arranque,
+el de inicialización de sensores y la memoria libre.
+
+Uso:
+    python3 tools/profile_report.py
+    python3 tools/profile_report.py -e freenove_esp32_s3_wroom_thermal
+    pio device monitor -e freenove_esp32_s3_wroom > boot_full.log      # (un arranque por perfil)
+    python3 tools/profile_report.py --boot-log boot_full.log --boot-log boot_thermal.log
+    python3 tools/profile_report.py --no-build --boot-log boot_full.log  # solo arranque
+
+Código de salida: 0 si todos los entornos compilan, 1 si alguno falla.
+"""
+import argparse
+import configparser
+import json
+import os
+import re
+import subprocess
+import sys
+
+PREFIX = "BOOT_PROFILE "
+PROJECT_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+PROFILE_FLAG = re.compile(r"-D\s*BOARD_PROFILE_([A-Z0-9_]+)")
+# Resumen de `pio run`: "RAM:   [==        ]  15.3% (used 50148 bytes from 327680 bytes)"
+SIZE_LINE = re.compile(r"^(RAM|Flash):.*\(used (\d+) bytes from (\d+) bytes\)")
+
+
+def profile_environments(ini_path):
+    """Devuelve [(entorno, perfil)] de los entornos que eligen un perfil de placa."""
+    parser = configparser.ConfigParser(interpolation=None, inline_comment_prefixes=(";",))
+    parser.read(ini_path, encoding="utf-8")
+    envs = []
+    for section in parser.sections():
+        if not section.startswith("env:"):
+            continue
+        match = PROFILE_FLAG.search(parser.get(section, "build_flags", fallback=""))
+        if match:
+            envs.append((section[len("env:"):], match.group(1).lower()))
+    return envs
+
+
+def build_sizes(env):
+    """Compila el entorno y devuelve {"RAM": (usado, total), "Flash": (usado, total)} o None."""
+    proc = subprocess.run(["pio", "run", "-e", env], cwd=PROJECT_DIR,
+                          stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+    sizes = {}
+    for line in proc.stdout.splitlines():
+        match = SIZE_LINE.match(line.strip())
+        if match:
+            sizes[match.group(1)] = (int(match.group(2)), int(match.group(3)))
+    if proc.returncode != 0:
+        sys.stderr.write(proc.stdout[-4000:])
+        return None
+    return sizes
+
+
+def load_boot_logs(paths):
+    """Devuelve {perfil: datos de arranque} con la última línea BOOT_PROFILE de cada log."""
+    boots = {}
+    for path in paths:
+        with open(path, encoding="utf-8", errors="replace") as f:
+            for line in f:
+                idx = line.find(PREFIX)
+                if idx < 0:
+                    continue
+                try:
+                    entry = json.loads(line[idx + len(PREFIX):].strip())
+                except ValueError:
+                    continue
+                boots[entry["profile"]] = entry
+    return boots
+
+
+def fmt_kib(value):
+    return "-" if value is None else "%.1f" % (value / 1024.0)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Code size, RAM and boot time per ArandanoIRT board profile.")
+    parser.add_argument("-e", "--environment", action="append", help="Only these PlatformIO environments")
+    parser.add_argument("--boot-log", action="append", default=[], help="Serial log with a BOOT_PROFILE line")
+    parser.add_argument("--no-build", action="store_true", help="Skip `pio run` (boot logs only)")
+    args = parser.parse_args()
+
+    envs = profile_environments(os.path.join(PROJECT_DIR, "platformio.ini"))
+    if args.environment:
+        envs = [(env, profile) for env, profile in envs if env in args.environment]
+    if not envs:
+        sys.exit("No environment in platformio.ini selects a board profile (-D BOARD_PROFILE_*)")
+    boots = load_boot_logs(args.boot_log)
+
+    failed = []
+    rows = []
+    for env, profile in envs:
+        sizes = {} if args.no_build else build_sizes(env)
+        if sizes is None:
+            failed.append(env)
+            sizes = {}
+        flash = sizes.get("Flash", (None, None))[0]
+        ram = sizes.get("RAM", (None, None))[0]
+        rows.append((env, profile, flash, ram, boots.get(profile, {})))
+
+    print("%-34s %-13s %10s %9s %9s %11s %10s %11s" % ("environment", "profile", "flash KiB", "RAM KiB",
+                                                       "boot ms", "sensors ms", "heap KiB", "PSRAM KiB"))
+    for env, profile, flash, ram, boot in rows:
+        print("%-34s %-13s %10s %9s %9s %11s %10s %11s" % (
+            env, profile, fmt_kib(flash), fmt_kib(ram), boot.get("boot_ms", "-"), boot.get("sensors_ms", "-"),
+            fmt_kib(boot.get("free_heap")), fmt_kib(boot.get("free_psram"))))
+
+    # Diferencias contra el primer perfil (normalmente el completo)
+    base = rows[0]
+    for env, profile, flash, ram, boot in rows[1:]:
+        parts = []
+        if flash is not None and base[2] is not None:
+            parts.append("flash %+.1f KiB" % ((flash - base[2]) / 1024.0))
+        if ram is not None and base[3] is not None:
+            parts.append("RAM %+.1f KiB" % ((ram - base[3]) / 1024.0))
+        if "boot_ms" in boot and "boot_ms" in base[4]:
+            parts.append("boot %+d ms" % (boot["boot_ms"] - base[4]["boot_ms"]))
+        if parts:
+            print("%s vs %s: %s" % (profile, base[1], ", ".join(parts)))
+
+    if failed:
+        print("\nBUILD FAILED: " + ", ".join(failed))
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
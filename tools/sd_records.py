@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+"""
+Verifica y extrae los registros escritos por SDManager::writeTextFile/writeBinaryFile.
+
+Los archivos de data_pending/ y archive/ llevan una cabecera de 12 bytes
+("REC1", longitud u32 y CRC-32 del contenido, little-endian), tanto los
+enviados en vivo como los archivados desde la cola. Este script comprueba
+cada archivo y, con --extract, copia el contenido sin la cabecera (JSON o
+JPEG tal cual) a otro directorio. Los archivos sin cabecera, de versiones
+anteriores del firmware, se copian completos.
+
+Uso:
+    python3 tools/sd_records.py /media/sd/archive/captures
+    python3 tools/sd_records.py /media/sd/archive --extract salida/
+"""
+import argparse
+import os
+import struct
+import sys
+import zlib
+
+MAGIC = b"REC1"
+HEADER = struct.Struct("<4sII")  # magic, longitud, CRC-32 (zlib)
+
+
+def read_record(path):
+    """Devuelve (estado, contenido). Estado: 'ok', 'legacy', 'torn' o 'crc'."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if len(data) < 4 or data[:4] != MAGIC:
+        return "legacy", data
+    if len(data) < HEADER.size:
+        return "torn", None
+    _, length, crc = HEADER.unpack_from(data, 0)
+    payload = data[HEADER.size:]
+    if len(payload) != length:
+        return "torn", None
+    if zlib.crc32(payload) & 0xFFFFFFFF != crc:
+        return "crc", None
+    return "ok", payload
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Verify or extract ArandanoIRT SD records.")
+    parser.add_argument("paths", nargs="+", help="Record files or directories copied from the SD card")
+    parser.add_argument("--extract", metavar="DIR", help="Write each valid payload to DIR (same relative path)")
+    args = parser.parse_args()
+
+    files = []
+    for root in args.paths:
+        if os.path.isdir(root):
+            for dirpath, _, names in os.walk(root):
+                files.extend((os.path.join(dirpath, n), os.path.relpath(os.path.join(dirpath, n), root))
+                             for n in sorted(names))
+        else:
+            files.append((root, os.path.basename(root)))
+
+    counts = {"ok": 0, "legacy": 0, "torn": 0, "crc": 0}
+    for path, rel in files:
+        status, payload = read_record(path)
+        counts[status] += 1
+        if status in ("torn", "crc"):
+            print("%s: %s" % (path, "torn record" if status == "torn" else "CRC mismatch"))
+            continue
+        if args.extract:
+            out = os.path.join(args.extract, rel)
+            os.makedirs(os.path.dirname(out) or ".", exist_ok=True)
+            with open(out, "wb") as f:
+                f.write(payload)
+
+    print("%d files: %d ok, %d without header, %d torn, %d CRC mismatch"
+          % (len(files), counts["ok"], counts["legacy"], counts["torn"], counts["crc"]))
+    sys.exit(1 if counts["torn"] or counts["crc"] else 0)
+
+
+if __name__ == "__main__":
+    main()
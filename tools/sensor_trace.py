@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""
+Lector de host para las trazas de sensores grabadas por SensorTrace (lib/SensorTrace).
+
+Muestra un resumen de la traza o la exporta a archivos manejables en el PC:
+lecturas escalares en CSV, cada fotograma térmico como CSV de 24x32 y cada
+captura como JPEG.
+
+Uso:
+    python3 tools/sensor_trace.py sensor_trace.trc
+    python3 tools/sensor_trace.py sensor_trace.trc --export salida/
+"""
+import argparse
+import csv
+import datetime
+import os
+import struct
+import sys
+
+MAGIC = b"ASTR"
+VERSION = 1
+HEADER = struct.Struct("<4sB3xI")        # magic, versión, época de inicio
+RECORD = struct.Struct("<BBHII")         # canal, flags, reservado, ms, longitud
+FLAG_FAILED = 0x01
+THERMAL_PIXELS = 768
+THERMAL_NAN = -32768
+
+# Mismo orden que enum class SensorChannel (SensorTrace.h)
+CHANNELS = ["thermal_frame", "light", "ambient_temperature", "humidity",
+            "pressure", "device_temperature", "jpeg"]
+SCALAR_CHANNELS = set(CHANNELS[1:6])
+
+
+def read_trace(path):
+    """Devuelve (época de inicio, [(canal, flags, ms, datos)]). Ignora un registro final truncado."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if len(data) < HEADER.size:
+        sys.exit("%s: file too short" % path)
+    magic, version, start_epoch = HEADER.unpack_from(data, 0)
+    if magic != MAGIC or version != VERSION:
+        sys.exit("%s: not a sensor trace (magic %r, version %d)" % (path, magic, version))
+
+    records = []
+    offset = HEADER.size
+    while offset + RECORD.size <= len(data):
+        channel, flags, _, time_ms, length = RECORD.unpack_from(data, offset)
+        start = offset + RECORD.size
+        if start + length > len(data):
+            print("warning: truncated record at offset %d ignored" % offset, file=sys.stderr)
+            break
+        records.append((channel, flags, time_ms, data[start:start + length]))
+        offset = start + length
+    return start_epoch, records
+
+
+def channel_name(channel):
+    return CHANNELS[channel] if channel < len(CHANNELS) else "unknown_%d" % channel
+
+
+def decode_thermal(payload):
+    values = struct.unpack("<%dh" % THERMAL_PIXELS, payload)
+    return [None if v == THERMAL_NAN else v / 100.0 for v in values]
+
+
+def print_summary(path, start_epoch, records):
+    start = datetime.datetime.fromtimestamp(start_epoch, datetime.timezone.utc).isoformat() if start_epoch else "unknown (no NTP)"
+    duration = records[-1][2] / 1000.0 if records else 0.0
+    print("%s: started %s, %.1f s, %d records" % (path, start, duration, len(records)))
+    print("%-22s %8s %8s %12s" % ("channel", "records", "failed", "bytes"))
+    for index, name in enumerate(CHANNELS):
+        selected = [r for r in records if r[0] == index]
+        if not selected:
+            continue
+        failed = sum(1 for r in selected if r[1] & FLAG_FAILED)
+        size = sum(len(r[3]) for r in selected)
+        print("%-22s %8d %8d %12d" % (name, len(selected), failed, size))
+
+
+def export(records, out_dir):
+    os.makedirs(out_dir, exist_ok=True)
+    frames = jpegs = 0
+    with open(os.path.join(out_dir, "scalars.csv"), "w", newline="") as f:
+        writer = csv.writer(f)
+        writer.writerow(["time_ms", "channel", "value", "failed"])
+        for channel, flags, time_ms, payload in records:
+            name = channel_name(channel)
+            failed = bool(flags & FLAG_FAILED)
+            if name in SCALAR_CHANNELS:
+                value = "" if failed else "%.4f" % struct.unpack("<f", payload)[0]
+                writer.writerow([time_ms, name, value, int(failed)])
+            elif name == "thermal_frame" and not failed:
+                pixels = decode_thermal(payload)
+                with open(os.path.join(out_dir, "thermal_%05d_%d.csv" % (frames, time_ms)), "w", newline="") as tf:
+                    rows = csv.writer(tf)
+                    for row in range(24):
+                        rows.writerow(["" if v is None else "%.2f" % v for v in pixels[row * 32:(row + 1) * 32]])
+                frames += 1
+            elif name == "jpeg" and not failed:
+                with open(os.path.join(out_dir, "capture_%05d_%d.jpg" % (jpegs, time_ms)), "wb") as jf:
+                    jf.write(payload)
+                jpegs += 1
+    print("Exported scalars.csv, %d thermal frames and %d JPEGs to %s" % (frames, jpegs, out_dir))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Inspect or export an ArandanoIRT sensor trace.")
+    parser.add_argument("trace", help="Trace file recorded on the SD card")
+    parser.add_argument("--export", metavar="DIR", help="Write scalars.csv, thermal CSVs and JPEGs to DIR")
+    args = parser.parse_args()
+
+    start_epoch, records = read_trace(args.trace)
+    print_summary(args.trace, start_epoch, records)
+    if args.export:
+        export(records, args.export)
+
+
+if __name__ == "__main__":
+    main()
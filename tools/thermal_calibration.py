@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+"""
+Ajusta la homografía entre la cámara visual (OV2640) y la térmica (MLX90640)
+que usa ThermalRegistration para calcular las temperaturas solo del dosel.
+
+Se ajusta una vez por equipo (las dos cámaras van fijas en la misma carcasa).
+Se necesitan al menos 4 correspondencias, mejor 8-12 repartidas por la imagen:
+un objeto pequeño y caliente (una taza de agua caliente, una resistencia) en
+distintas posiciones de la escena, a la distancia de trabajo. Para cada
+posición se anota su centro en el JPEG (píxeles de la imagen completa,
+640x480) y en el frame térmico. --hotspot da el centro del punto caliente de
+un JSON térmico de la SD (con o sin cabecera REC1).
+
+Formato de los puntos (CSV, '#' para comentarios):
+    x_visual,y_visual,columna_termica,fila_termica
+Las coordenadas térmicas son continuas: el píxel (c, r) cubre [c, c+1) x [r, r+1),
+así que su centro es (c + 0.5, r + 0.5).
+
+Uso:
+    python3 tools/thermal_calibration.py --hotspot 20251031_120000_thermal.json
+    python3 tools/thermal_calibration.py puntos.csv
+La última línea es el valor de "thermal_homography" para config.json (o el portal).
+"""
+import argparse
+import json
+import math
+import os
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from sd_records import read_record  # noqa: E402
+
+THERMAL_WIDTH = 32
+THERMAL_HEIGHT = 24
+MAX_RMS_PX = 0.5  # Error medio aceptable (píxeles térmicos)
+
+
+def load_points(path):
+    points = []
+    with open(path, encoding="utf-8") as f:
+        for number, line in enumerate(f, 1):
+            line = line.split("#", 1)[0].strip()
+            if not line:
+                continue
+            try:
+                values = [float(v) for v in line.replace(";", ",").split(",")]
+            except ValueError:
+                if not points:
+                    continue  # Cabecera
+                sys.exit("%s:%d: expected 4 numbers" % (path, number))
+            if len(values) != 4:
+                sys.exit("%s:%d: expected 4 numbers" % (path, number))
+            points.append(((values[0], values[1]), (values[2], values[3])))
+    return points
+
+
+def normalization(pts):
+    """Semejanza que lleva los puntos a media 0 y distancia media sqrt(2) (Hartley)."""
+    cx = sum(p[0] for p in pts) / len(pts)
+    cy = sum(p[1] for p in pts) / len(pts)
+    mean_dist = sum(math.hypot(p[0] - cx, p[1] - cy) for p in pts) / len(pts)
+    s = math.sqrt(2) / mean_dist if mean_dist > 0 else 1.0
+    return [[s, 0.0, -s * cx], [0.0, s, -s * cy], [0.0, 0.0, 1.0]]
+
+
+def matmul(a, b):
+    return [[sum(a[i][k] * b[k][j] for k in range(3)) for j in range(3)] for i in range(3)]
+
+
+def inverse_similarity(t):
+    s = t[0][0]
+    return [[1.0 / s, 0.0, -t[0][2] / s], [0.0, 1.0 / s, -t[1][2] / s], [0.0, 0.0, 1.0]]
+
+
+def apply(h, x, y):
+    w = h[2][0] * x + h[2][1] * y + h[2][2]
+    return (h[0][0] * x + h[0][1] * y + h[0][2]) / w, (h[1][0] * x + h[1][1] * y + h[1][2]) / w
+
+
+def solve(a, b):
+    """Eliminación gaussiana con pivoteo parcial (sistema n x n)."""
+    n = len(b)
+    m = [row[:] + [b[i]] for i, row in enumerate(a)]
+    for col in range(n):
+        pivot = max(range(col, n), key=lambda r: abs(m[r][col]))
+        if abs(m[pivot][col]) < 1e-12:
+            sys.exit("Degenerate point set (collinear or repeated points)")
+        m[col], m[pivot] = m[pivot], m[col]
+        for r in range(col + 1, n):
+            f = m[r][col] / m[col][col]
+            for c in range(col, n + 1):
+                m[r][c] -= f * m[col][c]
+    x = [0.0] * n
+    for r in range(n - 1, -1, -1):
+        x[r] = (m[r][n] - sum(m[r][c] * x[c] for c in range(r + 1, n))) / m[r][r]
+    return x
+
+
+def fit_homography(points):
+    """DLT normalizado (h22 = 1) por mínimos cuadrados: visual -> térmico."""
+    tv = normalization([p[0] for p in points])
+    tt = normalization([p[1] for p in points])
+    rows, rhs = [], []
+    for (x, y), (u, v) in points:
+        x, y = apply(tv, x, y)
+        u, v = apply(tt, u, v)
+        rows.append([x, y, 1, 0, 0, 0, -u * x, -u * y])
+        rhs.append(u)
+        rows.append([0, 0, 0, x, y, 1, -v * x, -v * y])
+        rhs.append(v)
+    ata = [[sum(r[i] * r[j] for r in rows) for j in range(8)] for i in range(8)]
+    atb = [sum(r[i] * b for r, b in zip(rows, rhs)) for i in range(8)]
+    h = solve(ata, atb) + [1.0]
+    hn = [h[0:3], h[3:6], h[6:9]]
+    full = matmul(inverse_similarity(tt), matmul(hn, tv))
+    scale = full[2][2]
+    return [[c / scale for c in row] for row in full]
+
+
+def hotspot(path):
+    """Centro (columna, fila) del punto más caliente: centroide ponderado del vecindario 3x3."""
+    status, payload = read_record(path)
+    if payload is None:
+        sys.exit("%s: %s" % (path, status))
+    temps = json.loads(payload.decode("utf-8"))["temperatures"]
+    valid = [(t, i) for i, t in enumerate(temps) if t is not None]
+    hottest, index = max(valid)
+    col, row = index % THERMAL_WIDTH, index // THERMAL_WIDTH
+    floor = min(t for t, _ in valid)
+    sw = sx = sy = 0.0
+    for dr in (-1, 0, 1):
+        for dc in (-1, 0, 1):
+            c, r = col + dc, row + dr
+            if 0 <= c < THERMAL_WIDTH and 0 <= r < THERMAL_HEIGHT and temps[r * THERMAL_WIDTH + c] is not None:
+                w = temps[r * THERMAL_WIDTH + c] - floor
+                sw += w
+                sx += w * (c + 0.5)
+                sy += w * (r + 0.5)
+    print("hottest %.2f C at pixel (%d, %d); centroid: %.3f,%.3f" % (hottest, col, row, sx / sw, sy / sw))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Fit the visual -> thermal homography for ArandanoIRT.")
+    parser.add_argument("points", nargs="?", help="CSV with x_visual,y_visual,col_thermal,row_thermal")
+    parser.add_argument("--hotspot", metavar="JSON", help="Print the hot spot centre of a thermal JSON and exit")
+    parser.add_argument("--visual-size", default="640x480", help="Visual frame size (default 640x480)")
+    args = parser.parse_args()
+
+    if args.hotspot:
+        hotspot(args.hotspot)
+        return
+    if not args.points:
+        parser.error("points file required")
+
+    points = load_points(args.points)
+    if len(points) < 4:
+        sys.exit("At least 4 correspondences are needed (%d given)" % len(points))
+    h = fit_homography(points)
+
+    errors = []
+    for (x, y), (u, v) in points:
+        pu, pv = apply(h, x, y)
+        errors.append(math.hypot(pu - u, pv - v))
+        print("visual (%7.1f, %7.1f) -> thermal (%6.2f, %6.2f), measured (%6.2f, %6.2f), error %.3f px"
+              % (x, y, pu, pv, u, v, errors[-1]))
+    rms = math.sqrt(sum(e * e for e in errors) / len(errors))
+    print("RMS error: %.3f thermal px (max %.3f)" % (rms, max(errors)))
+    if rms > MAX_RMS_PX:
+        print("Warning: RMS above %.1f px. Check the points (swapped axes, wrong image size, moved target)." % MAX_RMS_PX)
+
+    width, height = (int(v) for v in args.visual_size.lower().split("x"))
+    corners = [apply(h, x, y) for x, y in ((0, 0), (width, 0), (width, height), (0, height))]
+    print("Visual frame corners on the thermal grid: " + ", ".join("(%.1f, %.1f)" % c for c in corners))
+
+    print('"thermal_homography": "%s"' % ",".join("%.9g" % c for row in h for c in row))
+
+
+if __name__ == "__main__":
+    main()
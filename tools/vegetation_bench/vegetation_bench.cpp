@@ -0,0 +1,116 @@
+// Benchmark en el host de los índices de vegetación (lib/VegetationIndex) sobre imágenes de muestra.
+//
+// El firmware decodifica el JPEG de la cámara a 1/8 (solo coeficientes DC) y calcula ExG, ExGR
+// y la fracción de dosel sobre el resultado. En el host no hay decodificador integrado, así que
+// las muestras se reducen antes con libjpeg, que hace la misma decodificación DC a escala 1/8:
+//     djpeg -scale 1/8 -ppm captura_visual.jpg > captura.ppm
+//
+// Compilar y ejecutar (Linux, sin dependencias):
+//     g++ -std=c++17 -O2 -Ilib/VegetationIndex -Itest/test_benchmarks tools/vegetation_bench/vegetation_bench.cpp lib/VegetationIndex/VegetationIndex.cpp -o vegetation_bench
+//     ./vegetation_bench captura1.ppm captura2.ppm > bench.log
+//     python3 tools/bench_compare.py bench.log --baseline <baseline_host.json>
+//
+// Sin argumentos usa un cuadro sintético de 80x60 (mitad dosel, mitad suelo).
+// Cada imagen imprime una línea BENCH_JSON y otra con sus índices.
+
+#include "VegetationIndex.h"
+#include "bench_harness.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define HOST_ITERATIONS 200   // Iteraciones medidas por imagen (BENCH_MAX_ITERATIONS)
+#define SYNTHETIC_WIDTH 80    // VGA a 1/8
+#define SYNTHETIC_HEIGHT 60
+
+struct Image {
+    std::string name;
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> rgb;
+};
+
+// Lee un token numérico de la cabecera PPM (salta espacios y comentarios '#')
+static bool readHeaderInt(FILE* f, int& value) {
+    int c = fgetc(f);
+    while (c != EOF) {
+        if (c == '#') {
+            while (c != EOF && c != '\n') c = fgetc(f);
+        } else if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+            break;
+        }
+        c = fgetc(f);
+    }
+    if (c == EOF || c < '0' || c > '9') return false;
+    value = 0;
+    while (c >= '0' && c <= '9') {
+        value = value * 10 + (c - '0');
+        c = fgetc(f);
+    }
+    return true; // El separador que sigue al número queda consumido (un solo espacio tras maxval)
+}
+
+// Carga un PPM binario (P6, maxval 255)
+static bool loadPpm(const char* path, Image& image) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    char magic[2];
+    int maxval = 0;
+    bool ok = fread(magic, 1, 2, f) == 2 && magic[0] == 'P' && magic[1] == '6' &&
+              readHeaderInt(f, image.width) && readHeaderInt(f, image.height) &&
+              readHeaderInt(f, maxval) && maxval == 255 && image.width > 0 && image.height > 0;
+    if (ok) {
+        image.rgb.resize((size_t)image.width * image.height * 3);
+        ok = fread(image.rgb.data(), 1, image.rgb.size(), f) == image.rgb.size();
+    }
+    fclose(f);
+    image.name = path;
+    return ok;
+}
+
+// Cuadro sintético: mitad izquierda dosel verde, mitad derecha suelo
+static Image syntheticImage() {
+    Image image;
+    image.name = "synthetic";
+    image.width = SYNTHETIC_WIDTH;
+    image.height = SYNTHETIC_HEIGHT;
+    image.rgb.resize((size_t)SYNTHETIC_WIDTH * SYNTHETIC_HEIGHT * 3);
+    for (size_t i = 0; i < (size_t)SYNTHETIC_WIDTH * SYNTHETIC_HEIGHT; i++) {
+        bool canopy = (i % SYNTHETIC_WIDTH) < SYNTHETIC_WIDTH / 2;
+        image.rgb[3 * i] = canopy ? 50 : 110;
+        image.rgb[3 * i + 1] = canopy ? 150 : 90;
+        image.rgb[3 * i + 2] = canopy ? 50 : 110;
+    }
+    return image;
+}
+
+int main(int argc, char** argv) {
+    std::vector<Image> images;
+    for (int i = 1; i < argc; i++) {
+        Image image;
+        if (!loadPpm(argv[i], image)) {
+            fprintf(stderr, "No se pudo leer %s (se espera PPM P6 de 8 bits)\n", argv[i]);
+            return 1;
+        }
+        images.push_back(image);
+    }
+    if (images.empty()) images.push_back(syntheticImage());
+
+    for (const Image& image : images) {
+        size_t pixels = (size_t)image.width * image.height;
+        std::vector<uint8_t> mask(pixels);
+        VegetationStats stats;
+        // Nombre estable para bench_compare.py: vegetation_kernel_<archivo sin ruta>
+        std::string base = image.name.substr(image.name.find_last_of('/') + 1);
+        std::string name = "vegetation_kernel_" + base;
+        bench::run(name.c_str(), HOST_ITERATIONS, [&]() {
+            computeVegetationIndices(image.rgb.data(), pixels, stats, mask.data());
+        });
+        printf("%s %dx%d: ExG %.4f, ExGR %.4f, canopy %.4f\n", base.c_str(), image.width, image.height,
+               stats.exg, stats.exgr, stats.canopyFraction);
+    }
+    return 0;
+}